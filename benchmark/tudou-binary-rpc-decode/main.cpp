@@ -0,0 +1,151 @@
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "binary_rpc.pb.h"
+#include "decode_bench.pb.h"
+#include "tudou/rpc/binary/BinaryRpcCodec.h"
+#include "tudou/tcp/Buffer.h"
+
+// 二进制 RPC 服务端拆包路径对比：把若干帧按固定分片大小（模拟每次可读事件读到的字节数）喂给解码器，
+// 统计“整段缓存拷贝 + 复制解码”的旧路径与“连接读缓冲原地窥探 + ParseFromArray”的新路径的吞吐。
+
+namespace {
+
+using tudou::rpc::RpcMeta;
+using tudou::rpc::binary::BinaryRpcCodec;
+using tudou::rpc::binary::RpcHeader;
+using tudou::rpc::binary::RpcMessageType;
+using tudou::rpc::binary::bench::BenchPayload;
+
+constexpr size_t kDefaultSegmentSize = 16 * 1024;
+
+struct Scenario {
+    const char* name;
+    size_t payloadSize;
+    int frameCount;
+};
+
+size_t parse_segment_size(const char* text) {
+    const long value = std::stol(text);
+    if (value <= 0) {
+        throw std::invalid_argument("segment_size must be > 0");
+    }
+    return static_cast<size_t>(value);
+}
+
+std::string build_stream(size_t payloadSize, int frameCount) {
+    RpcMeta meta;
+    meta.set_service_name("tudou.rpc.binary.bench.BenchService");
+    meta.set_method_name("Echo");
+    std::string metaRaw;
+    meta.SerializeToString(&metaRaw);
+
+    BenchPayload payload;
+    payload.set_data(std::string(payloadSize, 'x'));
+    std::string bodyRaw;
+    payload.SerializeToString(&bodyRaw);
+
+    Buffer buf;
+    for (int i = 0; i < frameCount; ++i) {
+        BinaryRpcCodec::encode(&buf, RpcMessageType::Request, static_cast<uint64_t>(i + 1), metaRaw, bodyRaw);
+    }
+    return buf.read_from_buffer();
+}
+
+// 旧路径：连接级 std::string 缓存 -> 整段拷进临时 Buffer -> decode 复制出 Meta/Body -> 剩余字节拷回缓存
+size_t run_copying_decode(const std::string& stream, size_t segmentSize) {
+    std::string cache;
+    size_t decoded = 0;
+    RpcHeader header;
+    std::string metaRaw;
+    std::string bodyRaw;
+
+    for (size_t offset = 0; offset < stream.size(); offset += segmentSize) {
+        cache.append(stream, offset, segmentSize);
+
+        Buffer buf;
+        buf.write_to_buffer(cache.data(), cache.size());
+        while (BinaryRpcCodec::decode(&buf, header, metaRaw, bodyRaw) == BinaryRpcCodec::DecodeResult::Success) {
+            RpcMeta meta;
+            BenchPayload payload;
+            if (meta.ParseFromString(metaRaw) && payload.ParseFromString(bodyRaw)) {
+                ++decoded;
+            }
+        }
+        cache = buf.read_from_buffer();
+    }
+    return decoded;
+}
+
+// 新路径：数据只进入一次读缓冲，完整帧到齐后直接从缓冲区区间反序列化
+size_t run_in_place_decode(const std::string& stream, size_t segmentSize) {
+    Buffer buf;
+    size_t decoded = 0;
+    RpcHeader header;
+    const char* metaData = nullptr;
+    const char* bodyData = nullptr;
+
+    for (size_t offset = 0; offset < stream.size(); offset += segmentSize) {
+        const size_t len = std::min(segmentSize, stream.size() - offset);
+        buf.write_to_buffer(stream.data() + offset, len);
+
+        while (BinaryRpcCodec::peek(&buf, header, metaData, bodyData) == BinaryRpcCodec::DecodeResult::Success) {
+            RpcMeta meta;
+            BenchPayload payload;
+            if (meta.ParseFromArray(metaData, static_cast<int>(header.metaLen))
+                && payload.ParseFromArray(bodyData, static_cast<int>(header.bodyLen))) {
+                ++decoded;
+            }
+            buf.advance_read_index(BinaryRpcCodec::frame_size(header));
+        }
+    }
+    return decoded;
+}
+
+template <typename Fn>
+void report(const char* path, const Scenario& scenario, const std::string& stream, size_t segmentSize, Fn fn) {
+    const auto start = std::chrono::steady_clock::now();
+    const size_t decoded = fn(stream, segmentSize);
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+
+    const double seconds = std::chrono::duration<double>(elapsed).count();
+    const double mbPerSecond = static_cast<double>(stream.size()) / (1024.0 * 1024.0) / seconds;
+    std::cout << "  " << path << ": " << decoded << "/" << scenario.frameCount << " frames in " << seconds << " s, "
+              << mbPerSecond << " MiB/s, " << static_cast<uint64_t>(decoded / seconds) << " frames/s" << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    try {
+        const size_t segmentSize = argc > 1 ? parse_segment_size(argv[1]) : kDefaultSegmentSize;
+
+        const std::vector<Scenario> scenarios = {
+            {"1KB", 1024, 20000},
+            {"64KB", 64 * 1024, 1000},
+            {"16MB", 16 * 1024 * 1024, 2},
+        };
+
+        std::cout << "Tudou binary RPC decode benchmark, segment_size=" << segmentSize << std::endl;
+        for (const Scenario& scenario : scenarios) {
+            const std::string stream = build_stream(scenario.payloadSize, scenario.frameCount);
+            std::cout << scenario.name << " payload, " << scenario.frameCount << " frames:" << std::endl;
+            report("copying decode", scenario, stream, segmentSize, run_copying_decode);
+            report("in-place decode", scenario, stream, segmentSize, run_in_place_decode);
+        }
+        return 0;
+    }
+    catch (const std::exception& ex) {
+        std::cerr << "usage: " << argv[0] << " [segment_size]" << std::endl;
+        std::cerr << "error: " << ex.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+}
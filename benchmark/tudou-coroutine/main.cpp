@@ -0,0 +1,83 @@
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+#include <boost/coroutine2/all.hpp>
+
+#include "tudou/rpc/Coroutine.h"
+
+namespace {
+
+constexpr int kDefaultIterations = 200000;
+
+using coro_t = boost::coroutines2::coroutine<void>;
+
+int parse_iterations(const char* text) {
+    const int value = std::stoi(text);
+    if (value <= 0) {
+        throw std::invalid_argument("iterations must be > 0");
+    }
+    return value;
+}
+
+// 对照组：每个请求新建一个 boost 默认 fixedsize_stack 协程，结束即 munmap
+void run_fixedsize_stack(int iterations, uint64_t& sink) {
+    for (int i = 0; i < iterations; ++i) {
+        coro_t::pull_type pull([&sink](coro_t::push_type& yield) {
+            yield();
+            ++sink;
+        });
+        pull();
+    }
+}
+
+// 实验组：Coroutine::create 复用对象池中的协程与栈池中的栈
+void run_pooled_coroutine(int iterations, uint64_t& sink) {
+    for (int i = 0; i < iterations; ++i) {
+        auto coro = tudou::rpc::Coroutine::create(nullptr, [&sink]() {
+            tudou::rpc::Coroutine::t_current_coroutine->yield();
+            ++sink;
+        });
+        coro->resume();
+        coro->resume();
+    }
+}
+
+template <typename Fn>
+void report(const char* name, int iterations, Fn fn) {
+    uint64_t sink = 0;
+    const auto start = std::chrono::steady_clock::now();
+    fn(iterations, sink);
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+
+    const double seconds = std::chrono::duration<double>(elapsed).count();
+    const double nsPerOp = seconds * 1e9 / iterations;
+    std::cout << name << ": " << iterations << " create/resume/destroy in " << seconds << " s, "
+              << nsPerOp << " ns/op, " << static_cast<uint64_t>(iterations / seconds) << " ops/s"
+              << " (sink=" << sink << ")" << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    try {
+        const int iterations = argc > 1 ? parse_iterations(argv[1]) : kDefaultIterations;
+
+        std::cout << "Tudou coroutine benchmark, iterations=" << iterations
+                  << ", stackSize=" << tudou::rpc::Coroutine::get_options().stackSize << std::endl;
+
+        report("boost fixedsize_stack", iterations, run_fixedsize_stack);
+        report("tudou pooled coroutine", iterations, run_pooled_coroutine);
+        return 0;
+    }
+    catch (const std::exception& ex) {
+        std::cerr << "usage: " << argv[0] << " [iterations]" << std::endl;
+        std::cerr << "error: " << ex.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+}
@@ -0,0 +1,334 @@
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <openssl/ssl.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "spdlog/spdlog.h"
+#include "tudou/http/HttpRequest.h"
+#include "tudou/http/HttpResponse.h"
+#include "tudou/http/HttpServer.h"
+#include "tudou/http/TlsConfig.h"
+#include "tudou/http/TlsConnection.h"
+#include "tudou/tcp/Buffer.h"
+
+// HTTPS 数据通路压测：同一个 GET 路由分别以 MemoryBio 与 BufferBio 两种 TLS 模式提供服务。
+// 1. 回环 TCP 上由多个 keep-alive 客户端线程串行请求，统计端到端 requests/sec；
+// 2. 不经网络，按 HttpServer 的读写顺序直接驱动 TlsConnection，统计每请求在用户态搬运的字节数。
+// 输出为 CSV，可直接对比两种模式的吞吐与拷贝量。
+
+namespace {
+
+constexpr uint16_t kDefaultPort = 19443;
+constexpr double kDefaultSeconds = 2.0;
+constexpr int kDefaultClients = 4;
+constexpr int kCopyRounds = 2000;
+constexpr char kRequest[] = "GET /payload HTTP/1.1\r\nHost: localhost\r\n\r\n";
+
+std::string cert_path(const char* fileName) {
+    return std::string(TUDOU_SOURCE_DIR) + "/certs/" + fileName;
+}
+
+double parse_seconds(const char* text) {
+    const double value = std::stod(text);
+    if (value <= 0) {
+        throw std::invalid_argument("seconds must be > 0");
+    }
+    return value;
+}
+
+int parse_clients(const char* text) {
+    const int value = std::stoi(text);
+    if (value <= 0) {
+        throw std::invalid_argument("clients must be > 0");
+    }
+    return value;
+}
+
+const char* mode_name(TlsMode mode) {
+    return mode == TlsMode::BufferBio ? "buffer_bio" : "memory_bio";
+}
+
+SSL_CTX* create_client_context() {
+    SSL_CTX* context = SSL_CTX_new(TLS_client_method());
+    if (!context) {
+        throw std::runtime_error("SSL_CTX_new failed");
+    }
+    SSL_CTX_set_min_proto_version(context, TLS1_2_VERSION);
+    SSL_CTX_set_verify(context, SSL_VERIFY_NONE, nullptr);
+    return context;
+}
+
+// 阻塞 socket 上的 keep-alive HTTPS 客户端：发出请求后读到完整响应（按 Content-Length 判定）再发下一个
+class BlockingHttpsClient {
+public:
+    BlockingHttpsClient(SSL_CTX* context, uint16_t port) : fd_(-1), ssl_(nullptr) {
+        fd_ = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, IPPROTO_TCP);
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(port);
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        const int one = 1;
+        ::setsockopt(fd_, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        if (fd_ < 0 || ::connect(fd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+            throw std::runtime_error("connect failed");
+        }
+
+        ssl_ = SSL_new(context);
+        SSL_set_fd(ssl_, fd_);
+        if (SSL_connect(ssl_) != 1) {
+            throw std::runtime_error("SSL_connect failed");
+        }
+    }
+
+    ~BlockingHttpsClient() {
+        if (ssl_) {
+            SSL_free(ssl_);
+        }
+        if (fd_ >= 0) {
+            ::close(fd_);
+        }
+    }
+
+    bool round_trip() {
+        if (SSL_write(ssl_, kRequest, sizeof(kRequest) - 1) <= 0) {
+            return false;
+        }
+
+        size_t expected = 0;
+        while (expected == 0 || pending_.size() < expected) {
+            char buf[16384];
+            const int n = SSL_read(ssl_, buf, sizeof(buf));
+            if (n <= 0) {
+                return false;
+            }
+            pending_.append(buf, static_cast<size_t>(n));
+
+            const size_t headerEnd = pending_.find("\r\n\r\n");
+            if (expected == 0 && headerEnd != std::string::npos) {
+                const size_t pos = pending_.find("Content-Length: ");
+                expected = headerEnd + 4 + std::stoul(pending_.substr(pos + 16));
+            }
+        }
+        pending_.erase(0, expected);
+        return true;
+    }
+
+private:
+    int fd_;
+    SSL* ssl_;
+    std::string pending_;
+};
+
+double measure_requests_per_sec(TlsMode mode, uint16_t port, size_t bodyBytes, int clients, double seconds) {
+    HttpServer server("127.0.0.1", port, 1);
+    if (!server.enable_ssl(cert_path("test-cert.pem"), cert_path("test-key.pem")) || !server.set_tls_mode(mode)) {
+        throw std::runtime_error("failed to enable TLS");
+    }
+    const std::string body(bodyBytes, 'x');
+    server.add_get_route("/payload", [&body](const HttpRequest&, HttpResponse& resp) {
+        resp.set_status(200, "OK");
+        resp.set_header("Content-Type", "application/octet-stream");
+        resp.set_body(body);
+        });
+
+    std::thread serverThread([&server]() {
+        server.start();
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+    SSL_CTX* context = create_client_context();
+    std::atomic<uint64_t> requests{ 0 };
+    const auto end = std::chrono::steady_clock::now()
+        + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(seconds));
+    std::vector<std::thread> workers;
+    const auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < clients; ++i) {
+        workers.emplace_back([&]() {
+            BlockingHttpsClient client(context, port);
+            uint64_t local = 0;
+            while (std::chrono::steady_clock::now() < end && client.round_trip()) {
+                ++local;
+            }
+            requests.fetch_add(local);
+        });
+    }
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+    const double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    SSL_CTX_free(context);
+
+    server.stop();
+    serverThread.join();
+    return requests.load() / elapsed;
+}
+
+// 内存中的 TLS 客户端：与服务端 TlsConnection 之间用 Memory BIO 传递记录，不引入 socket 噪声
+class MemoryTlsClient {
+public:
+    explicit MemoryTlsClient(SSL_CTX* context)
+        : ssl_(SSL_new(context)), rbio_(BIO_new(BIO_s_mem())), wbio_(BIO_new(BIO_s_mem())) {
+        SSL_set_bio(ssl_, rbio_, wbio_);
+        SSL_set_connect_state(ssl_);
+    }
+
+    ~MemoryTlsClient() {
+        SSL_free(ssl_);
+    }
+
+    void advance_handshake() {
+        SSL_do_handshake(ssl_);
+    }
+
+    bool is_established() const {
+        return SSL_is_init_finished(ssl_) == 1;
+    }
+
+    void write(const char* data, size_t len) {
+        SSL_write(ssl_, data, static_cast<int>(len));
+    }
+
+    void feed(const char* data, size_t len) {
+        BIO_write(rbio_, data, static_cast<int>(len));
+    }
+
+    std::string take_output() {
+        std::string output(BIO_ctrl_pending(wbio_), '\0');
+        if (!output.empty()) {
+            output.resize(static_cast<size_t>(BIO_read(wbio_, &output[0], static_cast<int>(output.size()))));
+        }
+        return output;
+    }
+
+    size_t drain_plaintext() {
+        char buf[16384];
+        size_t total = 0;
+        int n = 0;
+        while ((n = SSL_read(ssl_, buf, sizeof(buf))) > 0) {
+            total += static_cast<size_t>(n);
+        }
+        return total;
+    }
+
+private:
+    SSL* ssl_;
+    BIO* rbio_;
+    BIO* wbio_;
+};
+
+// 按 HttpServer 在两种模式下的读写顺序驱动同一条 TLS 会话：
+// MemoryBio：读缓冲 -> receive() 得到 string -> read_plaintext(string) -> write_plaintext(string) -> conn->send(string)；
+// BufferBio：read_plaintext(读缓冲, 明文 Buffer, 密文 Buffer) -> write_plaintext(data, len, 密文 Buffer) -> conn->send(data, len)。
+void measure_copied_bytes(TlsMode mode, TlsConfig& tlsConfig, size_t bodyBytes) {
+    SSL_CTX* context = create_client_context();
+    TlsConnection server(tlsConfig.create_ssl(), mode);
+    MemoryTlsClient client(context);
+
+    Buffer socketBuffer;
+    Buffer plaintext;
+    Buffer ciphertext;
+    uint64_t receiveCopies = 0;
+    auto server_read = [&]() {
+        if (mode == TlsMode::BufferBio) {
+            server.read_plaintext(socketBuffer, plaintext, ciphertext);
+            plaintext.advance_read_index(plaintext.readable_bytes());
+            const std::string out = ciphertext.read_from_buffer();
+            client.feed(out.data(), out.size());
+            return;
+        }
+        const std::string received = socketBuffer.read_from_buffer();
+        receiveCopies += received.size();
+        std::string decrypted;
+        std::string outbound;
+        server.read_plaintext(received, decrypted, outbound);
+        client.feed(outbound.data(), outbound.size());
+    };
+
+    for (int round = 0; round < 32 && !(client.is_established() && server.is_established()); ++round) {
+        client.advance_handshake();
+        socketBuffer.write_to_buffer(client.take_output());
+        server_read();
+    }
+    if (!server.is_established()) {
+        SSL_CTX_free(context);
+        throw std::runtime_error("in-memory TLS handshake failed");
+    }
+
+    const std::string response = "HTTP/1.1 200 OK\r\nContent-Length: " + std::to_string(bodyBytes) + "\r\n\r\n"
+        + std::string(bodyBytes, 'x');
+    const uint64_t copiedBefore = server.get_copied_bytes();
+    receiveCopies = 0;
+
+    const auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < kCopyRounds; ++i) {
+        client.write(kRequest, sizeof(kRequest) - 1);
+        socketBuffer.write_to_buffer(client.take_output());
+        server_read();
+
+        if (mode == TlsMode::BufferBio) {
+            server.write_plaintext(response.data(), response.size(), ciphertext);
+            client.feed(ciphertext.readable_start_ptr(), ciphertext.readable_bytes());
+            ciphertext.advance_read_index(ciphertext.readable_bytes());
+        }
+        else {
+            std::string encrypted;
+            server.write_plaintext(response, encrypted);
+            client.feed(encrypted.data(), encrypted.size());
+        }
+        client.drain_plaintext();
+    }
+    const double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    const uint64_t copied = server.get_copied_bytes() - copiedBefore + receiveCopies;
+    std::cout << "in_memory," << mode_name(mode) << "," << bodyBytes << ",,"
+              << static_cast<uint64_t>(kCopyRounds / elapsed) << ","
+              << copied / kCopyRounds << std::endl;
+    SSL_CTX_free(context);
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    try {
+        const double seconds = argc > 1 ? parse_seconds(argv[1]) : kDefaultSeconds;
+        const int clients = argc > 2 ? parse_clients(argv[2]) : kDefaultClients;
+        spdlog::set_level(spdlog::level::critical);
+
+        TlsConfig tlsConfig;
+        if (!tlsConfig.init(cert_path("test-cert.pem"), cert_path("test-key.pem"))) {
+            throw std::runtime_error("failed to load test certificate");
+        }
+
+        std::cout << "Tudou HTTPS BIO benchmark, seconds=" << seconds << ", clients=" << clients << std::endl;
+        std::cout << "scenario,tls_mode,body_bytes,loopback_requests_per_sec,in_memory_requests_per_sec,copied_bytes_per_request" << std::endl;
+
+        uint16_t port = kDefaultPort;
+        for (size_t bodyBytes : { 64, 16384 }) {
+            for (TlsMode mode : { TlsMode::MemoryBio, TlsMode::BufferBio }) {
+                const double rps = measure_requests_per_sec(mode, port++, bodyBytes, clients, seconds);
+                std::cout << "loopback," << mode_name(mode) << "," << bodyBytes << "," << static_cast<uint64_t>(rps) << ",," << std::endl;
+                measure_copied_bytes(mode, tlsConfig, bodyBytes);
+            }
+        }
+        return 0;
+    }
+    catch (const std::exception& ex) {
+        std::cerr << "usage: " << argv[0] << " [seconds] [clients]" << std::endl;
+        std::cerr << "error: " << ex.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+}
@@ -0,0 +1,236 @@
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <openssl/ssl.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "spdlog/spdlog.h"
+#include "tudou/http/HttpRequest.h"
+#include "tudou/http/HttpResponse.h"
+#include "tudou/http/HttpServer.h"
+
+// HTTPS 握手风暴压测：单 IO 线程的 HttpServer 上，若干 keep-alive 连接持续发小请求并记录往返时延，
+// 同时多个风暴线程不断新建连接做完整握手（不带会话，无法复用）。
+// 分别在握手留在 IO 线程（handshake_threads=0）与卸载到加密线程池时运行，输出 CSV：
+// 风暴期间每秒完成的握手数，以及已建立连接上请求时延的 p50/p99（微秒）。
+
+namespace {
+
+constexpr uint16_t kDefaultPort = 19583;
+constexpr double kDefaultSeconds = 2.0;
+constexpr int kDefaultClients = 4;
+constexpr int kProbeConnections = 2;
+constexpr char kRequest[] = "GET /ping HTTP/1.1\r\nHost: localhost\r\n\r\n";
+
+double parse_seconds(const char* text) {
+    const double value = std::stod(text);
+    if (value <= 0) {
+        throw std::invalid_argument("seconds must be > 0");
+    }
+    return value;
+}
+
+int parse_clients(const char* text) {
+    const int value = std::stoi(text);
+    if (value <= 0) {
+        throw std::invalid_argument("clients must be > 0");
+    }
+    return value;
+}
+
+std::string cert_path(const char* fileName) {
+    return std::string(TUDOU_SOURCE_DIR) + "/certs/" + fileName;
+}
+
+SSL_CTX* create_client_context() {
+    SSL_CTX* context = SSL_CTX_new(TLS_client_method());
+    if (!context) {
+        throw std::runtime_error("SSL_CTX_new failed");
+    }
+    SSL_CTX_set_min_proto_version(context, TLS1_2_VERSION);
+    SSL_CTX_set_verify(context, SSL_VERIFY_NONE, nullptr);
+    SSL_CTX_set_session_cache_mode(context, SSL_SESS_CACHE_OFF);
+    return context;
+}
+
+int connect_loopback(uint16_t port) {
+    const int fd = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, IPPROTO_TCP);
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (fd < 0 || ::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+        if (fd >= 0) {
+            ::close(fd);
+        }
+        return -1;
+    }
+    const int one = 1;
+    ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    return fd;
+}
+
+// 读完一个带 Content-Length 的响应
+bool read_response(SSL* ssl) {
+    std::string response;
+    char buf[4096];
+    size_t headerEnd = std::string::npos;
+    size_t total = 0;
+    while (headerEnd == std::string::npos || response.size() < total) {
+        const int n = SSL_read(ssl, buf, sizeof(buf));
+        if (n <= 0) {
+            return false;
+        }
+        response.append(buf, static_cast<size_t>(n));
+        if (headerEnd == std::string::npos && (headerEnd = response.find("\r\n\r\n")) != std::string::npos) {
+            const size_t pos = response.find("Content-Length: ");
+            total = headerEnd + 4 + (pos == std::string::npos ? 0 : std::stoul(response.substr(pos + 16)));
+        }
+    }
+    return true;
+}
+
+// 一次完整握手后立即断开，不发请求
+bool full_handshake(SSL_CTX* context, uint16_t port) {
+    const int fd = connect_loopback(port);
+    if (fd < 0) {
+        return false;
+    }
+    SSL* ssl = SSL_new(context);
+    SSL_set_fd(ssl, fd);
+    const bool ok = SSL_connect(ssl) == 1;
+    SSL_free(ssl);
+    ::close(fd);
+    return ok;
+}
+
+struct Measurement {
+    double handshakesPerSec = 0;
+    size_t requests = 0;
+    double p50Micros = 0;
+    double p99Micros = 0;
+};
+
+Measurement measure(int handshakeThreads, uint16_t port, int stormClients, double seconds) {
+    HttpServer server("127.0.0.1", port, 0);
+    if (!server.enable_ssl(cert_path("test-cert.pem"), cert_path("test-key.pem"))) {
+        throw std::runtime_error("failed to enable TLS");
+    }
+    server.set_tls_handshake_threads(handshakeThreads);
+    server.add_get_route("/ping", [](const HttpRequest&, HttpResponse& resp) {
+        resp.set_status(200, "OK");
+        resp.set_body("pong");
+        });
+
+    std::thread serverThread([&server]() {
+        server.start();
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+    SSL_CTX* context = create_client_context();
+    std::atomic<bool> stop{ false };
+    std::atomic<uint64_t> handshakes{ 0 };
+    std::vector<std::thread> storm;
+    for (int i = 0; i < stormClients; ++i) {
+        storm.emplace_back([&]() {
+            while (!stop.load(std::memory_order_relaxed)) {
+                if (full_handshake(context, port)) {
+                    handshakes.fetch_add(1, std::memory_order_relaxed);
+                }
+            }
+        });
+    }
+
+    // 已建立的 keep-alive 连接：握手在风暴开始前完成，只测请求往返
+    std::vector<std::vector<double>> latencies(kProbeConnections);
+    std::vector<std::thread> probes;
+    const auto end = std::chrono::steady_clock::now()
+        + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(seconds));
+    for (int i = 0; i < kProbeConnections; ++i) {
+        const int fd = connect_loopback(port);
+        SSL* ssl = SSL_new(context);
+        SSL_set_fd(ssl, fd);
+        if (fd < 0 || SSL_connect(ssl) != 1) {
+            throw std::runtime_error("probe connection failed");
+        }
+        probes.emplace_back([&, fd, ssl, i]() {
+            while (std::chrono::steady_clock::now() < end) {
+                const auto start = std::chrono::steady_clock::now();
+                if (SSL_write(ssl, kRequest, sizeof(kRequest) - 1) <= 0 || !read_response(ssl)) {
+                    break;
+                }
+                latencies[i].push_back(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count());
+            }
+            SSL_free(ssl);
+            ::close(fd);
+        });
+    }
+
+    const auto stormStart = std::chrono::steady_clock::now();
+    for (std::thread& probe : probes) {
+        probe.join();
+    }
+    stop = true;
+    for (std::thread& worker : storm) {
+        worker.join();
+    }
+    const double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - stormStart).count();
+    SSL_CTX_free(context);
+
+    server.stop();
+    serverThread.join();
+
+    std::vector<double> all;
+    for (const std::vector<double>& samples : latencies) {
+        all.insert(all.end(), samples.begin(), samples.end());
+    }
+    std::sort(all.begin(), all.end());
+    Measurement result;
+    result.handshakesPerSec = handshakes.load() / elapsed;
+    result.requests = all.size();
+    if (!all.empty()) {
+        result.p50Micros = all[all.size() / 2];
+        result.p99Micros = all[std::min(all.size() - 1, all.size() * 99 / 100)];
+    }
+    return result;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    try {
+        const double seconds = argc > 1 ? parse_seconds(argv[1]) : kDefaultSeconds;
+        const int clients = argc > 2 ? parse_clients(argv[2]) : kDefaultClients;
+        spdlog::set_level(spdlog::level::critical);
+
+        std::cout << "Tudou HTTPS handshake storm benchmark, seconds=" << seconds << ", storm_clients=" << clients << std::endl;
+        std::cout << "handshake_threads,storm_handshakes_per_sec,requests,p50_us,p99_us" << std::endl;
+
+        uint16_t port = kDefaultPort;
+        for (int handshakeThreads : { 0, 1, 2 }) {
+            const Measurement m = measure(handshakeThreads, port++, clients, seconds);
+            std::cout << handshakeThreads << "," << m.handshakesPerSec << "," << m.requests << ","
+                      << m.p50Micros << "," << m.p99Micros << std::endl;
+        }
+        return 0;
+    }
+    catch (const std::exception& ex) {
+        std::cerr << "usage: " << argv[0] << " [seconds] [clients]" << std::endl;
+        std::cerr << "error: " << ex.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+}
@@ -0,0 +1,233 @@
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <openssl/ssl.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "spdlog/spdlog.h"
+#include "tudou/http/HttpRequest.h"
+#include "tudou/http/HttpResponse.h"
+#include "tudou/http/HttpServer.h"
+
+// HTTPS 握手压测：每个请求都新建 TCP + TLS 连接，对比完整握手与两种会话复用（无状态票据、服务端共享会话缓存）。
+// 客户端线程在回环 TCP 上循环「建连 → 握手 → 一次 GET → 关闭」，复用场景下每次都带上一次拿到的会话。
+// 输出 CSV：TLS 版本、复用方式、每秒握手数，以及服务端统计的复用命中率。
+
+namespace {
+
+constexpr uint16_t kDefaultPort = 19563;
+constexpr double kDefaultSeconds = 2.0;
+constexpr int kDefaultClients = 2;
+constexpr char kRequest[] = "GET /ping HTTP/1.1\r\nHost: localhost\r\n\r\n";
+
+enum class Resumption {
+    None,
+    Ticket,
+    Cache
+};
+
+std::string cert_path(const char* fileName) {
+    return std::string(TUDOU_SOURCE_DIR) + "/certs/" + fileName;
+}
+
+double parse_seconds(const char* text) {
+    const double value = std::stod(text);
+    if (value <= 0) {
+        throw std::invalid_argument("seconds must be > 0");
+    }
+    return value;
+}
+
+int parse_clients(const char* text) {
+    const int value = std::stoi(text);
+    if (value <= 0) {
+        throw std::invalid_argument("clients must be > 0");
+    }
+    return value;
+}
+
+const char* resumption_name(Resumption resumption) {
+    switch (resumption) {
+    case Resumption::Ticket:
+        return "ticket";
+    case Resumption::Cache:
+        return "session_cache";
+    default:
+        return "full";
+    }
+}
+
+TlsSessionOptions session_options_for(Resumption resumption) {
+    TlsSessionOptions options;
+    options.enableTickets = resumption == Resumption::Ticket;
+    options.enableSessionCache = resumption == Resumption::Cache;
+    return options;
+}
+
+SSL_CTX* create_client_context(int version) {
+    SSL_CTX* context = SSL_CTX_new(TLS_client_method());
+    if (!context) {
+        throw std::runtime_error("SSL_CTX_new failed");
+    }
+    SSL_CTX_set_min_proto_version(context, version);
+    SSL_CTX_set_max_proto_version(context, version);
+    SSL_CTX_set_verify(context, SSL_VERIFY_NONE, nullptr);
+    SSL_CTX_set_session_cache_mode(context, SSL_SESS_CACHE_CLIENT);
+    return context;
+}
+
+// 阻塞 socket 上完成一次「握手 + 请求 + 关闭」；成功时返回可供下次复用的会话（由调用方释放）
+SSL_SESSION* handshake_once(SSL_CTX* context, uint16_t port, SSL_SESSION* resume) {
+    const int fd = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, IPPROTO_TCP);
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (fd < 0 || ::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+        if (fd >= 0) {
+            ::close(fd);
+        }
+        return nullptr;
+    }
+    // 与服务端一致关闭 Nagle：握手尾部的 Finished 与紧随的请求是两次小写，否则会被延迟 ACK 拖住
+    const int one = 1;
+    ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+    SSL* ssl = SSL_new(context);
+    SSL_set_fd(ssl, fd);
+    if (resume) {
+        SSL_set_session(ssl, resume);
+    }
+
+    SSL_SESSION* session = nullptr;
+    if (SSL_connect(ssl) == 1 && SSL_write(ssl, kRequest, sizeof(kRequest) - 1) > 0) {
+        // 读完整个响应；TLS 1.3 的票据先于响应到达，读完即可取到最新会话
+        std::string response;
+        char buf[4096];
+        size_t headerEnd = std::string::npos;
+        size_t total = 0;
+        while (headerEnd == std::string::npos || response.size() < total) {
+            const int n = SSL_read(ssl, buf, sizeof(buf));
+            if (n <= 0) {
+                break;
+            }
+            response.append(buf, static_cast<size_t>(n));
+            if (headerEnd == std::string::npos && (headerEnd = response.find("\r\n\r\n")) != std::string::npos) {
+                const size_t pos = response.find("Content-Length: ");
+                total = headerEnd + 4 + (pos == std::string::npos ? 0 : std::stoul(response.substr(pos + 16)));
+            }
+        }
+        if (headerEnd != std::string::npos && response.size() >= total) {
+            session = SSL_get1_session(ssl);
+        }
+        // 不发 close_notify 直接断开，与浏览器/压测工具常见行为一致；标记关闭以免 OpenSSL 作废会话
+        SSL_set_shutdown(ssl, SSL_SENT_SHUTDOWN | SSL_RECEIVED_SHUTDOWN);
+    }
+
+    SSL_free(ssl);
+    ::close(fd);
+    return session;
+}
+
+struct Measurement {
+    double handshakesPerSec = 0;
+    double hitRate = 0;
+};
+
+Measurement measure(int version, Resumption resumption, uint16_t port, int clients, double seconds) {
+    HttpServer server("127.0.0.1", port, 1);
+    if (!server.set_tls_session_options(session_options_for(resumption))
+        || !server.enable_ssl(cert_path("test-cert.pem"), cert_path("test-key.pem"))) {
+        throw std::runtime_error("failed to enable TLS");
+    }
+    server.add_get_route("/ping", [](const HttpRequest&, HttpResponse& resp) {
+        resp.set_status(200, "OK");
+        resp.set_body("pong");
+        });
+
+    std::thread serverThread([&server]() {
+        server.start();
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+    SSL_CTX* context = create_client_context(version);
+    std::atomic<uint64_t> handshakes{ 0 };
+    const auto end = std::chrono::steady_clock::now()
+        + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(seconds));
+    std::vector<std::thread> workers;
+    const auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < clients; ++i) {
+        workers.emplace_back([&]() {
+            SSL_SESSION* session = nullptr;
+            uint64_t local = 0;
+            while (std::chrono::steady_clock::now() < end) {
+                SSL_SESSION* next = handshake_once(context, port, resumption == Resumption::None ? nullptr : session);
+                if (!next) {
+                    break;
+                }
+                SSL_SESSION_free(session);
+                session = next;
+                ++local;
+            }
+            SSL_SESSION_free(session);
+            handshakes.fetch_add(local);
+        });
+    }
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+    const double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    SSL_CTX_free(context);
+
+    // 客户端已全部断开，但服务端可能还没处理完最后几个握手，稍等再读统计
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    Measurement result;
+    result.handshakesPerSec = handshakes.load() / elapsed;
+    result.hitRate = server.get_tls_session_stats().hit_rate();
+
+    server.stop();
+    serverThread.join();
+    return result;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    try {
+        const double seconds = argc > 1 ? parse_seconds(argv[1]) : kDefaultSeconds;
+        const int clients = argc > 2 ? parse_clients(argv[2]) : kDefaultClients;
+        spdlog::set_level(spdlog::level::critical);
+
+        std::cout << "Tudou HTTPS session resumption benchmark, seconds=" << seconds << ", clients=" << clients << std::endl;
+        std::cout << "tls_version,resumption,handshakes_per_sec,server_hit_rate" << std::endl;
+
+        uint16_t port = kDefaultPort;
+        for (int version : { TLS1_2_VERSION, TLS1_3_VERSION }) {
+            for (Resumption resumption : { Resumption::None, Resumption::Ticket, Resumption::Cache }) {
+                const Measurement m = measure(version, resumption, port++, clients, seconds);
+                std::cout << (version == TLS1_3_VERSION ? "tls1.3" : "tls1.2") << "," << resumption_name(resumption) << ","
+                          << m.handshakesPerSec << "," << m.hitRate << std::endl;
+            }
+        }
+        return 0;
+    }
+    catch (const std::exception& ex) {
+        std::cerr << "usage: " << argv[0] << " [seconds] [clients]" << std::endl;
+        std::cerr << "error: " << ex.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+}
@@ -0,0 +1,109 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "spdlog/spdlog.h"
+#include "tudou/rpc/json/JsonRpcRouter.h"
+
+// JSON-RPC 批量请求的端到端派发延迟：Batch 中每个元素调用一个耗时 1 ms 的合成处理器（sleep，模拟下游 IO），
+// 对比顺序执行与不同工作线程数、并发上限下的并行执行，以及全部为 Notification 的 Batch 在并行模式下的返回延迟。
+
+namespace {
+
+constexpr int kDefaultBatches = 20;
+constexpr int kDefaultBatchSize = 100;
+
+struct Config {
+    const char* name;
+    int numThreads;          // 0 表示顺序执行
+    size_t maxConcurrency;
+};
+
+int parse_positive(const char* text, const char* what) {
+    const int value = std::stoi(text);
+    if (value <= 0) {
+        throw std::invalid_argument(std::string(what) + " must be > 0");
+    }
+    return value;
+}
+
+std::string build_batch(int batchSize, bool notifications) {
+    std::string request = "[";
+    for (int i = 0; i < batchSize; ++i) {
+        if (i > 0) {
+            request.push_back(',');
+        }
+        request += R"({"jsonrpc":"2.0","method":"io","params":[)" + std::to_string(i) + "]";
+        if (!notifications) {
+            request += R"(,"id":)" + std::to_string(i);
+        }
+        request.push_back('}');
+    }
+    request.push_back(']');
+    return request;
+}
+
+void register_io_method(JsonRpcRouter& router) {
+    router.register_method("io", [](const nlohmann::json& params) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        return params[0];
+    });
+}
+
+void run(const Config& config, const std::string& request, int batches, bool expectResponse) {
+    JsonRpcRouter router;
+    register_io_method(router);
+    if (config.numThreads > 0) {
+        router.enable_parallel_batch(config.numThreads, config.maxConcurrency);
+    }
+
+    std::vector<double> latencies;
+    latencies.reserve(static_cast<size_t>(batches));
+    for (int i = 0; i < batches; ++i) {
+        const auto start = std::chrono::steady_clock::now();
+        const std::string response = router.dispatch(request);
+        latencies.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+        if (response.empty() == expectResponse) {
+            throw std::runtime_error(std::string("unexpected response for ") + config.name);
+        }
+    }
+
+    std::sort(latencies.begin(), latencies.end());
+    std::cout << config.name << ": p50 " << latencies[latencies.size() / 2] << " ms/batch, max "
+              << latencies.back() << " ms/batch" << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    try {
+        const int batches = argc > 1 ? parse_positive(argv[1], "batches") : kDefaultBatches;
+        const int batchSize = argc > 2 ? parse_positive(argv[2], "batch size") : kDefaultBatchSize;
+        spdlog::set_level(spdlog::level::warn);
+
+        const std::string requests = build_batch(batchSize, false);
+        const std::string notifications = build_batch(batchSize, true);
+
+        std::cout << "Tudou JSON-RPC batch benchmark, batches=" << batches << ", batchSize=" << batchSize
+                  << ", handler=1 ms" << std::endl;
+        run({ "sequential                ", 0, 0 }, requests, batches, true);
+        run({ "parallel 8 threads        ", 8, 0 }, requests, batches, true);
+        run({ "parallel 32 threads       ", 32, 0 }, requests, batches, true);
+        run({ "parallel 32 threads, lim 8", 32, 8 }, requests, batches, true);
+        run({ "parallel 100 threads      ", 100, 0 }, requests, batches, true);
+        // Notification 提交后即返回，后台执行完之前 router 析构会等待线程池排空
+        run({ "notifications, 8 threads  ", 8, 0 }, notifications, batches, false);
+        return 0;
+    }
+    catch (const std::exception& ex) {
+        std::cerr << "usage: " << argv[0] << " [batches] [batchSize]" << std::endl;
+        std::cerr << "error: " << ex.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+}
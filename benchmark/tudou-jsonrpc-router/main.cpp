@@ -0,0 +1,157 @@
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "spdlog/spdlog.h"
+#include "tudou/rpc/json/JsonRpcRouter.h"
+
+// JSON-RPC 路由解析后端对比：同一组请求分别经 nlohmann DOM 后端、simdjson On-Demand 后端（nlohmann 处理器），
+// 以及 On-Demand 后端 + 原始文本处理器（全程不构建 DOM）派发，统计单次 dispatch 耗时与输入吞吐。
+// 小载荷为两个整数求和；中载荷携带约 4 KB 的 params 对象，处理器只取其中一个字段；批量为 50 个小请求组成的数组。
+
+namespace {
+
+constexpr int kDefaultIterations = 200000;
+
+struct Scenario {
+    const char* name;
+    std::string request;
+    int weight; // 相对小载荷的迭代次数缩放，保证各场景耗时相近
+};
+
+int parse_iterations(const char* text) {
+    const int value = std::stoi(text);
+    if (value <= 0) {
+        throw std::invalid_argument("iterations must be > 0");
+    }
+    return value;
+}
+
+std::string small_request(int id) {
+    return R"({"jsonrpc":"2.0","method":"sum","params":[)" + std::to_string(id) + R"(,42],"id":)" + std::to_string(id) + "}";
+}
+
+std::string medium_request() {
+    std::string params = "{";
+    for (int i = 0; i < 64; ++i) {
+        params += "\"field_" + std::to_string(i) + "\":{\"name\":\"item-" + std::to_string(i)
+            + "\",\"tags\":[\"alpha\",\"beta\",\"gamma\"],\"score\":" + std::to_string(i * 1.25) + "},";
+    }
+    params += "\"id\":7}";
+    return R"({"jsonrpc":"2.0","method":"lookup","params":)" + params + R"(,"id":"req-7"})";
+}
+
+std::string batch_request() {
+    std::string batch = "[";
+    for (int i = 0; i < 50; ++i) {
+        if (i > 0) {
+            batch += ",";
+        }
+        batch += small_request(i);
+    }
+    batch += "]";
+    return batch;
+}
+
+// 解析 "[a,b]" 形式的两个整数，演示原始文本处理器只按需读取 params
+int64_t parse_two_ints_sum(const char* params, size_t len) {
+    const std::string text(params, len);
+    char* end = nullptr;
+    const char* cursor = text.c_str() + 1;
+    const long long a = std::strtoll(cursor, &end, 10);
+    if (end == cursor || *end != ',') {
+        throw std::invalid_argument("params must be [a, b]");
+    }
+    cursor = end + 1;
+    const long long b = std::strtoll(cursor, &end, 10);
+    if (end == cursor) {
+        throw std::invalid_argument("params must be [a, b]");
+    }
+    return a + b;
+}
+
+void register_dom_methods(JsonRpcRouter& router) {
+    router.register_method("sum", [](const nlohmann::json& params) {
+        return params[0].get<int64_t>() + params[1].get<int64_t>();
+    });
+    router.register_method("lookup", [](const nlohmann::json& params) {
+        return params.at("id").get<int>();
+    });
+}
+
+void register_raw_methods(JsonRpcRouter& router) {
+    router.register_raw_method("sum", [](const char* params, size_t len, std::string& result) {
+        result.append(std::to_string(parse_two_ints_sum(params, len)));
+    });
+    router.register_raw_method("lookup", [](const char*, size_t, std::string& result) {
+        // 处理器不关心 params 内容时，On-Demand 后端连这 4 KB 都不会物化
+        result.append("7");
+    });
+}
+
+void run(const char* backendName, JsonRpcRouter& router, const Scenario& scenario, int iterations) {
+    const int rounds = iterations / scenario.weight;
+    std::string output;
+    size_t responseBytes = 0;
+
+    const auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < rounds; ++i) {
+        output.clear();
+        router.dispatch(scenario.request.data(), scenario.request.size(), output);
+        responseBytes += output.size();
+    }
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    const double mbPerSecond = static_cast<double>(scenario.request.size()) * rounds / (1024.0 * 1024.0) / seconds;
+    std::cout << "  " << backendName << ": " << seconds * 1e9 / rounds << " ns/dispatch, " << mbPerSecond << " MiB/s"
+              << " (response_bytes=" << responseBytes / rounds << ")" << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    try {
+        const int iterations = argc > 1 ? parse_iterations(argv[1]) : kDefaultIterations;
+        spdlog::set_level(spdlog::level::warn);
+
+        JsonRpcRouter dom;
+        register_dom_methods(dom);
+
+        const bool onDemandAvailable = JsonRpcRouter::is_backend_available(JsonRpcRouter::Backend::OnDemand);
+        JsonRpcRouter onDemand;
+        register_dom_methods(onDemand);
+        onDemand.set_backend(JsonRpcRouter::Backend::OnDemand);
+
+        JsonRpcRouter onDemandRaw;
+        register_raw_methods(onDemandRaw);
+        onDemandRaw.set_backend(JsonRpcRouter::Backend::OnDemand);
+
+        const std::vector<Scenario> scenarios = {
+            {"small", small_request(1), 1},
+            {"medium", medium_request(), 20},
+            {"batch", batch_request(), 50},
+        };
+
+        std::cout << "Tudou JSON-RPC router benchmark, iterations=" << iterations << std::endl;
+        if (!onDemandAvailable) {
+            std::cout << "  (simdjson not found at build time, on-demand rows fall back to the nlohmann backend)" << std::endl;
+        }
+        for (const Scenario& scenario : scenarios) {
+            std::cout << scenario.name << " payload, " << scenario.request.size() << " bytes/request:" << std::endl;
+            run("nlohmann dom       ", dom, scenario, iterations);
+            run("on-demand          ", onDemand, scenario, iterations);
+            run("on-demand + raw    ", onDemandRaw, scenario, iterations);
+        }
+        return 0;
+    }
+    catch (const std::exception& ex) {
+        std::cerr << "usage: " << argv[0] << " [iterations]" << std::endl;
+        std::cerr << "error: " << ex.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+}
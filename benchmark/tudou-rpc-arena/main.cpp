@@ -0,0 +1,188 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "arena_bench.pb.h"
+#include "tudou/rpc/binary/BinaryRpcRouter.h"
+
+// 嵌套消息 Echo 服务的单次调用开销：对比“逐个 new 请求/响应/闭包”的堆分配路径
+// 与 BinaryRpcRouter 内置的池化 Arena 路径，统计每次调用的堆分配次数与延迟分位数。
+
+namespace {
+
+std::atomic<uint64_t> g_allocations{0};
+
+} // namespace
+
+void* operator new(std::size_t size) {
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size == 0 ? 1 : size)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept {
+    std::free(p);
+}
+
+namespace {
+
+using tudou::rpc::binary::BinaryRpcRouter;
+using tudou::rpc::binary::bench::Item;
+using tudou::rpc::binary::bench::NestedEchoRequest;
+using tudou::rpc::binary::bench::NestedEchoResponse;
+using tudou::rpc::binary::bench::NestedEchoService;
+
+constexpr int kDefaultIterations = 100000;
+constexpr int kItemsPerRequest = 16;
+
+class NestedEchoServiceImpl : public NestedEchoService {
+public:
+    void Echo(google::protobuf::RpcController*,
+              const NestedEchoRequest* request,
+              NestedEchoResponse* response,
+              google::protobuf::Closure* done) override {
+        response->set_note(request->note());
+        response->mutable_items()->CopyFrom(request->items());
+        done->Run();
+    }
+};
+
+// 对照组：与改造前的 router 相同的堆分配方式
+class HeapClosure : public google::protobuf::Closure {
+public:
+    HeapClosure(google::protobuf::Message* response, std::string* out)
+        : response_(response), out_(out) {
+    }
+
+    void Run() override {
+        std::unique_ptr<google::protobuf::Closure> selfGuard(this);
+        std::unique_ptr<google::protobuf::Message> responseGuard(response_);
+        responseGuard->SerializeToString(out_);
+    }
+
+private:
+    google::protobuf::Message* response_;
+    std::string* out_;
+};
+
+int parse_iterations(const char* text) {
+    const int value = std::stoi(text);
+    if (value <= 0) {
+        throw std::invalid_argument("iterations must be > 0");
+    }
+    return value;
+}
+
+std::string build_request_payload() {
+    NestedEchoRequest request;
+    request.set_note("nested echo benchmark");
+    for (int i = 0; i < kItemsPerRequest; ++i) {
+        Item* item = request.add_items();
+        item->set_id(i);
+        item->set_name("item-name-that-does-not-fit-sso-" + std::to_string(i));
+        item->add_tags("tag-a-long-enough-to-force-a-heap-allocation");
+        item->add_tags("tag-b-long-enough-to-force-a-heap-allocation");
+    }
+    std::string payload;
+    request.SerializeToString(&payload);
+    return payload;
+}
+
+struct Result {
+    double allocationsPerCall;
+    double p50Us;
+    double p99Us;
+    double callsPerSecond;
+};
+
+template <typename Fn>
+Result measure(int iterations, Fn call) {
+    // 预热，使线程局部 Arena 池与 Router 内部结构就绪
+    for (int i = 0; i < 1000; ++i) {
+        call();
+    }
+
+    std::vector<double> latenciesUs;
+    latenciesUs.reserve(static_cast<size_t>(iterations));
+
+    const uint64_t allocationsBefore = g_allocations.load(std::memory_order_relaxed);
+    const auto begin = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i) {
+        const auto start = std::chrono::steady_clock::now();
+        call();
+        const auto end = std::chrono::steady_clock::now();
+        latenciesUs.push_back(std::chrono::duration<double, std::micro>(end - start).count());
+    }
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+    const uint64_t allocations = g_allocations.load(std::memory_order_relaxed) - allocationsBefore;
+
+    std::sort(latenciesUs.begin(), latenciesUs.end());
+    Result result;
+    result.allocationsPerCall = static_cast<double>(allocations) / iterations;
+    result.p50Us = latenciesUs[latenciesUs.size() / 2];
+    result.p99Us = latenciesUs[latenciesUs.size() * 99 / 100];
+    result.callsPerSecond = iterations / seconds;
+    return result;
+}
+
+void report(const char* name, const Result& result) {
+    std::cout << name << ": " << result.allocationsPerCall << " allocations/call, p50=" << result.p50Us
+              << " us, p99=" << result.p99Us << " us, " << static_cast<uint64_t>(result.callsPerSecond)
+              << " calls/s" << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    try {
+        const int iterations = argc > 1 ? parse_iterations(argv[1]) : kDefaultIterations;
+        const std::string payload = build_request_payload();
+        auto service = std::make_shared<NestedEchoServiceImpl>();
+        const google::protobuf::MethodDescriptor* method = service->GetDescriptor()->FindMethodByName("Echo");
+
+        std::cout << "Tudou RPC arena benchmark, iterations=" << iterations
+                  << ", items/request=" << kItemsPerRequest << ", payload=" << payload.size() << " bytes" << std::endl;
+
+        std::string responseRaw;
+        const Result heap = measure(iterations, [&]() {
+            std::unique_ptr<google::protobuf::Message> request(service->GetRequestPrototype(method).New());
+            request->ParseFromString(payload);
+            google::protobuf::Message* response = service->GetResponsePrototype(method).New();
+            service->CallMethod(method, nullptr, request.get(), response, new HeapClosure(response, &responseRaw));
+        });
+
+        BinaryRpcRouter router;
+        router.register_service(service);
+        const std::string serviceName = service->GetDescriptor()->full_name();
+        const Result arena = measure(iterations, [&]() {
+            router.dispatch(serviceName, "Echo", payload.data(), payload.size(), [&responseRaw](const std::string& raw) {
+                responseRaw = raw;
+            });
+        });
+
+        report("heap messages   ", heap);
+        report("router + arena  ", arena);
+        return 0;
+    }
+    catch (const std::exception& ex) {
+        std::cerr << "usage: " << argv[0] << " [iterations]" << std::endl;
+        std::cerr << "error: " << ex.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+}
@@ -0,0 +1,136 @@
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "coalesce_bench.pb.h"
+#include "spdlog/spdlog.h"
+#include "tudou/rpc/binary/BinaryRpcChannel.h"
+#include "tudou/rpc/binary/BinaryRpcClientLoopPool.h"
+#include "tudou/rpc/binary/BinaryRpcServer.h"
+
+// 单条 BinaryRpcChannel 上 1/16/256 个并发调用线程的吞吐（calls/s），
+// 分别覆盖阻塞线程模式与共享 loop 池模式，以及写合并逗留时间为 0 与 50µs 两种配置。
+
+namespace {
+
+using tudou::rpc::binary::BinaryRpcChannel;
+using tudou::rpc::binary::BinaryRpcClientLoopPool;
+using tudou::rpc::binary::BinaryRpcServer;
+using tudou::rpc::binary::bench::coalesce::CoalesceEchoService;
+using tudou::rpc::binary::bench::coalesce::CoalesceEchoService_Stub;
+using tudou::rpc::binary::bench::coalesce::EchoRequest;
+using tudou::rpc::binary::bench::coalesce::EchoResponse;
+
+constexpr uint16_t kDefaultPort = 19091;
+constexpr double kDefaultSeconds = 1.0;
+constexpr int kDefaultServerThreads = 4;
+
+class CoalesceEchoServiceImpl : public CoalesceEchoService {
+public:
+    void Echo(google::protobuf::RpcController*,
+              const EchoRequest* request,
+              EchoResponse* response,
+              google::protobuf::Closure* done) override {
+        response->set_payload(request->payload());
+        done->Run();
+    }
+};
+
+double parse_seconds(const char* text) {
+    const double value = std::stod(text);
+    if (value <= 0) {
+        throw std::invalid_argument("seconds must be > 0");
+    }
+    return value;
+}
+
+int parse_positive(const char* text, const char* name) {
+    const int value = std::stoi(text);
+    if (value <= 0) {
+        throw std::invalid_argument(std::string(name) + " must be > 0");
+    }
+    return value;
+}
+
+void run(const char* name, BinaryRpcChannel& channel, int callers, double seconds) {
+    std::atomic<bool> stop{false};
+    std::atomic<uint64_t> calls{0};
+    std::vector<std::thread> workers;
+    workers.reserve(callers);
+
+    const auto start = std::chrono::steady_clock::now();
+    for (int index = 0; index < callers; ++index) {
+        workers.emplace_back([&channel, &stop, &calls]() {
+            CoalesceEchoService_Stub stub(&channel);
+            EchoRequest request;
+            request.set_payload(std::string(64, 'x'));
+            EchoResponse response;
+            uint64_t local = 0;
+            while (!stop.load(std::memory_order_relaxed)) {
+                stub.Echo(nullptr, &request, &response, nullptr);
+                ++local;
+            }
+            calls.fetch_add(local, std::memory_order_relaxed);
+        });
+    }
+
+    std::this_thread::sleep_for(std::chrono::duration<double>(seconds));
+    stop = true;
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    const double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::cout << name << ", callers=" << callers << ": "
+              << static_cast<uint64_t>(calls.load() / elapsed) << " calls/s" << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    try {
+        const double seconds = argc > 1 ? parse_seconds(argv[1]) : kDefaultSeconds;
+        const int serverThreads = argc > 2 ? parse_positive(argv[2], "server threads") : kDefaultServerThreads;
+        spdlog::set_level(spdlog::level::warn);
+
+        BinaryRpcServer server("127.0.0.1", kDefaultPort, serverThreads);
+        server.register_service(std::make_shared<CoalesceEchoServiceImpl>());
+        std::thread serverThread([&server]() {
+            server.start();
+        });
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+        auto loopPool = std::make_shared<BinaryRpcClientLoopPool>(1);
+
+        std::cout << "Tudou RPC write coalescing benchmark, seconds=" << seconds
+                  << ", server threads=" << serverThreads << std::endl;
+        for (int lingerUs : {0, 50}) {
+            for (int callers : {1, 16, 256}) {
+                BinaryRpcChannel threadChannel("127.0.0.1", kDefaultPort);
+                threadChannel.set_write_linger(std::chrono::microseconds(lingerUs));
+                run(lingerUs == 0 ? "thread mode, linger=0us " : "thread mode, linger=50us", threadChannel, callers, seconds);
+
+                BinaryRpcChannel loopChannel(loopPool, "127.0.0.1", kDefaultPort);
+                loopChannel.set_write_linger(std::chrono::microseconds(lingerUs));
+                run(lingerUs == 0 ? "loop mode,   linger=0us " : "loop mode,   linger=50us", loopChannel, callers, seconds);
+            }
+        }
+
+        server.stop();
+        serverThread.join();
+        return 0;
+    }
+    catch (const std::exception& ex) {
+        std::cerr << "usage: " << argv[0] << " [seconds] [server threads]" << std::endl;
+        std::cerr << "error: " << ex.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+}
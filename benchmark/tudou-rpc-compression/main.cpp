@@ -0,0 +1,202 @@
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <deque>
+#include <exception>
+#include <future>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "compression_bench.pb.h"
+#include "spdlog/spdlog.h"
+#include "tudou/rpc/binary/BinaryRpcChannel.h"
+#include "tudou/rpc/binary/BinaryRpcClientLoopPool.h"
+#include "tudou/rpc/binary/BinaryRpcCompression.h"
+#include "tudou/rpc/binary/BinaryRpcServer.h"
+
+// 载荷压缩压测：服务端按请求返回 rows 行数据，可压缩载荷为字段大量重复的文本行，不可压缩载荷为随机字节。
+// 分别在不压缩与本构建编入的各压缩算法下，以固定并发深度连续调用，统计吞吐与每次调用的线路字节数（含帧头）。
+// 输出为 CSV，可直接对比带宽受限链路上压缩节省的字节数与付出的 CPU 代价。
+
+namespace {
+
+using tudou::rpc::binary::BinaryRpcChannel;
+using tudou::rpc::binary::BinaryRpcClientLoopPool;
+using tudou::rpc::binary::BinaryRpcCompression;
+using tudou::rpc::binary::BinaryRpcServer;
+using tudou::rpc::binary::CompressionOptions;
+using tudou::rpc::binary::CompressionType;
+using tudou::rpc::binary::bench::compression::FetchRequest;
+using tudou::rpc::binary::bench::compression::FetchResponse;
+using tudou::rpc::binary::bench::compression::FetchService;
+
+constexpr uint16_t kDefaultPort = 19094;
+constexpr double kDefaultSeconds = 1.0;
+constexpr int kDefaultRows = 256;
+constexpr size_t kPipelineDepth = 16;
+constexpr size_t kRowBytes = 64;
+
+class FetchServiceImpl : public FetchService {
+public:
+    FetchServiceImpl() {
+        std::mt19937 rng(2024);
+        for (int index = 0; index < 1024; ++index) {
+            std::string row = "user_id=" + std::to_string(100000 + index) + ",region=us-east-1,tier=gold,status=active";
+            row.resize(kRowBytes, ' ');
+            compressibleRows_.push_back(std::move(row));
+
+            std::string noise(kRowBytes, '\0');
+            for (char& ch : noise) {
+                ch = static_cast<char>(rng());
+            }
+            randomRows_.push_back(std::move(noise));
+        }
+    }
+
+    void Fetch(google::protobuf::RpcController*,
+               const FetchRequest* request,
+               FetchResponse* response,
+               google::protobuf::Closure* done) override {
+        const std::vector<std::string>& rows = request->compressible() ? compressibleRows_ : randomRows_;
+        for (uint32_t index = 0; index < request->rows(); ++index) {
+            response->add_rows(rows[index % rows.size()]);
+        }
+        done->Run();
+    }
+
+private:
+    std::vector<std::string> compressibleRows_;
+    std::vector<std::string> randomRows_;
+};
+
+const char* type_name(CompressionType type) {
+    switch (type) {
+    case CompressionType::Zlib:
+        return "zlib";
+    case CompressionType::Lz4:
+        return "lz4";
+    case CompressionType::Zstd:
+        return "zstd";
+    default:
+        return "none";
+    }
+}
+
+double parse_seconds(const char* text) {
+    const double value = std::stod(text);
+    if (value <= 0) {
+        throw std::invalid_argument("seconds must be > 0");
+    }
+    return value;
+}
+
+int parse_positive(const char* text, const char* name) {
+    const int value = std::stoi(text);
+    if (value <= 0) {
+        throw std::invalid_argument(std::string(name) + " must be > 0");
+    }
+    return value;
+}
+
+void run(BinaryRpcChannel& channel, CompressionType type, bool compressible, int rows, double seconds) {
+    const google::protobuf::MethodDescriptor* method = FetchService::descriptor()->FindMethodByName("Fetch");
+    FetchRequest request;
+    request.set_rows(static_cast<uint32_t>(rows));
+    request.set_compressible(compressible);
+
+    struct InFlight {
+        std::unique_ptr<FetchResponse> response;
+        std::future<void> future;
+    };
+    std::deque<InFlight> inFlight;
+    uint64_t calls = 0;
+    uint64_t payloadBytes = 0;
+
+    const uint64_t sentBefore = channel.get_bytes_sent();
+    const uint64_t receivedBefore = channel.get_bytes_received();
+    const auto start = std::chrono::steady_clock::now();
+    const auto end = start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(seconds));
+
+    // 保持固定深度的在途调用，让同一连接上的帧持续流动
+    while (std::chrono::steady_clock::now() < end || !inFlight.empty()) {
+        if (std::chrono::steady_clock::now() < end && inFlight.size() < kPipelineDepth) {
+            InFlight call;
+            call.response = std::make_unique<FetchResponse>();
+            call.future = channel.call_async(method, &request, call.response.get());
+            inFlight.push_back(std::move(call));
+            continue;
+        }
+        inFlight.front().future.get();
+        payloadBytes += inFlight.front().response->ByteSizeLong();
+        inFlight.pop_front();
+        ++calls;
+    }
+
+    const double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    const uint64_t wireBytes = (channel.get_bytes_sent() - sentBefore) + (channel.get_bytes_received() - receivedBefore);
+    std::cout << type_name(type) << "," << (compressible ? "compressible" : "incompressible") << ","
+              << static_cast<uint64_t>(calls / elapsed) << ","
+              << static_cast<uint64_t>(payloadBytes / elapsed / (1024 * 1024)) << ","
+              << (calls > 0 ? payloadBytes / calls : 0) << ","
+              << (calls > 0 ? wireBytes / calls : 0) << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    try {
+        const double seconds = argc > 1 ? parse_seconds(argv[1]) : kDefaultSeconds;
+        const int rows = argc > 2 ? parse_positive(argv[2], "rows") : kDefaultRows;
+        spdlog::set_level(spdlog::level::critical);
+
+        std::vector<CompressionType> types = {CompressionType::None};
+        for (CompressionType type : {CompressionType::Lz4, CompressionType::Zstd, CompressionType::Zlib}) {
+            if (BinaryRpcCompression::is_supported(type)) {
+                types.push_back(type);
+            }
+        }
+
+        CompressionOptions serverOptions;
+        serverOptions.accepted.assign(types.begin() + 1, types.end());
+        BinaryRpcServer server("127.0.0.1", kDefaultPort, 1);
+        server.register_service(std::make_shared<FetchServiceImpl>());
+        server.set_compression_options(serverOptions);
+        std::thread serverThread([&server]() {
+            server.start();
+        });
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+        std::cout << "Tudou RPC compression benchmark, seconds=" << seconds << ", rows=" << rows
+                  << ", row_bytes=" << kRowBytes << ", depth=" << kPipelineDepth << std::endl;
+        std::cout << "algorithm,payload,calls_per_sec,payload_mb_per_sec,payload_bytes_per_call,wire_bytes_per_call" << std::endl;
+
+        auto loopPool = std::make_shared<BinaryRpcClientLoopPool>(1);
+        for (CompressionType type : types) {
+            BinaryRpcChannel channel(loopPool, "127.0.0.1", kDefaultPort);
+            if (type != CompressionType::None) {
+                CompressionOptions options;
+                options.accepted = {type};
+                channel.set_compression_options(options);
+                while (channel.get_compression() != type) {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                }
+            }
+            run(channel, type, true, rows, seconds);
+            run(channel, type, false, rows, seconds);
+        }
+
+        server.stop();
+        serverThread.join();
+        return 0;
+    }
+    catch (const std::exception& ex) {
+        std::cerr << "usage: " << argv[0] << " [seconds] [rows]" << std::endl;
+        std::cerr << "error: " << ex.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+}
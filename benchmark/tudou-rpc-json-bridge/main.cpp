@@ -0,0 +1,192 @@
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <functional>
+#include <future>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+#include <google/protobuf/util/json_util.h>
+
+#include "binary_rpc.pb.h"
+#include "json_bridge_bench.pb.h"
+#include "nlohmann/json.hpp"
+#include "spdlog/spdlog.h"
+#include "tudou/rpc/UnifiedRpcServer.h"
+#include "tudou/rpc/binary/BinaryRpcRouter.h"
+#include "tudou/rpc/json/JsonRpcRouter.h"
+
+// 同一个 Protobuf Service 方法经不同入口执行一次调用的服务端耗时：
+// 原生二进制 RPC（反序列化请求 -> 业务 -> 序列化响应）与 JSON-RPC 桥接（解析 JSON -> 转 Protobuf -> 业务 -> 打印 JSON）。
+// 桥接分为旧实现（params 先 dump 成字符串、响应再 parse 回 nlohmann DOM）与直接转码两种。
+
+namespace {
+
+using tudou::rpc::RpcMethodTable;
+using tudou::rpc::UnifiedRpcServer;
+using tudou::rpc::binary::BinaryRpcRouter;
+using tudou::rpc::bench::json_bridge::QuoteRequest;
+using tudou::rpc::bench::json_bridge::QuoteResponse;
+using tudou::rpc::bench::json_bridge::QuoteService;
+
+constexpr int kDefaultIterations = 200000;
+
+class QuoteServiceImpl : public QuoteService {
+public:
+    void Quote(google::protobuf::RpcController*,
+               const QuoteRequest* request,
+               QuoteResponse* response,
+               google::protobuf::Closure* done) override {
+        response->set_symbol(request->symbol());
+        response->set_filled(request->quantity());
+        for (double level : request->levels()) {
+            auto* fill = response->add_fills();
+            fill->set_price(level);
+            fill->set_quantity(request->quantity() / request->levels_size());
+        }
+        done->Run();
+    }
+};
+
+int parse_iterations(const char* text) {
+    const int value = std::stoi(text);
+    if (value <= 0) {
+        throw std::invalid_argument("iterations must be > 0");
+    }
+    return value;
+}
+
+QuoteRequest build_request() {
+    QuoteRequest request;
+    request.set_symbol("TUDOU");
+    request.set_quantity(1200);
+    for (double level : { 10.25, 10.5, 10.75, 11.0 }) {
+        request.add_levels(level);
+    }
+    request.mutable_account()->set_id("acct-000042");
+    request.mutable_account()->set_region("cn-east");
+    return request;
+}
+
+// 改造前 UnifiedRpcServer 的桥接方式，作为对照
+JsonRpcRouter::RpcHandler make_legacy_bridge(std::shared_ptr<google::protobuf::Service> service,
+    const google::protobuf::MethodDescriptor* method) {
+    return [service, method](const nlohmann::json& params) -> nlohmann::json {
+        std::unique_ptr<google::protobuf::Message> request(service->GetRequestPrototype(method).New());
+        std::unique_ptr<google::protobuf::Message> response(service->GetResponsePrototype(method).New());
+
+        google::protobuf::util::JsonParseOptions parseOptions;
+        parseOptions.ignore_unknown_fields = true;
+        if (!google::protobuf::util::JsonStringToMessage(params.is_null() ? "{}" : params.dump(), request.get(), parseOptions).ok()) {
+            throw std::invalid_argument("bad params");
+        }
+
+        struct SyncClosure : public google::protobuf::Closure {
+            std::promise<void> promise;
+            void Run() override { promise.set_value(); }
+        };
+        SyncClosure doneClosure;
+        auto doneFuture = doneClosure.promise.get_future();
+        service->CallMethod(method, nullptr, request.get(), response.get(), &doneClosure);
+        doneFuture.wait();
+
+        std::string responseJson;
+        google::protobuf::util::JsonPrintOptions printOptions;
+        printOptions.always_print_primitive_fields = true;
+        google::protobuf::util::MessageToJsonString(*response, &responseJson, printOptions);
+        return nlohmann::json::parse(responseJson);
+    };
+}
+
+void report(const char* name, size_t requestBytes, double seconds, int iterations, double baseline) {
+    const double nsPerCall = seconds * 1e9 / iterations;
+    std::cout << name << ": " << requestBytes << " bytes/request, " << nsPerCall << " ns/call";
+    if (baseline > 0) {
+        std::cout << " (" << nsPerCall / baseline << "x binary)";
+    }
+    std::cout << std::endl;
+}
+
+double run_binary(BinaryRpcRouter& router, uint32_t methodId, const std::string& body, int iterations) {
+    uint64_t responseBytes = 0;
+    auto onDone = [&responseBytes](const std::string& responseRaw) {
+        responseBytes += responseRaw.size();
+    };
+
+    const auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i) {
+        router.dispatch(methodId, body.data(), body.size(), onDone);
+    }
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    if (responseBytes == 0) {
+        throw std::runtime_error("binary dispatch produced no response");
+    }
+    return seconds;
+}
+
+double run_json(JsonRpcRouter& router, const std::string& request, int iterations) {
+    std::string output;
+    const auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i) {
+        output.clear();
+        router.dispatch(request.data(), request.size(), output);
+    }
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    if (output.find("\"result\"") == std::string::npos) {
+        throw std::runtime_error("unexpected JSON-RPC response: " + output);
+    }
+    return seconds;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    try {
+        const int iterations = argc > 1 ? parse_iterations(argv[1]) : kDefaultIterations;
+        spdlog::set_level(spdlog::level::warn);
+
+        auto service = std::make_shared<QuoteServiceImpl>();
+        const google::protobuf::MethodDescriptor* method = service->GetDescriptor()->FindMethodByName("Quote");
+        const QuoteRequest request = build_request();
+
+        BinaryRpcRouter binaryRouter;
+        binaryRouter.register_service(service);
+        RpcMethodTable table;
+        binaryRouter.export_method_table(&table);
+        std::string body;
+        request.SerializeToString(&body);
+
+        std::string params;
+        google::protobuf::util::MessageToJsonString(request, &params);
+        const std::string jsonRequest = R"({"jsonrpc":"2.0","method":"Quote","params":)" + params + R"(,"id":1})";
+
+        std::cout << "Tudou RPC JSON bridge benchmark, iterations=" << iterations << std::endl;
+        const double binarySeconds = run_binary(binaryRouter, table.methods(0).method_id(), body, iterations);
+        const double baseline = binarySeconds * 1e9 / iterations;
+        report("binary rpc               ", body.size(), binarySeconds, iterations, 0);
+
+        JsonRpcRouter legacyRouter;
+        legacyRouter.register_method("Quote", make_legacy_bridge(service, method));
+        report("json bridge, legacy      ", jsonRequest.size(), run_json(legacyRouter, jsonRequest, iterations), iterations, baseline);
+
+        JsonRpcRouter directRouter;
+        directRouter.register_raw_method("Quote", UnifiedRpcServer::make_json_bridge(service, method));
+        report("json bridge, direct      ", jsonRequest.size(), run_json(directRouter, jsonRequest, iterations), iterations, baseline);
+
+        if (directRouter.set_backend(JsonRpcRouter::Backend::OnDemand)) {
+            report("json bridge, direct + ond", jsonRequest.size(), run_json(directRouter, jsonRequest, iterations), iterations, baseline);
+        }
+        else {
+            std::cout << "json bridge, direct + ond: skipped (built without simdjson)" << std::endl;
+        }
+        return 0;
+    }
+    catch (const std::exception& ex) {
+        std::cerr << "usage: " << argv[0] << " [iterations]" << std::endl;
+        std::cerr << "error: " << ex.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+}
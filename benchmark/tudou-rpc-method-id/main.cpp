@@ -0,0 +1,130 @@
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+#include "binary_rpc.pb.h"
+#include "method_id_bench.pb.h"
+#include "spdlog/spdlog.h"
+#include "tudou/rpc/binary/BinaryRpcCodec.h"
+#include "tudou/rpc/binary/BinaryRpcRouter.h"
+#include "tudou/tcp/Buffer.h"
+
+// 小载荷 RPC 下 version 1（完整方法名）与 version 2（协商后的方法 ID）的对比：
+// 每帧字节数，以及服务端“窥探帧 -> 解析 RpcMeta -> 路由定位 -> 执行空业务”的单次耗时。
+
+namespace {
+
+using tudou::rpc::RpcMeta;
+using tudou::rpc::RpcMethodTable;
+using tudou::rpc::binary::BinaryRpcCodec;
+using tudou::rpc::binary::BinaryRpcRouter;
+using tudou::rpc::binary::RpcHeader;
+using tudou::rpc::binary::RpcMessageType;
+using tudou::rpc::binary::bench::method_id::InventoryLookupService;
+using tudou::rpc::binary::bench::method_id::PingRequest;
+using tudou::rpc::binary::bench::method_id::PingResponse;
+
+constexpr int kDefaultIterations = 1000000;
+
+class InventoryLookupServiceImpl : public InventoryLookupService {
+public:
+    void Ping(google::protobuf::RpcController*,
+              const PingRequest* request,
+              PingResponse* response,
+              google::protobuf::Closure* done) override {
+        response->set_value(request->value());
+        done->Run();
+    }
+};
+
+int parse_iterations(const char* text) {
+    const int value = std::stoi(text);
+    if (value <= 0) {
+        throw std::invalid_argument("iterations must be > 0");
+    }
+    return value;
+}
+
+std::string build_frame(const RpcMeta& meta, uint8_t version) {
+    std::string metaRaw;
+    meta.SerializeToString(&metaRaw);
+
+    PingRequest request;
+    request.set_value(42);
+    std::string bodyRaw;
+    request.SerializeToString(&bodyRaw);
+
+    Buffer buf;
+    BinaryRpcCodec::encode(&buf, RpcMessageType::Request, 1, metaRaw, bodyRaw, version);
+    return buf.read_from_buffer();
+}
+
+void run(const char* name, BinaryRpcRouter& router, const std::string& frame, int iterations) {
+    Buffer buf;
+    RpcHeader header;
+    const char* metaData = nullptr;
+    const char* bodyData = nullptr;
+    uint64_t responses = 0;
+    auto onDone = [&responses](const std::string&) {
+        ++responses;
+    };
+
+    const auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i) {
+        buf.write_to_buffer(frame.data(), frame.size());
+        if (BinaryRpcCodec::peek(&buf, header, metaData, bodyData) != BinaryRpcCodec::DecodeResult::Success) {
+            throw std::runtime_error("unexpected decode result");
+        }
+
+        RpcMeta meta;
+        meta.ParseFromArray(metaData, static_cast<int>(header.metaLen));
+        if (meta.method_id() != 0) {
+            router.dispatch(meta.method_id(), bodyData, header.bodyLen, onDone);
+        }
+        else {
+            router.dispatch(meta.service_name(), meta.method_name(), bodyData, header.bodyLen, onDone);
+        }
+        buf.advance_read_index(BinaryRpcCodec::frame_size(header));
+    }
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::cout << name << ": " << frame.size() << " bytes/frame, " << seconds * 1e9 / iterations << " ns/call"
+              << " (responses=" << responses << ")" << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    try {
+        const int iterations = argc > 1 ? parse_iterations(argv[1]) : kDefaultIterations;
+        spdlog::set_level(spdlog::level::warn);
+
+        BinaryRpcRouter router;
+        router.register_service(std::make_shared<InventoryLookupServiceImpl>());
+
+        RpcMethodTable table;
+        router.export_method_table(&table);
+
+        RpcMeta byName;
+        byName.set_service_name(table.methods(0).service_name());
+        byName.set_method_name(table.methods(0).method_name());
+
+        RpcMeta byId;
+        byId.set_method_id(table.methods(0).method_id());
+
+        std::cout << "Tudou RPC method id benchmark, iterations=" << iterations << std::endl;
+        run("v1 method names", router, build_frame(byName, tudou::rpc::binary::kRpcVersion), iterations);
+        run("v2 method id   ", router, build_frame(byId, tudou::rpc::binary::kRpcVersionMethodId), iterations);
+        return 0;
+    }
+    catch (const std::exception& ex) {
+        std::cerr << "usage: " << argv[0] << " [iterations]" << std::endl;
+        std::cerr << "error: " << ex.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+}
@@ -0,0 +1,180 @@
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "overload_bench.pb.h"
+#include "spdlog/spdlog.h"
+#include "tudou/rpc/binary/BinaryRpcChannel.h"
+#include "tudou/rpc/binary/BinaryRpcClientLoopPool.h"
+#include "tudou/rpc/binary/BinaryRpcServer.h"
+
+// 开环压测：单 IO 线程的 BinaryRpcServer 上每个请求占用固定 CPU 时间，客户端按固定速率发请求（不等回包），
+// 在容量的 0.5x ~ 4x 区间逐级加压，对比关闭准入控制与开启自适应准入控制时的 goodput
+// （在 SLO 时限内成功返回的请求数/秒）。输出为 CSV，可直接用于绘制 goodput-offered load 曲线。
+
+namespace {
+
+using tudou::rpc::binary::BinaryRpcChannel;
+using tudou::rpc::binary::BinaryRpcClientLoopPool;
+using tudou::rpc::binary::BinaryRpcServer;
+using tudou::rpc::binary::bench::overload::OverloadWorkService;
+using tudou::rpc::binary::bench::overload::WorkRequest;
+using tudou::rpc::binary::bench::overload::WorkResponse;
+
+constexpr uint16_t kDefaultPort = 19092;
+constexpr double kDefaultSeconds = 1.0;
+constexpr int kDefaultWorkUs = 200;
+constexpr int kDefaultSloMs = 20;
+constexpr int kChannelNum = 8;
+constexpr double kLoadFactors[] = {0.5, 1.0, 1.5, 2.0, 3.0, 4.0};
+
+class OverloadWorkServiceImpl : public OverloadWorkService {
+public:
+    void Work(google::protobuf::RpcController*,
+              const WorkRequest* request,
+              WorkResponse* response,
+              google::protobuf::Closure* done) override {
+        // 忙等模拟纯 CPU 业务，避免 sleep 让出 IO 线程
+        const auto until = std::chrono::steady_clock::now() + std::chrono::microseconds(request->work_us());
+        while (std::chrono::steady_clock::now() < until) {
+        }
+        response->set_work_us(request->work_us());
+        done->Run();
+    }
+};
+
+struct Counters {
+    std::atomic<uint64_t> good{0};      // SLO 内成功
+    std::atomic<uint64_t> late{0};      // 成功但超出 SLO
+    std::atomic<uint64_t> rejected{0};  // 服务端过载拒绝或调用失败
+    std::atomic<uint64_t> outstanding{0};
+};
+
+double parse_seconds(const char* text) {
+    const double value = std::stod(text);
+    if (value <= 0) {
+        throw std::invalid_argument("seconds must be > 0");
+    }
+    return value;
+}
+
+int parse_positive(const char* text, const char* name) {
+    const int value = std::stoi(text);
+    if (value <= 0) {
+        throw std::invalid_argument(std::string(name) + " must be > 0");
+    }
+    return value;
+}
+
+void run(const char* mode, std::vector<std::unique_ptr<BinaryRpcChannel>>& channels,
+         double offeredRps, int workUs, std::chrono::milliseconds slo, double seconds) {
+    const google::protobuf::MethodDescriptor* method = OverloadWorkService::descriptor()->FindMethodByName("Work");
+    WorkRequest request;
+    request.set_work_us(static_cast<uint32_t>(workUs));
+    Counters counters;
+
+    // 每毫秒补发到期的请求，保持开环速率，不受回包快慢影响
+    const auto start = std::chrono::steady_clock::now();
+    const auto end = start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(seconds));
+    uint64_t sent = 0;
+    while (std::chrono::steady_clock::now() < end) {
+        const double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        const uint64_t due = static_cast<uint64_t>(offeredRps * elapsed);
+        for (; sent < due; ++sent) {
+            auto response = std::make_shared<WorkResponse>();
+            const auto issuedAt = std::chrono::steady_clock::now();
+            counters.outstanding.fetch_add(1, std::memory_order_relaxed);
+            channels[sent % channels.size()]->call_async(method, &request, response.get(),
+                [&counters, response, issuedAt, slo](std::exception_ptr error) {
+                    if (error) {
+                        counters.rejected.fetch_add(1, std::memory_order_relaxed);
+                    }
+                    else if (std::chrono::steady_clock::now() - issuedAt <= slo) {
+                        counters.good.fetch_add(1, std::memory_order_relaxed);
+                    }
+                    else {
+                        counters.late.fetch_add(1, std::memory_order_relaxed);
+                    }
+                    counters.outstanding.fetch_sub(1, std::memory_order_relaxed);
+                });
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    // 等积压排空（未开启准入控制时可能要很久，客户端调用时限兜底）再进入下一档
+    while (counters.outstanding.load(std::memory_order_relaxed) > 0) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    std::cout << mode << "," << static_cast<uint64_t>(offeredRps) << ","
+              << static_cast<uint64_t>(counters.good.load() / seconds) << ","
+              << static_cast<uint64_t>(counters.late.load() / seconds) << ","
+              << static_cast<uint64_t>(counters.rejected.load() / seconds) << std::endl;
+}
+
+void run_mode(const char* mode, uint16_t port, const AdmissionOptions* admission,
+              int workUs, std::chrono::milliseconds slo, double seconds) {
+    BinaryRpcServer server("127.0.0.1", port, 1);
+    server.register_service(std::make_shared<OverloadWorkServiceImpl>());
+    if (admission != nullptr) {
+        server.set_admission_options(*admission);
+    }
+    std::thread serverThread([&server]() {
+        server.start();
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+    auto loopPool = std::make_shared<BinaryRpcClientLoopPool>(1);
+    std::vector<std::unique_ptr<BinaryRpcChannel>> channels;
+    for (int index = 0; index < kChannelNum; ++index) {
+        channels.push_back(std::make_unique<BinaryRpcChannel>(loopPool, "127.0.0.1", port));
+        channels.back()->set_default_timeout(std::chrono::seconds(2));
+    }
+
+    const double capacityRps = 1e6 / workUs;
+    for (double factor : kLoadFactors) {
+        run(mode, channels, capacityRps * factor, workUs, slo, seconds);
+    }
+
+    channels.clear();
+    server.stop();
+    serverThread.join();
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    try {
+        const double seconds = argc > 1 ? parse_seconds(argv[1]) : kDefaultSeconds;
+        const int workUs = argc > 2 ? parse_positive(argv[2], "work us") : kDefaultWorkUs;
+        const std::chrono::milliseconds slo(argc > 3 ? parse_positive(argv[3], "slo ms") : kDefaultSloMs);
+        spdlog::set_level(spdlog::level::critical);
+
+        std::cout << "Tudou RPC overload benchmark, seconds=" << seconds << ", work=" << workUs
+                  << "us, slo=" << slo.count() << "ms" << std::endl;
+        std::cout << "mode,offered_rps,goodput_rps,late_rps,rejected_rps" << std::endl;
+
+        run_mode("no-admission", kDefaultPort, nullptr, workUs, slo, seconds);
+
+        AdmissionOptions adaptive;
+        adaptive.maxConcurrency = 64;
+        adaptive.adaptive = true;
+        adaptive.targetQueueDelay = std::chrono::milliseconds(2);
+        adaptive.interval = std::chrono::milliseconds(50);
+        run_mode("adaptive-admission", kDefaultPort + 1, &adaptive, workUs, slo, seconds);
+        return 0;
+    }
+    catch (const std::exception& ex) {
+        std::cerr << "usage: " << argv[0] << " [seconds] [work us] [slo ms]" << std::endl;
+        std::cerr << "error: " << ex.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+}
@@ -0,0 +1,136 @@
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "pool_bench.pb.h"
+#include "spdlog/spdlog.h"
+#include "tudou/rpc/binary/BinaryRpcClientLoopPool.h"
+#include "tudou/rpc/binary/BinaryRpcPooledChannel.h"
+#include "tudou/rpc/binary/BinaryRpcServer.h"
+
+// 同一进程内起一个多 IO 线程的 BinaryRpcServer，客户端用 BinaryRpcPooledChannel 以 K = 1/2/4/8 条连接
+// 承载固定数量的并发调用线程，对比不同 K 下的吞吐（calls/s）。
+
+namespace {
+
+using tudou::rpc::binary::BinaryRpcClientLoopPool;
+using tudou::rpc::binary::BinaryRpcPooledChannel;
+using tudou::rpc::binary::BinaryRpcPooledChannelOptions;
+using tudou::rpc::binary::BinaryRpcServer;
+using tudou::rpc::binary::LoadBalancePolicy;
+using tudou::rpc::binary::bench::pool::EchoRequest;
+using tudou::rpc::binary::bench::pool::EchoResponse;
+using tudou::rpc::binary::bench::pool::PoolEchoService;
+using tudou::rpc::binary::bench::pool::PoolEchoService_Stub;
+
+constexpr uint16_t kDefaultPort = 19090;
+constexpr double kDefaultSeconds = 2.0;
+constexpr int kDefaultCallers = 64;
+constexpr int kDefaultServerThreads = 8;
+
+class PoolEchoServiceImpl : public PoolEchoService {
+public:
+    void Echo(google::protobuf::RpcController*,
+              const EchoRequest* request,
+              EchoResponse* response,
+              google::protobuf::Closure* done) override {
+        response->set_payload(request->payload());
+        done->Run();
+    }
+};
+
+double parse_seconds(const char* text) {
+    const double value = std::stod(text);
+    if (value <= 0) {
+        throw std::invalid_argument("seconds must be > 0");
+    }
+    return value;
+}
+
+int parse_positive(const char* text, const char* name) {
+    const int value = std::stoi(text);
+    if (value <= 0) {
+        throw std::invalid_argument(std::string(name) + " must be > 0");
+    }
+    return value;
+}
+
+void run(const std::shared_ptr<BinaryRpcClientLoopPool>& loopPool, uint16_t port, size_t connections, int callers, double seconds) {
+    BinaryRpcPooledChannelOptions options;
+    options.connectionsPerEndpoint = connections;
+    options.policy = LoadBalancePolicy::LeastOutstanding;
+    BinaryRpcPooledChannel channel(loopPool, {{"127.0.0.1", port}}, options);
+
+    std::atomic<bool> stop{false};
+    std::atomic<uint64_t> calls{0};
+    std::vector<std::thread> workers;
+    workers.reserve(callers);
+
+    const auto start = std::chrono::steady_clock::now();
+    for (int index = 0; index < callers; ++index) {
+        workers.emplace_back([&channel, &stop, &calls]() {
+            PoolEchoService_Stub stub(&channel);
+            EchoRequest request;
+            request.set_payload(std::string(64, 'x'));
+            EchoResponse response;
+            uint64_t local = 0;
+            while (!stop.load(std::memory_order_relaxed)) {
+                stub.Echo(nullptr, &request, &response, nullptr);
+                ++local;
+            }
+            calls.fetch_add(local, std::memory_order_relaxed);
+        });
+    }
+
+    std::this_thread::sleep_for(std::chrono::duration<double>(seconds));
+    stop = true;
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    const double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::cout << "K=" << connections << ": " << static_cast<uint64_t>(calls.load() / elapsed) << " calls/s" << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    try {
+        const double seconds = argc > 1 ? parse_seconds(argv[1]) : kDefaultSeconds;
+        const int callers = argc > 2 ? parse_positive(argv[2], "callers") : kDefaultCallers;
+        const int serverThreads = argc > 3 ? parse_positive(argv[3], "server threads") : kDefaultServerThreads;
+        spdlog::set_level(spdlog::level::warn);
+
+        BinaryRpcServer server("127.0.0.1", kDefaultPort, serverThreads);
+        server.register_service(std::make_shared<PoolEchoServiceImpl>());
+        std::thread serverThread([&server]() {
+            server.start();
+        });
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+        auto loopPool = std::make_shared<BinaryRpcClientLoopPool>(4);
+
+        std::cout << "Tudou RPC pooled channel benchmark, seconds=" << seconds << ", callers=" << callers
+                  << ", server threads=" << serverThreads << std::endl;
+        for (size_t connections : {1, 2, 4, 8}) {
+            run(loopPool, kDefaultPort, connections, callers, seconds);
+        }
+
+        server.stop();
+        serverThread.join();
+        return 0;
+    }
+    catch (const std::exception& ex) {
+        std::cerr << "usage: " << argv[0] << " [seconds] [callers] [server threads]" << std::endl;
+        std::cerr << "error: " << ex.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+}
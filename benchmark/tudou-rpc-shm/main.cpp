@@ -0,0 +1,178 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <deque>
+#include <exception>
+#include <future>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "shm_bench.pb.h"
+#include "spdlog/spdlog.h"
+#include "tudou/rpc/binary/BinaryRpcChannel.h"
+#include "tudou/rpc/binary/BinaryRpcClientLoopPool.h"
+#include "tudou/rpc/binary/BinaryRpcServer.h"
+#include "tudou/tcp/InetAddress.h"
+
+// 同机传输压测：同一个 Ping 服务分别经回环 TCP、Unix 域 socket 与共享内存环形缓冲访问。
+// 每种传输、每种载荷大小先做单请求往返测延迟分位数，再以固定并发深度流水线调用测吞吐。
+// 输出为 CSV，可直接对比 sidecar 式部署下绕开 TCP 协议栈与内核 socket 缓冲的收益。
+
+namespace {
+
+using tudou::rpc::binary::BinaryRpcChannel;
+using tudou::rpc::binary::BinaryRpcClientLoopPool;
+using tudou::rpc::binary::BinaryRpcServer;
+using tudou::rpc::binary::ChannelTransport;
+using tudou::rpc::binary::bench::shm::PingRequest;
+using tudou::rpc::binary::bench::shm::PingResponse;
+using tudou::rpc::binary::bench::shm::PingService;
+
+constexpr uint16_t kDefaultPort = 19095;
+constexpr double kDefaultSeconds = 1.0;
+constexpr size_t kPipelineDepth = 32;
+constexpr const char* kUnixPath = "@tudou-rpc-shm-bench-uds";
+constexpr const char* kShmPath = "@tudou-rpc-shm-bench-shm";
+
+class PingServiceImpl : public PingService {
+public:
+    void Ping(google::protobuf::RpcController*,
+              const PingRequest* request,
+              PingResponse* response,
+              google::protobuf::Closure* done) override {
+        response->set_payload(request->payload());
+        done->Run();
+    }
+};
+
+double parse_seconds(const char* text) {
+    const double value = std::stod(text);
+    if (value <= 0) {
+        throw std::invalid_argument("seconds must be > 0");
+    }
+    return value;
+}
+
+std::chrono::steady_clock::time_point deadline_after(double seconds) {
+    return std::chrono::steady_clock::now()
+        + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(seconds));
+}
+
+// 单请求往返：每次等回包后再发下一次，返回排序后的逐次延迟（微秒）
+std::vector<double> measure_latency(BinaryRpcChannel& channel, const PingRequest& request, double seconds) {
+    const google::protobuf::MethodDescriptor* method = PingService::descriptor()->FindMethodByName("Ping");
+    std::vector<double> samples;
+    const auto end = deadline_after(seconds);
+    while (std::chrono::steady_clock::now() < end) {
+        PingResponse response;
+        const auto start = std::chrono::steady_clock::now();
+        channel.call_async(method, &request, &response).get();
+        samples.push_back(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count());
+    }
+    std::sort(samples.begin(), samples.end());
+    return samples;
+}
+
+// 固定深度流水线，返回每秒完成的调用数
+double measure_throughput(BinaryRpcChannel& channel, const PingRequest& request, double seconds) {
+    const google::protobuf::MethodDescriptor* method = PingService::descriptor()->FindMethodByName("Ping");
+    struct InFlight {
+        std::unique_ptr<PingResponse> response;
+        std::future<void> future;
+    };
+    std::deque<InFlight> inFlight;
+    uint64_t calls = 0;
+
+    const auto start = std::chrono::steady_clock::now();
+    const auto end = deadline_after(seconds);
+    while (std::chrono::steady_clock::now() < end || !inFlight.empty()) {
+        if (std::chrono::steady_clock::now() < end && inFlight.size() < kPipelineDepth) {
+            InFlight call;
+            call.response = std::make_unique<PingResponse>();
+            call.future = channel.call_async(method, &request, call.response.get());
+            inFlight.push_back(std::move(call));
+            continue;
+        }
+        inFlight.front().future.get();
+        inFlight.pop_front();
+        ++calls;
+    }
+    return calls / std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+double percentile(const std::vector<double>& sorted, double fraction) {
+    if (sorted.empty()) {
+        return 0;
+    }
+    const size_t index = std::min(sorted.size() - 1, static_cast<size_t>(fraction * static_cast<double>(sorted.size())));
+    return sorted[index];
+}
+
+void run(const char* name, BinaryRpcChannel& channel, size_t payloadBytes, double seconds) {
+    PingRequest request;
+    request.set_payload(std::string(payloadBytes, 'x'));
+
+    const std::vector<double> latencies = measure_latency(channel, request, seconds / 2);
+    const double callsPerSec = measure_throughput(channel, request, seconds / 2);
+    std::cout << name << "," << payloadBytes << ","
+              << static_cast<uint64_t>(percentile(latencies, 0.50)) << ","
+              << static_cast<uint64_t>(percentile(latencies, 0.99)) << ","
+              << static_cast<uint64_t>(callsPerSec) << ","
+              << static_cast<uint64_t>(callsPerSec * payloadBytes / (1024 * 1024)) << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    try {
+        const double seconds = argc > 1 ? parse_seconds(argv[1]) : kDefaultSeconds;
+        spdlog::set_level(spdlog::level::critical);
+
+        // TCP 服务端同时开放共享内存通道；Unix 域 socket 用另一个服务端实例监听
+        auto service = std::make_shared<PingServiceImpl>();
+        BinaryRpcServer tcpServer("127.0.0.1", kDefaultPort, 1);
+        tcpServer.register_service(service);
+        tcpServer.listen_shared_memory(kShmPath);
+        BinaryRpcServer unixServer(InetAddress::from_unix_path(kUnixPath), 1);
+        unixServer.register_service(service);
+
+        std::thread tcpThread([&tcpServer]() {
+            tcpServer.start();
+        });
+        std::thread unixThread([&unixServer]() {
+            unixServer.start();
+        });
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+        std::cout << "Tudou RPC co-located transport benchmark, seconds=" << seconds << ", depth=" << kPipelineDepth << std::endl;
+        std::cout << "transport,payload_bytes,p50_us,p99_us,pipelined_calls_per_sec,pipelined_payload_mb_per_sec" << std::endl;
+
+        auto loopPool = std::make_shared<BinaryRpcClientLoopPool>(1);
+        {
+            BinaryRpcChannel tcpChannel(loopPool, InetAddress("127.0.0.1", kDefaultPort));
+            BinaryRpcChannel unixChannel(loopPool, InetAddress::from_unix_path(kUnixPath));
+            BinaryRpcChannel shmChannel(loopPool, InetAddress::from_unix_path(kShmPath), ChannelTransport::SharedMemory);
+            for (size_t payloadBytes : {64, 4096, 65536}) {
+                run("tcp", tcpChannel, payloadBytes, seconds);
+                run("unix", unixChannel, payloadBytes, seconds);
+                run("shm", shmChannel, payloadBytes, seconds);
+            }
+        }
+
+        tcpServer.stop();
+        unixServer.stop();
+        tcpThread.join();
+        unixThread.join();
+        return 0;
+    }
+    catch (const std::exception& ex) {
+        std::cerr << "usage: " << argv[0] << " [seconds]" << std::endl;
+        std::cerr << "error: " << ex.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+}
@@ -0,0 +1,50 @@
+// ============================================================================
+// ScopedSigPipeBlock.h
+// 作用域内屏蔽当前线程 SIGPIPE 的 RAII 包装类，供无法携带 MSG_NOSIGNAL 的写调用使用。
+// ============================================================================
+
+#pragma once
+
+#include "base/NonCopyable.h"
+#include <cerrno>
+#include <csignal>
+#include <ctime>
+#include <pthread.h>
+
+// sendfile、OpenSSL Socket BIO 等写路径无法传入 MSG_NOSIGNAL：作用域内屏蔽 SIGPIPE，
+// 离开作用域时同步取走本次写调用挂起的 SIGPIPE 再恢复原屏蔽字，写调用照常返回 EPIPE。
+// 不修改进程级的信号处置，SIGPIPE 如何处理仍由应用决定。
+class ScopedSigPipeBlock : public NonCopyable {
+public:
+    ScopedSigPipeBlock() noexcept {
+        sigemptyset(&sigPipeSet_);
+        sigaddset(&sigPipeSet_, SIGPIPE);
+
+        // 进入前已挂起的 SIGPIPE 不属于本作用域，不屏蔽也不取走，避免吞掉别处产生的信号
+        sigset_t pending;
+        sigemptyset(&pending);
+        if (::sigpending(&pending) == 0 && sigismember(&pending, SIGPIPE) == 1) {
+            return;
+        }
+        blocked_ = ::pthread_sigmask(SIG_BLOCK, &sigPipeSet_, &oldMask_) == 0;
+    }
+
+    ~ScopedSigPipeBlock() {
+        if (!blocked_) {
+            return;
+        }
+
+        // 保留写调用留下的 errno，调用方可能在作用域结束后才检查
+        const int savedErrno = errno;
+        const timespec noWait = { 0, 0 };
+        while (::sigtimedwait(&sigPipeSet_, nullptr, &noWait) < 0 && errno == EINTR) {
+        }
+        ::pthread_sigmask(SIG_SETMASK, &oldMask_, nullptr);
+        errno = savedErrno;
+    }
+
+private:
+    sigset_t sigPipeSet_;
+    sigset_t oldMask_;
+    bool blocked_ = false;
+};
@@ -13,15 +13,19 @@
 
 #include <algorithm>
 #include <cerrno>
+#include <chrono>
 #include <unistd.h>
 
 #include "spdlog/spdlog.h"
+#include "tudou/reactor/EventLoop.h"
 #include "tudou/tcp/TcpServer.h"
 
 namespace {
 
 constexpr char kContentLengthHeader[] = "Content-Length";
 constexpr char kBadRequestMessage[] = "Bad Request";
+constexpr char kServiceUnavailableMessage[] = "Service Unavailable";
+constexpr char kRetryAfterHeader[] = "Retry-After";
 constexpr size_t kTlsFileChunkSize = 16 * 1024;
 
 } // namespace
@@ -34,7 +38,12 @@ HttpServer::HttpServer(std::string ip, uint16_t port, int threadNum) :
     contextsMutex_(),
     router_(),
     tlsMode_(TlsMode::MemoryBio),
-    tlsConfig_(nullptr) {
+    tlsConfig_(nullptr),
+    tlsSessionOptions_(),
+    handshakePool_(nullptr),
+    admission_(),
+    maxPendingOutputBytes_(0),
+    rejectedRequests_(0) {
 
     bind_tcp_callbacks();
 }
@@ -52,9 +61,22 @@ void HttpServer::start() {
         return;
     }
 
+    if (handshakePool_) {
+        handshakePool_->resume_delivery();
+    }
     tcpServer_->start();
 }
 
+void HttpServer::stop() {
+    // IO loop 会在 TcpServer::start() 收尾时析构：先切断加密线程向它们投递握手结果
+    if (handshakePool_) {
+        handshakePool_->pause_delivery();
+    }
+    if (tcpServer_) {
+        tcpServer_->stop();
+    }
+}
+
 void HttpServer::add_route(const std::string& method, const std::string& path, Handler handler) {
     router_.add_route(method, path, std::move(handler));
 }
@@ -84,7 +106,7 @@ void HttpServer::set_method_not_allowed_handler(Handler handler) {
 }
 
 bool HttpServer::set_tls_mode(TlsMode mode) {
-    if (mode == TlsMode::MemoryBio) {
+    if (mode == TlsMode::MemoryBio || mode == TlsMode::BufferBio) {
         tlsMode_ = mode;
         return true;
     }
@@ -92,9 +114,6 @@ bool HttpServer::set_tls_mode(TlsMode mode) {
     if (mode == TlsMode::KernelTls) {
         if (TlsProbe::is_kernel_tls_supported()) {
             tlsMode_ = mode;
-            if (tlsConfig_) {
-                tlsConfig_->restrict_to_tls12();
-            }
             return true;
         }
         spdlog::error("HttpServer: Kernel TLS is not supported on this platform/environment");
@@ -107,38 +126,88 @@ bool HttpServer::set_tls_mode(TlsMode mode) {
 
 bool HttpServer::enable_ssl(const std::string& certFile, const std::string& keyFile) {
     tlsConfig_ = std::make_unique<TlsConfig>();
+    tlsConfig_->configure_sessions(tlsSessionOptions_);
     if (!tlsConfig_->init(certFile, keyFile)) {
         spdlog::critical("HttpServer: Failed to initialize TLS configuration");
         tlsConfig_.reset();
         return false;
     }
 
-    if (tlsMode_ == TlsMode::KernelTls) {
-        tlsConfig_->restrict_to_tls12();
-    }
-
     spdlog::info("HttpServer: SSL enabled (cert={}, key={})", certFile, keyFile);
     return true;
 }
 
+bool HttpServer::add_ssl_certificate(const std::string& serverName, const std::string& certFile, const std::string& keyFile) {
+    if (!tlsConfig_) {
+        spdlog::error("HttpServer: Cannot add certificate for {}, SSL is not enabled", serverName);
+        return false;
+    }
+    return tlsConfig_->add_certificate(serverName, certFile, keyFile);
+}
+
+bool HttpServer::reload_ssl_certificates() {
+    if (!tlsConfig_) {
+        spdlog::error("HttpServer: Cannot reload certificates, SSL is not enabled");
+        return false;
+    }
+    return tlsConfig_->reload();
+}
+
 bool HttpServer::is_ssl_enabled() const {
     return tlsConfig_ && tlsConfig_->is_initialized();
 }
 
+bool HttpServer::set_tls_session_options(const TlsSessionOptions& options) {
+    tlsSessionOptions_ = options;
+    if (!tlsConfig_) {
+        return true;
+    }
+    return tlsConfig_->configure_sessions(options);
+}
+
+TlsSessionStats HttpServer::get_tls_session_stats() const {
+    return tlsConfig_ ? tlsConfig_->get_session_stats() : TlsSessionStats();
+}
+
+void HttpServer::set_tls_handshake_threads(int numThreads) {
+    handshakePool_ = numThreads > 0 ? std::make_unique<TlsHandshakePool>(numThreads) : nullptr;
+}
+
+void HttpServer::set_admission_options(const AdmissionOptions& options) {
+    admission_.configure(options);
+}
+
+void HttpServer::set_max_pending_output_bytes(size_t bytes) {
+    maxPendingOutputBytes_ = bytes;
+}
+
 void HttpServer::on_message(const TcpConnectionPtr& conn) {
-    const std::string receivedData = conn ? conn->receive() : std::string();
-    if (receivedData.empty()) {
+    if (!conn) {
         return;
     }
 
     std::shared_ptr<ConnectionState> state = find_connection_state(conn);
-    if (!state) {
+    if (state && should_offload_handshake(*state)) {
+        offload_tls_handshake(conn, state);
+        return;
+    }
+    if (state && state->tlsMode == TlsMode::BufferBio && state->tlsConnection) {
+        on_buffer_bio_message(conn, *state);
+        return;
+    }
+    if (state && state->tlsMode == TlsMode::KernelTls && state->tlsConnection) {
+        on_kernel_tls_message(conn, *state);
+        return;
+    }
+
+    const std::string receivedData = conn->receive();
+    if (receivedData.empty() || !state) {
         return;
     }
 
     // 1. 提取并归一化明文 payload（处理 TLS 解密与握手数据发回）
     std::string payload;
-    if (state->tlsConnection && !state->isKtlsOffloaded) {
+    if (state->tlsConnection) {
         std::string plaintext;
         std::string outboundCiphertext;
         const TlsConnection::ReadResult tlsResult =
@@ -153,40 +222,218 @@ void HttpServer::on_message(const TcpConnectionPtr& conn) {
             spdlog::error("HttpServer: TLS read failed for fd={}", conn ? conn->get_fd() : -1);
             return;
         }
-
-        // 握手就绪时，若为 kTLS 模式，立刻尝试将 socket 卸载至内核
-        if (state->tlsMode == TlsMode::KernelTls && state->tlsConnection->is_established()) {
-            if (state->tlsConnection->enable_ktls_offload(conn->get_fd())) {
-                state->isKtlsOffloaded = true;
-            } else {
-                spdlog::warn("HttpServer: kTLS offloading failed, falling back to Memory BIO, fd={}", conn ? conn->get_fd() : -1);
-                state->tlsMode = TlsMode::MemoryBio;
-            }
+        if (!flush_pending_tls_responses(conn, *state)) {
+            return;
         }
 
         // 若 TLS 握手尚未完成或收到的是半包，静待下一波 TCP 可读事件
-        if (tlsResult != TlsConnection::ReadResult::Ready && !state->isKtlsOffloaded) {
+        if (tlsResult != TlsConnection::ReadResult::Ready) {
             return;
         }
 
         payload = std::move(plaintext);
     } else {
-        // 安全校验：若服务器启用了 SSL 但并非 kTLS 卸载态，明文连接不应拥有缺失的 TlsConnection
-        if (is_ssl_enabled() && !state->isKtlsOffloaded) {
+        // 安全校验：服务器启用了 SSL 时，连接不应缺失 TlsConnection
+        if (is_ssl_enabled()) {
             spdlog::error("HttpServer: Missing TlsConnection for TLS-enabled server, fd={}", conn ? conn->get_fd() : -1);
             return;
         }
         payload = receivedData;
     }
 
-    // 2. 通过 while 循环逐个解析并消费粘包/管道化发送的 HTTP 请求，解决多请求丢弃漏洞。
+    // 2. 逐个解析并消费粘包/管道化发送的 HTTP 请求
+    process_plaintext(conn, *state, payload.data(), payload.size());
+}
+
+void HttpServer::on_buffer_bio_message(const TcpConnectionPtr& conn, ConnectionState& state) {
+    // 1. OpenSSL 经自定义 BIO 直接消费连接读缓冲，明文原地解密进连接级明文缓冲，握手密文落入密文缓冲
+    Buffer& plaintext = *state.tlsPlaintext;
+    const TlsConnection::ReadResult tlsResult =
+        state.tlsConnection->read_plaintext(*conn->get_read_buffer(), plaintext, *state.tlsCiphertext);
+    flush_tls_ciphertext(conn, *state.tlsCiphertext);
+
+    if (tlsResult == TlsConnection::ReadResult::Error) {
+        spdlog::error("HttpServer: TLS read failed for fd={}", conn->get_fd());
+        // 与 Memory BIO 路径一致：出错时本轮收到的数据整体丢弃，避免残留密文在后续读事件里反复报错
+        Buffer* readBuffer = conn->get_read_buffer();
+        readBuffer->advance_read_index(readBuffer->readable_bytes());
+        return;
+    }
+    if (!flush_pending_tls_responses(conn, state) || tlsResult != TlsConnection::ReadResult::Ready) {
+        return;
+    }
+
+    // 2. 直接在明文缓冲上解析；HttpContext 自身保存跨包状态，本轮明文处理完即可整体丢弃
+    const size_t plaintextLen = plaintext.readable_bytes();
+    process_plaintext(conn, state, plaintext.readable_start_ptr(), plaintextLen);
+    plaintext.advance_read_index(plaintextLen);
+}
+
+void HttpServer::on_kernel_tls_message(const TcpConnectionPtr& conn, ConnectionState& state) {
+    // 1. 连接处于直读模式：OpenSSL 按记录直接读 socket，RX 卸载后内核交付的就是明文
+    Buffer& plaintext = *state.tlsPlaintext;
+    const TlsConnection::ReadResult tlsResult =
+        state.tlsConnection->read_plaintext_from_socket(plaintext, *state.tlsCiphertext);
+    flush_tls_ciphertext(conn, *state.tlsCiphertext);
+    state.isKtlsOffloaded = state.tlsConnection->is_ktls_send_offloaded();
+
+    switch (tlsResult) {
+    case TlsConnection::ReadResult::NeedMoreData:
+        break;
+    case TlsConnection::ReadResult::WantWrite:
+        // 握手报文受阻于 socket 发送缓冲：读事件不会再因此触发，关注可写事件，可写后经消息回调重新推进握手
+        conn->retry_on_writable();
+        return;
+    case TlsConnection::ReadResult::Closed:
+        // close_notify 或 EOF：直读模式下 TcpConnection 不再自行判定 EOF，必须在这里关闭
+        conn->force_close();
+        return;
+    case TlsConnection::ReadResult::Error:
+        spdlog::error("HttpServer: Kernel TLS read failed for fd={}", conn->get_fd());
+        conn->force_close();
+        return;
+    case TlsConnection::ReadResult::Ready:
+        break;
+    }
+    if (!flush_pending_tls_responses(conn, state) || tlsResult != TlsConnection::ReadResult::Ready) {
+        return;
+    }
+
+    // 2. 与 BufferBio 共用明文缓冲上的解析流程
+    const size_t plaintextLen = plaintext.readable_bytes();
+    process_plaintext(conn, state, plaintext.readable_start_ptr(), plaintextLen);
+    plaintext.advance_read_index(plaintextLen);
+}
+
+bool HttpServer::should_offload_handshake(const ConnectionState& state) const {
+    if (!handshakePool_ || !state.tlsConnection
+        || (state.tlsMode != TlsMode::MemoryBio && state.tlsMode != TlsMode::BufferBio)) {
+        return false;
+    }
+    // 先看 in-flight 标记：握手步骤执行期间 tlsConnection 归加密线程所有，不能读它的状态
+    return state.handshakeInFlight || state.tlsConnection->is_handshaking();
+}
+
+void HttpServer::offload_tls_handshake(const TcpConnectionPtr& conn, const std::shared_ptr<ConnectionState>& state) {
+    // 同一连接的握手步骤串行执行：上一步未完成时新密文留在读缓冲，完成后一并处理
+    if (state->handshakeInFlight) {
+        return;
+    }
+    std::string ciphertext = conn->receive();
+    if (ciphertext.empty()) {
+        return;
+    }
+
+    // 任务持有 state 的 shared_ptr：连接中途关闭时 TlsConnection 也要活到加密线程用完为止
+    state->handshakeInFlight = true;
+    std::weak_ptr<TcpConnection> weakConn(conn);
+    auto step = std::make_shared<HandshakeStep>();
+    handshakePool_->submit(
+        [state, step, ciphertext = std::move(ciphertext)]() {
+            *step = run_handshake_step(*state, ciphertext);
+        },
+        conn->get_loop(),
+        [this, weakConn, state, step]() {
+            finish_handshake_step(weakConn, state, *step);
+        });
+}
+
+HttpServer::HandshakeStep HttpServer::run_handshake_step(ConnectionState& state, const std::string& ciphertext) {
+    HandshakeStep step;
+    if (state.tlsMode == TlsMode::MemoryBio) {
+        step.result = state.tlsConnection->read_plaintext(ciphertext, step.plaintext, step.outboundCiphertext);
+        return step;
+    }
+
+    // BufferBio 的自定义 BIO 只认 Buffer：用任务私有的 Buffer 承接，连接的读缓冲与明文/密文缓冲仍只由 IO 线程访问
+    Buffer input;
+    Buffer plaintext;
+    Buffer outbound;
+    input.write_to_buffer(ciphertext.data(), ciphertext.size());
+    step.result = state.tlsConnection->read_plaintext(input, plaintext, outbound);
+    step.outboundCiphertext = outbound.read_from_buffer();
+    step.plaintext = plaintext.read_from_buffer();
+    step.unconsumedCiphertext = input.read_from_buffer();
+    return step;
+}
+
+void HttpServer::finish_handshake_step(const std::weak_ptr<TcpConnection>& weakConn,
+    const std::shared_ptr<ConnectionState>& state,
+    HandshakeStep& step) {
+    state->handshakeInFlight = false;
+    TcpConnectionPtr conn = weakConn.lock();
+    if (!conn) {
+        return;
+    }
+    {
+        // 握手期间连接已关闭（状态已被 on_close 移除）时不再发送任何数据
+        std::lock_guard<std::mutex> lock(contextsMutex_);
+        const auto it = connectionStates_.find(conn.get());
+        if (it == connectionStates_.end() || it->second != state) {
+            return;
+        }
+    }
+
+    if (!step.outboundCiphertext.empty()) {
+        conn->send(step.outboundCiphertext);
+    }
+    if (step.result == TlsConnection::ReadResult::Error) {
+        spdlog::error("HttpServer: Offloaded TLS handshake failed for fd={}", conn->get_fd());
+        conn->force_close();
+        return;
+    }
+
+    // 未凑成完整记录的密文必须排在握手期间新到达的密文之前
+    if (!step.unconsumedCiphertext.empty()) {
+        const std::string arrived = conn->receive();
+        Buffer* readBuffer = conn->get_read_buffer();
+        readBuffer->write_to_buffer(step.unconsumedCiphertext);
+        readBuffer->write_to_buffer(arrived);
+    }
+
+    if (!flush_pending_tls_responses(conn, *state)) {
+        return;
+    }
+    if (step.result == TlsConnection::ReadResult::Ready && !step.plaintext.empty()) {
+        process_plaintext(conn, *state, step.plaintext.data(), step.plaintext.size());
+        if (!find_connection_state(conn)) {
+            return;
+        }
+    }
+
+    // 握手期间到达的密文：仍在握手则继续投递，已完成则回到常规读路径
+    if (conn->get_read_buffer()->readable_bytes() > 0) {
+        on_message(conn);
+    }
+}
+
+bool HttpServer::flush_pending_tls_responses(const TcpConnectionPtr& conn, ConnectionState& state) {
+    if (state.pendingTlsResponses.empty() || !state.tlsConnection->is_established()) {
+        return true;
+    }
+
+    // 先整体换出：发送过程中若再有响应产生，也不会与正在遍历的队列交错
+    std::vector<HttpResponse> pending;
+    pending.swap(state.pendingTlsResponses);
+    for (HttpResponse& resp : pending) {
+        const bool closeConnection = resp.get_close_connection();
+        send_http_response(conn, state, std::move(resp));
+        if (closeConnection) {
+            return false; // 连接已 force_close，state 可能已被 on_close 释放
+        }
+    }
+    return true;
+}
+
+void HttpServer::process_plaintext(const TcpConnectionPtr& conn, ConnectionState& state, const char* data, size_t len) {
+    // 通过 while 循环逐个解析并消费粘包/管道化发送的 HTTP 请求，解决多请求丢弃漏洞。
     size_t consumed = 0;
-    while (consumed < payload.size()) {
-        const char* currentData = payload.data() + consumed;
-        size_t currentLen = payload.size() - consumed;
+    while (consumed < len) {
+        const char* currentData = data + consumed;
+        size_t currentLen = len - consumed;
 
-        HttpContext::ParseResult result = state->httpContext.parse(currentData, currentLen);
-        size_t lastConsumed = state->httpContext.get_consumed_bytes();
+        HttpContext::ParseResult result = state.httpContext.parse(currentData, currentLen);
+        size_t lastConsumed = state.httpContext.get_consumed_bytes();
         consumed += lastConsumed;
 
         switch (result) {
@@ -195,11 +442,24 @@ void HttpServer::on_message(const TcpConnectionPtr& conn) {
             break;
         case HttpContext::ParseResult::Rejected:
             // 直接就地回复 400 Bad Request，并重置当前连接的 HTTP 上下文
-            send_http_response(conn, *state, HttpResponse::plain_text(400, kBadRequestMessage, kBadRequestMessage));
-            state->httpContext.reset();
+            send_http_response(conn, state, HttpResponse::plain_text(400, kBadRequestMessage, kBadRequestMessage));
+            state.httpContext.reset();
             return;
-        case HttpContext::ParseResult::Complete:
-            reply_complete_request(conn, *state);
+        case HttpContext::ParseResult::Complete: {
+            bool closeConnection = false;
+            bool admitted = false;
+            if (!admit_request(conn, closeConnection, admitted)) {
+                reject_overloaded(conn, state, closeConnection);
+                if (closeConnection) {
+                    return;
+                }
+                break;
+            }
+
+            reply_complete_request(conn, state);
+            if (admitted) {
+                admission_.release();
+            }
 
             // 安全护栏：若响应中设置了 Connection: close 导致连接被 force_close() 关闭，
             // 对应的 ConnectionState 已经在 on_close 里被从 HttpServer 清理，必须退出防止野指针崩溃。
@@ -208,6 +468,7 @@ void HttpServer::on_message(const TcpConnectionPtr& conn) {
             }
             break;
         }
+        }
 
         // 防死循环保护：如果未消费任何字节且未完成，直接跳出
         if (lastConsumed == 0 && result == HttpContext::ParseResult::NeedMoreData) {
@@ -237,7 +498,12 @@ void HttpServer::on_connect(const TcpConnectionPtr& conn) {
         if (connectionStates_.find(conn.get()) != connectionStates_.end()) {
             spdlog::warn("HttpServer: ConnectionState already exists for fd={}, overwriting.", conn ? conn->get_fd() : -1);
         }
-        connectionStates_[conn.get()] = std::move(state);
+        connectionStates_[conn.get()] = state;
+    }
+
+    // KernelTls 由 OpenSSL 直接按记录读 socket，连接不再预读到自身读缓冲
+    if (conn && state->tlsMode == TlsMode::KernelTls && state->tlsConnection) {
+        conn->set_direct_read(true);
     }
 
     spdlog::debug("HttpServer: New connection established, fd={}", conn ? conn->get_fd() : -1);
@@ -258,7 +524,11 @@ std::shared_ptr<HttpServer::ConnectionState> HttpServer::create_connection_state
 
     spdlog::debug("HttpServer: TlsConnection created for fd={}", conn ? conn->get_fd() : -1);
     state->tlsMode = tlsMode_;
-    state->tlsConnection = std::make_unique<TlsConnection>(ssl);
+    state->tlsConnection = std::make_unique<TlsConnection>(ssl, tlsMode_, conn ? conn->get_fd() : -1);
+    if (tlsMode_ == TlsMode::BufferBio || tlsMode_ == TlsMode::KernelTls) {
+        state->tlsPlaintext = std::make_unique<Buffer>();
+        state->tlsCiphertext = std::make_unique<Buffer>();
+    }
     return state;
 }
 
@@ -278,6 +548,32 @@ std::shared_ptr<HttpServer::ConnectionState> HttpServer::find_connection_state(c
     return it->second;
 }
 
+bool HttpServer::admit_request(const TcpConnectionPtr& conn, bool& closeConnection, bool& admitted) {
+    // 1. 对端迟迟不读导致本连接输出积压：继续执行只会让写缓冲无界增长，拒绝后断开
+    if (maxPendingOutputBytes_ > 0 && conn->get_write_buffer_size() > maxPendingOutputBytes_) {
+        closeConnection = true;
+        return false;
+    }
+
+    // 2. 服务端整体过载：以本轮 poll 返回到现在的时间作为排队时延交给准入控制判定；admitted 记录是否实际占用了名额
+    if (admission_.is_enabled()
+        && !admission_.try_acquire(std::chrono::steady_clock::now() - conn->get_loop()->get_poll_return_time(), &admitted)) {
+        return false;
+    }
+    return true;
+}
+
+void HttpServer::reject_overloaded(const TcpConnectionPtr& conn, ConnectionState& state, bool closeConnection) {
+    rejectedRequests_.fetch_add(1, std::memory_order_relaxed);
+
+    // 全局过载只拒绝本次请求并保留连接，避免客户端重连反而加重负载
+    HttpResponse resp = HttpResponse::plain_text(503, kServiceUnavailableMessage, kServiceUnavailableMessage);
+    resp.set_header(kRetryAfterHeader, "1");
+    resp.set_close_connection(closeConnection);
+    send_http_response(conn, state, std::move(resp));
+    state.httpContext.reset();
+}
+
 void HttpServer::reply_complete_request(const TcpConnectionPtr& conn,
     ConnectionState& state) {
     send_http_response(conn, state, build_http_response(state.httpContext.get_request()));
@@ -292,7 +588,7 @@ HttpResponse HttpServer::build_http_response(const HttpRequest& req) const {
 }
 
 void HttpServer::send_http_response(const TcpConnectionPtr& conn,
-    const ConnectionState& state,
+    ConnectionState& state,
     HttpResponse resp) {
 
     // 1. Content-Length 是网络契约的一部分，统一在基础设施层补齐，避免业务回调重复关注协议细节。
@@ -301,6 +597,12 @@ void HttpServer::send_http_response(const TcpConnectionPtr& conn,
         resp.set_header(kContentLengthHeader, std::to_string(bodySize));
     }
 
+    // TLS 握手尚未完成时既无法加密，kTLS 也还不知道是否卸载：先排队，握手完成后按原顺序发出，而不是丢弃
+    if (state.tlsConnection && (state.handshakeInFlight || state.tlsConnection->is_handshaking())) {
+        state.pendingTlsResponses.push_back(std::move(resp));
+        return;
+    }
+
     // 2. 序列化 DTO 状态转换为完整协议报文
     std::string response = resp.package_to_string();
 
@@ -319,15 +621,20 @@ void HttpServer::send_http_response(const TcpConnectionPtr& conn,
             return;
         }
         break;
+    case TlsMode::BufferBio:
+        if (!send_buffer_bio_response(conn, state, resp, response)) {
+            spdlog::error("HttpServer: Buffer BIO TLS response failed, fd={}", conn ? conn->get_fd() : -1);
+            return;
+        }
+        break;
     case TlsMode::KernelTls:
         if (state.isKtlsOffloaded) {
             // kTLS 已经在内核层接管了加密，我们可以直接以明文方式发送响应报文和文件
             send_plain_response(conn, resp, response);
-        } else {
-            if (!send_kernel_tls_response(conn, resp, response)) {
-                spdlog::error("HttpServer: Kernel TLS response failed, fd={}", conn ? conn->get_fd() : -1);
-                return;
-            }
+        } else if (!send_buffer_bio_response(conn, state, resp, response)) {
+            // 内核未接管发送方向：用户态加密进密文 Buffer 后写出，与 BufferBio 发送路径相同
+            spdlog::error("HttpServer: Kernel TLS fallback response failed, fd={}", conn ? conn->get_fd() : -1);
+            return;
         }
         break;
     }
@@ -419,14 +726,68 @@ bool HttpServer::send_memory_bio_file_response(const TcpConnectionPtr& conn,
     return true;
 }
 
-bool HttpServer::send_kernel_tls_response(const TcpConnectionPtr& conn,
+bool HttpServer::send_buffer_bio_response(const TcpConnectionPtr& conn,
+    const ConnectionState& state,
     const HttpResponse& resp,
     const std::string& responseHead) {
-    (void)conn;
-    (void)resp;
-    (void)responseHead;
-    spdlog::error("HttpServer: Kernel TLS is not supported yet");
-    return false;
+    if (!send_buffer_bio_plaintext(conn, state, responseHead.data(), responseHead.size())) {
+        return false;
+    }
+    if (!resp.has_file_body()) {
+        return true;
+    }
+
+    // 文件分块 pread 到明文缓冲的可写区后原地加密，不再为每块构造 string
+    const HttpResponse::FileBody& fileBody = resp.get_file_body();
+    Buffer chunk(kTlsFileChunkSize);
+    size_t offset = fileBody.offset;
+    size_t remaining = fileBody.size;
+
+    while (remaining > 0) {
+        const size_t want = std::min(kTlsFileChunkSize, remaining);
+        chunk.ensure_writable_bytes(want);
+        const ssize_t n = ::pread(fileBody.file->fd(), chunk.writable_start_ptr(), want, static_cast<off_t>(offset));
+        if (n <= 0) {
+            spdlog::error("HttpServer: failed to read Buffer BIO TLS file body, fd={}, errno={}", fileBody.file->fd(), errno);
+            return false;
+        }
+
+        chunk.advance_write_index(static_cast<size_t>(n));
+        if (!send_buffer_bio_plaintext(conn, state, chunk.readable_start_ptr(), chunk.readable_bytes())) {
+            return false;
+        }
+        chunk.advance_read_index(chunk.readable_bytes());
+
+        offset += static_cast<size_t>(n);
+        remaining -= static_cast<size_t>(n);
+    }
+
+    return true;
+}
+
+bool HttpServer::send_buffer_bio_plaintext(const TcpConnectionPtr& conn,
+    const ConnectionState& state,
+    const char* data,
+    size_t len) {
+    if (!conn) {
+        return false;
+    }
+
+    if (!state.tlsConnection->write_plaintext(data, len, *state.tlsCiphertext)) {
+        return false;
+    }
+    flush_tls_ciphertext(conn, *state.tlsCiphertext);
+    return true;
+}
+
+void HttpServer::flush_tls_ciphertext(const TcpConnectionPtr& conn, Buffer& ciphertext) {
+    // 密文直接从 Buffer 内存写出，未写完的部分由 TcpConnection 自己的写缓冲接管
+    const size_t len = ciphertext.readable_bytes();
+    if (len == 0) {
+        return;
+    }
+    conn->send(ciphertext.readable_start_ptr(), len);
+    ciphertext.advance_read_index(len);
 }
 
 void HttpServer::remove_connection_state(const TcpConnectionPtr& conn) {
@@ -9,18 +9,28 @@
 //     ├── HttpServer(ip, port, threadNum)        # [公有] 构造服务器并绑定底层 TcpServer 回调
 //     │   └── bind_tcp_callbacks()               # [私有] 绑定连接/消息/关闭事件
 //     │       ├── on_connect(conn)               # [私有] 创建并登记连接级状态
-//     │       │   └── create_connection_state(conn) const # [私有] 创建 HttpContext 与可选 TLS 状态
+//     │       │   └── create_connection_state(conn) const # [私有] 创建 HttpContext 与可选 TLS 状态；KernelTls 连接切为直读
 //     │       ├── on_message(conn)               # [私有] 处理一次消息到达，并按需从 conn 读取数据
 //     │       │   ├── find_connection_state(conn) # [私有] 查找连接级状态
+//     │       │   ├── offload_tls_handshake(conn, state) # [私有] 启用加密线程池时：握手步骤投递到池中执行，期间到达的密文留在读缓冲
+//     │       │   │   ├── run_handshake_step(state, ciphertext) # [私有] 加密线程：喂入密文推进握手，收集待发密文与明文
+//     │       │   │   └── finish_handshake_step(weakConn, state, step) # [私有] 回到 IO 线程：发送握手密文、处理明文与积压密文
+//     │       │   ├── on_buffer_bio_message(conn, state) # [私有] BufferBio：直接解密连接读缓冲，不经 receive()
+//     │       │   │   └── flush_tls_ciphertext(conn, ciphertext) # [私有] 从密文 Buffer 直接写出
+//     │       │   ├── on_kernel_tls_message(conn, state) # [私有] KernelTls：OpenSSL 直读 socket，Closed/Error 时关闭连接
+//     │       │   ├── flush_pending_tls_responses(conn, state) # [私有] 握手完成后按序补发握手期间排队的响应
+//     │       │   ├── process_plaintext(conn, state, data, len) # [私有] 逐个解析粘包/管道化请求并回复
 //     │       │   ├── read_request_payload(conn, data, state, payload) # [私有] 归一化本次 HTTP 明文
 //     │       │   ├── log_incomplete_request(conn) # [私有] 记录等待更多数据
 //     │       │   ├── reject_bad_request(conn, state) # [私有] 返回 400 并重置上下文
 //     │       │   │   ├── build_bad_request_response()   # [私有] 构建 400 响应
 //     │       │   │   ├── send_http_response(conn, state, resp) # [私有] 发送响应
-//     │       │   │   │   ├── finalize_http_response(resp) # [私有] 补齐协议头
+//     │       │   │   │   ├── finalize_http_response(resp) # [私有] 补齐协议头；TLS 握手未完成时入队等待
 //     │       │   │   │   ├── serialize_response(resp)   # [私有] 序列化响应
-//     │       │   │   │   └── send_response(conn, state, data) # [私有] 发送明文或 TLS 密文
+//     │       │   │   │   └── send_response(conn, state, data) # [私有] 发送明文或 TLS 密文；kTLS 已卸载时文件走 sendfile
 //     │       │   │   └── HttpContext::reset()    # [私有] 清空本连接当前解析状态
+//     │       │   ├── admit_request(conn)     # [私有] 按连接输出积压与服务端准入控制决定是否执行
+//     │       │   ├── reject_overloaded(conn, state, closeConnection) # [私有] 返回 503 并重置上下文
 //     │       │   └── reply_complete_request(conn, state) # [私有] 路由分发并发送响应
 //     │       │       ├── build_http_response(req)       # [私有] 交给内部 Router 填充响应
 //     │       │       ├── send_http_response(conn, state, resp) # [私有] 发送响应
@@ -34,6 +44,7 @@
 //     ├── operator=(copy)                        # [公有] 删除拷贝赋值
 //     ├── ~HttpServer()                          # [公有] 默认析构
 //     ├── start()                                # [公有] 启动底层 TCP 服务
+//     ├── stop()                                 # [公有] 线程安全：停止投递握手结果，请求底层 TCP 服务退出主循环
 //     ├── add_route(method, path, handler)       # [公有] 注册 method + path 精确路由
 //     ├── add_get_route(path, handler)           # [公有] 注册 GET 精确路由
 //     ├── add_post_route(path, handler)          # [公有] 注册 POST 精确路由
@@ -41,24 +52,37 @@
 //     ├── add_prefix_route(prefix, handler)      # [公有] 注册前缀兜底路由
 //     ├── set_not_found_handler(handler)         # [公有] 覆盖默认 404 响应
 //     ├── set_method_not_allowed_handler(handler) # [公有] 覆盖默认 405 响应
+//     ├── set_tls_mode(mode)                     # [公有] 选择 HTTPS 连接的 TLS 传输模式
 //     ├── enable_ssl(certFile, keyFile)          # [公有] 启用 HTTPS 支持
+//     ├── add_ssl_certificate(name, cert, key)   # [公有] 线程安全：按 SNI 主机名追加证书
+//     ├── reload_ssl_certificates()              # [公有] 线程安全：热加载全部证书，新连接立即使用
 //     ├── is_ssl_enabled() const                 # [公有] 判断 TLS 是否已启用
+//     ├── set_tls_session_options(options)       # [公有] 配置会话票据密钥轮换与共享会话缓存
+//     ├── get_tls_session_stats() const          # [公有] 握手数、会话复用数与票据密钥轮换次数
+//     ├── set_tls_handshake_threads(numThreads)  # [公有] 在 start 前配置 TLS 握手加密线程数，0 表示在 IO 线程握手
+//     ├── set_admission_options(options)         # [公有] 配置服务端级并发上限与自适应收缩，运行期也可调整
+//     ├── set_max_pending_output_bytes(bytes)    # [公有] 在 start 前配置单连接允许积压的未发送字节数
+//     ├── get_rejected_request_count() const     # [公有] 因过载被 503 拒绝的请求数
 // ============================================================================
 
 #pragma once
+#include <atomic>
 #include <cstdint>
 #include <functional>
 #include <memory>
 #include <mutex>
 #include <string>
 #include <unordered_map>
+#include <vector>
 
 #include "tudou/tcp/TcpServer.h"
+#include "tudou/tcp/AdmissionController.h"
 #include "tudou/http/HttpRequest.h"
 #include "tudou/http/HttpResponse.h"
 #include "tudou/http/HttpContext.h"
 #include "tudou/http/TlsConfig.h"
 #include "tudou/http/TlsConnection.h"
+#include "tudou/http/TlsHandshakePool.h"
 #include "tudou/http/TlsMode.h"
 #include "tudou/http/HttpRouter.h"
 
@@ -72,6 +96,7 @@ public:
     ~HttpServer() = default;
 
     void start();
+    void stop(); // 线程安全；start() 尚未进入主循环时调用会被忽略。
     void add_route(const std::string& method, const std::string& path, Handler handler);
     void add_get_route(const std::string& path, Handler handler);
     void add_post_route(const std::string& path, Handler handler);
@@ -79,31 +104,64 @@ public:
     void add_prefix_route(const std::string& prefix, Handler handler);
     void set_not_found_handler(Handler handler);
     void set_method_not_allowed_handler(Handler handler);
-    bool set_tls_mode(TlsMode mode); // 目前仅支持 MemoryBio；KernelTls 后续接入。
+    bool set_tls_mode(TlsMode mode); // 支持 MemoryBio、BufferBio；KernelTls 需内核支持。
     bool enable_ssl(const std::string& certFile, const std::string& keyFile); // 在 start 前启用 HTTPS。
+    bool add_ssl_certificate(const std::string& serverName, const std::string& certFile, const std::string& keyFile); // 需先 enable_ssl；运行中可调用。
+    bool reload_ssl_certificates(); // 运行中可调用（如收到 SIGHUP 后）；失败时保留原证书。
 
     bool is_ssl_enabled() const;
+    bool set_tls_session_options(const TlsSessionOptions& options); // 在 start 前配置；enable_ssl 前后调用均可。
+    TlsSessionStats get_tls_session_stats() const; // 未启用 TLS 时全为 0。
+    void set_tls_handshake_threads(int numThreads); // 在 start 前配置；仅作用于 MemoryBio/BufferBio，KernelTls 握手直读 socket，仍在 IO 线程执行。
+    uint64_t get_offloaded_handshake_steps() const { return handshakePool_ ? handshakePool_->get_completed_count() : 0; }
+
+    void set_admission_options(const AdmissionOptions& options); // 运行期也可调整；超限请求立即返回 503。
+    void set_max_pending_output_bytes(size_t bytes); // 在 start 前配置；0 表示不限制。
+    uint64_t get_rejected_request_count() const { return rejectedRequests_.load(std::memory_order_relaxed); }
 
 private:
     struct ConnectionState {
         HttpContext httpContext;                                                                // 单连接 HTTP 解析状态。
         TlsMode tlsMode = TlsMode::None;                                                        // 当前连接的传输加密模式。
         std::unique_ptr<TlsConnection> tlsConnection;                                           // HTTPS 连接独有的 TLS 状态。
-        bool isKtlsOffloaded = false;                                                           // 当前连接是否已成功卸载至 kTLS。
+        bool isKtlsOffloaded = false;                                                           // 发送方向是否已卸载至 kTLS，为 true 时明文直写 socket。
+        std::unique_ptr<Buffer> tlsPlaintext;                                                   // BufferBio/KernelTls：解密后的明文，跨读事件复用。
+        std::unique_ptr<Buffer> tlsCiphertext;                                                  // BufferBio/KernelTls：待发送密文，写出后立即清空复用。
+        std::vector<HttpResponse> pendingTlsResponses;                                          // TLS 握手完成前产生的响应，握手完成后按序发出。
+        bool handshakeInFlight = false;                                                         // 握手步骤正在加密线程执行，期间 IO 线程不得触碰 tlsConnection。
+    };
+
+    struct HandshakeStep {
+        TlsConnection::ReadResult result = TlsConnection::ReadResult::NeedMoreData;
+        std::string outboundCiphertext;                                                         // 握手产生的待发送密文。
+        std::string plaintext;                                                                  // 握手完成时随 Finished 一并到达的应用数据。
+        std::string unconsumedCiphertext;                                                       // BufferBio：未凑成完整记录的密文，需放回读缓冲。
     };
 
     void bind_tcp_callbacks();
     void on_connect(const TcpConnectionPtr& conn);
     void on_message(const TcpConnectionPtr& conn);
+    void on_buffer_bio_message(const TcpConnectionPtr& conn, ConnectionState& state);
+    void on_kernel_tls_message(const TcpConnectionPtr& conn, ConnectionState& state);
+    bool should_offload_handshake(const ConnectionState& state) const;
+    void offload_tls_handshake(const TcpConnectionPtr& conn, const std::shared_ptr<ConnectionState>& state);
+    static HandshakeStep run_handshake_step(ConnectionState& state, const std::string& ciphertext);
+    void finish_handshake_step(const std::weak_ptr<TcpConnection>& weakConn,
+        const std::shared_ptr<ConnectionState>& state,
+        HandshakeStep& step);
+    bool flush_pending_tls_responses(const TcpConnectionPtr& conn, ConnectionState& state); // 返回 false 表示连接已被关闭。
+    void process_plaintext(const TcpConnectionPtr& conn, ConnectionState& state, const char* data, size_t len);
     std::shared_ptr<ConnectionState> create_connection_state(const TcpConnectionPtr& conn) const;
     void on_close(const TcpConnectionPtr& conn);
 
     std::shared_ptr<ConnectionState> find_connection_state(const TcpConnectionPtr& conn);
+    bool admit_request(const TcpConnectionPtr& conn, bool& closeConnection, bool& admitted);
+    void reject_overloaded(const TcpConnectionPtr& conn, ConnectionState& state, bool closeConnection);
     void reply_complete_request(const TcpConnectionPtr& conn, ConnectionState& state);
     HttpResponse build_http_response(const HttpRequest& req) const; // 调用内部路由器构建响应。
 
     void send_http_response(const TcpConnectionPtr& conn,
-        const ConnectionState& state,
+        ConnectionState& state,
         HttpResponse resp);
     TlsMode tls_mode_of(const ConnectionState& state) const;
     void send_plain_response(const TcpConnectionPtr& conn,
@@ -120,9 +178,15 @@ private:
         TlsConnection& tlsConnection,
         const HttpResponse& resp,
         const std::string& responseHead);
-    bool send_kernel_tls_response(const TcpConnectionPtr& conn,
+    bool send_buffer_bio_response(const TcpConnectionPtr& conn,
+        const ConnectionState& state,
         const HttpResponse& resp,
         const std::string& responseHead);
+    bool send_buffer_bio_plaintext(const TcpConnectionPtr& conn,
+        const ConnectionState& state,
+        const char* data,
+        size_t len);
+    void flush_tls_ciphertext(const TcpConnectionPtr& conn, Buffer& ciphertext);
 
     void remove_connection_state(const TcpConnectionPtr& conn);
 
@@ -138,4 +202,10 @@ private:
 
     TlsMode tlsMode_;                                                                           // HTTPS 连接使用的 TLS 传输模式。
     std::unique_ptr<TlsConfig> tlsConfig_;                                                      // 全局 TLS 配置，持有证书与私钥。
+    TlsSessionOptions tlsSessionOptions_;                                                       // 会话复用配置，enable_ssl 时应用到新的 TlsConfig。
+    std::unique_ptr<TlsHandshakePool> handshakePool_;                                           // TLS 握手加密线程池，为空时握手在 IO 线程执行；先于 tcpServer_ 析构。
+
+    AdmissionController admission_;                                                             // 服务端级准入控制，全部 IO 线程共享。
+    size_t maxPendingOutputBytes_;                                                              // 单连接允许积压的未发送字节数，0 表示不限制。
+    std::atomic<uint64_t> rejectedRequests_;                                                    // 因过载被 503 拒绝的请求数。
 };
@@ -1,79 +1,506 @@
 #include "tudou/http/TlsConfig.h"
 #include "spdlog/spdlog.h"
 
+#include <openssl/core_names.h>
+#include <openssl/evp.h>
+#include <openssl/rand.h>
 #include <openssl/ssl.h>
 
-TlsConfig::TlsConfig() : ctx_(nullptr) {}
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <ctime>
+#include <iterator>
+
+namespace {
+
+constexpr unsigned char kSessionIdContext[] = "tudou-http";
+
+std::string to_lower(std::string text) {
+    std::transform(text.begin(), text.end(), text.begin(), [](unsigned char c) {
+        return static_cast<char>(std::tolower(c));
+        });
+    return text;
+}
+
+} // namespace
+
+TlsConfig::ContextSnapshot::~ContextSnapshot() {
+    if (defaultCtx) {
+        SSL_CTX_free(defaultCtx);
+    }
+    for (auto& entry : sniContexts) {
+        SSL_CTX_free(entry.second);
+    }
+}
+
+SSL_CTX* TlsConfig::ContextSnapshot::select(const char* serverName) const {
+    if (!serverName || sniContexts.empty()) {
+        return defaultCtx;
+    }
+
+    // 先精确匹配，再匹配一级通配符（*.example.com 只覆盖 a.example.com，不含 example.com 与 a.b.example.com）
+    const std::string name = to_lower(serverName);
+    for (const auto& entry : sniContexts) {
+        if (entry.first == name) {
+            return entry.second;
+        }
+    }
+    const size_t dot = name.find('.');
+    if (dot != std::string::npos && dot > 0) {
+        const std::string wildcard = "*" + name.substr(dot);
+        for (const auto& entry : sniContexts) {
+            if (entry.first == wildcard) {
+                return entry.second;
+            }
+        }
+    }
+    return defaultCtx;
+}
+
+TlsConfig::TlsConfig()
+    : writerMutex_()
+    , certificates_()
+    , current_(nullptr)
+    , sessionOptions_()
+    , ticketKeyMutex_()
+    , ticketKeys_()
+    , sessionCacheMutex_()
+    , sessions_()
+    , sessionIndex_()
+    , handshakes_(0)
+    , resumed_(0)
+    , rotations_(0) {
+}
 
 TlsConfig::~TlsConfig() {
-    reset_context();
+    // 析构时已没有并发读者，当前快照随 current_ 一同释放
+    for (auto& entry : sessions_) {
+        SSL_SESSION_free(entry.second);
+    }
 }
 
 bool TlsConfig::init(const std::string& certFile, const std::string& keyFile) {
     // init 是唯一编排入口；每次重建都先清空旧上下文，避免失败重试时遗留旧状态。
-    reset_context();
+    std::lock_guard<std::mutex> lock(writerMutex_);
+    certificates_.clear();
+    publish_locked(nullptr);
 
-    ctx_ = SSL_CTX_new(TLS_server_method());
-    if (!ctx_) {
-        spdlog::critical("TlsConfig: Failed to create SSL_CTX");
+    std::shared_ptr<ContextSnapshot> snapshot = std::make_shared<ContextSnapshot>();
+    snapshot->defaultCtx = create_context(certFile, keyFile);
+    if (!snapshot->defaultCtx) {
         return false;
     }
 
-    // TLS 1.2 是当前服务端的最低安全线，统一在上下文层配置。
-    SSL_CTX_set_min_proto_version(ctx_, TLS1_2_VERSION);
-
-#ifdef SSL_OP_ENABLE_KTLS
-    SSL_CTX_set_options(ctx_, SSL_OP_ENABLE_KTLS);
-#endif
+    certificates_.push_back(CertificateFiles{ std::string(), certFile, keyFile });
+    publish_locked(std::move(snapshot));
+    spdlog::info("TlsConfig: TLS configuration initialized successfully (cert={}, key={})", certFile, keyFile);
+    return true;
+}
 
-    if (SSL_CTX_use_certificate_file(ctx_, certFile.c_str(), SSL_FILETYPE_PEM) <= 0) {
-        spdlog::critical("TlsConfig: Failed to load certificate file: {}", certFile);
-        reset_context();
+bool TlsConfig::add_certificate(const std::string& serverName, const std::string& certFile, const std::string& keyFile) {
+    std::lock_guard<std::mutex> lock(writerMutex_);
+    const std::shared_ptr<const ContextSnapshot> current = std::atomic_load(&current_);
+    if (!current) {
+        spdlog::error("TlsConfig: Cannot add certificate for {}, default certificate not initialized", serverName);
+        return false;
+    }
+    const std::string name = to_lower(serverName);
+    if (name.empty()) {
+        spdlog::error("TlsConfig: SNI certificate requires a server name");
         return false;
     }
 
-    if (SSL_CTX_use_PrivateKey_file(ctx_, keyFile.c_str(), SSL_FILETYPE_PEM) <= 0) {
-        spdlog::critical("TlsConfig: Failed to load private key file: {}", keyFile);
-        reset_context();
+    SSL_CTX* ctx = create_context(certFile, keyFile);
+    if (!ctx) {
         return false;
     }
 
-    if (!SSL_CTX_check_private_key(ctx_)) {
-        spdlog::critical("TlsConfig: Private key does not match certificate");
-        reset_context();
+    // 新快照与旧快照共享其余上下文（各自持有一份引用），只有新增或替换的证书需要新建
+    std::shared_ptr<ContextSnapshot> snapshot = std::make_shared<ContextSnapshot>();
+    SSL_CTX_up_ref(current->defaultCtx);
+    snapshot->defaultCtx = current->defaultCtx;
+    for (const auto& entry : current->sniContexts) {
+        if (entry.first != name) {
+            SSL_CTX_up_ref(entry.second);
+            snapshot->sniContexts.push_back(entry);
+        }
+    }
+    snapshot->sniContexts.emplace_back(name, ctx);
+
+    certificates_.erase(std::remove_if(certificates_.begin(), certificates_.end(), [&name](const CertificateFiles& files) {
+        return files.serverName == name;
+        }), certificates_.end());
+    certificates_.push_back(CertificateFiles{ name, certFile, keyFile });
+    publish_locked(std::move(snapshot));
+    spdlog::info("TlsConfig: SNI certificate added for {} (cert={})", name, certFile);
+    return true;
+}
+
+bool TlsConfig::reload() {
+    std::lock_guard<std::mutex> lock(writerMutex_);
+    if (certificates_.empty()) {
+        spdlog::error("TlsConfig: Cannot reload, TLS configuration not initialized");
         return false;
     }
 
-    spdlog::info("TlsConfig: TLS configuration initialized successfully (cert={}, key={})", certFile, keyFile);
+    // 全部证书重新加载成功才发布：任何一张失败都保留旧快照，服务不受影响
+    std::shared_ptr<ContextSnapshot> snapshot = std::make_shared<ContextSnapshot>();
+    for (const CertificateFiles& files : certificates_) {
+        SSL_CTX* ctx = create_context(files.certFile, files.keyFile);
+        if (!ctx) {
+            spdlog::error("TlsConfig: Certificate reload failed, keeping previous certificates");
+            return false;
+        }
+        if (files.serverName.empty()) {
+            snapshot->defaultCtx = ctx;
+        } else {
+            snapshot->sniContexts.emplace_back(files.serverName, ctx);
+        }
+    }
+
+    publish_locked(std::move(snapshot));
+    spdlog::info("TlsConfig: Reloaded {} certificate(s)", certificates_.size());
     return true;
 }
 
 SSL* TlsConfig::create_ssl() const {
-    if (!ctx_) {
+    // 读侧不经写者锁：持有当前快照的一份引用直到 SSL_new 持有默认上下文的引用，之后即使快照被替换也不受影响
+    const std::shared_ptr<const ContextSnapshot> snapshot = std::atomic_load(&current_);
+    if (!snapshot) {
         spdlog::error("TlsConfig: Cannot create SSL, context not initialized");
         return nullptr;
     }
 
     // 每个连接都从共享 SSL_CTX 派生一个独立 SSL 对象，后续握手和加解密状态都放在连接侧维护。
-    SSL* ssl = SSL_new(ctx_);
+    SSL* ssl = SSL_new(snapshot->defaultCtx);
     if (!ssl) {
         spdlog::error("TlsConfig: Failed to create SSL object");
     }
     return ssl;
 }
 
-void TlsConfig::reset_context() {
-    if (!ctx_) {
+SSL_CTX* TlsConfig::create_context(const std::string& certFile, const std::string& keyFile) {
+    SSL_CTX* ctx = SSL_CTX_new(TLS_server_method());
+    if (!ctx) {
+        spdlog::critical("TlsConfig: Failed to create SSL_CTX");
+        return nullptr;
+    }
+
+    // TLS 1.2 是当前服务端的最低安全线，统一在上下文层配置。
+    SSL_CTX_set_min_proto_version(ctx, TLS1_2_VERSION);
+
+#ifdef SSL_OP_ENABLE_KTLS
+    SSL_CTX_set_options(ctx, SSL_OP_ENABLE_KTLS);
+#endif
+
+    if (SSL_CTX_use_certificate_chain_file(ctx, certFile.c_str()) <= 0) {
+        spdlog::critical("TlsConfig: Failed to load certificate file: {}", certFile);
+        SSL_CTX_free(ctx);
+        return nullptr;
+    }
+
+    if (SSL_CTX_use_PrivateKey_file(ctx, keyFile.c_str(), SSL_FILETYPE_PEM) <= 0) {
+        spdlog::critical("TlsConfig: Failed to load private key file: {}", keyFile);
+        SSL_CTX_free(ctx);
+        return nullptr;
+    }
+
+    if (!SSL_CTX_check_private_key(ctx)) {
+        spdlog::critical("TlsConfig: Private key does not match certificate");
+        SSL_CTX_free(ctx);
+        return nullptr;
+    }
+
+    // 回调只拿得到 SSL/SSL_CTX，借 app data 找回本对象的密钥环、计数器与证书快照
+    SSL_CTX_set_app_data(ctx, this);
+    SSL_CTX_set_tlsext_servername_callback(ctx, &TlsConfig::servername_callback);
+    if (!apply_session_options(ctx)) {
+        SSL_CTX_free(ctx);
+        return nullptr;
+    }
+    return ctx;
+}
+
+void TlsConfig::publish_locked(std::shared_ptr<const ContextSnapshot> snapshot) {
+    // 新快照一次原子替换，读者要么看到旧的要么看到新的；旧快照在最后一个读者放下引用时释放，没有读者则当即释放
+    std::atomic_store(&current_, std::move(snapshot));
+}
+
+int TlsConfig::servername_callback(SSL* ssl, int* alert, void* arg) {
+    (void)alert;
+    (void)arg;
+    TlsConfig* self = static_cast<TlsConfig*>(SSL_CTX_get_app_data(SSL_get_SSL_CTX(ssl)));
+    if (!self) {
+        return SSL_TLSEXT_ERR_OK;
+    }
+
+    // 按当前快照选证书：握手期间发生的重载对这次握手立即生效；SSL_set_SSL_CTX 持有选中上下文的引用之前快照保持有效
+    const std::shared_ptr<const ContextSnapshot> snapshot = std::atomic_load(&self->current_);
+    if (!snapshot) {
+        return SSL_TLSEXT_ERR_OK;
+    }
+    SSL_CTX* selected = snapshot->select(SSL_get_servername(ssl, TLSEXT_NAMETYPE_host_name));
+    if (selected != SSL_get_SSL_CTX(ssl)) {
+        SSL_set_SSL_CTX(ssl, selected);
+    }
+    return SSL_TLSEXT_ERR_OK;
+}
+
+bool TlsConfig::configure_sessions(const TlsSessionOptions& options) {
+    std::lock_guard<std::mutex> lock(writerMutex_);
+    sessionOptions_ = options;
+    const std::shared_ptr<const ContextSnapshot> snapshot = std::atomic_load(&current_);
+    if (!snapshot) {
+        return true;
+    }
+
+    bool ok = apply_session_options(snapshot->defaultCtx);
+    for (const auto& entry : snapshot->sniContexts) {
+        ok = apply_session_options(entry.second) && ok;
+    }
+    return ok;
+}
+
+bool TlsConfig::apply_session_options(SSL_CTX* ctx) {
+    // 1. 会话缓存：不用 SSL_CTX 内置缓存（随上下文重建而清空），改由本对象持有的外部缓存承接，
+    //    所有 IO 线程、全部证书上下文以及 reload 前后的上下文共享同一份
+    SSL_CTX_set_session_id_context(ctx, kSessionIdContext, sizeof(kSessionIdContext) - 1);
+    SSL_CTX_set_timeout(ctx, static_cast<long>(sessionOptions_.sessionTimeout.count()));
+    if (sessionOptions_.enableSessionCache) {
+        SSL_CTX_set_session_cache_mode(ctx, SSL_SESS_CACHE_SERVER | SSL_SESS_CACHE_NO_INTERNAL);
+        SSL_CTX_sess_set_new_cb(ctx, &TlsConfig::new_session_callback);
+        SSL_CTX_sess_set_get_cb(ctx, &TlsConfig::get_session_callback);
+        SSL_CTX_sess_set_remove_cb(ctx, &TlsConfig::remove_session_callback);
+    } else {
+        SSL_CTX_set_session_cache_mode(ctx, SSL_SESS_CACHE_OFF);
+    }
+
+    // 2. 票据：关闭时 TLS 1.3 改发有状态票据（查缓存）；两者都关闭则不再发送无用的票据
+    if (!sessionOptions_.enableTickets) {
+        SSL_CTX_set_options(ctx, SSL_OP_NO_TICKET);
+        if (!sessionOptions_.enableSessionCache) {
+            SSL_CTX_set_num_tickets(ctx, 0);
+        }
+        return true;
+    }
+    SSL_CTX_clear_options(ctx, SSL_OP_NO_TICKET);
+    SSL_CTX_set_num_tickets(ctx, 2);
+
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+    // 自管票据密钥环：OpenSSL 默认密钥随 SSL_CTX 生成且永不轮换
+    {
+        std::lock_guard<std::mutex> lock(ticketKeyMutex_);
+        if (ticketKeys_.empty() && !rotate_ticket_keys_locked(std::chrono::steady_clock::now())) {
+            spdlog::critical("TlsConfig: Failed to generate session ticket key");
+            return false;
+        }
+    }
+    if (SSL_CTX_set_tlsext_ticket_key_evp_cb(ctx, &TlsConfig::ticket_key_callback) != 1) {
+        spdlog::critical("TlsConfig: Failed to install session ticket key callback");
+        return false;
+    }
+#else
+    spdlog::warn("TlsConfig: OpenSSL < 3.0, session tickets use the library default key without rotation");
+#endif
+    return true;
+}
+
+void TlsConfig::rotate_ticket_keys() {
+    std::lock_guard<std::mutex> lock(ticketKeyMutex_);
+    rotate_ticket_keys_locked(std::chrono::steady_clock::now());
+}
+
+bool TlsConfig::rotate_ticket_keys_locked(std::chrono::steady_clock::time_point now) {
+    TicketKey key;
+    if (RAND_bytes(key.name.data(), static_cast<int>(key.name.size())) != 1
+        || RAND_bytes(key.aesKey.data(), static_cast<int>(key.aesKey.size())) != 1
+        || RAND_bytes(key.hmacKey.data(), static_cast<int>(key.hmacKey.size())) != 1) {
+        return false;
+    }
+    key.createdAt = now;
+
+    // 密钥环只保留当前密钥与上一把：上一把签发的票据在一个轮换周期内仍可复用，更早的票据退化为完整握手
+    ticketKeys_.insert(ticketKeys_.begin(), key);
+    if (ticketKeys_.size() > 2) {
+        ticketKeys_.resize(2);
+    }
+    if (rotations_.fetch_add(1, std::memory_order_relaxed) > 0) {
+        spdlog::info("TlsConfig: Session ticket key rotated");
+    }
+    return true;
+}
+
+void TlsConfig::store_session(SSL_SESSION* session) {
+    unsigned int idLen = 0;
+    const unsigned char* id = SSL_SESSION_get_id(session, &idLen);
+    std::string key(reinterpret_cast<const char*>(id), idLen);
+
+    std::lock_guard<std::mutex> lock(sessionCacheMutex_);
+    auto found = sessionIndex_.find(key);
+    if (found != sessionIndex_.end()) {
+        SSL_SESSION_free(found->second->second);
+        sessions_.erase(found->second);
+        sessionIndex_.erase(found);
+    }
+
+    // 有效期统一，最早写入的会话最先过期：先清掉已过期的，再按容量淘汰最早的
+    const long now = static_cast<long>(time(nullptr));
+    while (!sessions_.empty()) {
+        SSL_SESSION* oldest = sessions_.front().second;
+        const bool expired = SSL_SESSION_get_time(oldest) + SSL_SESSION_get_timeout(oldest) <= now;
+        if (!expired && sessions_.size() < sessionOptions_.sessionCacheSize) {
+            break;
+        }
+        sessionIndex_.erase(sessions_.front().first);
+        SSL_SESSION_free(oldest);
+        sessions_.pop_front();
+    }
+    if (sessionOptions_.sessionCacheSize == 0) {
+        SSL_SESSION_free(session);
+        return;
+    }
+
+    sessions_.emplace_back(key, session);
+    sessionIndex_.emplace(std::move(key), std::prev(sessions_.end()));
+}
+
+SSL_SESSION* TlsConfig::find_session(const unsigned char* id, int idLen) {
+    std::lock_guard<std::mutex> lock(sessionCacheMutex_);
+    auto found = sessionIndex_.find(std::string(reinterpret_cast<const char*>(id), static_cast<size_t>(idLen)));
+    if (found == sessionIndex_.end()) {
+        return nullptr;
+    }
+    // 在锁内为调用方加一份引用，避免返回后被并发淘汰释放
+    SSL_SESSION* session = found->second->second;
+    SSL_SESSION_up_ref(session);
+    return session;
+}
+
+void TlsConfig::erase_session(SSL_SESSION* session) {
+    unsigned int idLen = 0;
+    const unsigned char* id = SSL_SESSION_get_id(session, &idLen);
+
+    std::lock_guard<std::mutex> lock(sessionCacheMutex_);
+    auto found = sessionIndex_.find(std::string(reinterpret_cast<const char*>(id), idLen));
+    if (found == sessionIndex_.end()) {
+        return;
+    }
+    SSL_SESSION_free(found->second->second);
+    sessions_.erase(found->second);
+    sessionIndex_.erase(found);
+}
+
+int TlsConfig::new_session_callback(SSL* ssl, SSL_SESSION* session) {
+    TlsConfig* self = static_cast<TlsConfig*>(SSL_CTX_get_app_data(SSL_get_SSL_CTX(ssl)));
+    if (!self) {
+        return 0;
+    }
+    // 返回 1 表示接管 OpenSSL 传入的这份引用
+    self->store_session(session);
+    return 1;
+}
+
+SSL_SESSION* TlsConfig::get_session_callback(SSL* ssl, const unsigned char* id, int idLen, int* copy) {
+    TlsConfig* self = static_cast<TlsConfig*>(SSL_CTX_get_app_data(SSL_get_SSL_CTX(ssl)));
+    // 返回的会话已带一份新引用，交给 OpenSSL 直接接管；过期与一次性票据由 OpenSSL 判定后经 remove 回调移除
+    *copy = 0;
+    return self ? self->find_session(id, idLen) : nullptr;
+}
+
+void TlsConfig::remove_session_callback(SSL_CTX* ctx, SSL_SESSION* session) {
+    TlsConfig* self = static_cast<TlsConfig*>(SSL_CTX_get_app_data(ctx));
+    if (self) {
+        self->erase_session(session);
+    }
+}
+
+TlsSessionStats TlsConfig::get_session_stats() const {
+    TlsSessionStats stats;
+    stats.handshakes = handshakes_.load(std::memory_order_relaxed);
+    stats.resumed = resumed_.load(std::memory_order_relaxed);
+    // 首把密钥的生成不算轮换
+    const uint64_t generated = rotations_.load(std::memory_order_relaxed);
+    stats.ticketKeyRotations = generated > 0 ? generated - 1 : 0;
+    return stats;
+}
+
+void TlsConfig::record_handshake(SSL* ssl) {
+    if (!ssl) {
         return;
     }
+    TlsConfig* self = static_cast<TlsConfig*>(SSL_CTX_get_app_data(SSL_get_SSL_CTX(ssl)));
+    if (!self) {
+        return;
+    }
+
+    self->handshakes_.fetch_add(1, std::memory_order_relaxed);
+    if (SSL_session_reused(ssl)) {
+        self->resumed_.fetch_add(1, std::memory_order_relaxed);
+    }
+}
 
-    SSL_CTX_free(ctx_);
-    ctx_ = nullptr;
+int TlsConfig::ticket_key_callback(SSL* ssl, unsigned char* keyName, unsigned char* iv,
+    EVP_CIPHER_CTX* cipherCtx, EVP_MAC_CTX* macCtx, int enc) {
+    TlsConfig* self = static_cast<TlsConfig*>(SSL_CTX_get_app_data(SSL_get_SSL_CTX(ssl)));
+    // TLS 1.3 客户端把票据当作一次性凭据，复用成功后必须续发，否则每隔一次连接就退化为完整握手
+    const bool alwaysRenew = SSL_version(ssl) >= TLS1_3_VERSION;
+    return self ? self->handle_ticket_key(keyName, iv, cipherCtx, macCtx, enc, alwaysRenew) : -1;
 }
 
-void TlsConfig::restrict_to_tls12() {
-    if (ctx_) {
-        ::SSL_CTX_set_max_proto_version(ctx_, TLS1_2_VERSION);
-        spdlog::debug("TlsConfig: Restricted max protocol version to TLS 1.2 for kTLS");
+int TlsConfig::handle_ticket_key(unsigned char* keyName, unsigned char* iv,
+    EVP_CIPHER_CTX* cipherCtx, EVP_MAC_CTX* macCtx, int enc, bool alwaysRenew) {
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+    // 返回值约定：-1 出错；0 找不到密钥，走完整握手；1 成功；2 解密成功但密钥已降级，要求续发新票据
+    std::lock_guard<std::mutex> lock(ticketKeyMutex_);
+    const auto now = std::chrono::steady_clock::now();
+    const auto rotation = sessionOptions_.ticketKeyRotation;
+
+    const TicketKey* key = nullptr;
+    int result = 1;
+    if (enc) {
+        if (ticketKeys_.empty() || now - ticketKeys_.front().createdAt >= rotation) {
+            if (!rotate_ticket_keys_locked(now)) {
+                return -1;
+            }
+        }
+        key = &ticketKeys_.front();
+        if (RAND_bytes(iv, EVP_MAX_IV_LENGTH) != 1) {
+            return -1;
+        }
+        std::memcpy(keyName, key->name.data(), key->name.size());
+    } else {
+        const auto it = std::find_if(ticketKeys_.begin(), ticketKeys_.end(), [keyName](const TicketKey& candidate) {
+            return std::memcmp(candidate.name.data(), keyName, candidate.name.size()) == 0;
+            });
+        // 上一把密钥只在其后继生效后的一个周期内有效
+        if (it == ticketKeys_.end() || now - it->createdAt >= 2 * rotation) {
+            return 0;
+        }
+        key = &*it;
+        const bool current = it == ticketKeys_.begin() && now - it->createdAt < rotation;
+        result = (current && !alwaysRenew) ? 1 : 2;
+    }
+
+    OSSL_PARAM params[] = {
+        OSSL_PARAM_construct_octet_string(OSSL_MAC_PARAM_KEY, const_cast<unsigned char*>(key->hmacKey.data()), key->hmacKey.size()),
+        OSSL_PARAM_construct_utf8_string(OSSL_MAC_PARAM_DIGEST, const_cast<char*>("SHA256"), 0),
+        OSSL_PARAM_construct_end()
+    };
+    if (EVP_MAC_CTX_set_params(macCtx, params) != 1) {
+        return -1;
     }
+    const int cipherOk = enc
+        ? EVP_EncryptInit_ex(cipherCtx, EVP_aes_256_cbc(), nullptr, key->aesKey.data(), iv)
+        : EVP_DecryptInit_ex(cipherCtx, EVP_aes_256_cbc(), nullptr, key->aesKey.data(), iv);
+    return cipherOk == 1 ? result : -1;
+#else
+    (void)keyName;
+    (void)iv;
+    (void)cipherCtx;
+    (void)macCtx;
+    (void)enc;
+    (void)alwaysRenew;
+    return -1;
+#endif
 }
@@ -1,11 +1,46 @@
 #pragma once
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
 
 // TlsConfig 把 SSL_CTX 的初始化收敛成单向步骤，作为全局共享的安全传输配置工厂。
+// 会话复用状态（票据密钥环、会话缓存、命中计数）由本对象持有，不随 SSL_CTX 重建：所有 IO 线程与全部证书上下文共享，
+// reload 或新增证书后，此前签发的票据与缓存的会话仍可复用。
+// 证书上下文（默认证书 + 按 SNI 选择的证书）组成一份不可变快照，以引用计数的 shared_ptr 原子发布：
+// 接入路径（create_ssl、SNI 回调）原子加载一份引用后使用，期间快照不会被释放；重载与新增证书构造新快照后整体替换，
+// 最后一个读者放下引用时旧快照随即释放，旧连接继续持有旧 SSL_CTX 的引用。
 
 // 前向声明 OpenSSL 类型，避免头文件污染
 typedef struct ssl_ctx_st SSL_CTX;
 typedef struct ssl_st SSL;
+typedef struct ssl_session_st SSL_SESSION;
+typedef struct evp_cipher_ctx_st EVP_CIPHER_CTX;
+typedef struct evp_mac_ctx_st EVP_MAC_CTX;
+
+struct TlsSessionOptions {
+    bool enableTickets = true;                          // 无状态会话票据，票据密钥由本进程生成并按周期轮换。
+    std::chrono::seconds ticketKeyRotation{3600};       // 票据密钥轮换周期；旧密钥再保留一个周期，只用于解密并续发新票据。
+    bool enableSessionCache = false;                    // 进程内共享的服务端会话缓存（TLS 1.2 Session ID；关闭票据时 TLS 1.3 改发有状态票据）。
+    size_t sessionCacheSize = 20480;                    // 会话缓存容量上限（条）。
+    std::chrono::seconds sessionTimeout{7200};          // 会话有效期，同时约束票据与缓存。
+};
+
+struct TlsSessionStats {
+    uint64_t handshakes = 0;                            // 完成的服务端握手数。
+    uint64_t resumed = 0;                               // 其中复用了会话（票据或缓存）的握手数。
+    uint64_t ticketKeyRotations = 0;                    // 票据密钥轮换次数。
+
+    double hit_rate() const { return handshakes == 0 ? 0.0 : static_cast<double>(resumed) / static_cast<double>(handshakes); }
+};
 
 class TlsConfig {
 public:
@@ -15,15 +50,72 @@ public:
     TlsConfig(const TlsConfig&) = delete;
     TlsConfig& operator=(const TlsConfig&) = delete;
 
-    bool init(const std::string& certFile, const std::string& keyFile); // 初始化 SSL_CTX 并加载证书/私钥。
-    SSL* create_ssl() const; // 为一个新连接创建 SSL 会话对象。
+    bool init(const std::string& certFile, const std::string& keyFile); // 初始化默认证书的 SSL_CTX，会话复用使用当前选项；清空已添加的 SNI 证书。
+    bool add_certificate(const std::string& serverName, const std::string& certFile, const std::string& keyFile); // 线程安全：按 SNI 主机名（支持 *.example.com）追加或替换证书。
+    bool reload(); // 线程安全：从原路径重新加载全部证书，全部成功才替换；新连接使用新证书，已有连接不受影响，会话复用状态保留。
+    SSL* create_ssl() const; // 线程安全、无锁：为一个新连接创建 SSL 会话对象。
+
+    bool is_initialized() const { return std::atomic_load(&current_) != nullptr; }
+
+    bool configure_sessions(const TlsSessionOptions& options); // 需在服务启动前调用；init 之前调用则在 init 时生效。
+    void rotate_ticket_keys(); // 线程安全：立即生成新票据密钥，上一把降为只解密（如怀疑密钥泄露时手动轮换）。
+    TlsSessionStats get_session_stats() const;
 
-    bool is_initialized() const { return ctx_ != nullptr; }
-    void restrict_to_tls12();
+    static void record_handshake(SSL* ssl); // 服务端握手完成时调用，按 SSL 所属上下文累加复用计数。
 
 private:
-    void reset_context();
+    struct TicketKey {
+        std::array<unsigned char, 16> name;             // 票据中携带的密钥名，用于解密时查找密钥。
+        std::array<unsigned char, 32> aesKey;           // AES-256-CBC 加密密钥。
+        std::array<unsigned char, 32> hmacKey;          // HMAC-SHA256 完整性密钥。
+        std::chrono::steady_clock::time_point createdAt;
+    };
+
+    struct CertificateFiles {
+        std::string serverName;                         // SNI 主机名（小写）；空串表示默认证书。
+        std::string certFile;
+        std::string keyFile;
+    };
+
+    // 一次发布的证书上下文集合，发布后只读；析构时释放自己持有的 SSL_CTX 引用。
+    struct ContextSnapshot {
+        SSL_CTX* defaultCtx = nullptr;                  // 未带 SNI 或未匹配时使用。
+        std::vector<std::pair<std::string, SSL_CTX*>> sniContexts; // 主机名（或 *.域名）到上下文。
+
+        ~ContextSnapshot();
+        SSL_CTX* select(const char* serverName) const;
+    };
+
+    SSL_CTX* create_context(const std::string& certFile, const std::string& keyFile);
+    void publish_locked(std::shared_ptr<const ContextSnapshot> snapshot);
+    bool apply_session_options(SSL_CTX* ctx);
+    bool rotate_ticket_keys_locked(std::chrono::steady_clock::time_point now);
+    void store_session(SSL_SESSION* session);
+    SSL_SESSION* find_session(const unsigned char* id, int idLen); // 命中时返回一份新引用，由调用方释放。
+    void erase_session(SSL_SESSION* session);
+    int handle_ticket_key(unsigned char* keyName, unsigned char* iv, EVP_CIPHER_CTX* cipherCtx, EVP_MAC_CTX* macCtx, int enc, bool alwaysRenew);
+    static int servername_callback(SSL* ssl, int* alert, void* arg);
+    static int ticket_key_callback(SSL* ssl, unsigned char* keyName, unsigned char* iv,
+        EVP_CIPHER_CTX* cipherCtx, EVP_MAC_CTX* macCtx, int enc);
+    static int new_session_callback(SSL* ssl, SSL_SESSION* session);
+    static SSL_SESSION* get_session_callback(SSL* ssl, const unsigned char* id, int idLen, int* copy);
+    static void remove_session_callback(SSL_CTX* ctx, SSL_SESSION* session);
 
 private:
-    SSL_CTX* ctx_;                      // 全局 TLS 服务端上下文，由 HttpServer 共享使用。
+    std::mutex writerMutex_;                                    // 串行化 init/add_certificate/reload/configure_sessions，读侧不加锁。
+    std::vector<CertificateFiles> certificates_;                // 已加载证书的来源路径，reload 按此重建。
+    std::shared_ptr<const ContextSnapshot> current_;            // 当前发布的证书快照，只经 std::atomic_load/atomic_store 访问；为空表示未初始化。
+    TlsSessionOptions sessionOptions_;  // 会话复用配置。
+
+    mutable std::mutex ticketKeyMutex_; // 保护 ticketKeys_，多个 IO 线程并发签发/解密票据。
+    std::vector<TicketKey> ticketKeys_; // 票据密钥环：首个为当前签发密钥，其余只用于解密。
+
+    using SessionList = std::list<std::pair<std::string, SSL_SESSION*>>;
+    std::mutex sessionCacheMutex_;      // 保护会话缓存，多个 IO 线程并发存取。
+    SessionList sessions_;              // 会话缓存（Session ID -> 会话），按写入先后排列，超出容量时淘汰最早的。
+    std::unordered_map<std::string, SessionList::iterator> sessionIndex_; // Session ID 到 sessions_ 节点的索引。
+
+    std::atomic<uint64_t> handshakes_;  // 完成的握手数。
+    std::atomic<uint64_t> resumed_;     // 复用会话的握手数。
+    std::atomic<uint64_t> rotations_;   // 票据密钥轮换次数。
 };
@@ -4,18 +4,15 @@
 // ============================================================================
 
 #include "tudou/http/TlsConnection.h"
+#include "tudou/http/TlsConfig.h"
+#include "base/ScopedSigPipeBlock.h"
+#include "tudou/tcp/Buffer.h"
 #include "spdlog/spdlog.h"
 
 #include <openssl/ssl.h>
 
-#if defined(__linux__) && defined(SSL_OP_ENABLE_KTLS)
-#include <sys/socket.h>
-#include <netinet/in.h>
-#include <netinet/tcp.h>
-#include <unistd.h>
-#include <cerrno>
+#include <algorithm>
 #include <cstring>
-#endif
 
 namespace {
 
@@ -23,17 +20,42 @@ constexpr int kTlsBufferSize = 16384;
 
 } // namespace
 
-TlsConnection::TlsConnection(SSL* ssl)
+TlsConnection::TlsConnection(SSL* ssl, TlsMode mode, int socketFd)
     : ssl_(ssl)
     , rbio_(nullptr)
     , wbio_(nullptr)
-    , state_(State::HANDSHAKING) {
+    , state_(State::HANDSHAKING)
+    , bufferBio_(mode == TlsMode::BufferBio)
+    , socketBio_(mode == TlsMode::KernelTls)
+    , bufferWrite_(mode == TlsMode::BufferBio)
+    , ktlsSend_(false)
+    , ktlsRecv_(false)
+    , peerKeyUpdate_(false)
+    , inboundBuffer_(nullptr)
+    , outboundBuffer_(nullptr)
+    , copiedBytes_(0) {
 
     if (!ssl_) {
         mark_error("TlsConnection: Cannot initialize with null SSL handle");
         return;
     }
 
+    if (bufferBio_) {
+        attach_buffer_bio();
+    } else if (socketBio_) {
+        attach_socket_bio_pair(socketFd);
+    } else {
+        attach_memory_bio_pair();
+    }
+    if (state_ == State::ERROR) {
+        return;
+    }
+
+    // 当前对象始终扮演 TLS 服务端，客户端握手驱动由对端承担。
+    SSL_set_accept_state(ssl_);
+}
+
+void TlsConnection::attach_memory_bio_pair() {
     rbio_ = BIO_new(BIO_s_mem());
     wbio_ = BIO_new(BIO_s_mem());
     if (!rbio_ || !wbio_) {
@@ -51,12 +73,74 @@ TlsConnection::TlsConnection(SSL* ssl)
 
     // SSL_set_bio 会接管 BIO 的释放职责；这里保留裸指针仅用于后续读写。
     SSL_set_bio(ssl_, rbio_, wbio_);
-    // 当前对象始终扮演 TLS 服务端，客户端握手驱动由对端承担。
-    SSL_set_accept_state(ssl_);
+}
+
+void TlsConnection::attach_buffer_bio() {
+    BIO* bio = create_buffer_bio();
+    if (!bio) {
+        mark_error("TlsConnection: Failed to create Buffer BIO");
+        return;
+    }
+
+    // 读写共用同一个 BIO：SSL_set_bio 传入同一指针时只接管一份引用。
+    rbio_ = bio;
+    wbio_ = bio;
+    SSL_set_bio(ssl_, bio, bio);
+}
+
+void TlsConnection::attach_socket_bio_pair(int fd) {
+    if (fd < 0) {
+        mark_error("TlsConnection: Kernel TLS requires a connected socket fd");
+        return;
+    }
+
+    // 读写各用一个 Socket BIO：OpenSSL 在各自方向的密钥就绪时对对应 BIO 执行 BIO_set_ktls，
+    // TX 未卸载时只需替换写 BIO，读方向不受影响。BIO_new_socket 同时为 fd 挂上 TCP ULP "tls"。
+    rbio_ = BIO_new_socket(fd, BIO_NOCLOSE);
+    wbio_ = BIO_new_socket(fd, BIO_NOCLOSE);
+    if (!rbio_ || !wbio_) {
+        if (rbio_) {
+            BIO_free(rbio_);
+            rbio_ = nullptr;
+        }
+        if (wbio_) {
+            BIO_free(wbio_);
+            wbio_ = nullptr;
+        }
+        mark_error("TlsConnection: Failed to create Socket BIO pair");
+        return;
+    }
+    SSL_set_bio(ssl_, rbio_, wbio_);
+
+#ifdef SSL_OP_ENABLE_KTLS
+    SSL_set_options(ssl_, SSL_OP_ENABLE_KTLS);
+#endif
+#ifdef SSL_OP_IGNORE_UNEXPECTED_EOF
+    // HTTP 自带长度分帧，对端不发 close_notify 直接断开按正常关闭处理，与明文连接的 EOF 语义一致。
+    SSL_set_options(ssl_, SSL_OP_IGNORE_UNEXPECTED_EOF);
+#endif
+    SSL_set_msg_callback(ssl_, &TlsConnection::on_tls_message);
+    SSL_set_msg_callback_arg(ssl_, this);
+}
+
+BIO* TlsConnection::create_buffer_bio() {
+    BIO_METHOD* method = buffer_bio_method();
+    BIO* bio = method ? BIO_new(method) : nullptr;
+    if (!bio) {
+        return nullptr;
+    }
+    BIO_set_data(bio, this);
+    BIO_set_init(bio, 1);
+    return bio;
 }
 
 TlsConnection::~TlsConnection() {
     if (ssl_) {
+        // HTTP 连接多在无 close_notify 的情况下关闭；未标记关闭时 SSL_free 会把会话逐出共享缓存，
+        // 正常建立的会话仍应可复用，只有出错的会话才让 OpenSSL 作废
+        if (state_ == State::ESTABLISHED) {
+            SSL_set_shutdown(ssl_, SSL_SENT_SHUTDOWN | SSL_RECEIVED_SHUTDOWN);
+        }
         SSL_free(ssl_);
         ssl_ = nullptr;
     }
@@ -72,6 +156,10 @@ TlsConnection::ReadResult TlsConnection::read_plaintext(
     if (!ensure_tls_session("read_plaintext")) {
         return ReadResult::Error;
     }
+    if (bufferBio_ || socketBio_) {
+        spdlog::error("TlsConnection: string read_plaintext requires Memory BIO");
+        return ReadResult::Error;
+    }
 
     // 1. 将接收到的网络密文写入输入缓冲（rbio_）
     if (!ciphertext.empty()) {
@@ -80,22 +168,12 @@ TlsConnection::ReadResult TlsConnection::read_plaintext(
             mark_error("TlsConnection: BIO_write failed");
             return ReadResult::Error;
         }
+        copiedBytes_ += static_cast<uint64_t>(written);
     }
 
     // 2. 尝试推进 TLS 握手状态
-    if (state_ == State::HANDSHAKING) {
-        const int result = SSL_do_handshake(ssl_);
-        if (result == 1) {
-            state_ = State::ESTABLISHED;
-            spdlog::debug("TlsConnection: TLS handshake completed successfully");
-        } else {
-            const int err = SSL_get_error(ssl_, result);
-            if (err != SSL_ERROR_WANT_READ && err != SSL_ERROR_WANT_WRITE) {
-                state_ = State::ERROR;
-                spdlog::error("TlsConnection: TLS handshake failed, SSL_get_error={}", err);
-                return ReadResult::Error;
-            }
-        }
+    if (!advance_handshake()) {
+        return ReadResult::Error;
     }
 
     // 先把握手阶段产生的待发密文交给调用方，再决定本轮是否已有可读明文。
@@ -115,6 +193,7 @@ TlsConnection::ReadResult TlsConnection::read_plaintext(
         const int n = SSL_read(ssl_, buf, sizeof(buf));
         if (n > 0) {
             plaintext.append(buf, n);
+            copiedBytes_ += static_cast<uint64_t>(n);
             continue;
         }
 
@@ -144,6 +223,10 @@ bool TlsConnection::write_plaintext(const std::string& plaintext, std::string& c
     if (!ensure_tls_session("write_plaintext")) {
         return false;
     }
+    if (bufferBio_ || socketBio_) {
+        spdlog::error("TlsConnection: string write_plaintext requires Memory BIO");
+        return false;
+    }
 
     if (state_ != State::ESTABLISHED) {
         spdlog::warn("TlsConnection: Cannot encrypt, TLS not established");
@@ -166,6 +249,196 @@ bool TlsConnection::write_plaintext(const std::string& plaintext, std::string& c
     return !ciphertext.empty();
 }
 
+TlsConnection::ReadResult TlsConnection::read_plaintext(
+    Buffer& ciphertext,
+    Buffer& plaintext,
+    Buffer& outboundCiphertext) {
+    if (!ensure_tls_session("read_plaintext")) {
+        return ReadResult::Error;
+    }
+    if (!bufferBio_) {
+        spdlog::error("TlsConnection: Buffer read_plaintext requires Buffer BIO");
+        return ReadResult::Error;
+    }
+
+    // 本次调用期间把 BIO 指向调用方缓冲：OpenSSL 按记录边界直接从 ciphertext 取密文，
+    // 握手与告警产生的密文直接追加到 outboundCiphertext，不经过任何中转 string。
+    inboundBuffer_ = &ciphertext;
+    outboundBuffer_ = &outboundCiphertext;
+    ReadResult result = ReadResult::NeedMoreData;
+    if (!advance_handshake()) {
+        result = ReadResult::Error;
+    } else if (state_ == State::ESTABLISHED) {
+        result = drain_plaintext(plaintext);
+    }
+    inboundBuffer_ = nullptr;
+    outboundBuffer_ = nullptr;
+    return result;
+}
+
+TlsConnection::ReadResult TlsConnection::drain_plaintext(Buffer& plaintext) {
+    // 明文直接解密进 plaintext 的可写区，省去栈缓冲中转与 append 拷贝
+    size_t decrypted = 0;
+    while (true) {
+        plaintext.ensure_writable_bytes(kTlsBufferSize);
+        const int n = SSL_read(ssl_, plaintext.writable_start_ptr(), kTlsBufferSize);
+        if (n > 0) {
+            plaintext.advance_write_index(static_cast<size_t>(n));
+            decrypted += static_cast<size_t>(n);
+            continue;
+        }
+
+        const int err = SSL_get_error(ssl_, n);
+        if (err == SSL_ERROR_WANT_READ) {
+            break;
+        }
+        if (err == SSL_ERROR_ZERO_RETURN) {
+            spdlog::debug("TlsConnection: Peer sent TLS close_notify");
+            if (socketBio_) {
+                // socket 上已不会再有数据，水平触发下必须由上层关闭连接
+                return ReadResult::Closed;
+            }
+            break;
+        }
+        if (err == SSL_ERROR_WANT_WRITE && socketBio_) {
+            return ReadResult::WantWrite;
+        }
+
+        mark_error("TlsConnection: SSL_read failed");
+        spdlog::error("TlsConnection: SSL_read error, SSL_get_error={}", err);
+        return ReadResult::Error;
+    }
+
+    if (peerKeyUpdate_) {
+        mark_error("TlsConnection: Peer KeyUpdate cannot be applied to kernel TLS keys, closing connection");
+        return ReadResult::Error;
+    }
+    return decrypted == 0 ? ReadResult::NeedMoreData : ReadResult::Ready;
+}
+
+bool TlsConnection::write_plaintext(const char* data, size_t len, Buffer& ciphertext) {
+    if (len == 0) {
+        return true;
+    }
+
+    if (!ensure_tls_session("write_plaintext")) {
+        return false;
+    }
+    if (!bufferWrite_) {
+        spdlog::error("TlsConnection: Buffer write_plaintext requires Buffer BIO");
+        return false;
+    }
+
+    if (state_ != State::ESTABLISHED) {
+        spdlog::warn("TlsConnection: Cannot encrypt, TLS not established");
+        return false;
+    }
+
+    // 输出 Buffer 可无限追加，SSL_write 不会因 BIO 背压返回 WANT_WRITE，一次调用即写完全部明文。
+    outboundBuffer_ = &ciphertext;
+    const int written = SSL_write(ssl_, data, static_cast<int>(len));
+    outboundBuffer_ = nullptr;
+    if (written <= 0) {
+        mark_error("TlsConnection: SSL_write failed");
+        spdlog::error("TlsConnection: SSL_write error, SSL_get_error={}", SSL_get_error(ssl_, written));
+        return false;
+    }
+    return true;
+}
+
+TlsConnection::ReadResult TlsConnection::read_plaintext_from_socket(Buffer& plaintext, Buffer& outboundCiphertext) {
+    if (!ensure_tls_session("read_plaintext_from_socket")) {
+        return ReadResult::Error;
+    }
+    if (!socketBio_) {
+        spdlog::error("TlsConnection: read_plaintext_from_socket requires Kernel TLS mode");
+        return ReadResult::Error;
+    }
+
+    // OpenSSL 的 Socket BIO 用 write/sendmsg 直接写 socket，无法携带 MSG_NOSIGNAL，整个读推进期间屏蔽本线程的 SIGPIPE
+    ScopedSigPipeBlock sigPipeBlock;
+
+    // 1. 握手报文由 OpenSSL 直接经 socket 收发；OpenSSL 在密钥切换点自行调用 BIO_set_ktls，
+    //    TLS 1.2 与 TLS 1.3 的卸载时机都由其决定，不再需要握手后另行触发。
+    if (state_ == State::HANDSHAKING) {
+        if (!advance_handshake()) {
+            return ReadResult::Error;
+        }
+        if (state_ == State::HANDSHAKING) {
+            return SSL_want_write(ssl_) ? ReadResult::WantWrite : ReadResult::NeedMoreData;
+        }
+        settle_ktls_offload();
+        if (state_ == State::ERROR) {
+            return ReadResult::Error;
+        }
+    }
+
+    // 2. 逐条读取记录直到 socket 读空：RX 已卸载时内核交付的是明文，OpenSSL 只处理控制记录。
+    //    TX 未卸载时 SSL_read 产生的告警等密文落入 outboundCiphertext，由调用方写出。
+    outboundBuffer_ = bufferWrite_ ? &outboundCiphertext : nullptr;
+    const ReadResult result = drain_plaintext(plaintext);
+    outboundBuffer_ = nullptr;
+    return result;
+}
+
+void TlsConnection::settle_ktls_offload() {
+#if defined(BIO_get_ktls_send) && defined(BIO_get_ktls_recv)
+    ktlsSend_ = BIO_get_ktls_send(wbio_) == 1;
+    ktlsRecv_ = BIO_get_ktls_recv(rbio_) == 1;
+#endif
+    spdlog::debug("TlsConnection: {} handshake done, kTLS tx={}, rx={}", SSL_get_version(ssl_), ktlsSend_, ktlsRecv_);
+    if (ktlsSend_) {
+        return;
+    }
+
+    // 内核未接管发送方向（密码套件或内核不支持）：后续加密回退到用户态，密文经 Buffer BIO 交给 TcpConnection 写出，
+    // 不与 TcpConnection 的写缓冲争用 socket。握手已完整写出，此时替换写 BIO 不会丢失数据。
+    BIO* bio = create_buffer_bio();
+    if (!bio) {
+        mark_error("TlsConnection: Failed to create Buffer BIO for userspace TLS fallback");
+        return;
+    }
+    SSL_set0_wbio(ssl_, bio);
+    wbio_ = bio;
+    bufferWrite_ = true;
+}
+
+uint64_t TlsConnection::get_copied_bytes() const {
+    uint64_t copied = copiedBytes_;
+    if (!bufferBio_ && !socketBio_) {
+        // Memory BIO 内部的搬运：OpenSSL 从 rbio 取记录、向 wbio 写记录
+        if (rbio_) {
+            copied += BIO_number_read(rbio_);
+        }
+        if (wbio_) {
+            copied += BIO_number_written(wbio_);
+        }
+    }
+    return copied;
+}
+
+bool TlsConnection::advance_handshake() {
+    if (state_ != State::HANDSHAKING) {
+        return true;
+    }
+
+    const int result = SSL_do_handshake(ssl_);
+    if (result == 1) {
+        state_ = State::ESTABLISHED;
+        TlsConfig::record_handshake(ssl_);
+        spdlog::debug("TlsConnection: TLS handshake completed successfully (resumed={})", SSL_session_reused(ssl_) == 1);
+        return true;
+    }
+
+    const int err = SSL_get_error(ssl_, result);
+    if (err != SSL_ERROR_WANT_READ && err != SSL_ERROR_WANT_WRITE) {
+        state_ = State::ERROR;
+        spdlog::error("TlsConnection: TLS handshake failed, SSL_get_error={}", err);
+        return false;
+    }
+    return true;
+}
+
 std::string TlsConnection::drain_ciphertext() {
     std::string output;
 
@@ -186,6 +459,7 @@ std::string TlsConnection::drain_ciphertext() {
         return output;
     }
     output.resize(n);
+    copiedBytes_ += static_cast<uint64_t>(n);
 
     return output;
 }
@@ -209,44 +483,81 @@ void TlsConnection::mark_error(const char* message) {
     spdlog::error("{}", message);
 }
 
-bool TlsConnection::enable_ktls_offload(int fd) {
-#if defined(__linux__) && defined(SSL_OP_ENABLE_KTLS) && defined(BIO_get_ktls_send)
-    // 1. Enable TCP ULP (Upper Layer Protocol) "tls"
-    int ret = ::setsockopt(fd, IPPROTO_TCP, 31, "tls", sizeof("tls"));
-    if (ret < 0 && errno != EEXIST) {
-        spdlog::error("TlsConnection: Failed to set TCP_ULP to tls, fd={}, error={}", fd, std::strerror(errno));
-        return false;
+BIO_METHOD* TlsConnection::buffer_bio_method() {
+    // BIO_METHOD 只描述回调表，全进程共享一份即可；函数内静态变量保证多 IO 线程下只初始化一次。
+    static BIO_METHOD* method = []() {
+        BIO_METHOD* created = BIO_meth_new(BIO_get_new_index() | BIO_TYPE_SOURCE_SINK, "tudou Buffer BIO");
+        if (!created) {
+            return created;
+        }
+        BIO_meth_set_read(created, &TlsConnection::buffer_bio_read);
+        BIO_meth_set_write(created, &TlsConnection::buffer_bio_write);
+        BIO_meth_set_ctrl(created, &TlsConnection::buffer_bio_ctrl);
+        return created;
+    }();
+    return method;
+}
+
+int TlsConnection::buffer_bio_read(BIO* bio, char* out, int len) {
+    BIO_clear_retry_flags(bio);
+    TlsConnection* self = static_cast<TlsConnection*>(BIO_get_data(bio));
+    Buffer* inbound = self ? self->inboundBuffer_ : nullptr;
+    if (!inbound || inbound->readable_bytes() == 0 || len <= 0) {
+        // 没有更多密文：与非阻塞 socket 一致地报告可重试，SSL 层随之返回 WANT_READ
+        BIO_set_retry_read(bio);
+        return -1;
     }
 
-    // 2. Wrap fd into a Socket BIO
-    BIO* s_bio = BIO_new_socket(fd, BIO_NOCLOSE);
-    if (!s_bio) {
-        spdlog::error("TlsConnection: Failed to create socket BIO, fd={}", fd);
-        return false;
+    const size_t n = std::min(inbound->readable_bytes(), static_cast<size_t>(len));
+    std::memcpy(out, inbound->readable_start_ptr(), n);
+    inbound->advance_read_index(n);
+    self->copiedBytes_ += n;
+    return static_cast<int>(n);
+}
+
+int TlsConnection::buffer_bio_write(BIO* bio, const char* data, int len) {
+    BIO_clear_retry_flags(bio);
+    TlsConnection* self = static_cast<TlsConnection*>(BIO_get_data(bio));
+    Buffer* outbound = self ? self->outboundBuffer_ : nullptr;
+    if (!outbound) {
+        BIO_set_retry_write(bio);
+        return -1;
+    }
+    if (len <= 0) {
+        return 0;
     }
 
-    // 3. Bind the Socket BIO to the SSL session (wbio & rbio)
-    // SSL_set_bio takes ownership of the socket BIO.
-    // The previous memory BIOs (rbio_, wbio_) are automatically freed.
-    SSL_set_bio(ssl_, s_bio, s_bio);
-    rbio_ = nullptr;
-    wbio_ = nullptr;
+    outbound->write_to_buffer(data, static_cast<size_t>(len));
+    self->copiedBytes_ += static_cast<uint64_t>(len);
+    return len;
+}
 
-    // 4. Trigger OpenSSL to write session keys into the kernel
-    // A 1-byte write forces OpenSSL to run the internal kTLS setup.
-    ::SSL_write(ssl_, " ", 1);
+long TlsConnection::buffer_bio_ctrl(BIO* bio, int cmd, long num, void* ptr) {
+    (void)bio;
+    (void)num;
+    (void)ptr;
+    // 写出即落入输出 Buffer，没有需要冲刷的内部缓存；其余控制命令一律不支持。
+    return cmd == BIO_CTRL_FLUSH ? 1 : 0;
+}
 
-    // 5. Verify that kTLS has been successfully offloaded for sending
-    if (!BIO_get_ktls_send(s_bio)) {
-        spdlog::error("TlsConnection: OpenSSL failed to offload TX keys to kernel, fd={}", fd);
-        return false;
+void TlsConnection::on_tls_message(int writeP, int version, int contentType, const void* buf, size_t len, SSL* ssl, void* arg) {
+    (void)version;
+    (void)ssl;
+    TlsConnection* self = static_cast<TlsConnection*>(arg);
+    if (!self || writeP || contentType != SSL3_RT_HANDSHAKE || len < 5) {
+        return;
     }
 
-    spdlog::info("TlsConnection: Successfully offloaded TX keys to kTLS kernel space, fd={}", fd);
-    return true;
-#else
-    (void)fd;
-    spdlog::warn("TlsConnection: kTLS is not supported/enabled in this compilation, offload ignored.");
-    return false;
-#endif
+    const unsigned char* message = static_cast<const unsigned char*>(buf);
+    if (message[0] != SSL3_MT_KEY_UPDATE) {
+        return;
+    }
+
+    // TLS 1.3 KeyUpdate：接收密钥已在内核时，OpenSSL 无法保证同步更新内核中的接收密钥；
+    // 对端要求我方也更新（update_requested）时，回应的 KeyUpdate 需重新装载内核发送密钥，旧内核会拒绝。
+    // 两种情况都无法安全继续，标记后由本轮读取收口为错误并关闭连接。
+    const bool updateRequested = message[4] == SSL_KEY_UPDATE_REQUESTED;
+    if (self->ktlsRecv_ || (self->ktlsSend_ && updateRequested)) {
+        self->peerKeyUpdate_ = true;
+    }
 }
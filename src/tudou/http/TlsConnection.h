@@ -6,10 +6,11 @@
 //
 // TlsConnection.h
 // └── TlsConnection
-//     ├── TlsConnection(ssl)                     # [公有] 接管 SSL 并初始化 Memory BIO + 服务端模式
-//     │   └── initialize_tls_session()           # [私有] 建立单连接 TLS 会话基础设施
-//     │       ├── create_memory_bio_pair()       # [私有] 创建读写 Memory BIO
-//     │       └── attach_memory_bio_pair()       # [私有] 将 BIO 绑定到 SSL
+//     ├── TlsConnection(ssl, mode, socketFd)     # [公有] 接管 SSL 并初始化 BIO + 服务端模式
+//     │   ├── attach_memory_bio_pair()           # [私有] MemoryBio：创建读写 Memory BIO 并绑定到 SSL
+//     │   ├── attach_buffer_bio()                # [私有] BufferBio：创建直连 Buffer 的自定义 BIO 并绑定到 SSL
+//     │   │   └── buffer_bio_method()            # [私有] 进程内唯一的自定义 BIO_METHOD
+//     │   └── attach_socket_bio_pair(fd)         # [私有] KernelTls：读写各一个 Socket BIO，由 OpenSSL 自行把密钥装入内核
 //     ├── TlsConnection(copy)                    # [公有] 删除拷贝构造，避免复制连接级 TLS 状态
 //     ├── operator=(copy)                        # [公有] 删除拷贝赋值，保持 SSL/BIO 唯一所有权
 //     ├── ~TlsConnection()                       # [公有] 释放 SSL，对应 BIO 由 SSL 一并回收
@@ -17,7 +18,7 @@
 //     │   ├── feed_ciphertext(data, len)         # [私有] 把网络密文写入读 BIO
 //     │   │   ├── ensure_tls_session(action) const   # [私有] 校验会话是否可继续执行
 //     │   │   └── mark_error(message)            # [私有] BIO_write 失败时切换 ERROR 状态
-//     │   ├── advance_handshake()                # [私有] 推进一次 TLS 握手
+//     │   ├── advance_handshake()                # [私有] 推进一次 TLS 握手；完成时向 TlsConfig 上报是否复用会话
 //     │   │   ├── ensure_tls_session(action) const   # [私有] 校验会话状态
 //     │   │   └── handle_tls_progress(action, result) # [私有] 处理 WANT_READ/WANT_WRITE 或错误态
 //     │   ├── drain_ciphertext()                 # [私有] 从写 BIO 取出待发送密文
@@ -29,6 +30,20 @@
 //     │   │   ├── ensure_tls_session(action) const   # [私有] 校验会话状态
 //     │   │   └── mark_error(message)            # [私有] SSL_write 致命失败时切 ERROR
 //     │   └── drain_ciphertext()                 # [私有] 从写 BIO 取出待发送密文
+//     ├── read_plaintext(ciphertext, plaintext, outbound) # [公有] BufferBio：直接消费密文 Buffer，明文原地解密进 Buffer
+//     │   ├── advance_handshake()                # [私有] 推进一次 TLS 握手（两种 BIO 共用）
+//     │   ├── drain_plaintext(plaintext)         # [私有] 明文直接解密进 plaintext 可写区
+//     │   ├── buffer_bio_read(bio, out, len)     # [私有] BIO 回调：从 inboundBuffer_ 取密文
+//     │   └── buffer_bio_write(bio, data, len)   # [私有] BIO 回调：把密文追加到 outboundBuffer_
+//     ├── write_plaintext(data, len, ciphertext) # [公有] BufferBio / KernelTls 回退：密文经 BIO 回调直接追加到 ciphertext
+//     ├── read_plaintext_from_socket(plaintext, outbound) # [公有] KernelTls：OpenSSL 按记录直接读 socket，握手与解密同一入口
+//     │   ├── advance_handshake()                # [私有] 推进握手，握手报文直接写入 socket
+//     │   ├── settle_ktls_offload()              # [私有] 握手完成：确认 TX/RX 卸载结果，TX 未卸载时写 BIO 换成 Buffer BIO
+//     │   ├── drain_plaintext(plaintext)         # [私有] 读到 EAGAIN；close_notify/EOF 报告 Closed
+//     │   └── on_tls_message(...)                # [私有] 记录对端 KeyUpdate，内核密钥无法同步时拒绝继续
+//     ├── is_ktls_send_offloaded() const         # [公有] 发送方向是否已由内核加密
+//     ├── is_ktls_recv_offloaded() const         # [公有] 接收方向是否已由内核解密
+//     ├── get_copied_bytes() const               # [公有] 累计用户态搬运字节数，用于对比两种 BIO 的拷贝开销
 //     ├── get_state() const                      # [公有] 读取 TLS 生命周期状态
 //     ├── is_handshaking() const                 # [公有] 判断是否仍在握手阶段
 //     ├── is_established() const                 # [公有] 判断是否已建立完成
@@ -36,19 +51,30 @@
 // ============================================================================
 
 #pragma once
+#include <cstddef>
+#include <cstdint>
 #include <string>
 
+#include "tudou/http/TlsMode.h"
+
 // TlsConnection 只负责单连接 TLS 状态机，不参与任何 HTTP 业务编排。
+// MemoryBio 与 BufferBio 两套读写接口互不通用：构造时选定 BIO 后只能调用对应的一套，调错会直接返回失败。
+// KernelTls 下 OpenSSL 直接读写 socket：握手完成后 TX/RX 是否卸载到内核各自独立，TX 未卸载时加密回退到 Buffer BIO 接口。
 
 typedef struct ssl_st SSL;
 typedef struct bio_st BIO;
+typedef struct bio_method_st BIO_METHOD;
+
+class Buffer;
 
 class TlsConnection {
 public:
     enum class ReadResult {
         Error,
         NeedMoreData,
-        Ready
+        Ready,
+        WantWrite,      // KernelTls：socket 发送缓冲已满，握手报文未写完，需在 socket 可写后重试
+        Closed          // KernelTls：对端发送 close_notify 或已关闭连接
     };
 
     enum class State {
@@ -57,7 +83,7 @@ public:
         ERROR           // 发生错误
     };
 
-    explicit TlsConnection(SSL* ssl);
+    explicit TlsConnection(SSL* ssl, TlsMode mode = TlsMode::MemoryBio, int socketFd = -1); // KernelTls 需传入连接 fd。
     ~TlsConnection();
 
     TlsConnection(const TlsConnection&) = delete;
@@ -68,7 +94,19 @@ public:
         std::string& plaintext,
         std::string& outboundCiphertext); // 喂入密文并返回本轮可消费的明文与待发送密文。
     bool write_plaintext(const std::string& plaintext, std::string& ciphertext); // 把明文编码成可直接发送的 TLS 密文。
-    bool enable_ktls_offload(int fd); // 切换 Memory BIO 为 Socket BIO 并激活内核 kTLS
+    ReadResult read_plaintext(
+        Buffer& ciphertext,
+        Buffer& plaintext,
+        Buffer& outboundCiphertext); // BufferBio：OpenSSL 直接消费 ciphertext，明文追加到 plaintext，握手密文追加到 outboundCiphertext。
+    bool write_plaintext(const char* data, size_t len, Buffer& ciphertext); // BufferBio，或 KernelTls 未卸载 TX 时：加密结果直接追加到 ciphertext。
+    ReadResult read_plaintext_from_socket(
+        Buffer& plaintext,
+        Buffer& outboundCiphertext); // KernelTls：调用方须读到返回 NeedMoreData 为止；TX 未卸载时告警等密文追加到 outboundCiphertext。
+
+    bool uses_buffer_bio() const { return bufferBio_; }
+    bool is_ktls_send_offloaded() const { return ktlsSend_; } // 为 true 时明文直接写 socket 即由内核加密，可配合 sendfile。
+    bool is_ktls_recv_offloaded() const { return ktlsRecv_; }
+    uint64_t get_copied_bytes() const; // 本连接在用户态搬运的密文/明文字节数，不含 OpenSSL 记录层内部的解密搬运。
 
     State get_state() const { return state_; }
     bool is_handshaking() const { return state_ == State::HANDSHAKING; }
@@ -76,13 +114,35 @@ public:
     bool is_error() const { return state_ == State::ERROR; }
 
 private:
+    void attach_memory_bio_pair();
+    void attach_buffer_bio();
+    void attach_socket_bio_pair(int fd);
+    BIO* create_buffer_bio();
+    void settle_ktls_offload(); // KernelTls 握手完成后调用一次。
+    bool advance_handshake(); // 推进握手；返回 false 表示握手致命失败。
+    ReadResult drain_plaintext(Buffer& plaintext); // BufferBio：把已到达的完整记录解密进 plaintext。
     std::string drain_ciphertext();
     bool ensure_tls_session(const char* action) const; // 校验 SSL/BIO/状态机是否可继续执行。
     void mark_error(const char* message); // 记录不可恢复错误并切换 ERROR。
 
+    static BIO_METHOD* buffer_bio_method();
+    static int buffer_bio_read(BIO* bio, char* out, int len);
+    static int buffer_bio_write(BIO* bio, const char* data, int len);
+    static long buffer_bio_ctrl(BIO* bio, int cmd, long num, void* ptr);
+    static void on_tls_message(int writeP, int version, int contentType, const void* buf, size_t len, SSL* ssl, void* arg);
+
 private:
     SSL* ssl_;                          // SSL 对象，拥有所有权。
     BIO* rbio_;                         // 读 BIO，承接来自网络的 TLS 密文。
-    BIO* wbio_;                         // 写 BIO，输出待发送的 TLS 密文。
+    BIO* wbio_;                         // 写 BIO，输出待发送的 TLS 密文。BufferBio 下与 rbio_ 为同一个自定义 BIO。
     State state_;                       // 当前 TLS 生命周期状态。
+    bool bufferBio_;                    // 是否使用直连 Buffer 的自定义 BIO。
+    bool socketBio_;                    // KernelTls：OpenSSL 直接读写 socket。
+    bool bufferWrite_;                  // 写 BIO 是否为 Buffer BIO（BufferBio，或 KernelTls 未卸载 TX）。
+    bool ktlsSend_;                     // 发送方向已卸载到内核。
+    bool ktlsRecv_;                     // 接收方向已卸载到内核。
+    bool peerKeyUpdate_;                // 本轮读取期间收到对端 KeyUpdate，且内核持有的密钥无法随之更新。
+    Buffer* inboundBuffer_;             // BufferBio：仅在单次读写调用期间指向调用方的密文输入缓冲。
+    Buffer* outboundBuffer_;            // BufferBio：仅在单次读写调用期间指向调用方的密文输出缓冲。
+    uint64_t copiedBytes_;              // 本对象显式搬运的字节数；Memory BIO 内部的进出量在读取时另行累加。
 };
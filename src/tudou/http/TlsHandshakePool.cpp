@@ -0,0 +1,56 @@
+// ============================================================================
+// TlsHandshakePool.cpp
+// ============================================================================
+
+#include "tudou/http/TlsHandshakePool.h"
+#include "tudou/reactor/EventLoop.h"
+#include "tudou/reactor/EventLoopThread.h"
+
+#include <stdexcept>
+
+TlsHandshakePool::TlsHandshakePool(int numThreads)
+    : deliveryMutex_()
+    , deliveryEnabled_(true)
+    , completed_(0)
+    , nextIndex_(0)
+    , loopThreads_() {
+    if (numThreads <= 0) {
+        throw std::invalid_argument("TlsHandshakePool: numThreads must be > 0");
+    }
+
+    loopThreads_.reserve(static_cast<size_t>(numThreads));
+    for (int index = 0; index < numThreads; ++index) {
+        // EventLoopThread 构造时阻塞等待 loop 就绪，返回后即可投递任务
+        loopThreads_.push_back(std::make_unique<EventLoopThread>());
+    }
+}
+
+// EventLoopThread 析构时请求 loop 退出并 join 线程
+TlsHandshakePool::~TlsHandshakePool() = default;
+
+void TlsHandshakePool::submit(Task work, EventLoop* resultLoop, Task done) {
+    const size_t index = nextIndex_.fetch_add(1, std::memory_order_relaxed) % loopThreads_.size();
+    loopThreads_[index]->get_loop()->queue_in_loop([this, work = std::move(work), resultLoop, done = std::move(done)]() {
+        work();
+        completed_.fetch_add(1, std::memory_order_relaxed);
+        deliver(resultLoop, done);
+        });
+}
+
+void TlsHandshakePool::pause_delivery() {
+    std::lock_guard<std::mutex> lock(deliveryMutex_);
+    deliveryEnabled_ = false;
+}
+
+void TlsHandshakePool::resume_delivery() {
+    std::lock_guard<std::mutex> lock(deliveryMutex_);
+    deliveryEnabled_ = true;
+}
+
+void TlsHandshakePool::deliver(EventLoop* resultLoop, Task done) {
+    // 持锁投递：pause_delivery() 拿到锁即说明此前的投递都已入队，之后 resultLoop 可以安全析构
+    std::lock_guard<std::mutex> lock(deliveryMutex_);
+    if (deliveryEnabled_) {
+        resultLoop->queue_in_loop(std::move(done));
+    }
+}
@@ -0,0 +1,60 @@
+// ============================================================================
+// TlsHandshakePool.h
+// TLS 握手加密线程池，把握手中的私钥签名、密钥交换等 CPU 密集步骤移出 IO 线程。
+//
+// 成员函数调用树（[公有]/[私有] 标注接口层级）：
+//
+// TlsHandshakePool.h
+// └── TlsHandshakePool
+//     ├── TlsHandshakePool(numThreads)           # [公有] 构造：启动 numThreads 个后台 EventLoopThread
+//     ├── ~TlsHandshakePool()                    # [公有] 析构：请求各 loop 退出并 join 线程
+//     ├── submit(work, resultLoop, done)         # [公有] 线程安全：轮询选一个加密线程执行 work，再把 done 投递回 resultLoop
+//     │   └── deliver(resultLoop, done)          # [私有] 投递开关打开时才 queue_in_loop
+//     ├── pause_delivery()                       # [公有] 线程安全：关闭投递，返回后不会再触碰任何 resultLoop
+//     ├── resume_delivery()                      # [公有] 线程安全：重新打开投递
+//     ├── get_completed_count() const            # [公有] 已执行完成的 work 数
+//     └── size() const                           # [公有] 加密线程数
+// ============================================================================
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+class EventLoop;
+class EventLoopThread;
+
+// 每个加密线程跑一个 EventLoop，任务经 queue_in_loop 投递，不需要另起一套任务队列。
+// 结果回调只在 resultLoop 上执行；IO loop 析构前必须先 pause_delivery()，否则加密线程可能向已析构的 loop 投递。
+class TlsHandshakePool {
+public:
+    using Task = std::function<void()>;
+
+    explicit TlsHandshakePool(int numThreads); // numThreads 必须大于 0。
+    ~TlsHandshakePool();
+
+    TlsHandshakePool(const TlsHandshakePool&) = delete;
+    TlsHandshakePool& operator=(const TlsHandshakePool&) = delete;
+
+    void submit(Task work, EventLoop* resultLoop, Task done);
+    void pause_delivery();
+    void resume_delivery();
+
+    uint64_t get_completed_count() const { return completed_.load(std::memory_order_relaxed); }
+    size_t size() const { return loopThreads_.size(); }
+
+private:
+    void deliver(EventLoop* resultLoop, Task done);
+
+private:
+    std::mutex deliveryMutex_;                                      // 串行化投递与开关切换：pause_delivery() 返回时不会有进行中的投递。
+    bool deliveryEnabled_;                                          // 为 false 时丢弃结果回调（连接正随服务停止一并关闭）。
+    std::atomic<uint64_t> completed_;                               // 已完成 work 数；声明在线程之前，保证晚于加密线程析构。
+    std::atomic<size_t> nextIndex_;                                 // 轮询选择加密线程的游标。
+    std::vector<std::unique_ptr<EventLoopThread>> loopThreads_;    // 加密线程，析构时退出并 join。
+};
@@ -7,6 +7,7 @@
 
 enum class TlsMode {
     None,
-    MemoryBio,
-    KernelTls
+    MemoryBio,      // 密文经 Memory BIO 中转，读写都以 std::string 交接。
+    KernelTls,      // OpenSSL 直接读写 socket，握手后 TX/RX 密钥交给内核；内核不接管的方向回退到用户态加解密。
+    BufferBio       // OpenSSL 经自定义 BIO 直接读写连接 Buffer，明文原地解密到 Buffer。
 };
@@ -22,6 +22,7 @@ EventLoop::EventLoop(int pollTimeoutMs) :
     poller_(nullptr),
     isLooping_(false),
     isQuit_(false),
+    pollReturnTime_(std::chrono::steady_clock::now()),
     pendingFunctors_(),
     pendingFunctorsMutex_(),
     isCallingPendingFunctors_(false),
@@ -63,6 +64,7 @@ void EventLoop::loop() {
     isLooping_ = true;
     while (!isQuit_) {
         const auto& activeChannels = poller_->poll(pollTimeoutMs_);
+        pollReturnTime_ = std::chrono::steady_clock::now();
 
         for (Channel* channel : activeChannels) {
             channel->handle_events();
@@ -27,6 +27,7 @@
 //     ├── update_channel(channel) const            # [公有] 把 Channel 事件兴趣同步到 Poller
 //     ├── remove_channel(channel) const            # [公有] 从 Poller 中注销 Channel
 //     ├── has_channel(channel) const               # [公有] 查询 Poller 是否已经持有该 Channel
+//     ├── get_poll_return_time() const             # [公有] 本轮 poll 返回的时间，作为本轮就绪事件的到达时间估计
 //     └── is_in_loop_thread() const                # [公有] 判断当前线程是否就是所属 loop 线程
 // ============================================================================
 
@@ -59,6 +60,7 @@ public:
     void update_channel(Channel* channel) const;
     void remove_channel(Channel* channel) const;
     bool has_channel(Channel* channel) const;
+    std::chrono::steady_clock::time_point get_poll_return_time() const { return pollReturnTime_; } // 仅限 loop 线程调用。
     void quit();
     bool is_in_loop_thread() const;
     void run_in_loop(const Functor& cb); // 同线程直执，跨线程转入 pending queue。
@@ -85,6 +87,7 @@ private:
 
     std::atomic<bool> isLooping_;                       // 当前事件循环是否处于运行状态。
     std::atomic<bool> isQuit_;                          // 当前事件循环是否收到退出请求。
+    std::chrono::steady_clock::time_point pollReturnTime_; // 本轮 poll 返回时间，本轮回调据此估算排队时延。
 
     ScopedFd wakeupFd_;                                 // 跨线程唤醒使用的 eventfd，声明在 wakeupChannel_ 之前，保证逆序析构时 Channel 先注销再关闭 fd。
     std::unique_ptr<Channel> wakeupChannel_;            // 负责监听 wakeupFd_ 可读事件的 Channel。
@@ -6,39 +6,136 @@
  */
 
 #include "Coroutine.h"
+#include "CoroutineStackPool.h"
+
+#include <memory>
+#include <mutex>
+#include <vector>
 
 namespace tudou {
 namespace rpc {
 
+namespace {
+
+std::mutex g_optionsMutex;
+CoroutineOptions g_options;
+
+// 线程退出时空闲协程列表先于其它 thread_local 析构，之后的回收请求直接销毁对象
+thread_local bool t_idleCoroutinesDestroyed = false;
+
+struct IdleCoroutines {
+    std::vector<std::unique_ptr<Coroutine>> coroutines;
+    size_t capacity;
+
+    explicit IdleCoroutines(size_t maxPooled) : capacity(maxPooled) {
+        coroutines.reserve(capacity);
+    }
+
+    ~IdleCoroutines() {
+        t_idleCoroutinesDestroyed = true;
+    }
+};
+
+// one loop per thread 下，每个线程独享的栈池即是每个 EventLoop 的栈池，协程创建与销毁全程无锁
+std::shared_ptr<CoroutineStackPool> current_thread_stack_pool() {
+    thread_local std::shared_ptr<CoroutineStackPool> pool;
+    if (!pool) {
+        const CoroutineOptions options = Coroutine::get_options();
+        pool = std::make_shared<CoroutineStackPool>(options.stackSize, options.maxPooledStacks);
+    }
+    return pool;
+}
+
+IdleCoroutines& current_thread_idle_coroutines() {
+    thread_local IdleCoroutines idle(Coroutine::get_options().maxPooledCoroutines);
+    return idle;
+}
+
+} // namespace
+
 // 初始化线程局部静态变量
 thread_local Coroutine* Coroutine::t_current_coroutine = nullptr;
 
 Coroutine::Coroutine(EventLoop* loop, std::function<void()> func)
-    : loop_(loop), func_(std::move(func)) {
-    
+    : loop_(loop), func_(std::move(func)), ownerThread_(std::this_thread::get_id()) {
+
     pull_ = std::make_unique<coro_t::pull_type>(
+        CoroutineStackAllocator(current_thread_stack_pool()),
         [this](coro_t::push_type& yield) {
             push_ = &yield;
-            
+
             // 立即挂起以返回构造函数，确保外部可以安全构造 std::shared_ptr 并使用 shared_from_this()
             (*push_)();
-            
-            Coroutine* saved = t_current_coroutine;
-            t_current_coroutine = this;
-            
-            if (func_) {
-                func_();
+
+            // 任务执行完毕后不退出协程，而是停在挂起点等待装载下一个任务，使协程对象和栈得以复用
+            while (!exiting_) {
+                if (func_) {
+                    func_();
+                }
+                func_ = nullptr;
+                finished_ = true;
+                (*push_)();
             }
-            
-            t_current_coroutine = saved;
         }
     );
 }
 
-Coroutine::~Coroutine() = default;
+Coroutine::~Coroutine() {
+    // 已完成的协程停在复用循环的挂起点上，置位退出标志后再恢复一次，让函数体自然返回并归还协程栈
+    if (pull_ && *pull_ && finished_) {
+        exiting_ = true;
+        (*pull_)();
+    }
+}
+
+std::shared_ptr<Coroutine> Coroutine::create(EventLoop* loop, std::function<void()> func) {
+    Coroutine* coro = nullptr;
+
+    if (!t_idleCoroutinesDestroyed) {
+        IdleCoroutines& idle = current_thread_idle_coroutines();
+        if (!idle.coroutines.empty()) {
+            coro = idle.coroutines.back().release();
+            idle.coroutines.pop_back();
+
+            coro->loop_ = loop;
+            coro->func_ = std::move(func);
+            coro->finished_ = false;
+        }
+    }
+
+    if (coro == nullptr) {
+        coro = new Coroutine(loop, std::move(func));
+    }
+
+    return std::shared_ptr<Coroutine>(coro, &Coroutine::recycle);
+}
+
+void Coroutine::set_options(const CoroutineOptions& options) {
+    std::lock_guard<std::mutex> lock(g_optionsMutex);
+    g_options = options;
+}
+
+CoroutineOptions Coroutine::get_options() {
+    std::lock_guard<std::mutex> lock(g_optionsMutex);
+    return g_options;
+}
+
+void Coroutine::recycle(Coroutine* coro) {
+    // 只有运行完毕、且回到创建线程的协程才能入池；被挂起中途释放的协程仍需完整销毁以展开其栈
+    if (coro->finished_ && coro->ownerThread_ == std::this_thread::get_id() && !t_idleCoroutinesDestroyed) {
+        IdleCoroutines& idle = current_thread_idle_coroutines();
+        if (idle.coroutines.size() < idle.capacity) {
+            coro->loop_ = nullptr;
+            idle.coroutines.emplace_back(coro);
+            return;
+        }
+    }
+
+    delete coro;
+}
 
 void Coroutine::resume() {
-    if (pull_ && *pull_) {
+    if (!finished_ && pull_ && *pull_) {
         Coroutine* saved = t_current_coroutine;
         t_current_coroutine = this;
         // 恢复 pull_type 的执行流
@@ -8,25 +8,37 @@
 #pragma once
 
 #include <boost/coroutine2/all.hpp>
+#include <cstddef>
 #include <functional>
 #include <memory>
+#include <thread>
 
 class EventLoop;
 
 namespace tudou {
 namespace rpc {
 
+/**
+ * @brief 协程栈与协程对象池的配置。栈池与对象池均按线程（即按 EventLoop）独立创建，
+ *        因此需在 EventLoop 线程首次创建协程之前通过 Coroutine::set_options() 设置。
+ */
+struct CoroutineOptions {
+    size_t stackSize = 128 * 1024;          // 单个协程栈的可用大小（不含保护页）
+    size_t maxPooledStacks = 1024;          // 每个线程最多缓存的空闲栈数量
+    size_t maxPooledCoroutines = 1024;      // 每个线程最多缓存的已完成协程对象数量
+};
+
 class Coroutine : public std::enable_shared_from_this<Coroutine> {
 public:
     using coro_t = boost::coroutines2::coroutine<void>;
 
     /**
-     * @brief 构造函数，初始化并启动协程到第一个 yield 点
+     * @brief 构造函数，初始化并启动协程到第一个 yield 点。协程栈取自当前线程的栈池。
      * @param loop 协程所在的 EventLoop 线程指针
      * @param func 协程要运行的函数体
      */
     Coroutine(EventLoop* loop, std::function<void()> func);
-    
+
     /**
      * @brief 析构函数
      */
@@ -36,6 +48,24 @@ public:
     Coroutine(const Coroutine&) = delete;
     Coroutine& operator=(const Coroutine&) = delete;
 
+    /**
+     * @brief 从当前线程的协程对象池取出一个已完成的协程并装载新任务，池为空时再新建。
+     *        返回的 shared_ptr 在最后一个引用释放时，若协程已运行完毕则回收入池而非销毁。
+     * @param loop 协程所在的 EventLoop 线程指针
+     * @param func 协程要运行的函数体
+     */
+    static std::shared_ptr<Coroutine> create(EventLoop* loop, std::function<void()> func);
+
+    /**
+     * @brief 设置协程栈与对象池参数，仅对之后首次创建协程的线程生效
+     */
+    static void set_options(const CoroutineOptions& options);
+
+    /**
+     * @brief 获取当前协程栈与对象池参数
+     */
+    static CoroutineOptions get_options();
+
     /**
      * @brief 恢复运行该协程（从上一个 yield 挂起点继续向下）
      */
@@ -51,15 +81,26 @@ public:
      */
     EventLoop* get_loop() const { return loop_; }
 
+    /**
+     * @brief 协程函数体是否已执行完毕
+     */
+    bool is_finished() const { return finished_; }
+
 public:
     // 线程局部变量：当前正在运行的协程实例指针
     static thread_local Coroutine* t_current_coroutine;
 
+private:
+    static void recycle(Coroutine* coro);
+
 private:
     EventLoop* loop_;
     std::function<void()> func_;
     std::unique_ptr<coro_t::pull_type> pull_;
     coro_t::push_type* push_ = nullptr;
+    std::thread::id ownerThread_;   // 创建协程（即持有其栈池）的线程，只有该线程能把协程回收入池
+    bool finished_ = false;         // 当前任务是否已执行完毕，协程停在复用循环的挂起点上
+    bool exiting_ = false;          // 析构时置位，让复用循环退出并释放协程栈
 };
 
 } // namespace rpc
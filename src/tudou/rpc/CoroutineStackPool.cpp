@@ -0,0 +1,102 @@
+/**
+ * @file CoroutineStackPool.cpp
+ * @brief 带保护页的协程栈池实现
+ * @author wenxingming
+ * @project: https://github.com/WenXingming/Tudou
+ */
+
+#include "CoroutineStackPool.h"
+
+#include <sys/mman.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#include <new>
+#include <spdlog/spdlog.h>
+
+namespace tudou {
+namespace rpc {
+
+namespace {
+
+size_t round_up_to_page(size_t size, size_t pageSize) {
+    if (size == 0) {
+        size = pageSize;
+    }
+    return (size + pageSize - 1) / pageSize * pageSize;
+}
+
+} // namespace
+
+CoroutineStackPool::CoroutineStackPool(size_t stackSize, size_t maxCachedStacks)
+    : ownerThread_(std::this_thread::get_id())
+    , pageSize_(static_cast<size_t>(::sysconf(_SC_PAGESIZE)))
+    , stackSize_(round_up_to_page(stackSize, pageSize_))
+    , mappingSize_(stackSize_ + pageSize_)
+    , maxCachedStacks_(maxCachedStacks)
+    , mappedCount_(0) {
+    freeStacks_.reserve(maxCachedStacks_);
+}
+
+CoroutineStackPool::~CoroutineStackPool() {
+    for (void* base : freeStacks_) {
+        unmap_stack(base);
+    }
+}
+
+boost::context::stack_context CoroutineStackPool::allocate() {
+    void* base = nullptr;
+    if (std::this_thread::get_id() == ownerThread_ && !freeStacks_.empty()) {
+        base = freeStacks_.back();
+        freeStacks_.pop_back();
+    }
+    else {
+        base = map_stack();
+    }
+
+    // 栈向低地址增长：sp 指向映射区末尾，保护页位于映射区起始处
+    boost::context::stack_context sctx;
+    sctx.size = mappingSize_;
+    sctx.sp = static_cast<char*>(base) + mappingSize_;
+    return sctx;
+}
+
+void CoroutineStackPool::deallocate(boost::context::stack_context& sctx) noexcept {
+    void* base = static_cast<char*>(sctx.sp) - sctx.size;
+
+    // 跨线程归还或缓存已满时直接释放映射，保证空闲链表只被归属线程访问
+    if (std::this_thread::get_id() != ownerThread_ || freeStacks_.size() >= maxCachedStacks_) {
+        unmap_stack(base);
+        return;
+    }
+
+    freeStacks_.push_back(base);
+}
+
+void* CoroutineStackPool::map_stack() {
+    void* base = ::mmap(nullptr, mappingSize_, PROT_READ | PROT_WRITE,
+                        MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE | MAP_STACK, -1, 0);
+    if (base == MAP_FAILED) {
+        spdlog::error("CoroutineStackPool: mmap failed, size={}, errno={} ({})", mappingSize_, errno, std::strerror(errno));
+        throw std::bad_alloc();
+    }
+
+    // 最低地址的一页设为不可访问，栈溢出会立刻以 SIGSEGV 暴露，而不是静默破坏相邻映射
+    if (::mprotect(base, pageSize_, PROT_NONE) != 0) {
+        spdlog::error("CoroutineStackPool: mprotect guard page failed, errno={} ({})", errno, std::strerror(errno));
+        ::munmap(base, mappingSize_);
+        throw std::bad_alloc();
+    }
+
+    mappedCount_.fetch_add(1, std::memory_order_relaxed);
+    return base;
+}
+
+void CoroutineStackPool::unmap_stack(void* base) const noexcept {
+    if (::munmap(base, mappingSize_) != 0) {
+        spdlog::warn("CoroutineStackPool: munmap failed, errno={} ({})", errno, std::strerror(errno));
+    }
+}
+
+} // namespace rpc
+} // namespace tudou
@@ -0,0 +1,90 @@
+/**
+ * @file CoroutineStackPool.h
+ * @brief 带保护页的协程栈池，以及适配 Boost.Context StackAllocator 概念的分配器
+ * @author wenxingming
+ * @project: https://github.com/WenXingming/Tudou
+ */
+
+#pragma once
+
+#include <boost/context/stack_context.hpp>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace tudou {
+namespace rpc {
+
+/**
+ * @brief 固定大小的协程栈池。
+ *        每个栈由一次 mmap 映射得到，最低地址处额外保留一页 PROT_NONE 保护页，栈溢出时直接触发 SIGSEGV 而不是踩坏相邻内存。
+ *        协程结束后栈不立即 munmap，而是缓存在空闲链表中供下一个协程复用，省掉 mmap/munmap 与首次触页的缺页开销。
+ *        栈池归属于创建它的线程（one loop per thread 下即所属 EventLoop），只有归属线程才会读写空闲链表，全程无锁。
+ */
+class CoroutineStackPool {
+public:
+    /**
+     * @param stackSize 单个协程栈的可用字节数（向上按页对齐，不含保护页）
+     * @param maxCachedStacks 空闲链表最多缓存的栈数量，超出部分直接归还内核
+     */
+    CoroutineStackPool(size_t stackSize, size_t maxCachedStacks);
+    ~CoroutineStackPool();
+
+    // 禁用拷贝构造和赋值
+    CoroutineStackPool(const CoroutineStackPool&) = delete;
+    CoroutineStackPool& operator=(const CoroutineStackPool&) = delete;
+
+    /**
+     * @brief 取出一个可用栈：优先复用空闲链表，为空时再新建映射。映射失败抛出 std::bad_alloc。
+     */
+    boost::context::stack_context allocate();
+
+    /**
+     * @brief 归还一个栈：归属线程内且未超过缓存上限时放回空闲链表，否则直接 munmap。
+     */
+    void deallocate(boost::context::stack_context& sctx) noexcept;
+
+    size_t stack_size() const { return stackSize_; }
+    size_t cached_stacks() const { return freeStacks_.size(); }
+    size_t mapped_count() const { return mappedCount_.load(std::memory_order_relaxed); } // 累计 mmap 次数，用于观察复用效果。
+
+private:
+    void* map_stack();
+    void unmap_stack(void* base) const noexcept;
+
+private:
+    const std::thread::id ownerThread_;     // 栈池归属线程，跨线程归还的栈不进入空闲链表。
+    const size_t pageSize_;                 // 系统页大小，同时也是保护页大小。
+    const size_t stackSize_;                // 按页对齐后的可用栈大小。
+    const size_t mappingSize_;              // 单次映射总大小（可用栈 + 保护页）。
+    const size_t maxCachedStacks_;          // 空闲链表容量上限。
+    std::vector<void*> freeStacks_;         // 空闲栈映射的起始地址（即保护页地址）。
+    std::atomic<size_t> mappedCount_;       // 累计新建映射次数。
+};
+
+/**
+ * @brief 满足 Boost.Context StackAllocator 概念的轻量分配器，把 allocate/deallocate 转发给共享的栈池。
+ *        持有栈池的 shared_ptr，保证即使线程已退出，存活协程归还栈时栈池依旧有效。
+ */
+class CoroutineStackAllocator {
+public:
+    explicit CoroutineStackAllocator(std::shared_ptr<CoroutineStackPool> pool)
+        : pool_(std::move(pool)) {
+    }
+
+    boost::context::stack_context allocate() {
+        return pool_->allocate();
+    }
+
+    void deallocate(boost::context::stack_context& sctx) noexcept {
+        pool_->deallocate(sctx);
+    }
+
+private:
+    std::shared_ptr<CoroutineStackPool> pool_;
+};
+
+} // namespace rpc
+} // namespace tudou
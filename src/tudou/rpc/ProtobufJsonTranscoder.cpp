@@ -0,0 +1,976 @@
+/**
+ * @file ProtobufJsonTranscoder.cpp
+ * @brief JSON 文本与 Protobuf Message 之间的直接转码器实现
+ * @author wenxingming
+ * @project: https://github.com/WenXingming/Tudou
+ */
+
+#include "ProtobufJsonTranscoder.h"
+
+#include <cerrno>
+#include <cfloat>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <unordered_set>
+#include <google/protobuf/descriptor.h>
+#include <google/protobuf/message.h>
+
+namespace tudou {
+namespace rpc {
+
+namespace {
+
+using google::protobuf::Descriptor;
+using google::protobuf::EnumValueDescriptor;
+using google::protobuf::FieldDescriptor;
+using google::protobuf::FileDescriptor;
+using google::protobuf::Message;
+using google::protobuf::Reflection;
+
+constexpr char kBase64Chars[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+bool supports_impl(const Descriptor* descriptor, std::unordered_set<const Descriptor*>& visited) {
+    if (!visited.insert(descriptor).second) {
+        return true; // 递归引用的类型已在检查中
+    }
+
+    const FileDescriptor* file = descriptor->file();
+    if (file->syntax() != FileDescriptor::SYNTAX_PROTO3 || file->name().compare(0, 16, "google/protobuf/") == 0) {
+        return false;
+    }
+
+    for (int i = 0; i < descriptor->field_count(); ++i) {
+        const FieldDescriptor* field = descriptor->field(i);
+        if (field->cpp_type() == FieldDescriptor::CPPTYPE_MESSAGE && !supports_impl(field->message_type(), visited)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// ---------------------------------------------------------------------------
+// 打印
+// ---------------------------------------------------------------------------
+
+void append_unsigned(uint64_t value, std::string& output) {
+    char digits[20];
+    int count = 0;
+    do {
+        digits[count++] = static_cast<char>('0' + value % 10);
+        value /= 10;
+    } while (value != 0);
+    while (count > 0) {
+        output.push_back(digits[--count]);
+    }
+}
+
+void append_signed(int64_t value, std::string& output) {
+    if (value < 0) {
+        output.push_back('-');
+        append_unsigned(0 - static_cast<uint64_t>(value), output);
+        return;
+    }
+    append_unsigned(static_cast<uint64_t>(value), output);
+}
+
+// 与 protobuf 的 SimpleDtoa / SimpleFtoa 一致：先用较短精度，不能往返时再用完整精度
+void append_double(double value, std::string& output) {
+    if (std::isnan(value)) {
+        output += "\"NaN\"";
+        return;
+    }
+    if (std::isinf(value)) {
+        output += value > 0 ? "\"Infinity\"" : "\"-Infinity\"";
+        return;
+    }
+
+    char buf[32];
+    int len = std::snprintf(buf, sizeof(buf), "%.15g", value);
+    if (std::strtod(buf, nullptr) != value) {
+        len = std::snprintf(buf, sizeof(buf), "%.17g", value);
+    }
+    output.append(buf, static_cast<size_t>(len));
+}
+
+void append_float(float value, std::string& output) {
+    if (std::isnan(value) || std::isinf(value)) {
+        append_double(value, output);
+        return;
+    }
+
+    char buf[32];
+    int len = std::snprintf(buf, sizeof(buf), "%.6g", static_cast<double>(value));
+    if (std::strtof(buf, nullptr) != value) {
+        len = std::snprintf(buf, sizeof(buf), "%.9g", static_cast<double>(value));
+    }
+    output.append(buf, static_cast<size_t>(len));
+}
+
+void append_escaped(const std::string& text, std::string& output) {
+    output.push_back('"');
+    const char* run = text.data();
+    const char* const end = text.data() + text.size();
+    for (const char* p = run; p != end; ++p) {
+        const unsigned char c = static_cast<unsigned char>(*p);
+        if (c >= 0x20 && c != '"' && c != '\\') {
+            continue;
+        }
+
+        output.append(run, static_cast<size_t>(p - run));
+        run = p + 1;
+        switch (c) {
+        case '"': output += "\\\""; break;
+        case '\\': output += "\\\\"; break;
+        case '\b': output += "\\b"; break;
+        case '\f': output += "\\f"; break;
+        case '\n': output += "\\n"; break;
+        case '\r': output += "\\r"; break;
+        case '\t': output += "\\t"; break;
+        default: {
+            char buf[8];
+            std::snprintf(buf, sizeof(buf), "\\u%04x", c);
+            output.append(buf, 6);
+            break;
+        }
+        }
+    }
+    output.append(run, static_cast<size_t>(end - run));
+    output.push_back('"');
+}
+
+void append_base64(const std::string& data, std::string& output) {
+    output.push_back('"');
+    const unsigned char* in = reinterpret_cast<const unsigned char*>(data.data());
+    size_t i = 0;
+    for (; i + 3 <= data.size(); i += 3) {
+        const uint32_t triple = (in[i] << 16) | (in[i + 1] << 8) | in[i + 2];
+        output.push_back(kBase64Chars[(triple >> 18) & 0x3F]);
+        output.push_back(kBase64Chars[(triple >> 12) & 0x3F]);
+        output.push_back(kBase64Chars[(triple >> 6) & 0x3F]);
+        output.push_back(kBase64Chars[triple & 0x3F]);
+    }
+    const size_t rest = data.size() - i;
+    if (rest > 0) {
+        uint32_t triple = in[i] << 16;
+        if (rest == 2) {
+            triple |= in[i + 1] << 8;
+        }
+        output.push_back(kBase64Chars[(triple >> 18) & 0x3F]);
+        output.push_back(kBase64Chars[(triple >> 12) & 0x3F]);
+        output.push_back(rest == 2 ? kBase64Chars[(triple >> 6) & 0x3F] : '=');
+        output.push_back('=');
+    }
+    output.push_back('"');
+}
+
+void print_message(const Message& message, std::string& output);
+
+// index < 0 表示单值字段，否则为 repeated 字段的下标
+void print_value(const Message& message, const Reflection* reflection, const FieldDescriptor* field, int index,
+    std::string& output) {
+    const bool repeated = index >= 0;
+    switch (field->cpp_type()) {
+    case FieldDescriptor::CPPTYPE_INT32:
+        append_signed(repeated ? reflection->GetRepeatedInt32(message, field, index) : reflection->GetInt32(message, field), output);
+        break;
+    case FieldDescriptor::CPPTYPE_UINT32:
+        append_unsigned(repeated ? reflection->GetRepeatedUInt32(message, field, index) : reflection->GetUInt32(message, field), output);
+        break;
+    case FieldDescriptor::CPPTYPE_INT64:
+        // 64 位整数超出 IEEE 754 双精度的安全整数范围，按 proto3 JSON 映射打印为字符串
+        output.push_back('"');
+        append_signed(repeated ? reflection->GetRepeatedInt64(message, field, index) : reflection->GetInt64(message, field), output);
+        output.push_back('"');
+        break;
+    case FieldDescriptor::CPPTYPE_UINT64:
+        output.push_back('"');
+        append_unsigned(repeated ? reflection->GetRepeatedUInt64(message, field, index) : reflection->GetUInt64(message, field), output);
+        output.push_back('"');
+        break;
+    case FieldDescriptor::CPPTYPE_DOUBLE:
+        append_double(repeated ? reflection->GetRepeatedDouble(message, field, index) : reflection->GetDouble(message, field), output);
+        break;
+    case FieldDescriptor::CPPTYPE_FLOAT:
+        append_float(repeated ? reflection->GetRepeatedFloat(message, field, index) : reflection->GetFloat(message, field), output);
+        break;
+    case FieldDescriptor::CPPTYPE_BOOL:
+        output += (repeated ? reflection->GetRepeatedBool(message, field, index) : reflection->GetBool(message, field)) ? "true" : "false";
+        break;
+    case FieldDescriptor::CPPTYPE_ENUM: {
+        const int number = repeated ? reflection->GetRepeatedEnumValue(message, field, index) : reflection->GetEnumValue(message, field);
+        const EnumValueDescriptor* value = field->enum_type()->FindValueByNumber(number);
+        if (value != nullptr) {
+            append_escaped(value->name(), output);
+        }
+        else {
+            append_signed(number, output); // proto3 开放枚举里未定义的值
+        }
+        break;
+    }
+    case FieldDescriptor::CPPTYPE_STRING: {
+        std::string scratch;
+        const std::string& text = repeated
+            ? reflection->GetRepeatedStringReference(message, field, index, &scratch)
+            : reflection->GetStringReference(message, field, &scratch);
+        if (field->type() == FieldDescriptor::TYPE_BYTES) {
+            append_base64(text, output);
+        }
+        else {
+            append_escaped(text, output);
+        }
+        break;
+    }
+    case FieldDescriptor::CPPTYPE_MESSAGE:
+        print_message(repeated ? reflection->GetRepeatedMessage(message, field, index) : reflection->GetMessage(message, field), output);
+        break;
+    }
+}
+
+// map 字段在反射层是 key = 1、value = 2 的 entry 消息列表，JSON 中打印为对象，键一律是字符串
+void print_map(const Message& message, const Reflection* reflection, const FieldDescriptor* field, std::string& output) {
+    const FieldDescriptor* keyField = field->message_type()->field(0);
+    const FieldDescriptor* valueField = field->message_type()->field(1);
+
+    output.push_back('{');
+    const int size = reflection->FieldSize(message, field);
+    for (int i = 0; i < size; ++i) {
+        if (i > 0) {
+            output.push_back(',');
+        }
+        const Message& entry = reflection->GetRepeatedMessage(message, field, i);
+        const Reflection* entryReflection = entry.GetReflection();
+        if (keyField->cpp_type() == FieldDescriptor::CPPTYPE_STRING) {
+            print_value(entry, entryReflection, keyField, -1, output);
+        }
+        else if (keyField->cpp_type() == FieldDescriptor::CPPTYPE_BOOL) {
+            output += entryReflection->GetBool(entry, keyField) ? "\"true\"" : "\"false\"";
+        }
+        else {
+            // 整数键：64 位键本身已带引号，32 位键补上引号
+            const bool quoted = keyField->cpp_type() == FieldDescriptor::CPPTYPE_INT64
+                || keyField->cpp_type() == FieldDescriptor::CPPTYPE_UINT64;
+            if (!quoted) {
+                output.push_back('"');
+            }
+            print_value(entry, entryReflection, keyField, -1, output);
+            if (!quoted) {
+                output.push_back('"');
+            }
+        }
+        output.push_back(':');
+        print_value(entry, entryReflection, valueField, -1, output);
+    }
+    output.push_back('}');
+}
+
+void print_message(const Message& message, std::string& output) {
+    const Descriptor* descriptor = message.GetDescriptor();
+    const Reflection* reflection = message.GetReflection();
+
+    output.push_back('{');
+    bool first = true;
+    for (int i = 0; i < descriptor->field_count(); ++i) {
+        const FieldDescriptor* field = descriptor->field(i);
+        // 与 always_print_primitive_fields 一致：标量与 repeated 即使为默认值也打印，消息字段、oneof 成员与 optional 字段只打印已设置的
+        if (!field->is_repeated() && field->has_presence() && !reflection->HasField(message, field)) {
+            continue;
+        }
+
+        if (!first) {
+            output.push_back(',');
+        }
+        first = false;
+        append_escaped(field->json_name(), output);
+        output.push_back(':');
+
+        if (field->is_map()) {
+            print_map(message, reflection, field, output);
+        }
+        else if (field->is_repeated()) {
+            output.push_back('[');
+            const int size = reflection->FieldSize(message, field);
+            for (int j = 0; j < size; ++j) {
+                if (j > 0) {
+                    output.push_back(',');
+                }
+                print_value(message, reflection, field, j, output);
+            }
+            output.push_back(']');
+        }
+        else {
+            print_value(message, reflection, field, -1, output);
+        }
+    }
+    output.push_back('}');
+}
+
+// ---------------------------------------------------------------------------
+// 解析
+// ---------------------------------------------------------------------------
+
+int base64_value(char c) {
+    if (c >= 'A' && c <= 'Z') return c - 'A';
+    if (c >= 'a' && c <= 'z') return c - 'a' + 26;
+    if (c >= '0' && c <= '9') return c - '0' + 52;
+    if (c == '+' || c == '-') return 62; // 同时接受标准与 URL 安全字母表
+    if (c == '/' || c == '_') return 63;
+    return -1;
+}
+
+bool base64_decode(const std::string& text, std::string& output) {
+    size_t len = text.size();
+    while (len > 0 && text[len - 1] == '=') {
+        --len;
+    }
+    if (len % 4 == 1 || text.size() - len > 2) {
+        return false;
+    }
+
+    output.clear();
+    output.reserve(len * 3 / 4);
+    uint32_t buffer = 0;
+    int bits = 0;
+    for (size_t i = 0; i < len; ++i) {
+        const int value = base64_value(text[i]);
+        if (value < 0) {
+            return false;
+        }
+        buffer = (buffer << 6) | static_cast<uint32_t>(value);
+        bits += 6;
+        if (bits >= 8) {
+            bits -= 8;
+            output.push_back(static_cast<char>((buffer >> bits) & 0xFF));
+        }
+    }
+    return true;
+}
+
+void append_utf8(uint32_t codePoint, std::string& output) {
+    if (codePoint < 0x80) {
+        output.push_back(static_cast<char>(codePoint));
+    }
+    else if (codePoint < 0x800) {
+        output.push_back(static_cast<char>(0xC0 | (codePoint >> 6)));
+        output.push_back(static_cast<char>(0x80 | (codePoint & 0x3F)));
+    }
+    else if (codePoint < 0x10000) {
+        output.push_back(static_cast<char>(0xE0 | (codePoint >> 12)));
+        output.push_back(static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F)));
+        output.push_back(static_cast<char>(0x80 | (codePoint & 0x3F)));
+    }
+    else {
+        output.push_back(static_cast<char>(0xF0 | (codePoint >> 18)));
+        output.push_back(static_cast<char>(0x80 | ((codePoint >> 12) & 0x3F)));
+        output.push_back(static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F)));
+        output.push_back(static_cast<char>(0x80 | (codePoint & 0x3F)));
+    }
+}
+
+// 数字文本（可能来自带引号的字符串）转整数，整数形式之外也接受值为整数的小数或指数形式，如 "1e3"
+bool text_to_int64(const char* text, size_t len, int64_t& value) {
+    char buf[64];
+    if (len == 0 || len >= sizeof(buf) || text[0] == '+') {
+        return false;
+    }
+    std::memcpy(buf, text, len);
+    buf[len] = '\0';
+    if (std::strspn(buf, "+-.eE0123456789") != len) {
+        return false;
+    }
+
+    char* end = nullptr;
+    errno = 0;
+    const long long integer = std::strtoll(buf, &end, 10);
+    if (end == buf + len && errno == 0) {
+        value = integer;
+        return true;
+    }
+
+    const double number = std::strtod(buf, &end);
+    if (end != buf + len || number != std::trunc(number) || number < -9223372036854775808.0 || number >= 9223372036854775808.0) {
+        return false;
+    }
+    value = static_cast<int64_t>(number);
+    return true;
+}
+
+bool text_to_uint64(const char* text, size_t len, uint64_t& value) {
+    char buf[64];
+    if (len == 0 || len >= sizeof(buf) || text[0] == '+' || text[0] == '-') {
+        return false;
+    }
+    std::memcpy(buf, text, len);
+    buf[len] = '\0';
+    if (std::strspn(buf, "+-.eE0123456789") != len) {
+        return false;
+    }
+
+    char* end = nullptr;
+    errno = 0;
+    const unsigned long long integer = std::strtoull(buf, &end, 10);
+    if (end == buf + len && errno == 0) {
+        value = integer;
+        return true;
+    }
+
+    const double number = std::strtod(buf, &end);
+    if (end != buf + len || number != std::trunc(number) || number < 0 || number >= 18446744073709551616.0) {
+        return false;
+    }
+    value = static_cast<uint64_t>(number);
+    return true;
+}
+
+bool text_to_double(const char* text, size_t len, double& value) {
+    char buf[64];
+    if (len == 0 || len >= sizeof(buf)) {
+        return false;
+    }
+    std::memcpy(buf, text, len);
+    buf[len] = '\0';
+
+    if (std::strcmp(buf, "NaN") == 0) {
+        value = std::nan("");
+        return true;
+    }
+    if (std::strcmp(buf, "Infinity") == 0 || std::strcmp(buf, "-Infinity") == 0) {
+        value = buf[0] == '-' ? -HUGE_VAL : HUGE_VAL;
+        return true;
+    }
+
+    // strtod 还接受 "inf"、"nan" 与十六进制，JSON 数字只含这些字符
+    if (std::strspn(buf, "+-.eE0123456789") != len) {
+        return false;
+    }
+    char* end = nullptr;
+    errno = 0;
+    value = std::strtod(buf, &end);
+    return end == buf + len && errno != ERANGE;
+}
+
+// 单遍递归下降解析器，边解析边通过反射写入 Message，失败时记录第一个错误及其偏移
+class JsonReader {
+public:
+    JsonReader(const char* data, size_t len) : begin_(data), pos_(data), end_(data + len) {}
+
+    bool parse_root(Message* message) {
+        skip_whitespace();
+        if (!consume_literal("null") && !parse_message(message, 0)) {
+            return false;
+        }
+        skip_whitespace();
+        return pos_ == end_ || fail("unexpected trailing characters");
+    }
+
+    const std::string& error() const { return error_; }
+
+private:
+    bool fail(const char* reason) {
+        if (error_.empty()) {
+            error_ = std::string(reason) + " at offset " + std::to_string(pos_ - begin_);
+        }
+        return false;
+    }
+
+    void skip_whitespace() {
+        while (pos_ != end_ && (*pos_ == ' ' || *pos_ == '\t' || *pos_ == '\n' || *pos_ == '\r')) {
+            ++pos_;
+        }
+    }
+
+    bool consume(char c) {
+        if (pos_ != end_ && *pos_ == c) {
+            ++pos_;
+            return true;
+        }
+        return false;
+    }
+
+    bool consume_literal(const char* literal) {
+        const size_t len = std::strlen(literal);
+        if (static_cast<size_t>(end_ - pos_) >= len && std::memcmp(pos_, literal, len) == 0) {
+            pos_ += len;
+            return true;
+        }
+        return false;
+    }
+
+    bool parse_hex4(uint32_t& value) {
+        if (end_ - pos_ < 4) {
+            return fail("truncated unicode escape");
+        }
+        value = 0;
+        for (int i = 0; i < 4; ++i) {
+            const char c = *pos_++;
+            value <<= 4;
+            if (c >= '0' && c <= '9') value |= static_cast<uint32_t>(c - '0');
+            else if (c >= 'a' && c <= 'f') value |= static_cast<uint32_t>(c - 'a' + 10);
+            else if (c >= 'A' && c <= 'F') value |= static_cast<uint32_t>(c - 'A' + 10);
+            else return fail("invalid unicode escape");
+        }
+        return true;
+    }
+
+    bool parse_string(std::string& output) {
+        if (!consume('"')) {
+            return fail("expected string");
+        }
+        output.clear();
+        for (;;) {
+            const char* run = pos_;
+            while (pos_ != end_ && *pos_ != '"' && *pos_ != '\\' && static_cast<unsigned char>(*pos_) >= 0x20) {
+                ++pos_;
+            }
+            output.append(run, static_cast<size_t>(pos_ - run));
+            if (pos_ == end_) {
+                return fail("unterminated string");
+            }
+            if (*pos_ == '"') {
+                ++pos_;
+                return true;
+            }
+            if (*pos_ != '\\') {
+                return fail("control character in string");
+            }
+
+            ++pos_;
+            if (pos_ == end_) {
+                return fail("unterminated string");
+            }
+            const char escape = *pos_++;
+            switch (escape) {
+            case '"': output.push_back('"'); break;
+            case '\\': output.push_back('\\'); break;
+            case '/': output.push_back('/'); break;
+            case 'b': output.push_back('\b'); break;
+            case 'f': output.push_back('\f'); break;
+            case 'n': output.push_back('\n'); break;
+            case 'r': output.push_back('\r'); break;
+            case 't': output.push_back('\t'); break;
+            case 'u': {
+                uint32_t codePoint = 0;
+                if (!parse_hex4(codePoint)) {
+                    return false;
+                }
+                if (codePoint >= 0xD800 && codePoint <= 0xDBFF) {
+                    uint32_t low = 0;
+                    if (!consume('\\') || !consume('u') || !parse_hex4(low) || low < 0xDC00 || low > 0xDFFF) {
+                        return fail("invalid surrogate pair");
+                    }
+                    codePoint = 0x10000 + ((codePoint - 0xD800) << 10) + (low - 0xDC00);
+                }
+                else if (codePoint >= 0xDC00 && codePoint <= 0xDFFF) {
+                    return fail("invalid surrogate pair");
+                }
+                append_utf8(codePoint, output);
+                break;
+            }
+            default:
+                return fail("invalid escape");
+            }
+        }
+    }
+
+    // 数值字段的取值：裸数字直接返回原文区间，带引号的数字先反转义到 scratch_
+    bool read_number_text(const char*& text, size_t& len) {
+        if (pos_ != end_ && *pos_ == '"') {
+            if (!parse_string(scratch_)) {
+                return false;
+            }
+            text = scratch_.data();
+            len = scratch_.size();
+            return true;
+        }
+
+        text = pos_;
+        while (pos_ != end_ && std::strchr("+-.eE0123456789", *pos_) != nullptr && *pos_ != '\0') {
+            ++pos_;
+        }
+        len = static_cast<size_t>(pos_ - text);
+        return len > 0 || fail("expected number");
+    }
+
+    bool skip_value(int depth) {
+        if (depth > ProtobufJsonTranscoder::kMaxDepth) {
+            return fail("nesting too deep");
+        }
+        skip_whitespace();
+        if (pos_ == end_) {
+            return fail("unexpected end of input");
+        }
+
+        switch (*pos_) {
+        case '"':
+            return parse_string(scratch_);
+        case '{':
+        case '[': {
+            const bool object = (*pos_++ == '{');
+            const char close = object ? '}' : ']';
+            skip_whitespace();
+            if (consume(close)) {
+                return true;
+            }
+            for (;;) {
+                skip_whitespace();
+                if (object) {
+                    if (!parse_string(scratch_)) {
+                        return false;
+                    }
+                    skip_whitespace();
+                    if (!consume(':')) {
+                        return fail("expected ':'");
+                    }
+                }
+                if (!skip_value(depth + 1)) {
+                    return false;
+                }
+                skip_whitespace();
+                if (consume(',')) {
+                    continue;
+                }
+                return consume(close) || fail(object ? "expected ',' or '}'" : "expected ',' or ']'");
+            }
+        }
+        default:
+            if (consume_literal("true") || consume_literal("false") || consume_literal("null")) {
+                return true;
+            }
+            const char* text = nullptr;
+            size_t len = 0;
+            double ignored = 0;
+            return read_number_text(text, len) && (text_to_double(text, len, ignored) || fail("invalid number"));
+        }
+    }
+
+    static const FieldDescriptor* find_field(const Descriptor* descriptor, const std::string& key) {
+        // 字段名同时接受 json_name（lowerCamelCase）与 .proto 中的原名。默认 json_name 即 camelcase 名，
+        // 先走描述符自带的哈希索引；只有未知键或显式指定了 json_name 的字段才退回逐个比较
+        const FieldDescriptor* field = descriptor->FindFieldByCamelcaseName(key);
+        if (field != nullptr && field->json_name() == key) {
+            return field;
+        }
+        field = descriptor->FindFieldByName(key);
+        if (field != nullptr) {
+            return field;
+        }
+        for (int i = 0; i < descriptor->field_count(); ++i) {
+            if (descriptor->field(i)->json_name() == key) {
+                return descriptor->field(i);
+            }
+        }
+        return nullptr;
+    }
+
+    bool parse_message(Message* message, int depth) {
+        if (depth > ProtobufJsonTranscoder::kMaxDepth) {
+            return fail("nesting too deep");
+        }
+        if (!consume('{')) {
+            return fail("expected object");
+        }
+        skip_whitespace();
+        if (consume('}')) {
+            return true;
+        }
+
+        const Descriptor* descriptor = message->GetDescriptor();
+        std::string key;
+        for (;;) {
+            skip_whitespace();
+            if (!parse_string(key)) {
+                return false;
+            }
+            skip_whitespace();
+            if (!consume(':')) {
+                return fail("expected ':'");
+            }
+            skip_whitespace();
+
+            const FieldDescriptor* field = find_field(descriptor, key);
+            if (field == nullptr ? !skip_value(depth + 1) : !parse_field(message, field, depth + 1)) {
+                return false;
+            }
+
+            skip_whitespace();
+            if (consume(',')) {
+                continue;
+            }
+            return consume('}') || fail("expected ',' or '}'");
+        }
+    }
+
+    bool parse_field(Message* message, const FieldDescriptor* field, int depth) {
+        if (consume_literal("null")) {
+            message->GetReflection()->ClearField(message, field);
+            return true;
+        }
+        if (field->is_map()) {
+            return parse_map(message, field, depth);
+        }
+        if (!field->is_repeated()) {
+            return parse_value(message, field, false, depth);
+        }
+
+        if (!consume('[')) {
+            return fail("expected array");
+        }
+        skip_whitespace();
+        if (consume(']')) {
+            return true;
+        }
+        for (;;) {
+            skip_whitespace();
+            if (consume_literal("null")) {
+                return fail("null is not allowed in repeated field");
+            }
+            if (!parse_value(message, field, true, depth)) {
+                return false;
+            }
+            skip_whitespace();
+            if (consume(',')) {
+                continue;
+            }
+            return consume(']') || fail("expected ',' or ']'");
+        }
+    }
+
+    bool parse_map(Message* message, const FieldDescriptor* field, int depth) {
+        if (!consume('{')) {
+            return fail("expected object");
+        }
+        skip_whitespace();
+        if (consume('}')) {
+            return true;
+        }
+
+        const Reflection* reflection = message->GetReflection();
+        const FieldDescriptor* keyField = field->message_type()->field(0);
+        const FieldDescriptor* valueField = field->message_type()->field(1);
+        std::string key;
+        for (;;) {
+            skip_whitespace();
+            if (!parse_string(key)) {
+                return false;
+            }
+            skip_whitespace();
+            if (!consume(':')) {
+                return fail("expected ':'");
+            }
+            skip_whitespace();
+
+            Message* entry = reflection->AddMessage(message, field);
+            if (!set_map_key(entry, keyField, key)) {
+                return false;
+            }
+            if (consume_literal("null")) {
+                // 值为 null 时保留默认值
+            }
+            else if (!parse_value(entry, valueField, false, depth + 1)) {
+                return false;
+            }
+
+            skip_whitespace();
+            if (consume(',')) {
+                continue;
+            }
+            return consume('}') || fail("expected ',' or '}'");
+        }
+    }
+
+    bool set_map_key(Message* entry, const FieldDescriptor* keyField, const std::string& key) {
+        const Reflection* reflection = entry->GetReflection();
+        int64_t signedKey = 0;
+        uint64_t unsignedKey = 0;
+        switch (keyField->cpp_type()) {
+        case FieldDescriptor::CPPTYPE_STRING:
+            reflection->SetString(entry, keyField, key);
+            return true;
+        case FieldDescriptor::CPPTYPE_BOOL:
+            if (key != "true" && key != "false") {
+                return fail("invalid bool map key");
+            }
+            reflection->SetBool(entry, keyField, key == "true");
+            return true;
+        case FieldDescriptor::CPPTYPE_INT32:
+            if (!text_to_int64(key.data(), key.size(), signedKey) || signedKey < INT32_MIN || signedKey > INT32_MAX) {
+                return fail("invalid int32 map key");
+            }
+            reflection->SetInt32(entry, keyField, static_cast<int32_t>(signedKey));
+            return true;
+        case FieldDescriptor::CPPTYPE_INT64:
+            if (!text_to_int64(key.data(), key.size(), signedKey)) {
+                return fail("invalid int64 map key");
+            }
+            reflection->SetInt64(entry, keyField, signedKey);
+            return true;
+        case FieldDescriptor::CPPTYPE_UINT32:
+            if (!text_to_uint64(key.data(), key.size(), unsignedKey) || unsignedKey > UINT32_MAX) {
+                return fail("invalid uint32 map key");
+            }
+            reflection->SetUInt32(entry, keyField, static_cast<uint32_t>(unsignedKey));
+            return true;
+        case FieldDescriptor::CPPTYPE_UINT64:
+            if (!text_to_uint64(key.data(), key.size(), unsignedKey)) {
+                return fail("invalid uint64 map key");
+            }
+            reflection->SetUInt64(entry, keyField, unsignedKey);
+            return true;
+        default:
+            return fail("unsupported map key type");
+        }
+    }
+
+    bool parse_value(Message* message, const FieldDescriptor* field, bool repeated, int depth) {
+        const Reflection* reflection = message->GetReflection();
+        const char* text = nullptr;
+        size_t len = 0;
+        int64_t signedValue = 0;
+        uint64_t unsignedValue = 0;
+        double doubleValue = 0;
+
+        switch (field->cpp_type()) {
+        case FieldDescriptor::CPPTYPE_MESSAGE:
+            return parse_message(repeated ? reflection->AddMessage(message, field) : reflection->MutableMessage(message, field), depth);
+
+        case FieldDescriptor::CPPTYPE_STRING: {
+            std::string value;
+            if (!parse_string(value)) {
+                return false;
+            }
+            if (field->type() == FieldDescriptor::TYPE_BYTES) {
+                std::string decoded;
+                if (!base64_decode(value, decoded)) {
+                    return fail("invalid base64");
+                }
+                value.swap(decoded);
+            }
+            if (repeated) {
+                reflection->AddString(message, field, std::move(value));
+            }
+            else {
+                reflection->SetString(message, field, std::move(value));
+            }
+            return true;
+        }
+
+        case FieldDescriptor::CPPTYPE_BOOL: {
+            bool value = false;
+            if (consume_literal("true")) {
+                value = true;
+            }
+            else if (!consume_literal("false")) {
+                return fail("expected bool");
+            }
+            repeated ? reflection->AddBool(message, field, value) : reflection->SetBool(message, field, value);
+            return true;
+        }
+
+        case FieldDescriptor::CPPTYPE_ENUM: {
+            int number = 0;
+            if (pos_ != end_ && *pos_ == '"') {
+                if (!parse_string(scratch_)) {
+                    return false;
+                }
+                const EnumValueDescriptor* value = field->enum_type()->FindValueByName(scratch_);
+                if (value == nullptr) {
+                    return true; // 与 ignore_unknown_fields 一致：不认识的枚举名按未知字段忽略
+                }
+                number = value->number();
+            }
+            else {
+                if (!read_number_text(text, len) || !text_to_int64(text, len, signedValue)
+                    || signedValue < INT32_MIN || signedValue > INT32_MAX) {
+                    return fail("invalid enum value");
+                }
+                number = static_cast<int>(signedValue);
+            }
+            repeated ? reflection->AddEnumValue(message, field, number) : reflection->SetEnumValue(message, field, number);
+            return true;
+        }
+
+        case FieldDescriptor::CPPTYPE_INT32:
+            if (!read_number_text(text, len) || !text_to_int64(text, len, signedValue)
+                || signedValue < INT32_MIN || signedValue > INT32_MAX) {
+                return fail("invalid int32 value");
+            }
+            repeated ? reflection->AddInt32(message, field, static_cast<int32_t>(signedValue))
+                     : reflection->SetInt32(message, field, static_cast<int32_t>(signedValue));
+            return true;
+
+        case FieldDescriptor::CPPTYPE_INT64:
+            if (!read_number_text(text, len) || !text_to_int64(text, len, signedValue)) {
+                return fail("invalid int64 value");
+            }
+            repeated ? reflection->AddInt64(message, field, signedValue) : reflection->SetInt64(message, field, signedValue);
+            return true;
+
+        case FieldDescriptor::CPPTYPE_UINT32:
+            if (!read_number_text(text, len) || !text_to_uint64(text, len, unsignedValue) || unsignedValue > UINT32_MAX) {
+                return fail("invalid uint32 value");
+            }
+            repeated ? reflection->AddUInt32(message, field, static_cast<uint32_t>(unsignedValue))
+                     : reflection->SetUInt32(message, field, static_cast<uint32_t>(unsignedValue));
+            return true;
+
+        case FieldDescriptor::CPPTYPE_UINT64:
+            if (!read_number_text(text, len) || !text_to_uint64(text, len, unsignedValue)) {
+                return fail("invalid uint64 value");
+            }
+            repeated ? reflection->AddUInt64(message, field, unsignedValue) : reflection->SetUInt64(message, field, unsignedValue);
+            return true;
+
+        case FieldDescriptor::CPPTYPE_DOUBLE:
+            if (!read_number_text(text, len) || !text_to_double(text, len, doubleValue)) {
+                return fail("invalid double value");
+            }
+            repeated ? reflection->AddDouble(message, field, doubleValue) : reflection->SetDouble(message, field, doubleValue);
+            return true;
+
+        case FieldDescriptor::CPPTYPE_FLOAT:
+            if (!read_number_text(text, len) || !text_to_double(text, len, doubleValue)
+                || (std::isfinite(doubleValue) && std::fabs(doubleValue) > FLT_MAX)) {
+                return fail("invalid float value");
+            }
+            repeated ? reflection->AddFloat(message, field, static_cast<float>(doubleValue))
+                     : reflection->SetFloat(message, field, static_cast<float>(doubleValue));
+            return true;
+        }
+        return fail("unsupported field type");
+    }
+
+private:
+    const char* const begin_;
+    const char* pos_;
+    const char* const end_;
+    std::string scratch_;   // 被跳过的字符串、带引号的数字与枚举名的临时存放
+    std::string error_;
+};
+
+} // namespace
+
+bool ProtobufJsonTranscoder::supports(const google::protobuf::Descriptor* descriptor) {
+    std::unordered_set<const Descriptor*> visited;
+    return descriptor != nullptr && supports_impl(descriptor, visited);
+}
+
+bool ProtobufJsonTranscoder::parse(const char* data, size_t len, google::protobuf::Message* message, std::string* error) {
+    message->Clear();
+    JsonReader reader(data, len);
+    if (reader.parse_root(message)) {
+        return true;
+    }
+    if (error != nullptr) {
+        *error = reader.error();
+    }
+    return false;
+}
+
+void ProtobufJsonTranscoder::print(const google::protobuf::Message& message, std::string& output) {
+    print_message(message, output);
+}
+
+} // namespace rpc
+} // namespace tudou
@@ -0,0 +1,54 @@
+/**
+ * @file ProtobufJsonTranscoder.h
+ * @brief JSON 文本与 Protobuf Message 之间的直接转码器声明
+ * @author wenxingming
+ * @project: https://github.com/WenXingming/Tudou
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+namespace google {
+namespace protobuf {
+class Descriptor;
+class Message;
+} // namespace protobuf
+} // namespace google
+
+namespace tudou {
+namespace rpc {
+
+/**
+ * @brief 基于 Protobuf 反射的 JSON 转码：解析时直接在 JSON 文本区间上逐字段写入 Message，
+ *        打印时直接把字段追加到输出缓冲，不经过 protobuf 自带 JSON 工具的“二进制序列化 + TypeResolver + 对象流”中转。
+ *        输出与 util::MessageToJsonString（always_print_primitive_fields = true）的 JSON 语义一致：
+ *        字段名用 json_name，64 位整数打印为字符串，bytes 为 Base64，枚举打印为名称。
+ *        只覆盖 proto3 的普通消息，引用 google/protobuf/ 下知名类型（Any、Timestamp、Struct 等）的消息需回退到 protobuf 自带工具。
+ */
+class ProtobufJsonTranscoder {
+public:
+    // 解析时允许的最大嵌套深度，超出即视为非法输入
+    static constexpr int kMaxDepth = 64;
+
+    /**
+     * @brief 该消息类型及其引用的全部消息类型是否都能由本转码器处理
+     */
+    static bool supports(const google::protobuf::Descriptor* descriptor);
+
+    /**
+     * @brief 把 [data, data + len) 上的 JSON 对象解析进 message（先清空）。未知字段被忽略，"null" 视为空对象。
+     * @param error 失败时写入原因及出错的字节偏移，可为空
+     * @return 解析成功返回 true
+     */
+    static bool parse(const char* data, size_t len, google::protobuf::Message* message, std::string* error);
+
+    /**
+     * @brief 把 message 打印为紧凑 JSON 追加到 output
+     */
+    static void print(const google::protobuf::Message& message, std::string& output);
+};
+
+} // namespace rpc
+} // namespace tudou
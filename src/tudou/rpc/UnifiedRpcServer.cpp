@@ -6,16 +6,43 @@
  */
 
 #include "UnifiedRpcServer.h"
+#include "ProtobufJsonTranscoder.h"
 #include "tudou/rpc/binary/BinaryRpcServer.h"
 #include "tudou/rpc/json/JsonRpcServer.h"
 #include <google/protobuf/util/json_util.h>
 #include <spdlog/spdlog.h>
+#include <condition_variable>
+#include <cstring>
+#include <mutex>
 #include <stdexcept>
-#include <future>
 
 namespace tudou {
 namespace rpc {
 
+namespace {
+
+// 供 JSON 桥接等待业务完成的 Closure：只有一次 Run，同步完成时加解锁一次即可，不再为每次调用分配 promise 共享状态
+class BridgeClosure : public google::protobuf::Closure {
+public:
+    void Run() override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        done_ = true;
+        cond_.notify_one();
+    }
+
+    void wait() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        cond_.wait(lock, [this]() { return done_; });
+    }
+
+private:
+    std::mutex mutex_;
+    std::condition_variable cond_;
+    bool done_ = false;
+};
+
+} // namespace
+
 UnifiedRpcServer::UnifiedRpcServer(const std::string& ip, uint16_t binaryPort, uint16_t jsonPort, int numThreads)
     : ip_(ip), binaryPort_(binaryPort), jsonPort_(jsonPort) {
     
@@ -25,6 +52,11 @@ UnifiedRpcServer::UnifiedRpcServer(const std::string& ip, uint16_t binaryPort, u
 
     binaryServer_ = std::make_unique<binary::BinaryRpcServer>(ip, binaryPort, binaryThreads);
     jsonServer_ = std::make_unique<JsonRpcServer>(ip, jsonPort, jsonThreads);
+
+    // 桥接方法都以原始文本处理器注册：OnDemand 后端下 params 文本直接交给 Protobuf 解析，不经过 nlohmann DOM
+    if (JsonRpcRouter::is_backend_available(JsonRpcRouter::Backend::OnDemand)) {
+        jsonServer_->set_json_backend(JsonRpcRouter::Backend::OnDemand);
+    }
 }
 
 UnifiedRpcServer::~UnifiedRpcServer() {
@@ -51,53 +83,7 @@ void UnifiedRpcServer::register_service(std::shared_ptr<google::protobuf::Servic
         // 生成完整的方法限定名作为 JSON-RPC 映射方法名，如 "tudou.rpc.binary.test.TestEchoService.Echo"
         std::string fullMethodName = serviceName + "." + method->name();
 
-        jsonServer_->register_method(fullMethodName, [service, method](const nlohmann::json& params) -> nlohmann::json {
-            // A. 实例化动态请求及响应 Message 对象
-            std::unique_ptr<google::protobuf::Message> request(service->GetRequestPrototype(method).New());
-            std::unique_ptr<google::protobuf::Message> response(service->GetResponsePrototype(method).New());
-
-            // B. 转换 JSON 参数为 Protobuf Request
-            std::string jsonStr = params.is_null() ? "{}" : params.dump();
-            google::protobuf::util::JsonParseOptions parseOptions;
-            parseOptions.ignore_unknown_fields = true;
-
-            auto parseStatus = google::protobuf::util::JsonStringToMessage(jsonStr, request.get(), parseOptions);
-            if (!parseStatus.ok()) {
-                throw std::invalid_argument("UnifiedRpcServer: Failed to parse JSON to Protobuf request: " + parseStatus.ToString());
-            }
-
-            // C. 派发业务，并通过 promise/future 同步等待调用完成
-            struct SyncClosure : public google::protobuf::Closure {
-                std::promise<void> promise;
-                void Run() override {
-                    promise.set_value();
-                }
-            };
-
-            SyncClosure doneClosure;
-            auto doneFuture = doneClosure.promise.get_future();
-
-            try {
-                service->CallMethod(method, nullptr, request.get(), response.get(), &doneClosure);
-                doneFuture.wait();
-            }
-            catch (const std::exception& e) {
-                spdlog::error("UnifiedRpcServer: Exception caught in service execution: {}", e.what());
-                throw;
-            }
-
-            // D. 转换 Protobuf Response 回 JSON 并返回
-            std::string responseJsonStr;
-            google::protobuf::util::JsonPrintOptions printOptions;
-            printOptions.always_print_primitive_fields = true;
-
-            auto printStatus = google::protobuf::util::MessageToJsonString(*response, &responseJsonStr, printOptions);
-            if (!printStatus.ok()) {
-                throw std::runtime_error("UnifiedRpcServer: Failed to print Protobuf response to JSON: " + printStatus.ToString());
-            }
-
-            return nlohmann::json::parse(responseJsonStr);
-        });
+        jsonServer_->register_raw_method(fullMethodName, make_json_bridge(service, method));
 
         spdlog::info("UnifiedRpcServer: Dynamically bridged method={}", fullMethodName);
     }
@@ -128,6 +114,63 @@ void UnifiedRpcServer::stop() {
     }
 }
 
+JsonRpcRouter::RawRpcHandler UnifiedRpcServer::make_json_bridge(std::shared_ptr<google::protobuf::Service> service,
+    const google::protobuf::MethodDescriptor* method) {
+    // 请求与响应类型都能由 ProtobufJsonTranscoder 处理时直接转码，否则（如引用了 Any、Timestamp 等知名类型）回退到 protobuf 自带的 JSON 工具
+    const bool direct = ProtobufJsonTranscoder::supports(method->input_type())
+        && ProtobufJsonTranscoder::supports(method->output_type());
+
+    return [service, method, direct](const char* params, size_t len, std::string& result) {
+        // A. 实例化动态请求及响应 Message 对象
+        std::unique_ptr<google::protobuf::Message> request(service->GetRequestPrototype(method).New());
+        std::unique_ptr<google::protobuf::Message> response(service->GetResponsePrototype(method).New());
+
+        // B. 直接在 params 的原始文本上转换出 Protobuf Request，缺省 params 视为空对象，未知字段被忽略
+        if (direct) {
+            std::string error;
+            if (!ProtobufJsonTranscoder::parse(params, len, request.get(), &error)) {
+                throw std::invalid_argument("UnifiedRpcServer: Failed to parse JSON to Protobuf request: " + error);
+            }
+        }
+        else {
+            if (len == 4 && std::memcmp(params, "null", 4) == 0) {
+                params = "{}";
+                len = 2;
+            }
+            google::protobuf::util::JsonParseOptions parseOptions;
+            parseOptions.ignore_unknown_fields = true;
+            auto parseStatus = google::protobuf::util::JsonStringToMessage({ params, len }, request.get(), parseOptions);
+            if (!parseStatus.ok()) {
+                throw std::invalid_argument("UnifiedRpcServer: Failed to parse JSON to Protobuf request: " + parseStatus.ToString());
+            }
+        }
+
+        // C. 派发业务。同步完成的 Service 在 CallMethod 返回前已执行 done，wait 直接返回；异步完成时才真正阻塞
+        BridgeClosure doneClosure;
+        try {
+            service->CallMethod(method, nullptr, request.get(), response.get(), &doneClosure);
+            doneClosure.wait();
+        }
+        catch (const std::exception& e) {
+            spdlog::error("UnifiedRpcServer: Exception caught in service execution: {}", e.what());
+            throw;
+        }
+
+        // D. Protobuf Response 直接打印追加到输出缓冲，失败时由路由回滚已追加的内容
+        if (direct) {
+            ProtobufJsonTranscoder::print(*response, result);
+            return;
+        }
+
+        google::protobuf::util::JsonPrintOptions printOptions;
+        printOptions.always_print_primitive_fields = true;
+        auto printStatus = google::protobuf::util::MessageToJsonString(*response, &result, printOptions);
+        if (!printStatus.ok()) {
+            throw std::runtime_error("UnifiedRpcServer: Failed to print Protobuf response to JSON: " + printStatus.ToString());
+        }
+    };
+}
+
 uint16_t UnifiedRpcServer::get_binary_port() const {
     return binaryServer_->get_listen_port();
 }
@@ -11,6 +11,7 @@
 #include <string>
 #include <thread>
 #include <google/protobuf/service.h>
+#include "tudou/rpc/json/JsonRpcRouter.h"
 
 class JsonRpcServer;
 
@@ -49,6 +50,16 @@ public:
      */
     void register_service(std::shared_ptr<google::protobuf::Service> service);
 
+    /**
+     * @brief 生成把 JSON-RPC 调用桥接到 Protobuf Service 方法的原始文本处理器。
+     *        params 文本由 ProtobufJsonTranscoder 直接解析为请求 Message，响应 Message 直接打印追加到输出缓冲，
+     *        中间不经过 nlohmann DOM；转码器不支持的类型回退到 protobuf 自带的 JSON 工具。
+     * @param service 提供该方法的 Service 实例
+     * @param method 该 Service 描述符中的方法
+     */
+    static JsonRpcRouter::RawRpcHandler make_json_bridge(std::shared_ptr<google::protobuf::Service> service,
+        const google::protobuf::MethodDescriptor* method);
+
     /**
      * @brief 启动双轨服务端。
      *        此调用会阻塞当前线程（因为接管了主 Reactor 的 EventLoop）。
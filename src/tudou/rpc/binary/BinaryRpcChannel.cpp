@@ -6,44 +6,116 @@
  */
 
 #include "BinaryRpcChannel.h"
+#include "BinaryRpcClientLoopPool.h"
+#include "BinaryRpcController.h"
+#include "BinaryRpcShmTransport.h"
 #include "tudou/rpc/binary/BinaryRpcCodec.h"
 #include "tudou/reactor/Channel.h"
 #include "tudou/reactor/EventLoop.h"
 #include "binary_rpc.pb.h"
+#include <google/protobuf/descriptor.h>
 
 #include <sys/socket.h>
 #include <netinet/in.h>
+#include <netinet/tcp.h>
 #include <arpa/inet.h>
 #include <unistd.h>
 #include <fcntl.h>
+#include <sys/uio.h>
+#include <cerrno>
+#include <algorithm>
 #include <cstring>
+#include <limits>
 #include <stdexcept>
+#include <vector>
 #include <spdlog/spdlog.h>
 
 namespace tudou {
 namespace rpc {
 namespace binary {
 
+namespace {
+
+constexpr int kMaxFramesPerWritev = 64; // 单次 writev 最多携带的帧数，远低于 IOV_MAX
+
+// 以一次 sendmsg（等价于带 MSG_NOSIGNAL 的 writev）写出队首若干帧。
+// 整帧写完即出队，部分写出的首帧以 headOffset 记录已写字节数；对端已关闭时只返回 EPIPE 而不触发 SIGPIPE
+ssize_t writev_frames(int fd, std::deque<std::string>& frames, size_t& headOffset, int* savedErrno) {
+    struct iovec iov[kMaxFramesPerWritev];
+    int count = 0;
+    for (auto it = frames.begin(); it != frames.end() && count < kMaxFramesPerWritev; ++it, ++count) {
+        const size_t skip = (count == 0) ? headOffset : 0;
+        iov[count].iov_base = const_cast<char*>(it->data()) + skip;
+        iov[count].iov_len = it->size() - skip;
+    }
+
+    struct msghdr msg;
+    std::memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = iov;
+    msg.msg_iovlen = static_cast<size_t>(count);
+
+    const ssize_t n = ::sendmsg(fd, &msg, MSG_NOSIGNAL);
+    if (n < 0) {
+        *savedErrno = errno;
+        return n;
+    }
+
+    size_t written = static_cast<size_t>(n);
+    while (written > 0) {
+        const size_t remaining = frames.front().size() - headOffset;
+        if (written < remaining) {
+            headOffset += written;
+            break;
+        }
+        written -= remaining;
+        frames.pop_front();
+        headOffset = 0;
+    }
+    return n;
+}
+
+// 关闭 Nagle：流控窗口更新与流消息都是小帧，且往往紧跟着分两次写出，等待 ACK 合并会引入延迟确认量级的停顿
+void disable_nagle(int fd) {
+    const int enable = 1;
+    if (::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &enable, sizeof(enable)) < 0) {
+        spdlog::warn("BinaryRpcChannel: Failed to set TCP_NODELAY on fd {}, errno={}", fd, errno);
+    }
+}
+
+InetAddress resolve_address(const std::string& ip, uint16_t port) {
+    try {
+        return InetAddress(ip, port);
+    }
+    catch (const std::invalid_argument&) {
+        throw std::runtime_error("BinaryRpcChannel: Invalid IP address: " + ip);
+    }
+}
+
+} // namespace
+
 BinaryRpcChannel::BinaryRpcChannel(const std::string& ip, uint16_t port)
+    : BinaryRpcChannel(resolve_address(ip, port)) {
+}
+
+BinaryRpcChannel::BinaryRpcChannel(const InetAddress& serverAddr)
     : connected_(true) {
-    clientFd_ = ::socket(AF_INET, SOCK_STREAM, 0);
+    clientFd_ = ::socket(serverAddr.get_family(), SOCK_STREAM, 0);
     if (clientFd_ < 0) {
         throw std::runtime_error("BinaryRpcChannel: Failed to create socket");
     }
+    if (!serverAddr.is_unix()) {
+        disable_nagle(clientFd_);
+    }
 
-    struct sockaddr_in servAddr;
-    std::memset(&servAddr, 0, sizeof(servAddr));
-    servAddr.sin_family = AF_INET;
-    servAddr.sin_port = htons(port);
-    
-    if (::inet_pton(AF_INET, ip.c_str(), &servAddr.sin_addr) != 1) {
+    if (::connect(clientFd_, serverAddr.get_sockaddr_ptr(), serverAddr.get_socklen()) < 0) {
         ::close(clientFd_);
-        throw std::runtime_error("BinaryRpcChannel: Invalid IP address: " + ip);
+        throw std::runtime_error("BinaryRpcChannel: Failed to connect to server " + serverAddr.get_ip_port());
     }
 
-    if (::connect(clientFd_, (struct sockaddr*)&servAddr, sizeof(servAddr)) < 0) {
-        ::close(clientFd_);
-        throw std::runtime_error("BinaryRpcChannel: Failed to connect to server " + ip + ":" + std::to_string(port));
+    // 发起方法 ID 协商；对端若不支持则收不到回包，后续请求继续按方法名发送
+    const std::string negotiation = encode_method_table_request();
+    if (::send(clientFd_, negotiation.data(), negotiation.size(), MSG_NOSIGNAL) != static_cast<ssize_t>(negotiation.size())) {
+        spdlog::warn("BinaryRpcChannel: Failed to send method table request, falling back to method names");
     }
 
     // 连接成功后，启动专职的后台接收解包线程
@@ -53,95 +125,261 @@ BinaryRpcChannel::BinaryRpcChannel(const std::string& ip, uint16_t port)
 }
 
 BinaryRpcChannel::BinaryRpcChannel(EventLoop* loop, const std::string& ip, uint16_t port)
-    : loop_(loop), connected_(false) {
-    
+    : BinaryRpcChannel(loop, resolve_address(ip, port)) {
+}
+
+BinaryRpcChannel::BinaryRpcChannel(EventLoop* loop, const InetAddress& serverAddr, ChannelTransport transport)
+    : loop_(loop) {
+    if (transport == ChannelTransport::SharedMemory) {
+        open_shared_memory(serverAddr);
+    }
+    else {
+        open_nonblocking(serverAddr);
+    }
+}
+
+BinaryRpcChannel::BinaryRpcChannel(std::shared_ptr<BinaryRpcClientLoopPool> loopPool, const std::string& ip, uint16_t port)
+    : BinaryRpcChannel(std::move(loopPool), resolve_address(ip, port)) {
+}
+
+BinaryRpcChannel::BinaryRpcChannel(std::shared_ptr<BinaryRpcClientLoopPool> loopPool,
+                                   const InetAddress& serverAddr,
+                                   ChannelTransport transport)
+    : loopPool_(std::move(loopPool)) {
+    if (!loopPool_) {
+        throw std::invalid_argument("BinaryRpcChannel: loopPool must not be null");
+    }
+    loop_ = loopPool_->get_next_loop();
+    if (transport == ChannelTransport::SharedMemory) {
+        open_shared_memory(serverAddr);
+    }
+    else {
+        open_nonblocking(serverAddr);
+    }
+}
+
+BinaryRpcChannel::~BinaryRpcChannel() {
+    running_ = false;
+
+    if (loop_ != nullptr) {
+        // Channel 只能在 loop 线程注销：本线程即 loop 线程时直接拆除，否则投递过去并等待完成
+        if (loop_->is_in_loop_thread()) {
+            teardown_in_loop();
+        }
+        else {
+            std::promise<void> tornDown;
+            std::future<void> future = tornDown.get_future();
+            loop_->queue_in_loop([this, &tornDown]() {
+                this->teardown_in_loop();
+                tornDown.set_value();
+            });
+            future.wait();
+        }
+    }
+    else {
+        if (clientFd_ >= 0) {
+            ::shutdown(clientFd_, SHUT_RDWR);
+            ::close(clientFd_);
+        }
+
+        if (receiverThread_.joinable()) {
+            receiverThread_.join();
+        }
+    }
+
+    // 清理析构时可能仍挂起未返回的请求
+    cleanup_pending_requests("BinaryRpcChannel: Channel is being destructed");
+}
+
+void BinaryRpcChannel::open_nonblocking(const InetAddress& serverAddr) {
     // 1. 创建非阻塞 Socket，设置 SOCK_NONBLOCK
-    clientFd_ = ::socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    clientFd_ = ::socket(serverAddr.get_family(), SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
     if (clientFd_ < 0) {
         throw std::runtime_error("BinaryRpcChannel: Failed to create non-blocking socket");
     }
-
-    struct sockaddr_in servAddr;
-    std::memset(&servAddr, 0, sizeof(servAddr));
-    servAddr.sin_family = AF_INET;
-    servAddr.sin_port = htons(port);
-    
-    if (::inet_pton(AF_INET, ip.c_str(), &servAddr.sin_addr) != 1) {
-        ::close(clientFd_);
-        throw std::runtime_error("BinaryRpcChannel: Invalid IP address: " + ip);
+    if (!serverAddr.is_unix()) {
+        disable_nagle(clientFd_);
     }
 
-    // 2. 发起非阻塞 connect，如果返回小于 0，应为 EINPROGRESS 状态
-    int ret = ::connect(clientFd_, (struct sockaddr*)&servAddr, sizeof(servAddr));
+    // 2. 发起非阻塞 connect，如果返回小于 0，应为 EINPROGRESS 状态（Unix 域连接要么立即完成要么失败）
+    int ret = ::connect(clientFd_, serverAddr.get_sockaddr_ptr(), serverAddr.get_socklen());
     if (ret < 0 && errno != EINPROGRESS) {
         ::close(clientFd_);
-        throw std::runtime_error("BinaryRpcChannel: Failed to initiate non-blocking connect to " + ip + ":" + std::to_string(port));
+        throw std::runtime_error("BinaryRpcChannel: Failed to initiate non-blocking connect to " + serverAddr.get_ip_port());
     }
 
-    // 3. 将 Socket 包装成 Channel 注册到 EventLoop 监听事件
-    channel_ = std::make_unique<Channel>(loop_, clientFd_);
-    channel_->set_read_callback([this](Channel&) { this->on_read(); });
-    channel_->set_write_callback([this](Channel&) { this->on_write(); });
-    
-    // 监听读，以及用于确认 connect 是否完成的可写事件
-    channel_->enable_reading();
-    channel_->enable_writing();
+    // 3. 在 loop 线程把 Socket 包装成 Channel 注册到 EventLoop；构造线程即 loop 线程时立即执行
+    lifeToken_ = std::make_shared<char>(0);
+    std::weak_ptr<char> token = lifeToken_;
+    loop_->run_in_loop([this, token]() {
+        if (!token.lock()) {
+            return;
+        }
+        channel_ = std::make_unique<Channel>(loop_, clientFd_);
+        channel_->set_read_callback([this](Channel&) { this->on_read(); });
+        channel_->set_write_callback([this](Channel&) { this->on_write(); });
+        channel_->set_close_callback([this](Channel&) {
+            this->fail_connection("BinaryRpcChannel: Connection closed by peer");
+        });
+        channel_->set_error_callback([this](Channel&) {
+            this->fail_connection("BinaryRpcChannel: Socket error");
+        });
+
+        // 监听读，以及用于确认 connect 是否完成的可写事件
+        channel_->enable_reading();
+        channel_->enable_writing();
+    });
+
+    // 4. 方法 ID 协商帧先进入发送缓冲，连接完成后随首次可写事件一起刷出
+    send_frame(encode_method_table_request());
 }
 
-BinaryRpcChannel::~BinaryRpcChannel() {
-    running_ = false;
-    
-    if (channel_) {
-        channel_->disable_all();
+void BinaryRpcChannel::open_shared_memory(const InetAddress& serverAddr) {
+    if (!serverAddr.is_unix()) {
+        throw std::invalid_argument("BinaryRpcChannel: Shared memory transport requires a unix socket address");
     }
 
-    if (clientFd_ >= 0) {
-        ::shutdown(clientFd_, SHUT_RDWR);
+    // 1. 阻塞连接并等待服务端经 SCM_RIGHTS 发来共享内存与门铃，握手完成后 socket 只用于感知服务端退出
+    clientFd_ = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (clientFd_ < 0) {
+        throw std::runtime_error("BinaryRpcChannel: Failed to create socket");
+    }
+    if (::connect(clientFd_, serverAddr.get_sockaddr_ptr(), serverAddr.get_socklen()) < 0) {
+        ::close(clientFd_);
+        throw std::runtime_error("BinaryRpcChannel: Failed to connect to server " + serverAddr.get_ip_port());
+    }
+    try {
+        shm_ = BinaryRpcShmTransport::join_session(clientFd_);
+    }
+    catch (...) {
         ::close(clientFd_);
+        throw;
     }
+    ::fcntl(clientFd_, F_SETFL, ::fcntl(clientFd_, F_GETFL) | O_NONBLOCK);
+    connected_ = true;
+
+    // 2. 在 loop 线程注册 socket 与门铃的 Channel，随后走一轮收发循环公布等待标记
+    lifeToken_ = std::make_shared<char>(0);
+    std::weak_ptr<char> token = lifeToken_;
+    loop_->run_in_loop([this, token]() {
+        if (!token.lock()) {
+            return;
+        }
+        auto onSocketEvent = [this](Channel&) {
+            char discard[64];
+            const ssize_t n = ::read(clientFd_, discard, sizeof(discard));
+            if (n == 0 || (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)) {
+                this->fail_connection("BinaryRpcChannel: Connection closed by peer");
+            }
+        };
+        channel_ = std::make_unique<Channel>(loop_, clientFd_);
+        channel_->set_read_callback(onSocketEvent);
+        channel_->set_close_callback(onSocketEvent);
+        channel_->set_error_callback(onSocketEvent);
+        channel_->enable_reading();
 
-    if (receiverThread_.joinable()) {
-        receiverThread_.join();
+        doorbellChannel_ = std::make_unique<Channel>(loop_, shm_->get_doorbell_fd());
+        doorbellChannel_->set_read_callback([this](Channel&) {
+            shm_->drain_doorbell();
+            this->pump_shared_memory();
+        });
+        doorbellChannel_->enable_reading();
+        this->pump_shared_memory();
+    });
+
+    // 3. 方法 ID 协商帧与 socket 模式一样先入队，由刷写任务写入共享内存
+    send_frame(encode_method_table_request());
+}
+
+void BinaryRpcChannel::pump_shared_memory() {
+    if (!shm_ || !running_) {
+        return;
     }
 
-    // 清理析构时可能仍挂起未返回的请求
-    cleanup_pending_requests("BinaryRpcChannel: Channel is being destructed");
+    shm_->clear_wait();
+    do {
+        const size_t nr = shm_->read_into(&readBuf_);
+        if (nr > 0) {
+            shm_->notify_peer_space();
+            bytesReceived_.fetch_add(static_cast<uint64_t>(nr), std::memory_order_relaxed);
+            if (!dispatch_responses(&readBuf_)) {
+                fail_connection("BinaryRpcChannel: Protocol decode error");
+                return;
+            }
+            if (!running_) {
+                return;
+            }
+        }
+        write_shared_memory();
+    } while (!shm_->arm_wait(!writingFrames_.empty()));
+}
+
+void BinaryRpcChannel::write_shared_memory() {
+    size_t total = 0;
+    while (!writingFrames_.empty()) {
+        const std::string& frame = writingFrames_.front();
+        const size_t written = shm_->write(frame.data() + writingOffset_, frame.size() - writingOffset_);
+        if (written == 0) {
+            break; // 出站环已满，等服务端读走数据后敲响门铃再继续
+        }
+        total += written;
+        writingOffset_ += written;
+        if (writingOffset_ == frame.size()) {
+            writingFrames_.pop_front();
+            writingOffset_ = 0;
+        }
+    }
+    if (total > 0) {
+        bytesSent_.fetch_add(static_cast<uint64_t>(total), std::memory_order_relaxed);
+        shm_->notify_peer_data();
+    }
+}
+
+void BinaryRpcChannel::teardown_in_loop() {
+    // 令已投递但尚未执行的任务失效，再注销 Channel 并关闭 fd
+    lifeToken_.reset();
+    doorbellChannel_.reset();
+    shm_.reset();
+    channel_.reset();
+    if (clientFd_ >= 0) {
+        ::close(clientFd_);
+        clientFd_ = -1;
+    }
 }
 
 void BinaryRpcChannel::CallMethod(const google::protobuf::MethodDescriptor* method,
-                                 google::protobuf::RpcController* /* controller */,
+                                 google::protobuf::RpcController* controller,
                                  const google::protobuf::Message* request,
                                  google::protobuf::Message* response,
                                  google::protobuf::Closure* done) {
-    uint64_t seq = nextSequenceId_++;
     auto context = std::make_shared<ResponseContext>();
     context->response = response;
+    context->cancelController = dynamic_cast<BinaryRpcController*>(controller);
+    const std::chrono::milliseconds timeout = resolve_timeout(context->cancelController);
 
     Coroutine* cur_coro = Coroutine::t_current_coroutine;
 
-    if (cur_coro != nullptr && loop_ != nullptr) {
-        // ───────────────── 【路径一：协程非阻塞模式】 ─────────────────
-        context->coroutine = cur_coro->shared_from_this();
-        {
-            std::lock_guard<std::mutex> lock(mapMutex_);
-            if (!running_) {
-                throw std::runtime_error("BinaryRpcChannel: Channel is closed");
-            }
-            pendingRequests_[seq] = context;
-        }
+    if (loop_ == nullptr) {
+        // ───────────────── 【路径一：传统线程阻塞模式】 ─────────────────
+        std::future<void> future = context->promise.get_future();
+        submit_request(method, request, context, timeout);
 
-        std::string bytesToSend;
-        try {
-            bytesToSend = encode_request(method, request, seq);
+        // 阻塞当前操作系统线程，等待底层解包线程将其唤醒；超时则放弃该请求，由 get() 抛出超时异常
+        if (timeout.count() > 0 && future.wait_for(timeout) == std::future_status::timeout) {
+            abandon_request(context->sequenceId, "BinaryRpcChannel: Deadline exceeded");
         }
-        catch (...) {
-            std::lock_guard<std::mutex> lock(mapMutex_);
-            pendingRequests_.erase(seq);
-            throw;
+        future.get();
+
+        if (done) {
+            done->Run();
         }
+        return;
+    }
 
-        // 调用非阻塞发送管道
-        write_request_nonblocking(bytesToSend);
+    if (cur_coro != nullptr) {
+        // ───────────────── 【路径二：协程非阻塞模式】 ─────────────────
+        context->coroutine = cur_coro->shared_from_this();
+        submit_request(method, request, context, timeout);
 
         // 挂起当前协程，释放 CPU 执行权回退到 EventLoop 主循环
         cur_coro->yield();
@@ -156,307 +394,616 @@ void BinaryRpcChannel::CallMethod(const google::protobuf::MethodDescriptor* meth
         }
         return;
     }
-    else {
-        // ───────────────── 【路径二：传统线程阻塞模式】 ─────────────────
-        std::future<void> future = context->promise.get_future();
-        {
-            std::lock_guard<std::mutex> lock(mapMutex_);
-            if (!running_) {
-                throw std::runtime_error("BinaryRpcChannel: Channel is closed");
-            }
-            pendingRequests_[seq] = context;
-        }
 
-        std::string bytesToSend;
-        try {
-            bytesToSend = encode_request(method, request, seq);
+    if (done != nullptr) {
+        // ───────────────── 【路径三：回调异步模式】 ─────────────────
+        // 立即返回，回包后由本 Channel 的 loop 线程执行 done
+        context->done = done;
+        context->controller = controller;
+        submit_request(method, request, context, timeout);
+        return;
+    }
+
+    // ───────────────── 【路径四：事件驱动下的同步等待】 ─────────────────
+    // 回包只能由本 Channel 的 loop 线程分发，在该线程阻塞等待必然死锁
+    if (loop_->is_in_loop_thread()) {
+        throw std::logic_error("BinaryRpcChannel: Blocking call on the channel's own EventLoop thread");
+    }
+    std::future<void> future = context->promise.get_future();
+    submit_request(method, request, context, timeout);
+    future.get();
+}
+
+std::future<void> BinaryRpcChannel::call_async(const google::protobuf::MethodDescriptor* method,
+                                               const google::protobuf::Message* request,
+                                               google::protobuf::Message* response) {
+    auto context = std::make_shared<ResponseContext>();
+    context->response = response;
+    std::future<void> future = context->promise.get_future();
+    submit_request(method, request, context, resolve_timeout(nullptr));
+    return future;
+}
+
+void BinaryRpcChannel::call_async(const google::protobuf::MethodDescriptor* method,
+                                  const google::protobuf::Message* request,
+                                  google::protobuf::Message* response,
+                                  std::function<void(std::exception_ptr)> onComplete) {
+    if (loop_ == nullptr) {
+        throw std::logic_error("BinaryRpcChannel: Callback calls require an event-driven channel");
+    }
+
+    auto context = std::make_shared<ResponseContext>();
+    context->response = response;
+    context->callback = std::move(onComplete);
+    submit_request(method, request, context, resolve_timeout(nullptr));
+}
+
+void BinaryRpcChannel::submit_request(const google::protobuf::MethodDescriptor* method,
+                                      const google::protobuf::Message* request,
+                                      const std::shared_ptr<ResponseContext>& context,
+                                      std::chrono::milliseconds timeout) {
+    const uint64_t seq = nextSequenceId_++;
+    context->sequenceId = seq;
+    uint32_t methodId = 0;
+    {
+        std::lock_guard<std::mutex> lock(mapMutex_);
+        if (!running_) {
+            throw std::runtime_error("BinaryRpcChannel: Channel is closed");
         }
-        catch (...) {
-            std::lock_guard<std::mutex> lock(mapMutex_);
-            pendingRequests_.erase(seq);
-            throw;
+        pendingRequests_[seq] = context;
+        auto idIt = methodIds_.find(method);
+        if (idIt != methodIds_.end()) {
+            methodId = idIt->second;
         }
+    }
 
-        try {
-            std::lock_guard<std::mutex> lock(sendMutex_);
-            size_t totalSent = 0;
-            while (totalSent < bytesToSend.size()) {
-                ssize_t n = ::write(clientFd_, bytesToSend.data() + totalSent, bytesToSend.size() - totalSent);
-                if (n <= 0) {
-                    if (n < 0 && errno == EINTR) {
-                        continue;
-                    }
-                    throw std::runtime_error("BinaryRpcChannel: Failed to write bytes to socket");
+    std::string frame;
+    try {
+        frame = encode_request(method, request, seq, methodId, timeout);
+    }
+    catch (...) {
+        std::lock_guard<std::mutex> lock(mapMutex_);
+        pendingRequests_.erase(seq);
+        throw;
+    }
+
+    // 在发出请求帧之前布置定时器与取消钩子，回包不可能早于它们到达；
+    // 在 mapMutex_ 内写入，使取出表项后完成请求的线程能看到 deadlineTimer
+    bool cancelledEarly = false;
+    {
+        std::lock_guard<std::mutex> lock(mapMutex_);
+        if (timeout.count() > 0 && loop_ != nullptr) {
+            std::weak_ptr<char> token = lifeToken_;
+            context->deadlineTimer = loop_->run_at(std::chrono::steady_clock::now() + timeout, [this, token, seq]() {
+                if (token.lock()) {
+                    this->abandon_request(seq, "BinaryRpcChannel: Deadline exceeded");
                 }
-                totalSent += n;
+            });
+        }
+        if (context->cancelController != nullptr) {
+            cancelledEarly = !context->cancelController->install_cancel_hook([this, seq]() {
+                this->abandon_request(seq, "BinaryRpcChannel: Call cancelled");
+            });
+            if (cancelledEarly) {
+                pendingRequests_.erase(seq);
             }
         }
-        catch (...) {
-            std::lock_guard<std::mutex> lock(mapMutex_);
-            pendingRequests_.erase(seq);
-            throw;
+    }
+    if (cancelledEarly) {
+        // 发起前就已被取消：请求帧不再发出
+        complete_request(context, std::make_exception_ptr(std::runtime_error("BinaryRpcChannel: Call cancelled")));
+        return;
+    }
+
+    // 入队后写出失败不再抛给本调用方，而是经连接失效路径以异常完成全部挂起请求
+    enqueue_frame(std::move(frame));
+}
+
+bool BinaryRpcChannel::abandon_request(uint64_t seq, const std::string& reason) {
+    std::shared_ptr<ResponseContext> context;
+    {
+        std::lock_guard<std::mutex> lock(mapMutex_);
+        auto it = pendingRequests_.find(seq);
+        if (it == pendingRequests_.end()) {
+            return false; // 回包、连接失效或另一条放弃路径已先完成该请求
         }
+        context = it->second;
+        pendingRequests_.erase(it);
+    }
 
-        // 阻塞当前操作系统线程，等待底层解包线程将其唤醒
-        future.get();
+    // 通知服务端不必再执行或回包；此后迟到的回包因找不到挂起表项被直接丢弃
+    if (running_) {
+        Buffer writeBuf;
+        BinaryRpcCodec::encode(&writeBuf, RpcMessageType::Cancel, seq, "", "", kRpcVersion);
+        enqueue_frame(writeBuf.read_from_buffer());
+    }
+    complete_request(context, std::make_exception_ptr(std::runtime_error(reason)));
+    return true;
+}
 
-        if (done) {
-            done->Run();
+std::shared_ptr<BinaryRpcStream> BinaryRpcChannel::open_stream(const google::protobuf::MethodDescriptor* method,
+                                                               uint32_t window) {
+    const uint64_t streamId = nextSequenceId_++;
+    auto stream = std::make_shared<BinaryRpcStream>(streamId, window, loop_,
+        [this, streamId](RpcMessageType type, const std::string& metaRaw, const std::string& body) {
+            if (type == RpcMessageType::StreamCancel) {
+                std::lock_guard<std::mutex> lock(mapMutex_);
+                streams_.erase(streamId);
+            }
+            if (running_) {
+                enqueue_frame(encode_frame(type, streamId, metaRaw, body, kRpcVersion));
+            }
+        });
+
+    {
+        std::lock_guard<std::mutex> lock(mapMutex_);
+        if (!running_) {
+            throw std::runtime_error("BinaryRpcChannel: Channel is closed");
+        }
+        streams_[streamId] = stream;
+    }
+
+    // 流按服务名与方法名打开：方法 ID 表只覆盖一元方法
+    RpcMeta meta;
+    meta.set_service_name(method->service()->full_name());
+    meta.set_method_name(method->name());
+    meta.set_stream_window(window > 0 ? window : kDefaultStreamWindow);
+
+    Buffer writeBuf;
+    BinaryRpcCodec::encode(&writeBuf, RpcMessageType::StreamOpen, streamId, meta.SerializeAsString(), "", kRpcVersion);
+    enqueue_frame(writeBuf.read_from_buffer());
+    return stream;
+}
+
+std::chrono::milliseconds BinaryRpcChannel::resolve_timeout(const BinaryRpcController* controller) const {
+    if (controller != nullptr && controller->get_timeout().count() > 0) {
+        return controller->get_timeout();
+    }
+    return std::chrono::milliseconds(defaultTimeoutMs_.load(std::memory_order_relaxed));
+}
+
+void BinaryRpcChannel::enqueue_frame(std::string frame) {
+    if (loop_ != nullptr) {
+        send_frame(std::move(frame));
+    }
+    else {
+        send_frame_blocking(std::move(frame));
+    }
+}
+
+void BinaryRpcChannel::send_frame_blocking(std::string frame) {
+    {
+        std::lock_guard<std::mutex> lock(sendMutex_);
+        pendingFrames_.push_back(std::move(frame));
+        // 已有调用方持有写权：它会在释放写权前把本帧一并写出
+        if (writerActive_) {
+            return;
+        }
+        writerActive_ = true;
+    }
+
+    const int64_t lingerUs = writeLingerUs_.load(std::memory_order_relaxed);
+    if (lingerUs > 0) {
+        std::this_thread::sleep_for(std::chrono::microseconds(lingerUs));
+    }
+
+    std::deque<std::string> batch;
+    while (true) {
+        {
+            std::lock_guard<std::mutex> lock(sendMutex_);
+            if (pendingFrames_.empty()) {
+                writerActive_ = false;
+                return;
+            }
+            batch.swap(pendingFrames_);
+        }
+
+        size_t offset = 0;
+        while (!batch.empty()) {
+            int savedErrno = 0;
+            const ssize_t written = writev_frames(clientFd_, batch, offset, &savedErrno);
+            if (written > 0) {
+                bytesSent_.fetch_add(static_cast<uint64_t>(written), std::memory_order_relaxed);
+            }
+            if (written < 0 && savedErrno != EINTR) {
+                // 写失败说明连接已不可用：关闭读写让接收线程退出并清理全部挂起请求
+                spdlog::error("BinaryRpcChannel: Failed to write frames to socket, errno={}", savedErrno);
+                ::shutdown(clientFd_, SHUT_RDWR);
+                std::lock_guard<std::mutex> lock(sendMutex_);
+                pendingFrames_.clear();
+                writerActive_ = false;
+                return;
+            }
         }
-        return;
     }
 }
 
 void BinaryRpcChannel::receive_loop() {
     Buffer readBuf;
-    char temp[1024];
-    RpcHeader respHeader;
-    std::string respMetaRaw;
-    std::string respBodyRaw;
 
     while (running_) {
-        ssize_t nr = ::read(clientFd_, temp, sizeof(temp));
+        int savedErrno = 0;
+        ssize_t nr = readBuf.read_from_fd(clientFd_, &savedErrno);
         if (nr <= 0) {
-            if (nr < 0 && (errno == EINTR || errno == EAGAIN)) {
+            if (nr < 0 && (savedErrno == EINTR || savedErrno == EAGAIN)) {
                 continue;
             }
             // 对端断开或 Socket 被 shutdown/close 发生异常，退出接收循环并清理待处理事务
+            running_ = false;
             cleanup_pending_requests("BinaryRpcChannel: Connection closed prematurely");
             break;
         }
 
-        readBuf.write_to_buffer(temp, nr);
-
-        while (running_) {
-            BinaryRpcCodec::DecodeResult result = BinaryRpcCodec::decode(&readBuf, respHeader, respMetaRaw, respBodyRaw);
-            
-            if (result == BinaryRpcCodec::DecodeResult::Success) {
-                std::shared_ptr<ResponseContext> context;
-                
-                // 加锁提取并从 Map 移走该 sequenceId，防止二次操作
-                {
-                    std::lock_guard<std::mutex> lock(mapMutex_);
-                    auto it = pendingRequests_.find(respHeader.sequenceId);
-                    if (it != pendingRequests_.end()) {
-                        context = it->second;
-                        pendingRequests_.erase(it);
-                    }
-                }
+        bytesReceived_.fetch_add(static_cast<uint64_t>(nr), std::memory_order_relaxed);
+        if (!dispatch_responses(&readBuf)) {
+            running_ = false;
+            cleanup_pending_requests("BinaryRpcChannel: Detected binary protocol decode error");
+            break;
+        }
+    }
+}
 
-                if (context) {
-                    // 反序列化并还原回出参 response
-                    if (context->response->ParseFromString(respBodyRaw)) {
-                        context->promise.set_value(); // 【核心唤醒】
-                    } else {
-                        context->promise.set_exception(std::make_exception_ptr(
-                            std::runtime_error("BinaryRpcChannel: Failed to parse Response Message")
-                        ));
-                    }
-                }
+bool BinaryRpcChannel::dispatch_responses(Buffer* buf) {
+    RpcHeader respHeader;
+    const char* respMetaData = nullptr;
+    const char* respBody = nullptr;
+
+    while (true) {
+        BinaryRpcCodec::DecodeResult result = BinaryRpcCodec::peek(buf, respHeader, respMetaData, respBody);
+        if (result == BinaryRpcCodec::DecodeResult::HalfPack || result == BinaryRpcCodec::DecodeResult::Empty) {
+            return true; // 半包继续等待接收
+        }
+        if (result == BinaryRpcCodec::DecodeResult::Error) {
+            return false;
+        }
+
+        if (frame_type(respHeader) == RpcMessageType::MethodTable) {
+            apply_method_table(std::string(respBody, respHeader.bodyLen));
+            buf->advance_read_index(BinaryRpcCodec::frame_size(respHeader));
+            continue;
+        }
+
+        // 压缩的 Body 解压到线程复用的缓冲，之后的反序列化与流消息拷贝都从该缓冲读取
+        const char* body = respBody;
+        size_t bodyLen = respHeader.bodyLen;
+        if (is_body_compressed(respHeader)) {
+            const std::string* raw = BinaryRpcCompression::decompress(respBody, respHeader.bodyLen);
+            if (raw == nullptr) {
+                spdlog::error("BinaryRpcChannel: Failed to decompress frame body, seq={}", respHeader.sequenceId);
+                return false;
             }
-            else if (result == BinaryRpcCodec::DecodeResult::HalfPack || result == BinaryRpcCodec::DecodeResult::Empty) {
-                break; // 半包继续等待接收
+            body = raw->data();
+            bodyLen = raw->size();
+        }
+
+        if (is_stream_frame(frame_type(respHeader))) {
+            dispatch_stream_frame(respHeader, respMetaData, body, bodyLen);
+            buf->advance_read_index(BinaryRpcCodec::frame_size(respHeader));
+            continue;
+        }
+
+        // 加锁提取并从 Map 移走该 sequenceId，防止二次操作
+        std::shared_ptr<ResponseContext> context;
+        {
+            std::lock_guard<std::mutex> lock(mapMutex_);
+            auto it = pendingRequests_.find(respHeader.sequenceId);
+            if (it != pendingRequests_.end()) {
+                context = it->second;
+                pendingRequests_.erase(it);
             }
-            else if (result == BinaryRpcCodec::DecodeResult::Error) {
-                cleanup_pending_requests("BinaryRpcChannel: Detected binary protocol decode error");
-                running_ = false;
-                break;
+        }
+
+        if (!context) {
+            buf->advance_read_index(BinaryRpcCodec::frame_size(respHeader));
+            continue;
+        }
+
+        // 携带 Meta 的响应帧表示服务端未执行该请求（如过载拒绝），以其中的错误信息结束调用
+        if (respHeader.metaLen > 0) {
+            RpcMeta respMeta;
+            std::string errorText = "BinaryRpcChannel: Malformed response meta";
+            if (respMeta.ParseFromArray(respMetaData, static_cast<int>(respHeader.metaLen)) && !respMeta.error_text().empty()) {
+                errorText = respMeta.error_text();
             }
+            buf->advance_read_index(BinaryRpcCodec::frame_size(respHeader));
+            complete_request(context, std::make_exception_ptr(std::runtime_error(errorText)));
+            continue;
+        }
+
+        // 直接从读缓冲反序列化回出参 response，推进读指针后再唤醒调用方
+        const bool parsed = bodyLen <= static_cast<size_t>(std::numeric_limits<int>::max())
+            && context->response->ParseFromArray(body, static_cast<int>(bodyLen));
+        buf->advance_read_index(BinaryRpcCodec::frame_size(respHeader));
+
+        if (parsed) {
+            complete_request(context, nullptr);
+        }
+        else {
+            complete_request(context, std::make_exception_ptr(
+                std::runtime_error("BinaryRpcChannel: Failed to parse Response Message")));
         }
     }
 }
 
-void BinaryRpcChannel::cleanup_pending_requests(const std::string& reason) {
-    std::lock_guard<std::mutex> lock(mapMutex_);
-    auto err = std::make_exception_ptr(std::runtime_error(reason));
-    for (auto& pair : pendingRequests_) {
-        auto context = pair.second;
-        if (context->coroutine) {
-            context->exception = err;
-            EventLoop* origin_loop = context->coroutine->get_loop();
-            origin_loop->run_in_loop([coro = context->coroutine]() {
-                coro->resume();
+void BinaryRpcChannel::dispatch_stream_frame(const RpcHeader& header, const char* metaData, const char* body, size_t bodyLen) {
+    const RpcMessageType type = frame_type(header);
+    std::shared_ptr<BinaryRpcStream> stream;
+    {
+        std::lock_guard<std::mutex> lock(mapMutex_);
+        auto it = streams_.find(header.sequenceId);
+        if (it == streams_.end()) {
+            return; // 已结束或已取消的流上迟到的帧
+        }
+        stream = it->second;
+        // 服务端半关闭即结束整个流，取消同理，此后不再有该流的帧
+        if (type == RpcMessageType::StreamHalfClose || type == RpcMessageType::StreamCancel) {
+            streams_.erase(it);
+        }
+    }
+
+    RpcMeta meta;
+    if (header.metaLen > 0 && !meta.ParseFromArray(metaData, static_cast<int>(header.metaLen))) {
+        stream->cancel("BinaryRpcChannel: Malformed stream meta");
+        return;
+    }
+
+    switch (type) {
+    case RpcMessageType::StreamData:
+        if (!stream->on_data(std::string(body, bodyLen))) {
+            spdlog::warn("BinaryRpcChannel: Stream {} exceeded its receive window, cancelling", header.sequenceId);
+            stream->cancel("BinaryRpcChannel: Stream window exceeded");
+        }
+        break;
+    case RpcMessageType::StreamHalfClose:
+        stream->on_remote_finish(meta.error_text());
+        break;
+    case RpcMessageType::StreamCancel:
+        stream->on_remote_cancel(meta.error_text().empty() ? "BinaryRpcChannel: Stream cancelled by server" : meta.error_text());
+        break;
+    case RpcMessageType::StreamWindowUpdate:
+        stream->on_window_update(meta.window_increment());
+        break;
+    default:
+        break;
+    }
+}
+
+void BinaryRpcChannel::complete_request(const std::shared_ptr<ResponseContext>& context, std::exception_ptr error) {
+    // 表项已被取出，定时器与取消钩子不会再找到它；尽早拆除，避免控制器被复用时误触发
+    if (context->deadlineTimer.valid()) {
+        loop_->cancel(context->deadlineTimer);
+    }
+    if (context->cancelController != nullptr) {
+        context->cancelController->clear_cancel_hook();
+    }
+
+    if (context->coroutine) {
+        // 协程统一在其所属 loop 的下一轮任务中恢复，避免在读回调内部重入业务代码
+        context->exception = error;
+        EventLoop* origin_loop = context->coroutine->get_loop();
+        origin_loop->queue_in_loop([coro = context->coroutine]() {
+            coro->resume();
+        });
+    }
+    else if (context->callback || context->done != nullptr) {
+        // StartCancel() 的取消钩子会在调用方线程上走到这里：回调与 done 统一投递到本 Channel 的 loop 线程执行。
+        // 析构时 loop 上的 Channel 已拆除、投递的任务未必还能执行，就地完成
+        if (loop_ != nullptr && running_) {
+            loop_->run_in_loop([context, error]() {
+                run_completion_callback(context, error);
             });
-        } else {
-            context->promise.set_exception(err);
         }
+        else {
+            run_completion_callback(context, error);
+        }
+    }
+    else if (error) {
+        context->promise.set_exception(error);
+    }
+    else {
+        context->promise.set_value(); // 【核心唤醒】
     }
-    pendingRequests_.clear();
 }
 
-void BinaryRpcChannel::on_read() {
-    char temp[1024];
-    bool socketErrorOrEOF = false;
+void BinaryRpcChannel::run_completion_callback(const std::shared_ptr<ResponseContext>& context, std::exception_ptr error) {
+    if (context->callback) {
+        context->callback(error);
+        return;
+    }
 
-    while (running_) {
-        ssize_t nr = ::read(clientFd_, temp, sizeof(temp));
-        if (nr < 0) {
-            if (errno == EINTR) {
-                continue;
+    if (error) {
+        try {
+            std::rethrow_exception(error);
+        }
+        catch (const std::exception& e) {
+            if (context->controller != nullptr) {
+                context->controller->SetFailed(e.what());
             }
-            if (errno == EAGAIN || errno == EWOULDBLOCK) {
-                break; // 读空，等待下一次事件
+            else {
+                spdlog::warn("BinaryRpcChannel: Async call failed without controller, error={}", e.what());
             }
-            socketErrorOrEOF = true;
-            break;
-        }
-        if (nr == 0) {
-            socketErrorOrEOF = true; // 对端关闭连接
-            break;
         }
-        readBuf_.write_to_buffer(temp, nr);
     }
+    context->done->Run();
+}
+
+void BinaryRpcChannel::cleanup_pending_requests(const std::string& reason) {
+    // 先整体摘下挂起表再逐个完成，done 回调中再次发起调用时不会与本函数争用 mapMutex_
+    std::unordered_map<uint64_t, std::shared_ptr<ResponseContext>> pending;
+    std::unordered_map<uint64_t, std::shared_ptr<BinaryRpcStream>> streams;
+    {
+        std::lock_guard<std::mutex> lock(mapMutex_);
+        pending.swap(pendingRequests_);
+        streams.swap(streams_);
+    }
+
+    auto err = std::make_exception_ptr(std::runtime_error(reason));
+    for (auto& pair : pending) {
+        complete_request(pair.second, err);
+    }
+    for (auto& pair : streams) {
+        pair.second->on_remote_cancel(reason);
+    }
+}
 
-    if (socketErrorOrEOF) {
-        cleanup_pending_requests("BinaryRpcChannel: Connection closed or read error");
-        running_ = false;
-        if (channel_) {
-            channel_->disable_all();
+void BinaryRpcChannel::on_read() {
+    // 单次 readv：主缓冲不够时溢出到栈上 64KB 额外缓冲，LT 模式下未读完的数据下一轮继续读
+    int savedErrno = 0;
+    ssize_t nr = readBuf_.read_from_fd(clientFd_, &savedErrno);
+    if (nr == 0) {
+        fail_connection("BinaryRpcChannel: Connection closed by peer");
+        return;
+    }
+    if (nr < 0) {
+        if (savedErrno != EINTR && savedErrno != EAGAIN && savedErrno != EWOULDBLOCK) {
+            fail_connection("BinaryRpcChannel: Connection read error");
         }
         return;
     }
 
-    // 解包并匹配分发
-    RpcHeader respHeader;
-    std::string respMetaRaw;
-    std::string respBodyRaw;
+    bytesReceived_.fetch_add(static_cast<uint64_t>(nr), std::memory_order_relaxed);
+    if (!dispatch_responses(&readBuf_)) {
+        fail_connection("BinaryRpcChannel: Protocol decode error");
+    }
+}
 
-    while (running_) {
-        BinaryRpcCodec::DecodeResult result = BinaryRpcCodec::decode(&readBuf_, respHeader, respMetaRaw, respBodyRaw);
-        
-        if (result == BinaryRpcCodec::DecodeResult::Success) {
-            std::shared_ptr<ResponseContext> context;
-            {
-                std::lock_guard<std::mutex> lock(mapMutex_);
-                auto it = pendingRequests_.find(respHeader.sequenceId);
-                if (it != pendingRequests_.end()) {
-                    context = it->second;
-                    pendingRequests_.erase(it);
-                }
-            }
+void BinaryRpcChannel::on_write() {
+    if (!running_) {
+        return; // 同一轮事件中读回调已判定连接失效
+    }
 
-            if (context) {
-                if (context->response->ParseFromString(respBodyRaw)) {
-                    if (context->coroutine) {
-                        EventLoop* origin_loop = context->coroutine->get_loop();
-                        origin_loop->run_in_loop([coro = context->coroutine]() {
-                            coro->resume();
-                        });
-                    } else {
-                        context->promise.set_value();
-                    }
-                } else {
-                    auto err = std::make_exception_ptr(std::runtime_error("BinaryRpcChannel: Failed to parse Response Message"));
-                    if (context->coroutine) {
-                        context->exception = err;
-                        EventLoop* origin_loop = context->coroutine->get_loop();
-                        origin_loop->run_in_loop([coro = context->coroutine]() {
-                            coro->resume();
-                        });
-                    } else {
-                        context->promise.set_exception(err);
-                    }
-                }
-            }
-        }
-        else if (result == BinaryRpcCodec::DecodeResult::HalfPack || result == BinaryRpcCodec::DecodeResult::Empty) {
-            break;
-        }
-        else if (result == BinaryRpcCodec::DecodeResult::Error) {
-            cleanup_pending_requests("BinaryRpcChannel: Protocol decode error");
-            running_ = false;
-            if (channel_) {
-                channel_->disable_all();
-            }
-            break;
+    if (!connected_) {
+        // 检查非阻塞 Socket 连接状态（第一次可写时触发getsockopt检测连接是否成功）
+        int err = 0;
+        socklen_t len = sizeof(err);
+        if (::getsockopt(clientFd_, SOL_SOCKET, SO_ERROR, &err, &len) < 0 || err != 0) {
+            fail_connection("BinaryRpcChannel: Non-blocking connect failed");
+            return;
         }
+        connected_ = true;
     }
+
+    flush_output();
 }
 
-void BinaryRpcChannel::on_write() {
-    // 检查非阻塞 Socket 连接状态（第一次可写时触发getsockopt检测连接是否成功）
-    int err = 0;
-    socklen_t len = sizeof(err);
-    if (::getsockopt(clientFd_, SOL_SOCKET, SO_ERROR, &err, &len) < 0 || err != 0) {
-        cleanup_pending_requests("BinaryRpcChannel: Non-blocking connect failed");
-        running_ = false;
-        if (channel_) {
-            channel_->disable_all();
+void BinaryRpcChannel::send_frame(std::string frame) {
+    bool needFlush = false;
+    {
+        std::lock_guard<std::mutex> lock(sendMutex_);
+        pendingFrames_.push_back(std::move(frame));
+        // 已有刷写任务在排队时只入队，同一轮循环内的多次调用由那一次刷写合并写出
+        if (!flushQueued_) {
+            flushQueued_ = true;
+            needFlush = true;
         }
-        return;
     }
 
-    // 发送缓冲区写出
-    std::lock_guard<std::mutex> lock(sendMutex_);
-    if (writeBuffer_.empty()) {
-        channel_->disable_writing();
+    if (!needFlush) {
         return;
     }
 
-    size_t totalSent = 0;
-    while (totalSent < writeBuffer_.size()) {
-        ssize_t n = ::write(clientFd_, writeBuffer_.data() + totalSent, writeBuffer_.size() - totalSent);
-        if (n < 0) {
-            if (errno == EINTR) {
-                continue;
-            }
-            if (errno == EAGAIN || errno == EWOULDBLOCK) {
-                writeBuffer_ = writeBuffer_.substr(totalSent);
-                return;
-            }
-            cleanup_pending_requests("BinaryRpcChannel: Non-blocking write error");
-            running_ = false;
-            if (channel_) {
-                channel_->disable_all();
+    std::weak_ptr<char> token = lifeToken_;
+    auto flushTask = [this, token]() {
+        if (token.lock()) {
+            this->flush_output();
+        }
+    };
+
+    const int64_t lingerUs = writeLingerUs_.load(std::memory_order_relaxed);
+    if (lingerUs > 0) {
+        loop_->run_at(std::chrono::steady_clock::now() + std::chrono::microseconds(lingerUs), flushTask);
+    }
+    else {
+        loop_->queue_in_loop(flushTask);
+    }
+}
+
+void BinaryRpcChannel::flush_output() {
+    {
+        // 只在锁内整体取走排队帧，writev 系统调用在锁外进行，不阻塞并发入队的调用方
+        std::lock_guard<std::mutex> lock(sendMutex_);
+        flushQueued_ = false;
+        if (writingFrames_.empty()) {
+            writingFrames_.swap(pendingFrames_);
+        }
+        else {
+            for (std::string& frame : pendingFrames_) {
+                writingFrames_.push_back(std::move(frame));
             }
-            return;
+            pendingFrames_.clear();
         }
-        totalSent += n;
     }
 
-    writeBuffer_.clear();
-    channel_->disable_writing();
-}
+    // 连接尚未建立时保留队列，等待 on_write 确认连接后再刷出；连接已失效时不再写
+    if (!connected_ || !channel_ || !running_) {
+        return;
+    }
 
-void BinaryRpcChannel::write_request_nonblocking(const std::string& data) {
-    std::lock_guard<std::mutex> lock(sendMutex_);
-    
-    // 如果还未连接成功，或者发送缓存中已有挂起数据，则追加到缓存末尾等待 on_write 依次刷出
-    if (!connected_ || !writeBuffer_.empty()) {
-        writeBuffer_ += data;
+    if (shm_) {
+        pump_shared_memory();
         return;
     }
 
-    size_t totalSent = 0;
-    while (totalSent < data.size()) {
-        ssize_t n = ::write(clientFd_, data.data() + totalSent, data.size() - totalSent);
-        if (n < 0) {
-            if (errno == EINTR) {
+    while (!writingFrames_.empty()) {
+        int savedErrno = 0;
+        const ssize_t written = writev_frames(clientFd_, writingFrames_, writingOffset_, &savedErrno);
+        if (written > 0) {
+            bytesSent_.fetch_add(static_cast<uint64_t>(written), std::memory_order_relaxed);
+        }
+        if (written < 0) {
+            if (savedErrno == EINTR) {
                 continue;
             }
-            if (errno == EAGAIN || errno == EWOULDBLOCK) {
-                // 写缓冲区满，记录剩余字节，并在 EventLoop 中开启 writable 监听以等待就绪通知
-                writeBuffer_ += data.substr(totalSent);
-                loop_->run_in_loop([this]() {
-                    if (channel_) {
-                        channel_->enable_writing();
-                    }
-                });
+            if (savedErrno == EAGAIN || savedErrno == EWOULDBLOCK) {
                 break;
             }
-            throw std::runtime_error("BinaryRpcChannel: Non-blocking socket write error");
+            fail_connection("BinaryRpcChannel: Non-blocking write error");
+            return;
         }
-        totalSent += n;
     }
+
+    // 内核发送缓冲写满时关注可写事件，写空后立即取消，避免 LT 模式下空转
+    if (!writingFrames_.empty()) {
+        if (!channel_->is_writing()) {
+            channel_->enable_writing();
+        }
+    }
+    else if (channel_->is_writing()) {
+        channel_->disable_writing();
+    }
+}
+
+void BinaryRpcChannel::fail_connection(const std::string& reason) {
+    running_ = false;
+    if (channel_) {
+        channel_->disable_all();
+    }
+    if (doorbellChannel_) {
+        doorbellChannel_->disable_all();
+    }
+    cleanup_pending_requests(reason);
 }
 
 std::string BinaryRpcChannel::encode_request(const google::protobuf::MethodDescriptor* method,
                                              const google::protobuf::Message* request,
-                                             uint64_t seq) {
+                                             uint64_t seq,
+                                             uint32_t methodId,
+                                             std::chrono::milliseconds timeout) {
+    // 协商成功后只携带方法 ID，否则按 version 1 携带完整服务名与方法名
     RpcMeta meta;
-    meta.set_service_name(method->service()->full_name());
-    meta.set_method_name(method->name());
-    
+    uint8_t version = kRpcVersion;
+    if (methodId != 0) {
+        meta.set_method_id(methodId);
+        version = kRpcVersionMethodId;
+    }
+    else {
+        meta.set_service_name(method->service()->full_name());
+        meta.set_method_name(method->name());
+    }
+    if (timeout.count() > 0) {
+        meta.set_timeout_ms(static_cast<uint32_t>(std::min<int64_t>(timeout.count(), std::numeric_limits<uint32_t>::max())));
+    }
+
     std::string metaRaw;
     if (!meta.SerializeToString(&metaRaw)) {
         throw std::runtime_error("BinaryRpcChannel: Failed to serialize RpcMeta");
@@ -467,11 +1014,80 @@ std::string BinaryRpcChannel::encode_request(const google::protobuf::MethodDescr
         throw std::runtime_error("BinaryRpcChannel: Failed to serialize Request Message");
     }
 
+    return encode_frame(RpcMessageType::Request, seq, metaRaw, bodyRaw, version);
+}
+
+std::string BinaryRpcChannel::encode_frame(RpcMessageType type, uint64_t seq, const std::string& metaRaw,
+                                           const std::string& body, uint8_t version) {
+    Buffer writeBuf;
+    std::string compressed;
+    const CompressionType compression = get_compression();
+    if (BinaryRpcCompression::maybe_compress(compression, compressMinBytes_.load(std::memory_order_relaxed), body, &compressed)) {
+        BinaryRpcCodec::encode(&writeBuf, type, seq, metaRaw, compressed, version, kRpcFlagCompressed);
+    }
+    else {
+        BinaryRpcCodec::encode(&writeBuf, type, seq, metaRaw, body, version);
+    }
+    return writeBuf.read_from_buffer();
+}
+
+void BinaryRpcChannel::set_compression_options(const CompressionOptions& options) {
+    {
+        std::lock_guard<std::mutex> lock(mapMutex_);
+        compressionOptions_ = options;
+    }
+    compressMinBytes_.store(options.minBytes, std::memory_order_relaxed);
+    if (options.accepted.empty()) {
+        compression_.store(static_cast<uint8_t>(CompressionType::None));
+    }
+    if (running_) {
+        enqueue_frame(encode_method_table_request());
+    }
+}
+
+std::string BinaryRpcChannel::encode_method_table_request() {
+    RpcMethodTable request;
+    {
+        std::lock_guard<std::mutex> lock(mapMutex_);
+        for (CompressionType type : compressionOptions_.accepted) {
+            request.add_accept_compression(static_cast<uint32_t>(type));
+        }
+    }
+
     Buffer writeBuf;
-    BinaryRpcCodec::encode(&writeBuf, RpcMessageType::Request, seq, metaRaw, bodyRaw);
+    BinaryRpcCodec::encode(&writeBuf, RpcMessageType::MethodTable, nextSequenceId_++, "", request.SerializeAsString(), kRpcVersionMethodId);
     return writeBuf.read_from_buffer();
 }
 
+void BinaryRpcChannel::apply_method_table(const std::string& tableRaw) {
+    RpcMethodTable table;
+    if (!table.ParseFromString(tableRaw)) {
+        spdlog::warn("BinaryRpcChannel: Failed to parse method table, falling back to method names");
+        return;
+    }
+
+    // 只收录本进程生成代码中存在的方法；未识别的方法继续按名称调用
+    std::unordered_map<const google::protobuf::MethodDescriptor*, uint32_t> methodIds;
+    const google::protobuf::DescriptorPool* pool = google::protobuf::DescriptorPool::generated_pool();
+    for (const RpcMethodEntry& entry : table.methods()) {
+        const google::protobuf::MethodDescriptor* method =
+            pool->FindMethodByName(entry.service_name() + "." + entry.method_name());
+        if (method != nullptr && entry.method_id() != 0) {
+            methodIds[method] = entry.method_id();
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(mapMutex_);
+    methodIds_.swap(methodIds);
+
+    // 只采用本端仍然接受且已编入的算法，防止异常的服务端选出本端无法处理的算法
+    const CompressionType chosen = static_cast<CompressionType>(table.compression());
+    const std::vector<CompressionType>& accepted = compressionOptions_.accepted;
+    const bool usable = BinaryRpcCompression::is_supported(chosen)
+        && std::find(accepted.begin(), accepted.end(), chosen) != accepted.end();
+    compression_.store(static_cast<uint8_t>(usable ? chosen : CompressionType::None));
+}
+
 } // namespace binary
 } // namespace rpc
 } // namespace tudou
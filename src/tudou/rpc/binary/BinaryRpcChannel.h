@@ -15,8 +15,15 @@
 #include <thread>
 #include <atomic>
 #include <memory>
+#include <functional>
+#include <chrono>
+#include <deque>
 #include "tudou/rpc/Coroutine.h"
+#include "tudou/rpc/binary/BinaryRpcStream.h"
+#include "tudou/rpc/binary/BinaryRpcCompression.h"
 #include "tudou/tcp/Buffer.h"
+#include "tudou/tcp/InetAddress.h"
+#include "tudou/timer/Timer.h"
 
 class Channel;
 class EventLoop;
@@ -25,18 +32,54 @@ namespace tudou {
 namespace rpc {
 namespace binary {
 
+class BinaryRpcClientLoopPool;
+class BinaryRpcController;
+class BinaryRpcShmTransport;
+
+// 事件驱动模式下连接承载帧的方式
+enum class ChannelTransport {
+    Socket,       // TCP 或 Unix 域 socket
+    SharedMemory  // 同机共享内存环形缓冲，经服务端 listen_shared_memory() 的 Unix 域地址握手
+};
+
+/**
+ * @brief 二进制 RPC 客户端通道，支持三种驱动方式：
+ *        1. 阻塞线程模式：每个 Channel 一个后台接收线程，调用方以 promise/future 同步等待；
+ *        2. 绑定调用方 EventLoop：连接读写由该 loop 驱动，协程内调用只挂起协程；
+ *        3. 共享客户端 loop 池：多个 Channel 轮询挂到 BinaryRpcClientLoopPool 的少量线程上。
+ *        模式 2、3 下读路径经 Buffer::read_from_fd 走 readv，写路径先把编码好的帧放入发送队列，
+ *        同一轮事件循环内的多次调用由一次 writev 合并写出；调用方可选协程挂起、done 回调或 future 三种等待方式。
+ *        模式 1 下并发调用方同样只入队，由抢到写权的那个调用方一次 writev 写出全部排队帧。
+ *        调用可设时限（BinaryRpcController::set_timeout 或 set_default_timeout），事件驱动模式下由 loop 的 TimerQueue 计时；
+ *        超时或 StartCancel() 时调用以失败结束、挂起表项被移除，并向服务端发送 Cancel 帧。
+ *        open_stream() 在同一连接上打开带流控窗口的双向消息流，与一元调用共享序列号空间并交错传输。
+ *        set_compression_options() 与服务端协商载荷压缩，协商成功后超过阈值的请求与流消息压缩发送。
+ *        服务端地址可以是 Unix 域地址；模式 2、3 还可选 ChannelTransport::SharedMemory，请求与回包经共享内存环传递，
+ *        只在对端空闲等待时才以 eventfd 唤醒，此时仅支持一元调用且不压缩。
+ */
 class BinaryRpcChannel : public google::protobuf::RpcChannel {
 public:
     /**
-     * @brief 构造函数，建立连接并拉起后台接收线程
+     * @brief 构造函数，建立连接并拉起后台接收线程。连接建立后自动发起方法 ID 协商
      */
     BinaryRpcChannel(const std::string& ip, uint16_t port);
-    
+    explicit BinaryRpcChannel(const InetAddress& serverAddr);
+
     /**
-     * @brief 构造函数，绑定 EventLoop 并启用非阻塞事件驱动模型（协程版）
+     * @brief 构造函数，绑定 EventLoop 并启用非阻塞事件驱动模型（协程版）。
+     *        Channel 需在该 loop 线程内析构，或在 loop 仍在运行时从其它线程析构。
      */
     BinaryRpcChannel(EventLoop* loop, const std::string& ip, uint16_t port);
-    
+    BinaryRpcChannel(EventLoop* loop, const InetAddress& serverAddr, ChannelTransport transport = ChannelTransport::Socket);
+
+    /**
+     * @brief 构造函数，从共享客户端 loop 池中轮询选取一个 EventLoop 驱动本连接
+     */
+    BinaryRpcChannel(std::shared_ptr<BinaryRpcClientLoopPool> loopPool, const std::string& ip, uint16_t port);
+    BinaryRpcChannel(std::shared_ptr<BinaryRpcClientLoopPool> loopPool,
+                     const InetAddress& serverAddr,
+                     ChannelTransport transport = ChannelTransport::Socket);
+
     /**
      * @brief 析构函数，优雅释放后台线程并清理挂起请求
      */
@@ -47,8 +90,12 @@ public:
     BinaryRpcChannel& operator=(const BinaryRpcChannel&) = delete;
 
     /**
-     * @brief 客户端 Stub 调用的核心纯虚函数覆写。
-     *        支持多线程并发调用。内部通过唯一 sequence ID 隔离并利用 promise/future 同步挂起唤醒。
+     * @brief 客户端 Stub 调用的核心纯虚函数覆写，支持多线程并发调用，内部通过唯一 sequence ID 隔离。
+     *        - 当前处于协程中且为事件驱动模式：挂起协程，回包后由 EventLoop 唤醒；
+     *        - 事件驱动模式且 done 非空：立即返回，回包、超时或取消后都在本 Channel 的 loop 线程调用 done（失败时先 controller->SetFailed）；
+     *        - 其余情况：阻塞当前线程直到回包（事件驱动模式下禁止在本 Channel 的 loop 线程中阻塞等待）。
+     *        controller 为 BinaryRpcController 时读取其时限并支持 StartCancel()；超时或取消在协程与阻塞路径上抛出
+     *        std::runtime_error，在回调路径上经 controller->SetFailed() 报告后照常执行 done。
      */
     void CallMethod(const google::protobuf::MethodDescriptor* method,
                     google::protobuf::RpcController* controller,
@@ -56,15 +103,109 @@ public:
                     google::protobuf::Message* response,
                     google::protobuf::Closure* done) override;
 
+    /**
+     * @brief future 风格的异步调用：立即返回，回包写入 response 后 future 就绪，失败时 future 携带异常。
+     *        response 需存活到 future 就绪。
+     */
+    std::future<void> call_async(const google::protobuf::MethodDescriptor* method,
+                                 const google::protobuf::Message* request,
+                                 google::protobuf::Message* response);
+
+    /**
+     * @brief 回调风格的异步调用（仅事件驱动模式）：回包或失败后在本 Channel 的 loop 线程调用 onComplete，
+     *        成功时参数为空，失败时携带异常。供 BinaryRpcPooledChannel 等上层组合使用
+     */
+    void call_async(const google::protobuf::MethodDescriptor* method,
+                    const google::protobuf::Message* request,
+                    google::protobuf::Message* response,
+                    std::function<void(std::exception_ptr)> onComplete);
+
+    /**
+     * @brief 打开一条到服务端流式方法的双向消息流，立即返回，不等待服务端确认。
+     *        window 为本端接收窗口（消息条数），同时告知服务端作为其发送额度。方法不存在或服务端拒绝时，
+     *        首次 read() 返回 false 且 get_error() 给出原因。连接失效或 Channel 析构时流被取消；流须在 Channel 析构前停止使用
+     */
+    std::shared_ptr<BinaryRpcStream> open_stream(const google::protobuf::MethodDescriptor* method,
+                                                 uint32_t window = kDefaultStreamWindow);
+
+    /**
+     * @brief 设置未通过 BinaryRpcController 指定时限的调用所用的默认时限，0 表示不限时。线程安全
+     */
+    void set_default_timeout(std::chrono::milliseconds timeout) { defaultTimeoutMs_ = timeout.count(); }
+
+    /**
+     * @brief 设置本端接受的压缩算法（按偏好排序）与发送时的压缩阈值，并立即向服务端重新发起协商。
+     *        服务端回包确定算法之前请求保持不压缩；accepted 为空时停止压缩。线程安全
+     */
+    void set_compression_options(const CompressionOptions& options);
+
+    /**
+     * @brief 当前与服务端协商得到的压缩算法
+     */
+    CompressionType get_compression() const { return static_cast<CompressionType>(compression_.load()); }
+
+    /**
+     * @brief 本连接累计写出 / 读入 socket 的字节数（含帧头），用于观察压缩前后的线路字节数
+     */
+    uint64_t get_bytes_sent() const { return bytesSent_.load(std::memory_order_relaxed); }
+    uint64_t get_bytes_received() const { return bytesReceived_.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief 连接是否已失效（连接失败、对端关闭、协议错误或已析构），失效后的调用立即抛出异常
+     */
+    bool is_closed() const { return !running_; }
+
+    /**
+     * @brief 设置写合并的逗留时间（默认 0，即不逗留）。大于 0 时首帧入队后等待该时长再刷写，
+     *        以少量延迟换取更多帧合并进同一次 writev，类似 Nagle 算法。线程安全，对之后入队的帧生效
+     */
+    void set_write_linger(std::chrono::microseconds linger) { writeLingerUs_ = linger.count(); }
+
+    /**
+     * @brief 返回驱动本连接的 EventLoop，阻塞线程模式下为 nullptr
+     */
+    EventLoop* get_loop() const { return loop_; }
+
 private:
     // 单次请求的响应上下文结构
     struct ResponseContext {
         google::protobuf::Message* response;
         std::promise<void> promise;
-        std::shared_ptr<Coroutine> coroutine; // 关联的协程上下文
-        std::exception_ptr exception;         // 缓存的异常指针
+        std::shared_ptr<Coroutine> coroutine;             // 关联的协程上下文
+        google::protobuf::Closure* done = nullptr;        // 回调模式下回包后执行的闭包
+        google::protobuf::RpcController* controller = nullptr; // 回调模式下用于上报失败
+        std::function<void(std::exception_ptr)> callback; // 函数回调模式下的完成通知
+        uint64_t sequenceId = 0;
+        TimerId deadlineTimer;                            // 事件驱动模式下的超时定时器
+        BinaryRpcController* cancelController = nullptr;  // 安装了取消钩子的控制器，完成时拆除钩子
+        std::exception_ptr exception;                     // 缓存的异常指针
     };
 
+    /**
+     * @brief 建立非阻塞连接，并在 loop 线程内注册 Channel（模式 2、3 共用）
+     */
+    void open_nonblocking(const InetAddress& serverAddr);
+
+    /**
+     * @brief 经 Unix 域地址握手取得共享内存会话，并在 loop 线程内注册 socket 与门铃的 Channel
+     */
+    void open_shared_memory(const InetAddress& serverAddr);
+
+    /**
+     * @brief 共享内存模式下的收发循环：取走入站环数据拆包分发、写出排队帧，直到可以安全地公布等待标记
+     */
+    void pump_shared_memory();
+
+    /**
+     * @brief 把 writingFrames_ 尽量写入出站环，环满时保留剩余部分等待对端腾出空间
+     */
+    void write_shared_memory();
+
+    /**
+     * @brief 在 loop 线程内注销 Channel 并关闭 fd
+     */
+    void teardown_in_loop();
+
     /**
      * @brief 后台接收线程的循环体，专职从 Socket 读取字节并进行 BinaryRpcCodec 拆包分发
      */
@@ -80,11 +221,93 @@ private:
      */
     void on_write();
 
-    void write_request_nonblocking(const std::string& data);
+    /**
+     * @brief 从读缓冲中原地拆出全部完整帧并分发给对应的挂起请求，协议错误时返回 false
+     */
+    bool dispatch_responses(Buffer* buf);
+
+    /**
+     * @brief 把服务端发来的流式帧投递给对应的流，流结束或被取消时从流表中移除
+     */
+    void dispatch_stream_frame(const RpcHeader& header, const char* metaData, const char* body, size_t bodyLen);
+
+    /**
+     * @brief 事件驱动模式的发送入口：帧入队，队列由空变非空时投递一次刷写任务（有逗留时间时延后执行）
+     */
+    void send_frame(std::string frame);
+
+    /**
+     * @brief 在 loop 线程把排队帧以 writev 尽量写入 Socket，写不完时开启可写事件
+     */
+    void flush_output();
+
+    /**
+     * @brief 阻塞线程模式的发送入口：帧入队，没有其它调用方在写时由本调用方接过写权，
+     *        循环取走整批排队帧阻塞写出，直到队列为空
+     */
+    void send_frame_blocking(std::string frame);
+
+    /**
+     * @brief 连接失败或对端关闭时停止读写，并唤醒全部挂起请求
+     */
+    void fail_connection(const std::string& reason);
+
+    /**
+     * @brief 登记挂起请求并编码发送：阻塞线程模式下同步写出，事件驱动模式下交给 send_frame 合并发送。
+     *        编码或写入失败时撤销登记并抛出异常
+     */
+    void submit_request(const google::protobuf::MethodDescriptor* method,
+                        const google::protobuf::Message* request,
+                        const std::shared_ptr<ResponseContext>& context,
+                        std::chrono::milliseconds timeout);
+
+    /**
+     * @brief 放弃一个仍在挂起的请求（超时或取消）：移出挂起表、通知服务端取消并以 reason 失败结束。
+     *        请求已完成时返回 false
+     */
+    bool abandon_request(uint64_t seq, const std::string& reason);
+
+    /**
+     * @brief 计算本次调用的时限：优先取 BinaryRpcController 的设置，否则使用默认时限
+     */
+    std::chrono::milliseconds resolve_timeout(const BinaryRpcController* controller) const;
+
+    /**
+     * @brief 按驱动模式把一帧交给对应的发送路径
+     */
+    void enqueue_frame(std::string frame);
+
+    /**
+     * @brief 按请求的等待方式完成一次调用：唤醒协程、执行 done 或兑现 promise
+     */
+    void complete_request(const std::shared_ptr<ResponseContext>& context, std::exception_ptr error);
+
+    /**
+     * @brief 回调路径的完成：执行 call_async 的回调，或在失败时写入 controller 后执行 done
+     */
+    static void run_completion_callback(const std::shared_ptr<ResponseContext>& context, std::exception_ptr error);
 
     std::string encode_request(const google::protobuf::MethodDescriptor* method,
                                const google::protobuf::Message* request,
-                               uint64_t seq);
+                               uint64_t seq,
+                               uint32_t methodId,
+                               std::chrono::milliseconds timeout);
+
+    /**
+     * @brief 按协商结果把一帧编码为字符串，Body 超过阈值时压缩并置位 kRpcFlagCompressed
+     */
+    std::string encode_frame(RpcMessageType type, uint64_t seq, const std::string& metaRaw,
+                             const std::string& body, uint8_t version);
+
+    /**
+     * @brief 编码方法表协商帧，携带当前接受的压缩算法。连接建立后立即发送，服务端回包前请求仍按 version 1 携带完整方法名
+     */
+    std::string encode_method_table_request();
+
+    /**
+     * @brief 解析服务端回传的方法表，把本进程可识别的方法映射到紧凑 ID
+     */
+    void apply_method_table(const std::string& tableRaw);
 
     /**
      * @brief 网络中断或析构时触发，将异常传入所有仍在挂起等待的连接，防止线程永久卡死
@@ -98,18 +321,45 @@ private:
     std::atomic<bool> running_{true};
     std::thread receiverThread_;
 
-    std::mutex sendMutex_; // 保护并发 Socket 写入
+    std::mutex sendMutex_; // 保护发送队列与写权标记
     std::mutex mapMutex_;  // 保护全局 pending 映射表访问
 
     // 缓存挂起的请求会话: sequenceId -> ResponseContext
     std::unordered_map<uint64_t, std::shared_ptr<ResponseContext>> pendingRequests_;
 
-    // 非阻塞 EventLoop 模式专有变量
+    // 打开中的流: streamId -> BinaryRpcStream，与 pendingRequests_ 共用 mapMutex_ 保护
+    std::unordered_map<uint64_t, std::shared_ptr<BinaryRpcStream>> streams_;
+
+    // 协商得到的方法 ID: MethodDescriptor -> methodId，与 pendingRequests_ 共用 mapMutex_ 保护
+    std::unordered_map<const google::protobuf::MethodDescriptor*, uint32_t> methodIds_;
+
+    // 两种模式共用的写合并状态
+    std::deque<std::string> pendingFrames_;     // 待发送的完整帧，受 sendMutex_ 保护
+    bool writerActive_ = false;                 // 阻塞线程模式下是否已有调用方持有写权，受 sendMutex_ 保护
+    std::atomic<int64_t> writeLingerUs_{0};     // 写合并逗留时间（微秒）
+    std::atomic<int64_t> defaultTimeoutMs_{0};  // 默认调用时限（毫秒），0 表示不限时
+
+    // 载荷压缩
+    CompressionOptions compressionOptions_;     // 受 mapMutex_ 保护
+    std::atomic<uint8_t> compression_{0};       // 服务端选定的算法（CompressionType）
+    std::atomic<size_t> compressMinBytes_{0};   // 发送时的压缩阈值
+    std::atomic<uint64_t> bytesSent_{0};
+    std::atomic<uint64_t> bytesReceived_{0};
+
+    // 事件驱动模式专有变量
+    std::shared_ptr<BinaryRpcClientLoopPool> loopPool_; // 共享 loop 池模式下持有线程池，保证其晚于本 Channel 销毁
     EventLoop* loop_ = nullptr;
-    std::unique_ptr<Channel> channel_;
-    Buffer readBuf_;
-    std::string writeBuffer_;
-    bool connected_ = false;
+    std::unique_ptr<Channel> channel_;  // 只在 loop 线程内创建与销毁
+    Buffer readBuf_;                    // 只在 loop 线程内访问
+    std::deque<std::string> writingFrames_; // 已从发送队列取出、正在写出的帧，只在 loop 线程内访问
+    size_t writingOffset_ = 0;          // writingFrames_ 首帧已写出的字节数
+    bool flushQueued_ = false;          // 是否已投递刷写任务，受 sendMutex_ 保护
+    bool connected_ = false;            // 非阻塞 connect 是否已完成，只在 loop 线程内访问
+    std::shared_ptr<char> lifeToken_;   // 投递到 loop 的任务以 weak_ptr 判断 Channel 是否仍存活
+
+    // 共享内存模式专有变量，只在 loop 线程内访问
+    std::unique_ptr<BinaryRpcShmTransport> shm_;
+    std::unique_ptr<Channel> doorbellChannel_;
 };
 
 } // namespace binary
@@ -0,0 +1,49 @@
+/**
+ * @file BinaryRpcClientLoopPool.cpp
+ * @brief 供多个 BinaryRpcChannel 共享的客户端 EventLoop 线程池实现
+ * @author wenxingming
+ * @project: https://github.com/WenXingming/Tudou
+ */
+
+#include "BinaryRpcClientLoopPool.h"
+#include "tudou/reactor/EventLoopThread.h"
+#include "tudou/reactor/EventLoop.h"
+
+#include <stdexcept>
+
+namespace tudou {
+namespace rpc {
+namespace binary {
+
+BinaryRpcClientLoopPool::BinaryRpcClientLoopPool(int numThreads) {
+    if (numThreads <= 0) {
+        throw std::invalid_argument("BinaryRpcClientLoopPool: numThreads must be > 0");
+    }
+
+    loopThreads_.reserve(static_cast<size_t>(numThreads));
+    for (int index = 0; index < numThreads; ++index) {
+        // EventLoopThread 构造时阻塞等待 loop 就绪，返回后即可投递任务
+        loopThreads_.push_back(std::make_unique<EventLoopThread>());
+    }
+}
+
+// EventLoopThread 析构时请求 loop 退出并 join 线程
+BinaryRpcClientLoopPool::~BinaryRpcClientLoopPool() = default;
+
+EventLoop* BinaryRpcClientLoopPool::get_next_loop() {
+    const size_t index = nextIndex_.fetch_add(1, std::memory_order_relaxed) % loopThreads_.size();
+    return loopThreads_[index]->get_loop();
+}
+
+bool BinaryRpcClientLoopPool::is_in_pool_thread() const {
+    for (const auto& loopThread : loopThreads_) {
+        if (loopThread->get_loop()->is_in_loop_thread()) {
+            return true;
+        }
+    }
+    return false;
+}
+
+} // namespace binary
+} // namespace rpc
+} // namespace tudou
@@ -0,0 +1,59 @@
+/**
+ * @file BinaryRpcClientLoopPool.h
+ * @brief 供多个 BinaryRpcChannel 共享的客户端 EventLoop 线程池声明
+ * @author wenxingming
+ * @project: https://github.com/WenXingming/Tudou
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+class EventLoop;
+class EventLoopThread;
+
+namespace tudou {
+namespace rpc {
+namespace binary {
+
+/**
+ * @brief 客户端 EventLoop 线程池。
+ *        每个线程跑一个 EventLoop，新建的 BinaryRpcChannel 轮询挂到其中一个 loop 上，
+ *        由该 loop 负责连接的读写与回包分发。进程内 1000 条上游连接也只需 N 个线程，而不是每连接一个接收线程。
+ *        Channel 持有线程池的 shared_ptr，保证线程池晚于所有挂在其上的 Channel 销毁。
+ */
+class BinaryRpcClientLoopPool {
+public:
+    /**
+     * @param numThreads 后台 EventLoop 线程数，必须大于 0
+     */
+    explicit BinaryRpcClientLoopPool(int numThreads);
+    ~BinaryRpcClientLoopPool();
+
+    // 禁用拷贝构造和赋值
+    BinaryRpcClientLoopPool(const BinaryRpcClientLoopPool&) = delete;
+    BinaryRpcClientLoopPool& operator=(const BinaryRpcClientLoopPool&) = delete;
+
+    /**
+     * @brief 轮询选择下一个 EventLoop，线程安全
+     */
+    EventLoop* get_next_loop();
+
+    /**
+     * @brief 当前线程是否为池中某个 EventLoop 的线程
+     */
+    bool is_in_pool_thread() const;
+
+    size_t size() const { return loopThreads_.size(); }
+
+private:
+    std::vector<std::unique_ptr<EventLoopThread>> loopThreads_;
+    std::atomic<size_t> nextIndex_{0};
+};
+
+} // namespace binary
+} // namespace rpc
+} // namespace tudou
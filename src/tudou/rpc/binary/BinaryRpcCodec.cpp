@@ -19,11 +19,13 @@ void BinaryRpcCodec::encode(Buffer* buf,
                             RpcMessageType type,
                             uint64_t sequenceId,
                             const std::string& metaBytes,
-                            const std::string& bodyBytes) {
+                            const std::string& bodyBytes,
+                            uint8_t version,
+                            uint8_t flags) {
     RpcHeader header;
     header.magic = htons(kRpcMagic);
-    header.version = kRpcVersion;
-    header.type = static_cast<uint8_t>(type);
+    header.version = version;
+    header.type = static_cast<uint8_t>(static_cast<uint8_t>(type) | flags);
     header.sequenceId = htobe64(sequenceId);
     header.metaLen = htonl(static_cast<uint32_t>(metaBytes.size()));
     header.bodyLen = htonl(static_cast<uint32_t>(bodyBytes.size()));
@@ -46,12 +48,31 @@ BinaryRpcCodec::DecodeResult BinaryRpcCodec::decode(Buffer* buf,
                                                     RpcHeader& outHeader,
                                                     std::string& outMetaBytes,
                                                     std::string& outBodyBytes) {
+    const char* meta = nullptr;
+    const char* body = nullptr;
+    DecodeResult result = peek(buf, outHeader, meta, body);
+    if (result != DecodeResult::Success) {
+        return result;
+    }
+
+    // 组装元数据与载荷字节流，再一次性消费整帧
+    outMetaBytes.assign(meta, outHeader.metaLen);
+    outBodyBytes.assign(body, outHeader.bodyLen);
+    buf->advance_read_index(frame_size(outHeader));
+
+    return DecodeResult::Success;
+}
+
+BinaryRpcCodec::DecodeResult BinaryRpcCodec::peek(const Buffer* buf,
+                                                  RpcHeader& outHeader,
+                                                  const char*& outMeta,
+                                                  const char*& outBody) {
     // 缓冲区大小不足以解析出一个固定头部 (20 字节)
     if (buf->readable_bytes() < kRpcHeaderSize) {
         return DecodeResult::Empty;
     }
 
-    // 1. 预先窥探（peek）数据头部，不推进读指针，防止因为后续半包导致读指针割裂
+    // 1. 窥探（peek）数据头部，不推进读指针，防止因为后续半包导致读指针割裂
     RpcHeader header;
     std::memcpy(&header, buf->readable_start_ptr(), kRpcHeaderSize);
 
@@ -63,32 +84,14 @@ BinaryRpcCodec::DecodeResult BinaryRpcCodec::decode(Buffer* buf,
 
     uint32_t metaLen = ntohl(header.metaLen);
     uint32_t bodyLen = ntohl(header.bodyLen);
-    size_t totalPacketSize = kRpcHeaderSize + metaLen + bodyLen;
+    size_t totalPacketSize = kRpcHeaderSize + static_cast<size_t>(metaLen) + bodyLen;
 
     // 3. 校验当前缓冲区可读字节数是否足以拼成一个完整包
     if (buf->readable_bytes() < totalPacketSize) {
         return DecodeResult::HalfPack; // 半包，等待下次数据到达
     }
 
-    // 4. 正式消费头部，推进读指针
-    buf->advance_read_index(kRpcHeaderSize);
-
-    // 5. 组装元数据与载荷字节流并消费对应空间
-    if (metaLen > 0) {
-        outMetaBytes.assign(buf->readable_start_ptr(), metaLen);
-        buf->advance_read_index(metaLen);
-    } else {
-        outMetaBytes.clear();
-    }
-
-    if (bodyLen > 0) {
-        outBodyBytes.assign(buf->readable_start_ptr(), bodyLen);
-        buf->advance_read_index(bodyLen);
-    } else {
-        outBodyBytes.clear();
-    }
-
-    // 6. 将帧头网络字节序还原回主机字节序导出
+    // 4. 将帧头网络字节序还原回主机字节序导出，Meta 与 Body 直接指向 Buffer 内部
     outHeader.magic = magic;
     outHeader.version = header.version;
     outHeader.type = header.type;
@@ -96,6 +99,9 @@ BinaryRpcCodec::DecodeResult BinaryRpcCodec::decode(Buffer* buf,
     outHeader.metaLen = metaLen;
     outHeader.bodyLen = bodyLen;
 
+    outMeta = buf->readable_start_ptr() + kRpcHeaderSize;
+    outBody = outMeta + metaLen;
+
     return DecodeResult::Success;
 }
 
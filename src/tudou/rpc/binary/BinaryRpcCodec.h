@@ -34,12 +34,16 @@ public:
      * @param sequenceId 会话序列 ID
      * @param metaBytes 元数据字符流
      * @param bodyBytes 消息体载荷字符流
+     * @param version 协议版本号
+     * @param flags 与消息类型按位或写入 Type 字节的标志位（如 kRpcFlagCompressed）
      */
     static void encode(Buffer* buf,
                        RpcMessageType type,
                        uint64_t sequenceId,
                        const std::string& metaBytes,
-                       const std::string& bodyBytes);
+                       const std::string& bodyBytes,
+                       uint8_t version = kRpcVersion,
+                       uint8_t flags = 0);
 
     /**
      * @brief 尝试从接收 Buffer 中解码出一个完整的 RPC 二进制数据帧。
@@ -53,6 +57,28 @@ public:
                                RpcHeader& outHeader,
                                std::string& outMetaBytes,
                                std::string& outBodyBytes);
+
+    /**
+     * @brief 零拷贝窥探 Buffer 头部的一个完整帧，不推进读指针。
+     *        成功时 outMeta / outBody 直接指向 Buffer 内部的可读区，调用方在消费完毕后
+     *        再以 buf->advance_read_index(frame_size(outHeader)) 一次性推进读指针；
+     *        推进或向 Buffer 写入之前指针始终有效。
+     * @param buf 输入数据 Buffer
+     * @param outHeader 输出解码后的帧头信息（主机字节序），type 保留标志位，以 frame_type() 取消息类型
+     * @param outMeta 输出元数据在 Buffer 中的起始地址，长度为 outHeader.metaLen
+     * @param outBody 输出消息体在 Buffer 中的起始地址，长度为 outHeader.bodyLen
+     */
+    static DecodeResult peek(const Buffer* buf,
+                             RpcHeader& outHeader,
+                             const char*& outMeta,
+                             const char*& outBody);
+
+    /**
+     * @brief 返回帧头描述的整帧字节数（固定头部 + Meta + Body）
+     */
+    static size_t frame_size(const RpcHeader& header) {
+        return kRpcHeaderSize + header.metaLen + header.bodyLen;
+    }
 };
 
 } // namespace binary
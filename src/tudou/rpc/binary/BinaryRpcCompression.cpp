@@ -0,0 +1,173 @@
+/**
+ * @file BinaryRpcCompression.cpp
+ * @brief 二进制 RPC 帧载荷压缩算法实现
+ * @author wenxingming
+ * @project: https://github.com/WenXingming/Tudou
+ */
+
+#include "BinaryRpcCompression.h"
+
+#include <algorithm>
+#include <limits>
+
+#if TUDOU_HAS_ZLIB
+#include <zlib.h>
+#endif
+#if TUDOU_HAS_LZ4
+#include <lz4.h>
+#endif
+#if TUDOU_HAS_ZSTD
+#include <zstd.h>
+#endif
+
+namespace tudou {
+namespace rpc {
+namespace binary {
+
+namespace {
+
+constexpr size_t kMaxPooledCapacity = 4 * 1024 * 1024; // 复用缓冲超过该容量时在下次使用前收缩，避免单个大包长期占住内存
+constexpr int kZlibLevel = 1;                            // 以速度优先的压缩级别
+constexpr int kZstdLevel = 1;
+
+void write_prefix(char* out, CompressionType type, uint32_t rawSize) {
+    out[0] = static_cast<char>(type);
+    out[1] = static_cast<char>((rawSize >> 24) & 0xFF);
+    out[2] = static_cast<char>((rawSize >> 16) & 0xFF);
+    out[3] = static_cast<char>((rawSize >> 8) & 0xFF);
+    out[4] = static_cast<char>(rawSize & 0xFF);
+}
+
+uint32_t read_raw_size(const char* prefix) {
+    const unsigned char* bytes = reinterpret_cast<const unsigned char*>(prefix);
+    return (static_cast<uint32_t>(bytes[1]) << 24) | (static_cast<uint32_t>(bytes[2]) << 16)
+        | (static_cast<uint32_t>(bytes[3]) << 8) | static_cast<uint32_t>(bytes[4]);
+}
+
+// 压缩到 dst，返回压缩后字节数，失败或算法未编入时返回 0
+size_t compress_block(CompressionType type, const char* src, size_t srcLen, std::string* dst, size_t offset) {
+    switch (type) {
+#if TUDOU_HAS_ZLIB
+    case CompressionType::Zlib: {
+        uLongf bound = compressBound(static_cast<uLong>(srcLen));
+        dst->resize(offset + bound);
+        if (compress2(reinterpret_cast<Bytef*>(&(*dst)[offset]), &bound,
+                      reinterpret_cast<const Bytef*>(src), static_cast<uLong>(srcLen), kZlibLevel) != Z_OK) {
+            return 0;
+        }
+        return bound;
+    }
+#endif
+#if TUDOU_HAS_LZ4
+    case CompressionType::Lz4: {
+        const int bound = LZ4_compressBound(static_cast<int>(srcLen));
+        dst->resize(offset + static_cast<size_t>(bound));
+        const int written = LZ4_compress_default(src, &(*dst)[offset], static_cast<int>(srcLen), bound);
+        return written > 0 ? static_cast<size_t>(written) : 0;
+    }
+#endif
+#if TUDOU_HAS_ZSTD
+    case CompressionType::Zstd: {
+        const size_t bound = ZSTD_compressBound(srcLen);
+        dst->resize(offset + bound);
+        const size_t written = ZSTD_compress(&(*dst)[offset], bound, src, srcLen, kZstdLevel);
+        return ZSTD_isError(written) ? 0 : written;
+    }
+#endif
+    default:
+        return 0;
+    }
+}
+
+// 解压到 dst 的 [0, rawSize)，成功且长度恰好吻合时返回 true
+bool decompress_block(CompressionType type, const char* src, size_t srcLen, char* dst, size_t rawSize) {
+    switch (type) {
+#if TUDOU_HAS_ZLIB
+    case CompressionType::Zlib: {
+        uLongf destLen = static_cast<uLongf>(rawSize);
+        return uncompress(reinterpret_cast<Bytef*>(dst), &destLen,
+                          reinterpret_cast<const Bytef*>(src), static_cast<uLong>(srcLen)) == Z_OK
+            && destLen == rawSize;
+    }
+#endif
+#if TUDOU_HAS_LZ4
+    case CompressionType::Lz4:
+        return LZ4_decompress_safe(src, dst, static_cast<int>(srcLen), static_cast<int>(rawSize))
+            == static_cast<int>(rawSize);
+#endif
+#if TUDOU_HAS_ZSTD
+    case CompressionType::Zstd: {
+        const size_t written = ZSTD_decompress(dst, rawSize, src, srcLen);
+        return !ZSTD_isError(written) && written == rawSize;
+    }
+#endif
+    default:
+        return false;
+    }
+}
+
+} // namespace
+
+bool BinaryRpcCompression::is_supported(CompressionType type) {
+    switch (type) {
+    case CompressionType::Zlib:
+        return TUDOU_HAS_ZLIB != 0;
+    case CompressionType::Lz4:
+        return TUDOU_HAS_LZ4 != 0;
+    case CompressionType::Zstd:
+        return TUDOU_HAS_ZSTD != 0;
+    default:
+        return false;
+    }
+}
+
+CompressionType BinaryRpcCompression::negotiate(const std::vector<CompressionType>& offered,
+                                                const std::vector<CompressionType>& accepted) {
+    for (CompressionType type : offered) {
+        if (is_supported(type) && std::find(accepted.begin(), accepted.end(), type) != accepted.end()) {
+            return type;
+        }
+    }
+    return CompressionType::None;
+}
+
+bool BinaryRpcCompression::maybe_compress(CompressionType type, size_t minBytes, const std::string& body, std::string* out) {
+    if (type == CompressionType::None || body.size() < minBytes || body.size() > kMaxDecompressedSize) {
+        return false;
+    }
+
+    const size_t written = compress_block(type, body.data(), body.size(), out, kPrefixSize);
+    // 不可压缩的数据（已压缩的图片、随机字节）压缩后反而更长，此时原样发送
+    if (written == 0 || kPrefixSize + written >= body.size()) {
+        return false;
+    }
+    out->resize(kPrefixSize + written);
+    write_prefix(&(*out)[0], type, static_cast<uint32_t>(body.size()));
+    return true;
+}
+
+const std::string* BinaryRpcCompression::decompress(const char* data, size_t len) {
+    if (len < kPrefixSize || len - kPrefixSize > static_cast<size_t>(std::numeric_limits<int>::max())) {
+        return nullptr;
+    }
+    const CompressionType type = static_cast<CompressionType>(static_cast<uint8_t>(data[0]));
+    const size_t rawSize = read_raw_size(data);
+    if (!is_supported(type) || rawSize > kMaxDecompressedSize) {
+        return nullptr;
+    }
+
+    // 每个线程复用一块解压缓冲：解压结果只在反序列化期间使用，容量随最大载荷增长后留存，省去逐帧分配
+    thread_local std::string pooled;
+    if (pooled.capacity() > kMaxPooledCapacity && rawSize <= kMaxPooledCapacity) {
+        std::string().swap(pooled);
+    }
+    pooled.resize(rawSize);
+    if (rawSize > 0 && !decompress_block(type, data + kPrefixSize, len - kPrefixSize, &pooled[0], rawSize)) {
+        return nullptr;
+    }
+    return &pooled;
+}
+
+} // namespace binary
+} // namespace rpc
+} // namespace tudou
@@ -0,0 +1,71 @@
+/**
+ * @file BinaryRpcCompression.h
+ * @brief 二进制 RPC 帧载荷压缩算法声明
+ * @author wenxingming
+ * @project: https://github.com/WenXingming/Tudou
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace tudou {
+namespace rpc {
+namespace binary {
+
+// 载荷压缩算法，取值即线路上的算法编号
+enum class CompressionType : uint8_t {
+    None = 0,
+    Zlib = 1,
+    Lz4 = 2,
+    Zstd = 3
+};
+
+/**
+ * @brief 单端的压缩配置。accepted 按偏好顺序列出本端愿意使用的算法，为空表示不压缩；
+ *        客户端把列表随方法表协商帧发给服务端，服务端选出双方都支持的第一个算法。
+ *        协商成功后每一端各自按 minBytes 决定是否压缩本端发出的帧：小于阈值的载荷压缩收益抵不过 CPU 开销，保持原样发送。
+ */
+struct CompressionOptions {
+    std::vector<CompressionType> accepted;
+    size_t minBytes = 1024;
+};
+
+/**
+ * @brief 压缩后的 Body 自带 5 字节前缀：1 字节算法编号 + 4 字节原始长度（大端），接收方据此直接解压到预分配的缓冲中，
+ *        无需依赖连接上的协商状态。帧头 type 字节的最高位（kRpcFlagCompressed）标记 Body 是否经过压缩。
+ */
+class BinaryRpcCompression {
+public:
+    static constexpr size_t kPrefixSize = 5;
+    static constexpr size_t kMaxDecompressedSize = 64 * 1024 * 1024; // 拒绝声称超过 64MB 的载荷，防止解压炸弹
+
+    /**
+     * @brief 本构建是否编入了该算法（LZ4 / zstd 取决于构建时是否找到对应的库）
+     */
+    static bool is_supported(CompressionType type);
+
+    /**
+     * @brief 在 offered（对端偏好顺序）中选出本端 accepted 也包含且已编入的第一个算法，没有则返回 None
+     */
+    static CompressionType negotiate(const std::vector<CompressionType>& offered,
+                                     const std::vector<CompressionType>& accepted);
+
+    /**
+     * @brief 载荷不小于 minBytes 时尝试压缩，压缩后确实更短才写入 out 并返回 true；否则返回 false，调用方应原样发送
+     */
+    static bool maybe_compress(CompressionType type, size_t minBytes, const std::string& body, std::string* out);
+
+    /**
+     * @brief 解压带前缀的 Body。结果写入当前线程复用的缓冲并返回其指针，该缓冲在本线程下一次解压前有效；
+     *        前缀非法、算法未编入或数据损坏时返回 nullptr
+     */
+    static const std::string* decompress(const char* data, size_t len);
+};
+
+} // namespace binary
+} // namespace rpc
+} // namespace tudou
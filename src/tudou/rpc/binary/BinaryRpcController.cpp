@@ -0,0 +1,107 @@
+/**
+ * @file BinaryRpcController.cpp
+ * @brief 携带调用时限与取消能力的二进制 RPC 客户端控制器实现
+ * @author wenxingming
+ * @project: https://github.com/WenXingming/Tudou
+ */
+
+#include "BinaryRpcController.h"
+
+namespace tudou {
+namespace rpc {
+namespace binary {
+
+void BinaryRpcController::Reset() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    failed_ = false;
+    canceled_ = false;
+    errorText_.clear();
+    timeout_ = std::chrono::milliseconds(0);
+    cancelHook_ = nullptr;
+    cancelCallback_ = nullptr;
+}
+
+bool BinaryRpcController::Failed() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return failed_;
+}
+
+std::string BinaryRpcController::ErrorText() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return errorText_;
+}
+
+void BinaryRpcController::StartCancel() {
+    std::function<void()> hook;
+    google::protobuf::Closure* callback = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (canceled_) {
+            return;
+        }
+        canceled_ = true;
+        hook = std::move(cancelHook_);
+        cancelHook_ = nullptr;
+        callback = cancelCallback_;
+        cancelCallback_ = nullptr;
+    }
+
+    // 锁外执行：钩子会同步结束调用，进而回到本对象清理钩子与写入失败原因
+    if (hook) {
+        hook();
+    }
+    if (callback != nullptr) {
+        callback->Run();
+    }
+}
+
+void BinaryRpcController::SetFailed(const std::string& reason) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    failed_ = true;
+    errorText_ = reason;
+}
+
+bool BinaryRpcController::IsCanceled() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return canceled_;
+}
+
+void BinaryRpcController::NotifyOnCancel(google::protobuf::Closure* callback) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!canceled_) {
+            cancelCallback_ = callback;
+            return;
+        }
+    }
+    // 已取消时按 protobuf 约定立即执行
+    callback->Run();
+}
+
+void BinaryRpcController::set_timeout(std::chrono::milliseconds timeout) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    timeout_ = timeout;
+}
+
+std::chrono::milliseconds BinaryRpcController::get_timeout() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return timeout_;
+}
+
+bool BinaryRpcController::install_cancel_hook(std::function<void()> hook) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (canceled_) {
+        return false;
+    }
+    cancelHook_ = std::move(hook);
+    return true;
+}
+
+void BinaryRpcController::clear_cancel_hook() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    cancelHook_ = nullptr;
+}
+
+} // namespace binary
+} // namespace rpc
+} // namespace tudou
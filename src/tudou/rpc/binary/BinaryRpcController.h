@@ -0,0 +1,69 @@
+/**
+ * @file BinaryRpcController.h
+ * @brief 携带调用时限与取消能力的二进制 RPC 客户端控制器声明
+ * @author wenxingming
+ * @project: https://github.com/WenXingming/Tudou
+ */
+
+#pragma once
+
+#include <google/protobuf/service.h>
+#include <chrono>
+#include <functional>
+#include <mutex>
+#include <string>
+
+namespace tudou {
+namespace rpc {
+namespace binary {
+
+/**
+ * @brief 二进制 RPC 客户端控制器。
+ *        set_timeout() 为单次调用设置时限，超时后 BinaryRpcChannel 以失败结束调用并通知服务端取消；
+ *        StartCancel() 可在调用挂起期间从任意线程主动取消。一次调用结束后需 Reset() 才能复用。
+ */
+class BinaryRpcController : public google::protobuf::RpcController {
+public:
+    BinaryRpcController() = default;
+    ~BinaryRpcController() override = default;
+
+    // 禁用拷贝构造和赋值
+    BinaryRpcController(const BinaryRpcController&) = delete;
+    BinaryRpcController& operator=(const BinaryRpcController&) = delete;
+
+    void Reset() override;
+    bool Failed() const override;
+    std::string ErrorText() const override;
+    void StartCancel() override;
+    void SetFailed(const std::string& reason) override;
+    bool IsCanceled() const override;
+    void NotifyOnCancel(google::protobuf::Closure* callback) override;
+
+    /**
+     * @brief 设置本次调用的时限，0 表示沿用 Channel 的默认时限
+     */
+    void set_timeout(std::chrono::milliseconds timeout);
+    std::chrono::milliseconds get_timeout() const;
+
+private:
+    friend class BinaryRpcChannel;
+
+    /**
+     * @brief 由 Channel 在调用挂起期间安装取消钩子。若此前已被取消则不安装并返回 false
+     */
+    bool install_cancel_hook(std::function<void()> hook);
+    void clear_cancel_hook();
+
+private:
+    mutable std::mutex mutex_;
+    bool failed_ = false;
+    bool canceled_ = false;
+    std::string errorText_;
+    std::chrono::milliseconds timeout_{0};
+    std::function<void()> cancelHook_;                      // 取消挂起中的调用
+    google::protobuf::Closure* cancelCallback_ = nullptr;  // NotifyOnCancel 注册的回调，取消时执行一次
+};
+
+} // namespace binary
+} // namespace rpc
+} // namespace tudou
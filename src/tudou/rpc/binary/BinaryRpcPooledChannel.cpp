@@ -0,0 +1,398 @@
+/**
+ * @file BinaryRpcPooledChannel.cpp
+ * @brief 多端点、多连接、带负载均衡与断线重连的二进制 RPC 客户端通道实现
+ * @author wenxingming
+ * @project: https://github.com/WenXingming/Tudou
+ */
+
+#include "BinaryRpcPooledChannel.h"
+#include "BinaryRpcChannel.h"
+#include "BinaryRpcClientLoopPool.h"
+#include "tudou/reactor/EventLoop.h"
+#include "tudou/rpc/Coroutine.h"
+
+#include <algorithm>
+#include <future>
+#include <limits>
+#include <random>
+#include <stdexcept>
+#include <spdlog/spdlog.h>
+
+namespace tudou {
+namespace rpc {
+namespace binary {
+
+namespace {
+
+size_t random_index(size_t bound) {
+    thread_local std::minstd_rand engine(std::random_device{}());
+    return std::uniform_int_distribution<size_t>(0, bound - 1)(engine);
+}
+
+// 失效连接可能仍被其 loop 上排队的任务引用，统一投递回它自己的 loop 线程释放，
+// 避免在别的 loop 线程里跨线程同步析构而互相等待
+void release_on_own_loop(std::shared_ptr<BinaryRpcChannel> channel) {
+    if (!channel) {
+        return;
+    }
+    EventLoop* loop = channel->get_loop();
+    loop->queue_in_loop([channel]() mutable {
+        channel.reset();
+    });
+}
+
+} // namespace
+
+// 一次经由连接池发起的调用，连接失效重发时在不同 BinaryRpcChannel 之间传递
+struct BinaryRpcPooledChannel::PooledCall {
+    const google::protobuf::MethodDescriptor* method = nullptr;
+    google::protobuf::RpcController* controller = nullptr;
+    const google::protobuf::Message* request = nullptr;
+    google::protobuf::Message* response = nullptr;
+    google::protobuf::Closure* done = nullptr;
+    std::shared_ptr<Coroutine> coroutine;   // 协程模式下待唤醒的协程
+    std::exception_ptr exception;           // 协程模式下缓存的异常
+    std::promise<void> promise;             // 阻塞模式下的唤醒通道
+    int attempts = 0;                       // 已发送次数
+};
+
+BinaryRpcPooledChannel::BinaryRpcPooledChannel(std::shared_ptr<BinaryRpcClientLoopPool> loopPool,
+                                               const std::vector<BinaryRpcEndpoint>& endpoints,
+                                               const BinaryRpcPooledChannelOptions& options)
+    : loopPool_(std::move(loopPool))
+    , options_(options)
+    , lifeState_(std::make_shared<LifeState>()) {
+    if (!loopPool_) {
+        throw std::invalid_argument("BinaryRpcPooledChannel: loopPool must not be null");
+    }
+    if (endpoints.empty()) {
+        throw std::invalid_argument("BinaryRpcPooledChannel: endpoints must not be empty");
+    }
+    if (options_.connectionsPerEndpoint == 0) {
+        throw std::invalid_argument("BinaryRpcPooledChannel: connectionsPerEndpoint must be > 0");
+    }
+
+    // 端点交错排列，使轮询在 K 条连接之间也均匀覆盖所有端点
+    slots_.reserve(endpoints.size() * options_.connectionsPerEndpoint);
+    for (size_t round = 0; round < options_.connectionsPerEndpoint; ++round) {
+        for (const BinaryRpcEndpoint& endpoint : endpoints) {
+            auto slot = std::make_unique<Slot>();
+            slot->endpoint = endpoint;
+            slot->backoffSeconds = options_.initialReconnectBackoffSeconds;
+            slot->channel = std::make_shared<BinaryRpcChannel>(loopPool_, endpoint.ip, endpoint.port);
+            slot->channel->set_default_timeout(options_.callTimeout);
+            if (!options_.compression.accepted.empty()) {
+                slot->channel->set_compression_options(options_.compression);
+            }
+            slots_.push_back(std::move(slot));
+        }
+    }
+}
+
+BinaryRpcPooledChannel::~BinaryRpcPooledChannel() {
+    {
+        std::lock_guard<std::mutex> lock(lifeState_->mutex);
+        lifeState_->closing = true;
+    }
+
+    // 逐个关闭连接：BinaryRpcChannel 析构时以异常完成其挂起请求，closing 已置位因此不再转移重发
+    for (auto& slot : slots_) {
+        std::shared_ptr<BinaryRpcChannel> channel;
+        {
+            std::lock_guard<std::mutex> lock(slot->mutex);
+            channel = std::move(slot->channel);
+        }
+        channel.reset();
+    }
+}
+
+size_t BinaryRpcPooledChannel::healthy_connection_count() const {
+    size_t count = 0;
+    for (const auto& slot : slots_) {
+        std::lock_guard<std::mutex> lock(slot->mutex);
+        if (slot->channel && !slot->channel->is_closed()) {
+            ++count;
+        }
+    }
+    return count;
+}
+
+void BinaryRpcPooledChannel::CallMethod(const google::protobuf::MethodDescriptor* method,
+                                        google::protobuf::RpcController* controller,
+                                        const google::protobuf::Message* request,
+                                        google::protobuf::Message* response,
+                                        google::protobuf::Closure* done) {
+    auto call = std::make_shared<PooledCall>();
+    call->method = method;
+    call->controller = controller;
+    call->request = request;
+    call->response = response;
+
+    Coroutine* cur_coro = Coroutine::t_current_coroutine;
+    if (cur_coro != nullptr && cur_coro->get_loop() != nullptr) {
+        // 协程模式：挂起协程，回包后在协程所属 loop 中恢复
+        call->coroutine = cur_coro->shared_from_this();
+        start_call(call);
+        cur_coro->yield();
+
+        if (call->exception) {
+            std::rethrow_exception(call->exception);
+        }
+        if (done) {
+            done->Run();
+        }
+        return;
+    }
+
+    if (done != nullptr) {
+        // 回调模式：立即返回，回包后在对应连接的 loop 线程执行 done
+        call->done = done;
+        start_call(call);
+        return;
+    }
+
+    // 阻塞模式：回包由池中某个 loop 线程分发（重试时可能换到其它连接的 loop），在任一池线程中阻塞都可能死锁
+    if (loopPool_->is_in_pool_thread()) {
+        static const char* const kError = "BinaryRpcPooledChannel: Blocking call on a client loop pool thread";
+        if (controller != nullptr) {
+            controller->SetFailed(kError);
+        }
+        throw std::logic_error(kError);
+    }
+    std::future<void> future = call->promise.get_future();
+    start_call(call);
+    future.get();
+}
+
+void BinaryRpcPooledChannel::start_call(const std::shared_ptr<PooledCall>& call) {
+    size_t index = 0;
+    std::shared_ptr<BinaryRpcChannel> channel;
+    if (!pick_slot(index, channel)) {
+        finish_call(call, std::make_exception_ptr(
+            std::runtime_error("BinaryRpcPooledChannel: No healthy connection available")));
+        return;
+    }
+
+    Slot& slot = *slots_[index];
+    slot.outstanding.fetch_add(1, std::memory_order_relaxed);
+    ++call->attempts;
+
+    BinaryRpcChannel* raw = channel.get();
+    try {
+        channel->call_async(call->method, call->request, call->response,
+                            [this, call, index, raw](std::exception_ptr error) {
+                                this->on_call_complete(call, index, raw, error);
+                            });
+    }
+    catch (...) {
+        // 挑选后连接恰好失效时 call_async 直接抛出，与回包失败走同一条转移路径
+        on_call_complete(call, index, raw, std::current_exception());
+    }
+}
+
+void BinaryRpcPooledChannel::on_call_complete(const std::shared_ptr<PooledCall>& call,
+                                              size_t index,
+                                              BinaryRpcChannel* channel,
+                                              std::exception_ptr error) {
+    Slot& slot = *slots_[index];
+    slot.outstanding.fetch_sub(1, std::memory_order_relaxed);
+
+    if (!error) {
+        // 成功回包说明连接可用，重连退避回到初始值
+        std::lock_guard<std::mutex> lock(slot.mutex);
+        slot.backoffSeconds = options_.initialReconnectBackoffSeconds;
+    }
+    else if (channel->is_closed()) {
+        // 连接级失败：排队重连本槽位，并把请求转移到其它健康连接
+        schedule_reconnect(index, channel);
+
+        bool closing = false;
+        {
+            std::lock_guard<std::mutex> lock(lifeState_->mutex);
+            closing = lifeState_->closing;
+        }
+        if (!closing && call->attempts <= options_.maxRetries) {
+            spdlog::warn("BinaryRpcPooledChannel: Connection to {}:{} failed, moving request to another connection",
+                         slot.endpoint.ip, slot.endpoint.port);
+            start_call(call);
+            return;
+        }
+    }
+
+    finish_call(call, error);
+}
+
+void BinaryRpcPooledChannel::finish_call(const std::shared_ptr<PooledCall>& call, std::exception_ptr error) {
+    if (call->coroutine) {
+        call->exception = error;
+        EventLoop* origin_loop = call->coroutine->get_loop();
+        origin_loop->queue_in_loop([coro = call->coroutine]() {
+            coro->resume();
+        });
+    }
+    else if (call->done != nullptr) {
+        if (error) {
+            try {
+                std::rethrow_exception(error);
+            }
+            catch (const std::exception& e) {
+                if (call->controller != nullptr) {
+                    call->controller->SetFailed(e.what());
+                }
+                else {
+                    spdlog::warn("BinaryRpcPooledChannel: Async call failed without controller, error={}", e.what());
+                }
+            }
+        }
+        call->done->Run();
+    }
+    else if (error) {
+        call->promise.set_exception(error);
+    }
+    else {
+        call->promise.set_value();
+    }
+}
+
+std::shared_ptr<BinaryRpcChannel> BinaryRpcPooledChannel::healthy_channel(size_t index) {
+    std::shared_ptr<BinaryRpcChannel> channel;
+    {
+        std::lock_guard<std::mutex> lock(slots_[index]->mutex);
+        channel = slots_[index]->channel;
+    }
+
+    if (!channel) {
+        return nullptr;
+    }
+    if (channel->is_closed()) {
+        schedule_reconnect(index, channel.get());
+        return nullptr;
+    }
+    return channel;
+}
+
+bool BinaryRpcPooledChannel::pick_slot(size_t& index, std::shared_ptr<BinaryRpcChannel>& channel) {
+    const size_t slotCount = slots_.size();
+
+    switch (options_.policy) {
+    case LoadBalancePolicy::PowerOfTwoChoices: {
+        const size_t first = random_index(slotCount);
+        const size_t second = random_index(slotCount);
+        std::shared_ptr<BinaryRpcChannel> firstChannel = healthy_channel(first);
+        std::shared_ptr<BinaryRpcChannel> secondChannel = healthy_channel(second);
+        if (firstChannel && secondChannel) {
+            const bool preferSecond = slots_[second]->outstanding.load(std::memory_order_relaxed)
+                < slots_[first]->outstanding.load(std::memory_order_relaxed);
+            index = preferSecond ? second : first;
+            channel = preferSecond ? std::move(secondChannel) : std::move(firstChannel);
+            return true;
+        }
+        if (firstChannel || secondChannel) {
+            index = firstChannel ? first : second;
+            channel = firstChannel ? std::move(firstChannel) : std::move(secondChannel);
+            return true;
+        }
+        break; // 两个候选都失效时退化为全量扫描
+    }
+    case LoadBalancePolicy::RoundRobin: {
+        const size_t start = nextSlot_.fetch_add(1, std::memory_order_relaxed);
+        for (size_t offset = 0; offset < slotCount; ++offset) {
+            const size_t candidate = (start + offset) % slotCount;
+            std::shared_ptr<BinaryRpcChannel> candidateChannel = healthy_channel(candidate);
+            if (candidateChannel) {
+                index = candidate;
+                channel = std::move(candidateChannel);
+                return true;
+            }
+        }
+        return false;
+    }
+    case LoadBalancePolicy::LeastOutstanding:
+        break;
+    }
+
+    // 最少挂起请求：从轮询游标开始扫描，挂起数相同的连接之间仍然轮转
+    const size_t start = nextSlot_.fetch_add(1, std::memory_order_relaxed);
+    size_t bestOutstanding = std::numeric_limits<size_t>::max();
+    for (size_t offset = 0; offset < slotCount; ++offset) {
+        const size_t candidate = (start + offset) % slotCount;
+        const size_t outstanding = slots_[candidate]->outstanding.load(std::memory_order_relaxed);
+        if (outstanding >= bestOutstanding) {
+            continue;
+        }
+        std::shared_ptr<BinaryRpcChannel> candidateChannel = healthy_channel(candidate);
+        if (candidateChannel) {
+            index = candidate;
+            channel = std::move(candidateChannel);
+            bestOutstanding = outstanding;
+        }
+    }
+    return channel != nullptr;
+}
+
+void BinaryRpcPooledChannel::schedule_reconnect(size_t index, const BinaryRpcChannel* failed) {
+    Slot& slot = *slots_[index];
+    double delaySeconds = 0.0;
+    {
+        std::lock_guard<std::mutex> lock(slot.mutex);
+        // 槽位已被替换、已在重连或正在析构时不再重复排队
+        if (slot.channel.get() != failed || slot.reconnecting) {
+            return;
+        }
+        slot.reconnecting = true;
+        delaySeconds = slot.backoffSeconds;
+        slot.backoffSeconds = std::min(slot.backoffSeconds * 2, options_.maxReconnectBackoffSeconds);
+    }
+
+    spdlog::info("BinaryRpcPooledChannel: Reconnecting to {}:{} in {}s",
+                 slot.endpoint.ip, slot.endpoint.port, delaySeconds);
+
+    std::shared_ptr<LifeState> state = lifeState_;
+    loopPool_->get_next_loop()->run_after(delaySeconds, [this, state, index]() {
+        std::lock_guard<std::mutex> lock(state->mutex);
+        if (state->closing) {
+            return;
+        }
+        this->reconnect(index);
+    });
+}
+
+void BinaryRpcPooledChannel::reconnect(size_t index) {
+    Slot& slot = *slots_[index];
+
+    std::shared_ptr<BinaryRpcChannel> fresh;
+    try {
+        // 非阻塞 connect：失败会在之后使新连接失效，届时挑选连接时再次触发（退避已翻倍的）重连
+        fresh = std::make_shared<BinaryRpcChannel>(loopPool_, slot.endpoint.ip, slot.endpoint.port);
+        fresh->set_default_timeout(options_.callTimeout);
+        if (!options_.compression.accepted.empty()) {
+            fresh->set_compression_options(options_.compression);
+        }
+    }
+    catch (const std::exception& e) {
+        spdlog::error("BinaryRpcPooledChannel: Failed to reconnect to {}:{}, error={}",
+                      slot.endpoint.ip, slot.endpoint.port, e.what());
+    }
+
+    std::shared_ptr<BinaryRpcChannel> stale;
+    const BinaryRpcChannel* current = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(slot.mutex);
+        slot.reconnecting = false;
+        if (fresh) {
+            stale = std::move(slot.channel);
+            slot.channel = std::move(fresh);
+        }
+        current = slot.channel.get();
+    }
+
+    release_on_own_loop(std::move(stale));
+
+    if (current == nullptr || current->is_closed()) {
+        schedule_reconnect(index, current);
+    }
+}
+
+} // namespace binary
+} // namespace rpc
+} // namespace tudou
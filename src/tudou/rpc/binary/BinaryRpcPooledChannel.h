@@ -0,0 +1,150 @@
+/**
+ * @file BinaryRpcPooledChannel.h
+ * @brief 多端点、多连接、带负载均衡与断线重连的二进制 RPC 客户端通道声明
+ * @author wenxingming
+ * @project: https://github.com/WenXingming/Tudou
+ */
+
+#pragma once
+
+#include "tudou/rpc/binary/BinaryRpcCompression.h"
+#include <google/protobuf/service.h>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace tudou {
+namespace rpc {
+namespace binary {
+
+class BinaryRpcChannel;
+class BinaryRpcClientLoopPool;
+
+struct BinaryRpcEndpoint {
+    std::string ip;
+    uint16_t port = 0;
+};
+
+/**
+ * @brief 连接选择策略
+ */
+enum class LoadBalancePolicy {
+    RoundRobin,         // 轮询
+    LeastOutstanding,   // 挂起请求最少的连接
+    PowerOfTwoChoices   // 随机取两条连接，选挂起请求较少者
+};
+
+struct BinaryRpcPooledChannelOptions {
+    size_t connectionsPerEndpoint = 4;                       // 每个端点保持的连接数 K
+    LoadBalancePolicy policy = LoadBalancePolicy::LeastOutstanding;
+    int maxRetries = 2;                                      // 连接失效时把未回包请求转移到其它连接的最多次数
+    double initialReconnectBackoffSeconds = 0.1;             // 首次重连等待时间
+    double maxReconnectBackoffSeconds = 10.0;                // 重连等待时间的上限，每次失败翻倍
+    std::chrono::milliseconds callTimeout{0};                // 每条连接上单次调用的默认时限，0 表示不限时；超时的调用不会重试
+    CompressionOptions compression;                          // 每条连接（含重连后）与服务端协商的载荷压缩配置，默认不压缩
+};
+
+/**
+ * @brief 连接池化的二进制 RPC 通道。
+ *        对每个端点保持 K 条挂在共享客户端 loop 池上的 BinaryRpcChannel，每次调用按策略挑选一条健康连接。
+ *        连接失效时按指数退避重连，已发出但未回包的请求转移到其它健康连接重发（至多 maxRetries 次），
+ *        因此被转移的请求在服务端可能执行不止一次，只应用于幂等方法。
+ *        调用方式与 BinaryRpcChannel 的事件驱动模式一致：协程内挂起协程，done 非空时异步回调，否则阻塞等待。
+ *        阻塞等待不能发生在 loop 池的线程中，否则 controller 被置为失败并抛出 std::logic_error。
+ */
+class BinaryRpcPooledChannel : public google::protobuf::RpcChannel {
+public:
+    BinaryRpcPooledChannel(std::shared_ptr<BinaryRpcClientLoopPool> loopPool,
+                           const std::vector<BinaryRpcEndpoint>& endpoints,
+                           const BinaryRpcPooledChannelOptions& options = BinaryRpcPooledChannelOptions());
+
+    /**
+     * @brief 析构函数，停止重连并关闭全部连接，仍挂起的请求以异常结束
+     */
+    ~BinaryRpcPooledChannel() override;
+
+    // 禁用拷贝构造和赋值
+    BinaryRpcPooledChannel(const BinaryRpcPooledChannel&) = delete;
+    BinaryRpcPooledChannel& operator=(const BinaryRpcPooledChannel&) = delete;
+
+    void CallMethod(const google::protobuf::MethodDescriptor* method,
+                    google::protobuf::RpcController* controller,
+                    const google::protobuf::Message* request,
+                    google::protobuf::Message* response,
+                    google::protobuf::Closure* done) override;
+
+    /**
+     * @brief 连接总数（端点数 × K）
+     */
+    size_t connection_count() const { return slots_.size(); }
+
+    /**
+     * @brief 当前未失效的连接数
+     */
+    size_t healthy_connection_count() const;
+
+private:
+    struct PooledCall;
+
+    // 单条连接槽位：连接失效后原地替换为重连得到的新 BinaryRpcChannel
+    struct Slot {
+        BinaryRpcEndpoint endpoint;
+        mutable std::mutex mutex;                   // 保护 channel、reconnecting、backoffSeconds
+        std::shared_ptr<BinaryRpcChannel> channel;
+        bool reconnecting = false;                  // 是否已排队重连任务
+        double backoffSeconds = 0.0;                // 下一次重连的等待时间
+        std::atomic<size_t> outstanding{0};         // 本连接上已发出未完成的请求数
+    };
+
+    // 定时重连任务持有的共享状态，析构后到期的任务据此放弃执行
+    struct LifeState {
+        std::mutex mutex;
+        bool closing = false;
+    };
+
+    /**
+     * @brief 按策略挑选一条健康连接，途经的失效连接顺带排队重连
+     */
+    bool pick_slot(size_t& index, std::shared_ptr<BinaryRpcChannel>& channel);
+
+    /**
+     * @brief 取槽位当前的连接，失效时返回 nullptr 并排队重连
+     */
+    std::shared_ptr<BinaryRpcChannel> healthy_channel(size_t index);
+
+    void start_call(const std::shared_ptr<PooledCall>& call);
+
+    void on_call_complete(const std::shared_ptr<PooledCall>& call,
+                          size_t index,
+                          BinaryRpcChannel* channel,
+                          std::exception_ptr error);
+
+    /**
+     * @brief 按调用方的等待方式完成一次调用：唤醒协程、执行 done 或兑现 promise
+     */
+    static void finish_call(const std::shared_ptr<PooledCall>& call, std::exception_ptr error);
+
+    /**
+     * @brief 为失效连接排队一次退避重连；同一失效连接只排队一次
+     */
+    void schedule_reconnect(size_t index, const BinaryRpcChannel* failed);
+
+    void reconnect(size_t index);
+
+private:
+    std::shared_ptr<BinaryRpcClientLoopPool> loopPool_;
+    BinaryRpcPooledChannelOptions options_;
+    std::vector<std::unique_ptr<Slot>> slots_;
+    std::atomic<size_t> nextSlot_{0};               // 轮询游标
+    std::shared_ptr<LifeState> lifeState_;
+};
+
+} // namespace binary
+} // namespace rpc
+} // namespace tudou
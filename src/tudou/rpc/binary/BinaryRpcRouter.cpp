@@ -6,15 +6,84 @@
  */
 
 #include "BinaryRpcRouter.h"
+#include "binary_rpc.pb.h"
 #include <spdlog/spdlog.h>
+#include <atomic>
 #include <stdexcept>
 #include <memory>
+#include <limits>
+#include <vector>
+#include <google/protobuf/arena.h>
 
 namespace tudou {
 namespace rpc {
 namespace binary {
 
-// 自定义包装的 Closure 闭包，用于管理异步回调 and response 的生命周期自动回收
+namespace {
+
+constexpr size_t kArenaInitialBlockSize = 4096; // 每个池化 Arena 自带的首块内存，Reset 后保留，覆盖绝大多数请求/响应
+constexpr size_t kMaxPooledArenas = 256;        // 每个线程最多缓存的空闲 Arena 数量
+
+// 自带首块内存的 Arena。Reset() 只释放后续追加的块，首块保留下来供下次调用复用
+struct PooledArena {
+    PooledArena()
+        : block(new char[kArenaInitialBlockSize])
+        , arena(block.get(), kArenaInitialBlockSize) {
+    }
+
+    std::unique_ptr<char[]> block;
+    google::protobuf::Arena arena; // 必须在 block 之后声明，保证先于 block 析构
+};
+
+// 线程退出时空闲列表先行析构，之后归还的 Arena 直接销毁
+thread_local bool t_arenaFreeListDestroyed = false;
+
+struct ArenaFreeList {
+    std::vector<std::unique_ptr<PooledArena>> arenas;
+
+    ~ArenaFreeList() {
+        t_arenaFreeListDestroyed = true;
+    }
+};
+
+ArenaFreeList& current_thread_arena_free_list() {
+    thread_local ArenaFreeList freeList;
+    return freeList;
+}
+
+// 归还 Arena：先 Reset 回收本次调用在其上构造的全部对象，再放回当前线程的空闲列表
+struct ArenaRecycler {
+    void operator()(PooledArena* pooled) const noexcept {
+        pooled->arena.Reset();
+        if (!t_arenaFreeListDestroyed) {
+            ArenaFreeList& freeList = current_thread_arena_free_list();
+            if (freeList.arenas.size() < kMaxPooledArenas) {
+                freeList.arenas.emplace_back(pooled);
+                return;
+            }
+        }
+        delete pooled;
+    }
+};
+
+using PooledArenaPtr = std::unique_ptr<PooledArena, ArenaRecycler>;
+
+PooledArenaPtr acquire_arena() {
+    if (!t_arenaFreeListDestroyed) {
+        ArenaFreeList& freeList = current_thread_arena_free_list();
+        if (!freeList.arenas.empty()) {
+            PooledArenaPtr pooled(freeList.arenas.back().release());
+            freeList.arenas.pop_back();
+            return pooled;
+        }
+    }
+    return PooledArenaPtr(new PooledArena());
+}
+
+} // namespace
+
+// 自定义包装的 Closure 闭包。请求、响应与闭包自身都构造在同一个 Arena 上，
+// Run() 时归还 Arena，一次 Reset 即回收本次调用的全部对象（含嵌套字段），无需逐个 delete
 class BinaryRpcClosure : public google::protobuf::Closure {
 public:
     BinaryRpcClosure(google::protobuf::Message* response,
@@ -26,12 +95,16 @@ public:
     ~BinaryRpcClosure() override = default;
 
     void Run() override {
-        // 使用 RAII 智能指针接管，确保退出函数作用域时自动执行销毁，防止内存泄漏
-        std::unique_ptr<google::protobuf::Closure> selfGuard(this);
-        std::unique_ptr<google::protobuf::Message> responseGuard(response_);
+        // 与 invoke() 的异常路径争抢 Arena 所有权：对方已先取回时闭包即将随 Arena 销毁，不再回包
+        if (runFlag_ && runFlag_->exchange(true)) {
+            return;
+        }
+        // 闭包自身位于 Arena 中：先取出所有权，离开作用域（含回调抛出异常）时即 Reset，this 随之析构。
+        // arenaGuard 先于 responseRaw 声明，保证回调使用的局部对象先析构
+        PooledArenaPtr arenaGuard = std::move(arena_);
 
         std::string responseRaw;
-        if (responseGuard && responseGuard->SerializeToString(&responseRaw)) {
+        if (response_ && response_->SerializeToString(&responseRaw)) {
             callback_(responseRaw);
         }
         else {
@@ -40,9 +113,24 @@ public:
         }
     }
 
+    void adopt_arena(PooledArenaPtr arena) {
+        arena_ = std::move(arena);
+    }
+
+    // 与 invoke() 共享的所有权标志，先把它置为 true 的一方负责归还 Arena
+    void set_run_flag(std::shared_ptr<std::atomic<bool>> flag) {
+        runFlag_ = std::move(flag);
+    }
+
+    PooledArenaPtr release_arena() {
+        return std::move(arena_);
+    }
+
 private:
     google::protobuf::Message* response_;
     std::function<void(const std::string&)> callback_;
+    PooledArenaPtr arena_;   // 承载本次调用全部对象的 Arena
+    std::shared_ptr<std::atomic<bool>> runFlag_; // 独立于 Arena 分配，闭包销毁后 invoke() 仍可读写
 };
 
 BinaryRpcRouter::BinaryRpcRouter() = default;
@@ -66,7 +154,8 @@ void BinaryRpcRouter::register_service(std::shared_ptr<google::protobuf::Service
     for (int index = 0; index < methodCount; ++index) {
         const google::protobuf::MethodDescriptor* method = descriptor->method(index);
         serviceInfo.methods[method->name()] = method;
-        spdlog::info("BinaryRpcRouter: Method registered, method={}.{}", serviceName, method->name());
+        methodsById_.push_back(MethodEntry{service, method});
+        spdlog::info("BinaryRpcRouter: Method registered, method={}.{}, id={}", serviceName, method->name(), methodsById_.size());
     }
 
     services_[serviceName] = std::move(serviceInfo);
@@ -77,6 +166,14 @@ void BinaryRpcRouter::dispatch(const std::string& serviceName,
                                const std::string& methodName,
                                const std::string& requestRaw,
                                std::function<void(const std::string& responseRaw)> doneCallback) {
+    dispatch(serviceName, methodName, requestRaw.data(), requestRaw.size(), std::move(doneCallback));
+}
+
+void BinaryRpcRouter::dispatch(const std::string& serviceName,
+                               const std::string& methodName,
+                               const char* requestData,
+                               size_t requestLen,
+                               std::function<void(const std::string& responseRaw)> doneCallback) {
     // 1. 查找服务对象
     auto serviceIt = services_.find(serviceName);
     if (serviceIt == services_.end()) {
@@ -93,30 +190,86 @@ void BinaryRpcRouter::dispatch(const std::string& serviceName,
         throw std::invalid_argument("Method not found: " + serviceName + "." + methodName);
     }
 
-    const google::protobuf::MethodDescriptor* method = methodIt->second;
+    invoke(serviceInfo.service.get(), methodIt->second, requestData, requestLen, std::move(doneCallback));
+}
 
-    // 3. 动态构建请求消息实例
-    std::unique_ptr<google::protobuf::Message> request(serviceInfo.service->GetRequestPrototype(method).New());
-    if (!request->ParseFromString(requestRaw)) {
-        spdlog::error("BinaryRpcRouter: Failed to parse request payload for method={}.{}", serviceName, methodName);
-        throw std::invalid_argument("Invalid request payload for method: " + serviceName + "." + methodName);
+void BinaryRpcRouter::dispatch(uint32_t methodId,
+                               const char* requestData,
+                               size_t requestLen,
+                               std::function<void(const std::string& responseRaw)> doneCallback) {
+    if (methodId == 0 || methodId > methodsById_.size()) {
+        spdlog::warn("BinaryRpcRouter: Method id not found, id={}", methodId);
+        throw std::invalid_argument("Method id not found: " + std::to_string(methodId));
+    }
+
+    const MethodEntry& entry = methodsById_[methodId - 1];
+    invoke(entry.service.get(), entry.method, requestData, requestLen, std::move(doneCallback));
+}
+
+void BinaryRpcRouter::register_stream_handler(const google::protobuf::MethodDescriptor* method, StreamHandler handler) {
+    if (method == nullptr || !handler) {
+        throw std::invalid_argument("BinaryRpcRouter: Stream method and handler must not be null");
+    }
+    streamHandlers_[method->full_name()] = std::move(handler);
+    spdlog::info("BinaryRpcRouter: Stream handler registered, method={}", method->full_name());
+}
+
+BinaryRpcRouter::StreamHandler BinaryRpcRouter::find_stream_handler(const std::string& serviceName,
+                                                                    const std::string& methodName) const {
+    auto it = streamHandlers_.find(serviceName + "." + methodName);
+    if (it == streamHandlers_.end()) {
+        return StreamHandler();
+    }
+    return it->second;
+}
+
+void BinaryRpcRouter::export_method_table(RpcMethodTable* table) const {
+    table->clear_methods();
+    for (size_t index = 0; index < methodsById_.size(); ++index) {
+        const MethodEntry& entry = methodsById_[index];
+        RpcMethodEntry* out = table->add_methods();
+        out->set_method_id(static_cast<uint32_t>(index + 1));
+        out->set_service_name(entry.method->service()->full_name());
+        out->set_method_name(entry.method->name());
+    }
+}
+
+void BinaryRpcRouter::invoke(google::protobuf::Service* service,
+                             const google::protobuf::MethodDescriptor* method,
+                             const char* requestData,
+                             size_t requestLen,
+                             std::function<void(const std::string& responseRaw)> doneCallback) {
+    // 3. 从当前线程的池中取出 Arena，动态构建请求消息实例
+    // 请求需存活到 done 被调用（异步业务可能稍后才回包），因此与响应一样交由 Arena 统一管理
+    PooledArenaPtr arena = acquire_arena();
+    google::protobuf::Message* request = service->GetRequestPrototype(method).New(&arena->arena);
+    if (requestLen > static_cast<size_t>(std::numeric_limits<int>::max())
+        || !request->ParseFromArray(requestData, static_cast<int>(requestLen))) {
+        spdlog::error("BinaryRpcRouter: Failed to parse request payload for method={}", method->full_name());
+        throw std::invalid_argument("Invalid request payload for method: " + method->full_name());
     }
 
     // 4. 动态构建响应消息实例
-    // 生命周期移交给 done 闭包持有，由 BinaryRpcClosure::Run() 析构时自动回收
-    auto* response = serviceInfo.service->GetResponsePrototype(method).New();
+    auto* response = service->GetResponsePrototype(method).New(&arena->arena);
 
-    // 5. 实例化 Closure 闭包
-    auto* done = new BinaryRpcClosure(response, std::move(doneCallback));
+    // 5. 在同一 Arena 上实例化 Closure 闭包，并把 Arena 所有权移交给它，由 BinaryRpcClosure::Run() 归还
+    google::protobuf::Arena* rawArena = &arena->arena;
+    auto* done = google::protobuf::Arena::Create<BinaryRpcClosure>(rawArena, response, std::move(doneCallback));
+    done->adopt_arena(std::move(arena));
+    auto doneRan = std::make_shared<std::atomic<bool>>(false);
+    done->set_run_flag(doneRan);
 
-    // 6. 执行具体的 RPC 业务分发
+    // 6. 执行具体的 RPC 业务分发。业务可能在其它线程上执行 done，Run() 随即归还 Arena，
+    // 因此 CallMethod 正常返回后不再访问 done
     try {
-        serviceInfo.service->CallMethod(method, nullptr, request.get(), response, done);
+        service->CallMethod(method, nullptr, request, response, done);
     }
     catch (const std::exception& e) {
         spdlog::error("BinaryRpcRouter: Exception caught during CallMethod, error={}", e.what());
-        // 异常分支下，由于 Run() 无法被执行，需在此处手动销毁 done，防范内存泄漏
-        delete done;
+        // 抢在 Run() 之前取得所有权时由此处归还 Arena，连带销毁 done、请求与响应；否则 Arena 由 Run() 归还
+        if (!doneRan->exchange(true)) {
+            PooledArenaPtr arenaGuard = done->release_arena();
+        }
         throw;
     }
 }
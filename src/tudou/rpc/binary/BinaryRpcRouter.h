@@ -10,17 +10,27 @@
 #include <google/protobuf/service.h>
 #include <google/protobuf/descriptor.h>
 #include <google/protobuf/message.h>
+#include <cstddef>
 #include <unordered_map>
 #include <string>
 #include <memory>
 #include <functional>
+#include <vector>
 
 namespace tudou {
 namespace rpc {
+
+class RpcMethodTable;
+
 namespace binary {
 
+class BinaryRpcStream;
+
 class BinaryRpcRouter {
 public:
+    // 流式方法处理函数：在协程中运行，通过 stream 收发消息，返回即结束流；抛出异常时以异常信息作为流的错误结束
+    using StreamHandler = std::function<void(BinaryRpcStream& stream)>;
+
     BinaryRpcRouter();
     ~BinaryRpcRouter();
 
@@ -30,11 +40,22 @@ public:
 
     /**
      * @brief 注册一个具体的 Protobuf RPC 业务服务对象。
-     *        内部会自动反射提取该服务声明的全部远程调用方法。
+     *        内部会自动反射提取该服务声明的全部远程调用方法，并按注册顺序为每个方法分配从 1 开始的紧凑方法 ID。
      * @param service 继承自 google::protobuf::Service 的具体服务实例指针。
      */
     void register_service(std::shared_ptr<google::protobuf::Service> service);
 
+    /**
+     * @brief 为 proto 中声明为 stream 的方法注册流处理函数。protoc 生成的一元桩代码无法承载流式语义，
+     *        流式方法只能经此注册；同一方法重复注册时后者覆盖前者。
+     */
+    void register_stream_handler(const google::protobuf::MethodDescriptor* method, StreamHandler handler);
+
+    /**
+     * @brief 按服务名与方法名查找流处理函数，未注册时返回空函数
+     */
+    StreamHandler find_stream_handler(const std::string& serviceName, const std::string& methodName) const;
+
     /**
      * @brief 解析二进制载荷，并动态反射调度具体的业务方法。
      * @param serviceName 服务名称，如 "tudou.rpc.UserService"
@@ -47,7 +68,43 @@ public:
                   const std::string& requestRaw,
                   std::function<void(const std::string& responseRaw)> doneCallback);
 
+    /**
+     * @brief 同上，但请求载荷以 [requestData, requestData + requestLen) 区间给出，直接 ParseFromArray 反序列化，
+     *        可指向连接读缓冲内部而无需先拷贝成 std::string。区间只需在本函数内有效。
+     */
+    void dispatch(const std::string& serviceName,
+                  const std::string& methodName,
+                  const char* requestData,
+                  size_t requestLen,
+                  std::function<void(const std::string& responseRaw)> doneCallback);
+
+    /**
+     * @brief 按协商得到的方法 ID 调度，直接以数组下标定位方法，省去两次字符串哈希查找。
+     *        ID 未注册时抛出 std::invalid_argument。
+     */
+    void dispatch(uint32_t methodId,
+                  const char* requestData,
+                  size_t requestLen,
+                  std::function<void(const std::string& responseRaw)> doneCallback);
+
+    /**
+     * @brief 导出当前全部方法及其 ID，供服务端回应客户端的方法表协商
+     */
+    void export_method_table(RpcMethodTable* table) const;
+
 private:
+    void invoke(google::protobuf::Service* service,
+                const google::protobuf::MethodDescriptor* method,
+                const char* requestData,
+                size_t requestLen,
+                std::function<void(const std::string& responseRaw)> doneCallback);
+
+private:
+    struct MethodEntry {
+        std::shared_ptr<google::protobuf::Service> service;
+        const google::protobuf::MethodDescriptor* method;
+    };
+
     struct ServiceInfo {
         std::shared_ptr<google::protobuf::Service> service;
         std::unordered_map<std::string, const google::protobuf::MethodDescriptor*> methods;
@@ -55,6 +112,12 @@ private:
 
     // 映射: ServiceName -> ServiceInfo
     std::unordered_map<std::string, ServiceInfo> services_;
+
+    // 方法 ID 表: methodsById_[methodId - 1]，只增不减，重复注册同名服务时旧 ID 仍指向旧实例
+    std::vector<MethodEntry> methodsById_;
+
+    // 流式方法: "ServiceName.MethodName" -> StreamHandler
+    std::unordered_map<std::string, StreamHandler> streamHandlers_;
 };
 
 } // namespace binary
@@ -7,6 +7,9 @@
 
 #include "BinaryRpcServer.h"
 #include "tudou/rpc/binary/BinaryRpcCodec.h"
+#include "tudou/rpc/binary/BinaryRpcShmServer.h"
+#include "tudou/rpc/Coroutine.h"
+#include "tudou/reactor/EventLoop.h"
 #include "binary_rpc.pb.h"
 #include <spdlog/spdlog.h>
 
@@ -16,7 +19,15 @@ namespace binary {
 
 BinaryRpcServer::BinaryRpcServer(const std::string& ip, uint16_t port, int numThreads)
     : tcpServer_(std::make_unique<TcpServer>(ip, port, numThreads > 0 ? numThreads - 1 : 0)) {
-    
+    init_callbacks();
+}
+
+BinaryRpcServer::BinaryRpcServer(const InetAddress& listenAddr, int numThreads)
+    : tcpServer_(std::make_unique<TcpServer>(listenAddr, numThreads > 0 ? numThreads - 1 : 0)) {
+    init_callbacks();
+}
+
+void BinaryRpcServer::init_callbacks() {
     tcpServer_->set_connection_callback([this](const TcpConnectionPtr& conn) {
         on_connection(conn);
     });
@@ -33,8 +44,14 @@ BinaryRpcServer::BinaryRpcServer(const std::string& ip, uint16_t port, int numTh
 BinaryRpcServer::~BinaryRpcServer() = default;
 
 void BinaryRpcServer::start() {
+    if (shmServer_) {
+        shmServer_->start();
+    }
     tcpServer_->start();
     spdlog::info("BinaryRpcServer: Started listening on {}:{}", tcpServer_->get_ip(), tcpServer_->get_port());
+    if (shmServer_) {
+        shmServer_->stop();
+    }
 }
 
 void BinaryRpcServer::stop() {
@@ -49,58 +66,162 @@ void BinaryRpcServer::register_service(std::shared_ptr<google::protobuf::Service
     router_.register_service(std::move(service));
 }
 
+void BinaryRpcServer::register_stream_handler(const google::protobuf::MethodDescriptor* method,
+                                              BinaryRpcRouter::StreamHandler handler) {
+    router_.register_stream_handler(method, std::move(handler));
+}
+
+void BinaryRpcServer::set_max_in_flight_per_connection(size_t limit) {
+    maxInFlightPerConnection_ = limit;
+}
+
+void BinaryRpcServer::set_admission_options(const AdmissionOptions& options) {
+    admission_.configure(options);
+}
+
+void BinaryRpcServer::set_compression_options(const CompressionOptions& options) {
+    compressionOptions_ = options;
+}
+
+void BinaryRpcServer::listen_shared_memory(const std::string& path, size_t ringCapacity) {
+    shmServer_ = std::make_unique<BinaryRpcShmServer>(router_, InetAddress::from_unix_path(path), ringCapacity);
+}
+
 void BinaryRpcServer::on_connection(const TcpConnectionPtr& conn) {
     spdlog::info("BinaryRpcServer: Client connected, fd={}, peer={}", 
                  conn->get_fd(), conn->get_peer_addr().get_ip_port());
 }
 
 void BinaryRpcServer::on_message(const TcpConnectionPtr& conn) {
-    std::string data = conn->receive();
-    if (data.empty()) {
-        return;
+    // 半包直接留在连接读缓冲中，下次可读事件追加后继续从头部窥探，无需另存一份缓存
+    std::shared_ptr<ConnectionState> state = find_connection_state(conn);
+    state->lastReadTime = conn->get_loop()->get_poll_return_time();
+    process_frames(conn, state);
+}
+
+void BinaryRpcServer::on_close(const TcpConnectionPtr& conn) {
+    spdlog::info("BinaryRpcServer: Client disconnected, fd={}", conn->get_fd());
+
+    std::lock_guard<std::mutex> lock(statesMutex_);
+    auto it = connectionStates_.find(conn.get());
+    if (it != connectionStates_.end()) {
+        // 仍在挂起的协程持有 state，标记关闭后它们回包时不再恢复读取
+        it->second->closed = true;
+        // 挂起在流读写上的处理函数随之返回，由其协程负责把流从表中移除
+        for (auto& entry : it->second->streams) {
+            entry.second->on_remote_cancel("BinaryRpcServer: Connection closed");
+        }
+        connectionStates_.erase(it);
     }
+}
 
-    // 获取并追加新数据入连接关联缓存
-    std::string& cache = connectionBuffers_[conn.get()];
-    cache.append(data);
+std::shared_ptr<BinaryRpcServer::ConnectionState> BinaryRpcServer::find_connection_state(const TcpConnectionPtr& conn) {
+    std::lock_guard<std::mutex> lock(statesMutex_);
+    std::shared_ptr<ConnectionState>& state = connectionStates_[conn.get()];
+    if (!state) {
+        state = std::make_shared<ConnectionState>();
+    }
+    return state;
+}
 
-    // 载入临时解包 Buffer
-    Buffer buf;
-    buf.write_to_buffer(cache.data(), cache.size());
+void BinaryRpcServer::process_frames(const TcpConnectionPtr& conn, const std::shared_ptr<ConnectionState>& state) {
+    // 直接在连接读缓冲上原地拆包：帧未收全时不做任何拷贝，收全后 Meta 与 Body 都从缓冲区内的区间反序列化
+    Buffer* buf = conn->get_read_buffer();
 
     RpcHeader header;
-    std::string metaRaw;
-    std::string bodyRaw;
+    const char* metaData = nullptr;
+    const char* bodyData = nullptr;
     bool hasCorruptFrame = false;
+    bool blockedByLimit = false;
 
+    state->processing = true;
     while (true) {
-        BinaryRpcCodec::DecodeResult result = BinaryRpcCodec::decode(&buf, header, metaRaw, bodyRaw);
-        
-        if (result == BinaryRpcCodec::DecodeResult::Success) {
+        BinaryRpcCodec::DecodeResult result = BinaryRpcCodec::peek(buf, header, metaData, bodyData);
+
+        if (result == BinaryRpcCodec::DecodeResult::Success
+            && reached_in_flight_limit(*state)
+            && (frame_type(header) == RpcMessageType::Request || frame_type(header) == RpcMessageType::StreamOpen)) {
+            // 在途上限只约束新请求与新流：该帧留在缓冲中等待名额，其后的帧随之排队。
+            // 已打开流上的数据、窗口更新与取消、方法表等帧照常处理，避免在途请求等待流推进时互相卡死
+            blockedByLimit = true;
+            break;
+        }
+
+        if (result == BinaryRpcCodec::DecodeResult::Success
+            && frame_type(header) == RpcMessageType::MethodTable) {
+            // 方法表协商帧：直接回传方法 ID 表并选定压缩算法，不占用在途配额
+            reply_method_table(conn, state, header, bodyData);
+            buf->advance_read_index(BinaryRpcCodec::frame_size(header));
+        }
+        else if (result == BinaryRpcCodec::DecodeResult::Success
+                 && frame_type(header) == RpcMessageType::Cancel) {
+            // 取消帧：标记对应在途请求，其回包将被丢弃
+            cancel_request(state, header.sequenceId);
+            buf->advance_read_index(BinaryRpcCodec::frame_size(header));
+        }
+        else if (result == BinaryRpcCodec::DecodeResult::Success) {
             // 反序列化 RPC 元信息
             RpcMeta meta;
-            if (!meta.ParseFromString(metaRaw)) {
+            if (!meta.ParseFromArray(metaData, static_cast<int>(header.metaLen))) {
                 spdlog::error("BinaryRpcServer: Failed to parse RpcMeta on fd {}. Closing connection...", conn->get_fd());
                 hasCorruptFrame = true;
                 break;
             }
 
-            uint64_t sequenceId = header.sequenceId;
+            // 压缩的 Body 解压到线程复用的缓冲：请求在协程首个挂起点前、流消息在投递时即完成拷贝，下一帧可安全覆盖
+            const char* body = bodyData;
+            size_t bodyLen = header.bodyLen;
+            if (is_body_compressed(header)) {
+                const std::string* raw = BinaryRpcCompression::decompress(bodyData, header.bodyLen);
+                if (raw == nullptr) {
+                    spdlog::error("BinaryRpcServer: Failed to decompress frame body on fd {}. Closing connection...", conn->get_fd());
+                    hasCorruptFrame = true;
+                    break;
+                }
+                body = raw->data();
+                bodyLen = raw->size();
+            }
 
-            // 派发至反射路由器执行具体业务
-            try {
-                router_.dispatch(meta.service_name(), meta.method_name(), bodyRaw,
-                    [this, conn, sequenceId](const std::string& responseRaw) {
-                        Buffer responseBuf;
-                        BinaryRpcCodec::encode(&responseBuf, RpcMessageType::Response, sequenceId, "", responseRaw);
-                        conn->send(responseBuf.read_from_buffer());
-                    }
-                );
+            // 流式帧：打开新流或投递给已打开的流，均不占用在途配额
+            const RpcMessageType type = frame_type(header);
+            if (type == RpcMessageType::StreamOpen) {
+                open_stream(conn, state, header, meta);
+                buf->advance_read_index(BinaryRpcCodec::frame_size(header));
+                continue;
             }
-            catch (const std::exception& e) {
-                spdlog::error("BinaryRpcServer: Dispatch exception for {}.{}, error={}", 
-                              meta.service_name(), meta.method_name(), e.what());
+            if (is_stream_frame(type)) {
+                handle_stream_frame(state, header, meta, body, bodyLen);
+                buf->advance_read_index(BinaryRpcCodec::frame_size(header));
+                continue;
+            }
+
+            // 在途背压或积压期间已超过客户端时限的请求，客户端早已放弃等待，直接跳过不再执行
+            if (is_expired(*state, meta)) {
+                expiredRequests_.fetch_add(1, std::memory_order_relaxed);
+                buf->advance_read_index(BinaryRpcCodec::frame_size(header));
+                continue;
+            }
+
+            // 复用仍在途的序列号属于协议错误：覆盖原记录会让其准入名额永不归还、在途计数失准，直接关闭连接
+            if (state->inFlightRequests.count(header.sequenceId) != 0) {
+                spdlog::error("BinaryRpcServer: Duplicate in-flight sequenceId {} on fd {}. Closing connection...",
+                              header.sequenceId, conn->get_fd());
+                hasCorruptFrame = true;
+                break;
             }
+
+            // 过载时立即拒绝，不让请求继续在本连接缓冲或 loop 任务队列里排队；实际占用的名额在 finish_request 中归还
+            bool admitted = false;
+            if (admission_.is_enabled()
+                && !admission_.try_acquire(std::chrono::steady_clock::now() - state->lastReadTime, &admitted)) {
+                reply_overloaded(conn, header);
+                buf->advance_read_index(BinaryRpcCodec::frame_size(header));
+                continue;
+            }
+
+            // 派发至协程中执行具体业务。请求体在协程首个挂起点之前即完成反序列化，之后才消费整帧
+            dispatch_in_coroutine(conn, state, header, std::move(meta), body, bodyLen, admitted);
+            buf->advance_read_index(BinaryRpcCodec::frame_size(header));
         }
         else if (result == BinaryRpcCodec::DecodeResult::HalfPack || result == BinaryRpcCodec::DecodeResult::Empty) {
             break;
@@ -111,19 +232,325 @@ void BinaryRpcServer::on_message(const TcpConnectionPtr& conn) {
             break;
         }
     }
+    state->processing = false;
 
     if (hasCorruptFrame) {
+        buf->advance_read_index(buf->readable_bytes());
         conn->force_close();
-        connectionBuffers_.erase(conn.get());
-    } else {
-        // 保存未消费的半包流数据
-        cache = buf.read_from_buffer();
+        return;
+    }
+
+    // 新请求因在途上限被挡在缓冲头部：暂停读取，等某个请求回包后再恢复并继续派发积压的帧。
+    // 仅达到上限而缓冲中没有被挡住的帧时保持读取，已打开流上的后续帧仍能送达
+    if (blockedByLimit && !state->readingPaused) {
+        state->readingPaused = true;
+        conn->stop_reading();
     }
 }
 
-void BinaryRpcServer::on_close(const TcpConnectionPtr& conn) {
-    spdlog::info("BinaryRpcServer: Client disconnected, fd={}", conn->get_fd());
-    connectionBuffers_.erase(conn.get());
+void BinaryRpcServer::dispatch_in_coroutine(const TcpConnectionPtr& conn,
+                                            const std::shared_ptr<ConnectionState>& state,
+                                            const RpcHeader& header,
+                                            RpcMeta meta,
+                                            const char* body,
+                                            size_t bodyLen,
+                                            bool admitted) {
+    ++state->inFlight;
+
+    const uint64_t sequenceId = header.sequenceId;
+    const uint8_t version = header.version; // 按请求的协议版本回包，兼容 version 1 客户端
+    InFlightRequest& record = state->inFlightRequests[sequenceId];
+    record.cancelled = false;
+    record.admitted = admitted;
+    record.responded = false;
+
+    auto coro = Coroutine::create(conn->get_loop(),
+        [this, conn, state, sequenceId, version, meta = std::move(meta), body, bodyLen]() {
+            auto onDone = [this, conn, state, sequenceId, version](const std::string& responseRaw) {
+                // 业务可能在其它线程调用 done：取消标记只在连接所属线程读写，此时连同回包一起投递回去
+                EventLoop* loop = conn->get_loop();
+                if (loop->is_in_loop_thread()) {
+                    send_response(conn, state, sequenceId, version, responseRaw);
+                }
+                else {
+                    loop->queue_in_loop([this, conn, state, sequenceId, version, responseRaw]() {
+                        send_response(conn, state, sequenceId, version, responseRaw);
+                    });
+                }
+
+                // 业务也可能在协程内部调用 done，在途计数统一投递回连接所属线程的顶层维护
+                loop->queue_in_loop([this, conn, state, sequenceId]() {
+                    finish_request(conn, state, sequenceId);
+                });
+            };
+
+            try {
+                // body 指向连接读缓冲，router 在调用业务方法（可能挂起）之前就完成反序列化，此时区间仍然有效
+                if (meta.method_id() != 0) {
+                    router_.dispatch(meta.method_id(), body, bodyLen, std::move(onDone));
+                }
+                else {
+                    router_.dispatch(meta.service_name(), meta.method_name(), body, bodyLen, std::move(onDone));
+                }
+            }
+            catch (const std::exception& e) {
+                spdlog::error("BinaryRpcServer: Dispatch exception for {}.{} (id={}), error={}", 
+                              meta.service_name(), meta.method_name(), meta.method_id(), e.what());
+                // 方法未找到、请求体无法解析或业务抛出异常：协程运行在连接所属线程上，直接以错误回包告知客户端，
+                // 避免其一直等到超时；在途计数仍投递回顶层维护
+                send_error_response(conn, state, sequenceId, version, std::string("BinaryRpcServer: ") + e.what());
+                conn->get_loop()->queue_in_loop([this, conn, state, sequenceId]() {
+                    finish_request(conn, state, sequenceId);
+                });
+            }
+        }
+    );
+
+    // 运行到业务完成或首个挂起点（如嵌套 RPC 等待回包）即返回，挂起的协程由等待方持有并负责唤醒
+    coro->resume();
+}
+
+void BinaryRpcServer::open_stream(const TcpConnectionPtr& conn,
+                                  const std::shared_ptr<ConnectionState>& state,
+                                  const RpcHeader& header,
+                                  const RpcMeta& meta) {
+    const uint64_t streamId = header.sequenceId;
+    BinaryRpcRouter::StreamHandler handler = router_.find_stream_handler(meta.service_name(), meta.method_name());
+    if (!handler) {
+        spdlog::error("BinaryRpcServer: Stream method not found, method={}.{}", meta.service_name(), meta.method_name());
+        reply_stream_error(conn, header, "BinaryRpcServer: Stream method not found: " + meta.service_name() + "." + meta.method_name());
+        return;
+    }
+    if (state->streams.count(streamId) != 0) {
+        reply_stream_error(conn, header, "BinaryRpcServer: Duplicate stream id");
+        return;
+    }
+    bool admitted = false;
+    if (admission_.is_enabled()
+        && !admission_.try_acquire(std::chrono::steady_clock::now() - state->lastReadTime, &admitted)) {
+        reply_stream_error(conn, header, "BinaryRpcServer: Server overloaded");
+        return;
+    }
+
+    const uint8_t version = header.version;
+    const CompressionType compression = state->compression;
+    const size_t minBytes = compressionOptions_.minBytes;
+    std::weak_ptr<TcpConnection> weakConn = conn;
+    auto stream = std::make_shared<BinaryRpcStream>(streamId, meta.stream_window(), conn->get_loop(),
+        [weakConn, streamId, version, compression, minBytes](RpcMessageType type, const std::string& metaRaw, const std::string& body) {
+            TcpConnectionPtr target = weakConn.lock();
+            if (!target) {
+                return;
+            }
+            Buffer frameBuf;
+            std::string compressed;
+            if (BinaryRpcCompression::maybe_compress(compression, minBytes, body, &compressed)) {
+                BinaryRpcCodec::encode(&frameBuf, type, streamId, metaRaw, compressed, version, kRpcFlagCompressed);
+            }
+            else {
+                BinaryRpcCodec::encode(&frameBuf, type, streamId, metaRaw, body, version);
+            }
+            target->send(frameBuf.read_from_buffer());
+        });
+    state->streams[streamId] = stream;
+
+    auto coro = Coroutine::create(conn->get_loop(),
+        [this, conn, state, stream, streamId, admitted, handler = std::move(handler)]() {
+            std::string error;
+            try {
+                handler(*stream);
+            }
+            catch (const std::exception& e) {
+                spdlog::error("BinaryRpcServer: Stream handler exception, stream={}, error={}", streamId, e.what());
+                error = e.what();
+            }
+            stream->finish(error);
+
+            // 与一元请求一致，名额与流表项统一回到连接所属线程的顶层维护
+            conn->get_loop()->queue_in_loop([this, state, streamId, admitted]() {
+                state->streams.erase(streamId);
+                if (admitted) {
+                    admission_.release();
+                }
+            });
+        }
+    );
+    coro->resume();
+}
+
+void BinaryRpcServer::handle_stream_frame(const std::shared_ptr<ConnectionState>& state,
+                                          const RpcHeader& header,
+                                          const RpcMeta& meta,
+                                          const char* body,
+                                          size_t bodyLen) {
+    // 已结束的流上迟到的帧直接丢弃
+    auto it = state->streams.find(header.sequenceId);
+    if (it == state->streams.end()) {
+        return;
+    }
+    const std::shared_ptr<BinaryRpcStream>& stream = it->second;
+
+    switch (frame_type(header)) {
+    case RpcMessageType::StreamData:
+        if (!stream->on_data(std::string(body, bodyLen))) {
+            spdlog::warn("BinaryRpcServer: Stream {} exceeded its receive window, cancelling", header.sequenceId);
+            stream->cancel("BinaryRpcServer: Stream window exceeded");
+        }
+        break;
+    case RpcMessageType::StreamHalfClose:
+        stream->on_remote_half_close();
+        break;
+    case RpcMessageType::StreamCancel:
+        stream->on_remote_cancel(meta.error_text().empty() ? "BinaryRpcServer: Stream cancelled by client" : meta.error_text());
+        break;
+    case RpcMessageType::StreamWindowUpdate:
+        stream->on_window_update(meta.window_increment());
+        break;
+    default:
+        break;
+    }
+}
+
+void BinaryRpcServer::reply_stream_error(const TcpConnectionPtr& conn, const RpcHeader& header, const std::string& error) {
+    RpcMeta meta;
+    meta.set_error_text(error);
+    std::string metaRaw;
+    meta.SerializeToString(&metaRaw);
+
+    Buffer responseBuf;
+    BinaryRpcCodec::encode(&responseBuf, RpcMessageType::StreamHalfClose, header.sequenceId, metaRaw, "", header.version);
+    conn->send(responseBuf.read_from_buffer());
+}
+
+void BinaryRpcServer::reply_method_table(const TcpConnectionPtr& conn,
+                                         const std::shared_ptr<ConnectionState>& state,
+                                         const RpcHeader& header,
+                                         const char* body) {
+    // 每次方法表请求都重新协商压缩算法：Body 携带客户端接受的算法列表，列表为空时序列化为空 Body（含旧客户端），
+    // 协商结果为不压缩，从而覆盖该连接此前的协商结果。无法解析的 Body 同样按空列表处理
+    RpcMethodTable request;
+    std::vector<CompressionType> offered;
+    if (request.ParseFromArray(body, static_cast<int>(header.bodyLen))) {
+        for (uint32_t type : request.accept_compression()) {
+            offered.push_back(static_cast<CompressionType>(type));
+        }
+    }
+    state->compression = BinaryRpcCompression::negotiate(offered, compressionOptions_.accepted);
+
+    RpcMethodTable table;
+    router_.export_method_table(&table);
+    table.set_compression(static_cast<uint32_t>(state->compression));
+
+    std::string tableRaw;
+    if (!table.SerializeToString(&tableRaw)) {
+        spdlog::error("BinaryRpcServer: Failed to serialize method table on fd {}", conn->get_fd());
+        return;
+    }
+
+    Buffer responseBuf;
+    BinaryRpcCodec::encode(&responseBuf, RpcMessageType::MethodTable, header.sequenceId, "", tableRaw, kRpcVersionMethodId);
+    conn->send(responseBuf.read_from_buffer());
+}
+
+void BinaryRpcServer::reply_overloaded(const TcpConnectionPtr& conn, const RpcHeader& header) {
+    RpcMeta meta;
+    meta.set_error_text("BinaryRpcServer: Server overloaded");
+    std::string metaRaw;
+    meta.SerializeToString(&metaRaw);
+
+    Buffer responseBuf;
+    BinaryRpcCodec::encode(&responseBuf, RpcMessageType::Response, header.sequenceId, metaRaw, "", header.version);
+    conn->send(responseBuf.read_from_buffer());
+}
+
+void BinaryRpcServer::cancel_request(const std::shared_ptr<ConnectionState>& state, uint64_t sequenceId) {
+    // 业务已在执行（可能挂起在嵌套调用上）无法中途打断，只能省掉回包；已完成或未知的序列号直接忽略
+    auto it = state->inFlightRequests.find(sequenceId);
+    if (it != state->inFlightRequests.end() && !it->second.cancelled) {
+        it->second.cancelled = true;
+        cancelledRequests_.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+bool BinaryRpcServer::is_expired(const ConnectionState& state, const RpcMeta& meta) const {
+    if (meta.timeout_ms() == 0) {
+        return false;
+    }
+    const auto deadline = state.lastReadTime + std::chrono::milliseconds(meta.timeout_ms());
+    return std::chrono::steady_clock::now() >= deadline;
+}
+
+void BinaryRpcServer::send_response(const TcpConnectionPtr& conn,
+                                    const std::shared_ptr<ConnectionState>& state,
+                                    uint64_t sequenceId,
+                                    uint8_t version,
+                                    const std::string& responseRaw) {
+    auto it = state->inFlightRequests.find(sequenceId);
+    if (it != state->inFlightRequests.end() && it->second.cancelled) {
+        return; // 客户端已取消，不再回包
+    }
+    if (it != state->inFlightRequests.end()) {
+        it->second.responded = true;
+    }
+
+    Buffer responseBuf;
+    std::string compressed;
+    if (BinaryRpcCompression::maybe_compress(state->compression, compressionOptions_.minBytes, responseRaw, &compressed)) {
+        BinaryRpcCodec::encode(&responseBuf, RpcMessageType::Response, sequenceId, "", compressed, version, kRpcFlagCompressed);
+    }
+    else {
+        BinaryRpcCodec::encode(&responseBuf, RpcMessageType::Response, sequenceId, "", responseRaw, version);
+    }
+    conn->send(responseBuf.read_from_buffer());
+}
+
+void BinaryRpcServer::send_error_response(const TcpConnectionPtr& conn,
+                                          const std::shared_ptr<ConnectionState>& state,
+                                          uint64_t sequenceId,
+                                          uint8_t version,
+                                          const std::string& error) {
+    // 已回包（业务先执行了 done 再抛出异常）、已取消或已结束的请求不再回错误包
+    auto it = state->inFlightRequests.find(sequenceId);
+    if (it == state->inFlightRequests.end() || it->second.cancelled || it->second.responded) {
+        return;
+    }
+    it->second.responded = true;
+
+    RpcMeta meta;
+    meta.set_error_text(error);
+    std::string metaRaw;
+    meta.SerializeToString(&metaRaw);
+
+    Buffer responseBuf;
+    BinaryRpcCodec::encode(&responseBuf, RpcMessageType::Response, sequenceId, metaRaw, "", version);
+    conn->send(responseBuf.read_from_buffer());
+}
+
+void BinaryRpcServer::finish_request(const TcpConnectionPtr& conn, const std::shared_ptr<ConnectionState>& state, uint64_t sequenceId) {
+    auto it = state->inFlightRequests.find(sequenceId);
+    if (it != state->inFlightRequests.end()) {
+        if (it->second.admitted) {
+            admission_.release();
+        }
+        state->inFlightRequests.erase(it);
+    }
+    if (state->inFlight > 0) {
+        --state->inFlight;
+    }
+
+    if (state->closed || state->processing || !state->readingPaused || reached_in_flight_limit(*state)) {
+        return;
+    }
+
+    state->readingPaused = false;
+    conn->start_reading();
+
+    // 暂停期间缓存中可能已积压完整帧，立即继续派发
+    process_frames(conn, state);
+}
+
+bool BinaryRpcServer::reached_in_flight_limit(const ConnectionState& state) const {
+    return maxInFlightPerConnection_ > 0 && state.inFlight >= maxInFlightPerConnection_;
 }
 
 } // namespace binary
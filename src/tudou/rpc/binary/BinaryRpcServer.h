@@ -8,18 +8,50 @@
 #pragma once
 
 #include "tudou/tcp/TcpServer.h"
+#include "tudou/tcp/AdmissionController.h"
 #include "tudou/rpc/binary/BinaryRpcRouter.h"
+#include "tudou/rpc/binary/BinaryRpcStream.h"
+#include "tudou/rpc/binary/BinaryRpcCompression.h"
+#include "tudou/rpc/binary/BinaryRpcShmTransport.h"
+#include "tudou/rpc/binary/Protocol.h"
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <unordered_map>
 
 namespace tudou {
 namespace rpc {
+
+class RpcMeta;
+
 namespace binary {
 
+class BinaryRpcShmServer;
+
+/**
+ * @brief 二进制 RPC 服务端。
+ *        每个请求帧在所属连接的 EventLoop 线程上以独立协程执行，业务内部经协程版 BinaryRpcChannel 发起的嵌套 RPC
+ *        只会挂起当前协程，同一连接及其它连接上的帧照常处理。单连接在途请求数达到上限时，新的请求帧与打开流帧
+ *        留在读缓冲中并暂停读取，形成接收背压；在此之前到达的已打开流上的帧照常处理。
+ *        携带 timeout_ms 的请求若在派发前已超时则直接丢弃；收到 Cancel 帧后不再为对应的在途请求回包；
+ *        复用仍在途的序列号视为协议错误，直接关闭连接。
+ *        可选的服务端级准入控制限制全部连接的在途请求总数，并按排队时延自适应收缩，超限请求立即以过载错误回包。
+ *        流式方法由 register_stream_handler() 注册，每条流的处理函数同样在独立协程中运行；流不计入单连接在途数，
+ *        但打开时占用一个准入名额，处理函数返回后归还。
+ *        配置了压缩算法时按连接与客户端协商，之后超过阈值的回包与流消息压缩发送；压缩的请求帧总是可以解压。
+ *        监听地址可以是 InetAddress::from_unix_path() 构造的 Unix 域地址；listen_shared_memory() 另为同机客户端
+ *        开放共享内存环形缓冲通道（见 BinaryRpcShmServer），与 TCP 监听共用已注册的服务。
+ */
 class BinaryRpcServer {
 public:
+    static constexpr size_t kDefaultMaxInFlightPerConnection = 64;
+
     BinaryRpcServer(const std::string& ip, uint16_t port, int numThreads = 0);
+    explicit BinaryRpcServer(const InetAddress& listenAddr, int numThreads = 0);
     ~BinaryRpcServer();
 
     // 禁用拷贝构造和赋值
@@ -46,17 +78,125 @@ public:
      */
     void register_service(std::shared_ptr<google::protobuf::Service> service);
 
+    /**
+     * @brief 注册流式方法的处理函数，见 BinaryRpcRouter::register_stream_handler()
+     */
+    void register_stream_handler(const google::protobuf::MethodDescriptor* method, BinaryRpcRouter::StreamHandler handler);
+
+    /**
+     * @brief 设置单连接最大在途请求数（已派发但尚未回包），需在 start() 之前调用。0 表示不限制。
+     */
+    void set_max_in_flight_per_connection(size_t limit);
+
+    /**
+     * @brief 设置服务端级准入控制（全部连接共享的在途上限与自适应收缩），运行期也可调整
+     */
+    void set_admission_options(const AdmissionOptions& options);
+
+    /**
+     * @brief 设置服务端接受的压缩算法与本端发送时的压缩阈值，需在 start() 之前调用。默认不压缩
+     */
+    void set_compression_options(const CompressionOptions& options);
+
+    /**
+     * @brief 在 Unix 域地址 path（'@' 开头为抽象命名空间）上额外开放共享内存传输，需在 start() 之前调用。
+     *        该通道在 start() 时于独立线程上启动、随 start() 返回而关闭，只承载一元调用，不受准入控制、压缩与在途上限约束
+     * @param ringCapacity 每个会话单方向的环容量
+     */
+    void listen_shared_memory(const std::string& path, size_t ringCapacity = BinaryRpcShmTransport::kDefaultRingCapacity);
+
+    /**
+     * @brief 因过载被准入控制拒绝的请求数
+     */
+    uint64_t get_rejected_request_count() const { return admission_.get_rejected_count(); }
+
+    /**
+     * @brief 因派发前已超过客户端时限而被丢弃的请求数
+     */
+    uint64_t get_expired_request_count() const { return expiredRequests_.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief 被客户端 Cancel 帧取消、未再回包的在途请求数
+     */
+    uint64_t get_cancelled_request_count() const { return cancelledRequests_.load(std::memory_order_relaxed); }
+
 private:
+    // 在途请求的记录，仅在连接所属 EventLoop 线程上读写
+    struct InFlightRequest {
+        bool cancelled = false; // 是否已被客户端取消
+        bool admitted = false;  // 是否占用了准入名额，结束时据此归还
+        bool responded = false; // 是否已经回包，派发异常时据此避免重复回包
+    };
+
+    // 连接级状态，仅在连接所属 EventLoop 线程上读写
+    struct ConnectionState {
+        size_t inFlight = 0;        // 已派发但尚未回包的请求数
+        bool readingPaused = false; // 是否因在途请求达到上限而暂停读取
+        bool processing = false;    // 是否处于拆包派发循环中，防止同步回包时重入
+        bool closed = false;        // 连接是否已关闭
+        std::unordered_map<uint64_t, InFlightRequest> inFlightRequests; // 在途请求: sequenceId -> 取消与准入记录
+        std::chrono::steady_clock::time_point lastReadTime;  // 最近一次收到数据的 poll 返回时间，作为缓冲中各帧到达时间的保守估计
+        std::unordered_map<uint64_t, std::shared_ptr<BinaryRpcStream>> streams; // 打开中的流: streamId -> 流
+        CompressionType compression = CompressionType::None; // 与该连接客户端协商得到的压缩算法
+    };
+
     void on_connection(const TcpConnectionPtr& conn);
     void on_message(const TcpConnectionPtr& conn);
     void on_close(const TcpConnectionPtr& conn);
 
+    std::shared_ptr<ConnectionState> find_connection_state(const TcpConnectionPtr& conn);
+    void process_frames(const TcpConnectionPtr& conn, const std::shared_ptr<ConnectionState>& state);
+    void dispatch_in_coroutine(const TcpConnectionPtr& conn,
+                               const std::shared_ptr<ConnectionState>& state,
+                               const RpcHeader& header,
+                               RpcMeta meta,
+                               const char* body,
+                               size_t bodyLen,
+                               bool admitted);
+    void open_stream(const TcpConnectionPtr& conn,
+                     const std::shared_ptr<ConnectionState>& state,
+                     const RpcHeader& header,
+                     const RpcMeta& meta);
+    void handle_stream_frame(const std::shared_ptr<ConnectionState>& state,
+                             const RpcHeader& header,
+                             const RpcMeta& meta,
+                             const char* body,
+                             size_t bodyLen);
+    void reply_stream_error(const TcpConnectionPtr& conn, const RpcHeader& header, const std::string& error);
+    void reply_method_table(const TcpConnectionPtr& conn,
+                            const std::shared_ptr<ConnectionState>& state,
+                            const RpcHeader& header,
+                            const char* body);
+    void reply_overloaded(const TcpConnectionPtr& conn, const RpcHeader& header);
+    void cancel_request(const std::shared_ptr<ConnectionState>& state, uint64_t sequenceId);
+    bool is_expired(const ConnectionState& state, const RpcMeta& meta) const;
+    void send_response(const TcpConnectionPtr& conn,
+                       const std::shared_ptr<ConnectionState>& state,
+                       uint64_t sequenceId,
+                       uint8_t version,
+                       const std::string& responseRaw);
+    void send_error_response(const TcpConnectionPtr& conn,
+                             const std::shared_ptr<ConnectionState>& state,
+                             uint64_t sequenceId,
+                             uint8_t version,
+                             const std::string& error);
+    void finish_request(const TcpConnectionPtr& conn, const std::shared_ptr<ConnectionState>& state, uint64_t sequenceId);
+    bool reached_in_flight_limit(const ConnectionState& state) const;
+    void init_callbacks();
+
 private:
     std::unique_ptr<TcpServer> tcpServer_;
     BinaryRpcRouter router_;
+    std::unique_ptr<BinaryRpcShmServer> shmServer_;
+    size_t maxInFlightPerConnection_ = kDefaultMaxInFlightPerConnection;
+    AdmissionController admission_;
+    CompressionOptions compressionOptions_;
+    std::atomic<uint64_t> expiredRequests_{0};
+    std::atomic<uint64_t> cancelledRequests_{0};
 
-    // 半包缓冲区，key 为连接裸指针，用以处理 TCP 粘包/半包
-    std::unordered_map<TcpConnection*, std::string> connectionBuffers_;
+    // 连接级状态表，key 为连接裸指针；多个 IO 线程共享，查找后即可脱锁使用
+    std::unordered_map<TcpConnection*, std::shared_ptr<ConnectionState>> connectionStates_;
+    std::mutex statesMutex_;
 };
 
 } // namespace binary
@@ -0,0 +1,351 @@
+/**
+ * @file BinaryRpcShmServer.cpp
+ * @brief 同机客户端经共享内存环形缓冲接入的二进制 RPC 服务端实现
+ * @author wenxingming
+ * @project: https://github.com/WenXingming/Tudou
+ */
+
+#include "BinaryRpcShmServer.h"
+#include "BinaryRpcShmTransport.h"
+#include "tudou/rpc/binary/BinaryRpcCodec.h"
+#include "tudou/rpc/binary/BinaryRpcCompression.h"
+#include "tudou/rpc/binary/BinaryRpcRouter.h"
+#include "tudou/rpc/Coroutine.h"
+#include "tudou/reactor/Channel.h"
+#include "tudou/reactor/EventLoop.h"
+#include "tudou/reactor/EventLoopThread.h"
+#include "tudou/tcp/Acceptor.h"
+#include "tudou/tcp/Socket.h"
+#include "binary_rpc.pb.h"
+
+#include <unistd.h>
+#include <cerrno>
+#include <exception>
+#include <future>
+#include <spdlog/spdlog.h>
+
+namespace tudou {
+namespace rpc {
+namespace binary {
+
+// 单个共享内存会话，只在 loop 线程内读写
+struct BinaryRpcShmServer::Session {
+    explicit Session(Socket connSocket) : socket(std::move(connSocket)) {}
+
+    Socket socket;                                    // 握手用的 Unix 域连接，之后只用于感知客户端退出
+    std::unique_ptr<BinaryRpcShmTransport> transport;
+    std::unique_ptr<Channel> socketChannel;
+    std::unique_ptr<Channel> doorbellChannel;
+    Buffer readBuf;                                   // 从入站环取出、尚未拆完的字节
+    std::deque<std::string> outFrames;                // 出站环写满时暂存的回包
+    size_t outOffset = 0;                             // outFrames 首帧已写入环的字节数
+    bool pumping = false;                             // 是否处于 pump 循环中，回包只入队由循环统一写出
+    bool closed = false;
+};
+
+BinaryRpcShmServer::BinaryRpcShmServer(BinaryRpcRouter& router, const InetAddress& listenAddr, size_t ringCapacity)
+    : router_(router)
+    , listenAddr_(listenAddr)
+    , ringCapacity_(ringCapacity) {
+}
+
+BinaryRpcShmServer::~BinaryRpcShmServer() {
+    stop();
+}
+
+void BinaryRpcShmServer::start() {
+    if (loopThread_) {
+        return;
+    }
+    loopThread_ = std::make_unique<EventLoopThread>();
+    loop_ = loopThread_->get_loop();
+
+    // 监听 socket 在 loop 线程创建，bind 失败等异常带回调用线程抛出
+    std::promise<void> ready;
+    std::future<void> readyFuture = ready.get_future();
+    loop_->run_in_loop([this, &ready]() {
+        try {
+            acceptor_ = std::make_unique<Acceptor>(loop_, listenAddr_);
+            acceptor_->set_connect_callback([this](Socket connSocket, const InetAddress&) {
+                on_connect(std::move(connSocket));
+            });
+            ready.set_value();
+        }
+        catch (...) {
+            ready.set_exception(std::current_exception());
+        }
+    });
+
+    try {
+        readyFuture.get();
+    }
+    catch (...) {
+        loopThread_.reset();
+        loop_ = nullptr;
+        throw;
+    }
+    spdlog::info("BinaryRpcShmServer: Started listening on {}", listenAddr_.get_ip_port());
+}
+
+void BinaryRpcShmServer::stop() {
+    if (!loopThread_) {
+        return;
+    }
+
+    // Channel 与 Acceptor 只能在 loop 线程注销；仍挂起的协程持有会话，之后回包时发现已关闭直接丢弃
+    std::promise<void> stopped;
+    std::future<void> stoppedFuture = stopped.get_future();
+    loop_->run_in_loop([this, &stopped]() {
+        acceptor_.reset();
+        for (auto& entry : sessions_) {
+            entry.second->closed = true;
+            entry.second->socketChannel.reset();
+            entry.second->doorbellChannel.reset();
+        }
+        sessions_.clear();
+        stopped.set_value();
+    });
+    stoppedFuture.wait();
+
+    loopThread_.reset();
+    loop_ = nullptr;
+}
+
+void BinaryRpcShmServer::on_connect(Socket connSocket) {
+    std::unique_ptr<BinaryRpcShmTransport> transport;
+    try {
+        transport = BinaryRpcShmTransport::accept_session(connSocket.fd(), ringCapacity_);
+    }
+    catch (const std::exception& e) {
+        spdlog::error("BinaryRpcShmServer: Failed to set up shared memory session on fd {}, error={}", connSocket.fd(), e.what());
+        return;
+    }
+
+    auto session = std::make_shared<Session>(std::move(connSocket));
+    session->transport = std::move(transport);
+    std::weak_ptr<Session> weakSession = session;
+
+    // 客户端握手后不再往 socket 写数据：读到 EOF 或出错即表示客户端进程已退出或关闭了通道
+    session->socketChannel = std::make_unique<Channel>(loop_, session->socket.fd());
+    auto onSocketEvent = [this, weakSession](Channel&) {
+        std::shared_ptr<Session> target = weakSession.lock();
+        if (!target) {
+            return;
+        }
+        char discard[64];
+        const ssize_t n = ::read(target->socket.fd(), discard, sizeof(discard));
+        if (n == 0 || (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)) {
+            close_session(target);
+        }
+    };
+    session->socketChannel->set_read_callback(onSocketEvent);
+    session->socketChannel->set_close_callback(onSocketEvent);
+    session->socketChannel->set_error_callback(onSocketEvent);
+    session->socketChannel->enable_reading();
+
+    session->doorbellChannel = std::make_unique<Channel>(loop_, session->transport->get_doorbell_fd());
+    session->doorbellChannel->set_read_callback([this, weakSession](Channel&) {
+        std::shared_ptr<Session> target = weakSession.lock();
+        if (!target || target->closed) {
+            return;
+        }
+        target->transport->drain_doorbell();
+        pump(target);
+    });
+    session->doorbellChannel->enable_reading();
+
+    sessions_[session.get()] = session;
+    spdlog::info("BinaryRpcShmServer: Client attached, fd={}", session->socket.fd());
+
+    // 客户端可能在门铃注册前已写入方法表协商帧，先主动处理一轮再公布等待标记
+    pump(session);
+}
+
+void BinaryRpcShmServer::close_session(const std::shared_ptr<Session>& session) {
+    if (session->closed) {
+        return;
+    }
+    spdlog::info("BinaryRpcShmServer: Client detached, fd={}", session->socket.fd());
+    session->closed = true;
+    session->socketChannel->disable_all();
+    session->doorbellChannel->disable_all();
+    sessions_.erase(session.get());
+
+    // 可能正处于本会话某个 Channel 的回调中，注销推迟到本轮事件处理之后
+    loop_->queue_in_loop([session]() {
+        session->socketChannel.reset();
+        session->doorbellChannel.reset();
+    });
+}
+
+void BinaryRpcShmServer::pump(const std::shared_ptr<Session>& session) {
+    if (session->closed || session->pumping) {
+        return;
+    }
+    session->pumping = true;
+
+    BinaryRpcShmTransport& transport = *session->transport;
+    transport.clear_wait();
+    do {
+        if (transport.read_into(&session->readBuf) > 0) {
+            transport.notify_peer_space();
+            if (!process_frames(session)) {
+                spdlog::error("BinaryRpcShmServer: Decode error on fd {}. Closing session...", session->socket.fd());
+                session->pumping = false;
+                close_session(session);
+                return;
+            }
+        }
+        flush_output(*session);
+    } while (!session->closed && !transport.arm_wait(!session->outFrames.empty()));
+
+    session->pumping = false;
+}
+
+bool BinaryRpcShmServer::process_frames(const std::shared_ptr<Session>& session) {
+    Buffer* buf = &session->readBuf;
+    RpcHeader header;
+    const char* metaData = nullptr;
+    const char* bodyData = nullptr;
+
+    while (true) {
+        const BinaryRpcCodec::DecodeResult result = BinaryRpcCodec::peek(buf, header, metaData, bodyData);
+        if (result == BinaryRpcCodec::DecodeResult::Empty || result == BinaryRpcCodec::DecodeResult::HalfPack) {
+            return true;
+        }
+        if (result == BinaryRpcCodec::DecodeResult::Error) {
+            return false;
+        }
+
+        const RpcMessageType type = frame_type(header);
+        if (type == RpcMessageType::MethodTable) {
+            reply_method_table(session, header);
+        }
+        else if (type == RpcMessageType::Request) {
+            RpcMeta meta;
+            if (!meta.ParseFromArray(metaData, static_cast<int>(header.metaLen))) {
+                return false;
+            }
+            const char* body = bodyData;
+            size_t bodyLen = header.bodyLen;
+            if (is_body_compressed(header)) {
+                const std::string* raw = BinaryRpcCompression::decompress(bodyData, header.bodyLen);
+                if (raw == nullptr) {
+                    return false;
+                }
+                body = raw->data();
+                bodyLen = raw->size();
+            }
+            dispatch_in_coroutine(session, header, meta.service_name(), meta.method_name(), meta.method_id(), body, bodyLen);
+        }
+        else if (type == RpcMessageType::StreamOpen) {
+            RpcMeta meta;
+            meta.set_error_text("BinaryRpcShmServer: Streaming is not supported over shared memory");
+            std::string metaRaw;
+            meta.SerializeToString(&metaRaw);
+            Buffer frameBuf;
+            BinaryRpcCodec::encode(&frameBuf, RpcMessageType::StreamHalfClose, header.sequenceId, metaRaw, "", header.version);
+            send_frame(session, frameBuf.read_from_buffer());
+        }
+        // Cancel、心跳与其余流式帧在共享内存会话上无需处理，直接跳过
+
+        buf->advance_read_index(BinaryRpcCodec::frame_size(header));
+    }
+}
+
+void BinaryRpcShmServer::dispatch_in_coroutine(const std::shared_ptr<Session>& session,
+                                               const RpcHeader& header,
+                                               const std::string& serviceName,
+                                               const std::string& methodName,
+                                               uint32_t methodId,
+                                               const char* body,
+                                               size_t bodyLen) {
+    const uint64_t sequenceId = header.sequenceId;
+    const uint8_t version = header.version;
+    EventLoop* loop = loop_;
+
+    auto coro = Coroutine::create(loop,
+        [this, loop, session, sequenceId, version, serviceName, methodName, methodId, body, bodyLen]() {
+            auto onDone = [this, loop, session, sequenceId, version](const std::string& responseRaw) {
+                Buffer frameBuf;
+                BinaryRpcCodec::encode(&frameBuf, RpcMessageType::Response, sequenceId, "", responseRaw, version);
+                std::string frame = frameBuf.read_from_buffer();
+                // 出站环只允许 loop 线程写入，业务在其它线程调用 done 时把回包投递回去
+                if (loop->is_in_loop_thread()) {
+                    send_frame(session, std::move(frame));
+                }
+                else {
+                    loop->queue_in_loop([this, session, frame]() {
+                        send_frame(session, frame);
+                    });
+                }
+            };
+
+            try {
+                // body 指向会话读缓冲，router 在调用业务方法（可能挂起）之前就完成反序列化，此时区间仍然有效
+                if (methodId != 0) {
+                    router_.dispatch(methodId, body, bodyLen, std::move(onDone));
+                }
+                else {
+                    router_.dispatch(serviceName, methodName, body, bodyLen, std::move(onDone));
+                }
+            }
+            catch (const std::exception& e) {
+                spdlog::error("BinaryRpcShmServer: Dispatch exception for {}.{} (id={}), error={}",
+                              serviceName, methodName, methodId, e.what());
+            }
+        }
+    );
+    coro->resume();
+}
+
+void BinaryRpcShmServer::reply_method_table(const std::shared_ptr<Session>& session, const RpcHeader& header) {
+    // 共享内存上不压缩：按 compression = None 回应，客户端随之保持原样发送
+    RpcMethodTable table;
+    router_.export_method_table(&table);
+
+    std::string tableRaw;
+    if (!table.SerializeToString(&tableRaw)) {
+        spdlog::error("BinaryRpcShmServer: Failed to serialize method table on fd {}", session->socket.fd());
+        return;
+    }
+
+    Buffer frameBuf;
+    BinaryRpcCodec::encode(&frameBuf, RpcMessageType::MethodTable, header.sequenceId, "", tableRaw, kRpcVersionMethodId);
+    send_frame(session, frameBuf.read_from_buffer());
+}
+
+void BinaryRpcShmServer::send_frame(const std::shared_ptr<Session>& session, std::string frame) {
+    if (session->closed) {
+        return;
+    }
+    session->outFrames.push_back(std::move(frame));
+    // pump 循环中的回包由循环末尾统一写出；否则立即走一轮 pump，写出后重新公布等待标记
+    if (!session->pumping) {
+        pump(session);
+    }
+}
+
+void BinaryRpcShmServer::flush_output(Session& session) {
+    bool wrote = false;
+    while (!session.outFrames.empty()) {
+        const std::string& frame = session.outFrames.front();
+        const size_t written = session.transport->write(frame.data() + session.outOffset, frame.size() - session.outOffset);
+        if (written == 0) {
+            break; // 出站环已满，等客户端读走数据后敲响门铃再继续
+        }
+        wrote = true;
+        session.outOffset += written;
+        if (session.outOffset == frame.size()) {
+            session.outFrames.pop_front();
+            session.outOffset = 0;
+        }
+    }
+    if (wrote) {
+        session.transport->notify_peer_data();
+    }
+}
+
+} // namespace binary
+} // namespace rpc
+} // namespace tudou
@@ -0,0 +1,90 @@
+/**
+ * @file BinaryRpcShmServer.h
+ * @brief 同机客户端经共享内存环形缓冲接入的二进制 RPC 服务端声明
+ * @author wenxingming
+ * @project: https://github.com/WenXingming/Tudou
+ */
+
+#pragma once
+
+#include "tudou/tcp/Buffer.h"
+#include "tudou/tcp/InetAddress.h"
+#include "tudou/rpc/binary/Protocol.h"
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+class Acceptor;
+class Channel;
+class EventLoop;
+class EventLoopThread;
+class Socket;
+
+namespace tudou {
+namespace rpc {
+namespace binary {
+
+class BinaryRpcRouter;
+class BinaryRpcShmTransport;
+
+/**
+ * @brief 共享内存传输的服务端，由 BinaryRpcServer::listen_shared_memory() 创建并与其共用服务路由。
+ *        在独立的 EventLoop 线程上监听 Unix 域地址，每个接入的客户端获得一对专属的共享内存环（见 BinaryRpcShmTransport），
+ *        请求帧与 TCP 路径一样在独立协程中派发。只承载一元调用与方法 ID 协商：流式方法以错误结束，
+ *        不做载荷压缩、准入控制与单连接在途上限，Cancel 与心跳帧直接忽略。
+ */
+class BinaryRpcShmServer {
+public:
+    BinaryRpcShmServer(BinaryRpcRouter& router, const InetAddress& listenAddr, size_t ringCapacity);
+    ~BinaryRpcShmServer();
+
+    BinaryRpcShmServer(const BinaryRpcShmServer&) = delete;
+    BinaryRpcShmServer& operator=(const BinaryRpcShmServer&) = delete;
+
+    /**
+     * @brief 拉起事件循环线程并开始监听，不阻塞。监听失败时抛出 std::runtime_error
+     */
+    void start();
+
+    /**
+     * @brief 关闭监听与全部会话并退出事件循环线程，可重复调用
+     */
+    void stop();
+
+private:
+    struct Session;
+
+    void on_connect(Socket connSocket);
+    void close_session(const std::shared_ptr<Session>& session);
+    void pump(const std::shared_ptr<Session>& session);
+    bool process_frames(const std::shared_ptr<Session>& session);
+    void dispatch_in_coroutine(const std::shared_ptr<Session>& session,
+                               const RpcHeader& header,
+                               const std::string& serviceName,
+                               const std::string& methodName,
+                               uint32_t methodId,
+                               const char* body,
+                               size_t bodyLen);
+    void reply_method_table(const std::shared_ptr<Session>& session, const RpcHeader& header);
+    void send_frame(const std::shared_ptr<Session>& session, std::string frame);
+    void flush_output(Session& session);
+
+private:
+    BinaryRpcRouter& router_;
+    InetAddress listenAddr_;
+    size_t ringCapacity_;
+
+    std::unique_ptr<EventLoopThread> loopThread_;
+    EventLoop* loop_ = nullptr;
+    std::unique_ptr<Acceptor> acceptor_;  // 只在 loop 线程内创建与销毁
+
+    // 会话表，只在 loop 线程内访问
+    std::unordered_map<Session*, std::shared_ptr<Session>> sessions_;
+};
+
+} // namespace binary
+} // namespace rpc
+} // namespace tudou
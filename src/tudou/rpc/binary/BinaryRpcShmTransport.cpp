@@ -0,0 +1,309 @@
+/**
+ * @file BinaryRpcShmTransport.cpp
+ * @brief 同机二进制 RPC 的共享内存环形缓冲传输实现
+ * @author wenxingming
+ * @project: https://github.com/WenXingming/Tudou
+ */
+
+#include "BinaryRpcShmTransport.h"
+
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+#include <string>
+
+namespace tudou {
+namespace rpc {
+namespace binary {
+
+static_assert(ATOMIC_LLONG_LOCK_FREE == 2, "shared memory rings require lock-free 64-bit atomics");
+
+// 每个字段独占一条缓存行，两端进程各自推进的位置不会互相伪共享
+struct alignas(64) ShmCacheLine {
+    std::atomic<uint64_t> value;
+};
+
+struct ShmControlBlock {
+    uint64_t magic;
+    uint64_t capacity;
+    ShmCacheLine head[2];    // 第 i 条环的写入位置（单调递增），由 i 端推进
+    ShmCacheLine tail[2];    // 第 i 条环的读取位置（单调递增），由对端推进
+    ShmCacheLine waiting[2]; // i 端正在等待的事件（kWaitData / kWaitSpace），对端据此决定是否敲门
+};
+
+namespace {
+
+constexpr uint64_t kShmMagic = 0x5444534D52494E47ULL; // "TDSMRING"
+constexpr size_t kControlSize = 4096;                 // 控制块独占首页，两条环的数据区按页对齐
+constexpr size_t kMinRingCapacity = 4096;
+constexpr size_t kMaxRingCapacity = 256 * 1024 * 1024;
+constexpr int kHandshakeTimeoutSec = 5;
+constexpr int kClientSide = 0;
+constexpr int kServerSide = 1;
+constexpr uint32_t kWaitData = 1;
+constexpr uint32_t kWaitSpace = 2;
+
+static_assert(sizeof(ShmControlBlock) <= kControlSize, "control block must fit in the first page");
+
+// 握手消息正文，三个 fd 随 SCM_RIGHTS 附带：memfd、客户端门铃、服务端门铃
+struct ShmHello {
+    uint64_t magic;
+    uint64_t capacity;
+};
+
+size_t round_up_capacity(size_t capacity) {
+    size_t rounded = kMinRingCapacity;
+    while (rounded < capacity && rounded < kMaxRingCapacity) {
+        rounded <<= 1;
+    }
+    return rounded;
+}
+
+std::string errno_text(const char* what) {
+    return std::string("BinaryRpcShmTransport: ") + what + " failed, errno=" + std::to_string(errno) + " (" + std::strerror(errno) + ")";
+}
+
+} // namespace
+
+BinaryRpcShmTransport::BinaryRpcShmTransport(int side, void* mapping, size_t mappingSize, ScopedFd ownDoorbell, ScopedFd peerDoorbell)
+    : side_(side)
+    , mapping_(mapping)
+    , mappingSize_(mappingSize)
+    , control_(static_cast<ShmControlBlock*>(mapping))
+    , capacity_(static_cast<size_t>(static_cast<ShmControlBlock*>(mapping)->capacity))
+    , ownDoorbell_(std::move(ownDoorbell))
+    , peerDoorbell_(std::move(peerDoorbell)) {
+    char* data = static_cast<char*>(mapping) + kControlSize;
+    outData_ = data + static_cast<size_t>(side_) * capacity_;
+    inData_ = data + static_cast<size_t>(1 - side_) * capacity_;
+}
+
+BinaryRpcShmTransport::~BinaryRpcShmTransport() {
+    ::munmap(mapping_, mappingSize_);
+}
+
+std::unique_ptr<BinaryRpcShmTransport> BinaryRpcShmTransport::accept_session(int sockFd, size_t ringCapacity) {
+    const size_t capacity = round_up_capacity(ringCapacity);
+    const size_t mappingSize = kControlSize + 2 * capacity;
+
+    ScopedFd memFd(::memfd_create("tudou-rpc-shm", MFD_CLOEXEC));
+    if (!memFd.valid()) {
+        throw std::runtime_error(errno_text("memfd_create()"));
+    }
+    if (::ftruncate(memFd.fd(), static_cast<off_t>(mappingSize)) < 0) {
+        throw std::runtime_error(errno_text("ftruncate()"));
+    }
+
+    ScopedFd clientDoorbell(::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC));
+    ScopedFd serverDoorbell(::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC));
+    if (!clientDoorbell.valid() || !serverDoorbell.valid()) {
+        throw std::runtime_error(errno_text("eventfd()"));
+    }
+
+    void* mapping = ::mmap(nullptr, mappingSize, PROT_READ | PROT_WRITE, MAP_SHARED, memFd.fd(), 0);
+    if (mapping == MAP_FAILED) {
+        throw std::runtime_error(errno_text("mmap()"));
+    }
+    ShmControlBlock* control = new (mapping) ShmControlBlock();
+    control->magic = kShmMagic;
+    control->capacity = capacity;
+    std::unique_ptr<BinaryRpcShmTransport> transport(
+        new BinaryRpcShmTransport(kServerSide, mapping, mappingSize, std::move(serverDoorbell), ScopedFd()));
+
+    ShmHello hello{kShmMagic, capacity};
+    struct iovec iov;
+    iov.iov_base = &hello;
+    iov.iov_len = sizeof(hello);
+
+    const int fds[3] = {memFd.fd(), clientDoorbell.fd(), transport->ownDoorbell_.fd()};
+    alignas(struct cmsghdr) char controlBuf[CMSG_SPACE(sizeof(fds))];
+    std::memset(controlBuf, 0, sizeof(controlBuf));
+
+    struct msghdr msg;
+    std::memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = controlBuf;
+    msg.msg_controllen = sizeof(controlBuf);
+
+    struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(fds));
+    std::memcpy(CMSG_DATA(cmsg), fds, sizeof(fds));
+
+    // 新接入的连接发送缓冲为空，这条小消息一次即可写完
+    if (::sendmsg(sockFd, &msg, MSG_NOSIGNAL) != static_cast<ssize_t>(sizeof(hello))) {
+        throw std::runtime_error(errno_text("sendmsg()"));
+    }
+
+    // memfd 在映射建立后即可关闭；客户端门铃留在本端用于敲门
+    transport->peerDoorbell_ = std::move(clientDoorbell);
+    return transport;
+}
+
+std::unique_ptr<BinaryRpcShmTransport> BinaryRpcShmTransport::join_session(int sockFd) {
+    struct timeval timeout{kHandshakeTimeoutSec, 0};
+    ::setsockopt(sockFd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+    ShmHello hello{0, 0};
+    struct iovec iov;
+    iov.iov_base = &hello;
+    iov.iov_len = sizeof(hello);
+
+    alignas(struct cmsghdr) char controlBuf[CMSG_SPACE(3 * sizeof(int))];
+    struct msghdr msg;
+    std::memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = controlBuf;
+    msg.msg_controllen = sizeof(controlBuf);
+
+    ssize_t n = 0;
+    do {
+        n = ::recvmsg(sockFd, &msg, MSG_CMSG_CLOEXEC);
+    } while (n < 0 && errno == EINTR);
+
+    // 先接管收到的 fd，之后的任何校验失败都不会泄漏
+    ScopedFd received[3];
+    struct cmsghdr* cmsg = n > 0 ? CMSG_FIRSTHDR(&msg) : nullptr;
+    size_t fdCount = 0;
+    if (cmsg != nullptr && cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS) {
+        fdCount = (cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+        int fds[3] = {-1, -1, -1};
+        std::memcpy(fds, CMSG_DATA(cmsg), std::min(fdCount, static_cast<size_t>(3)) * sizeof(int));
+        for (size_t index = 0; index < 3; ++index) {
+            received[index] = ScopedFd(fds[index]);
+        }
+    }
+
+    if (n < 0) {
+        throw std::runtime_error(errno_text("recvmsg()"));
+    }
+    if (n != static_cast<ssize_t>(sizeof(hello)) || hello.magic != kShmMagic || fdCount != 3
+        || (msg.msg_flags & MSG_CTRUNC) != 0) {
+        throw std::runtime_error("BinaryRpcShmTransport: Invalid handshake from server");
+    }
+
+    const size_t capacity = static_cast<size_t>(hello.capacity);
+    const size_t mappingSize = kControlSize + 2 * capacity;
+    struct stat st;
+    if (capacity < kMinRingCapacity || capacity > kMaxRingCapacity || (capacity & (capacity - 1)) != 0
+        || ::fstat(received[0].fd(), &st) < 0 || static_cast<size_t>(st.st_size) != mappingSize) {
+        throw std::runtime_error("BinaryRpcShmTransport: Shared memory size does not match handshake");
+    }
+
+    void* mapping = ::mmap(nullptr, mappingSize, PROT_READ | PROT_WRITE, MAP_SHARED, received[0].fd(), 0);
+    if (mapping == MAP_FAILED) {
+        throw std::runtime_error(errno_text("mmap()"));
+    }
+    const ShmControlBlock* control = static_cast<const ShmControlBlock*>(mapping);
+    if (control->magic != kShmMagic || control->capacity != capacity) {
+        ::munmap(mapping, mappingSize);
+        throw std::runtime_error("BinaryRpcShmTransport: Shared memory header does not match handshake");
+    }
+
+    return std::unique_ptr<BinaryRpcShmTransport>(
+        new BinaryRpcShmTransport(kClientSide, mapping, mappingSize, std::move(received[1]), std::move(received[2])));
+}
+
+void BinaryRpcShmTransport::drain_doorbell() {
+    uint64_t count = 0;
+    while (::read(ownDoorbell_.fd(), &count, sizeof(count)) < 0 && errno == EINTR) {
+    }
+}
+
+size_t BinaryRpcShmTransport::write(const char* data, size_t len) {
+    std::atomic<uint64_t>& head = control_->head[side_].value;
+    const uint64_t writePos = head.load(std::memory_order_relaxed);
+    const uint64_t readPos = control_->tail[side_].value.load(std::memory_order_acquire);
+    const size_t freeBytes = capacity_ - static_cast<size_t>(writePos - readPos);
+    const size_t n = std::min(len, freeBytes);
+    if (n == 0) {
+        return 0;
+    }
+
+    const size_t offset = static_cast<size_t>(writePos) & (capacity_ - 1);
+    const size_t first = std::min(n, capacity_ - offset);
+    std::memcpy(outData_ + offset, data, first);
+    std::memcpy(outData_, data + first, n - first);
+    head.store(writePos + n, std::memory_order_release);
+    return n;
+}
+
+size_t BinaryRpcShmTransport::read_into(Buffer* buf) {
+    const int in = 1 - side_;
+    std::atomic<uint64_t>& tail = control_->tail[in].value;
+    const uint64_t readPos = tail.load(std::memory_order_relaxed);
+    const uint64_t writePos = control_->head[in].value.load(std::memory_order_acquire);
+    // 对端越界推进的位置按最多一整环处理，错乱的字节交给拆包器判定为协议错误
+    const size_t n = std::min(static_cast<size_t>(writePos - readPos), capacity_);
+    if (n == 0) {
+        return 0;
+    }
+
+    const size_t offset = static_cast<size_t>(readPos) & (capacity_ - 1);
+    const size_t first = std::min(n, capacity_ - offset);
+    buf->write_to_buffer(inData_ + offset, first);
+    if (n > first) {
+        buf->write_to_buffer(inData_, n - first);
+    }
+    tail.store(readPos + n, std::memory_order_release);
+    return n;
+}
+
+void BinaryRpcShmTransport::notify_peer_data() {
+    notify_peer(kWaitData);
+}
+
+void BinaryRpcShmTransport::notify_peer_space() {
+    notify_peer(kWaitSpace);
+}
+
+void BinaryRpcShmTransport::notify_peer(uint32_t event) {
+    // 与 arm_wait 配对的 Dekker 式握手：本端先发布 head/tail 再读对端标记，对端先发布标记再复查环，
+    // 两侧全屏障保证至少一方看到对方的写入，不会出现双方都以为对方会处理而错过唤醒
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    std::atomic<uint64_t>& waiting = control_->waiting[1 - side_].value;
+    if ((waiting.load(std::memory_order_relaxed) & event) == 0 || waiting.exchange(0) == 0) {
+        return;
+    }
+    const uint64_t one = 1;
+    while (::write(peerDoorbell_.fd(), &one, sizeof(one)) < 0 && errno == EINTR) {
+    }
+}
+
+void BinaryRpcShmTransport::clear_wait() {
+    control_->waiting[side_].value.store(0, std::memory_order_relaxed);
+}
+
+bool BinaryRpcShmTransport::arm_wait(bool wantSpace) {
+    std::atomic<uint64_t>& waiting = control_->waiting[side_].value;
+    waiting.store(kWaitData | (wantSpace ? kWaitSpace : 0), std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    const int in = 1 - side_;
+    const bool readable = control_->head[in].value.load(std::memory_order_acquire)
+        != control_->tail[in].value.load(std::memory_order_relaxed);
+    const bool writable = wantSpace
+        && control_->head[side_].value.load(std::memory_order_relaxed)
+            - control_->tail[side_].value.load(std::memory_order_acquire) < capacity_;
+    if (readable || writable) {
+        waiting.store(0, std::memory_order_relaxed);
+        return false;
+    }
+    return true;
+}
+
+} // namespace binary
+} // namespace rpc
+} // namespace tudou
@@ -0,0 +1,107 @@
+/**
+ * @file BinaryRpcShmTransport.h
+ * @brief 同机二进制 RPC 的共享内存环形缓冲传输声明
+ * @author wenxingming
+ * @project: https://github.com/WenXingming/Tudou
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include "base/ScopedFd.h"
+#include "tudou/tcp/Buffer.h"
+
+namespace tudou {
+namespace rpc {
+namespace binary {
+
+struct ShmControlBlock;
+
+/**
+ * @brief 共享内存会话的一端。一个会话由一段 memfd 映射与两个 eventfd 门铃组成：
+ *        映射里是两条单生产者单消费者的字节环（客户端→服务端、服务端→客户端），帧按原有二进制协议写入，
+ *        读端照常用 BinaryRpcCodec 拆包，数据全程不经过内核 socket 缓冲。
+ *        每端在共享控制块中公布自己正在等待的事件（有数据可读 / 有空间可写），对端写入或读走数据后
+ *        只在本端确实处于等待时才写一次 eventfd 门铃，忙碌期间连续的帧不产生任何系统调用。
+ *        握手经 Unix 域 socket 完成：服务端创建映射与门铃后以 SCM_RIGHTS 传给客户端，该 socket 随后只用于感知对端进程退出。
+ *        一个端点的全部读写须在同一线程（其 EventLoop）上进行。
+ */
+class BinaryRpcShmTransport {
+public:
+    static constexpr size_t kDefaultRingCapacity = 1024 * 1024;
+
+    /**
+     * @brief 服务端：创建共享内存与门铃，通过已连接的 Unix 域 socket 发给客户端。失败时抛出 std::runtime_error
+     * @param ringCapacity 每个方向的环容量，向上取整到 2 的幂且不小于 4KB
+     */
+    static std::unique_ptr<BinaryRpcShmTransport> accept_session(int sockFd, size_t ringCapacity);
+
+    /**
+     * @brief 客户端：从已连接的阻塞 Unix 域 socket 接收服务端发来的共享内存与门铃，最多等待 5 秒。失败时抛出 std::runtime_error
+     */
+    static std::unique_ptr<BinaryRpcShmTransport> join_session(int sockFd);
+
+    ~BinaryRpcShmTransport();
+
+    BinaryRpcShmTransport(const BinaryRpcShmTransport&) = delete;
+    BinaryRpcShmTransport& operator=(const BinaryRpcShmTransport&) = delete;
+
+    /**
+     * @brief 本端门铃 eventfd（非阻塞），可读表示对端写入了数据或腾出了空间
+     */
+    int get_doorbell_fd() const { return ownDoorbell_.fd(); }
+
+    /**
+     * @brief 读空门铃计数，门铃可读回调中先于 read_into() 调用
+     */
+    void drain_doorbell();
+
+    /**
+     * @brief 向出站环写入至多 len 字节，空间不足时只写入一部分，返回实际写入字节数。写入后需调用 notify_peer_data()
+     */
+    size_t write(const char* data, size_t len);
+
+    /**
+     * @brief 把入站环中的全部数据追加到 buf，返回读走的字节数。读走后需调用 notify_peer_space()
+     */
+    size_t read_into(Buffer* buf);
+
+    /**
+     * @brief 对端在等待数据 / 等待空间时敲一次门铃
+     */
+    void notify_peer_data();
+    void notify_peer_space();
+
+    /**
+     * @brief 本端开始处理前撤销等待标记，处理期间对端的写入无需敲门
+     */
+    void clear_wait();
+
+    /**
+     * @brief 本端回到事件循环前公布等待标记并复查：入站环已有数据，或 wantSpace 且出站环已有空间时撤销标记返回 false，
+     *        调用方应继续处理而不是进入等待；否则返回 true，对端之后的写入或读出会敲响门铃
+     */
+    bool arm_wait(bool wantSpace);
+
+private:
+    BinaryRpcShmTransport(int side, void* mapping, size_t mappingSize, ScopedFd ownDoorbell, ScopedFd peerDoorbell);
+
+    void notify_peer(uint32_t event);
+
+private:
+    int side_;                      // 0 为客户端，1 为服务端；本端写入第 side_ 条环，读取另一条
+    void* mapping_;
+    size_t mappingSize_;
+    ShmControlBlock* control_;
+    char* outData_;                 // 出站环数据区
+    char* inData_;                  // 入站环数据区
+    size_t capacity_;
+    ScopedFd ownDoorbell_;          // 本端等待的门铃
+    ScopedFd peerDoorbell_;         // 对端等待的门铃，由本端敲响
+};
+
+} // namespace binary
+} // namespace rpc
+} // namespace tudou
@@ -0,0 +1,231 @@
+/**
+ * @file BinaryRpcStream.cpp
+ * @brief 二进制 RPC 协议上带流控窗口的双向消息流实现
+ * @author wenxingming
+ * @project: https://github.com/WenXingming/Tudou
+ */
+
+#include "BinaryRpcStream.h"
+#include "tudou/rpc/Coroutine.h"
+#include "tudou/reactor/EventLoop.h"
+#include "binary_rpc.pb.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace tudou {
+namespace rpc {
+namespace binary {
+
+namespace {
+
+std::string encode_error_meta(const std::string& error) {
+    if (error.empty()) {
+        return std::string();
+    }
+    RpcMeta meta;
+    meta.set_error_text(error);
+    return meta.SerializeAsString();
+}
+
+} // namespace
+
+BinaryRpcStream::BinaryRpcStream(uint64_t streamId, uint32_t window, EventLoop* ioLoop, FrameSender sender)
+    : streamId_(streamId)
+    , window_(window > 0 ? window : kDefaultStreamWindow)
+    , ioLoop_(ioLoop)
+    , sender_(std::move(sender))
+    , sendCredits_(window_) {
+}
+
+bool BinaryRpcStream::read(google::protobuf::Message* message) {
+    std::string raw;
+    uint32_t grant = 0;
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        wait_until(lock, [this]() {
+            return !inbox_.empty() || remoteClosed_ || cancelled_;
+        });
+        if (cancelled_ || inbox_.empty()) {
+            return false;
+        }
+        raw = std::move(inbox_.front());
+        inbox_.pop_front();
+
+        // 攒够半个窗口再归还额度，避免每条消息都回一帧 StreamWindowUpdate
+        if (!remoteClosed_ && ++consumed_ >= std::max<uint32_t>(1, window_ / 2)) {
+            grant = consumed_;
+            consumed_ = 0;
+        }
+    }
+
+    if (grant > 0) {
+        RpcMeta meta;
+        meta.set_window_increment(grant);
+        sender_(RpcMessageType::StreamWindowUpdate, meta.SerializeAsString(), std::string());
+    }
+
+    if (!message->ParseFromString(raw)) {
+        cancel("BinaryRpcStream: Failed to parse stream message");
+        return false;
+    }
+    return true;
+}
+
+bool BinaryRpcStream::write(const google::protobuf::Message& message) {
+    std::string body;
+    if (!message.SerializeToString(&body)) {
+        throw std::runtime_error("BinaryRpcStream: Failed to serialize stream message");
+    }
+
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        wait_until(lock, [this]() {
+            return sendCredits_ > 0 || cancelled_ || finished_ || localClosed_;
+        });
+        if (cancelled_ || finished_ || localClosed_) {
+            return false;
+        }
+        --sendCredits_;
+    }
+
+    sender_(RpcMessageType::StreamData, std::string(), body);
+    return true;
+}
+
+void BinaryRpcStream::writes_done() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (localClosed_ || cancelled_ || finished_) {
+            return;
+        }
+        localClosed_ = true;
+    }
+    sender_(RpcMessageType::StreamHalfClose, std::string(), std::string());
+}
+
+void BinaryRpcStream::cancel(const std::string& reason) {
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (cancelled_ || finished_) {
+            return;
+        }
+        cancelled_ = true;
+        error_ = reason;
+        wake_waiters(lock);
+    }
+    sender_(RpcMessageType::StreamCancel, encode_error_meta(reason), std::string());
+}
+
+bool BinaryRpcStream::is_cancelled() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return cancelled_;
+}
+
+std::string BinaryRpcStream::get_error() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return error_;
+}
+
+bool BinaryRpcStream::on_data(std::string body) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (cancelled_ || remoteClosed_) {
+        return true; // 中止或半关闭之后迟到的数据直接丢弃
+    }
+    if (inbox_.size() >= window_) {
+        return false; // 对端无视流控窗口
+    }
+    inbox_.push_back(std::move(body));
+    wake_waiters(lock);
+    return true;
+}
+
+void BinaryRpcStream::on_remote_half_close() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    remoteClosed_ = true;
+    wake_waiters(lock);
+}
+
+void BinaryRpcStream::on_remote_finish(const std::string& error) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (cancelled_) {
+        return;
+    }
+    remoteClosed_ = true;
+    finished_ = true;
+    error_ = error;
+    wake_waiters(lock);
+}
+
+void BinaryRpcStream::on_remote_cancel(const std::string& reason) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (cancelled_ || finished_) {
+        return;
+    }
+    cancelled_ = true;
+    error_ = reason;
+    wake_waiters(lock);
+}
+
+void BinaryRpcStream::on_window_update(uint32_t increment) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    sendCredits_ += increment;
+    wake_waiters(lock);
+}
+
+void BinaryRpcStream::finish(const std::string& error) {
+    bool sendHalfClose = false;
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (cancelled_ || finished_) {
+            return;
+        }
+        // 处理函数已主动 writes_done() 时半关闭帧已发出，对端据此结束流，不再补发
+        sendHalfClose = !localClosed_;
+        localClosed_ = true;
+        finished_ = true;
+        error_ = error;
+        wake_waiters(lock);
+    }
+    if (sendHalfClose) {
+        sender_(RpcMessageType::StreamHalfClose, encode_error_meta(error), std::string());
+    }
+}
+
+template <typename Predicate>
+void BinaryRpcStream::wait_until(std::unique_lock<std::mutex>& lock, Predicate predicate) {
+    while (!predicate()) {
+        Coroutine* coro = Coroutine::t_current_coroutine;
+        if (coro != nullptr) {
+            // 唤醒方总是把恢复投递到协程所属 loop，因此解锁与 yield 之间的唤醒不会丢失
+            waiters_.push_back(coro->shared_from_this());
+            lock.unlock();
+            coro->yield();
+            lock.lock();
+            continue;
+        }
+
+        // 消息只能由所属 IO loop 分发，在该线程阻塞等待必然死锁
+        if (ioLoop_ != nullptr && ioLoop_->is_in_loop_thread()) {
+            throw std::logic_error("BinaryRpcStream: Blocking wait on the stream's own EventLoop thread");
+        }
+        cond_.wait(lock);
+    }
+}
+
+void BinaryRpcStream::wake_waiters(std::unique_lock<std::mutex>& lock) {
+    std::vector<std::shared_ptr<Coroutine>> waiters;
+    waiters.swap(waiters_);
+    lock.unlock();
+
+    for (const std::shared_ptr<Coroutine>& coro : waiters) {
+        coro->get_loop()->queue_in_loop([coro]() {
+            coro->resume();
+        });
+    }
+    cond_.notify_all();
+}
+
+} // namespace binary
+} // namespace rpc
+} // namespace tudou
@@ -0,0 +1,114 @@
+/**
+ * @file BinaryRpcStream.h
+ * @brief 二进制 RPC 协议上带流控窗口的双向消息流声明
+ * @author wenxingming
+ * @project: https://github.com/WenXingming/Tudou
+ */
+
+#pragma once
+
+#include "tudou/rpc/binary/Protocol.h"
+#include <google/protobuf/message.h>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+class EventLoop;
+
+namespace tudou {
+namespace rpc {
+
+class Coroutine;
+
+namespace binary {
+
+class BinaryRpcChannel;
+class BinaryRpcServer;
+
+/**
+ * @brief 一条双向消息流，客户端由 BinaryRpcChannel::open_stream() 打开，服务端作为流处理函数的参数传入。
+ *        read()/write() 在协程中调用时只挂起当前协程，否则阻塞当前线程（禁止在所属 IO loop 线程上阻塞）。
+ *        每个方向最多有 window 条消息在途：接收方未消费的消息不会超过窗口，发送方额度耗尽时 write() 等待对端归还额度，
+ *        因此大结果集可以边产生边消费，两端内存都有上界。
+ *        客户端：服务端结束流（或任一方取消）后 read() 返回 false，get_error() 非空表示以错误结束。
+ *        服务端：客户端 writes_done() 后 read() 返回 false，此时仍可继续 write()；处理函数返回即结束流。
+ */
+class BinaryRpcStream {
+public:
+    // 帧发送器：由所属 Channel / Server 提供，把一帧编码后写到流所在的连接
+    using FrameSender = std::function<void(RpcMessageType type, const std::string& metaRaw, const std::string& body)>;
+
+    BinaryRpcStream(uint64_t streamId, uint32_t window, EventLoop* ioLoop, FrameSender sender);
+    ~BinaryRpcStream() = default;
+
+    // 禁用拷贝构造和赋值
+    BinaryRpcStream(const BinaryRpcStream&) = delete;
+    BinaryRpcStream& operator=(const BinaryRpcStream&) = delete;
+
+    /**
+     * @brief 读取下一条消息，无消息时等待。对端已结束发送、流已结束或已取消时返回 false
+     */
+    bool read(google::protobuf::Message* message);
+
+    /**
+     * @brief 发送一条消息，额度耗尽时等待对端归还。流已结束、已取消或本方已 writes_done() 时返回 false
+     */
+    bool write(const google::protobuf::Message& message);
+
+    /**
+     * @brief 结束本方向的发送（半关闭），对端读完已发送的消息后 read() 返回 false
+     */
+    void writes_done();
+
+    /**
+     * @brief 中止流并通知对端，双方挂起中的 read()/write() 立即返回 false
+     */
+    void cancel(const std::string& reason = "BinaryRpcStream: Cancelled");
+
+    bool is_cancelled() const;
+    std::string get_error() const;
+    uint64_t get_stream_id() const { return streamId_; }
+
+private:
+    friend class BinaryRpcChannel;
+    friend class BinaryRpcServer;
+
+    // 以下由所属 Channel / Server 在其 IO 线程上调用，均不阻塞
+    bool on_data(std::string body);                 // 超出接收窗口时返回 false，调用方应中止该流
+    void on_remote_half_close();                    // 对端结束发送
+    void on_remote_finish(const std::string& error); // 服务端结束整个流（仅客户端）
+    void on_remote_cancel(const std::string& reason);
+    void on_window_update(uint32_t increment);
+    void finish(const std::string& error);           // 服务端处理函数返回后结束流（仅服务端）
+
+    template <typename Predicate>
+    void wait_until(std::unique_lock<std::mutex>& lock, Predicate predicate);
+    void wake_waiters(std::unique_lock<std::mutex>& lock); // 释放锁后唤醒全部等待者
+
+private:
+    const uint64_t streamId_;
+    const uint32_t window_;
+    EventLoop* ioLoop_;     // 帧收发所在的 IO loop，线程模式下为空
+    FrameSender sender_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable cond_;
+    std::vector<std::shared_ptr<Coroutine>> waiters_; // 挂起等待本流的协程，唤醒时投递回各自所属 loop 恢复
+    std::deque<std::string> inbox_;      // 已收到但尚未被 read() 消费的消息
+    uint32_t sendCredits_;               // 剩余发送额度
+    uint32_t consumed_ = 0;              // 自上次归还以来已消费的消息数
+    bool localClosed_ = false;           // 本方已结束发送
+    bool remoteClosed_ = false;          // 对端已结束发送
+    bool finished_ = false;              // 整个流已结束（服务端已回 StreamHalfClose）
+    bool cancelled_ = false;
+    std::string error_;
+};
+
+} // namespace binary
+} // namespace rpc
+} // namespace tudou
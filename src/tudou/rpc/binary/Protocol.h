@@ -26,6 +26,30 @@
  *
  * Note: High-fidelity image layout is saved in:
  * docs/tudou_rpc_protocol.jpg
+ *
+ * Version 1: Meta 为携带完整 service_name / method_name 的 RpcMeta。
+ * Version 2: 帧头不变。客户端先发送一个 MethodTable 帧，服务端以 MethodTable 帧回传 RpcMethodTable；
+ *            此后请求的 RpcMeta 只需携带 method_id，服务端以数组下标直接定位方法。
+ *            服务端始终同时接受 version 1 帧，未完成协商（或对端不支持）的客户端继续按 version 1 发送。
+ *
+ * Deadline / Cancel: RpcMeta.timeout_ms 携带调用的相对时限，服务端据此跳过已过期的请求；
+ *            客户端超时或主动取消时发送 Cancel 帧（Sequence ID 为被取消的请求，Meta 与 Body 为空），
+ *            服务端不再为该请求回包。不识别 Cancel 帧的旧服务端按未知方法记录错误后丢弃该帧。
+ *
+ * Overload: 服务端准入控制拒绝的请求立即以 Response 帧回包，Meta 为携带 error_text 的 RpcMeta、Body 为空，
+ *            客户端据此以失败结束调用，而不是让请求在服务端排队。
+ *
+ * Streaming: Sequence ID 同时作为流 ID。客户端以 StreamOpen 帧（Meta 携带服务名、方法名与 stream_window）打开流，
+ *            此后双方各自发送 StreamData 帧（Body 为一条 protobuf 消息），以 StreamHalfClose 帧结束本方向的发送；
+ *            服务端的 StreamHalfClose 同时结束整个调用，Meta 中非空的 error_text 表示以错误结束。
+ *            任一方可发送 StreamCancel 帧中止流。流控以消息条数计：每个方向的初始额度为 stream_window，
+ *            接收方每消费一批消息后以 StreamWindowUpdate 帧（Meta 携带 window_increment）归还额度，
+ *            发送方额度耗尽即挂起等待，任一时刻每个方向在途的消息数都不超过窗口。
+ *
+ * Compression: 客户端在 MethodTable 请求帧的 Body 中携带 RpcMethodTable.accept_compression（按偏好排序），
+ *            服务端在回包的 compression 字段给出选定的算法。协商成功后双方可各自压缩 Request / Response / StreamData
+ *            的 Body，并置位 Type 字节的最高位（kRpcFlagCompressed）；压缩后的 Body 以 1 字节算法编号与 4 字节原始长度开头。
+ *            旧服务端忽略请求 Body、回包不带 compression，旧客户端不发 accept_compression，两种情况都退化为不压缩。
  */
 
 #pragma once
@@ -40,14 +64,37 @@ namespace binary {
 // 协议头部魔数，用以快速识别合法请求 (TD = 0x5444)
 constexpr uint16_t kRpcMagic = 0x5444;
 constexpr uint8_t kRpcVersion = 1;
+constexpr uint8_t kRpcVersionMethodId = 2; // 支持方法 ID 协商的协议版本
 
 // 二进制包消息类型
 enum class RpcMessageType : uint8_t {
     Request = 0,
     Response = 1,
-    Heartbeat = 2
+    Heartbeat = 2,
+    MethodTable = 3,        // 方法表协商：客户端请求 Body 为 RpcMethodTable（accept_compression，可为空），服务端回包 Body 为 RpcMethodTable
+    Cancel = 4,             // 取消请求：Sequence ID 指向被取消的请求，Meta 与 Body 为空
+    StreamOpen = 5,         // 打开流：Meta 为 RpcMeta（服务名、方法名、stream_window），Body 为空
+    StreamData = 6,         // 流消息：Meta 为空，Body 为一条 protobuf 消息
+    StreamHalfClose = 7,    // 结束本方向的发送；服务端发出时结束整个流，Meta 可携带 error_text
+    StreamCancel = 8,       // 中止流：Meta 可携带 error_text
+    StreamWindowUpdate = 9  // 归还接收额度：Meta 携带 window_increment
 };
 
+// Type 字节最高位：Body 经过压缩；低 7 位为 RpcMessageType
+constexpr uint8_t kRpcFlagCompressed = 0x80;
+constexpr uint8_t kRpcTypeMask = 0x7F;
+
+// 流的默认接收窗口（消息条数）
+constexpr uint32_t kDefaultStreamWindow = 32;
+
+// 是否为已打开流上的后续帧（StreamOpen 之外的流式帧）
+inline bool is_stream_frame(RpcMessageType type) {
+    return type == RpcMessageType::StreamData
+        || type == RpcMessageType::StreamHalfClose
+        || type == RpcMessageType::StreamCancel
+        || type == RpcMessageType::StreamWindowUpdate;
+}
+
 #pragma pack(push, 1)
 struct RpcHeader {
     uint16_t magic;       // 0-1 字节: 协议魔数 (Big-Endian)
@@ -62,6 +109,16 @@ struct RpcHeader {
 // 头部总大小固定为 20 字节
 constexpr size_t kRpcHeaderSize = sizeof(RpcHeader);
 
+// 去掉标志位后的消息类型
+inline RpcMessageType frame_type(const RpcHeader& header) {
+    return static_cast<RpcMessageType>(header.type & kRpcTypeMask);
+}
+
+// Body 是否经过压缩
+inline bool is_body_compressed(const RpcHeader& header) {
+    return (header.type & kRpcFlagCompressed) != 0;
+}
+
 } // namespace binary
 } // namespace rpc
 } // namespace tudou
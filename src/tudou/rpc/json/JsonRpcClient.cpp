@@ -6,10 +6,9 @@
  */
 
 #include "JsonRpcClient.h"
+#include "tudou/tcp/InetAddress.h"
 
 #include <sys/socket.h>
-#include <netinet/in.h>
-#include <arpa/inet.h>
 #include <unistd.h>
 #include <cstring>
 #include <stdexcept>
@@ -18,23 +17,29 @@
 namespace tudou {
 namespace rpc {
 
+namespace {
+
+// 文本地址解析失败时沿用客户端一贯的 runtime_error 契约
+InetAddress resolve_address(const std::string& ip, uint16_t port) {
+    try {
+        return InetAddress(ip, port);
+    }
+    catch (const std::invalid_argument&) {
+        throw std::runtime_error("JsonRpcClient: Invalid IP address: " + ip);
+    }
+}
+
+} // namespace
+
 JsonRpcClient::JsonRpcClient(const std::string& ip, uint16_t port) {
-    clientFd_ = ::socket(AF_INET, SOCK_STREAM, 0);
+    // 先解析地址再创建 socket：地址族（IPv4 / IPv6）决定 socket 的协议族
+    const InetAddress servAddr = resolve_address(ip, port);
+    clientFd_ = ::socket(servAddr.get_family(), SOCK_STREAM, 0);
     if (clientFd_ < 0) {
         throw std::runtime_error("JsonRpcClient: Failed to create socket");
     }
 
-    struct sockaddr_in servAddr;
-    std::memset(&servAddr, 0, sizeof(servAddr));
-    servAddr.sin_family = AF_INET;
-    servAddr.sin_port = htons(port);
-    
-    if (::inet_pton(AF_INET, ip.c_str(), &servAddr.sin_addr) != 1) {
-        ::close(clientFd_);
-        throw std::runtime_error("JsonRpcClient: Invalid IP address: " + ip);
-    }
-
-    if (::connect(clientFd_, (struct sockaddr*)&servAddr, sizeof(servAddr)) < 0) {
+    if (::connect(clientFd_, servAddr.get_sockaddr_ptr(), servAddr.get_socklen()) < 0) {
         ::close(clientFd_);
         throw std::runtime_error("JsonRpcClient: Failed to connect to server " + ip + ":" + std::to_string(port));
     }
@@ -63,7 +68,7 @@ nlohmann::json JsonRpcClient::call(const std::string& method, const nlohmann::js
     // 2. 发送请求字节流到网络 Socket
     size_t totalSent = 0;
     while (totalSent < requestStr.size()) {
-        ssize_t n = ::write(clientFd_, requestStr.data() + totalSent, requestStr.size() - totalSent);
+        ssize_t n = ::send(clientFd_, requestStr.data() + totalSent, requestStr.size() - totalSent, MSG_NOSIGNAL);
         if (n <= 0) {
             if (n < 0 && errno == EINTR) {
                 continue;
@@ -17,7 +17,7 @@ class JsonRpcClient {
 public:
     /**
      * @brief 构造函数，建立到 JSON-RPC 服务端的 TCP 连接
-     * @param ip 服务端 IP 地址
+     * @param ip 服务端 IP 地址（IPv4 或 IPv6 文本）
      * @param port 服务端监听端口
      */
     JsonRpcClient(const std::string& ip, uint16_t port);
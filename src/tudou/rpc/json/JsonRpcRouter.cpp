@@ -7,58 +7,562 @@
 
 #include "JsonRpcRouter.h"
 
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
 #include <exception>
+#include <memory>
+#include <mutex>
 #include <stdexcept>
+#include <thread>
+#include <vector>
 #include <spdlog/spdlog.h>
 
-JsonRpcRouter::JsonRpcRouter() = default;
+#if TUDOU_HAS_SIMDJSON
+#include <simdjson.h>
+#endif
+
+namespace {
+
+// 当前线程是否为批量工作线程：处理器内嵌套 dispatch 的 Batch 在工作线程上顺序执行，避免工作线程互相等待而死锁
+thread_local bool inBatchWorker = false;
+
+/**
+ * @brief 执行业务处理器，并把异常统一映射为 JSON-RPC 错误码；两种解析后端共用。
+ * @return 处理器正常返回时为 true，否则 code/message 为应回的错误
+ */
+template <typename Body>
+bool run_handler(const std::string& methodName, Body&& body, int& code, std::string& message) {
+    try {
+        body();
+        return true;
+    }
+    catch (const nlohmann::json::exception& e) {
+        // 通常是 params 参数读取类型不匹配异常，归为 Invalid params 错误
+        spdlog::error("JsonRpcRouter: Invalid params exception for method={}, error={}", methodName, e.what());
+        code = -32602;
+        message = "Invalid params: " + std::string(e.what());
+    }
+    catch (const std::invalid_argument& e) {
+        spdlog::error("JsonRpcRouter: Invalid argument for method={}, error={}", methodName, e.what());
+        code = -32602;
+        message = "Invalid params: " + std::string(e.what());
+    }
+    catch (const std::exception& e) {
+        // 服务端内部异常，归为 Internal error
+        spdlog::error("JsonRpcRouter: Internal error for method={}, error={}", methodName, e.what());
+        code = -32603;
+        message = "Internal error: " + std::string(e.what());
+    }
+    catch (...) {
+        spdlog::error("JsonRpcRouter: Unknown internal exception for method={}", methodName);
+        code = -32603;
+        message = "Internal error: Unknown exception";
+    }
+    return false;
+}
+
+// 流式写出错误响应；id 为原始 JSON 文本，空指针表示 null
+void write_error_response(std::string& output, const char* id, size_t idLen, int code, const std::string& message) {
+    output.append("{\"jsonrpc\":\"2.0\",\"error\":{\"code\":");
+    output.append(std::to_string(code));
+    output.append(",\"message\":");
+    output.append(nlohmann::json(message).dump());
+    output.append("},\"id\":");
+    if (id) {
+        output.append(id, idLen);
+    } else {
+        output.append("null");
+    }
+    output.push_back('}');
+}
+
+// 拼装 DOM 后端的 Batch 响应，跳过 Notification 留下的空位；全部为 Notification 时返回空串
+std::string join_dom_responses(std::vector<nlohmann::json>& responses) {
+    nlohmann::json batchResponse = nlohmann::json::array();
+    for (nlohmann::json& singleResponse : responses) {
+        if (!singleResponse.is_null()) {
+            batchResponse.push_back(std::move(singleResponse));
+        }
+    }
+    return batchResponse.empty() ? std::string() : batchResponse.dump();
+}
+
+#if TUDOU_HAS_SIMDJSON
+
+// 按请求顺序拼接 OnDemand 后端各元素独立写出的响应，wrote[i] 为 false 的元素不回包；全部不回包时 output 不变
+void append_batch_outputs(std::string& output, const std::vector<std::string>& entryOutputs, const bool* wrote) {
+    const size_t batchStart = output.size();
+    output.push_back('[');
+    bool wroteAny = false;
+    for (size_t i = 0; i < entryOutputs.size(); ++i) {
+        if (!wrote[i]) {
+            continue;
+        }
+        if (wroteAny) {
+            output.push_back(',');
+        }
+        output.append(entryOutputs[i]);
+        wroteAny = true;
+    }
+    if (!wroteAny) {
+        output.resize(batchStart);
+        return;
+    }
+    output.push_back(']');
+}
+
+// 扫描阶段从一个请求对象中记下的字段；文本区间指向填充副本内部，执行阶段之前不做任何物化
+struct RequestSpan {
+    bool isObject = false;
+    bool hasId = false;
+    bool idValid = true;
+    bool versionValid = false;
+    bool methodValid = false;
+    bool paramsValid = true;
+    std::string method;
+    const char* id = nullptr;
+    size_t idLen = 0;
+    const char* params = nullptr;   // 空指针表示请求未携带 params
+    size_t paramsLen = 0;
+};
+
+// 每个线程复用的解析器与填充缓冲，处理器内嵌套 dispatch 时另起一份
+struct OnDemandScratch {
+    simdjson::ondemand::parser parser;
+    std::string padded;
+    std::vector<RequestSpan> spans;
+};
+
+simdjson::error_code raw_text(simdjson::ondemand::value& value, const char*& data, size_t& len) {
+    std::string_view text;
+    const simdjson::error_code error = value.raw_json().get(text);
+    if (error) {
+        return error;
+    }
+    // 标量的原始文本带有其后的空白
+    len = text.size();
+    while (len > 0 && (text[len - 1] == ' ' || text[len - 1] == '\t' || text[len - 1] == '\n' || text[len - 1] == '\r')) {
+        --len;
+    }
+    data = text.data();
+    return simdjson::SUCCESS;
+}
+
+// 只扫描一次请求信封：jsonrpc/method 取值，id/params 只记录原始文本区间，其余字段由 On-Demand 迭代器跳过
+simdjson::error_code scan_request(simdjson::ondemand::value value, RequestSpan& span) {
+    using simdjson::ondemand::json_type;
+
+    json_type type;
+    simdjson::error_code error = value.type().get(type);
+    if (error) {
+        return error;
+    }
+    if (type != json_type::object) {
+        const char* ignored = nullptr;
+        size_t ignoredLen = 0;
+        return raw_text(value, ignored, ignoredLen);
+    }
+
+    span.isObject = true;
+    simdjson::ondemand::object object;
+    if ((error = value.get_object().get(object))) {
+        return error;
+    }
+    for (auto fieldResult : object) {
+        simdjson::ondemand::field field;
+        std::string_view key;
+        if ((error = std::move(fieldResult).get(field)) || (error = field.unescaped_key().get(key))) {
+            return error;
+        }
+        simdjson::ondemand::value fieldValue = field.value();
+        json_type fieldType;
+        if ((error = fieldValue.type().get(fieldType))) {
+            return error;
+        }
+
+        if (key == "jsonrpc") {
+            span.versionValid = false;
+            if (fieldType == json_type::string) {
+                std::string_view version;
+                if ((error = fieldValue.get_string().get(version))) {
+                    return error;
+                }
+                span.versionValid = version == "2.0";
+            }
+        } else if (key == "method") {
+            span.methodValid = false;
+            if (fieldType == json_type::string) {
+                std::string_view method;
+                if ((error = fieldValue.get_string().get(method))) {
+                    return error;
+                }
+                span.method.assign(method.data(), method.size());
+                span.methodValid = true;
+            }
+        } else if (key == "id") {
+            span.hasId = true;
+            span.idValid = fieldType == json_type::string || fieldType == json_type::number || fieldType == json_type::null;
+            if ((error = raw_text(fieldValue, span.id, span.idLen))) {
+                return error;
+            }
+        } else if (key == "params") {
+            span.paramsValid = fieldType == json_type::object || fieldType == json_type::array || fieldType == json_type::null;
+            if ((error = raw_text(fieldValue, span.params, span.paramsLen))) {
+                return error;
+            }
+        }
+    }
+    return simdjson::SUCCESS;
+}
+
+#endif
+
+} // namespace
+
+/**
+ * @brief 批量并行的工作线程池。所有线程共享一个任务队列，某个慢请求不会让排在同一线程后面的元素空等；
+ *        Batch 元素的数量由各 Batch 的并发上限约束，Notification 另按全池的上限计数。
+ *        析构时先执行完队列中剩余的任务（包括尚未执行的 Notification）再 join。
+ */
+class JsonRpcRouter::BatchWorkerPool {
+public:
+    explicit BatchWorkerPool(int numThreads)
+        : mutex_(), cond_(), tasks_(), pendingNotifications_(0), stopping_(false), threads_() {
+        threads_.reserve(static_cast<size_t>(numThreads));
+        for (int i = 0; i < numThreads; ++i) {
+            threads_.emplace_back([this]() { run(); });
+        }
+    }
+
+    ~BatchWorkerPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
+        }
+        cond_.notify_all();
+        for (std::thread& thread : threads_) {
+            thread.join();
+        }
+    }
+
+    BatchWorkerPool(const BatchWorkerPool&) = delete;
+    BatchWorkerPool& operator=(const BatchWorkerPool&) = delete;
+
+    void submit(std::function<void()> task) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            tasks_.push_back(std::move(task));
+        }
+        cond_.notify_one();
+    }
+
+    /**
+     * @brief 排队与执行中的 Notification 少于 limit 时入队并返回 true；否则 task 保持原样，返回 false
+     */
+    bool try_submit_notification(std::function<void()>& task, size_t limit) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (pendingNotifications_ >= limit) {
+                return false;
+            }
+            ++pendingNotifications_;
+            tasks_.push_back([this, task = std::move(task)]() {
+                task();
+                std::lock_guard<std::mutex> lock(mutex_);
+                --pendingNotifications_;
+            });
+        }
+        cond_.notify_one();
+        return true;
+    }
+
+    size_t size() const { return threads_.size(); }
+
+private:
+    void run() {
+        inBatchWorker = true;
+        for (;;) {
+            std::function<void()> task;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                cond_.wait(lock, [this]() { return stopping_ || !tasks_.empty(); });
+                if (tasks_.empty()) {
+                    return;
+                }
+                task = std::move(tasks_.front());
+                tasks_.pop_front();
+            }
+            task();
+        }
+    }
+
+private:
+    std::mutex mutex_;
+    std::condition_variable cond_;
+    std::deque<std::function<void()>> tasks_;
+    size_t pendingNotifications_;   // 排队与执行中的 Notification 数
+    bool stopping_;
+    std::vector<std::thread> threads_;
+};
+
+/**
+ * @brief 一个并行 Batch 的进度，由其在途元素共同持有：完成一个元素便提交下一个，最后完成的元素调用 onComplete。
+ */
+struct JsonRpcRouter::BatchState {
+    std::mutex mutex;
+    std::vector<std::function<void()>> works;   // 需要等待结果的元素，按请求顺序
+    size_t next = 0;                            // 下一个待提交的元素
+    size_t remaining = 0;                       // 尚未完成的元素数
+    std::function<void()> onComplete;
+};
+
+JsonRpcRouter::JsonRpcRouter()
+    : methods_(),
+      backend_(Backend::Nlohmann),
+      batchConcurrency_(0),
+      maxPendingNotifications_(0),
+      batchPool_(nullptr) {}
+
 JsonRpcRouter::~JsonRpcRouter() = default;
 
 void JsonRpcRouter::register_method(const std::string& name, RpcHandler handler) {
-    methods_[name] = std::move(handler);
+    methods_[name] = MethodEntry{ std::move(handler), nullptr };
     spdlog::info("JsonRpcRouter: Method registered successfully, name={}", name);
 }
 
+void JsonRpcRouter::register_raw_method(const std::string& name, RawRpcHandler handler) {
+    methods_[name] = MethodEntry{ nullptr, std::move(handler) };
+    spdlog::info("JsonRpcRouter: Raw method registered successfully, name={}", name);
+}
+
+bool JsonRpcRouter::is_backend_available(Backend backend) {
+    if (backend == Backend::OnDemand) {
+        return TUDOU_HAS_SIMDJSON != 0;
+    }
+    return true;
+}
+
+bool JsonRpcRouter::set_backend(Backend backend) {
+    if (!is_backend_available(backend)) {
+        spdlog::warn("JsonRpcRouter: On-demand JSON backend is not built in (simdjson not found), keeping current backend");
+        return false;
+    }
+    backend_ = backend;
+    return true;
+}
+
+void JsonRpcRouter::enable_parallel_batch(int numThreads, size_t maxConcurrency, size_t maxPendingNotifications) {
+    if (numThreads <= 0) {
+        throw std::invalid_argument("JsonRpcRouter: parallel batch requires at least one worker thread");
+    }
+    batchPool_.reset(new BatchWorkerPool(numThreads));
+    batchConcurrency_ = maxConcurrency > 0 ? maxConcurrency : static_cast<size_t>(numThreads);
+    maxPendingNotifications_ = maxPendingNotifications;
+    spdlog::info("JsonRpcRouter: Parallel batch enabled, threads={}, maxConcurrency={}, maxPendingNotifications={}",
+                 numThreads, batchConcurrency_, maxPendingNotifications_);
+}
+
+bool JsonRpcRouter::parallel_batch_enabled() const {
+    return batchPool_ != nullptr && !inBatchWorker;
+}
+
+bool JsonRpcRouter::is_fire_and_forget(const nlohmann::json& req) const {
+    // 只有能通过全部校验的 Notification 才不需要任何响应，其余（包括不带 id 的非法请求）仍按原语义回错误
+    if (!req.is_object() || req.contains("id")) {
+        return false;
+    }
+    auto version = req.find("jsonrpc");
+    auto method = req.find("method");
+    if (version == req.end() || *version != "2.0" || method == req.end() || !method->is_string()
+        || methods_.find(method->get_ref<const std::string&>()) == methods_.end()) {
+        return false;
+    }
+    auto params = req.find("params");
+    return params == req.end() || params->is_object() || params->is_array() || params->is_null();
+}
+
+bool JsonRpcRouter::run_batch_tasks(std::vector<BatchTask> tasks, std::function<void()> onComplete) {
+    auto state = std::make_shared<BatchState>();
+    for (BatchTask& task : tasks) {
+        if (task.awaited) {
+            state->works.push_back(std::move(task.work));
+        } else {
+            submit_notification(std::move(task.work));
+        }
+    }
+    if (state->works.empty()) {
+        return false;
+    }
+
+    // 先提交并发上限内的元素，其余由完成的元素接力提交，调用线程不等待
+    const size_t initial = std::min(batchConcurrency_, state->works.size());
+    state->next = initial;
+    state->remaining = state->works.size();
+    state->onComplete = std::move(onComplete);
+    for (size_t i = 0; i < initial; ++i) {
+        submit_batch_task(state, i);
+    }
+    return true;
+}
+
+void JsonRpcRouter::submit_batch_task(const std::shared_ptr<BatchState>& state, size_t index) {
+    batchPool_->submit([this, state, index]() {
+        try {
+            state->works[index]();
+        }
+        catch (const std::exception& e) {
+            spdlog::error("JsonRpcRouter: Batch task failed, error={}", e.what());
+        }
+        state->works[index] = nullptr;
+
+        size_t nextIndex = state->works.size();
+        bool last = false;
+        {
+            std::lock_guard<std::mutex> lock(state->mutex);
+            if (state->next < state->works.size()) {
+                nextIndex = state->next++;
+            }
+            last = --state->remaining == 0;
+        }
+        if (nextIndex < state->works.size()) {
+            submit_batch_task(state, nextIndex);
+        }
+        if (!last) {
+            return;
+        }
+        try {
+            state->onComplete();
+        }
+        catch (const std::exception& e) {
+            spdlog::error("JsonRpcRouter: Batch completion callback failed, error={}", e.what());
+        }
+    });
+}
+
+void JsonRpcRouter::submit_notification(std::function<void()> work) {
+    std::function<void()> task = [work = std::move(work)]() {
+        try {
+            work();
+        }
+        catch (const std::exception& e) {
+            spdlog::error("JsonRpcRouter: Notification task failed, error={}", e.what());
+        }
+    };
+    // 线程池中积压的 Notification 已达上限：在调用线程上就地执行，dispatch 随之变慢，把压力传回发送方
+    if (!batchPool_->try_submit_notification(task, maxPendingNotifications_)) {
+        task();
+    }
+}
+
 std::string JsonRpcRouter::dispatch(const std::string& requestStr) {
-    if (requestStr.empty()) {
-        return make_error_response(nullptr, -32600, "Invalid Request (empty body)").dump();
+    return dispatch(requestStr.data(), requestStr.size());
+}
+
+std::string JsonRpcRouter::dispatch(const char* data, size_t len) {
+    std::string output;
+    dispatch(data, len, output);
+    return output;
+}
+
+void JsonRpcRouter::dispatch(const char* data, size_t len, std::string& output) {
+    // 并行 Batch 由最后完成的元素回调，在调用线程上等待；回调释放锁之前这里无法返回，等待状态可以放在栈上
+    struct Waiter {
+        std::mutex mutex;
+        std::condition_variable cond;
+        bool finished = false;
+        std::string response;
+    } waiter;
+    Waiter* waiterPtr = &waiter;
+    if (dispatch(data, len, output, [waiterPtr](std::string&& response) {
+            std::lock_guard<std::mutex> lock(waiterPtr->mutex);
+            waiterPtr->response = std::move(response);
+            waiterPtr->finished = true;
+            waiterPtr->cond.notify_one();
+        })) {
+        return;
+    }
+    std::unique_lock<std::mutex> lock(waiter.mutex);
+    waiter.cond.wait(lock, [&waiter]() { return waiter.finished; });
+    output.append(waiter.response);
+}
+
+bool JsonRpcRouter::dispatch(const char* data, size_t len, std::string& output, ResponseCallback done) {
+    if (!done) {
+        dispatch(data, len, output);
+        return true;
+    }
+    if (backend_ == Backend::OnDemand) {
+        return dispatch_on_demand(data, len, output, done);
+    }
+    return dispatch_dom(data, len, output, done);
+}
+
+bool JsonRpcRouter::dispatch_dom(const char* data, size_t len, std::string& output, const ResponseCallback& done) {
+    if (len == 0) {
+        output.append(make_error_response(nullptr, -32600, "Invalid Request (empty body)").dump());
+        return true;
     }
 
     nlohmann::json root;
     try {
-        root = nlohmann::json::parse(requestStr);
+        root = nlohmann::json::parse(data, data + len);
     }
     catch (const nlohmann::json::parse_error& e) {
         spdlog::error("JsonRpcRouter: JSON parse failed, error={}", e.what());
-        return make_error_response(nullptr, -32700, "Parse error").dump();
+        output.append(make_error_response(nullptr, -32700, "Parse error").dump());
+        return true;
     }
 
     // 处理批量请求 (Batch Requests)
     if (root.is_array()) {
         if (root.empty()) {
-            return make_error_response(nullptr, -32600, "Invalid Request (empty batch)").dump();
+            output.append(make_error_response(nullptr, -32600, "Invalid Request (empty batch)").dump());
+            return true;
         }
 
-        nlohmann::json batchResponse = nlohmann::json::array();
-        for (const auto& req : root) {
-            nlohmann::json singleResponse = dispatch_single(req);
-            if (!singleResponse.is_null()) {
-                batchResponse.push_back(std::move(singleResponse));
+        if (parallel_batch_enabled()) {
+            // 请求与各元素的响应由在途任务共同持有，最后完成的元素拼装响应交给 done
+            struct DomBatch {
+                nlohmann::json requests;
+                std::vector<nlohmann::json> responses;
+            };
+            auto batch = std::make_shared<DomBatch>();
+            batch->responses.resize(root.size());
+            std::vector<BatchTask> tasks;
+            tasks.reserve(root.size());
+            for (size_t i = 0; i < root.size(); ++i) {
+                if (is_fire_and_forget(root[i])) {
+                    tasks.push_back(BatchTask{ [this, req = std::move(root[i])]() { dispatch_single(req); }, false });
+                } else {
+                    tasks.push_back(BatchTask{ [this, batch, i]() { batch->responses[i] = dispatch_single(batch->requests[i]); }, true });
+                }
+            }
+            batch->requests = std::move(root);
+            if (run_batch_tasks(std::move(tasks), [batch, done]() { done(join_dom_responses(batch->responses)); })) {
+                return false;
             }
+            return true; // 全部为 Notification，无需任何响应
         }
 
-        if (batchResponse.empty()) {
-            return ""; // 若全部为 Notification，则无需任何响应
+        std::vector<nlohmann::json> responses(root.size());
+        for (size_t i = 0; i < root.size(); ++i) {
+            responses[i] = dispatch_single(root[i]);
         }
-        return batchResponse.dump();
+        output.append(join_dom_responses(responses)); // 若全部为 Notification，则无需任何响应
+        return true;
     }
 
     // 处理单次请求
+    if (parallel_batch_enabled() && is_fire_and_forget(root)) {
+        submit_notification([this, req = std::move(root)]() { dispatch_single(req); });
+        return true;
+    }
     nlohmann::json singleResponse = dispatch_single(root);
-    if (singleResponse.is_null()) {
-        return ""; // 单次 Notification 请求无需回复
+    if (!singleResponse.is_null()) {
+        output.append(singleResponse.dump()); // 单次 Notification 请求无需回复
     }
-    return singleResponse.dump();
+    return true;
 }
 
 nlohmann::json JsonRpcRouter::dispatch_single(const nlohmann::json& req) {
@@ -110,26 +614,22 @@ nlohmann::json JsonRpcRouter::dispatch_single(const nlohmann::json& req) {
 
     // 3. 执行具体业务逻辑
     nlohmann::json result;
-    try {
-        result = it->second(params);
-    }
-    catch (const nlohmann::json::exception& e) {
-        // 通常是 params 参数读取类型不匹配异常，归为 Invalid params 错误
-        spdlog::error("JsonRpcRouter: Invalid params exception for method={}, error={}", methodName, e.what());
-        return make_error_response(id, -32602, "Invalid params: " + std::string(e.what()));
-    }
-    catch (const std::invalid_argument& e) {
-        spdlog::error("JsonRpcRouter: Invalid argument for method={}, error={}", methodName, e.what());
-        return make_error_response(id, -32602, "Invalid params: " + std::string(e.what()));
-    }
-    catch (const std::exception& e) {
-        // 服务端内部异常，归为 Internal error
-        spdlog::error("JsonRpcRouter: Internal error for method={}, error={}", methodName, e.what());
-        return make_error_response(id, -32603, "Internal error: " + std::string(e.what()));
-    }
-    catch (...) {
-        spdlog::error("JsonRpcRouter: Unknown internal exception for method={}", methodName);
-        return make_error_response(id, -32603, "Internal error: Unknown exception");
+    int errorCode = 0;
+    std::string errorMessage;
+    const MethodEntry& entry = it->second;
+    const bool ok = run_handler(methodName, [&]() {
+        if (entry.handler) {
+            result = entry.handler(params);
+            return;
+        }
+        // 原始文本处理器在 DOM 后端下需要一次序列化与反序列化
+        const std::string paramsText = params.dump();
+        std::string resultText;
+        entry.rawHandler(paramsText.data(), paramsText.size(), resultText);
+        result = nlohmann::json::parse(resultText);
+        }, errorCode, errorMessage);
+    if (!ok) {
+        return make_error_response(id, errorCode, errorMessage);
     }
 
     // 4. Notification 不需要生成任何返回包
@@ -157,3 +657,260 @@ nlohmann::json JsonRpcRouter::make_error_response(const nlohmann::json& id, int
     resp["id"] = id.is_null() ? nullptr : id;
     return resp;
 }
+
+#if TUDOU_HAS_SIMDJSON
+
+bool JsonRpcRouter::dispatch_on_demand(const char* data, size_t len, std::string& output, const ResponseCallback& done) {
+    if (len == 0) {
+        write_error_response(output, nullptr, 0, -32600, "Invalid Request (empty body)");
+        return true;
+    }
+
+    thread_local OnDemandScratch threadScratch;
+    thread_local int depth = 0;
+    std::unique_ptr<OnDemandScratch> nestedScratch;
+    OnDemandScratch* scratch = &threadScratch;
+    if (depth > 0) {
+        // 处理器内部再次 dispatch：外层的 spans 仍指向线程缓冲，不能复用
+        nestedScratch.reset(new OnDemandScratch());
+        scratch = nestedScratch.get();
+    }
+    struct DepthGuard {
+        int& depth;
+        explicit DepthGuard(int& d) : depth(d) { ++depth; }
+        ~DepthGuard() { --depth; }
+    } depthGuard(depth);
+
+    // simdjson 需要输入尾部有 SIMDJSON_PADDING 字节可读，连接缓冲无法保证，拷贝一次到复用的填充缓冲
+    scratch->padded.assign(data, len);
+    scratch->padded.reserve(len + simdjson::SIMDJSON_PADDING);
+    const simdjson::padded_string_view input(scratch->padded.data(), len, scratch->padded.capacity());
+    std::vector<RequestSpan>& spans = scratch->spans;
+    spans.clear();
+
+    // 1. 扫描阶段：整个请求（含批量的每个元素）扫描无误后才执行任何处理器，与 DOM 后端一致
+    simdjson::ondemand::document doc;
+    simdjson::ondemand::json_type rootType;
+    bool isBatch = false;
+    simdjson::error_code error = scratch->parser.iterate(input).get(doc);
+    if (!error) {
+        error = doc.type().get(rootType);
+    }
+    if (!error) {
+        if (rootType == simdjson::ondemand::json_type::array) {
+            isBatch = true;
+            simdjson::ondemand::array array;
+            error = doc.get_array().get(array);
+            for (auto element : array) {
+                if (error) {
+                    break;
+                }
+                simdjson::ondemand::value value;
+                if ((error = std::move(element).get(value))) {
+                    break;
+                }
+                spans.emplace_back();
+                error = scan_request(value, spans.back());
+            }
+        } else if (rootType == simdjson::ondemand::json_type::object) {
+            simdjson::ondemand::value value;
+            if (!(error = doc.get_value().get(value))) {
+                spans.emplace_back();
+                error = scan_request(value, spans.back());
+            }
+        } else {
+            // 根为标量：一定是非法请求，交给 DOM 路径给出与之相同的错误
+            return dispatch_dom(data, len, output, done);
+        }
+    }
+    if (!error && !doc.at_end()) {
+        error = simdjson::TRAILING_CONTENT;
+    }
+    if (error) {
+        spdlog::error("JsonRpcRouter: JSON parse failed, error={}", simdjson::error_message(error));
+        write_error_response(output, nullptr, 0, -32700, "Parse error");
+        return true;
+    }
+    if (isBatch && spans.empty()) {
+        write_error_response(output, nullptr, 0, -32600, "Invalid Request (empty batch)");
+        return true;
+    }
+
+    // 2. 执行阶段：params 此时才物化；回包直接写入 out（顺序执行时即 output），原始文本处理器的结果也直接写入其中
+    auto execute = [this](const RequestSpan& span, std::string& out) -> bool {
+        if (!span.isObject) {
+            write_error_response(out, nullptr, 0, -32600, "Invalid Request (not an object)");
+            return true;
+        }
+        if (!span.idValid) {
+            write_error_response(out, nullptr, 0, -32600, "Invalid Request (id must be string, number or null)");
+            return true;
+        }
+        const char* id = span.hasId ? span.id : nullptr;
+        if (!span.versionValid) {
+            write_error_response(out, id, span.idLen, -32600, "Invalid Request (missing or invalid jsonrpc version)");
+            return true;
+        }
+        if (!span.methodValid) {
+            write_error_response(out, id, span.idLen, -32600, "Invalid Request (missing or invalid method name)");
+            return true;
+        }
+
+        auto it = methods_.find(span.method);
+        if (it == methods_.end()) {
+            spdlog::warn("JsonRpcRouter: Method not found, name={}", span.method);
+            write_error_response(out, id, span.idLen, -32601, "Method not found");
+            return true;
+        }
+        if (!span.paramsValid) {
+            write_error_response(out, id, span.idLen, -32602, "Invalid params (must be structured object or array)");
+            return true;
+        }
+
+        const char* params = span.params ? span.params : "null";
+        const size_t paramsLen = span.params ? span.paramsLen : 4;
+        const MethodEntry& entry = it->second;
+        const size_t mark = out.size();
+        if (span.hasId) {
+            out.append("{\"jsonrpc\":\"2.0\",\"result\":");
+        }
+        const size_t resultStart = out.size();
+
+        int errorCode = 0;
+        std::string errorMessage;
+        const bool ok = run_handler(span.method, [&]() {
+            if (entry.rawHandler) {
+                if (span.hasId) {
+                    entry.rawHandler(params, paramsLen, out);
+                } else {
+                    std::string discarded;
+                    entry.rawHandler(params, paramsLen, discarded);
+                }
+                return;
+            }
+            const nlohmann::json result = entry.handler(nlohmann::json::parse(params, params + paramsLen));
+            if (span.hasId) {
+                out.append(result.dump());
+            }
+            }, errorCode, errorMessage);
+
+        if (!ok) {
+            out.resize(mark);
+            write_error_response(out, id, span.idLen, errorCode, errorMessage);
+            return true;
+        }
+        // Notification 不需要生成任何返回包
+        if (!span.hasId) {
+            return false;
+        }
+        if (out.size() == resultStart) {
+            out.append("null");
+        }
+        out.append(",\"id\":");
+        out.append(span.id, span.idLen);
+        out.push_back('}');
+        return true;
+    };
+
+    // 合法的 Notification：执行结果不会写入任何响应
+    auto fireAndForget = [this](const RequestSpan& span) {
+        return span.isObject && !span.hasId && span.versionValid && span.methodValid && span.paramsValid
+            && methods_.find(span.method) != methods_.end();
+    };
+    // 提交给工作线程的 Notification 可能晚于本次 dispatch 执行，而 span 指向线程复用的填充缓冲，需要拷贝出方法名与 params
+    auto makeNotificationTask = [execute](const RequestSpan& span) {
+        std::string params = span.params ? std::string(span.params, span.paramsLen) : std::string("null");
+        return BatchTask{ [execute, method = span.method, params = std::move(params)]() {
+            RequestSpan owned;
+            owned.isObject = true;
+            owned.versionValid = true;
+            owned.methodValid = true;
+            owned.method = method;
+            owned.params = params.data();
+            owned.paramsLen = params.size();
+            std::string discarded;
+            execute(owned, discarded);
+            }, false };
+    };
+
+    if (!isBatch) {
+        if (parallel_batch_enabled() && fireAndForget(spans.front())) {
+            submit_notification(makeNotificationTask(spans.front()).work);
+            return true;
+        }
+        execute(spans.front(), output);
+        return true;
+    }
+
+    if (parallel_batch_enabled()) {
+        // 请求文本与各元素独立的输出缓冲由在途任务共同持有：填充缓冲转交给 Batch，spans 中的文本区间随之重定位
+        struct OnDemandBatch {
+            std::string input;
+            std::vector<RequestSpan> spans;
+            std::vector<std::string> entryOutputs;
+            std::unique_ptr<bool[]> wrote;
+        };
+        auto batch = std::make_shared<OnDemandBatch>();
+        const char* oldBase = scratch->padded.data();
+        batch->input = std::move(scratch->padded);
+        batch->spans = std::move(spans);
+        const char* newBase = batch->input.data();
+        for (RequestSpan& span : batch->spans) {
+            if (span.id) {
+                span.id = newBase + (span.id - oldBase);
+            }
+            if (span.params) {
+                span.params = newBase + (span.params - oldBase);
+            }
+        }
+        batch->entryOutputs.resize(batch->spans.size());
+        batch->wrote.reset(new bool[batch->spans.size()]());
+
+        std::vector<BatchTask> tasks;
+        tasks.reserve(batch->spans.size());
+        for (size_t i = 0; i < batch->spans.size(); ++i) {
+            if (fireAndForget(batch->spans[i])) {
+                tasks.push_back(makeNotificationTask(batch->spans[i]));
+            } else {
+                tasks.push_back(BatchTask{ [execute, batch, i]() {
+                    batch->wrote[i] = execute(batch->spans[i], batch->entryOutputs[i]);
+                    }, true });
+            }
+        }
+        return !run_batch_tasks(std::move(tasks), [batch, done]() {
+            std::string response;
+            append_batch_outputs(response, batch->entryOutputs, batch->wrote.get());
+            done(std::move(response));
+        });
+    }
+
+    const size_t batchStart = output.size();
+    output.push_back('[');
+    bool wroteAny = false;
+    for (const RequestSpan& span : spans) {
+        const size_t entryStart = output.size();
+        if (wroteAny) {
+            output.push_back(',');
+        }
+        if (execute(span, output)) {
+            wroteAny = true;
+        } else {
+            output.resize(entryStart);
+        }
+    }
+    if (!wroteAny) {
+        output.resize(batchStart); // 若全部为 Notification，则无需任何响应
+        return true;
+    }
+    output.push_back(']');
+    return true;
+}
+
+#else
+
+bool JsonRpcRouter::dispatch_on_demand(const char* data, size_t len, std::string& output, const ResponseCallback& done) {
+    // 未编入 simdjson 时 set_backend 不会切到 OnDemand，这里仅作兜底
+    return dispatch_dom(data, len, output, done);
+}
+
+#endif
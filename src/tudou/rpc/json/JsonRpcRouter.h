@@ -7,14 +7,36 @@
 
 #pragma once
 
+#include <cstddef>
+#include <memory>
 #include <string>
 #include <unordered_map>
 #include <functional>
+#include <vector>
 #include <nlohmann/json.hpp>
 
+/**
+ * @brief JSON-RPC 2.0 请求路由器。
+ *        解析后端可切换：默认的 Nlohmann 后端把整个请求解析成 DOM 再 dump 回包；OnDemand 后端（构建时找到 simdjson 才可用）
+ *        用 simdjson On-Demand 只扫描请求信封，params 以原始文本区间保留，交给处理器时才物化，回包直接写入输出缓冲。
+ *        两种后端对合法 JSON 的错误码与响应语义一致；OnDemand 后端只对 params 做结构检查，其内容非法时报 Invalid params。dispatch 可在多个 IO 线程并发调用，注册方法、切换后端与开启批量并行须在启动前完成。
+ */
 class JsonRpcRouter {
 public:
     using RpcHandler = std::function<nlohmann::json(const nlohmann::json& params)>;
+    // 原始文本处理器：params 为请求中 params 字段的原始 JSON 文本（缺省时为 "null"），结果 JSON 文本追加写入 result。
+    // 抛出异常时与 RpcHandler 一样映射为错误响应，已追加的内容会被丢弃。
+    using RawRpcHandler = std::function<void(const char* params, size_t len, std::string& result)>;
+    // 异步完成回调：参数为完整的响应文本，无需响应时为空串。在完成最后一个 Batch 元素的工作线程上调用
+    using ResponseCallback = std::function<void(std::string&& response)>;
+
+    // 线程池中排队与执行中的 Notification 总数默认上限
+    static constexpr size_t kDefaultMaxPendingNotifications = 1024;
+
+    enum class Backend {
+        Nlohmann,   // nlohmann::json DOM 解析（默认）
+        OnDemand,   // simdjson On-Demand 按需解析 + 流式写回包
+    };
 
     JsonRpcRouter();
     ~JsonRpcRouter();
@@ -30,6 +52,33 @@ public:
      */
     void register_method(const std::string& name, RpcHandler handler);
 
+    /**
+     * @brief 注册直接读写 JSON 文本的处理器，OnDemand 后端下全程不构建 DOM。
+     */
+    void register_raw_method(const std::string& name, RawRpcHandler handler);
+
+    /**
+     * @brief 切换解析后端。
+     * @return 后端未编入当前构建时返回 false，保持原后端不变。
+     */
+    bool set_backend(Backend backend);
+    Backend get_backend() const { return backend_; }
+    static bool is_backend_available(Backend backend);
+
+    /**
+     * @brief 开启批量请求的并行执行。
+     *        Batch 中的各个元素分发到 numThreads 个工作线程执行，同一个 Batch 同时在途的元素不超过 maxConcurrency（0 表示与线程数相同），
+     *        每完成一个元素再提交下一个，最后完成的元素按请求顺序拼装响应。带完成回调的 dispatch 不阻塞调用线程，其余重载在调用线程上等待。
+     *        合法的 Notification（单条或 Batch 内）直接投入工作线程、不占并发名额，dispatch 不等待其完成，处理器异常只记录日志；
+     *        线程池中的 Notification 达到 maxPendingNotifications 后，新的 Notification 改在调用线程上就地执行，由此把积压反压回调用方。
+     *        开启后处理器会在工作线程上并发执行，必须线程安全。
+     * @param numThreads 工作线程数，必须大于 0
+     * @param maxConcurrency 单个 Batch 的并发上限
+     * @param maxPendingNotifications 全部 dispatch 共享的 Notification 排队上限（含执行中的）
+     */
+    void enable_parallel_batch(int numThreads, size_t maxConcurrency = 0,
+                               size_t maxPendingNotifications = kDefaultMaxPendingNotifications);
+
     /**
      * @brief 解析并分发处理网络传来的 JSON 请求文本。
      * @param requestStr 请求文本字节流（支持单请求、Notification 以及 Batch 批量请求）。
@@ -37,9 +86,53 @@ public:
      */
     std::string dispatch(const std::string& requestStr);
 
+    /**
+     * @brief 同 dispatch(requestStr)，直接解析调用方缓冲区内的一段请求文本，免去拷贝成 std::string。
+     * @param data 请求文本起始地址
+     * @param len 请求文本字节数
+     */
+    std::string dispatch(const char* data, size_t len);
+
+    /**
+     * @brief 同 dispatch(data, len)，响应直接追加到 output 尾部（如连接的待发送缓冲）；无需响应时 output 不变。
+     */
+    void dispatch(const char* data, size_t len, std::string& output);
+
+    /**
+     * @brief 不阻塞调用线程的 dispatch，供 IO 线程使用。
+     * @return 响应已同步生成并追加到 output（或无需响应）时返回 true，done 不会被调用；
+     *         并行 Batch 已提交时立即返回 false，output 不变，全部元素完成后以拼装好的响应调用 done。done 为空时等同同步重载
+     */
+    bool dispatch(const char* data, size_t len, std::string& output, ResponseCallback done);
+
 private:
+    struct MethodEntry {
+        RpcHandler handler;         // DOM 处理器，与 rawHandler 二选一
+        RawRpcHandler rawHandler;   // 原始文本处理器
+    };
+
+    // 批量并行执行的一个单元：awaited 为 false 的（Notification）提交后不等待
+    struct BatchTask {
+        std::function<void()> work;
+        bool awaited;
+    };
+
+    class BatchWorkerPool;
+    struct BatchState;
+
+    bool dispatch_dom(const char* data, size_t len, std::string& output, const ResponseCallback& done);
     nlohmann::json dispatch_single(const nlohmann::json& req);
     nlohmann::json make_error_response(const nlohmann::json& id, int code, const std::string& message);
+    bool dispatch_on_demand(const char* data, size_t len, std::string& output, const ResponseCallback& done);
+    bool is_fire_and_forget(const nlohmann::json& req) const;
+    bool parallel_batch_enabled() const;
+    bool run_batch_tasks(std::vector<BatchTask> tasks, std::function<void()> onComplete);
+    void submit_batch_task(const std::shared_ptr<BatchState>& state, size_t index);
+    void submit_notification(std::function<void()> work);
 
-    std::unordered_map<std::string, RpcHandler> methods_;
+    std::unordered_map<std::string, MethodEntry> methods_;
+    Backend backend_;
+    size_t batchConcurrency_;                   // 单个 Batch 同时在途的元素上限
+    size_t maxPendingNotifications_;            // 线程池中排队与执行中的 Notification 上限
+    std::unique_ptr<BatchWorkerPool> batchPool_; // 批量并行的工作线程，未开启时为空；最后声明，析构时最先执行完剩余任务并 join
 };
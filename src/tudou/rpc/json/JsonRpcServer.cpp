@@ -6,10 +6,35 @@
  */
 
 #include "JsonRpcServer.h"
+#include "tudou/reactor/EventLoop.h"
+
+#include <cstring>
+#include <strings.h>
 #include <spdlog/spdlog.h>
 
+namespace {
+
+// 按请求的分帧方式封装一条回包：换行帧追加 '\n'，Content-Length 帧加上头部；空回包（Notification）不输出
+void append_framed(std::string& output, const std::string& response, bool headerFramed) {
+    if (response.empty()) {
+        return;
+    }
+    if (headerFramed) {
+        output.append("Content-Length: ");
+        output.append(std::to_string(response.size()));
+        output.append("\r\n\r\n");
+        output.append(response);
+        return;
+    }
+    output.append(response);
+    output.push_back('\n');
+}
+
+} // namespace
+
 JsonRpcServer::JsonRpcServer(const std::string& ip, uint16_t port, int numThreads)
-    : tcpServer_(new TcpServer(ip, port, numThreads > 0 ? numThreads - 1 : 0)) {
+    : tcpServer_(new TcpServer(ip, port, numThreads > 0 ? numThreads - 1 : 0)),
+      parallelBatch_(false) {
 
     tcpServer_->set_connection_callback([this](const TcpConnectionPtr& conn) {
         on_connection(conn);
@@ -38,51 +63,272 @@ void JsonRpcServer::register_method(const std::string& name, JsonRpcRouter::RpcH
     router_.register_method(name, std::move(handler));
 }
 
+void JsonRpcServer::register_raw_method(const std::string& name, JsonRpcRouter::RawRpcHandler handler) {
+    router_.register_raw_method(name, std::move(handler));
+}
+
+bool JsonRpcServer::set_json_backend(JsonRpcRouter::Backend backend) {
+    return router_.set_backend(backend);
+}
+
+void JsonRpcServer::enable_parallel_batch(int numThreads, size_t maxConcurrency, size_t maxPendingNotifications) {
+    router_.enable_parallel_batch(numThreads, maxConcurrency, maxPendingNotifications);
+    parallelBatch_ = true;
+}
+
 void JsonRpcServer::on_connection(const TcpConnectionPtr& conn) {
     spdlog::info("JsonRpcServer: Client connected, fd={}, peer={}", conn->get_fd(), conn->get_peer_addr().get_ip_port());
 }
 
 void JsonRpcServer::on_message(const TcpConnectionPtr& conn) {
-    std::string data = conn->receive();
-    if (data.empty()) {
-        return;
-    }
+    process_frames(conn, find_connection_state(conn));
+}
 
-    // 获取该连接对应的应用层缓冲区，并将新数据追加在尾部
-    std::string& connBuf = connectionBuffers_[conn.get()];
-    connBuf.append(data);
+void JsonRpcServer::process_frames(const TcpConnectionPtr& conn, const std::shared_ptr<ConnectionState>& state) {
+    Buffer* buf = conn->get_read_buffer();
 
-    while (true) {
-        // 查找换行符 \n 作为分包边界
-        size_t pos = connBuf.find('\n');
-        if (pos == std::string::npos) {
-            // 没有换行符，说明是半包数据，跳出循环等待下一次可读事件接收后续数据
+    // 同一次可读事件里拆出的全部回包合并成一次 send，流水线批量请求不再逐条写 socket
+    std::string output;
+    bool blocked = false;
+    while (buf->readable_bytes() > 0) {
+        // 等待前面并行 Batch 的回包过多：剩余消息留在读缓冲，暂停读取直到 Batch 完成
+        if (state->pending.size() >= kMaxQueuedResponses) {
+            blocked = true;
             break;
         }
 
-        // 提取出一行完整的请求文本
-        std::string requestStr = connBuf.substr(0, pos);
-        
-        // 擦除缓冲区中已被解析处理的数据和换行符本身
-        connBuf.erase(0, pos + 1);
+        // JSON 文本总以 '{'、'[' 或空白开头，首字节是字母即为 Content-Length 头
+        const char first = *buf->readable_start_ptr();
+        const bool headerFramed = state->bodyOffset > 0 || first == 'C' || first == 'c';
+        const FrameResult result = headerFramed
+            ? process_content_length_frame(conn, state, output)
+            : process_line_frame(conn, state, output);
 
-        // 过滤空行请求
-        if (requestStr.empty()) {
-            continue;
+        if (result == FrameResult::NeedMore) {
+            break;
         }
-
-        // 调度核心业务处理
-        std::string responseStr = router_.dispatch(requestStr);
-
-        // 如果不是 Notification，将响应追加换行符发回对端
-        if (!responseStr.empty()) {
-            conn->send(responseStr + "\n");
+        if (result == FrameResult::Malformed) {
+            spdlog::warn("JsonRpcServer: Malformed or oversized frame, closing connection, fd={}", conn->get_fd());
+            buf->advance_read_index(buf->readable_bytes());
+            conn->force_close();
+            return;
         }
     }
+
+    if (!output.empty()) {
+        conn->send(std::move(output));
+    }
+    if (blocked && !state->readingPaused) {
+        state->readingPaused = true;
+        conn->stop_reading();
+    }
 }
 
 void JsonRpcServer::on_close(const TcpConnectionPtr& conn) {
     spdlog::info("JsonRpcServer: Client disconnected, fd={}", conn->get_fd());
-    // 清理该连接对应的应用层缓冲区，防止内存泄露
-    connectionBuffers_.erase(conn.get());
+    // 清理该连接对应的拆包进度，防止内存泄露；仍在执行的 Batch 持有 state，标记关闭后它们完成时不再回包
+    std::lock_guard<std::mutex> lock(statesMutex_);
+    auto it = connectionStates_.find(conn.get());
+    if (it != connectionStates_.end()) {
+        it->second->closed = true;
+        connectionStates_.erase(it);
+    }
+}
+
+std::shared_ptr<JsonRpcServer::ConnectionState> JsonRpcServer::find_connection_state(const TcpConnectionPtr& conn) {
+    std::lock_guard<std::mutex> lock(statesMutex_);
+    std::shared_ptr<ConnectionState>& state = connectionStates_[conn.get()];
+    if (!state) {
+        state = std::make_shared<ConnectionState>();
+    }
+    return state;
+}
+
+JsonRpcServer::FrameResult JsonRpcServer::process_line_frame(const TcpConnectionPtr& conn, const std::shared_ptr<ConnectionState>& state, std::string& output) {
+    Buffer* buf = conn->get_read_buffer();
+    const char* data = buf->readable_start_ptr();
+    const size_t size = buf->readable_bytes();
+
+    // 只扫描上次之后新到达的字节；memchr 由 libc 以向量指令实现
+    const void* found = ::memchr(data + state->scanOffset, '\n', size - state->scanOffset);
+    if (!found) {
+        state->scanOffset = size;
+        return size > kMaxFrameBytes ? FrameResult::Malformed : FrameResult::NeedMore;
+    }
+
+    const size_t lineLength = static_cast<const char*>(found) - data;
+    state->scanOffset = 0;
+
+    // 过滤空行请求（兼容 CRLF 行尾）
+    size_t requestLength = lineLength;
+    if (requestLength > 0 && data[requestLength - 1] == '\r') {
+        --requestLength;
+    }
+    if (requestLength > 0) {
+        // 直接解析读缓冲内的这一行，派发返回之前不消费，避免 Buffer 搬移数据后指针失效
+        dispatch_message(conn, state, data, requestLength, false, output);
+    }
+
+    buf->advance_read_index(lineLength + 1);
+    return FrameResult::Consumed;
+}
+
+JsonRpcServer::FrameResult JsonRpcServer::process_content_length_frame(const TcpConnectionPtr& conn, const std::shared_ptr<ConnectionState>& state, std::string& output) {
+    static const char kHeaderEnd[] = "\r\n\r\n";
+    static const size_t kHeaderEndLength = sizeof(kHeaderEnd) - 1;
+    static const char kContentLength[] = "content-length:";
+    static const size_t kContentLengthLength = sizeof(kContentLength) - 1;
+
+    Buffer* buf = conn->get_read_buffer();
+    const char* data = buf->readable_start_ptr();
+    const size_t size = buf->readable_bytes();
+
+    if (state->bodyOffset == 0) {
+        // 头部结束标记可能跨两次可读事件，回退 3 字节重新比较
+        const size_t from = state->scanOffset > kHeaderEndLength - 1 ? state->scanOffset - (kHeaderEndLength - 1) : 0;
+        const void* found = ::memmem(data + from, size - from, kHeaderEnd, kHeaderEndLength);
+        if (!found) {
+            state->scanOffset = size;
+            return size > kMaxHeaderBytes ? FrameResult::Malformed : FrameResult::NeedMore;
+        }
+
+        const size_t headerLength = static_cast<const char*>(found) - data;
+        if (headerLength > kMaxHeaderBytes) {
+            return FrameResult::Malformed;
+        }
+
+        // 逐行解析头部，只认 Content-Length（大小写不敏感），其余头（如 Content-Type）忽略
+        bool hasLength = false;
+        size_t bodyLength = 0;
+        size_t lineStart = 0;
+        while (lineStart < headerLength) {
+            const void* lineEnd = ::memmem(data + lineStart, headerLength - lineStart, "\r\n", 2);
+            const size_t lineLength = lineEnd ? static_cast<const char*>(lineEnd) - (data + lineStart) : headerLength - lineStart;
+            const char* line = data + lineStart;
+            if (lineLength > kContentLengthLength && ::strncasecmp(line, kContentLength, kContentLengthLength) == 0) {
+                size_t pos = kContentLengthLength;
+                while (pos < lineLength && (line[pos] == ' ' || line[pos] == '\t')) {
+                    ++pos;
+                }
+                if (pos == lineLength) {
+                    return FrameResult::Malformed;
+                }
+                bodyLength = 0;
+                for (; pos < lineLength; ++pos) {
+                    if (line[pos] < '0' || line[pos] > '9' || bodyLength > kMaxFrameBytes) {
+                        return FrameResult::Malformed;
+                    }
+                    bodyLength = bodyLength * 10 + static_cast<size_t>(line[pos] - '0');
+                }
+                hasLength = true;
+            }
+            lineStart += lineLength + 2;
+        }
+        if (!hasLength || bodyLength > kMaxFrameBytes) {
+            return FrameResult::Malformed;
+        }
+
+        state->bodyOffset = headerLength + kHeaderEndLength;
+        state->bodyLength = bodyLength;
+        state->scanOffset = 0;
+    }
+
+    // 头部已解析，正文未收全时只比较长度，不再扫描
+    if (size < state->bodyOffset + state->bodyLength) {
+        return FrameResult::NeedMore;
+    }
+
+    if (state->bodyLength > 0) {
+        dispatch_message(conn, state, data + state->bodyOffset, state->bodyLength, true, output);
+    }
+
+    buf->advance_read_index(state->bodyOffset + state->bodyLength);
+    state->bodyOffset = 0;
+    state->bodyLength = 0;
+    return FrameResult::Consumed;
+}
+
+void JsonRpcServer::dispatch_message(const TcpConnectionPtr& conn,
+                                     const std::shared_ptr<ConnectionState>& state,
+                                     const char* data,
+                                     size_t len,
+                                     bool headerFramed,
+                                     std::string& output) {
+    // 前面还有未完成的并行 Batch 时，本条回包排到队尾，保证回包顺序与请求顺序一致
+    const uint64_t sequence = state->nextSequence;
+    PendingResponse* slot = nullptr;
+    if (!state->pending.empty()) {
+        state->pending.emplace_back();
+        ++state->nextSequence;
+        slot = &state->pending.back();
+    }
+    std::string& target = slot ? slot->data : output;
+
+    // 并行 Batch 由完成最后一个元素的工作线程回调，投递回连接所属 IO 线程后再按序发出；未开启并行时不构造回调
+    JsonRpcRouter::ResponseCallback done;
+    if (parallelBatch_) {
+        done = [this, conn, state, sequence, headerFramed](std::string&& response) {
+            conn->get_loop()->queue_in_loop([this, conn, state, sequence, headerFramed, response = std::move(response)]() {
+                complete_response(conn, state, sequence, headerFramed, response);
+            });
+        };
+    }
+
+    bool completed = false;
+    if (headerFramed) {
+        std::string response;
+        completed = router_.dispatch(data, len, response, done);
+        append_framed(target, response, true);
+    } else {
+        // 换行帧的响应直接写入待发送的缓冲，如果不是 Notification，追加换行符
+        const size_t targetSize = target.size();
+        completed = router_.dispatch(data, len, target, done);
+        if (target.size() != targetSize) {
+            target.push_back('\n');
+        }
+    }
+
+    if (completed) {
+        if (slot) {
+            slot->ready = true;
+        }
+        return;
+    }
+    if (!slot) {
+        state->pending.emplace_back();
+        ++state->nextSequence;
+    }
+}
+
+void JsonRpcServer::complete_response(const TcpConnectionPtr& conn,
+                                      const std::shared_ptr<ConnectionState>& state,
+                                      uint64_t sequence,
+                                      bool headerFramed,
+                                      const std::string& response) {
+    if (state->closed) {
+        return;
+    }
+
+    PendingResponse& slot = state->pending[sequence - (state->nextSequence - state->pending.size())];
+    append_framed(slot.data, response, headerFramed);
+    slot.ready = true;
+
+    // 发出队首连续已完成的回包，后面仍在执行的 Batch 继续占位
+    std::string output;
+    while (!state->pending.empty() && state->pending.front().ready) {
+        output.append(state->pending.front().data);
+        state->pending.pop_front();
+    }
+    if (!output.empty()) {
+        conn->send(std::move(output));
+    }
+
+    if (!state->readingPaused || state->pending.size() >= kMaxQueuedResponses) {
+        return;
+    }
+    state->readingPaused = false;
+    conn->start_reading();
+
+    // 暂停期间读缓冲中可能已积压完整消息，立即继续派发
+    process_frames(conn, state);
 }
@@ -7,12 +7,22 @@
 
 #pragma once
 
+#include <deque>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <unordered_map>
 #include "tudou/tcp/TcpServer.h"
 #include "tudou/rpc/json/JsonRpcRouter.h"
 
+/**
+ * @brief JSON-RPC 2.0 服务端。
+ *        支持两种分帧方式，按每条消息的首字节自动识别，回包沿用请求的分帧方式：
+ *        1. 换行分隔：每行一个请求（单请求、Notification 或 Batch），JSON 文本内不得包含裸换行；
+ *        2. Content-Length 头：`Content-Length: N\r\n\r\n` 后跟 N 字节 JSON，正文可以包含换行（与 LSP 的分帧一致）。
+ *        请求直接在连接读缓冲上原地拆包，半包时记住已扫描的位置，下次可读事件只扫描新到达的数据。
+ *        并行 Batch 不占用 IO 线程：全部元素完成后回包投递回连接所属 IO 线程，与同一连接上的其它回包按请求顺序发出。
+ */
 class JsonRpcServer {
 public:
     JsonRpcServer(const std::string& ip, uint16_t port, int numThreads = 0);
@@ -47,14 +57,80 @@ public:
      */
     void register_method(const std::string& name, JsonRpcRouter::RpcHandler handler);
 
+    /**
+     * @brief 注册直接读写 JSON 文本的处理器，见 JsonRpcRouter::register_raw_method
+     */
+    void register_raw_method(const std::string& name, JsonRpcRouter::RawRpcHandler handler);
+
+    /**
+     * @brief 切换请求解析后端，需在 start 前调用
+     * @return 后端未编入当前构建时返回 false
+     */
+    bool set_json_backend(JsonRpcRouter::Backend backend);
+
+    /**
+     * @brief 开启批量请求的并行执行，需在 start 前调用，见 JsonRpcRouter::enable_parallel_batch。
+     *        IO 线程提交 Batch 后继续处理其它消息，Batch 的耗时由各元素之和降为约 ceil(N / maxConcurrency) 轮。
+     */
+    void enable_parallel_batch(int numThreads, size_t maxConcurrency = 0,
+                               size_t maxPendingNotifications = JsonRpcRouter::kDefaultMaxPendingNotifications);
+
+    // 单条消息（换行帧的一行，或 Content-Length 帧的头部加正文）允许的最大字节数，超出即关闭连接
+    static constexpr size_t kMaxFrameBytes = 64 * 1024 * 1024;
+    // Content-Length 帧头部允许的最大字节数
+    static constexpr size_t kMaxHeaderBytes = 8 * 1024;
+    // 单连接上排队等待前面并行 Batch 完成的回包上限，达到后暂停读取
+    static constexpr size_t kMaxQueuedResponses = 64;
+
 private:
+    // 排队中的一条回包，已按请求的分帧方式封装；Notification 的回包为空
+    struct PendingResponse {
+        bool ready = false;
+        std::string data;
+    };
+
+    // 连接级拆包进度与回包队列，只在连接所属 IO 线程读写
+    struct ConnectionState {
+        size_t scanOffset = 0;   // 读缓冲开头这么多字节已确认不含分隔符，下次从这里继续查找
+        size_t bodyOffset = 0;   // Content-Length 帧头部已解析时，正文相对读缓冲开头的偏移；0 表示尚未解析
+        size_t bodyLength = 0;   // Content-Length 帧的正文长度
+        std::deque<PendingResponse> pending; // 队首为未完成的并行 Batch 时，其后的回包按请求顺序在此等待
+        uint64_t nextSequence = 0;  // 下一条入队回包的序号，队首序号为 nextSequence - pending.size()
+        bool readingPaused = false; // 是否因排队回包达到上限而暂停读取
+        bool closed = false;        // 连接是否已关闭，之后完成的 Batch 不再回包
+    };
+
+    enum class FrameResult {
+        Consumed,   // 处理完一条消息并已从读缓冲消费
+        NeedMore,   // 半包，等待后续数据
+        Malformed,  // 分帧错误或超出上限，需关闭连接
+    };
+
     void on_connection(const TcpConnectionPtr& conn);
     void on_message(const TcpConnectionPtr& conn);
     void on_close(const TcpConnectionPtr& conn);
 
+    std::shared_ptr<ConnectionState> find_connection_state(const TcpConnectionPtr& conn);
+    void process_frames(const TcpConnectionPtr& conn, const std::shared_ptr<ConnectionState>& state);
+    FrameResult process_line_frame(const TcpConnectionPtr& conn, const std::shared_ptr<ConnectionState>& state, std::string& output);
+    FrameResult process_content_length_frame(const TcpConnectionPtr& conn, const std::shared_ptr<ConnectionState>& state, std::string& output);
+    void dispatch_message(const TcpConnectionPtr& conn,
+                          const std::shared_ptr<ConnectionState>& state,
+                          const char* data,
+                          size_t len,
+                          bool headerFramed,
+                          std::string& output);
+    void complete_response(const TcpConnectionPtr& conn,
+                           const std::shared_ptr<ConnectionState>& state,
+                           uint64_t sequence,
+                           bool headerFramed,
+                           const std::string& response);
+
     std::unique_ptr<TcpServer> tcpServer_;
     JsonRpcRouter router_;
+    bool parallelBatch_;    // 是否开启了批量并行，决定派发时是否需要完成回调
 
-    // 每个连接的应用层接收缓冲区，用于解决 TCP 粘包和半包
-    std::unordered_map<TcpConnection*, std::string> connectionBuffers_;
+    // 每个连接的拆包进度。连接回调分布在各 IO 线程，表本身需要加锁
+    std::mutex statesMutex_;
+    std::unordered_map<TcpConnection*, std::shared_ptr<ConnectionState>> connectionStates_;
 };
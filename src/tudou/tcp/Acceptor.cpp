@@ -8,6 +8,7 @@
 #include <cassert>
 #include <cerrno>
 #include <fcntl.h>
+#include <unistd.h>
 
 #include "spdlog/spdlog.h"
 #include "tudou/reactor/Channel.h"
@@ -15,10 +16,14 @@
 
 Acceptor::Acceptor(EventLoop* loop, const InetAddress& listenAddr) :
     loop_(loop),
-    listenSocket_(Socket::create_tcp_listener(listenAddr)),
+    listenSocket_(Socket::create_listener(listenAddr)),
     channel_(nullptr),
     newConnectCallback_(nullptr) {
 
+    if (listenAddr.is_unix() && listenAddr.get_unix_path()[0] != '@') {
+        unixPath_ = listenAddr.get_unix_path();
+    }
+
     // 监听 socket 就绪后再挂接 Channel，保证回调只面对可用的 listen fd
     channel_ = std::make_unique<Channel>(loop_, listenSocket_.fd());
     channel_->set_read_callback([this](Channel& ch) {
@@ -31,6 +36,9 @@ Acceptor::Acceptor(EventLoop* loop, const InetAddress& listenAddr) :
 }
 
 Acceptor::~Acceptor() {
+    if (!unixPath_.empty()) {
+        ::unlink(unixPath_.c_str());
+    }
 }
 
 void Acceptor::set_connect_callback(NewConnectCallback cb) {
@@ -43,8 +51,9 @@ int Acceptor::get_listen_fd() const {
 
 void Acceptor::on_read(Channel& channel) {
     // listen fd 可读表示有新连接到来，accept 返回一个新 socket fd 和对端地址。
-    sockaddr_in clientAddr{};
-    Socket connSocket = listenSocket_.accept(&clientAddr);
+    sockaddr_storage clientAddr{};
+    socklen_t clientAddrLen = 0;
+    Socket connSocket = listenSocket_.accept(&clientAddr, &clientAddrLen);
     if (connSocket.fd() < 0) {
         // EMFILE/ENFILE：fd 耗尽，内核队列中的挂起连接无法取出，会导致 epoll 持续触发 busy-loop。
         // 通过关闭预留的 idle fd 腾出名额、重试 accept 拉走挂起连接来打破循环。
@@ -54,7 +63,7 @@ void Acceptor::on_read(Channel& channel) {
         return;
     }
 
-    InetAddress peerAddr(clientAddr);
+    InetAddress peerAddr(reinterpret_cast<const sockaddr*>(&clientAddr), clientAddrLen);
     spdlog::debug("Acceptor: connFd {} accepted from {}", connSocket.fd(), peerAddr.get_ip_port());
     handle_connect_callback(std::move(connSocket), peerAddr);
 }
@@ -66,9 +75,10 @@ void Acceptor::accept_idle_connection() {
     idleFd_ = Socket(-1);
 
     // 2. 重试 accept 拉走内核队列中的挂起连接，因作用域结束自动关闭，通知客户端连接重置。
-    sockaddr_in clientAddr{};
+    sockaddr_storage clientAddr{};
+    socklen_t clientAddrLen = 0;
     {
-        Socket connSocket = listenSocket_.accept(&clientAddr);
+        Socket connSocket = listenSocket_.accept(&clientAddr, &clientAddrLen);
     }
 
     // 3. 重新打开 /dev/null 恢复占位，用于下一次 EMFILE 恢复。
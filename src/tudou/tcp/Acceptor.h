@@ -8,11 +8,11 @@
 // Acceptor.h
 // └── Acceptor
 //     ├── Acceptor(loop, listenAddr)              # [公有] 构造：创建 Socket 监听器并绑定 Channel 回调
-//     │   ├── Socket::create_tcp_listener(addr)   # [Socket] 创建 non-blocking 监听 socket 并 bind+listen
+//     │   ├── Socket::create_listener(addr)       # [Socket] 按地址族创建 non-blocking TCP（IPv4 / 双栈 IPv6）/ Unix 域监听 socket 并 bind+listen
 //     │   ├── on_read(channel)                    # [私有] 监听 socket 可读时的 accept 入口
 //     │   │   ├── Socket::accept(&peerAddr)       # [Socket] accept4 返回新 Socket
 //     │   │   └── handle_connect_callback(...)     # [私有] 触发上层 newConnectCallback_
-//     ├── ~Acceptor()                             # [公有] 析构：listenSocket_ 和 channel_ 按序销毁
+//     ├── ~Acceptor()                             # [公有] 析构：listenSocket_ 和 channel_ 按序销毁，Unix 域监听删除 socket 文件
 //     ├── set_connect_callback(cb)                # [公有] 注册 accept 成功后的上行发布回调
 //     └── get_listen_fd() const                   # [公有] 返回监听 fd
 // ============================================================================
@@ -21,6 +21,7 @@
 
 #include <functional>
 #include <memory>
+#include <string>
 
 #include "tudou/tcp/InetAddress.h"
 #include "tudou/tcp/Socket.h"
@@ -48,6 +49,7 @@ private:
 
 private:
     EventLoop* loop_;                       // Acceptor 运行所在的事件循环（线程），负责调度事件回调
+    std::string unixPath_;                  // Unix 域文件系统路径监听时记录路径，析构时删除 socket 文件
 
     Socket listenSocket_;                   // 监听 socket 的 RAII 句柄，析构时自动关闭 fd
     std::unique_ptr<Channel> channel_;      // 监听 socket 对应的事件通道（声明在后，确保析构时先反注册再关 fd）
@@ -0,0 +1,109 @@
+// ============================================================================
+// AdmissionController.cpp
+// 服务端准入控制实现，静态并发上限 + 基于排队时延的自适应收缩与快速拒绝。
+// ============================================================================
+
+#include "tudou/tcp/AdmissionController.h"
+
+#include <algorithm>
+
+#include "spdlog/spdlog.h"
+
+namespace {
+
+constexpr double kMinShrinkRatio = 0.5; // 单个周期内上限最多收缩一半，避免一次时延尖刺把上限打到底。
+constexpr int64_t kNoDelaySample = INT64_MAX;
+
+int64_t to_nanoseconds(std::chrono::steady_clock::duration duration) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count();
+}
+
+} // namespace
+
+void AdmissionController::configure(const AdmissionOptions& options) {
+    AdmissionOptions effective = options;
+    if (effective.adaptive && effective.maxConcurrency == 0) {
+        spdlog::warn("AdmissionController: adaptive mode requires maxConcurrency > 0, admission control disabled");
+        effective.adaptive = false;
+    }
+    if (effective.minConcurrency == 0 || effective.minConcurrency > effective.maxConcurrency) {
+        effective.minConcurrency = std::min<size_t>(1, effective.maxConcurrency);
+    }
+
+    const int64_t intervalNs = to_nanoseconds(effective.interval);
+    minConcurrency_.store(effective.minConcurrency, std::memory_order_relaxed);
+    targetDelayNs_.store(to_nanoseconds(effective.targetQueueDelay), std::memory_order_relaxed);
+    intervalNs_.store(intervalNs, std::memory_order_relaxed);
+    windowEndNs_.store(to_nanoseconds(std::chrono::steady_clock::now().time_since_epoch()) + intervalNs, std::memory_order_relaxed);
+    windowMinDelayNs_.store(kNoDelaySample, std::memory_order_relaxed);
+    dropping_.store(false, std::memory_order_relaxed);
+    adaptive_.store(effective.adaptive, std::memory_order_relaxed);
+    limit_.store(effective.maxConcurrency, std::memory_order_relaxed);
+    maxConcurrency_.store(effective.maxConcurrency, std::memory_order_relaxed);
+}
+
+bool AdmissionController::try_acquire(std::chrono::steady_clock::duration queueDelay, bool* acquired) {
+    if (acquired != nullptr) {
+        *acquired = false;
+    }
+    if (!is_enabled()) {
+        return true;
+    }
+
+    if (adaptive_.load(std::memory_order_relaxed) && observe_queue_delay(queueDelay)) {
+        rejected_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    size_t current = inFlight_.load(std::memory_order_relaxed);
+    do {
+        if (current >= limit_.load(std::memory_order_relaxed)) {
+            rejected_.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+    } while (!inFlight_.compare_exchange_weak(current, current + 1, std::memory_order_relaxed));
+
+    if (acquired != nullptr) {
+        *acquired = true;
+    }
+    return true;
+}
+
+void AdmissionController::release() {
+    // 只由实际占用过名额的请求调用，不再看当前是否启用：运行期关闭限流后，此前占用的名额照样归还
+    inFlight_.fetch_sub(1, std::memory_order_relaxed);
+}
+
+bool AdmissionController::observe_queue_delay(std::chrono::steady_clock::duration queueDelay) {
+    const int64_t delayNs = to_nanoseconds(queueDelay);
+    const int64_t nowNs = to_nanoseconds(std::chrono::steady_clock::now().time_since_epoch());
+
+    // 1. 更新本周期最小排队时延：多数样本不低于当前最小值，只读一次即返回，不写共享缓存行
+    int64_t currentMin = windowMinDelayNs_.load(std::memory_order_relaxed);
+    while (delayNs < currentMin
+        && !windowMinDelayNs_.compare_exchange_weak(currentMin, delayNs, std::memory_order_relaxed)) {
+    }
+
+    // 2. 周期到期：只有成功推进周期结束时间的线程结算本周期，其余线程照常按上一结论判定
+    int64_t windowEnd = windowEndNs_.load(std::memory_order_relaxed);
+    const int64_t targetNs = targetDelayNs_.load(std::memory_order_relaxed);
+    if (nowNs >= windowEnd
+        && windowEndNs_.compare_exchange_strong(windowEnd, nowNs + intervalNs_.load(std::memory_order_relaxed), std::memory_order_relaxed)) {
+        const int64_t windowMinNs = windowMinDelayNs_.exchange(kNoDelaySample, std::memory_order_relaxed);
+        const size_t limit = limit_.load(std::memory_order_relaxed);
+        if (windowMinNs != kNoDelaySample && windowMinNs > targetNs) {
+            // 整个周期都没有排空过队列：按目标与实测时延之比收缩上限
+            const double ratio = std::max(kMinShrinkRatio, static_cast<double>(targetNs) / static_cast<double>(windowMinNs));
+            limit_.store(std::max(minConcurrency_.load(std::memory_order_relaxed), static_cast<size_t>(limit * ratio)),
+                std::memory_order_relaxed);
+            dropping_.store(true, std::memory_order_relaxed);
+        }
+        else {
+            limit_.store(std::min(maxConcurrency_.load(std::memory_order_relaxed), limit + 1), std::memory_order_relaxed);
+            dropping_.store(false, std::memory_order_relaxed);
+        }
+    }
+
+    // 丢弃态下已排队超过目标的请求即使执行完成，调用方多半也已放弃等待，直接拒绝更划算
+    return dropping_.load(std::memory_order_relaxed) && delayNs > targetNs;
+}
@@ -0,0 +1,74 @@
+// ============================================================================
+// AdmissionController.h
+// 服务端准入控制，限制同时执行的请求数，并按排队时延自适应收缩上限，过载时快速拒绝而不是继续排队。
+//
+// 成员函数调用树（[公有]/[私有] 标注接口层级）：
+//
+// AdmissionController.h
+// └── AdmissionController
+//     ├── AdmissionController()                  # [公有] 构造：默认不限流
+//     ├── configure(options)                     # [公有] 设置静态上限与自适应参数，运行期也可调用
+//     ├── is_enabled() const                     # [公有] 是否配置了任何限流策略，未启用时调用方可跳过取时间
+//     ├── try_acquire(queueDelay, &acquired)     # [公有] 尝试占用一个执行名额，失败即应拒绝该请求
+//     │   └── observe_queue_delay(queueDelay)    # [私有] 记录排队时延，按周期调整上限并判定是否处于丢弃态
+//     ├── release()                              # [公有] 归还 try_acquire 实际占用的名额
+//     ├── get_limit() const                      # [公有] 当前生效的并发上限，0 表示不限
+//     ├── get_in_flight() const                  # [公有] 当前占用的名额数
+//     └── get_rejected_count() const             # [公有] 累计拒绝的请求数
+// ============================================================================
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+struct AdmissionOptions {
+    size_t maxConcurrency = 0;                                  // 服务端同时执行的请求数上限，0 表示不限；自适应模式下为上限的上界。
+    bool adaptive = false;                                      // 是否按排队时延自适应调整上限。
+    size_t minConcurrency = 1;                                  // 自适应模式下上限的下界。
+    std::chrono::microseconds targetQueueDelay{5000};           // 可接受的排队时延，一个周期内的最小排队时延超过它即视为过载。
+    std::chrono::milliseconds interval{100};                    // 自适应调整周期。
+};
+
+// AdmissionController 可被多个 IO 线程共享：名额计数与自适应统计窗口都是原子变量，热路径上不加锁。
+// 自适应策略参考 CoDel：一个周期内的最小排队时延仍高于目标，说明队列不是突发而是持续积压，
+// 此时按 目标/实测 的梯度收缩上限并进入丢弃态，直接拒绝排队已超过目标的请求；否则每个周期上限加一逐步回升。
+class AdmissionController {
+public:
+    AdmissionController() = default;
+    AdmissionController(const AdmissionController&) = delete;
+    AdmissionController& operator=(const AdmissionController&) = delete;
+
+    // 运行期可调用，各参数逐个生效；已占用的名额仍按各自的 acquired 记录归还，计数不会漂移。
+    void configure(const AdmissionOptions& options);
+    bool is_enabled() const { return maxConcurrency_.load(std::memory_order_relaxed) > 0; }
+
+    // 返回 false 表示应拒绝该请求。acquired 写入是否实际占用了名额（未启用时放行但不占用），
+    // 调用方按请求记录下来，为 true 时在请求结束后 release() 恰好一次。
+    bool try_acquire(std::chrono::steady_clock::duration queueDelay, bool* acquired = nullptr);
+    void release();
+
+    size_t get_limit() const { return limit_.load(std::memory_order_relaxed); }
+    size_t get_in_flight() const { return inFlight_.load(std::memory_order_relaxed); }
+    uint64_t get_rejected_count() const { return rejected_.load(std::memory_order_relaxed); }
+
+private:
+    bool observe_queue_delay(std::chrono::steady_clock::duration queueDelay); // 返回 true 表示该请求应被丢弃。
+
+private:
+    std::atomic<size_t> maxConcurrency_{0};                     // 并发上限的上界，0 表示未启用。
+    std::atomic<size_t> minConcurrency_{1};                     // 自适应模式下上限的下界。
+    std::atomic<bool> adaptive_{false};                         // 是否按排队时延自适应调整上限。
+    std::atomic<int64_t> targetDelayNs_{0};                     // 可接受的排队时延。
+    std::atomic<int64_t> intervalNs_{0};                        // 自适应调整周期。
+
+    std::atomic<size_t> limit_{0};                              // 当前生效的并发上限。
+    std::atomic<size_t> inFlight_{0};                           // 已占用的名额数。
+    std::atomic<uint64_t> rejected_{0};                         // 累计拒绝数。
+
+    std::atomic<int64_t> windowEndNs_{0};                       // 当前统计周期的结束时间（steady_clock 纳秒）。
+    std::atomic<int64_t> windowMinDelayNs_{INT64_MAX};          // 本周期最小排队时延。
+    std::atomic<bool> dropping_{false};                         // 上一周期判定为持续过载。
+};
@@ -73,6 +73,22 @@ void Buffer::write_to_buffer(const std::string& str) {
     write_to_buffer(str.data(), str.size());
 }
 
+void Buffer::ensure_writable_bytes(size_t len) {
+    if (writable_bytes() < len) {
+        make_space(len);
+    }
+    assert(writable_bytes() >= len);
+}
+
+char* Buffer::writable_start_ptr() {
+    return buffer_.data() + writeIndex_;
+}
+
+void Buffer::advance_write_index(size_t len) {
+    assert(len <= writable_bytes());
+    writeIndex_ += len;
+}
+
 ssize_t Buffer::read_from_fd(int fd, int* savedErrno) {
     // 使用 readv 让主缓冲与临时栈缓冲协作，减少“先扩容再读”的额外内存动作。
     char extraBuf[kStackBufSize];
@@ -102,7 +118,11 @@ ssize_t Buffer::read_from_fd(int fd, int* savedErrno) {
 ssize_t Buffer::write_to_fd(int fd, int* savedErrno) {
     const char* readablePtr = readable_start_ptr();
     const size_t readableBytes = readable_bytes();
-    const ssize_t n = ::write(fd, readablePtr, readableBytes);
+    // socket 上以 MSG_NOSIGNAL 发送，不依赖进程忽略 SIGPIPE；非 socket 的 fd 回退到 write
+    ssize_t n = ::send(fd, readablePtr, readableBytes, MSG_NOSIGNAL);
+    if (n < 0 && errno == ENOTSOCK) {
+        n = ::write(fd, readablePtr, readableBytes);
+    }
     if (n < 0) {
         *savedErrno = errno;
     }
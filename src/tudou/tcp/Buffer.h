@@ -36,9 +36,13 @@
 //     │       └── prependable_bytes() const       # [私有] 计算头部可复用空间，决定是否搬移数据
 //     ├── write_to_buffer(str)                    # [公有] 把字符串追加到缓冲区
 //     │   └── write_to_buffer(str.data(), str.size())  # [公有] 复用原始内存写入路径
+//     ├── ensure_writable_bytes(len)              # [公有] 预留至少 len 字节可写区，供调用方原地写入
+//     │   └── make_space(len)                     # [私有] 不够写时先挪动再按需扩容
+//     ├── writable_start_ptr()                    # [公有] 定位当前可写区首地址
+//     ├── advance_write_index(len)                # [公有] 原地写入完成后推进写指针，使数据变为可读
 //     ├── read_from_fd(fd, &err)                  # [公有] 通过 readv 把 fd 数据搬入缓冲区
 //     │   └── write_to_buffer(extraBuf, ...)      # [公有] 主缓冲放不下时把溢出数据继续写回 Buffer
-//     ├── write_to_fd(fd, &err)                   # [公有] 把可读区数据写入 fd 并推进读指针
+//     ├── write_to_fd(fd, &err)                   # [公有] 把可读区数据写入 fd 并推进读指针（socket 上不触发 SIGPIPE）
 //     │   └── maintain_read_index(n)              # [私有] 写成功后消费对应字节数
 //     │       └── maintain_all_index()            # [私有] 缓冲区写空时整体复位索引
 //     ├── readable_bytes() const                  # [公有] 返回当前可读字节数
@@ -66,9 +70,12 @@ public:
     void advance_read_index(size_t len);                // 仅推进读指针而不产生任何拷贝。
     void write_to_buffer(const char* data, size_t len); // 顺序追加原始字节。
     void write_to_buffer(const std::string& str);
+    void ensure_writable_bytes(size_t len);             // 预留可写空间，配合 writable_start_ptr() 原地写入。
+    char* writable_start_ptr();
+    void advance_write_index(size_t len);               // 提交原地写入的字节，不产生任何拷贝。
 
     ssize_t read_from_fd(int fd, int* savedErrno);      // 通过 readv 把 fd 数据追加到缓冲区。
-    ssize_t write_to_fd(int fd, int* savedErrno);       // 把当前可读数据刷入 fd。
+    ssize_t write_to_fd(int fd, int* savedErrno);       // 把当前可读数据刷入 fd；对端已关闭的 socket 返回 EPIPE 而不触发 SIGPIPE。
 
     size_t readable_bytes() const;
     size_t writable_bytes() const;
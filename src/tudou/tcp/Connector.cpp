@@ -0,0 +1,260 @@
+// ============================================================================
+// Connector.cpp
+// 主动连接器实现：非阻塞 connect 的结论统一在可写事件之后的投递任务里收口，Channel 不在自身回调中析构。
+// ============================================================================
+
+#include "tudou/tcp/Connector.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cerrno>
+#include <cstring>
+#include <sys/socket.h>
+
+#include "spdlog/spdlog.h"
+#include "tudou/reactor/Channel.h"
+#include "tudou/reactor/EventLoop.h"
+
+Connector::Connector(EventLoop* loop, const InetAddress& serverAddr) :
+    Connector(loop, serverAddr, Options()) {
+}
+
+Connector::Connector(EventLoop* loop, const InetAddress& serverAddr, const Options& options) :
+    loop_(loop),
+    serverAddr_(serverAddr),
+    options_(options),
+    wantConnect_(false),
+    state_(State::Disconnected),
+    socket_(-1),
+    channel_(nullptr),
+    attempts_(0),
+    retryDelaySeconds_(options.initialRetryDelaySeconds),
+    timeoutTimer_(),
+    retryTimer_(),
+    newConnectionCallback_(nullptr),
+    connectFailedCallback_(nullptr) {
+}
+
+Connector::~Connector() {
+    // 进行中的 Channel 只能在 loop 线程注销，上层须先在 loop 线程 stop()
+    assert(channel_ == nullptr);
+}
+
+void Connector::start() {
+    std::weak_ptr<Connector> weakSelf(shared_from_this());
+    loop_->run_in_loop([weakSelf]() {
+        if (auto self = weakSelf.lock()) {
+            self->start_in_loop();
+        }
+        });
+}
+
+void Connector::restart() {
+    assert(loop_->is_in_loop_thread());
+    stop_in_loop();
+    start_in_loop();
+}
+
+void Connector::stop() {
+    std::weak_ptr<Connector> weakSelf(shared_from_this());
+    loop_->run_in_loop([weakSelf]() {
+        if (auto self = weakSelf.lock()) {
+            self->stop_in_loop();
+        }
+        });
+}
+
+void Connector::start_in_loop() {
+    assert(loop_->is_in_loop_thread());
+    if (wantConnect_) {
+        return; // 已在连接或等待重试中
+    }
+
+    wantConnect_ = true;
+    attempts_ = 0;
+    retryDelaySeconds_ = options_.initialRetryDelaySeconds;
+    connect();
+}
+
+void Connector::stop_in_loop() {
+    assert(loop_->is_in_loop_thread());
+    wantConnect_ = false;
+    cancel_timers();
+    channel_.reset();
+    socket_ = Socket(-1);
+    state_ = State::Disconnected;
+}
+
+void Connector::connect() {
+    const int fd = ::socket(serverAddr_.get_family(), SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        wantConnect_ = false;
+        handle_connect_failed_callback(std::string("socket() failed: ") + strerror(errno));
+        return;
+    }
+    socket_ = Socket(fd);
+    ++attempts_;
+
+    const int ret = ::connect(socket_.fd(), serverAddr_.get_sockaddr_ptr(), serverAddr_.get_socklen());
+    const int savedErrno = (ret == 0) ? 0 : errno;
+    switch (savedErrno) {
+    case 0:
+    case EINPROGRESS:
+    case EINTR:
+    case EISCONN:
+        // 立即成功也走可写事件路径，保证成功回调总在同一个时机触发
+        connecting();
+        break;
+
+    case EAGAIN:          // 本地临时端口耗尽，或 Unix 域监听 backlog 已满
+    case EADDRINUSE:
+    case EADDRNOTAVAIL:
+    case ECONNREFUSED:
+    case ENETUNREACH:
+    case EHOSTUNREACH:
+    case ETIMEDOUT:
+    case ENOENT:          // Unix 域 socket 文件尚未创建
+        retry(strerror(savedErrno));
+        break;
+
+    default:
+        // EACCES、EAFNOSUPPORT 等：地址或权限本身有问题，重试没有意义
+        socket_ = Socket(-1);
+        wantConnect_ = false;
+        handle_connect_failed_callback(std::string("connect() failed: ") + strerror(savedErrno));
+        break;
+    }
+}
+
+void Connector::connecting() {
+    state_ = State::Connecting;
+    channel_ = std::make_unique<Channel>(loop_, socket_.fd());
+    channel_->set_write_callback([this](Channel&) { on_write(); });
+    channel_->set_error_callback([this](Channel&) { on_error(); });
+    channel_->set_close_callback([this](Channel&) { on_error(); });
+    channel_->enable_writing();
+
+    if (options_.connectTimeoutSeconds > 0) {
+        std::weak_ptr<Connector> weakSelf(shared_from_this());
+        timeoutTimer_ = loop_->run_after(options_.connectTimeoutSeconds, [weakSelf]() {
+            if (auto self = weakSelf.lock()) {
+                self->timeoutTimer_ = TimerId();
+                self->on_timeout();
+            }
+            });
+    }
+}
+
+void Connector::on_write() {
+    // 可写（或出错）即连接已有结论。这里仍处于 Channel 的事件分发中，不能析构它：
+    // 先停止关注，再投递任务收口，Channel 的注销与 Socket 的移交都在任务里完成。
+    if (state_ != State::Connecting || channel_->is_none_event()) {
+        return;
+    }
+    channel_->disable_all();
+
+    std::weak_ptr<Connector> weakSelf(shared_from_this());
+    loop_->queue_in_loop([weakSelf]() {
+        auto self = weakSelf.lock();
+        if (!self || self->state_ != State::Connecting || !self->channel_) {
+            return; // stop() 或超时已接手
+        }
+        self->release_channel();
+
+        int error = 0;
+        socklen_t len = sizeof(error);
+        if (::getsockopt(self->socket_.fd(), SOL_SOCKET, SO_ERROR, &error, &len) < 0) {
+            error = errno;
+        }
+        if (error != 0) {
+            self->retry(strerror(error));
+            return;
+        }
+
+        // 目标为本机且端口落在临时端口范围时，内核可能让 socket 连上自己（TCP 自连接），视为失败
+        if (!self->serverAddr_.is_unix()
+            && self->socket_.local_address().get_ip_port() == self->socket_.peer_address().get_ip_port()) {
+            self->retry("self connect");
+            return;
+        }
+
+        self->state_ = State::Connected;
+        self->wantConnect_ = false;
+        self->handle_new_connection_callback(std::move(self->socket_));
+        self->socket_ = Socket(-1);
+        });
+}
+
+void Connector::on_error() {
+    // EPOLLERR/EPOLLHUP 与可写事件的收口路径相同：都以 SO_ERROR 为准
+    on_write();
+}
+
+void Connector::on_timeout() {
+    if (state_ != State::Connecting) {
+        return;
+    }
+    // 定时器回调不在 Channel 事件分发中，可以直接注销
+    release_channel();
+    retry("connect timeout");
+}
+
+void Connector::retry(const std::string& reason) {
+    socket_ = Socket(-1);
+    state_ = State::Disconnected;
+    cancel_timers();
+    if (!wantConnect_) {
+        return;
+    }
+
+    if (options_.maxAttempts > 0 && attempts_ >= options_.maxAttempts) {
+        wantConnect_ = false;
+        handle_connect_failed_callback(reason);
+        return;
+    }
+
+    spdlog::info("Connector: connect to {} failed ({}), retry in {}s", serverAddr_.get_ip_port(), reason, retryDelaySeconds_);
+    std::weak_ptr<Connector> weakSelf(shared_from_this());
+    retryTimer_ = loop_->run_after(retryDelaySeconds_, [weakSelf]() {
+        auto self = weakSelf.lock();
+        if (!self) {
+            return;
+        }
+        self->retryTimer_ = TimerId();
+        if (self->wantConnect_ && self->state_ == State::Disconnected) {
+            self->connect();
+        }
+        });
+    retryDelaySeconds_ = std::min(retryDelaySeconds_ * 2, options_.maxRetryDelaySeconds);
+}
+
+void Connector::release_channel() {
+    channel_.reset(); // 先从 Poller 注销，再由调用方关闭或移交 fd
+    if (timeoutTimer_.valid()) {
+        loop_->cancel(timeoutTimer_);
+        timeoutTimer_ = TimerId();
+    }
+}
+
+void Connector::cancel_timers() {
+    if (timeoutTimer_.valid()) {
+        loop_->cancel(timeoutTimer_);
+        timeoutTimer_ = TimerId();
+    }
+    if (retryTimer_.valid()) {
+        loop_->cancel(retryTimer_);
+        retryTimer_ = TimerId();
+    }
+}
+
+void Connector::handle_new_connection_callback(Socket connSocket) {
+    assert(newConnectionCallback_ != nullptr);
+    newConnectionCallback_(std::move(connSocket));
+}
+
+void Connector::handle_connect_failed_callback(const std::string& reason) {
+    spdlog::warn("Connector: giving up connecting to {} after {} attempt(s): {}", serverAddr_.get_ip_port(), attempts_, reason);
+    if (connectFailedCallback_) {
+        connectFailedCallback_(reason);
+    }
+}
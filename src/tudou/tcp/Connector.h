@@ -0,0 +1,105 @@
+// ============================================================================
+// Connector.h
+// 主动连接器，负责在 EventLoop 上完成非阻塞 connect、超时判定与指数退避重试，成功后把已连接 Socket 交给上层。
+//
+// 成员函数调用树（[公有]/[私有] 标注接口层级）：
+//
+// Connector.h
+// └── Connector
+//     ├── Connector(loop, serverAddr, options)    # [公有] 构造：只记录目标地址与重试策略，不发起连接
+//     ├── start()                                 # [公有] 线程安全：投递到 loop 线程发起首次连接
+//     │   └── connect()                           # [私有] 创建 non-blocking socket 并调用 ::connect，按 errno 分流
+//     │       ├── connecting()                    # [私有] 连接进行中：挂接 Channel 关注可写事件并启动超时定时器
+//     │       │   ├── on_write()                  # [私有] 可写即连接有结论：读 SO_ERROR，排除自连接后发布 Socket
+//     │       │   │   └── handle_new_connection_callback(socket) # [私有] 向上发布已连接 Socket
+//     │       │   ├── on_error()                  # [私有] EPOLLERR：读 SO_ERROR 后进入重试
+//     │       │   └── on_timeout()                # [私有] 超时仍未连上：放弃本次尝试并重试
+//     │       └── retry()                         # [私有] 关闭本次 socket，按指数退避调度下一次 connect
+//     │           └── handle_connect_failed_callback(reason) # [私有] 重试次数耗尽或遇到不可重试错误时通知上层
+//     ├── restart()                               # [公有] 仅 loop 线程：重置退避并立即重新连接（断线重连使用）
+//     ├── stop()                                  # [公有] 线程安全：取消进行中的尝试与待执行的重试
+//     ├── set_new_connection_callback(cb)         # [公有] 注册连接成功回调
+//     ├── set_connect_failed_callback(cb)         # [公有] 注册最终失败回调
+//     └── get_server_addr() const                 # [公有] 返回目标地址
+// ============================================================================
+
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <string>
+
+#include "tudou/tcp/InetAddress.h"
+#include "tudou/tcp/Socket.h"
+#include "tudou/timer/Timer.h"
+
+class Channel;
+class EventLoop;
+
+// Connector 只负责"把一个 socket 连上"，连接建立后的会话语义交给 TcpConnection。
+// 以 shared_ptr 持有：定时器与投递任务通过 weak_ptr 回指，Connector 先于它们销毁时任务自动失效。
+class Connector : public std::enable_shared_from_this<Connector> {
+public:
+    using NewConnectionCallback = std::function<void(Socket connSocket)>;
+    using ConnectFailedCallback = std::function<void(const std::string& reason)>;
+
+    struct Options {
+        double connectTimeoutSeconds = 3.0;     // 单次 connect 的超时时间，<= 0 表示只等内核结论
+        double initialRetryDelaySeconds = 0.5;  // 首次重试的等待时间，之后每次翻倍
+        double maxRetryDelaySeconds = 30.0;     // 退避等待的上限
+        int maxAttempts = 0;                    // 最多尝试次数（含首次），0 表示一直重试直到 stop()
+    };
+
+    Connector(EventLoop* loop, const InetAddress& serverAddr);
+    Connector(EventLoop* loop, const InetAddress& serverAddr, const Options& options);
+    ~Connector();
+
+    Connector(const Connector&) = delete;
+    Connector& operator=(const Connector&) = delete;
+
+    void start();
+    void restart();
+    void stop();
+
+    void set_new_connection_callback(NewConnectionCallback cb) { newConnectionCallback_ = std::move(cb); }
+    void set_connect_failed_callback(ConnectFailedCallback cb) { connectFailedCallback_ = std::move(cb); }
+    const InetAddress& get_server_addr() const { return serverAddr_; }
+
+private:
+    enum class State {
+        Disconnected,
+        Connecting,
+        Connected
+    };
+
+    void start_in_loop();
+    void stop_in_loop();
+    void connect();
+    void connecting();
+    void on_write();
+    void on_error();
+    void on_timeout();
+    void retry(const std::string& reason);
+    void release_channel();
+    void cancel_timers();
+    void handle_new_connection_callback(Socket connSocket);
+    void handle_connect_failed_callback(const std::string& reason);
+
+private:
+    EventLoop* loop_;                               // 所属 EventLoop，全部状态只在此线程读写。
+    InetAddress serverAddr_;                        // 目标地址。
+    Options options_;                               // 超时与退避策略。
+
+    bool wantConnect_;                              // 上层是否仍希望连接，stop() 后置为 false。
+    State state_;                                   // 当前连接阶段。
+    Socket socket_;                                 // 进行中的连接 socket（必须在 channel_ 之前声明）。
+    std::unique_ptr<Channel> channel_;              // 连接进行中关注可写事件的 Channel。
+
+    int attempts_;                                  // 本轮已发起的 connect 次数。
+    double retryDelaySeconds_;                      // 下一次重试前的等待时间。
+    TimerId timeoutTimer_;                          // 单次 connect 超时定时器。
+    TimerId retryTimer_;                            // 退避重试定时器。
+
+    NewConnectionCallback newConnectionCallback_;   // 连接成功回调（必选）。
+    ConnectFailedCallback connectFailedCallback_;   // 最终失败回调（可选）。
+};
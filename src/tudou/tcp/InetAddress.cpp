@@ -1,54 +1,166 @@
 // ============================================================================
 // InetAddress.cpp
-// IPv4 地址值对象实现，显式展开构造步骤并收紧输入契约。
+// 套接字地址值对象实现，显式展开构造步骤并收紧输入契约。
 // ============================================================================
 
 #include "InetAddress.h"
 
 #include <arpa/inet.h>
+#include <cstddef>
+#include <cstring>
 #include <sstream>
 #include <stdexcept>
 
 InetAddress::InetAddress(const std::string& ip, uint16_t port) {
-    address_ = sockaddr_in{};
-    address_.sin_family = AF_INET;
-    address_.sin_port = htons(port);
-    if (::inet_pton(AF_INET, ip.c_str(), &address_.sin_addr) != 1) {
-        throw std::invalid_argument("InetAddress requires a valid IPv4 text address: " + ip);
+    if (::inet_pton(AF_INET, ip.c_str(), &address_.v4.sin_addr) == 1) {
+        address_.v4.sin_family = AF_INET;
+        address_.v4.sin_port = htons(port);
+        length_ = sizeof(sockaddr_in);
+        return;
     }
+
+    // 允许 URL 风格的 "[::1]" 写法，去掉方括号后再按 IPv6 解析
+    std::string text = ip;
+    if (text.size() >= 2 && text.front() == '[' && text.back() == ']') {
+        text = text.substr(1, text.size() - 2);
+    }
+    if (::inet_pton(AF_INET6, text.c_str(), &address_.v6.sin6_addr) != 1) {
+        throw std::invalid_argument("InetAddress requires a valid IPv4 or IPv6 text address: " + ip);
+    }
+    address_.v6.sin6_family = AF_INET6;
+    address_.v6.sin6_port = htons(port);
+    length_ = sizeof(sockaddr_in6);
 }
 
 InetAddress::InetAddress(const sockaddr_in& address) {
     if (address.sin_family != AF_INET) { // 检查满足 IPv4 契约
         throw std::invalid_argument("InetAddress requires an AF_INET sockaddr_in input");
     }
-    address_ = address;
+    address_.v4 = address;
+    length_ = sizeof(sockaddr_in);
+}
+
+InetAddress::InetAddress(const sockaddr_in6& address) {
+    if (address.sin6_family != AF_INET6) {
+        throw std::invalid_argument("InetAddress requires an AF_INET6 sockaddr_in6 input");
+    }
+    address_.v6 = address;
+    length_ = sizeof(sockaddr_in6);
+}
+
+InetAddress::InetAddress(const sockaddr* address, socklen_t len) {
+    if (address == nullptr || len < static_cast<socklen_t>(sizeof(sa_family_t)) || len > static_cast<socklen_t>(sizeof(address_))) {
+        throw std::invalid_argument("InetAddress requires a non-empty sockaddr input");
+    }
+    if (address->sa_family != AF_INET && address->sa_family != AF_INET6 && address->sa_family != AF_UNIX) {
+        throw std::invalid_argument("InetAddress supports only AF_INET, AF_INET6 and AF_UNIX sockaddr input");
+    }
+    if ((address->sa_family == AF_INET && len < static_cast<socklen_t>(sizeof(sockaddr_in)))
+        || (address->sa_family == AF_INET6 && len < static_cast<socklen_t>(sizeof(sockaddr_in6)))) {
+        throw std::invalid_argument("InetAddress received a truncated sockaddr");
+    }
+    std::memcpy(&address_, address, len);
+    length_ = len; // 未绑定路径的 Unix 域对端（如客户端 connect 方）长度只含地址族
+    if (address->sa_family == AF_INET6) {
+        unmap_ipv4();
+    }
+}
+
+void InetAddress::unmap_ipv4() {
+    // 双栈监听 socket 上接入的 IPv4 客户端以 ::ffff:a.b.c.d 形式出现，还原为 AF_INET，
+    // 让连接地址快照、日志与按 IPv4 配置的访问规则看到的仍是原始 IPv4 地址。
+    if (!IN6_IS_ADDR_V4MAPPED(&address_.v6.sin6_addr)) {
+        return;
+    }
+    sockaddr_in v4{};
+    v4.sin_family = AF_INET;
+    v4.sin_port = address_.v6.sin6_port;
+    std::memcpy(&v4.sin_addr, address_.v6.sin6_addr.s6_addr + 12, sizeof(v4.sin_addr));
+    address_ = Storage{};
+    address_.v4 = v4;
+    length_ = sizeof(sockaddr_in);
+}
+
+InetAddress InetAddress::from_unix_path(const std::string& path) {
+    InetAddress address;
+    if (path.empty() || path.size() >= sizeof(address.address_.un.sun_path)) {
+        throw std::invalid_argument("InetAddress requires a non-empty unix socket path shorter than sun_path: " + path);
+    }
+    address.address_.un.sun_family = AF_UNIX;
+    std::memcpy(address.address_.un.sun_path, path.data(), path.size());
+    if (path[0] == '@') {
+        // Linux 抽象命名空间：首字节为 '\0'，名字长度由 socklen 界定，不在文件系统留下 socket 文件
+        address.address_.un.sun_path[0] = '\0';
+        address.length_ = static_cast<socklen_t>(offsetof(sockaddr_un, sun_path) + path.size());
+    }
+    else {
+        address.length_ = static_cast<socklen_t>(offsetof(sockaddr_un, sun_path) + path.size() + 1);
+    }
+    return address;
 }
 
 const sockaddr_in& InetAddress::get_sockaddr() const {
-    return address_;
+    if (get_family() != AF_INET) {
+        throw std::logic_error("InetAddress::get_sockaddr() requires an AF_INET address");
+    }
+    return address_.v4;
+}
+
+const sockaddr_in6& InetAddress::get_sockaddr_in6() const {
+    if (!is_ipv6()) {
+        throw std::logic_error("InetAddress::get_sockaddr_in6() requires an AF_INET6 address");
+    }
+    return address_.v6;
+}
+
+std::string InetAddress::get_unix_path() const {
+    if (!is_unix() || length_ <= static_cast<socklen_t>(offsetof(sockaddr_un, sun_path))) {
+        return std::string();
+    }
+    const size_t nameLen = static_cast<size_t>(length_) - offsetof(sockaddr_un, sun_path);
+    if (address_.un.sun_path[0] == '\0') {
+        return "@" + std::string(address_.un.sun_path + 1, nameLen - 1);
+    }
+    return std::string(address_.un.sun_path, ::strnlen(address_.un.sun_path, nameLen));
 }
 
 std::string InetAddress::get_ip() const {
-    return to_ip_string(address_); // 对外暴露文本 IP 时，统一复用单一序列化逻辑，避免字节序细节泄漏到调用方。
+    if (is_unix()) {
+        return get_unix_path();
+    }
+    return to_ip_string(); // 对外暴露文本 IP 时，统一复用单一序列化逻辑，避免字节序细节泄漏到调用方。
 }
 
 uint16_t InetAddress::get_port() const {
-    return ntohs(address_.sin_port); // 对外读取端口时统一转换为主机字节序，保证上层拿到的是业务可读值。
+    if (is_unix()) {
+        return 0;
+    }
+    // sin_port 与 sin6_port 位于相同偏移，但仍按地址族显式读取，不依赖布局巧合
+    return ntohs(is_ipv6() ? address_.v6.sin6_port : address_.v4.sin_port); // 对外读取端口时统一转换为主机字节序，保证上层拿到的是业务可读值。
 }
 
 std::string InetAddress::get_ip_port() const {
+    if (is_unix()) {
+        return "unix:" + get_unix_path();
+    }
     std::ostringstream endpoint;
-    endpoint << to_ip_string(address_) << ":" << ntohs(address_.sin_port);
+    if (is_ipv6()) {
+        endpoint << "[" << to_ip_string() << "]:" << get_port(); // IPv6 文本自带冒号，按 RFC 3986 加方括号消除歧义
+    }
+    else {
+        endpoint << to_ip_string() << ":" << get_port();
+    }
     return endpoint.str();
 }
 
-std::string InetAddress::to_ip_string(const sockaddr_in& address) {
+std::string InetAddress::to_ip_string() const {
     // 统一通过 inet_ntop 做二进制到文本的转换，避免外部自行处理缓冲区和协议细节。
-    char buffer[INET_ADDRSTRLEN] = {};
-    const char* convertedIp = ::inet_ntop(AF_INET, &address.sin_addr, buffer, sizeof(buffer));
+    char buffer[INET6_ADDRSTRLEN] = {};
+    const char* convertedIp = is_ipv6()
+        ? ::inet_ntop(AF_INET6, &address_.v6.sin6_addr, buffer, sizeof(buffer))
+        : ::inet_ntop(AF_INET, &address_.v4.sin_addr, buffer, sizeof(buffer));
     if (convertedIp == nullptr) {
-        throw std::invalid_argument("InetAddress failed to convert IPv4 address to text");
+        throw std::invalid_argument("InetAddress failed to convert IP address to text");
     }
     return std::string(convertedIp);
 }
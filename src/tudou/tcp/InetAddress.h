@@ -1,47 +1,83 @@
 // ============================================================================
 // InetAddress.h
-// IPv4 地址值对象，对 sockaddr_in 的构造、校验与读取契约做显式封装。
+// 套接字地址值对象，对 IPv4 sockaddr_in、IPv6 sockaddr_in6 与 Unix 域 sockaddr_un 的构造、校验与读取契约做显式封装。
 //
 // 成员函数调用树（[公有]/[私有] 标注接口层级）：
 //
 // InetAddress.h
 // └── InetAddress
-//     ├── InetAddress(ip, port)                  # [公有] 从 IPv4 文本和端口构造地址对象
-//     ├── InetAddress(address)                   # [公有] 从原生 sockaddr_in 接管地址
+//     ├── InetAddress(ip, port)                  # [公有] 从 IPv4 / IPv6 文本和端口构造地址对象，先按 IPv4 解析
+//     ├── InetAddress(address)                   # [公有] 从原生 sockaddr_in / sockaddr_in6 接管地址
+//     ├── InetAddress(addr, len)                 # [公有] 从 accept/getsockname 得到的通用地址接管（AF_INET / AF_INET6 / AF_UNIX）
+//     │   └── unmap_ipv4()                       # [私有] 双栈监听收到的 IPv4 映射地址还原为 AF_INET
+//     ├── from_unix_path(path)                   # [公有] 构造 Unix 域地址，'@' 开头表示 Linux 抽象命名空间
 //     ├── InetAddress(other)                     # [公有] 默认拷贝构造，保留地址值语义
 //     ├── operator=(other)                       # [公有] 默认拷贝赋值
 //     ├── ~InetAddress()                         # [公有] 默认析构
-//     ├── get_sockaddr() const                   # [公有] 返回底层 sockaddr_in 视图
-//     ├── get_ip() const                         # [公有] 输出 IPv4 文本地址
-//     │   └── to_ip_string(address)              # [私有] 做二进制到文本转换
-//     ├── get_port() const                       # [公有] 输出主机字节序端口
-//     └── get_ip_port() const                    # [公有] 输出 ip:port 组合字符串
-//         └── to_ip_string(address)              # [私有] 获取文本 IP
+//     ├── get_family() const                     # [公有] 返回地址族 AF_INET / AF_INET6 / AF_UNIX
+//     ├── is_unix() const                        # [公有] 是否为 Unix 域地址
+//     ├── is_ipv6() const                        # [公有] 是否为 IPv6 地址
+//     ├── get_sockaddr() const                   # [公有] 返回底层 sockaddr_in 视图（仅 IPv4）
+//     ├── get_sockaddr_in6() const               # [公有] 返回底层 sockaddr_in6 视图（仅 IPv6）
+//     ├── get_sockaddr_ptr() const               # [公有] 返回供 bind/connect 使用的通用地址指针
+//     ├── get_socklen() const                    # [公有] 返回通用地址的有效长度
+//     ├── get_unix_path() const                  # [公有] 返回 Unix 域路径（抽象命名空间以 '@' 开头）
+//     ├── get_ip() const                         # [公有] 输出 IPv4 / IPv6 文本地址，Unix 域地址输出路径
+//     │   └── to_ip_string() const               # [私有] 按地址族做二进制到文本转换
+//     ├── get_port() const                       # [公有] 输出主机字节序端口，Unix 域地址为 0
+//     └── get_ip_port() const                    # [公有] 输出 ip:port 组合字符串，IPv6 输出 [ip]:port，Unix 域地址输出 unix:path
+//         └── to_ip_string() const               # [私有] 获取文本 IP
 // ============================================================================
 
 #pragma once
 
 #include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/un.h>
 #include <string>
 
-// InetAddress 负责将 IPv4 文本地址与原生 sockaddr_in 之间的转换收敛到单一契约对象中。
+// InetAddress 负责将文本地址与原生 sockaddr 之间的转换收敛到单一契约对象中。
+// 同机部署（sidecar）可用 Unix 域地址替代回环 TCP，省去 TCP 协议栈开销，上层监听与连接代码无需区分。
+// IPv6 文本（可带方括号）与 IPv4 文本共用同一构造入口；IPv4 先解析，热路径上不为 IPv6 多付任何代价。
 class InetAddress {
 public:
     explicit InetAddress(const std::string& ip, uint16_t port);
     explicit InetAddress(const sockaddr_in& address);
+    explicit InetAddress(const sockaddr_in6& address);
+    InetAddress(const sockaddr* address, socklen_t len);
     InetAddress(const InetAddress& other) = default;
 
     InetAddress& operator=(const InetAddress& other) = default;
     ~InetAddress() = default;
 
+    static InetAddress from_unix_path(const std::string& path);
+
+    int get_family() const { return address_.storage.ss_family; }
+    bool is_unix() const { return get_family() == AF_UNIX; }
+    bool is_ipv6() const { return get_family() == AF_INET6; }
+
     const sockaddr_in& get_sockaddr() const;
+    const sockaddr_in6& get_sockaddr_in6() const;
+    const sockaddr* get_sockaddr_ptr() const { return reinterpret_cast<const sockaddr*>(&address_.storage); }
+    socklen_t get_socklen() const { return length_; }
+    std::string get_unix_path() const;
     std::string get_ip() const;
     uint16_t get_port() const;
     std::string get_ip_port() const; // 输出统一格式的 ip:port 文本。
 
 private:
-    static std::string to_ip_string(const sockaddr_in& address);
+    InetAddress() = default;
+    void unmap_ipv4();
+    std::string to_ip_string() const;
 
 private:
-    sockaddr_in address_;               // 以网络字节序保存的 IPv4 地址契约，屏蔽调用方对底层结构体细节的直接操作。
+    union Storage {
+        sockaddr_storage storage;
+        sockaddr_in v4;
+        sockaddr_in6 v6;
+        sockaddr_un un;
+    };
+
+    Storage address_{};                 // 以网络字节序保存的地址契约，屏蔽调用方对底层结构体细节的直接操作。
+    socklen_t length_ = 0;              // 有效地址长度；抽象命名空间的 Unix 域地址依赖它界定名字结尾。
 };
\ No newline at end of file
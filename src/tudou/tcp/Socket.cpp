@@ -12,16 +12,42 @@
 #include <netinet/tcp.h>
 #include <stdexcept>
 #include <sys/socket.h>
+#include <sys/stat.h>
 #include <unistd.h>
 
 #include "spdlog/spdlog.h"
 
+namespace {
+
+// 判断文件系统路径上的 socket 文件是否为上次进程异常退出后的残留：必须确实是 socket 文件，
+// 且试连被拒绝（没有进程在监听）。普通文件、目录或仍在服务的 socket 一律视为地址被占用
+bool is_stale_unix_socket(const InetAddress& addr) {
+    struct stat st;
+    if (::lstat(addr.get_unix_path().c_str(), &st) < 0 || !S_ISSOCK(st.st_mode)) {
+        return false;
+    }
+
+    const int probeFd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (probeFd < 0) {
+        return false;
+    }
+    const bool refused = ::connect(probeFd, addr.get_sockaddr_ptr(), addr.get_socklen()) < 0 && errno == ECONNREFUSED;
+    ::close(probeFd);
+    return refused;
+}
+
+} // namespace
+
 Socket::Socket(int sockFd) noexcept
     : fd_(sockFd) {
 }
 
+Socket Socket::create_listener(const InetAddress& addr) {
+    return addr.is_unix() ? create_unix_listener(addr) : create_tcp_listener(addr);
+}
+
 Socket Socket::create_tcp_listener(const InetAddress& addr) {
-    const int listenFd = ::socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, IPPROTO_TCP);
+    const int listenFd = ::socket(addr.get_family(), SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, IPPROTO_TCP);
     if (listenFd < 0) {
         std::string errMsg = "Socket::create_tcp_listener(): socket() failed, errno=" + std::to_string(errno) + " (" + strerror(errno) + ")";
         spdlog::error(errMsg);
@@ -34,8 +60,13 @@ Socket Socket::create_tcp_listener(const InetAddress& addr) {
     // 设置 SO_REUSEADDR，避免服务器重启时 TIME_WAIT 导致 bind 失败
     sock.set_reuse_addr(true);
 
-    sockaddr_in rawAddr = addr.get_sockaddr();
-    if (::bind(sock.fd(), reinterpret_cast<sockaddr*>(&rawAddr), sizeof(rawAddr)) < 0) {
+    // IPv6 监听显式关闭 IPV6_V6ONLY：监听 "::" 时同一个 socket 也接入 IPv4 客户端（双栈），
+    // 不依赖 /proc/sys/net/ipv6/bindv6only 的系统默认值，也无需再为 IPv4 单独起一个监听。
+    if (addr.is_ipv6()) {
+        sock.set_ipv6_only(false);
+    }
+
+    if (::bind(sock.fd(), addr.get_sockaddr_ptr(), addr.get_socklen()) < 0) {
         std::string errMsg = "Socket::create_tcp_listener(): bind() failed, errno=" + std::to_string(errno) + " (" + strerror(errno) + ")";
         spdlog::error(errMsg);
         throw std::runtime_error(errMsg);
@@ -50,12 +81,44 @@ Socket Socket::create_tcp_listener(const InetAddress& addr) {
     return sock;
 }
 
-Socket Socket::accept(sockaddr_in* peerAddr) const {
-    socklen_t addrLen = sizeof(sockaddr_in);
+Socket Socket::create_unix_listener(const InetAddress& addr) {
+    const int listenFd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (listenFd < 0) {
+        std::string errMsg = "Socket::create_unix_listener(): socket() failed, errno=" + std::to_string(errno) + " (" + strerror(errno) + ")";
+        spdlog::error(errMsg);
+        throw std::runtime_error(errMsg);
+    }
+
+    Socket sock(listenFd);
+
+    // 文件系统路径上残留的 socket 文件（上次进程异常退出）会让 bind 返回 EADDRINUSE，确认无人监听后才清理；
+    // 路径上的其它文件或仍在服务的 socket 保持原样，bind 照常以 EADDRINUSE 失败。抽象命名空间无需清理
+    const std::string path = addr.get_unix_path();
+    if (!path.empty() && path[0] != '@' && is_stale_unix_socket(addr)) {
+        ::unlink(path.c_str());
+    }
+
+    if (::bind(sock.fd(), addr.get_sockaddr_ptr(), addr.get_socklen()) < 0) {
+        std::string errMsg = "Socket::create_unix_listener(): bind(" + path + ") failed, errno=" + std::to_string(errno) + " (" + strerror(errno) + ")";
+        spdlog::error(errMsg);
+        throw std::runtime_error(errMsg);
+    }
+
+    if (::listen(sock.fd(), SOMAXCONN) < 0) {
+        std::string errMsg = "Socket::create_unix_listener(): listen() failed, errno=" + std::to_string(errno) + " (" + strerror(errno) + ")";
+        spdlog::error(errMsg);
+        throw std::runtime_error(errMsg);
+    }
+
+    return sock;
+}
+
+Socket Socket::accept(sockaddr_storage* peerAddr, socklen_t* addrLen) const {
+    *addrLen = sizeof(sockaddr_storage);
     // 使用 accept4 一次性原子创建 non-blocking + cloexec 连接 socket，减少系统调用并防 fd 泄露。
     const int connFd = ::accept4(fd(),
                                  reinterpret_cast<sockaddr*>(peerAddr),
-                                 &addrLen,
+                                 addrLen,
                                  SOCK_NONBLOCK | SOCK_CLOEXEC);
 
     if (connFd < 0) {
@@ -76,6 +139,13 @@ void Socket::set_reuse_addr(bool on) {
     }
 }
 
+void Socket::set_ipv6_only(bool on) {
+    const int kEnable = on ? 1 : 0;
+    if (::setsockopt(fd(), IPPROTO_IPV6, IPV6_V6ONLY, &kEnable, sizeof(kEnable)) < 0) {
+        spdlog::warn("Socket: failed to set IPV6_V6ONLY on fd {}, errno: {}", fd(), errno);
+    }
+}
+
 void Socket::set_tcp_no_delay(bool on) {
     const int kEnable = on ? 1 : 0;
     if (::setsockopt(fd(), IPPROTO_TCP, TCP_NODELAY, &kEnable, sizeof(kEnable)) < 0) {
@@ -111,6 +181,15 @@ void Socket::set_keep_alive(bool on) {
     }
 }
 
+void Socket::set_no_sigpipe() {
+#ifdef SO_NOSIGPIPE
+    const int kEnable = 1;
+    if (::setsockopt(fd(), SOL_SOCKET, SO_NOSIGPIPE, &kEnable, sizeof(kEnable)) < 0) {
+        spdlog::warn("Socket: failed to set SO_NOSIGPIPE on fd {}, errno: {}", fd(), errno);
+    }
+#endif
+}
+
 void Socket::shutdown_write() {
     if (::shutdown(fd(), SHUT_WR) < 0) {
         spdlog::warn("Socket: failed to shutdown_write on fd {}, errno: {}", fd(), errno);
@@ -118,13 +197,29 @@ void Socket::shutdown_write() {
 }
 
 InetAddress Socket::local_address() const {
-    sockaddr_in localSockAddr;
+    sockaddr_storage localSockAddr;
     memset(&localSockAddr, 0, sizeof(localSockAddr));
     socklen_t addrLen = sizeof(localSockAddr);
 
     if (::getsockname(fd(), reinterpret_cast<sockaddr*>(&localSockAddr), &addrLen) < 0) {
         spdlog::error("Socket::local_address(): getsockname() failed, errno={} ({})", errno, strerror(errno));
+        localSockAddr.ss_family = AF_INET;
+        addrLen = sizeof(sockaddr_in);
+    }
+
+    return InetAddress(reinterpret_cast<const sockaddr*>(&localSockAddr), addrLen);
+}
+
+InetAddress Socket::peer_address() const {
+    sockaddr_storage peerSockAddr;
+    memset(&peerSockAddr, 0, sizeof(peerSockAddr));
+    socklen_t addrLen = sizeof(peerSockAddr);
+
+    if (::getpeername(fd(), reinterpret_cast<sockaddr*>(&peerSockAddr), &addrLen) < 0) {
+        spdlog::error("Socket::peer_address(): getpeername() failed, errno={} ({})", errno, strerror(errno));
+        peerSockAddr.ss_family = AF_INET;
+        addrLen = sizeof(sockaddr_in);
     }
 
-    return InetAddress(localSockAddr);
+    return InetAddress(reinterpret_cast<const sockaddr*>(&peerSockAddr), addrLen);
 }
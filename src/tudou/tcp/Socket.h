@@ -26,15 +26,20 @@ public:
 
     int fd() const { return fd_.fd(); }
 
-    static Socket create_tcp_listener(const InetAddress& addr);
-    Socket accept(sockaddr_in* peerAddr) const;
+    static Socket create_listener(const InetAddress& addr); // 按地址族分派到 TCP 或 Unix 域监听
+    static Socket create_tcp_listener(const InetAddress& addr); // IPv6 地址以双栈方式监听
+    static Socket create_unix_listener(const InetAddress& addr); // 只清理无人监听的残留 socket 文件，否则 bind 以 EADDRINUSE 失败
+    Socket accept(sockaddr_storage* peerAddr, socklen_t* addrLen) const;
 
     void set_reuse_addr(bool on);
+    void set_ipv6_only(bool on);
     void set_tcp_no_delay(bool on);
     void set_keep_alive(bool on);
+    void set_no_sigpipe(); // 支持 SO_NOSIGPIPE 的平台上置位；Linux 由各写调用携带 MSG_NOSIGNAL
     void shutdown_write();
 
     InetAddress local_address() const;
+    InetAddress peer_address() const;
 
 private:
     ScopedFd fd_;
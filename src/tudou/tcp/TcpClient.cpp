@@ -0,0 +1,190 @@
+// ============================================================================
+// TcpClient.cpp
+// TcpClient 的实现：Connector 交出已连接 Socket，沿途配置 socket 选项后装配为 TcpConnection。
+// ============================================================================
+
+#include "tudou/tcp/TcpClient.h"
+
+#include <cassert>
+#include <future>
+
+#include "spdlog/spdlog.h"
+#include "tudou/reactor/EventLoop.h"
+
+namespace {
+
+constexpr size_t kDefaultHighWaterMark = 64 * 1024 * 1024; // 64 MB
+
+} // namespace
+
+TcpClient::TcpClient(EventLoop* loop, const InetAddress& serverAddr) :
+    TcpClient(loop, serverAddr, Connector::Options()) {
+}
+
+TcpClient::TcpClient(EventLoop* loop, const InetAddress& serverAddr, const Connector::Options& options) :
+    loop_(loop),
+    connector_(std::make_shared<Connector>(loop, serverAddr, options)),
+    retry_(false),
+    wantConnect_(false),
+    connectionMutex_(),
+    connection_(nullptr),
+    connectionCallback_(nullptr),
+    messageCallback_(nullptr),
+    closeCallback_(nullptr),
+    errorCallback_(nullptr),
+    writeCompleteCallback_(nullptr),
+    highWaterMarkCallback_(nullptr),
+    highWaterMark_(kDefaultHighWaterMark) {
+
+    // Connector 由 TcpClient 独占，析构前总会先在 loop 线程 stop()，回调回指 this 是安全的
+    connector_->set_new_connection_callback([this](Socket connSocket) {
+        on_new_connection(std::move(connSocket));
+        });
+}
+
+TcpClient::~TcpClient() {
+    // Connector 的 Channel 与 TcpConnection 的回调摘除都只能在 loop 线程进行：本线程即 loop 线程时直接收口，否则投递过去并等待完成
+    if (loop_->is_in_loop_thread()) {
+        teardown_in_loop();
+        return;
+    }
+
+    std::promise<void> tornDown;
+    std::future<void> future = tornDown.get_future();
+    loop_->queue_in_loop([this, &tornDown]() {
+        this->teardown_in_loop();
+        tornDown.set_value();
+        });
+    future.wait();
+}
+
+void TcpClient::set_high_water_mark_callback(HighWaterMarkCallback cb, size_t highWaterMark) {
+    highWaterMarkCallback_ = std::move(cb);
+    highWaterMark_ = highWaterMark;
+}
+
+void TcpClient::set_connect_failed_callback(ConnectFailedCallback cb) {
+    connector_->set_connect_failed_callback(std::move(cb));
+}
+
+void TcpClient::connect() {
+    spdlog::debug("TcpClient::connect() to {}", connector_->get_server_addr().get_ip_port());
+    wantConnect_ = true;
+    connector_->start();
+}
+
+void TcpClient::disconnect() {
+    wantConnect_ = false;
+    connector_->stop();
+
+    TcpConnectionPtr conn = get_connection();
+    if (conn) {
+        conn->force_close();
+    }
+}
+
+TcpConnectionPtr TcpClient::get_connection() const {
+    std::lock_guard<std::mutex> lock(connectionMutex_);
+    return connection_;
+}
+
+void TcpClient::on_new_connection(Socket connSocket) {
+    assert(loop_->is_in_loop_thread());
+
+    const InetAddress localAddr = connSocket.local_address();
+    const InetAddress peerAddr = connSocket.peer_address();
+    auto conn = TcpConnection::create_connection(loop_, std::move(connSocket), localAddr, peerAddr);
+
+    // 与服务端保持一致的 socket 选项：开启 TCP_NODELAY 和 TCP keepalive；Unix 域连接没有这些选项。
+    if (!localAddr.is_unix()) {
+        conn->set_tcp_no_delay(true);
+        conn->set_keep_alive(true);
+    }
+
+    conn->set_message_callback([this](const TcpConnectionPtr& activeConn) {
+        on_message(activeConn);
+        });
+    conn->set_close_callback([this](const TcpConnectionPtr& activeConn) {
+        on_close(activeConn);
+        });
+
+    if (errorCallback_) {
+        conn->set_error_callback(errorCallback_);
+    }
+
+    if (writeCompleteCallback_) {
+        conn->set_write_complete_callback(writeCompleteCallback_);
+    }
+
+    if (highWaterMarkCallback_) {
+        conn->set_high_water_mark_callback([this](const TcpConnectionPtr& activeConn) {
+            highWaterMarkCallback_(activeConn, activeConn->get_write_buffer_size());
+            }, highWaterMark_);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(connectionMutex_);
+        connection_ = conn;
+    }
+    spdlog::info("TcpClient: Connected to {} from {} on fd {}", peerAddr.get_ip_port(), localAddr.get_ip_port(), conn->get_fd());
+
+    if (!wantConnect_) {
+        // 建连期间上层已调用 disconnect()，连接一建立就关闭
+        conn->force_close();
+        return;
+    }
+
+    if (connectionCallback_) {
+        connectionCallback_(conn);
+    }
+}
+
+void TcpClient::on_message(const TcpConnectionPtr& conn) {
+    if (messageCallback_) {
+        messageCallback_(conn);
+        return;
+    }
+
+    spdlog::warn("TcpClient::on_message(). messageCallback is nullptr, fd: {}", conn ? conn->get_fd() : -1);
+}
+
+void TcpClient::on_close(const TcpConnectionPtr& conn) {
+    assert(loop_->is_in_loop_thread());
+    {
+        std::lock_guard<std::mutex> lock(connectionMutex_);
+        if (connection_ == conn) {
+            connection_.reset();
+        }
+    }
+
+    if (closeCallback_) {
+        closeCallback_(conn);
+    }
+
+    if (retry_ && wantConnect_) {
+        spdlog::info("TcpClient: Connection to {} closed, reconnecting", connector_->get_server_addr().get_ip_port());
+        connector_->restart();
+    }
+}
+
+void TcpClient::teardown_in_loop() {
+    wantConnect_ = false;
+    connector_->stop();
+
+    TcpConnectionPtr conn;
+    {
+        std::lock_guard<std::mutex> lock(connectionMutex_);
+        conn = std::move(connection_);
+    }
+    if (!conn) {
+        return;
+    }
+
+    // 先把回指 this 的回调换成空操作，再关闭连接：连接对象可能被其他持有者延长生命周期，不能再回调到已析构的 TcpClient
+    conn->set_message_callback([](const TcpConnectionPtr& activeConn) {
+        activeConn->receive();
+        });
+    conn->set_close_callback(nullptr);
+    conn->set_high_water_mark_callback(nullptr, conn->get_high_water_mark());
+    conn->force_close();
+}
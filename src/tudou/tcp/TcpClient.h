@@ -0,0 +1,104 @@
+// ============================================================================
+// TcpClient.h
+// TCP 客户端编排器，借助 Connector 主动建连，把连上的 Socket 装配成与服务端同构的 TcpConnection 并转发会话事件。
+//
+// 成员函数调用树（[公有]/[私有] 标注接口层级）：
+//
+// TcpClient.h
+// └── TcpClient
+//     ├── TcpClient(loop, serverAddr, options)    # [公有] 构造：创建 Connector，不发起连接
+//     ├── ~TcpClient()                            # [公有] 析构：在 loop 线程停止 Connector 并关闭当前连接
+//     │   └── teardown_in_loop()                  # [私有] 摘除回调后 force_close，避免回调回指已析构对象
+//     ├── connect()                               # [公有] 线程安全：启动 Connector（超时 + 指数退避重试）
+//     │   └── on_new_connection(connSocket)       # [私有] Connector 成功回调：配置 socket 选项、创建 TcpConnection、绑定回调
+//     │       ├── on_message(conn)                # [私有] 向上转发消息事件
+//     │       └── on_close(conn)                  # [私有] 清除当前连接、通知上层，按需重连
+//     │           └── Connector::restart()        # [Connector] 启用重连时重置退避并重新建连
+//     ├── disconnect()                            # [公有] 线程安全：停止重试并关闭当前连接，不再重连
+//     ├── enable_retry(on)                        # [公有] 已建立的连接断开后是否自动重连
+//     ├── set_connection_callback(cb)             # [公有] 注册建连回调
+//     ├── set_message_callback(cb)                # [公有] 注册消息回调
+//     ├── set_close_callback(cb)                  # [公有] 注册关闭回调
+//     ├── set_error_callback(cb)                  # [公有] 注册错误回调
+//     ├── set_write_complete_callback(cb)         # [公有] 注册写完成回调
+//     ├── set_high_water_mark_callback(cb, mark)  # [公有] 注册高水位回调并设置阈值
+//     ├── set_connect_failed_callback(cb)         # [公有] 注册建连最终失败回调
+//     ├── get_connection() const                  # [公有] 线程安全：返回当前连接（未连上为空）
+//     ├── get_loop() const                        # [公有] 返回所属 EventLoop
+//     └── get_server_addr() const                 # [公有] 返回目标地址
+// ============================================================================
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include "tudou/tcp/Connector.h"
+#include "tudou/tcp/TcpConnection.h"
+
+class EventLoop;
+
+// TcpClient 与 TcpServer 对称：回调签名一致，出站代理、RPC 客户端和压测工具可复用同一套连接语义。
+// 回调须在 connect() 之前设置；所有回调都在所属 loop 线程执行。析构时若不在 loop 线程，会投递到 loop 线程收口并等待完成，
+// 因此所属 loop 必须仍在运行。
+class TcpClient {
+public:
+    using ConnectionCallback = std::function<void(const TcpConnectionPtr&)>;
+    using MessageCallback = std::function<void(const TcpConnectionPtr&)>;
+    using CloseCallback = std::function<void(const TcpConnectionPtr&)>;
+    using ErrorCallback = std::function<void(const TcpConnectionPtr&)>;
+    using WriteCompleteCallback = std::function<void(const TcpConnectionPtr&)>;
+    using HighWaterMarkCallback = std::function<void(const TcpConnectionPtr&, size_t)>;
+    using ConnectFailedCallback = Connector::ConnectFailedCallback;
+
+    TcpClient(EventLoop* loop, const InetAddress& serverAddr);
+    TcpClient(EventLoop* loop, const InetAddress& serverAddr, const Connector::Options& options);
+    ~TcpClient();
+
+    TcpClient(const TcpClient&) = delete;
+    TcpClient& operator=(const TcpClient&) = delete;
+
+    void connect();
+    void disconnect();
+    void enable_retry(bool on = true) { retry_ = on; }
+
+    void set_connection_callback(ConnectionCallback cb) { connectionCallback_ = std::move(cb); }
+    void set_message_callback(MessageCallback cb) { messageCallback_ = std::move(cb); }
+    void set_close_callback(CloseCallback cb) { closeCallback_ = std::move(cb); }
+    void set_error_callback(ErrorCallback cb) { errorCallback_ = std::move(cb); }
+    void set_write_complete_callback(WriteCompleteCallback cb) { writeCompleteCallback_ = std::move(cb); }
+    void set_high_water_mark_callback(HighWaterMarkCallback cb, size_t highWaterMark = 64 * 1024 * 1024);
+    void set_connect_failed_callback(ConnectFailedCallback cb);
+
+    TcpConnectionPtr get_connection() const;
+    EventLoop* get_loop() const { return loop_; }
+    const InetAddress& get_server_addr() const { return connector_->get_server_addr(); }
+
+private:
+    void on_new_connection(Socket connSocket);
+    void on_message(const TcpConnectionPtr& conn);
+    void on_close(const TcpConnectionPtr& conn);
+    void teardown_in_loop();
+
+private:
+    EventLoop* loop_;                                   // 所属 EventLoop，连接与 Connector 的事件都在此线程执行。
+    std::shared_ptr<Connector> connector_;              // 主动建连器，只在 loop 线程停止与释放。
+
+    std::atomic<bool> retry_;                           // 已建立的连接断开后是否自动重连。
+    std::atomic<bool> wantConnect_;                     // 上层是否仍希望保持连接，disconnect() 后置为 false。
+
+    mutable std::mutex connectionMutex_;                // 保护 connection_，供其他线程 get_connection()。
+    TcpConnectionPtr connection_;                       // 当前连接，未连上时为空。
+
+    ConnectionCallback connectionCallback_;             // 建连回调（可选）。
+    MessageCallback messageCallback_;                   // 消息回调（必选）。
+    CloseCallback closeCallback_;                       // 关闭回调（可选）。
+    ErrorCallback errorCallback_;                       // 错误回调（可选）。
+    WriteCompleteCallback writeCompleteCallback_;       // 写完成回调（可选）。
+    HighWaterMarkCallback highWaterMarkCallback_;       // 高水位回调（可选）。
+    size_t highWaterMark_;                              // 高水位阈值（字节）。
+};
@@ -10,12 +10,14 @@
 #include <cstring>
 #include <unistd.h>
 #include <sys/sendfile.h>
+#include <sys/socket.h>
 #include <sys/stat.h>
 #include <sys/uio.h>
 
 #include "spdlog/spdlog.h"
 
 #include "base/ScopedFd.h"
+#include "base/ScopedSigPipeBlock.h"
 #include "tudou/tcp/Buffer.h"
 #include "tudou/reactor/Channel.h"
 #include "tudou/reactor/EventLoop.h"
@@ -52,12 +54,15 @@ TcpConnection::TcpConnection(EventLoop* loop, Socket connSocket, const InetAddre
     errorCallback_(nullptr),
     writeCompleteCallback_(nullptr),
     highWaterMarkCallback_(nullptr),
+    directRead_(false),
+    retryOnWritable_(false),
     isClosed_(false) {
 
     channel_->set_read_callback([this](Channel& ch) { on_read(ch); });
     channel_->set_write_callback([this](Channel& ch) { on_write(ch); });
     channel_->set_close_callback([this](Channel& ch) { on_close(ch); });
     channel_->set_error_callback([this](Channel& ch) { on_error(ch); });
+    connSocket_.set_no_sigpipe();
 }
 
 TcpConnection::~TcpConnection() {
@@ -69,27 +74,37 @@ void TcpConnection::send(const std::string& msg) {
     if (!loop_->is_in_loop_thread()) {
         std::shared_ptr<TcpConnection> self = shared_from_this();
         loop_->queue_in_loop([self, msg]() {
-            self->send_in_loop(msg);
+            self->send_in_loop(msg.data(), msg.size());
             });
         return;
     }
 
-    send_in_loop(msg);
+    send_in_loop(msg.data(), msg.size());
 }
 
 void TcpConnection::send(std::string&& msg) {
     if (!loop_->is_in_loop_thread()) {
         std::shared_ptr<TcpConnection> self = shared_from_this();
         loop_->queue_in_loop([self, msg = std::move(msg)]() {
-            self->send_in_loop(msg);
+            self->send_in_loop(msg.data(), msg.size());
             });
         return;
     }
 
-    send_in_loop(msg);
+    send_in_loop(msg.data(), msg.size());
 }
 
-void TcpConnection::send_in_loop(const std::string& msg) {
+void TcpConnection::send(const char* data, size_t len) {
+    if (!loop_->is_in_loop_thread()) {
+        // 跨线程时调用方的内存不保证存活到任务执行，只能在这里拷贝一份
+        send(std::string(data, len));
+        return;
+    }
+
+    send_in_loop(data, len);
+}
+
+void TcpConnection::send_in_loop(const char* data, size_t len) {
     assert(loop_->is_in_loop_thread());
     if (isClosed_) {
         return;
@@ -105,9 +120,9 @@ void TcpConnection::send_in_loop(const std::string& msg) {
     size_t writtenLen = 0;
     const size_t oldLen = writeBuffer_->readable_bytes();
 
-    // 场景 1：当前无积压，直接 write 写入新数据
+    // 场景 1：当前无积压，直接 send 写入新数据。各写调用都带 MSG_NOSIGNAL，对端已关闭时只返回 EPIPE
     if (oldLen == 0 && !channel_->is_writing()) {
-        const ssize_t n = ::write(connSocket_.fd(), msg.data(), msg.size());
+        const ssize_t n = ::send(connSocket_.fd(), data, len, MSG_NOSIGNAL);
 
         // 非瞬态写错误：记录日志并关闭连接
         if (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK) {
@@ -122,22 +137,25 @@ void TcpConnection::send_in_loop(const std::string& msg) {
         }
 
         // 判断是否完整写入。是：触发回调后直接返回
-        if (writtenLen == msg.size()) {
+        if (writtenLen == len) {
             handle_write_complete_callback();
             return;
         }
     }
-    // 场景 2：当前发送缓冲中已有积压，使用 writev 合并发送积压缓冲和新 msg，省去在用户态拷贝拼接的开销
+    // 场景 2：当前发送缓冲中已有积压，使用 sendmsg 聚集发送积压缓冲和新 msg，省去在用户态拷贝拼接的开销
     else if (oldLen > 0) {
         struct iovec iov[2];
         iov[0].iov_base = const_cast<char*>(writeBuffer_->readable_start_ptr());
         iov[0].iov_len = oldLen;
-        iov[1].iov_base = const_cast<char*>(msg.data());
-        iov[1].iov_len = msg.size();
+        iov[1].iov_base = const_cast<char*>(data);
+        iov[1].iov_len = len;
 
-        const ssize_t n = ::writev(connSocket_.fd(), iov, 2);
+        struct msghdr msg {};
+        msg.msg_iov = iov;
+        msg.msg_iovlen = 2;
+        const ssize_t n = ::sendmsg(connSocket_.fd(), &msg, MSG_NOSIGNAL);
         if (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK) {
-            spdlog::error("TcpConnection::send_in_loop() writev failed, errno={} ({})", errno, strerror(errno));
+            spdlog::error("TcpConnection::send_in_loop() sendmsg failed, errno={} ({})", errno, strerror(errno));
             handle_error_callback();
             close_connection(*channel_);
             return;
@@ -151,7 +169,7 @@ void TcpConnection::send_in_loop(const std::string& msg) {
                 size_t msgBytesWritten = bytesWritten - oldLen;
                 writtenLen = msgBytesWritten;
 
-                if (writtenLen == msg.size()) {
+                if (writtenLen == len) {
                     // 新旧数据全发完
                     channel_->disable_writing();
                     handle_write_complete_callback();
@@ -166,8 +184,8 @@ void TcpConnection::send_in_loop(const std::string& msg) {
     }
 
     // 将未发出数据追加到应用层发送缓冲，注册写事件驱动 Reactor 后续发送
-    if (writtenLen < msg.size()) {
-        writeBuffer_->write_to_buffer(msg.data() + writtenLen, msg.size() - writtenLen);
+    if (writtenLen < len) {
+        writeBuffer_->write_to_buffer(data + writtenLen, len - writtenLen);
     }
     channel_->enable_writing();
 
@@ -250,7 +268,7 @@ void TcpConnection::send_file_with_header_in_loop(const std::string& header, std
     }
 
     if (size == 0) {
-        send_in_loop(header);
+        send_in_loop(header.data(), header.size());
         return;
     }
 
@@ -292,6 +310,11 @@ std::string TcpConnection::receive() {
     return readBuffer_->read_from_buffer();
 }
 
+Buffer* TcpConnection::get_read_buffer() {
+    assert(loop_->is_in_loop_thread());
+    return readBuffer_.get();
+}
+
 void TcpConnection::set_tcp_no_delay(bool on) {
     connSocket_.set_tcp_no_delay(on);
 }
@@ -333,6 +356,33 @@ void TcpConnection::force_close() {
     force_close_in_loop();
 }
 
+void TcpConnection::stop_reading() {
+    std::shared_ptr<TcpConnection> self = shared_from_this();
+    loop_->run_in_loop([self]() {
+        if (!self->isClosed_ && self->channel_->is_reading()) {
+            self->channel_->disable_reading();
+        }
+        });
+}
+
+void TcpConnection::start_reading() {
+    std::shared_ptr<TcpConnection> self = shared_from_this();
+    loop_->run_in_loop([self]() {
+        if (!self->isClosed_ && !self->channel_->is_reading()) {
+            self->channel_->enable_reading();
+        }
+        });
+}
+
+void TcpConnection::retry_on_writable() {
+    assert(loop_->is_in_loop_thread());
+    if (isClosed_) {
+        return;
+    }
+    retryOnWritable_ = true;
+    channel_->enable_writing();
+}
+
 void TcpConnection::force_close_in_loop() {
     assert(loop_->is_in_loop_thread());
     close_connection(*channel_);
@@ -341,6 +391,11 @@ void TcpConnection::force_close_in_loop() {
 void TcpConnection::on_read(Channel& channel) {
     assert(loop_->is_in_loop_thread());
 
+    if (directRead_) {
+        handle_message_callback(); // 读取、EOF 与错误判定都交给上层
+        return;
+    }
+
     int savedErrno = 0;
     const ssize_t n = readBuffer_->read_from_fd(channel.get_fd(), &savedErrno);
     if (n > 0) {
@@ -398,6 +453,12 @@ void TcpConnection::on_write(Channel& channel) {
 
     channel.disable_writing();
     handle_write_complete_callback();
+
+    // 上层直写受阻时等待的可写事件：交回消息回调重试，再次受阻时由上层重新关注
+    if (retryOnWritable_ && !isClosed_) {
+        retryOnWritable_ = false;
+        handle_message_callback();
+    }
 }
 
 void TcpConnection::send_pending_file_in_loop() {
@@ -407,7 +468,12 @@ void TcpConnection::send_pending_file_in_loop() {
     }
 
     off_t offset = static_cast<off_t>(pendingFile_.offset);
-    const ssize_t n = ::sendfile(connSocket_.fd(), pendingFile_.file->fd(), &offset, pendingFile_.remaining);
+    ssize_t n = 0;
+    {
+        // sendfile 无法携带 MSG_NOSIGNAL，调用期间屏蔽本线程的 SIGPIPE
+        ScopedSigPipeBlock sigPipeBlock;
+        n = ::sendfile(connSocket_.fd(), pendingFile_.file->fd(), &offset, pendingFile_.remaining);
+    }
     if (n < 0) {
         if (errno == EAGAIN || errno == EWOULDBLOCK) {
             channel_->enable_writing();
@@ -14,6 +14,7 @@
 //     │   │       └── handle_close_callback()        # [私有] 触发服务器侧连接移除
 //     │   ├── on_write(channel)                      # [私有] 可写事件主干：刷发送缓冲
 //     │   │   ├── handle_write_complete_callback()   # [私有] 写缓冲清空时通知上层
+//     │   │   ├── handle_message_callback()          # [私有] 直写受阻的上层在 socket 可写后重试
 //     │   │   ├── handle_error_callback()            # [私有] 通知上层错误
 //     │   │   └── close_connection(channel)          # [私有] 致命写错误统一收口
 //     │   │       └── handle_close_callback()        # [私有] 触发服务器侧连接移除
@@ -24,11 +25,17 @@
 //     │       └── close_connection(channel)          # [私有] 与 read/write 错误共用收尾
 //     ├── ~TcpConnection()                       # [公有] 析构：connSocket_ 自动关闭 fd
 //     ├── send(msg)                              # [公有] 线程安全发送入口，必要时投递回所属 EventLoop
-//     │   └── send_in_loop(msg)                  # [私有] 先入写缓冲再注册写事件
+//     │   └── send_in_loop(data, len)            # [私有] 先尝试直写，剩余部分入写缓冲再注册写事件
 //     │       └── handle_high_water_mark_callback()  # [私有] 越过高水位阈值时上报背压
+//     ├── send(data, len)                        # [公有] 发送调用方持有的原始内存，loop 线程内不额外构造 string
 //     ├── receive()                              # [公有] 拉取并清空当前读缓冲中的应用层数据
+//     ├── get_read_buffer()                      # [公有] 直接暴露读缓冲，供上层原地解码免拷贝
+//     ├── set_direct_read(on)                    # [公有] 直读模式：读事件不经读缓冲，由上层自行从 fd 读取
+//     ├── retry_on_writable()                    # [公有] 上层直写 fd 受阻时关注可写事件，可写后再触发消息回调
 //     ├── force_close()                          # [公有] 主动关闭连接，供上层策略对象调用
 //     │   └── force_close_in_loop()              # [私有] 与被动关闭共用收尾路径
+//     ├── stop_reading()                         # [公有] 暂停读事件关注，供上层做接收背压
+//     ├── start_reading()                        # [公有] 恢复读事件关注
 //     ├── set_message_callback(cb)               # [公有] 注册消息回调
 //     ├── set_close_callback(cb)                 # [公有] 注册关闭回调
 //     ├── set_error_callback(cb)                 # [公有] 注册错误回调
@@ -76,9 +83,17 @@ public:
 
     void send(const std::string& msg);
     void send(std::string&& msg);
+    void send(const char* data, size_t len); // loop 线程内直接从调用方内存写出；跨线程时退化为拷贝一份再投递。
     void send_file(std::shared_ptr<ScopedFd> file, size_t size, size_t offset = 0);
     void send_file_with_header(const std::string& header, std::shared_ptr<ScopedFd> file, size_t size, size_t offset = 0);
     std::string receive();
+    Buffer* get_read_buffer(); // 仅限所属 EventLoop 线程使用：上层可原地窥探与消费，避免 receive() 的整段拷贝。
+    // 仅限所属 EventLoop 线程使用。开启后读事件只触发消息回调，由上层直接从 fd 读取（如 OpenSSL 按记录读取 kTLS socket）；
+    // epoll 为水平触发，上层必须读到 EAGAIN，并在 EOF 或读错误时 force_close()，否则读事件会反复触发。
+    void set_direct_read(bool on) { directRead_ = on; }
+    // 仅限所属 EventLoop 线程使用。上层直接写 fd 遇到 EAGAIN（如直读模式下 OpenSSL 写握手报文）时调用：
+    // 关注可写事件，发送缓冲腾出空间后再触发一次消息回调，由上层重试写出。
+    void retry_on_writable();
 
     void set_tcp_no_delay(bool on);
     void set_keep_alive(bool on);
@@ -90,6 +105,8 @@ public:
     void set_high_water_mark_callback(HighWaterMarkCallback cb, size_t highWaterMark);
 
     void force_close();
+    void stop_reading(); // 暂停读事件，内核接收缓冲填满后由 TCP 流控反压对端。
+    void start_reading(); // 恢复读事件，已关闭的连接不做任何事。
 
     EventLoop* get_loop() const { return loop_; }
     int get_fd() const { return connSocket_.fd(); }
@@ -101,7 +118,7 @@ public:
 private:
     explicit TcpConnection(EventLoop* loop, Socket connSocket, const InetAddress& localAddr, const InetAddress& peerAddr);
 
-    void send_in_loop(const std::string& msg);
+    void send_in_loop(const char* data, size_t len);
     void send_file_in_loop(std::shared_ptr<ScopedFd> file, size_t size, size_t offset);
     void send_file_with_header_in_loop(const std::string& header, std::shared_ptr<ScopedFd> file, size_t size, size_t offset);
     bool has_pending_file() const { return hasPendingFile_; }
@@ -146,5 +163,7 @@ private:
     WriteCompleteCallback writeCompleteCallback_;       // 写缓冲清空时触发（可选）。
     HighWaterMarkCallback highWaterMarkCallback_;       // 写缓冲越过高水位时触发（可选）。
 
+    bool directRead_;                                   // 直读模式：读事件不经 readBuffer_，由上层从 fd 读取。
+    bool retryOnWritable_;                              // 上层直写受阻，等待可写事件后重试。
     bool isClosed_;                                     // 是否已关闭，保证 close_connection 幂等。
 };
@@ -42,11 +42,17 @@ TcpServer::TcpServer(std::string ip, uint16_t port, size_t ioLoopNum) :
     connectionHeartbeatOptions_() {
 }
 
+TcpServer::TcpServer(const InetAddress& listenAddr, size_t ioLoopNum) :
+    TcpServer(listenAddr.get_ip(), listenAddr.get_port(), ioLoopNum) {
+    listenAddr_ = std::make_unique<InetAddress>(listenAddr);
+}
+
 TcpServer::~TcpServer() {
 }
 
 void TcpServer::start() {
-    spdlog::debug("TcpServer::start() called, starting server at {}:{}", ip_, port_);
+    const InetAddress listenAddr = listenAddr_ ? *listenAddr_ : InetAddress(ip_, port_);
+    spdlog::debug("TcpServer::start() called, starting server at {}", listenAddr.get_ip_port());
 
     // 创建并启动 IO 线程池，初始化 main loop 和 acceptor
     assert(loopThreadPool_ == nullptr);
@@ -71,7 +77,6 @@ void TcpServer::start() {
 
     // 在 main loop 所在线程创建 acceptor，监听 fd 的事件回调由 main loop 调度执行，保证线程安全。
     EventLoop& mainLoop = *loopThreadPool_->get_main_loop();
-    InetAddress listenAddr(ip_, port_);
     acceptor_ = std::make_unique<Acceptor>(&mainLoop, listenAddr);
     acceptor_->set_connect_callback([this](Socket connSocket, const InetAddress& peerAddr) {
         on_connect(std::move(connSocket), peerAddr);
@@ -199,9 +204,11 @@ TcpConnectionPtr TcpServer::create_connection(EventLoop& ioLoop,
     const InetAddress localAddr = connSocket.local_address();
     auto conn = TcpConnection::create_connection(&ioLoop, std::move(connSocket), localAddr, peerAddr);
 
-    // 配置 TCP 选项，开启 TCP_NODELAY 和 TCP keepalive。
-    conn->set_tcp_no_delay(true);
-    conn->set_keep_alive(true);
+    // 配置 TCP 选项，开启 TCP_NODELAY 和 TCP keepalive；Unix 域连接没有这些选项，对端进程退出时内核直接关闭连接。
+    if (!localAddr.is_unix()) {
+        conn->set_tcp_no_delay(true);
+        conn->set_keep_alive(true);
+    }
 
     // 配置 TcpConnection 回调，TcpServer 把 6 种 callback 从用户设置转发到每个 TcpConnection
     conn->set_message_callback([this](const TcpConnectionPtr& activeConn) {
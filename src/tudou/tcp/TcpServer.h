@@ -7,6 +7,7 @@
 // TcpServer.h
 // └── TcpServer
 //     ├── TcpServer(ip, port, ioLoopNum)         # [公有] 构造：仅记录配置，不创建任何运行时资源
+//     ├── TcpServer(listenAddr, ioLoopNum)        # [公有] 构造：按任意地址族（IPv4 / IPv6 / Unix 域）监听
 //     ├── ~TcpServer()                            # [公有] 析构：资源由成员对象统一回收
 //     ├── start()                                 # [公有] 启动线程池、创建 Acceptor 并进入主事件循环
 //     │   └── on_connect(connSocket, peerAddr)    # [私有] 绑定为 Acceptor 的新连接回调
@@ -25,8 +26,8 @@
 //     ├── set_write_complete_callback(cb)         # [公有] 注册写完成回调
 //     ├── set_high_water_mark_callback(cb, mark)  # [公有] 注册高水位回调并设置阈值
 //     ├── set_connection_heartbeat(interval, timeout) # [公有] 配置所有连接共享的空闲检测策略
-//     ├── get_ip() const                          # [公有] 返回监听 IP
-//     ├── get_port() const                        # [公有] 返回监听端口
+//     ├── get_ip() const                          # [公有] 返回监听 IP（Unix 域监听返回路径）
+//     ├── get_port() const                        # [公有] 返回监听端口（Unix 域监听为 0）
 //     └── get_num_threads() const                 # [公有] 返回线程池 loop 总数
 // ============================================================================
 
@@ -62,7 +63,10 @@ public:
     using WriteCompleteCallback = std::function<void(const TcpConnectionPtr&)>;
     using HighWaterMarkCallback = std::function<void(const TcpConnectionPtr&, size_t)>;
 
+    // ip 可为 IPv4 或 IPv6 文本；"::" 以双栈方式同时接入 IPv4 与 IPv6 客户端。
     TcpServer(std::string ip, uint16_t port, size_t ioLoopNum = 0);
+    // 同机部署的调用方可传入 InetAddress::from_unix_path() 构造的地址，经 Unix 域 socket 接入，其余流程与 TCP 一致。
+    explicit TcpServer(const InetAddress& listenAddr, size_t ioLoopNum = 0);
     ~TcpServer();
 
     void start();
@@ -123,6 +127,7 @@ private:
 
     std::string ip_;
     uint16_t port_;
+    std::unique_ptr<InetAddress> listenAddr_;      // 由 InetAddress 构造时保存完整地址，否则在 start() 时由 ip_/port_ 生成
     std::unique_ptr<Acceptor> acceptor_;
 
     // 【无锁/分片设计】
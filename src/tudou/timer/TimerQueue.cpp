@@ -21,8 +21,8 @@ namespace {
 timespec to_timespec(std::chrono::steady_clock::duration duration) {
     using namespace std::chrono;
 
-    if (duration < milliseconds(1)) { // timerfd 不允许 0 延迟，至少设 1ms
-        duration = milliseconds(1);
+    if (duration < microseconds(1)) { // timerfd 的 0 值表示解除定时，至少设 1us；亚毫秒定时器（如写合并逗留）依赖此精度
+        duration = microseconds(1);
     }
 
     auto sec = duration_cast<seconds>(duration);
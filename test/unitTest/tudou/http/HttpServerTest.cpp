@@ -108,6 +108,26 @@ public:
         return SSL_is_init_finished(ssl_) == 1;
     }
 
+    int version() const {
+        return SSL_version(ssl_);
+    }
+
+    void resume(SSL_SESSION* session) {
+        SSL_set_session(ssl_, session);
+    }
+
+    bool is_session_reused() const {
+        return SSL_session_reused(ssl_) == 1;
+    }
+
+    // 取走会话用于下次复用；TLS 1.3 票据在握手之后到达，需先读一次。标记关闭后释放不会让会话作废
+    SSL_SESSION* detach_session() {
+        std::string ignored;
+        read_plaintext(ignored);
+        SSL_set_shutdown(ssl_, SSL_SENT_SHUTDOWN | SSL_RECEIVED_SHUTDOWN);
+        return SSL_get1_session(ssl_);
+    }
+
     int feed_input(const std::string& encrypted) {
         if (encrypted.empty()) {
             return 0;
@@ -322,6 +342,29 @@ TEST(HttpServerTest, SetTlsModeAcceptsSupportedModes) {
     }
 }
 
+TEST(HttpServerTest, BufferBioConnectionStateOwnsReusableTlsBuffers) {
+    int fds[2] = { -1, -1 };
+    ASSERT_EQ(::socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+
+    EventLoop loop;
+    HttpServer server("127.0.0.1", 8080, 0);
+    ASSERT_TRUE(server.enable_ssl(cert_path("test-cert.pem"), cert_path("test-key.pem")));
+    ASSERT_TRUE(server.set_tls_mode(TlsMode::BufferBio));
+    auto conn = make_connection(loop, fds[0]);
+
+    server.on_connect(conn);
+    auto state = server.find_connection_state(conn);
+    ASSERT_NE(state, nullptr);
+    EXPECT_EQ(state->tlsMode, TlsMode::BufferBio);
+    ASSERT_NE(state->tlsConnection, nullptr);
+    EXPECT_TRUE(state->tlsConnection->uses_buffer_bio());
+    EXPECT_NE(state->tlsPlaintext, nullptr);
+    EXPECT_NE(state->tlsCiphertext, nullptr);
+
+    server.on_close(conn);
+    ::close(fds[1]);
+}
+
 TEST(HttpServerTest, KernelTlsConnectionStateUsesKernelTlsMode) {
     if (!TlsProbe::is_kernel_tls_supported()) {
         GTEST_SKIP() << "Kernel TLS is not supported on this platform, skipping test.";
@@ -558,6 +601,60 @@ TEST(HttpServerTest, ProcessBadRequestSendsBadRequestAndResetsContext) {
     ::close(fds[1]);
 }
 
+TEST(HttpServerTest, OverloadedServerRejectsWithServiceUnavailable) {
+    int fds[2] = { -1, -1 };
+    ASSERT_EQ(::socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+
+    EventLoop loop(20);
+    HttpServer server("127.0.0.1", 8080, 0);
+    AdmissionOptions options;
+    options.maxConcurrency = 1;
+    server.set_admission_options(options);
+    auto conn = make_connection(loop, fds[0]);
+    bool routeCalled = false;
+
+    server.add_get_route("/hello", [&](const HttpRequest&, HttpResponse& response) {
+        routeCalled = true;
+        response.set_status(200, "OK");
+        response.set_body("ok");
+        });
+    server.on_connect(conn);
+
+    conn->set_message_callback([&](const std::shared_ptr<TcpConnection>& activeConn) {
+        server.on_message(activeConn);
+        });
+    conn->set_write_complete_callback([&](const std::shared_ptr<TcpConnection>&) {
+        loop.quit();
+        });
+    conn->set_close_callback([&](const std::shared_ptr<TcpConnection>&) {
+        server.on_close(conn);
+        });
+
+    // 唯一的执行名额已被占用，新请求不排队而是立即得到 503，连接保持打开
+    ASSERT_TRUE(server.admission_.try_acquire(std::chrono::steady_clock::duration::zero()));
+
+    const std::string request =
+        "GET /hello HTTP/1.1\r\n"
+        "Host: example.com\r\n"
+        "\r\n";
+    ASSERT_EQ(::write(fds[1], request.data(), request.size()), static_cast<ssize_t>(request.size()));
+
+    loop.run_after(0.2, [&]() {
+        loop.quit();
+        });
+    loop.loop();
+
+    const std::string response = read_available(fds[1]);
+    EXPECT_FALSE(routeCalled);
+    EXPECT_NE(response.find("HTTP/1.1 503 Service Unavailable\r\n"), std::string::npos);
+    EXPECT_NE(response.find("Retry-After: 1\r\n"), std::string::npos);
+    EXPECT_EQ(server.get_rejected_request_count(), 1u);
+    EXPECT_FALSE(server.connectionStates_.empty());
+
+    conn->force_close();
+    ::close(fds[1]);
+}
+
 TEST(HttpServerTest, ProcessPipelinedRequests) {
     int fds[2] = { -1, -1 };
     ASSERT_EQ(::socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
@@ -619,126 +716,370 @@ TEST(HttpServerTest, ProcessPipelinedRequests) {
     ::close(fds[1]);
 }
 
-TEST(HttpServerTest, KernelTlsOffloadEnablesPlaintextTransmission) {
-    if (!TlsProbe::is_kernel_tls_supported()) {
-        GTEST_SKIP() << "Kernel TLS is not supported on this platform, skipping test.";
-    }
-
+TEST(HttpServerTest, KernelTlsServesTls13RequestWithOffloadOrFallback) {
     int fds[2] = { -1, -1 };
     ASSERT_TRUE(create_tcp_socketpair(fds));
-
-    // Ensure sockets are in non-blocking mode for our driving loop
     ::fcntl(fds[0], F_SETFL, ::fcntl(fds[0], F_GETFL, 0) | O_NONBLOCK);
     ::fcntl(fds[1], F_SETFL, ::fcntl(fds[1], F_GETFL, 0) | O_NONBLOCK);
 
     EventLoop loop;
     HttpServer server("127.0.0.1", 8080, 0);
     ASSERT_TRUE(server.enable_ssl(cert_path("test-cert.pem"), cert_path("test-key.pem")));
-    ASSERT_TRUE(server.set_tls_mode(TlsMode::KernelTls));
+    const bool kTlsSupported = server.set_tls_mode(TlsMode::KernelTls);
+    if (!kTlsSupported) {
+        // 内核不支持 kTLS 时 set_tls_mode 会拒绝，这里直接切换以覆盖 socket 直读 + 用户态加密回退路径
+        server.tlsMode_ = TlsMode::KernelTls;
+    }
 
-    // Client Peer
-    ClientTlsPeer client;
+    bool routeCalled = false;
+    server.add_get_route("/", [&](const HttpRequest&, HttpResponse& resp) {
+        routeCalled = true;
+        resp.set_status(200, "OK");
+        resp.set_body("ktls response ok");
+        });
 
+    ClientTlsPeer client;
     auto conn = make_connection(loop, fds[0]);
     server.on_connect(conn);
-
     auto state = server.find_connection_state(conn);
     ASSERT_NE(state, nullptr);
-
     conn->set_message_callback([&](const std::shared_ptr<TcpConnection>& activeConn) {
         server.on_message(activeConn);
-    });
+        });
     conn->set_close_callback([&](const std::shared_ptr<TcpConnection>&) {
         server.on_close(conn);
-    });
+        });
 
-    // Drive handshake by passing data back and forth using event loop timer
+    // 握手全程由 OpenSSL 直接读写服务端 socket；完成后立即发送请求（EventLoop 退出后不能再次进入，全程只跑一轮）。
     int rounds = 0;
     std::function<void()> driveHandshake = [&]() {
-        rounds++;
-        if (rounds > 500) {
+        if (++rounds > 200) {
             loop.quit();
             return;
         }
 
-        if (!client.is_established()) {
-            client.advance_handshake();
+        if (client.is_established() && state->tlsConnection->is_established()) {
+            std::string encryptedRequest;
+            ASSERT_GT(client.write_plaintext("GET / HTTP/1.1\r\nHost: localhost\r\n\r\n", encryptedRequest), 0);
+            (void)::write(fds[1], encryptedRequest.data(), encryptedRequest.size());
+            loop.run_after(0.1, [&]() {
+                loop.quit();
+                });
+            return;
         }
 
-        std::string clientOut = client.take_output();
+        client.advance_handshake();
+        const std::string clientOut = client.take_output();
         if (!clientOut.empty()) {
             (void)::write(fds[1], clientOut.data(), clientOut.size());
         }
-
-        std::string toClient = read_available(fds[1]);
+        const std::string toClient = read_all_available(fds[1]);
         if (!toClient.empty()) {
             client.feed_input(toClient);
-            client.advance_handshake();
         }
+        loop.run_after(0.005, driveHandshake);
+    };
+    loop.run_after(0.005, driveHandshake);
+    loop.loop();
+
+    ASSERT_TRUE(client.is_established());
+    EXPECT_EQ(client.version(), TLS1_3_VERSION);
+    EXPECT_TRUE(routeCalled);
+    EXPECT_EQ(state->isKtlsOffloaded, state->tlsConnection->is_ktls_send_offloaded());
+    if (!kTlsSupported) {
+        EXPECT_FALSE(state->isKtlsOffloaded);
+        EXPECT_FALSE(state->tlsConnection->is_ktls_recv_offloaded());
+    }
+
+    // 无论内核加密还是用户态回退，线上都只有标准 TLS 记录，客户端可直接解密，且不含任何额外字节
+    ASSERT_GT(client.feed_input(read_all_available(fds[1])), 0);
+    std::string decryptedResponse;
+    ASSERT_GT(client.read_plaintext(decryptedResponse), 0);
+    EXPECT_EQ(decryptedResponse.rfind("HTTP/1.1 200 OK\r\n", 0), 0U);
+    EXPECT_NE(decryptedResponse.find("ktls response ok"), std::string::npos);
+    EXPECT_EQ(conn->get_read_buffer()->readable_bytes(), 0U);
+
+    conn->force_close();
+    ::close(fds[1]);
+}
+
+TEST(HttpServerTest, KernelTlsQueuesResponsesProducedDuringHandshake) {
+    int fds[2] = { -1, -1 };
+    ASSERT_TRUE(create_tcp_socketpair(fds));
+    ::fcntl(fds[0], F_SETFL, ::fcntl(fds[0], F_GETFL, 0) | O_NONBLOCK);
+    ::fcntl(fds[1], F_SETFL, ::fcntl(fds[1], F_GETFL, 0) | O_NONBLOCK);
+
+    EventLoop loop;
+    HttpServer server("127.0.0.1", 8080, 0);
+    ASSERT_TRUE(server.enable_ssl(cert_path("test-cert.pem"), cert_path("test-key.pem")));
+    if (!server.set_tls_mode(TlsMode::KernelTls)) {
+        server.tlsMode_ = TlsMode::KernelTls;
+    }
 
-        // Exit loop once client is established and server has processed offloading (either succeeded or fell back)
-        if (client.is_established() && (state->isKtlsOffloaded || state->tlsMode == TlsMode::MemoryBio)) {
+    ClientTlsPeer client;
+    auto conn = make_connection(loop, fds[0]);
+    server.on_connect(conn);
+    auto state = server.find_connection_state(conn);
+    ASSERT_NE(state, nullptr);
+    conn->set_message_callback([&](const std::shared_ptr<TcpConnection>& activeConn) {
+        server.on_message(activeConn);
+        });
+    conn->set_close_callback([&](const std::shared_ptr<TcpConnection>&) {
+        server.on_close(conn);
+        });
+
+    // 握手尚未开始时产生的两个响应（内存体 + 文件体）都应排队，而不是写出明文或被丢弃
+    char path[] = "/tmp/tudou-http-ktls-queued-file-XXXXXX";
+    const int fileFd = ::mkstemp(path);
+    ASSERT_GE(fileFd, 0);
+    ASSERT_EQ(::unlink(path), 0);
+    const std::string fileBody(64 * 1024, 'f');
+    ASSERT_EQ(::write(fileFd, fileBody.data(), fileBody.size()), static_cast<ssize_t>(fileBody.size()));
+
+    HttpResponse early = HttpResponse::plain_text(200, "OK", "queued before handshake");
+    early.set_close_connection(false);
+    HttpResponse fileResponse;
+    fileResponse.set_status(200, "OK");
+    fileResponse.set_file_body(std::make_shared<ScopedFd>(fileFd), fileBody.size());
+    server.send_http_response(conn, *state, early);
+    server.send_http_response(conn, *state, fileResponse);
+    EXPECT_EQ(state->pendingTlsResponses.size(), 2U);
+    EXPECT_TRUE(read_all_available(fds[1]).empty());
+
+    // 握手完成后由服务端自动补发；客户端持续读取直到收齐两个响应
+    std::string decrypted;
+    int rounds = 0;
+    std::function<void()> drive = [&]() {
+        if (++rounds > 400 || decrypted.size() >= fileBody.size()) {
             loop.quit();
             return;
         }
-
-        loop.run_after(0.005, driveHandshake);
+        if (!client.is_established()) {
+            client.advance_handshake();
+        }
+        const std::string clientOut = client.take_output();
+        if (!clientOut.empty()) {
+            (void)::write(fds[1], clientOut.data(), clientOut.size());
+        }
+        const std::string toClient = read_all_available(fds[1]);
+        if (!toClient.empty()) {
+            client.feed_input(toClient);
+        }
+        if (client.is_established()) {
+            client.read_plaintext(decrypted);
+        }
+        loop.run_after(0.005, drive);
     };
-
-    loop.run_after(0.005, driveHandshake);
+    loop.run_after(0.005, drive);
     loop.loop();
 
     ASSERT_TRUE(client.is_established());
+    EXPECT_TRUE(state->pendingTlsResponses.empty());
+    const size_t first = decrypted.find("queued before handshake");
+    const size_t second = decrypted.find("Content-Length: " + std::to_string(fileBody.size()) + "\r\n");
+    ASSERT_NE(first, std::string::npos);
+    ASSERT_NE(second, std::string::npos);
+    EXPECT_LT(first, second);
+    EXPECT_NE(decrypted.find("\r\n\r\n" + fileBody), std::string::npos);
 
-    // 4. Verify transmission depending on offload result
-    if (state->isKtlsOffloaded) {
-        // Read and discard the 1-byte space sent by OpenSSL to trigger kTLS configuration
-        ::usleep(10000);
-        std::string junkResponse = read_available(fds[1]);
-        ASSERT_FALSE(junkResponse.empty());
-        ASSERT_GT(client.feed_input(junkResponse), 0);
-        std::string junkPlaintext;
-        EXPECT_GT(client.read_plaintext(junkPlaintext), 0);
-        EXPECT_EQ(junkPlaintext, " ");
-
-        // Register a simple route for verifying the kTLS response
-        bool routeCalled = false;
-        server.add_get_route("/", [&](const HttpRequest& req, HttpResponse& resp) {
-            (void)req;
-            routeCalled = true;
-            resp.set_status(200, "OK");
-            resp.set_body("ktls response ok");
+    conn->force_close();
+    ::close(fds[1]);
+}
+
+TEST(HttpServerTest, BufferBioServesPipelinedHttpsRequests) {
+    int fds[2] = { -1, -1 };
+    ASSERT_EQ(::socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, fds), 0);
+
+    EventLoop loop;
+    HttpServer server("127.0.0.1", 8080, 0);
+    ASSERT_TRUE(server.enable_ssl(cert_path("test-cert.pem"), cert_path("test-key.pem")));
+    ASSERT_TRUE(server.set_tls_mode(TlsMode::BufferBio));
+
+    int routeCalls = 0;
+    server.add_get_route("/first", [&](const HttpRequest&, HttpResponse& resp) {
+        ++routeCalls;
+        resp.set_status(200, "OK");
+        resp.set_body("first over buffer bio");
+        });
+    server.add_get_route("/second", [&](const HttpRequest&, HttpResponse& resp) {
+        ++routeCalls;
+        resp.set_status(200, "OK");
+        resp.set_body("second over buffer bio");
         });
 
-        // Client sends an encrypted request
-        std::string request = "GET / HTTP/1.1\r\nHost: localhost\r\n\r\n";
-        std::string encryptedRequest;
-        ASSERT_TRUE(client.write_plaintext(request, encryptedRequest));
-        ASSERT_GT(::write(fds[1], encryptedRequest.data(), encryptedRequest.size()), 0);
+    ClientTlsPeer client;
+    auto conn = make_connection(loop, fds[0]);
+    server.on_connect(conn);
+    conn->set_message_callback([&](const std::shared_ptr<TcpConnection>& activeConn) {
+        server.on_message(activeConn);
+        });
+    conn->set_close_callback([&](const std::shared_ptr<TcpConnection>&) {
+        server.on_close(conn);
+        });
 
-        // Run loop to let TcpConnection read, decrypt (via kernel RX), parse, and respond
-        loop.run_after(0.05, [&]() {
+    // 握手：客户端密文写入 socket，服务端经 Buffer BIO 直接消费连接读缓冲。
+    // 握手完成后把两个请求合并成一次写入，验证明文缓冲上的管道化解析（EventLoop 退出后不能再次进入，全程只跑一轮）。
+    std::string encryptedRequests;
+    int rounds = 0;
+    std::function<void()> driveHandshake = [&]() {
+        if (++rounds > 200) {
             loop.quit();
-        });
-        loop.loop();
+            return;
+        }
 
-        EXPECT_TRUE(routeCalled);
+        if (client.is_established()) {
+            std::string encrypted;
+            if (client.write_plaintext("GET /first HTTP/1.1\r\nHost: localhost\r\n\r\n", encrypted) > 0) {
+                encryptedRequests += encrypted;
+            }
+            if (client.write_plaintext("GET /second HTTP/1.1\r\nHost: localhost\r\n\r\n", encrypted) > 0) {
+                encryptedRequests += encrypted;
+            }
+            (void)::write(fds[1], encryptedRequests.data(), encryptedRequests.size());
+            loop.run_after(0.1, [&]() {
+                loop.quit();
+                });
+            return;
+        }
 
-        // Read response from client fd.
-        // Due to kTLS TX offload, the kernel encrypted it, so we read TLS ciphertext bytes.
-        std::string encryptedResponse = read_all_available(fds[1]);
-        ASSERT_FALSE(encryptedResponse.empty());
+        client.advance_handshake();
+        const std::string clientOut = client.take_output();
+        if (!clientOut.empty()) {
+            (void)::write(fds[1], clientOut.data(), clientOut.size());
+        }
+        const std::string toClient = read_all_available(fds[1]);
+        if (!toClient.empty()) {
+            client.feed_input(toClient);
+        }
+        loop.run_after(0.005, driveHandshake);
+    };
+    loop.run_after(0.005, driveHandshake);
+    loop.loop();
+    ASSERT_TRUE(client.is_established());
+    ASSERT_FALSE(encryptedRequests.empty());
 
-        // Client decrypts the response bytes
-        ASSERT_GT(client.feed_input(encryptedResponse), 0);
-        std::string decryptedResponse;
-        EXPECT_GT(client.read_plaintext(decryptedResponse), 0);
-        EXPECT_NE(decryptedResponse.find("HTTP/1.1 200 OK\r\n"), std::string::npos);
-        EXPECT_NE(decryptedResponse.find("ktls response ok"), std::string::npos);
-    } else {
-        SUCCEED() << "kTLS offloading is not fully supported in this restricted test environment (expected in sandbox containers). Skipping transmission check.";
-    }
+    EXPECT_EQ(routeCalls, 2);
+    ASSERT_GT(client.feed_input(read_all_available(fds[1])), 0);
+    std::string decryptedResponses;
+    ASSERT_GT(client.read_plaintext(decryptedResponses), 0);
+    const size_t first = decryptedResponses.find("first over buffer bio");
+    const size_t second = decryptedResponses.find("second over buffer bio");
+    ASSERT_NE(first, std::string::npos);
+    ASSERT_NE(second, std::string::npos);
+    EXPECT_LT(first, second);
+
+    auto state = server.find_connection_state(conn);
+    ASSERT_NE(state, nullptr);
+    EXPECT_EQ(conn->get_read_buffer()->readable_bytes(), 0U);
+    EXPECT_EQ(state->tlsPlaintext->readable_bytes(), 0U);
+    EXPECT_EQ(state->tlsCiphertext->readable_bytes(), 0U);
 
     conn->force_close();
     ::close(fds[1]);
 }
+
+TEST(HttpServerTest, SharedSessionCacheResumesAcrossConnections) {
+    HttpServer server("127.0.0.1", 8080, 0);
+    TlsSessionOptions options;
+    options.enableTickets = false;
+    options.enableSessionCache = true;
+    ASSERT_TRUE(server.set_tls_session_options(options));
+    ASSERT_TRUE(server.enable_ssl(cert_path("test-cert.pem"), cert_path("test-key.pem")));
+
+    SSL_SESSION* session = nullptr;
+    {
+        ClientTlsPeer client;
+        TlsConnection tls(server.tlsConfig_->create_ssl());
+        ASSERT_TRUE(complete_handshake(client, tls));
+        session = client.detach_session();
+        ASSERT_NE(session, nullptr);
+        // 服务端连接未收到 close_notify 就析构，会话仍须留在共享缓存里
+    }
+
+    {
+        ClientTlsPeer client;
+        client.resume(session);
+        TlsConnection tls(server.tlsConfig_->create_ssl());
+        ASSERT_TRUE(complete_handshake(client, tls));
+        EXPECT_TRUE(client.is_session_reused());
+    }
+    SSL_SESSION_free(session);
+
+    const TlsSessionStats stats = server.get_tls_session_stats();
+    EXPECT_EQ(stats.handshakes, 2u);
+    EXPECT_EQ(stats.resumed, 1u);
+    EXPECT_DOUBLE_EQ(stats.hit_rate(), 0.5);
+}
+
+TEST(HttpServerTest, OffloadedHandshakeServesHttpsRequests) {
+    for (const TlsMode mode : { TlsMode::MemoryBio, TlsMode::BufferBio }) {
+        int fds[2] = { -1, -1 };
+        ASSERT_EQ(::socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, fds), 0);
+
+        EventLoop loop;
+        HttpServer server("127.0.0.1", 8080, 0);
+        ASSERT_TRUE(server.enable_ssl(cert_path("test-cert.pem"), cert_path("test-key.pem")));
+        ASSERT_TRUE(server.set_tls_mode(mode));
+        server.set_tls_handshake_threads(1);
+        server.add_get_route("/offload", [](const HttpRequest&, HttpResponse& resp) {
+            resp.set_status(200, "OK");
+            resp.set_body("handshake offloaded");
+            });
+
+        ClientTlsPeer client;
+        auto conn = make_connection(loop, fds[0]);
+        server.on_connect(conn);
+        conn->set_message_callback([&](const std::shared_ptr<TcpConnection>& activeConn) {
+            server.on_message(activeConn);
+            });
+        conn->set_close_callback([&](const std::shared_ptr<TcpConnection>&) {
+            server.on_close(conn);
+            });
+
+        // 握手步骤在加密线程执行，结果经 queue_in_loop 回到本 loop；客户端在 Finished 之后立刻发出请求
+        std::string decrypted;
+        bool requestSent = false;
+        int rounds = 0;
+        std::function<void()> drive = [&]() {
+            if (++rounds > 400 || decrypted.find("handshake offloaded") != std::string::npos) {
+                loop.quit();
+                return;
+            }
+
+            client.advance_handshake();
+            std::string clientOut = client.take_output();
+            if (client.is_established() && !requestSent) {
+                std::string encrypted;
+                if (client.write_plaintext("GET /offload HTTP/1.1\r\nHost: localhost\r\n\r\n", encrypted) > 0) {
+                    clientOut += encrypted;
+                    requestSent = true;
+                }
+            }
+            if (!clientOut.empty()) {
+                (void)::write(fds[1], clientOut.data(), clientOut.size());
+            }
+            const std::string toClient = read_all_available(fds[1]);
+            if (!toClient.empty()) {
+                client.feed_input(toClient);
+                if (client.is_established()) {
+                    client.read_plaintext(decrypted);
+                }
+            }
+            loop.run_after(0.005, drive);
+        };
+        loop.run_after(0.005, drive);
+        loop.loop();
+
+        EXPECT_TRUE(client.is_established());
+        EXPECT_NE(decrypted.find("handshake offloaded"), std::string::npos) << "mode=" << static_cast<int>(mode);
+        EXPECT_GT(server.get_offloaded_handshake_steps(), 0u);
+
+        auto state = server.find_connection_state(conn);
+        ASSERT_NE(state, nullptr);
+        EXPECT_FALSE(state->handshakeInFlight);
+        EXPECT_TRUE(state->tlsConnection->is_established());
+
+        server.on_close(conn);
+        ::close(fds[1]);
+    }
+}
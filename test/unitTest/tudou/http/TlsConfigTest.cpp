@@ -1,8 +1,15 @@
 #include <gtest/gtest.h>
 
 #include <openssl/ssl.h>
+#include <openssl/x509.h>
 
+#include <atomic>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
 #include <string>
+#include <thread>
+#include <vector>
 
 #include "tudou/http/TlsConfig.h"
 
@@ -12,6 +19,81 @@ std::string cert_path(const char* fileName) {
     return std::string(TUDOU_SOURCE_DIR) + "/certs/" + fileName;
 }
 
+struct HandshakeResult {
+    bool completed = false;
+    bool reused = false;
+    SSL_SESSION* session = nullptr; // 客户端拿到的会话（含票据），由调用方释放。
+    std::string peerName;           // 服务端出示的证书 CN。
+};
+
+std::string common_name(X509* cert) {
+    char name[256] = {};
+    if (cert) {
+        X509_NAME_get_text_by_NID(X509_get_subject_name(cert), NID_commonName, name, sizeof(name));
+    }
+    return name;
+}
+
+void copy_file(const std::string& from, const std::string& to) {
+    std::ifstream in(from, std::ios::binary);
+    std::ofstream out(to, std::ios::binary | std::ios::trunc);
+    out << in.rdbuf();
+}
+
+// 客户端与服务端经 BIO 对在内存中完成一次握手，可选携带上次的会话尝试复用。
+HandshakeResult run_handshake(const TlsConfig& config, SSL_CTX* clientCtx, SSL_SESSION* resume, const char* serverName = nullptr) {
+    HandshakeResult result;
+    SSL* server = config.create_ssl();
+    SSL* client = SSL_new(clientCtx);
+    BIO* serverBio = nullptr;
+    BIO* clientBio = nullptr;
+    BIO_new_bio_pair(&serverBio, 0, &clientBio, 0);
+    SSL_set_bio(server, serverBio, serverBio);
+    SSL_set_bio(client, clientBio, clientBio);
+    SSL_set_accept_state(server);
+    SSL_set_connect_state(client);
+    if (resume) {
+        SSL_set_session(client, resume);
+    }
+    if (serverName) {
+        SSL_set_tlsext_host_name(client, serverName);
+    }
+
+    bool serverDone = false;
+    bool clientDone = false;
+    for (int round = 0; round < 32 && !(serverDone && clientDone); ++round) {
+        clientDone = clientDone || SSL_do_handshake(client) == 1;
+        serverDone = serverDone || SSL_do_handshake(server) == 1;
+    }
+
+    if (serverDone && clientDone) {
+        TlsConfig::record_handshake(server);
+        // TLS 1.3 的票据在握手之后才发送，客户端需要再读一次才能收到
+        char byte = 0;
+        SSL_read(client, &byte, 1);
+        result.completed = true;
+        result.reused = SSL_session_reused(server) == 1;
+        result.session = SSL_get1_session(client);
+        X509* peer = SSL_get1_peer_certificate(client);
+        result.peerName = common_name(peer);
+        X509_free(peer);
+        // 未标记关闭就释放会被 OpenSSL 视为异常断开，会话随之作废
+        SSL_set_shutdown(client, SSL_SENT_SHUTDOWN | SSL_RECEIVED_SHUTDOWN);
+        SSL_set_shutdown(server, SSL_SENT_SHUTDOWN | SSL_RECEIVED_SHUTDOWN);
+    }
+
+    SSL_free(client);
+    SSL_free(server);
+    return result;
+}
+
+SSL_CTX* create_client_ctx(int maxVersion) {
+    SSL_CTX* ctx = SSL_CTX_new(TLS_client_method());
+    SSL_CTX_set_max_proto_version(ctx, maxVersion);
+    SSL_CTX_set_session_cache_mode(ctx, SSL_SESS_CACHE_CLIENT);
+    return ctx;
+}
+
 } // namespace
 
 TEST(TlsConfigTest, InitWithValidCertificateCreatesServerSsl) {
@@ -35,3 +117,264 @@ TEST(TlsConfigTest, FailedReinitializationClearsPreviousContext) {
     EXPECT_FALSE(context.is_initialized());
     EXPECT_EQ(context.create_ssl(), nullptr);
 }
+
+TEST(TlsConfigTest, SessionTicketsResumeHandshakesAndCountHits) {
+    for (const int version : { TLS1_2_VERSION, TLS1_3_VERSION }) {
+        TlsConfig context;
+        ASSERT_TRUE(context.init(cert_path("test-cert.pem"), cert_path("test-key.pem")));
+        SSL_CTX* clientCtx = create_client_ctx(version);
+
+        HandshakeResult full = run_handshake(context, clientCtx, nullptr);
+        ASSERT_TRUE(full.completed);
+        EXPECT_FALSE(full.reused);
+        ASSERT_NE(full.session, nullptr);
+
+        HandshakeResult resumed = run_handshake(context, clientCtx, full.session);
+        ASSERT_TRUE(resumed.completed);
+        EXPECT_TRUE(resumed.reused) << "version=" << version;
+
+        // 复用后续发的票据可以继续复用（TLS 1.3 客户端不会重复使用同一张票据）
+        HandshakeResult chained = run_handshake(context, clientCtx, resumed.session);
+        ASSERT_TRUE(chained.completed);
+        EXPECT_TRUE(chained.reused) << "version=" << version;
+
+        const TlsSessionStats stats = context.get_session_stats();
+        EXPECT_EQ(stats.handshakes, 3u);
+        EXPECT_EQ(stats.resumed, 2u);
+        EXPECT_DOUBLE_EQ(stats.hit_rate(), 2.0 / 3.0);
+
+        SSL_SESSION_free(chained.session);
+        SSL_SESSION_free(resumed.session);
+        SSL_SESSION_free(full.session);
+        SSL_CTX_free(clientCtx);
+    }
+}
+
+TEST(TlsConfigTest, SharedSessionCacheResumesWithoutTickets) {
+    for (const int version : { TLS1_2_VERSION, TLS1_3_VERSION }) {
+        TlsConfig context;
+        TlsSessionOptions options;
+        options.enableTickets = false;
+        options.enableSessionCache = true;
+        ASSERT_TRUE(context.configure_sessions(options));
+        ASSERT_TRUE(context.init(cert_path("test-cert.pem"), cert_path("test-key.pem")));
+        SSL_CTX* clientCtx = create_client_ctx(version);
+
+        HandshakeResult full = run_handshake(context, clientCtx, nullptr);
+        ASSERT_TRUE(full.completed);
+        ASSERT_NE(full.session, nullptr);
+
+        HandshakeResult resumed = run_handshake(context, clientCtx, full.session);
+        ASSERT_TRUE(resumed.completed);
+        EXPECT_TRUE(resumed.reused) << "version=" << version;
+        EXPECT_EQ(context.get_session_stats().resumed, 1u);
+
+        SSL_SESSION_free(resumed.session);
+        SSL_SESSION_free(full.session);
+        SSL_CTX_free(clientCtx);
+    }
+}
+
+TEST(TlsConfigTest, DisablingTicketsAndCacheForcesFullHandshakes) {
+    TlsConfig context;
+    TlsSessionOptions options;
+    options.enableTickets = false;
+    ASSERT_TRUE(context.init(cert_path("test-cert.pem"), cert_path("test-key.pem")));
+    ASSERT_TRUE(context.configure_sessions(options));
+    SSL_CTX* clientCtx = create_client_ctx(TLS1_3_VERSION);
+
+    HandshakeResult full = run_handshake(context, clientCtx, nullptr);
+    ASSERT_TRUE(full.completed);
+    HandshakeResult again = run_handshake(context, clientCtx, full.session);
+    ASSERT_TRUE(again.completed);
+    EXPECT_FALSE(again.reused);
+    EXPECT_EQ(context.get_session_stats().resumed, 0u);
+
+    SSL_SESSION_free(again.session);
+    SSL_SESSION_free(full.session);
+    SSL_CTX_free(clientCtx);
+}
+
+TEST(TlsConfigTest, RotatedTicketKeyStillDecryptsUntilRetired) {
+    TlsConfig context;
+    ASSERT_TRUE(context.init(cert_path("test-cert.pem"), cert_path("test-key.pem")));
+    SSL_CTX* clientCtx = create_client_ctx(TLS1_3_VERSION);
+
+    HandshakeResult full = run_handshake(context, clientCtx, nullptr);
+    ASSERT_TRUE(full.completed);
+
+    // 轮换一次：旧票据由上一把密钥解密，仍可复用
+    context.rotate_ticket_keys();
+    HandshakeResult afterOne = run_handshake(context, clientCtx, full.session);
+    ASSERT_TRUE(afterOne.completed);
+    EXPECT_TRUE(afterOne.reused);
+
+    // 再轮换两次：签发旧票据的密钥已退出密钥环，只能完整握手
+    context.rotate_ticket_keys();
+    context.rotate_ticket_keys();
+    HandshakeResult afterThree = run_handshake(context, clientCtx, full.session);
+    ASSERT_TRUE(afterThree.completed);
+    EXPECT_FALSE(afterThree.reused);
+
+    const TlsSessionStats stats = context.get_session_stats();
+    EXPECT_EQ(stats.ticketKeyRotations, 3u);
+    EXPECT_EQ(stats.resumed, 1u);
+
+    SSL_SESSION_free(afterThree.session);
+    SSL_SESSION_free(afterOne.session);
+    SSL_SESSION_free(full.session);
+    SSL_CTX_free(clientCtx);
+}
+
+TEST(TlsConfigTest, ReloadSwapsCertificateForNewConnectionsOnly) {
+    const std::string certFile = ::testing::TempDir() + "tudou-reload-cert.pem";
+    const std::string keyFile = ::testing::TempDir() + "tudou-reload-key.pem";
+    copy_file(cert_path("test-cert.pem"), certFile);
+    copy_file(cert_path("test-key.pem"), keyFile);
+
+    TlsConfig context;
+    ASSERT_TRUE(context.init(certFile, keyFile));
+    SSL* before = context.create_ssl();
+    ASSERT_NE(before, nullptr);
+    EXPECT_EQ(common_name(SSL_get_certificate(before)), "localhost");
+
+    // 原路径上的证书被替换（如证书续期）后热加载
+    copy_file(cert_path("test-sni-cert.pem"), certFile);
+    copy_file(cert_path("test-sni-key.pem"), keyFile);
+    ASSERT_TRUE(context.reload());
+
+    // 重载前创建的连接继续使用旧上下文，新连接拿到新证书并能完成握手
+    EXPECT_EQ(common_name(SSL_get_certificate(before)), "localhost");
+    SSL_CTX* clientCtx = create_client_ctx(TLS1_3_VERSION);
+    HandshakeResult after = run_handshake(context, clientCtx, nullptr);
+    ASSERT_TRUE(after.completed);
+    EXPECT_EQ(after.peerName, "api.tudou.test");
+
+    SSL_SESSION_free(after.session);
+    SSL_CTX_free(clientCtx);
+    SSL_free(before);
+    std::remove(certFile.c_str());
+    std::remove(keyFile.c_str());
+}
+
+TEST(TlsConfigTest, ReloadKeepsTicketKeysAndSessionCache) {
+    // 分别覆盖无状态票据与共享会话缓存：重载前签发的会话在重载后仍可复用
+    for (const bool useTickets : { true, false }) {
+        for (const int version : { TLS1_2_VERSION, TLS1_3_VERSION }) {
+            TlsConfig context;
+            TlsSessionOptions options;
+            options.enableTickets = useTickets;
+            options.enableSessionCache = !useTickets;
+            ASSERT_TRUE(context.configure_sessions(options));
+            ASSERT_TRUE(context.init(cert_path("test-cert.pem"), cert_path("test-key.pem")));
+            SSL_CTX* clientCtx = create_client_ctx(version);
+
+            HandshakeResult full = run_handshake(context, clientCtx, nullptr);
+            ASSERT_TRUE(full.completed);
+            ASSERT_NE(full.session, nullptr);
+
+            ASSERT_TRUE(context.reload());
+            HandshakeResult resumed = run_handshake(context, clientCtx, full.session);
+            ASSERT_TRUE(resumed.completed);
+            EXPECT_TRUE(resumed.reused) << "tickets=" << useTickets << " version=" << version;
+
+            SSL_SESSION_free(resumed.session);
+            SSL_SESSION_free(full.session);
+            SSL_CTX_free(clientCtx);
+        }
+    }
+}
+
+TEST(TlsConfigTest, FailedReloadKeepsPreviousCertificates) {
+    const std::string certFile = ::testing::TempDir() + "tudou-broken-cert.pem";
+    copy_file(cert_path("test-cert.pem"), certFile);
+
+    TlsConfig context;
+    ASSERT_TRUE(context.init(certFile, cert_path("test-key.pem")));
+
+    // 证书文件被写坏：重载失败，已发布的证书不受影响
+    std::ofstream(certFile, std::ios::trunc) << "not a certificate";
+    EXPECT_FALSE(context.reload());
+    EXPECT_TRUE(context.is_initialized());
+
+    SSL_CTX* clientCtx = create_client_ctx(TLS1_3_VERSION);
+    HandshakeResult result = run_handshake(context, clientCtx, nullptr);
+    ASSERT_TRUE(result.completed);
+    EXPECT_EQ(result.peerName, "localhost");
+
+    SSL_SESSION_free(result.session);
+    SSL_CTX_free(clientCtx);
+    std::remove(certFile.c_str());
+}
+
+TEST(TlsConfigTest, SelectsCertificateBySniHostName) {
+    TlsConfig context;
+    ASSERT_TRUE(context.init(cert_path("test-cert.pem"), cert_path("test-key.pem")));
+    ASSERT_TRUE(context.add_certificate("*.tudou.test", cert_path("test-sni-cert.pem"), cert_path("test-sni-key.pem")));
+    EXPECT_FALSE(context.add_certificate("", cert_path("test-sni-cert.pem"), cert_path("test-sni-key.pem")));
+    EXPECT_FALSE(context.add_certificate("bad.tudou.test", cert_path("missing-cert.pem"), cert_path("test-sni-key.pem")));
+
+    SSL_CTX* clientCtx = create_client_ctx(TLS1_3_VERSION);
+    const struct {
+        const char* serverName;
+        const char* expected;
+    } cases[] = {
+        { "api.tudou.test", "api.tudou.test" },
+        { "WWW.Tudou.Test", "api.tudou.test" },  // 主机名不区分大小写
+        { "a.b.tudou.test", "localhost" },       // 通配符只匹配一级
+        { "tudou.test", "localhost" },
+        { "example.com", "localhost" },          // 未匹配回落到默认证书
+        { nullptr, "localhost" },                // 未携带 SNI
+    };
+    for (const auto& testCase : cases) {
+        HandshakeResult result = run_handshake(context, clientCtx, nullptr, testCase.serverName);
+        ASSERT_TRUE(result.completed);
+        EXPECT_EQ(result.peerName, testCase.expected) << (testCase.serverName ? testCase.serverName : "<none>");
+        SSL_SESSION_free(result.session);
+    }
+
+    // 重载保留 SNI 证书
+    ASSERT_TRUE(context.reload());
+    HandshakeResult reloaded = run_handshake(context, clientCtx, nullptr, "api.tudou.test");
+    ASSERT_TRUE(reloaded.completed);
+    EXPECT_EQ(reloaded.peerName, "api.tudou.test");
+    SSL_SESSION_free(reloaded.session);
+    SSL_CTX_free(clientCtx);
+}
+
+TEST(TlsConfigTest, ConcurrentReloadKeepsPinnedSnapshotsAlive) {
+    TlsConfig context;
+    ASSERT_TRUE(context.init(cert_path("test-cert.pem"), cert_path("test-key.pem")));
+    ASSERT_TRUE(context.add_certificate("*.tudou.test", cert_path("test-sni-cert.pem"), cert_path("test-sni-key.pem")));
+
+    // 读者持续建连与按 SNI 握手，写者反复重载：被替换的快照在读者放下引用后立即释放，读者从不访问已释放的快照
+    std::atomic<bool> stop{ false };
+    std::atomic<int> failures{ 0 };
+    std::vector<std::thread> readers;
+    for (int i = 0; i < 3; ++i) {
+        readers.emplace_back([&context, &stop, &failures]() {
+            SSL_CTX* clientCtx = create_client_ctx(TLS1_3_VERSION);
+            while (!stop.load()) {
+                SSL* ssl = context.create_ssl();
+                if (!ssl) {
+                    ++failures;
+                }
+                SSL_free(ssl);
+                HandshakeResult result = run_handshake(context, clientCtx, nullptr, "api.tudou.test");
+                if (!result.completed || result.peerName != "api.tudou.test") {
+                    ++failures;
+                }
+                SSL_SESSION_free(result.session);
+            }
+            SSL_CTX_free(clientCtx);
+        });
+    }
+    for (int i = 0; i < 20; ++i) {
+        EXPECT_TRUE(context.reload());
+    }
+    stop = true;
+    for (std::thread& reader : readers) {
+        reader.join();
+    }
+    EXPECT_EQ(failures.load(), 0);
+}
@@ -1,11 +1,14 @@
 #include <gtest/gtest.h>
 
 #include <openssl/ssl.h>
+#include <sys/socket.h>
+#include <unistd.h>
 
 #include <string>
 
 #include "tudou/http/TlsConfig.h"
 #include "tudou/http/TlsConnection.h"
+#include "tudou/tcp/Buffer.h"
 
 namespace {
 
@@ -92,6 +95,18 @@ public:
         return SSL_write(ssl_, plaintext.data(), static_cast<int>(plaintext.size())) > 0;
     }
 
+    bool request_key_update() {
+        return SSL_key_update(ssl_, SSL_KEY_UPDATE_REQUESTED) == 1;
+    }
+
+    bool send_close_notify() {
+        return SSL_shutdown(ssl_) >= 0;
+    }
+
+    int version() const {
+        return SSL_version(ssl_);
+    }
+
     int read_plaintext(std::string& plaintext) {
         char buffer[4096];
         int totalRead = 0;
@@ -150,6 +165,74 @@ bool complete_handshake(ClientTlsPeer& client, TlsConnection& server) {
     return false;
 }
 
+bool complete_buffer_bio_handshake(ClientTlsPeer& client, TlsConnection& server) {
+    Buffer inbound;
+    Buffer plaintext;
+    Buffer outbound;
+    for (int round = 0; round < 32; ++round) {
+        if (!client.is_established() && !client.advance_handshake()) {
+            return false;
+        }
+
+        inbound.write_to_buffer(client.take_output());
+        if (server.read_plaintext(inbound, plaintext, outbound) == TlsConnection::ReadResult::Error
+            || plaintext.readable_bytes() != 0) {
+            return false;
+        }
+        if (outbound.readable_bytes() > 0 && client.feed_input(outbound.read_from_buffer()) < 0) {
+            return false;
+        }
+
+        if (client.is_established() && server.is_established()) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+std::string read_socket(int fd) {
+    std::string output;
+    char buffer[4096];
+    ssize_t n = 0;
+    while ((n = ::read(fd, buffer, sizeof(buffer))) > 0) {
+        output.append(buffer, static_cast<size_t>(n));
+    }
+    return output;
+}
+
+bool write_socket(int fd, const std::string& data) {
+    return data.empty() || ::write(fd, data.data(), data.size()) == static_cast<ssize_t>(data.size());
+}
+
+// 服务端 OpenSSL 直接读写 fds[0]，客户端经 fds[1] 收发密文
+bool complete_socket_handshake(ClientTlsPeer& client, TlsConnection& server, int clientFd) {
+    Buffer plaintext;
+    Buffer outbound;
+    for (int round = 0; round < 32; ++round) {
+        if (!client.is_established() && !client.advance_handshake()) {
+            return false;
+        }
+        if (!write_socket(clientFd, client.take_output())) {
+            return false;
+        }
+
+        const TlsConnection::ReadResult result = server.read_plaintext_from_socket(plaintext, outbound);
+        if (result == TlsConnection::ReadResult::Error || plaintext.readable_bytes() != 0) {
+            return false;
+        }
+        if (client.feed_input(read_socket(clientFd)) < 0) {
+            return false;
+        }
+
+        if (client.is_established() && server.is_established()) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
 } // namespace
 
 TEST(TlsConnectionTest, NullSslHandleTransitionsToErrorState) {
@@ -195,4 +278,150 @@ TEST(TlsConnectionTest, HandshakeEncryptAndDecryptRoundTrip) {
     std::string decryptedResponse;
     EXPECT_EQ(clientPeer.read_plaintext(decryptedResponse), static_cast<int>(response.size()));
     EXPECT_EQ(decryptedResponse, response);
-}
\ No newline at end of file
+}
+
+TEST(TlsConnectionTest, BufferBioDecryptsInPlaceAndEncryptsIntoBuffer) {
+    TlsConfig serverContext;
+    ASSERT_TRUE(serverContext.init(cert_path("test-cert.pem"), cert_path("test-key.pem")));
+
+    TlsConnection serverConnection(serverContext.create_ssl(), TlsMode::BufferBio);
+    ASSERT_TRUE(serverConnection.uses_buffer_bio());
+    ClientTlsPeer clientPeer;
+    ASSERT_TRUE(complete_buffer_bio_handshake(clientPeer, serverConnection));
+
+    // 半条记录时 OpenSSL 只取走已到达的部分，明文在整条记录到齐后才出现
+    const std::string request = "GET /health HTTP/1.1\r\nHost: localhost\r\n\r\n";
+    ASSERT_TRUE(clientPeer.write_plaintext(request));
+    const std::string record = clientPeer.take_output();
+    Buffer inbound;
+    Buffer plaintext;
+    Buffer outbound;
+    inbound.write_to_buffer(record.data(), record.size() / 2);
+    EXPECT_EQ(serverConnection.read_plaintext(inbound, plaintext, outbound), TlsConnection::ReadResult::NeedMoreData);
+    inbound.write_to_buffer(record.data() + record.size() / 2, record.size() - record.size() / 2);
+    ASSERT_EQ(serverConnection.read_plaintext(inbound, plaintext, outbound), TlsConnection::ReadResult::Ready);
+    EXPECT_EQ(inbound.readable_bytes(), 0U);
+    EXPECT_EQ(outbound.readable_bytes(), 0U);
+    EXPECT_EQ(plaintext.read_from_buffer(), request);
+
+    const std::string response = "HTTP/1.1 200 OK\r\nContent-Length: 2\r\n\r\nOK";
+    ASSERT_TRUE(serverConnection.write_plaintext(response.data(), response.size(), outbound));
+    ASSERT_GT(outbound.readable_bytes(), response.size());
+    ASSERT_GT(clientPeer.feed_input(outbound.read_from_buffer()), 0);
+
+    std::string decryptedResponse;
+    EXPECT_EQ(clientPeer.read_plaintext(decryptedResponse), static_cast<int>(response.size()));
+    EXPECT_EQ(decryptedResponse, response);
+
+    // 两套接口按构造时选定的 BIO 区分，调错直接失败
+    std::string ignored;
+    std::string ignoredOutput;
+    EXPECT_EQ(serverConnection.read_plaintext("x", ignored, ignoredOutput), TlsConnection::ReadResult::Error);
+}
+
+TEST(TlsConnectionTest, BufferBioCopiesFewerBytesThanMemoryBio) {
+    TlsConfig serverContext;
+    ASSERT_TRUE(serverContext.init(cert_path("test-cert.pem"), cert_path("test-key.pem")));
+
+    TlsConnection memoryBio(serverContext.create_ssl(), TlsMode::MemoryBio);
+    TlsConnection bufferBio(serverContext.create_ssl(), TlsMode::BufferBio);
+    ClientTlsPeer memoryClient;
+    ClientTlsPeer bufferClient;
+    ASSERT_TRUE(complete_handshake(memoryClient, memoryBio));
+    ASSERT_TRUE(complete_buffer_bio_handshake(bufferClient, bufferBio));
+
+    const std::string request(4096, 'q');
+    const std::string response(4096, 'r');
+    const uint64_t memoryBefore = memoryBio.get_copied_bytes();
+    const uint64_t bufferBefore = bufferBio.get_copied_bytes();
+
+    ASSERT_TRUE(memoryClient.write_plaintext(request));
+    std::string memoryPlaintext;
+    std::string memoryOutput;
+    ASSERT_EQ(memoryBio.read_plaintext(memoryClient.take_output(), memoryPlaintext, memoryOutput), TlsConnection::ReadResult::Ready);
+    ASSERT_TRUE(memoryBio.write_plaintext(response, memoryOutput));
+
+    ASSERT_TRUE(bufferClient.write_plaintext(request));
+    Buffer inbound;
+    Buffer plaintext;
+    Buffer outbound;
+    inbound.write_to_buffer(bufferClient.take_output());
+    ASSERT_EQ(bufferBio.read_plaintext(inbound, plaintext, outbound), TlsConnection::ReadResult::Ready);
+    ASSERT_TRUE(bufferBio.write_plaintext(response.data(), response.size(), outbound));
+
+    // Memory BIO：密文进出 BIO 各两次，外加明文 append；Buffer BIO：密文进出各一次
+    const uint64_t memoryCopied = memoryBio.get_copied_bytes() - memoryBefore;
+    const uint64_t bufferCopied = bufferBio.get_copied_bytes() - bufferBefore;
+    EXPECT_GE(bufferCopied, request.size() + response.size());
+    EXPECT_GE(memoryCopied, 2 * bufferCopied);
+}
+
+TEST(TlsConnectionTest, KernelTlsReadsRecordsFromSocketAndFallsBackToUserspaceEncryption) {
+    int fds[2] = { -1, -1 };
+    ASSERT_EQ(::socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, fds), 0);
+
+    TlsConfig serverContext;
+    ASSERT_TRUE(serverContext.init(cert_path("test-cert.pem"), cert_path("test-key.pem")));
+    TlsConnection serverConnection(serverContext.create_ssl(), TlsMode::KernelTls, fds[0]);
+    ClientTlsPeer clientPeer;
+    ASSERT_TRUE(complete_socket_handshake(clientPeer, serverConnection, fds[1]));
+    EXPECT_EQ(clientPeer.version(), TLS1_3_VERSION);
+
+    // Unix 域 socket 不支持 TCP ULP，两个方向都不会卸载：读仍直接走 socket，写回退到 Buffer BIO
+    EXPECT_FALSE(serverConnection.is_ktls_send_offloaded());
+    EXPECT_FALSE(serverConnection.is_ktls_recv_offloaded());
+
+    const std::string request = "GET /health HTTP/1.1\r\nHost: localhost\r\n\r\n";
+    ASSERT_TRUE(clientPeer.write_plaintext(request));
+    ASSERT_TRUE(write_socket(fds[1], clientPeer.take_output()));
+    Buffer plaintext;
+    Buffer outbound;
+    ASSERT_EQ(serverConnection.read_plaintext_from_socket(plaintext, outbound), TlsConnection::ReadResult::Ready);
+    EXPECT_EQ(plaintext.read_from_buffer(), request);
+
+    // 未卸载时对端 KeyUpdate 由 OpenSSL 在用户态完成，连接照常可用
+    ASSERT_TRUE(clientPeer.request_key_update());
+    ASSERT_TRUE(clientPeer.write_plaintext(request));
+    ASSERT_TRUE(write_socket(fds[1], clientPeer.take_output()));
+    ASSERT_EQ(serverConnection.read_plaintext_from_socket(plaintext, outbound), TlsConnection::ReadResult::Ready);
+    EXPECT_EQ(plaintext.read_from_buffer(), request);
+
+    const std::string response = "HTTP/1.1 200 OK\r\nContent-Length: 2\r\n\r\nOK";
+    ASSERT_TRUE(serverConnection.write_plaintext(response.data(), response.size(), outbound));
+    ASSERT_GT(clientPeer.feed_input(outbound.read_from_buffer()), 0);
+    std::string decryptedResponse;
+    EXPECT_EQ(clientPeer.read_plaintext(decryptedResponse), static_cast<int>(response.size()));
+    EXPECT_EQ(decryptedResponse, response);
+
+    // close_notify 报告为 Closed，由上层关闭连接；字符串接口不适用于 KernelTls
+    ASSERT_TRUE(clientPeer.send_close_notify());
+    ASSERT_TRUE(write_socket(fds[1], clientPeer.take_output()));
+    EXPECT_EQ(serverConnection.read_plaintext_from_socket(plaintext, outbound), TlsConnection::ReadResult::Closed);
+    std::string ignored;
+    std::string ignoredOutput;
+    EXPECT_EQ(serverConnection.read_plaintext("x", ignored, ignoredOutput), TlsConnection::ReadResult::Error);
+
+    ::close(fds[0]);
+    ::close(fds[1]);
+}
+
+TEST(TlsConnectionTest, KernelTlsReportsPeerEofAsClosed) {
+    int fds[2] = { -1, -1 };
+    ASSERT_EQ(::socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, fds), 0);
+
+    TlsConfig serverContext;
+    ASSERT_TRUE(serverContext.init(cert_path("test-cert.pem"), cert_path("test-key.pem")));
+    TlsConnection serverConnection(serverContext.create_ssl(), TlsMode::KernelTls, fds[0]);
+    ClientTlsPeer clientPeer;
+    ASSERT_TRUE(complete_socket_handshake(clientPeer, serverConnection, fds[1]));
+
+    // 对端不发 close_notify 直接断开
+    ::close(fds[1]);
+    Buffer plaintext;
+    Buffer outbound;
+    EXPECT_EQ(serverConnection.read_plaintext_from_socket(plaintext, outbound), TlsConnection::ReadResult::Closed);
+
+    TlsConnection withoutFd(serverContext.create_ssl(), TlsMode::KernelTls);
+    EXPECT_TRUE(withoutFd.is_error());
+    ::close(fds[0]);
+}
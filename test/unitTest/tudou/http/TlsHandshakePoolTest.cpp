@@ -0,0 +1,77 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <mutex>
+#include <set>
+#include <stdexcept>
+#include <thread>
+
+#include "tudou/http/TlsHandshakePool.h"
+#include "tudou/reactor/EventLoop.h"
+#include "tudou/reactor/EventLoopThread.h"
+
+TEST(TlsHandshakePoolTest, RunsWorkOnPoolThreadsAndDeliversResultToLoop) {
+    TlsHandshakePool pool(2);
+    ASSERT_EQ(pool.size(), 2u);
+    EventLoopThread resultThread;
+    EventLoop* resultLoop = resultThread.get_loop();
+
+    std::mutex mutex;
+    std::set<std::thread::id> workers;
+    bool resultsOnLoop = true;
+    std::promise<void> done;
+    int remaining = 4;
+    for (int i = 0; i < 4; ++i) {
+        pool.submit(
+            [&]() {
+                std::lock_guard<std::mutex> lock(mutex);
+                workers.insert(std::this_thread::get_id());
+            },
+            resultLoop,
+            [&]() {
+                std::lock_guard<std::mutex> lock(mutex);
+                resultsOnLoop = resultsOnLoop && resultLoop->is_in_loop_thread();
+                if (--remaining == 0) {
+                    done.set_value();
+                }
+            });
+    }
+
+    std::future<void> future = done.get_future();
+    ASSERT_EQ(future.wait_for(std::chrono::seconds(3)), std::future_status::ready);
+    std::lock_guard<std::mutex> lock(mutex);
+    EXPECT_EQ(workers.size(), 2u);
+    EXPECT_EQ(workers.count(std::this_thread::get_id()), 0u);
+    EXPECT_TRUE(resultsOnLoop);
+    EXPECT_EQ(pool.get_completed_count(), 4u);
+}
+
+TEST(TlsHandshakePoolTest, PausedDeliveryDropsResults) {
+    TlsHandshakePool pool(1);
+    EventLoopThread resultThread;
+
+    std::atomic<int> delivered{ 0 };
+    pool.pause_delivery();
+    pool.submit([]() {}, resultThread.get_loop(), [&]() { delivered.fetch_add(1); });
+    for (int retry = 0; retry < 200 && pool.get_completed_count() < 1; ++retry) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    EXPECT_EQ(pool.get_completed_count(), 1u);
+
+    // 恢复后只投递新任务的结果
+    std::promise<void> done;
+    pool.resume_delivery();
+    pool.submit([]() {}, resultThread.get_loop(), [&]() {
+        delivered.fetch_add(1);
+        done.set_value();
+        });
+    std::future<void> future = done.get_future();
+    ASSERT_EQ(future.wait_for(std::chrono::seconds(3)), std::future_status::ready);
+    EXPECT_EQ(delivered.load(), 1);
+}
+
+TEST(TlsHandshakePoolTest, RejectsEmptyPool) {
+    EXPECT_THROW(TlsHandshakePool(0), std::invalid_argument);
+}
@@ -0,0 +1,70 @@
+/**
+ * @file CoroutineStackPoolTest.cpp
+ * @brief 带保护页的协程栈池单元测试
+ * @author wenxingming
+ * @project: https://github.com/WenXingming/Tudou
+ */
+
+#include <gtest/gtest.h>
+#include "tudou/rpc/CoroutineStackPool.h"
+#include <unistd.h>
+
+namespace tudou {
+namespace rpc {
+namespace test {
+
+TEST(CoroutineStackPoolTest, RoundsStackSizeUpToPage) {
+    const size_t pageSize = static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+    CoroutineStackPool pool(pageSize + 1, 4);
+    EXPECT_EQ(pool.stack_size(), pageSize * 2);
+
+    // 返回的 size 包含保护页
+    auto sctx = pool.allocate();
+    EXPECT_EQ(sctx.size, pageSize * 3);
+    pool.deallocate(sctx);
+}
+
+TEST(CoroutineStackPoolTest, ReusesReleasedStacks) {
+    CoroutineStackPool pool(64 * 1024, 4);
+
+    auto first = pool.allocate();
+    void* firstSp = first.sp;
+    pool.deallocate(first);
+    EXPECT_EQ(pool.cached_stacks(), 1u);
+
+    auto second = pool.allocate();
+    EXPECT_EQ(second.sp, firstSp);
+    EXPECT_EQ(pool.mapped_count(), 1u);
+    EXPECT_EQ(pool.cached_stacks(), 0u);
+    pool.deallocate(second);
+}
+
+TEST(CoroutineStackPoolTest, CacheIsBounded) {
+    CoroutineStackPool pool(16 * 1024, 2);
+
+    auto a = pool.allocate();
+    auto b = pool.allocate();
+    auto c = pool.allocate();
+    EXPECT_EQ(pool.mapped_count(), 3u);
+
+    pool.deallocate(a);
+    pool.deallocate(b);
+    pool.deallocate(c); // 超出上限，直接 munmap
+    EXPECT_EQ(pool.cached_stacks(), 2u);
+}
+
+TEST(CoroutineStackPoolTest, ForeignThreadDeallocateUnmaps) {
+    CoroutineStackPool pool(16 * 1024, 4);
+    auto sctx = pool.allocate();
+
+    std::thread other([&pool, &sctx]() {
+        pool.deallocate(sctx);
+    });
+    other.join();
+
+    EXPECT_EQ(pool.cached_stacks(), 0u);
+}
+
+} // namespace test
+} // namespace rpc
+} // namespace tudou
@@ -38,6 +38,72 @@ TEST(CoroutineTest, ContextSwitchingWorks) {
     // 预期执行流顺序应该是: 首次运行协程内(1) -> 挂起切回主线程(2) -> 再次唤醒协程内(3) -> 协程结束切回主线程(4)
     std::vector<int> expected = {1, 2, 3, 4};
     EXPECT_EQ(executionOrder, expected);
+    EXPECT_TRUE(coro->is_finished());
+}
+
+TEST(CoroutineTest, CreateReusesFinishedCoroutine) {
+    int runCount = 0;
+
+    auto first = Coroutine::create(nullptr, [&runCount]() {
+        ++runCount;
+    });
+    first->resume();
+    EXPECT_TRUE(first->is_finished());
+    Coroutine* firstAddress = first.get();
+    first.reset(); // 已完成的协程回收入当前线程的对象池
+
+    // 再次创建时取回同一个协程对象，装载新任务后从头运行
+    auto second = Coroutine::create(nullptr, [&runCount]() {
+        runCount += 10;
+        Coroutine::t_current_coroutine->yield();
+        runCount += 100;
+    });
+    EXPECT_EQ(second.get(), firstAddress);
+    EXPECT_FALSE(second->is_finished());
+
+    second->resume();
+    EXPECT_EQ(runCount, 11);
+    second->resume();
+    EXPECT_EQ(runCount, 111);
+    EXPECT_TRUE(second->is_finished());
+
+    // 已完成的协程再次 resume 不会重新执行任务
+    second->resume();
+    EXPECT_EQ(runCount, 111);
+}
+
+TEST(CoroutineTest, SuspendedCoroutineIsNotRecycled) {
+    bool resumedAfterYield = false;
+
+    auto suspended = Coroutine::create(nullptr, [&resumedAfterYield]() {
+        Coroutine::t_current_coroutine->yield();
+        resumedAfterYield = true;
+    });
+    suspended->resume();
+    EXPECT_FALSE(suspended->is_finished());
+    suspended.reset(); // 中途释放的协程直接销毁并展开其栈，不进入对象池
+
+    auto fresh = Coroutine::create(nullptr, []() {});
+    fresh->resume();
+    EXPECT_FALSE(resumedAfterYield);
+    EXPECT_TRUE(fresh->is_finished());
+}
+
+TEST(CoroutineTest, OptionsRoundTrip) {
+    const CoroutineOptions saved = Coroutine::get_options();
+
+    CoroutineOptions options;
+    options.stackSize = 256 * 1024;
+    options.maxPooledStacks = 8;
+    options.maxPooledCoroutines = 4;
+    Coroutine::set_options(options);
+
+    const CoroutineOptions loaded = Coroutine::get_options();
+    EXPECT_EQ(loaded.stackSize, 256u * 1024);
+    EXPECT_EQ(loaded.maxPooledStacks, 8u);
+    EXPECT_EQ(loaded.maxPooledCoroutines, 4u);
+
+    Coroutine::set_options(saved);
 }
 
 } // namespace test
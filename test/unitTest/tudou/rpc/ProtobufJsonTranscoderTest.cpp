@@ -0,0 +1,194 @@
+/**
+ * @file ProtobufJsonTranscoderTest.cpp
+ * @brief ProtobufJsonTranscoder 与 protobuf 自带 JSON 工具的对照测试
+ * @author wenxingming
+ * @project: https://github.com/WenXingming/Tudou
+ */
+
+#include <gtest/gtest.h>
+#include "tudou/rpc/ProtobufJsonTranscoder.h"
+#include "test.pb.h"
+
+#include <google/protobuf/timestamp.pb.h>
+#include <google/protobuf/util/field_comparator.h>
+#include <google/protobuf/util/json_util.h>
+#include <google/protobuf/util/message_differencer.h>
+#include <nlohmann/json.hpp>
+#include <string>
+#include <vector>
+
+namespace tudou {
+namespace rpc {
+namespace {
+
+using binary::test::TranscodeColor;
+using binary::test::TranscodeSample;
+
+TranscodeSample build_sample() {
+    TranscodeSample sample;
+    sample.set_int32_value(-42);
+    sample.set_int64_value(-9007199254740993LL);
+    sample.set_uint32_value(4000000000U);
+    sample.set_uint64_value(18446744073709551615ULL);
+    sample.set_sint32_value(-7);
+    sample.set_fixed64_value(123456789012345ULL);
+    sample.set_double_value(0.1);
+    sample.set_float_value(3.14159f);
+    sample.set_bool_value(true);
+    sample.set_string_value("quote\" backslash\\ newline\n tab\t \x01 中文");
+    sample.set_bytes_value(std::string("\x00\xff\x10tudou", 8));
+    sample.set_color(binary::test::TRANSCODE_COLOR_BLUE);
+    sample.mutable_nested()->set_name("outer");
+    sample.mutable_nested()->add_values(1);
+    sample.mutable_nested()->mutable_child()->set_name("inner");
+    sample.add_tags("a");
+    sample.add_tags("");
+    sample.add_samples(1e300);
+    sample.add_samples(-2.5);
+    sample.add_items()->set_name("first");
+    sample.add_items();
+    sample.add_colors(binary::test::TRANSCODE_COLOR_RED);
+    sample.add_colors(static_cast<TranscodeColor>(7)); // 开放枚举中未定义的值
+    (*sample.mutable_counters())["hits"] = 3;
+    (*sample.mutable_by_id())[-5].set_name("negative");
+    sample.set_maybe(0);
+    sample.set_choice_text("picked");
+    sample.set_renamed_value("custom json_name");
+    return sample;
+}
+
+// 比较两个消息，NaN 视为相等
+bool equals(const google::protobuf::Message& expected, const google::protobuf::Message& actual) {
+    google::protobuf::util::DefaultFieldComparator comparator;
+    comparator.set_treat_nan_as_equal(true);
+    google::protobuf::util::MessageDifferencer differencer;
+    differencer.set_field_comparator(&comparator);
+    return differencer.Compare(expected, actual);
+}
+
+nlohmann::json print_with_transcoder(const google::protobuf::Message& message) {
+    std::string output;
+    ProtobufJsonTranscoder::print(message, output);
+    return nlohmann::json::parse(output);
+}
+
+nlohmann::json print_with_protobuf(const google::protobuf::Message& message) {
+    std::string output;
+    google::protobuf::util::JsonPrintOptions options;
+    options.always_print_primitive_fields = true;
+    EXPECT_TRUE(google::protobuf::util::MessageToJsonString(message, &output, options).ok());
+    return nlohmann::json::parse(output);
+}
+
+} // namespace
+
+// 1. 打印结果与 always_print_primitive_fields 下的 MessageToJsonString 语义一致
+TEST(ProtobufJsonTranscoderTest, PrintMatchesProtobufJsonUtil) {
+    const TranscodeSample sample = build_sample();
+    EXPECT_EQ(print_with_transcoder(sample), print_with_protobuf(sample));
+
+    // 全默认值：标量与 repeated 照常打印，未设置的消息字段、oneof 与 optional 字段省略
+    const TranscodeSample empty;
+    EXPECT_EQ(print_with_transcoder(empty), print_with_protobuf(empty));
+
+    std::string output = "prefix";
+    ProtobufJsonTranscoder::print(empty, output);
+    EXPECT_EQ(output.compare(0, 6, "prefix"), 0);
+}
+
+// 2. 对同一段 JSON 文本，解析结果与 JsonStringToMessage（ignore_unknown_fields）一致
+TEST(ProtobufJsonTranscoderTest, ParseMatchesProtobufJsonUtil) {
+    const std::vector<std::string> inputs = {
+        "{}",
+        R"({"int32Value":-1,"int64Value":"-9007199254740993","uint64Value":"18446744073709551615","doubleValue":1.5e-3})",
+        R"({"int32_value":7,"uint32_value":4000000000,"sint32Value":"-3","fixed64Value":1e3,"floatValue":"0.25"})",
+        R"({"doubleValue":"NaN","samples":["Infinity","-Infinity",2]})",
+        R"({"stringValue":"esc \"\\\/\b\f\n\r\t é 😀","bytesValue":"AP8QdHVkb3U="})",
+        R"({"bytesValue":"-_8"})",
+        R"({"color":"TRANSCODE_COLOR_RED","colors":[2,"TRANSCODE_COLOR_BLUE","NO_SUCH_COLOR"]})",
+        R"({"nested":{"name":"n","values":[1,2,3],"child":{"child":{"name":"deep"}}},"items":[{},{"name":"x"}]})",
+        R"({"counters":{"a":"1","b":2},"byId":{"-5":{"name":"neg"},"9":null}})",
+        R"({"maybe":0,"choiceNested":{"name":"c"}})",
+        R"( { "unknown" : { "nested" : [ 1 , { "x" : null } , "s" , true ] } , "boolValue" : true , "tags" : [ "t" ] } )",
+        R"({"nested":null,"tags":null,"int32Value":null,"stringValue":"kept"})",
+        R"({"customName":"by json_name","renamedValue":"camelcase is not its json_name"})",
+        R"({"renamed_value":"by proto name"})",
+    };
+
+    google::protobuf::util::JsonParseOptions options;
+    options.ignore_unknown_fields = true;
+    for (const std::string& input : inputs) {
+        SCOPED_TRACE(input);
+        TranscodeSample expected;
+        ASSERT_TRUE(google::protobuf::util::JsonStringToMessage(input, &expected, options).ok());
+
+        TranscodeSample actual;
+        std::string error;
+        ASSERT_TRUE(ProtobufJsonTranscoder::parse(input.data(), input.size(), &actual, &error)) << error;
+        EXPECT_TRUE(equals(expected, actual))
+            << "expected: " << expected.ShortDebugString() << "\nactual: " << actual.ShortDebugString();
+    }
+}
+
+// 3. 打印后再解析得到原消息；缺省 params 的 "null" 视为空对象
+TEST(ProtobufJsonTranscoderTest, RoundTripsPrintedOutput) {
+    const TranscodeSample sample = build_sample();
+    std::string output;
+    ProtobufJsonTranscoder::print(sample, output);
+
+    TranscodeSample parsed;
+    std::string error;
+    ASSERT_TRUE(ProtobufJsonTranscoder::parse(output.data(), output.size(), &parsed, &error)) << error;
+    EXPECT_TRUE(equals(sample, parsed));
+
+    ASSERT_TRUE(ProtobufJsonTranscoder::parse("null", 4, &parsed, &error));
+    EXPECT_TRUE(equals(TranscodeSample(), parsed));
+}
+
+// 4. 类型不匹配、越界、非法文本都解析失败并给出出错偏移
+TEST(ProtobufJsonTranscoderTest, RejectsInvalidInput) {
+    std::string tooDeep;
+    for (int i = 0; i <= ProtobufJsonTranscoder::kMaxDepth; ++i) {
+        tooDeep += R"({"child":)";
+    }
+    tooDeep = R"({"nested":)" + tooDeep;
+
+    const std::vector<std::string> inputs = {
+        "",
+        "[]",
+        R"({"int32Value":"abc"})",
+        R"({"int32Value":2147483648})",
+        R"({"int32Value":1.5})",
+        R"({"uint64Value":-1})",
+        R"({"int32Value":"0x10"})",
+        R"({"floatValue":1e40})",
+        R"({"boolValue":"true"})",
+        R"({"stringValue":5})",
+        R"({"bytesValue":"a"})",
+        R"({"tags":[null]})",
+        R"({"nested":[]})",
+        R"({"stringValue":"\ud800"})",
+        R"({"stringValue":"unterminated)",
+        R"({"int32Value":1} trailing)",
+        R"({"int32Value":1,})",
+        tooDeep,
+    };
+
+    for (const std::string& input : inputs) {
+        SCOPED_TRACE(input);
+        TranscodeSample message;
+        std::string error;
+        EXPECT_FALSE(ProtobufJsonTranscoder::parse(input.data(), input.size(), &message, &error));
+        EXPECT_NE(error.find("offset"), std::string::npos);
+    }
+}
+
+// 5. 只接管 proto3 普通消息，知名类型留给 protobuf 自带工具
+TEST(ProtobufJsonTranscoderTest, SupportsPlainProto3MessagesOnly) {
+    EXPECT_TRUE(ProtobufJsonTranscoder::supports(TranscodeSample::descriptor()));
+    EXPECT_FALSE(ProtobufJsonTranscoder::supports(google::protobuf::Timestamp::descriptor()));
+    EXPECT_FALSE(ProtobufJsonTranscoder::supports(nullptr));
+}
+
+} // namespace rpc
+} // namespace tudou
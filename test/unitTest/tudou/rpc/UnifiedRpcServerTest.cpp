@@ -9,6 +9,7 @@
 #include "tudou/rpc/UnifiedRpcServer.h"
 #include "tudou/rpc/binary/BinaryRpcChannel.h"
 #include "tudou/rpc/json/JsonRpcClient.h"
+#include "tudou/rpc/json/JsonRpcRouter.h"
 #include "binary_rpc.pb.h"
 #include "test.pb.h"
 
@@ -19,6 +20,7 @@
 #include <thread>
 #include <chrono>
 #include <memory>
+#include <vector>
 
 namespace tudou {
 namespace rpc {
@@ -61,6 +63,31 @@ public:
         }
     }
 };
+
+// 在另一个线程里完成调用的 Service，用于验证桥接对异步完成的等待
+class DeferredEchoServiceImpl : public TestEchoService {
+public:
+    ~DeferredEchoServiceImpl() override {
+        for (auto& worker : workers_) {
+            worker.join();
+        }
+    }
+
+    void Echo(google::protobuf::RpcController*,
+              const EchoRequest* request,
+              EchoResponse* response,
+              google::protobuf::Closure* done) override {
+        std::string message = request->message();
+        workers_.emplace_back([message, response, done]() {
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            response->set_message("Deferred: " + message);
+            done->Run();
+        });
+    }
+
+private:
+    std::vector<std::thread> workers_;
+};
 }
 
 class UnifiedRpcServerTest : public ::testing::Test {
@@ -122,6 +149,54 @@ TEST_F(UnifiedRpcServerTest, AccessesViaJsonRpcClient) {
     EXPECT_EQ(result["message"].get<std::string>(), "UnifiedEcho: hello json");
 }
 
+// 3. 桥接处理器直接在 params 文本上解析、把响应写入输出缓冲，两种 JSON 后端结果一致
+TEST(UnifiedRpcJsonBridgeTest, TranscodesParamsAndResultWithoutDom) {
+    const std::string method = "tudou.rpc.binary.test.TestEchoService.Echo";
+    auto service = std::make_shared<TestEchoServiceImpl>();
+
+    std::vector<JsonRpcRouter::Backend> backends{ JsonRpcRouter::Backend::Nlohmann };
+    if (JsonRpcRouter::is_backend_available(JsonRpcRouter::Backend::OnDemand)) {
+        backends.push_back(JsonRpcRouter::Backend::OnDemand);
+    }
+
+    for (JsonRpcRouter::Backend backend : backends) {
+        JsonRpcRouter router;
+        ASSERT_TRUE(router.set_backend(backend));
+        router.register_raw_method(method,
+            UnifiedRpcServer::make_json_bridge(service, service->GetDescriptor()->FindMethodByName("Echo")));
+
+        // 未知字段被忽略
+        auto reply = nlohmann::json::parse(router.dispatch(
+            R"({"jsonrpc":"2.0","method":")" + method + R"(","params":{"message":"hi","extra":{"nested":[1,2]}},"id":1})"));
+        EXPECT_EQ(reply["result"]["message"], "UnifiedEcho: hi");
+        EXPECT_EQ(reply["id"], 1);
+
+        // 缺省 params 视为空请求，默认值字段也会打印
+        reply = nlohmann::json::parse(router.dispatch(R"({"jsonrpc":"2.0","method":")" + method + R"(","id":2})"));
+        EXPECT_EQ(reply["result"]["message"], "UnifiedEcho: ");
+
+        // 类型不匹配映射为 Invalid params，输出中不残留半截结果
+        std::string output = "prefix";
+        const std::string badRequest = R"({"jsonrpc":"2.0","method":")" + method + R"(","params":{"message":42},"id":3})";
+        router.dispatch(badRequest.data(), badRequest.size(), output);
+        ASSERT_EQ(output.compare(0, 6, "prefix"), 0);
+        reply = nlohmann::json::parse(output.substr(6));
+        EXPECT_EQ(reply["error"]["code"], -32602);
+        EXPECT_EQ(reply["id"], 3);
+    }
+}
+
+// 4. Service 在其他线程执行 done 时，桥接阻塞到调用完成后才打印响应
+TEST(UnifiedRpcJsonBridgeTest, WaitsForDeferredCompletion) {
+    auto service = std::make_shared<DeferredEchoServiceImpl>();
+    JsonRpcRouter router;
+    router.register_raw_method("Echo",
+        UnifiedRpcServer::make_json_bridge(service, service->GetDescriptor()->FindMethodByName("Echo")));
+
+    auto reply = nlohmann::json::parse(router.dispatch(R"({"jsonrpc":"2.0","method":"Echo","params":{"message":"later"},"id":1})"));
+    EXPECT_EQ(reply["result"]["message"], "Deferred: later");
+}
+
 } // namespace test
 } // namespace binary
 } // namespace rpc
@@ -8,6 +8,8 @@
 #include <gtest/gtest.h>
 #include "tudou/rpc/binary/BinaryRpcServer.h"
 #include "tudou/rpc/binary/BinaryRpcChannel.h"
+#include "tudou/rpc/binary/BinaryRpcClientLoopPool.h"
+#include "tudou/rpc/binary/BinaryRpcController.h"
 #include "tudou/reactor/EventLoop.h"
 #include "tudou/rpc/Coroutine.h"
 #include "binary_rpc.pb.h"
@@ -24,6 +26,8 @@
 #include <vector>
 #include <stdexcept>
 #include <atomic>
+#include <future>
+#include <set>
 
 namespace tudou {
 namespace rpc {
@@ -80,6 +84,18 @@ public:
         }
     }
 };
+
+// 回调模式下使用的测试闭包：Run() 时兑现 promise，测试线程据此等待回包
+class PromiseClosure : public google::protobuf::Closure {
+public:
+    void Run() override {
+        runThread = std::this_thread::get_id();
+        promise.set_value();
+    }
+
+    std::promise<void> promise;
+    std::thread::id runThread; // 执行 done 的线程
+};
 }
 
 class BinaryRpcChannelTest : public ::testing::Test {
@@ -123,6 +139,22 @@ TEST_F(BinaryRpcChannelTest, InvokesSingleCallSuccessfully) {
     EXPECT_EQ(response.message(), "Echo: Single RPC verification");
 }
 
+// 1.1 验证方法 ID 协商完成后的调用（以及协商完成前按方法名的调用）都能成功
+TEST_F(BinaryRpcChannelTest, InvokesBeforeAndAfterMethodIdNegotiation) {
+    BinaryRpcChannel channel("127.0.0.1", port);
+    TestEchoService_Stub stub(&channel);
+
+    for (int round = 0; round < 3; ++round) {
+        EchoRequest request;
+        request.set_message("round_" + std::to_string(round));
+        EchoResponse response;
+
+        stub.Echo(nullptr, &request, &response, nullptr);
+        EXPECT_EQ(response.message(), "Echo: round_" + std::to_string(round));
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    }
+}
+
 // 2. 【核心多路复用】验证多线程在单连接上发起并发调用时，回包内容精准匹配不发生混淆或交错
 TEST_F(BinaryRpcChannelTest, ExecutesConcurrentMultiplexedCallsSuccessfully) {
     BinaryRpcChannel channel("127.0.0.1", port);
@@ -246,6 +278,167 @@ TEST_F(BinaryRpcChannelTest, ThrowsExceptionOnCoroutineNetworkFailure) {
     EXPECT_TRUE(exceptionThrown);
 }
 
+// 6. 验证共享客户端 loop 池：多条连接轮询挂到少量线程上，future 风格调用全部成功
+TEST_F(BinaryRpcChannelTest, SharesClientLoopPoolAcrossManyChannels) {
+    auto loopPool = std::make_shared<BinaryRpcClientLoopPool>(2);
+
+    constexpr int kChannelNum = 16;
+    std::vector<std::unique_ptr<BinaryRpcChannel>> channels;
+    std::set<EventLoop*> loops;
+    for (int index = 0; index < kChannelNum; ++index) {
+        channels.push_back(std::make_unique<BinaryRpcChannel>(loopPool, "127.0.0.1", port));
+        loops.insert(channels.back()->get_loop());
+    }
+    EXPECT_EQ(loops.size(), loopPool->size());
+
+    const google::protobuf::MethodDescriptor* method = TestEchoService::descriptor()->FindMethodByName("Echo");
+    std::vector<EchoRequest> requests(kChannelNum);
+    std::vector<EchoResponse> responses(kChannelNum);
+    std::vector<std::future<void>> futures;
+    for (int index = 0; index < kChannelNum; ++index) {
+        requests[index].set_message("pool_" + std::to_string(index));
+        futures.push_back(channels[index]->call_async(method, &requests[index], &responses[index]));
+    }
+
+    for (int index = 0; index < kChannelNum; ++index) {
+        ASSERT_EQ(futures[index].wait_for(std::chrono::seconds(5)), std::future_status::ready);
+        futures[index].get();
+        EXPECT_EQ(responses[index].message(), "Echo: pool_" + std::to_string(index));
+    }
+}
+
+// 7. 验证共享 loop 池下 done 非空时立即返回，回包后在 loop 线程执行回调；done 为空时阻塞调用线程直到回包
+TEST_F(BinaryRpcChannelTest, InvokesCallbackAndBlockingCallsOnClientLoopPool) {
+    auto loopPool = std::make_shared<BinaryRpcClientLoopPool>(1);
+    BinaryRpcChannel channel(loopPool, "127.0.0.1", port);
+    TestEchoService_Stub stub(&channel);
+
+    EchoRequest asyncReq;
+    asyncReq.set_message("callback");
+    EchoResponse asyncResp;
+    PromiseClosure done;
+    std::future<void> doneFuture = done.promise.get_future();
+    stub.Echo(nullptr, &asyncReq, &asyncResp, &done);
+
+    ASSERT_EQ(doneFuture.wait_for(std::chrono::seconds(5)), std::future_status::ready);
+    EXPECT_EQ(asyncResp.message(), "Echo: callback");
+
+    EchoRequest syncReq;
+    syncReq.set_message("blocking");
+    EchoResponse syncResp;
+    stub.Echo(nullptr, &syncReq, &syncResp, nullptr);
+    EXPECT_EQ(syncResp.message(), "Echo: blocking");
+}
+
+// 8. 验证共享 loop 池下 Channel 在调用挂起期间被析构，future 能被唤醒并携带异常
+TEST_F(BinaryRpcChannelTest, FailsPendingFutureOnPooledChannelDestruction) {
+    auto loopPool = std::make_shared<BinaryRpcClientLoopPool>(1);
+    auto channel = std::make_unique<BinaryRpcChannel>(loopPool, "127.0.0.1", port);
+
+    const google::protobuf::MethodDescriptor* method = TestEchoService::descriptor()->FindMethodByName("Echo");
+    EchoRequest req;
+    req.set_message("slow_call_pool");
+    EchoResponse resp;
+    std::future<void> future = channel->call_async(method, &req, &resp);
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    channel.reset();
+
+    ASSERT_EQ(future.wait_for(std::chrono::seconds(1)), std::future_status::ready);
+    EXPECT_THROW(future.get(), std::runtime_error);
+}
+
+// 9. 验证开启写合并逗留时间后，两种模式下的并发调用都经合并写出并正确匹配回包
+TEST_F(BinaryRpcChannelTest, CoalescesConcurrentWritesWithLinger) {
+    auto loopPool = std::make_shared<BinaryRpcClientLoopPool>(1);
+    BinaryRpcChannel threadChannel("127.0.0.1", port);
+    BinaryRpcChannel loopChannel(loopPool, "127.0.0.1", port);
+
+    for (BinaryRpcChannel* channel : {&threadChannel, &loopChannel}) {
+        channel->set_write_linger(std::chrono::microseconds(50));
+        TestEchoService_Stub stub(channel);
+
+        constexpr int kThreadNum = 16;
+        std::atomic<int> successCount{0};
+        std::vector<std::thread> workers;
+        for (int index = 0; index < kThreadNum; ++index) {
+            workers.emplace_back([&stub, index, &successCount]() {
+                for (int round = 0; round < 10; ++round) {
+                    EchoRequest req;
+                    req.set_message("linger_" + std::to_string(index) + "_" + std::to_string(round));
+                    EchoResponse resp;
+                    stub.Echo(nullptr, &req, &resp, nullptr);
+                    if (resp.message() == "Echo: " + req.message()) {
+                        successCount++;
+                    }
+                }
+            });
+        }
+        for (auto& worker : workers) {
+            worker.join();
+        }
+        EXPECT_EQ(successCount.load(), kThreadNum * 10);
+    }
+}
+
+// 10. 验证两种模式下超过时限的阻塞调用抛出超时异常，迟到的回包被丢弃，连接仍可继续使用
+TEST_F(BinaryRpcChannelTest, FailsCallsThatExceedDeadline) {
+    auto loopPool = std::make_shared<BinaryRpcClientLoopPool>(1);
+    BinaryRpcChannel threadChannel("127.0.0.1", port);
+    BinaryRpcChannel loopChannel(loopPool, "127.0.0.1", port);
+
+    for (BinaryRpcChannel* channel : {&threadChannel, &loopChannel}) {
+        TestEchoService_Stub stub(channel);
+        BinaryRpcController controller;
+        controller.set_timeout(std::chrono::milliseconds(50));
+
+        EchoRequest slowReq;
+        slowReq.set_message("slow_call_deadline");
+        EchoResponse slowResp;
+        const auto start = std::chrono::steady_clock::now();
+        EXPECT_THROW(stub.Echo(&controller, &slowReq, &slowResp, nullptr), std::runtime_error);
+        EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::milliseconds(180));
+
+        EchoRequest req;
+        req.set_message("after_deadline");
+        EchoResponse resp;
+        stub.Echo(nullptr, &req, &resp, nullptr);
+        EXPECT_EQ(resp.message(), "Echo: after_deadline");
+        EXPECT_FALSE(channel->is_closed());
+    }
+}
+
+// 11. 验证回调模式下超时与 StartCancel 都经 controller 报告失败并照常执行 done，且 done 都在 loop 线程而非取消方线程执行
+TEST_F(BinaryRpcChannelTest, ReportsDeadlineAndCancelThroughController) {
+    auto loopPool = std::make_shared<BinaryRpcClientLoopPool>(1);
+    BinaryRpcChannel channel(loopPool, "127.0.0.1", port);
+    TestEchoService_Stub stub(&channel);
+
+    EchoRequest req;
+    req.set_message("slow_call_controller");
+    EchoResponse resp;
+
+    BinaryRpcController timedController;
+    timedController.set_timeout(std::chrono::milliseconds(30));
+    PromiseClosure timedDone;
+    std::future<void> timedFuture = timedDone.promise.get_future();
+    stub.Echo(&timedController, &req, &resp, &timedDone);
+    ASSERT_EQ(timedFuture.wait_for(std::chrono::milliseconds(150)), std::future_status::ready);
+    EXPECT_TRUE(timedController.Failed());
+    EXPECT_NE(timedController.ErrorText().find("Deadline"), std::string::npos);
+
+    BinaryRpcController cancelController;
+    PromiseClosure cancelDone;
+    std::future<void> cancelFuture = cancelDone.promise.get_future();
+    stub.Echo(&cancelController, &req, &resp, &cancelDone);
+    cancelController.StartCancel();
+    ASSERT_EQ(cancelFuture.wait_for(std::chrono::milliseconds(150)), std::future_status::ready);
+    EXPECT_TRUE(cancelController.IsCanceled());
+    EXPECT_NE(cancelController.ErrorText().find("cancelled"), std::string::npos);
+    EXPECT_NE(cancelDone.runThread, std::this_thread::get_id());
+    EXPECT_EQ(cancelDone.runThread, timedDone.runThread);
+}
+
 } // namespace test
 } // namespace binary
 } // namespace rpc
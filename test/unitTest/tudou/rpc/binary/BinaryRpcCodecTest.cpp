@@ -121,3 +121,24 @@ TEST_F(BinaryRpcCodecTest, ErrorsOutOnMagicMismatch) {
     EXPECT_EQ(BinaryRpcCodec::decode(&buffer, outHeader, outMeta, outBody), BinaryRpcCodec::DecodeResult::Error);
     EXPECT_EQ(buffer.readable_bytes(), 25); // 数据未被退回/消费（交给上层处理或切断连接）
 }
+
+// 5. 验证 peek 零拷贝窥探：区间直接指向 Buffer 内部，且不推进读指针
+TEST_F(BinaryRpcCodecTest, PeeksFrameInPlaceWithoutConsuming) {
+    BinaryRpcCodec::encode(&buffer, RpcMessageType::Request, 300, "Meta", "PeekBody");
+    const size_t totalBytes = buffer.readable_bytes();
+
+    RpcHeader header;
+    const char* meta = nullptr;
+    const char* body = nullptr;
+    ASSERT_EQ(BinaryRpcCodec::peek(&buffer, header, meta, body), BinaryRpcCodec::DecodeResult::Success);
+
+    EXPECT_EQ(header.sequenceId, 300);
+    EXPECT_EQ(std::string(meta, header.metaLen), "Meta");
+    EXPECT_EQ(std::string(body, header.bodyLen), "PeekBody");
+    EXPECT_EQ(meta, buffer.readable_start_ptr() + kRpcHeaderSize);
+    EXPECT_EQ(buffer.readable_bytes(), totalBytes); // 窥探不推进读指针
+    EXPECT_EQ(BinaryRpcCodec::frame_size(header), totalBytes);
+
+    buffer.advance_read_index(BinaryRpcCodec::frame_size(header));
+    EXPECT_EQ(BinaryRpcCodec::peek(&buffer, header, meta, body), BinaryRpcCodec::DecodeResult::Empty);
+}
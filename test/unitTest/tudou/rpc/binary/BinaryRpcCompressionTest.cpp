@@ -0,0 +1,327 @@
+/**
+ * @file BinaryRpcCompressionTest.cpp
+ * @brief 二进制 RPC 载荷压缩算法与按连接协商的单元及集成测试
+ * @author wenxingming
+ * @project: https://github.com/WenXingming/Tudou
+ */
+
+#include <gtest/gtest.h>
+#include "tudou/rpc/binary/BinaryRpcCompression.h"
+#include "tudou/rpc/binary/BinaryRpcServer.h"
+#include "tudou/rpc/binary/BinaryRpcChannel.h"
+#include "tudou/rpc/binary/BinaryRpcClientLoopPool.h"
+#include "tudou/rpc/binary/BinaryRpcCodec.h"
+#include "binary_rpc.pb.h"
+#include "test.pb.h"
+
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <chrono>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace tudou {
+namespace rpc {
+namespace binary {
+namespace test {
+
+namespace {
+
+// 预留端口
+uint16_t reserve_free_port() {
+    const int fd = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, IPPROTO_TCP);
+    if (fd < 0) {
+        return 0;
+    }
+
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = 0;
+    if (::inet_pton(AF_INET, "127.0.0.1", &addr.sin_addr) != 1
+        || ::bind(fd, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) != 0) {
+        ::close(fd);
+        return 0;
+    }
+
+    socklen_t len = sizeof(addr);
+    if (::getsockname(fd, reinterpret_cast<sockaddr*>(&addr), &len) != 0) {
+        ::close(fd);
+        return 0;
+    }
+
+    ::close(fd);
+    return ntohs(addr.sin_port);
+}
+
+// 本构建编入的全部算法，按偏好排序
+std::vector<CompressionType> supported_types() {
+    std::vector<CompressionType> types;
+    for (CompressionType type : {CompressionType::Zstd, CompressionType::Lz4, CompressionType::Zlib}) {
+        if (BinaryRpcCompression::is_supported(type)) {
+            types.push_back(type);
+        }
+    }
+    return types;
+}
+
+std::string repetitive_payload(size_t size) {
+    std::string payload;
+    while (payload.size() < size) {
+        payload += "user_id=42,region=us-east,status=active;";
+    }
+    payload.resize(size);
+    return payload;
+}
+
+class EchoServiceImpl : public TestEchoService {
+public:
+    void Echo(google::protobuf::RpcController*,
+              const EchoRequest* request,
+              EchoResponse* response,
+              google::protobuf::Closure* done) override {
+        response->set_message(request->message());
+        if (done) {
+            done->Run();
+        }
+    }
+};
+
+// 在后台线程运行的 BinaryRpcServer
+struct ServerHandle {
+    explicit ServerHandle(const CompressionOptions& options)
+        : port(reserve_free_port())
+        , server(std::make_unique<BinaryRpcServer>("127.0.0.1", port, 2)) {
+        server->register_service(std::make_shared<EchoServiceImpl>());
+        server->set_compression_options(options);
+        thread = std::thread([this]() {
+            server->start();
+        });
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    }
+
+    ~ServerHandle() {
+        server->stop();
+        if (thread.joinable()) {
+            thread.join();
+        }
+    }
+
+    uint16_t port;
+    std::unique_ptr<BinaryRpcServer> server;
+    std::thread thread;
+};
+
+bool wait_for_compression(const BinaryRpcChannel& channel) {
+    for (int attempt = 0; attempt < 100; ++attempt) {
+        if (channel.get_compression() != CompressionType::None) {
+            return true;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    return false;
+}
+
+int connect_to(uint16_t port) {
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    ::inet_pton(AF_INET, "127.0.0.1", &addr.sin_addr);
+    const int fd = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, IPPROTO_TCP);
+    if (fd >= 0 && ::connect(fd, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) != 0) {
+        ::close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+// 在原始连接上发送方法表请求（accepted 为空时 Body 为空），返回服务端选定的压缩算法；失败返回 -1
+int request_method_table(int fd, uint64_t sequenceId, const std::vector<CompressionType>& accepted) {
+    RpcMethodTable request;
+    for (CompressionType type : accepted) {
+        request.add_accept_compression(static_cast<uint32_t>(type));
+    }
+    Buffer writeBuf;
+    BinaryRpcCodec::encode(&writeBuf, RpcMessageType::MethodTable, sequenceId, "", request.SerializeAsString());
+    const std::string bytes = writeBuf.read_from_buffer();
+    if (::write(fd, bytes.data(), bytes.size()) != static_cast<ssize_t>(bytes.size())) {
+        return -1;
+    }
+
+    Buffer readBuf;
+    char temp[4096];
+    RpcHeader header;
+    std::string metaRaw;
+    std::string bodyRaw;
+    while (BinaryRpcCodec::decode(&readBuf, header, metaRaw, bodyRaw) != BinaryRpcCodec::DecodeResult::Success) {
+        const ssize_t nr = ::read(fd, temp, sizeof(temp));
+        if (nr <= 0) {
+            return -1;
+        }
+        readBuf.write_to_buffer(temp, nr);
+    }
+
+    RpcMethodTable reply;
+    if (!reply.ParseFromString(bodyRaw)) {
+        return -1;
+    }
+    return static_cast<int>(reply.compression());
+}
+
+} // namespace
+
+// 1. 验证各算法的压缩往返，以及低于阈值或不可压缩的载荷保持原样
+TEST(BinaryRpcCompressionTest, RoundTripsAndSkipsSmallOrIncompressiblePayloads) {
+    const std::vector<CompressionType> types = supported_types();
+    if (types.empty()) {
+        GTEST_SKIP() << "no compression library compiled in";
+    }
+
+    std::mt19937 rng(7);
+    std::string random(16 * 1024, '\0');
+    for (char& ch : random) {
+        ch = static_cast<char>(rng());
+    }
+    const std::string text = repetitive_payload(16 * 1024);
+
+    for (CompressionType type : types) {
+        std::string compressed;
+        ASSERT_TRUE(BinaryRpcCompression::maybe_compress(type, 1024, text, &compressed));
+        EXPECT_LT(compressed.size(), text.size() / 4);
+
+        const std::string* raw = BinaryRpcCompression::decompress(compressed.data(), compressed.size());
+        ASSERT_NE(raw, nullptr);
+        EXPECT_EQ(*raw, text);
+
+        std::string unused;
+        EXPECT_FALSE(BinaryRpcCompression::maybe_compress(type, 1024, text.substr(0, 512), &unused));
+        EXPECT_FALSE(BinaryRpcCompression::maybe_compress(type, 1024, random, &unused));
+    }
+    EXPECT_FALSE(BinaryRpcCompression::maybe_compress(CompressionType::None, 0, text, nullptr));
+}
+
+// 2. 验证协商按对端偏好选出双方都接受的算法，以及非法前缀、损坏数据被拒绝
+TEST(BinaryRpcCompressionTest, NegotiatesAndRejectsMalformedBodies) {
+    const std::vector<CompressionType> types = supported_types();
+    if (types.empty()) {
+        GTEST_SKIP() << "no compression library compiled in";
+    }
+    const CompressionType type = types.front();
+
+    EXPECT_EQ(BinaryRpcCompression::negotiate({type}, {type}), type);
+    EXPECT_EQ(BinaryRpcCompression::negotiate({type}, {}), CompressionType::None);
+    EXPECT_EQ(BinaryRpcCompression::negotiate({}, {type}), CompressionType::None);
+    EXPECT_EQ(BinaryRpcCompression::negotiate({static_cast<CompressionType>(99), type}, {type}), type);
+
+    std::string compressed;
+    ASSERT_TRUE(BinaryRpcCompression::maybe_compress(type, 0, repetitive_payload(4096), &compressed));
+
+    // 截断的数据、未知算法编号、声称超过上限的原始长度
+    EXPECT_EQ(BinaryRpcCompression::decompress(compressed.data(), 3), nullptr);
+    EXPECT_EQ(BinaryRpcCompression::decompress(compressed.data(), compressed.size() / 2), nullptr);
+    std::string unknown = compressed;
+    unknown[0] = static_cast<char>(99);
+    EXPECT_EQ(BinaryRpcCompression::decompress(unknown.data(), unknown.size()), nullptr);
+    std::string bomb = compressed;
+    bomb[1] = static_cast<char>(0x7F);
+    EXPECT_EQ(BinaryRpcCompression::decompress(bomb.data(), bomb.size()), nullptr);
+}
+
+// 3. 验证协商成功后大载荷双向压缩传输，线路字节数明显小于原始载荷
+TEST(BinaryRpcCompressionTest, CompressesLargePayloadsAfterNegotiation) {
+    const std::vector<CompressionType> types = supported_types();
+    if (types.empty()) {
+        GTEST_SKIP() << "no compression library compiled in";
+    }
+
+    CompressionOptions options;
+    options.accepted = types;
+    options.minBytes = 256;
+    ServerHandle handle(options);
+
+    auto loopPool = std::make_shared<BinaryRpcClientLoopPool>(1);
+    BinaryRpcChannel channel(loopPool, "127.0.0.1", handle.port);
+    channel.set_compression_options(options);
+    ASSERT_TRUE(wait_for_compression(channel));
+    EXPECT_EQ(channel.get_compression(), types.front());
+
+    const uint64_t sentBefore = channel.get_bytes_sent();
+    const uint64_t receivedBefore = channel.get_bytes_received();
+
+    TestEchoService_Stub stub(&channel);
+    const std::string payload = repetitive_payload(64 * 1024);
+    for (int index = 0; index < 4; ++index) {
+        EchoRequest request;
+        request.set_message(payload);
+        EchoResponse response;
+        stub.Echo(nullptr, &request, &response, nullptr);
+        EXPECT_EQ(response.message(), payload);
+    }
+
+    EXPECT_LT(channel.get_bytes_sent() - sentBefore, payload.size());
+    EXPECT_LT(channel.get_bytes_received() - receivedBefore, payload.size());
+
+    // 小载荷低于阈值不压缩，照常往返
+    EchoRequest request;
+    request.set_message("tiny");
+    EchoResponse response;
+    stub.Echo(nullptr, &request, &response, nullptr);
+    EXPECT_EQ(response.message(), "tiny");
+}
+
+// 4. 验证服务端未开启压缩或客户端未请求压缩时，连接退化为不压缩且调用照常成功
+TEST(BinaryRpcCompressionTest, FallsBackToUncompressedWhenEitherSideDeclines) {
+    const std::vector<CompressionType> types = supported_types();
+    CompressionOptions clientOptions;
+    clientOptions.accepted = types;
+    clientOptions.minBytes = 0;
+
+    ServerHandle plainServer{CompressionOptions()};
+    BinaryRpcChannel offering("127.0.0.1", plainServer.port);
+    offering.set_compression_options(clientOptions);
+
+    TestEchoService_Stub offeringStub(&offering);
+    const std::string payload = repetitive_payload(8 * 1024);
+    EchoRequest request;
+    request.set_message(payload);
+    EchoResponse response;
+    offeringStub.Echo(nullptr, &request, &response, nullptr);
+    EXPECT_EQ(response.message(), payload);
+    EXPECT_EQ(offering.get_compression(), CompressionType::None);
+
+    ServerHandle compressingServer(clientOptions);
+    BinaryRpcChannel plain("127.0.0.1", compressingServer.port);
+    TestEchoService_Stub plainStub(&plain);
+    response.Clear();
+    plainStub.Echo(nullptr, &request, &response, nullptr);
+    EXPECT_EQ(response.message(), payload);
+    EXPECT_EQ(plain.get_compression(), CompressionType::None);
+    EXPECT_GT(plain.get_bytes_received(), payload.size());
+}
+
+// 5. 验证每次方法表请求都会重新协商：空的接受列表（空 Body）把已协商的压缩算法重置为不压缩
+TEST(BinaryRpcCompressionTest, EmptyMethodTableOfferResetsNegotiatedCompression) {
+    const std::vector<CompressionType> types = supported_types();
+    if (types.empty()) {
+        GTEST_SKIP() << "no compression library compiled in";
+    }
+
+    CompressionOptions options;
+    options.accepted = types;
+    ServerHandle handle(options);
+
+    const int fd = connect_to(handle.port);
+    ASSERT_GE(fd, 0);
+    EXPECT_EQ(request_method_table(fd, 1, types), static_cast<int>(types.front()));
+    EXPECT_EQ(request_method_table(fd, 2, {}), static_cast<int>(CompressionType::None));
+    ::close(fd);
+}
+
+} // namespace test
+} // namespace binary
+} // namespace rpc
+} // namespace tudou
@@ -0,0 +1,262 @@
+/**
+ * @file BinaryRpcPooledChannelTest.cpp
+ * @brief 多端点、多连接、带负载均衡与断线重连的二进制 RPC 客户端通道集成测试
+ * @author wenxingming
+ * @project: https://github.com/WenXingming/Tudou
+ */
+
+#include <gtest/gtest.h>
+#include "tudou/rpc/binary/BinaryRpcServer.h"
+#include "tudou/rpc/binary/BinaryRpcPooledChannel.h"
+#include "tudou/rpc/binary/BinaryRpcClientLoopPool.h"
+#include "tudou/rpc/binary/BinaryRpcController.h"
+#include "test.pb.h"
+
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace tudou {
+namespace rpc {
+namespace binary {
+namespace test {
+
+namespace {
+
+// 预留端口
+uint16_t reserve_free_port() {
+    const int fd = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, IPPROTO_TCP);
+    if (fd < 0) {
+        return 0;
+    }
+
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = 0;
+    if (::inet_pton(AF_INET, "127.0.0.1", &addr.sin_addr) != 1
+        || ::bind(fd, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) != 0) {
+        ::close(fd);
+        return 0;
+    }
+
+    socklen_t len = sizeof(addr);
+    if (::getsockname(fd, reinterpret_cast<sockaddr*>(&addr), &len) != 0) {
+        ::close(fd);
+        return 0;
+    }
+
+    ::close(fd);
+    return ntohs(addr.sin_port);
+}
+
+// 记录处理次数的回显服务，用于观察请求在各端点之间的分布
+class CountingEchoServiceImpl : public TestEchoService {
+public:
+    void Echo(google::protobuf::RpcController*,
+              const EchoRequest* request,
+              EchoResponse* response,
+              google::protobuf::Closure* done) override {
+        ++calls;
+        response->set_message("Echo: " + request->message());
+        if (done) {
+            done->Run();
+        }
+    }
+
+    std::atomic<int> calls{0};
+};
+
+// 在后台线程运行的单个 BinaryRpcServer
+struct ServerHandle {
+    explicit ServerHandle(uint16_t listenPort)
+        : port(listenPort)
+        , service(std::make_shared<CountingEchoServiceImpl>())
+        , server(std::make_unique<BinaryRpcServer>("127.0.0.1", listenPort, 2)) {
+        server->register_service(service);
+        thread = std::thread([this]() {
+            server->start();
+        });
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    }
+
+    ~ServerHandle() {
+        server->stop();
+        if (thread.joinable()) {
+            thread.join();
+        }
+    }
+
+    uint16_t port;
+    std::shared_ptr<CountingEchoServiceImpl> service;
+    std::unique_ptr<BinaryRpcServer> server;
+    std::thread thread;
+};
+
+void echo_and_expect(TestEchoService_Stub& stub, const std::string& message) {
+    EchoRequest request;
+    request.set_message(message);
+    EchoResponse response;
+    stub.Echo(nullptr, &request, &response, nullptr);
+    EXPECT_EQ(response.message(), "Echo: " + message);
+}
+
+} // namespace
+
+// 1. 验证轮询策略把请求均匀分摊到多个端点的多条连接上
+TEST(BinaryRpcPooledChannelTest, SpreadsCallsAcrossEndpointsRoundRobin) {
+    ServerHandle first(reserve_free_port());
+    ServerHandle second(reserve_free_port());
+
+    BinaryRpcPooledChannelOptions options;
+    options.connectionsPerEndpoint = 2;
+    options.policy = LoadBalancePolicy::RoundRobin;
+
+    auto loopPool = std::make_shared<BinaryRpcClientLoopPool>(2);
+    BinaryRpcPooledChannel channel(loopPool, {{"127.0.0.1", first.port}, {"127.0.0.1", second.port}}, options);
+    EXPECT_EQ(channel.connection_count(), 4u);
+
+    TestEchoService_Stub stub(&channel);
+    for (int index = 0; index < 8; ++index) {
+        echo_and_expect(stub, "rr_" + std::to_string(index));
+    }
+
+    EXPECT_EQ(first.service->calls.load(), 4);
+    EXPECT_EQ(second.service->calls.load(), 4);
+}
+
+// 2. 验证最少挂起请求与二选一策略下，多线程并发调用全部成功
+TEST(BinaryRpcPooledChannelTest, ExecutesConcurrentCallsWithLoadAwarePolicies) {
+    ServerHandle server(reserve_free_port());
+    auto loopPool = std::make_shared<BinaryRpcClientLoopPool>(2);
+
+    for (LoadBalancePolicy policy : {LoadBalancePolicy::LeastOutstanding, LoadBalancePolicy::PowerOfTwoChoices}) {
+        BinaryRpcPooledChannelOptions options;
+        options.connectionsPerEndpoint = 3;
+        options.policy = policy;
+        BinaryRpcPooledChannel channel(loopPool, {{"127.0.0.1", server.port}}, options);
+        TestEchoService_Stub stub(&channel);
+
+        constexpr int kThreadNum = 8;
+        constexpr int kCallsPerThread = 20;
+        std::vector<std::thread> workers;
+        for (int thread = 0; thread < kThreadNum; ++thread) {
+            workers.emplace_back([&stub, thread]() {
+                for (int call = 0; call < kCallsPerThread; ++call) {
+                    echo_and_expect(stub, std::to_string(thread) + "_" + std::to_string(call));
+                }
+            });
+        }
+        for (auto& worker : workers) {
+            worker.join();
+        }
+    }
+
+    EXPECT_EQ(server.service->calls.load(), 2 * 8 * 20);
+}
+
+// 3. 验证某个端点不可达时，发往其连接的请求被转移到健康连接上完成，失效连接进入重连
+TEST(BinaryRpcPooledChannelTest, MovesPendingRequestsOffFailedConnections) {
+    ServerHandle alive(reserve_free_port());
+    const uint16_t deadPort = reserve_free_port();
+
+    BinaryRpcPooledChannelOptions options;
+    options.connectionsPerEndpoint = 2;
+    options.policy = LoadBalancePolicy::RoundRobin;
+    options.initialReconnectBackoffSeconds = 0.05;
+
+    auto loopPool = std::make_shared<BinaryRpcClientLoopPool>(2);
+    BinaryRpcPooledChannel channel(loopPool, {{"127.0.0.1", alive.port}, {"127.0.0.1", deadPort}}, options);
+    TestEchoService_Stub stub(&channel);
+
+    for (int index = 0; index < 8; ++index) {
+        echo_and_expect(stub, "failover_" + std::to_string(index));
+    }
+
+    EXPECT_EQ(alive.service->calls.load(), 8);
+    EXPECT_LE(channel.healthy_connection_count(), channel.connection_count());
+}
+
+// 4. 验证端点稍后才上线时，退避重连成功后请求重新分摊到该端点
+TEST(BinaryRpcPooledChannelTest, ReconnectsWhenEndpointComesBack) {
+    ServerHandle alive(reserve_free_port());
+    const uint16_t latePort = reserve_free_port();
+
+    BinaryRpcPooledChannelOptions options;
+    options.connectionsPerEndpoint = 1;
+    options.policy = LoadBalancePolicy::RoundRobin;
+    options.initialReconnectBackoffSeconds = 0.05;
+    options.maxReconnectBackoffSeconds = 0.1;
+
+    auto loopPool = std::make_shared<BinaryRpcClientLoopPool>(1);
+    BinaryRpcPooledChannel channel(loopPool, {{"127.0.0.1", alive.port}, {"127.0.0.1", latePort}}, options);
+    TestEchoService_Stub stub(&channel);
+
+    echo_and_expect(stub, "before");
+    echo_and_expect(stub, "before");
+
+    ServerHandle late(latePort);
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(3);
+    while (late.service->calls.load() == 0 && std::chrono::steady_clock::now() < deadline) {
+        echo_and_expect(stub, "after");
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    }
+
+    EXPECT_GT(late.service->calls.load(), 0);
+}
+
+// 5. 验证在 loop 池线程（异步回调 done 中）发起阻塞调用时立即失败，而不是等待自身线程分发的回包而死锁
+TEST(BinaryRpcPooledChannelTest, RejectsBlockingCallOnLoopPoolThread) {
+    ServerHandle server(reserve_free_port());
+    auto loopPool = std::make_shared<BinaryRpcClientLoopPool>(1);
+    BinaryRpcPooledChannel channel(loopPool, {{"127.0.0.1", server.port}});
+    TestEchoService_Stub stub(&channel);
+
+    struct NestedBlockingCall : public google::protobuf::Closure {
+        void Run() override {
+            EchoRequest nestedRequest;
+            nestedRequest.set_message("nested");
+            EchoResponse nestedResponse;
+            try {
+                stub->Echo(&controller, &nestedRequest, &nestedResponse, nullptr);
+            }
+            catch (const std::logic_error&) {
+                threw = true;
+            }
+            finished.set_value();
+        }
+
+        TestEchoService_Stub* stub = nullptr;
+        BinaryRpcController controller;
+        bool threw = false;
+        std::promise<void> finished;
+    };
+
+    NestedBlockingCall done;
+    done.stub = &stub;
+    std::future<void> finished = done.finished.get_future();
+
+    EchoRequest request;
+    request.set_message("outer");
+    EchoResponse response;
+    stub.Echo(nullptr, &request, &response, &done);
+    ASSERT_EQ(finished.wait_for(std::chrono::seconds(3)), std::future_status::ready);
+
+    EXPECT_EQ(response.message(), "Echo: outer");
+    EXPECT_TRUE(done.threw);
+    EXPECT_TRUE(done.controller.Failed());
+    EXPECT_EQ(server.service->calls.load(), 1);
+}
+
+} // namespace test
+} // namespace binary
+} // namespace rpc
+} // namespace tudou
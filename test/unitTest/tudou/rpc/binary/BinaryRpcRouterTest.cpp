@@ -8,6 +8,10 @@
 #include <gtest/gtest.h>
 #include "tudou/rpc/binary/BinaryRpcRouter.h"
 #include "test.pb.h"
+#include "binary_rpc.pb.h"
+#include <future>
+#include <stdexcept>
+#include <thread>
 
 namespace tudou {
 namespace rpc {
@@ -29,6 +33,23 @@ public:
         }
     }
 };
+
+// 延迟回包的服务：dispatch 返回后才由外部调用 done，模拟异步业务
+class DeferredEchoServiceImpl : public TestEchoService {
+public:
+    void Echo(google::protobuf::RpcController*,
+              const EchoRequest* request,
+              EchoResponse* response,
+              google::protobuf::Closure* done) override {
+        pendingRequest = request;
+        pendingResponse = response;
+        pendingDone = done;
+    }
+
+    const EchoRequest* pendingRequest = nullptr;
+    EchoResponse* pendingResponse = nullptr;
+    google::protobuf::Closure* pendingDone = nullptr;
+};
 }
 
 class BinaryRpcRouterTest : public ::testing::Test {
@@ -117,6 +138,125 @@ TEST_F(BinaryRpcRouterTest, ThrowsExceptionOnPayloadParseFailure) {
     }, std::invalid_argument);
 }
 
+// 5. 验证异步回包时，请求与响应在 done 被调用之前始终有效，且 Arena 复用后下一次调用不受影响
+TEST(BinaryRpcRouterArenaTest, KeepsMessagesAliveUntilDeferredDone) {
+    BinaryRpcRouter router;
+    auto service = std::make_shared<DeferredEchoServiceImpl>();
+    router.register_service(service);
+
+    for (int round = 0; round < 3; ++round) {
+        EchoRequest request;
+        request.set_message("deferred_" + std::to_string(round));
+        std::string requestRaw;
+        ASSERT_TRUE(request.SerializeToString(&requestRaw));
+
+        std::string outResponseRaw;
+        router.dispatch("tudou.rpc.binary.test.TestEchoService", "Echo", requestRaw,
+            [&outResponseRaw](const std::string& responseRaw) {
+                outResponseRaw = responseRaw;
+            });
+
+        // dispatch 已返回，业务仍持有请求、响应与闭包
+        ASSERT_NE(service->pendingDone, nullptr);
+        EXPECT_EQ(service->pendingRequest->message(), "deferred_" + std::to_string(round));
+        service->pendingResponse->set_message("Echo: " + service->pendingRequest->message());
+        service->pendingDone->Run();
+
+        EchoResponse response;
+        ASSERT_TRUE(response.ParseFromString(outResponseRaw));
+        EXPECT_EQ(response.message(), "Echo: deferred_" + std::to_string(round));
+        service->pendingDone = nullptr;
+    }
+}
+
+// 6. 验证方法 ID 表导出与按 ID 数组下标调度
+TEST_F(BinaryRpcRouterTest, DispatchesByNegotiatedMethodId) {
+    RpcMethodTable table;
+    router->export_method_table(&table);
+    ASSERT_EQ(table.methods_size(), 1);
+    EXPECT_EQ(table.methods(0).method_id(), 1u);
+    EXPECT_EQ(table.methods(0).service_name(), "tudou.rpc.binary.test.TestEchoService");
+    EXPECT_EQ(table.methods(0).method_name(), "Echo");
+
+    EchoRequest request;
+    request.set_message("by id");
+    std::string requestRaw;
+    ASSERT_TRUE(request.SerializeToString(&requestRaw));
+
+    std::string outResponseRaw;
+    router->dispatch(table.methods(0).method_id(), requestRaw.data(), requestRaw.size(),
+        [&outResponseRaw](const std::string& responseRaw) {
+            outResponseRaw = responseRaw;
+        });
+
+    EchoResponse response;
+    ASSERT_TRUE(response.ParseFromString(outResponseRaw));
+    EXPECT_EQ(response.message(), "Echo: by id");
+
+    // 未分配的 ID 与保留的 0 均视为未找到
+    EXPECT_THROW(router->dispatch(0u, requestRaw.data(), requestRaw.size(), [](const std::string&) {}), std::invalid_argument);
+    EXPECT_THROW(router->dispatch(2u, requestRaw.data(), requestRaw.size(), [](const std::string&) {}), std::invalid_argument);
+}
+
+// 7. 验证回包回调抛出异常时异常照常传出，同步与异步回包路径下 Arena 都被归还，后续调用不受影响
+TEST(BinaryRpcRouterArenaTest, ReleasesArenaWhenDoneCallbackThrows) {
+    EchoRequest request;
+    request.set_message("throwing");
+    std::string requestRaw;
+    ASSERT_TRUE(request.SerializeToString(&requestRaw));
+    auto throwingCallback = [](const std::string&) { throw std::runtime_error("callback failed"); };
+
+    BinaryRpcRouter syncRouter;
+    syncRouter.register_service(std::make_shared<TestEchoServiceImpl>());
+    EXPECT_THROW(syncRouter.dispatch("tudou.rpc.binary.test.TestEchoService", "Echo", requestRaw, throwingCallback),
+                 std::runtime_error);
+
+    BinaryRpcRouter deferredRouter;
+    auto service = std::make_shared<DeferredEchoServiceImpl>();
+    deferredRouter.register_service(service);
+    deferredRouter.dispatch("tudou.rpc.binary.test.TestEchoService", "Echo", requestRaw, throwingCallback);
+    ASSERT_NE(service->pendingDone, nullptr);
+    EXPECT_THROW(service->pendingDone->Run(), std::runtime_error);
+
+    std::string outResponseRaw;
+    syncRouter.dispatch("tudou.rpc.binary.test.TestEchoService", "Echo", requestRaw,
+        [&outResponseRaw](const std::string& responseRaw) {
+            outResponseRaw = responseRaw;
+        });
+    EchoResponse response;
+    ASSERT_TRUE(response.ParseFromString(outResponseRaw));
+    EXPECT_EQ(response.message(), "Echo: throwing");
+}
+
+// 8. 验证 dispatch 返回后业务在其它线程上执行 done 时，回包照常送达，Arena 由 Run() 归还
+TEST(BinaryRpcRouterArenaTest, RunsDoneOnAnotherThread) {
+    BinaryRpcRouter router;
+    auto service = std::make_shared<DeferredEchoServiceImpl>();
+    router.register_service(service);
+
+    for (int round = 0; round < 20; ++round) {
+        EchoRequest request;
+        request.set_message("threaded_" + std::to_string(round));
+        std::string requestRaw;
+        ASSERT_TRUE(request.SerializeToString(&requestRaw));
+
+        std::promise<std::string> responded;
+        router.dispatch("tudou.rpc.binary.test.TestEchoService", "Echo", requestRaw,
+            [&responded](const std::string& responseRaw) {
+                responded.set_value(responseRaw);
+            });
+        ASSERT_NE(service->pendingDone, nullptr);
+        service->pendingResponse->set_message("Echo: " + service->pendingRequest->message());
+        google::protobuf::Closure* done = service->pendingDone;
+        service->pendingDone = nullptr;
+        std::thread([done]() { done->Run(); }).join();
+
+        EchoResponse response;
+        ASSERT_TRUE(response.ParseFromString(responded.get_future().get()));
+        EXPECT_EQ(response.message(), "Echo: threaded_" + std::to_string(round));
+    }
+}
+
 } // namespace test
 } // namespace binary
 } // namespace rpc
@@ -8,6 +8,8 @@
 #include <gtest/gtest.h>
 #include "tudou/rpc/binary/BinaryRpcServer.h"
 #include "tudou/rpc/binary/BinaryRpcCodec.h"
+#include "tudou/rpc/Coroutine.h"
+#include "tudou/reactor/EventLoop.h"
 #include "binary_rpc.pb.h"
 #include "test.pb.h"
 
@@ -20,6 +22,7 @@
 #include <chrono>
 #include <memory>
 #include <cerrno>
+#include <vector>
 
 namespace tudou {
 namespace rpc {
@@ -80,6 +83,60 @@ int connect_with_retry(uint16_t port) {
     return -1;
 }
 
+// 编码一个 Echo 请求帧，timeoutMs 非 0 时携带调用时限
+std::string encode_echo_request(uint64_t sequenceId, const std::string& message, uint32_t timeoutMs = 0) {
+    RpcMeta meta;
+    meta.set_service_name("tudou.rpc.binary.test.TestEchoService");
+    meta.set_method_name("Echo");
+    meta.set_timeout_ms(timeoutMs);
+    std::string metaRaw;
+    meta.SerializeToString(&metaRaw);
+
+    EchoRequest request;
+    request.set_message(message);
+    std::string bodyRaw;
+    request.SerializeToString(&bodyRaw);
+
+    Buffer writeBuf;
+    BinaryRpcCodec::encode(&writeBuf, RpcMessageType::Request, sequenceId, metaRaw, bodyRaw);
+    return writeBuf.read_from_buffer();
+}
+
+// 编码一个取消帧
+std::string encode_cancel(uint64_t sequenceId) {
+    Buffer writeBuf;
+    BinaryRpcCodec::encode(&writeBuf, RpcMessageType::Cancel, sequenceId, "", "");
+    return writeBuf.read_from_buffer();
+}
+
+// 按到达顺序读取指定数量的响应帧，返回其 sequenceId 序列
+std::vector<uint64_t> read_response_sequence_ids(int clientFd, size_t count) {
+    std::vector<uint64_t> sequenceIds;
+    Buffer readBuf;
+    char temp[1024];
+    RpcHeader respHeader;
+    std::string respMetaRaw;
+    std::string respBodyRaw;
+
+    while (sequenceIds.size() < count) {
+        BinaryRpcCodec::DecodeResult decResult = BinaryRpcCodec::decode(&readBuf, respHeader, respMetaRaw, respBodyRaw);
+        if (decResult == BinaryRpcCodec::DecodeResult::Success) {
+            sequenceIds.push_back(respHeader.sequenceId);
+            continue;
+        }
+        if (decResult == BinaryRpcCodec::DecodeResult::Error) {
+            break;
+        }
+
+        ssize_t nr = ::read(clientFd, temp, sizeof(temp));
+        if (nr <= 0) {
+            break;
+        }
+        readBuf.write_to_buffer(temp, nr);
+    }
+    return sequenceIds;
+}
+
 } // namespace
 
 namespace {
@@ -90,6 +147,16 @@ public:
               const EchoRequest* request,
               EchoResponse* response,
               google::protobuf::Closure* done) override {
+        // 以 "suspend" 开头的请求挂起当前协程，由定时器稍后唤醒，模拟等待嵌套 RPC 回包
+        Coroutine* coro = Coroutine::t_current_coroutine;
+        if (coro != nullptr && request->message().compare(0, 7, "suspend") == 0) {
+            std::shared_ptr<Coroutine> self = coro->shared_from_this();
+            coro->get_loop()->run_after(0.1, [self]() {
+                self->resume();
+            });
+            coro->yield();
+        }
+
         response->set_message("Echo: " + request->message());
         if (done) {
             done->Run();
@@ -107,6 +174,7 @@ protected:
         // 创建 RPC 服务端并监听分配好的确定端口
         server = std::make_unique<BinaryRpcServer>("127.0.0.1", port, 0);
         server->register_service(std::make_shared<TestEchoServiceImpl>());
+        configure_server();
 
         // 启动后台 Reactor 循环线程
         serverThread = std::thread([this]() {
@@ -114,6 +182,8 @@ protected:
         });
     }
 
+    virtual void configure_server() {}
+
     void TearDown() override {
         server->stop();
         if (serverThread.joinable()) {
@@ -183,6 +253,240 @@ TEST_F(BinaryRpcServerTest, ExecutesLoopbackBinaryRpcSuccessfully) {
     ::close(clientFd);
 }
 
+TEST_F(BinaryRpcServerTest, SuspendedRequestDoesNotBlockLaterFrames) {
+    int clientFd = connect_with_retry(port);
+    ASSERT_GE(clientFd, 0);
+
+    // 同一连接上先发挂起请求，再发普通请求：后者不应被前者阻塞
+    std::string bytesToSend = encode_echo_request(1, "suspend") + encode_echo_request(2, "fast");
+    ASSERT_EQ(::write(clientFd, bytesToSend.data(), bytesToSend.size()), static_cast<ssize_t>(bytesToSend.size()));
+
+    std::vector<uint64_t> expected = {2, 1};
+    EXPECT_EQ(read_response_sequence_ids(clientFd, 2), expected);
+
+    ::close(clientFd);
+}
+
+class BinaryRpcServerInFlightLimitTest : public BinaryRpcServerTest {
+protected:
+    void configure_server() override {
+        server->set_max_in_flight_per_connection(1);
+    }
+};
+
+TEST_F(BinaryRpcServerInFlightLimitTest, InFlightLimitDefersLaterFrames) {
+    int clientFd = connect_with_retry(port);
+    ASSERT_GE(clientFd, 0);
+
+    // 在途上限为 1：挂起请求回包之前，后续帧不会被派发，响应保持发送顺序
+    std::string bytesToSend = encode_echo_request(1, "suspend") + encode_echo_request(2, "fast")
+                            + encode_echo_request(3, "suspend again");
+    ASSERT_EQ(::write(clientFd, bytesToSend.data(), bytesToSend.size()), static_cast<ssize_t>(bytesToSend.size()));
+
+    std::vector<uint64_t> expected = {1, 2, 3};
+    EXPECT_EQ(read_response_sequence_ids(clientFd, 3), expected);
+
+    ::close(clientFd);
+}
+
+TEST_F(BinaryRpcServerInFlightLimitTest, SkipsRequestsExpiredWhileDeferred) {
+    int clientFd = connect_with_retry(port);
+    ASSERT_GE(clientFd, 0);
+
+    // 序列号 2 的时限远短于序列号 1 的挂起时间，轮到它派发时已过期，不执行也不回包
+    std::string bytesToSend = encode_echo_request(1, "suspend") + encode_echo_request(2, "fast", 20)
+                            + encode_echo_request(3, "fast again");
+    ASSERT_EQ(::write(clientFd, bytesToSend.data(), bytesToSend.size()), static_cast<ssize_t>(bytesToSend.size()));
+
+    std::vector<uint64_t> expected = {1, 3};
+    EXPECT_EQ(read_response_sequence_ids(clientFd, 2), expected);
+    EXPECT_EQ(server->get_expired_request_count(), 1u);
+
+    ::close(clientFd);
+}
+
+TEST_F(BinaryRpcServerTest, DropsResponseOfCancelledRequest) {
+    int clientFd = connect_with_retry(port);
+    ASSERT_GE(clientFd, 0);
+
+    // 序列号 1 挂起期间被取消，服务端不再为它回包；之后的请求照常响应
+    std::string bytesToSend = encode_echo_request(1, "suspend") + encode_cancel(1);
+    ASSERT_EQ(::write(clientFd, bytesToSend.data(), bytesToSend.size()), static_cast<ssize_t>(bytesToSend.size()));
+    std::this_thread::sleep_for(std::chrono::milliseconds(150));
+
+    bytesToSend = encode_echo_request(2, "fast");
+    ASSERT_EQ(::write(clientFd, bytesToSend.data(), bytesToSend.size()), static_cast<ssize_t>(bytesToSend.size()));
+
+    std::vector<uint64_t> expected = {2};
+    EXPECT_EQ(read_response_sequence_ids(clientFd, 1), expected);
+    EXPECT_EQ(server->get_cancelled_request_count(), 1u);
+
+    ::close(clientFd);
+}
+
+TEST_F(BinaryRpcServerTest, RepliesErrorWhenDispatchFails) {
+    int clientFd = connect_with_retry(port);
+    ASSERT_GE(clientFd, 0);
+
+    // 方法不存在时派发抛出异常：服务端以带 error_text 的响应帧回包，客户端不必等到超时；连接继续可用
+    RpcMeta meta;
+    meta.set_service_name("tudou.rpc.binary.test.TestEchoService");
+    meta.set_method_name("Missing");
+    std::string metaRaw;
+    ASSERT_TRUE(meta.SerializeToString(&metaRaw));
+    Buffer writeBuf;
+    BinaryRpcCodec::encode(&writeBuf, RpcMessageType::Request, 5, metaRaw, "");
+    std::string bytesToSend = writeBuf.read_from_buffer() + encode_echo_request(6, "fast");
+    ASSERT_EQ(::write(clientFd, bytesToSend.data(), bytesToSend.size()), static_cast<ssize_t>(bytesToSend.size()));
+
+    Buffer readBuf;
+    char temp[1024];
+    RpcHeader respHeader;
+    std::string respMetaRaw;
+    std::string respBodyRaw;
+    std::vector<uint64_t> sequenceIds;
+    while (sequenceIds.size() < 2) {
+        BinaryRpcCodec::DecodeResult decResult = BinaryRpcCodec::decode(&readBuf, respHeader, respMetaRaw, respBodyRaw);
+        if (decResult == BinaryRpcCodec::DecodeResult::Success) {
+            sequenceIds.push_back(respHeader.sequenceId);
+            EXPECT_EQ(static_cast<RpcMessageType>(respHeader.type), RpcMessageType::Response);
+            RpcMeta respMeta;
+            ASSERT_TRUE(respMeta.ParseFromString(respMetaRaw));
+            EXPECT_EQ(respMeta.error_text().empty(), respHeader.sequenceId == 6);
+            continue;
+        }
+        ASSERT_NE(decResult, BinaryRpcCodec::DecodeResult::Error);
+        ssize_t nr = ::read(clientFd, temp, sizeof(temp));
+        ASSERT_GT(nr, 0);
+        readBuf.write_to_buffer(temp, nr);
+    }
+
+    std::vector<uint64_t> expected = {5, 6};
+    EXPECT_EQ(sequenceIds, expected);
+
+    ::close(clientFd);
+}
+
+TEST_F(BinaryRpcServerTest, ClosesConnectionOnDuplicateInFlightSequenceId) {
+    int clientFd = connect_with_retry(port);
+    ASSERT_GE(clientFd, 0);
+
+    // 序列号 1 仍挂起时再次使用：服务端视为协议错误关闭连接，两个请求都不回包
+    std::string bytesToSend = encode_echo_request(1, "suspend") + encode_echo_request(1, "fast");
+    ASSERT_EQ(::write(clientFd, bytesToSend.data(), bytesToSend.size()), static_cast<ssize_t>(bytesToSend.size()));
+
+    EXPECT_TRUE(read_response_sequence_ids(clientFd, 1).empty());
+
+    ::close(clientFd);
+}
+
+class BinaryRpcServerAdmissionTest : public BinaryRpcServerTest {
+protected:
+    void configure_server() override {
+        AdmissionOptions options;
+        options.maxConcurrency = 1;
+        server->set_admission_options(options);
+    }
+};
+
+TEST_F(BinaryRpcServerAdmissionTest, RejectsRequestsBeyondServerConcurrencyLimit) {
+    int clientFd = connect_with_retry(port);
+    ASSERT_GE(clientFd, 0);
+
+    // 服务端名额为 1：挂起请求占用名额期间，后续请求立即以过载错误回包，而不是排在其后
+    std::string bytesToSend = encode_echo_request(1, "suspend") + encode_echo_request(2, "fast");
+    ASSERT_EQ(::write(clientFd, bytesToSend.data(), bytesToSend.size()), static_cast<ssize_t>(bytesToSend.size()));
+
+    Buffer readBuf;
+    char temp[1024];
+    RpcHeader respHeader;
+    std::string respMetaRaw;
+    std::string respBodyRaw;
+    std::vector<uint64_t> sequenceIds;
+    while (sequenceIds.size() < 2) {
+        BinaryRpcCodec::DecodeResult decResult = BinaryRpcCodec::decode(&readBuf, respHeader, respMetaRaw, respBodyRaw);
+        if (decResult == BinaryRpcCodec::DecodeResult::Success) {
+            sequenceIds.push_back(respHeader.sequenceId);
+            RpcMeta meta;
+            ASSERT_TRUE(meta.ParseFromString(respMetaRaw));
+            EXPECT_EQ(meta.error_text().empty(), respHeader.sequenceId == 1);
+            continue;
+        }
+        ASSERT_NE(decResult, BinaryRpcCodec::DecodeResult::Error);
+        ssize_t nr = ::read(clientFd, temp, sizeof(temp));
+        ASSERT_GT(nr, 0);
+        readBuf.write_to_buffer(temp, nr);
+    }
+
+    std::vector<uint64_t> expected = {2, 1};
+    EXPECT_EQ(sequenceIds, expected);
+    EXPECT_EQ(server->get_rejected_request_count(), 1u);
+
+    ::close(clientFd);
+}
+
+TEST_F(BinaryRpcServerTest, NegotiatesMethodIdsAndDispatchesById) {
+    int clientFd = connect_with_retry(port);
+    ASSERT_GE(clientFd, 0);
+
+    // 1. 请求方法表
+    Buffer negotiateBuf;
+    BinaryRpcCodec::encode(&negotiateBuf, RpcMessageType::MethodTable, 1, "", "", kRpcVersionMethodId);
+    std::string negotiateBytes = negotiateBuf.read_from_buffer();
+    ASSERT_EQ(::write(clientFd, negotiateBytes.data(), negotiateBytes.size()), static_cast<ssize_t>(negotiateBytes.size()));
+
+    Buffer readBuf;
+    char temp[1024];
+    RpcHeader respHeader;
+    std::string respMetaRaw;
+    std::string respBodyRaw;
+    auto read_frame = [&]() {
+        while (true) {
+            BinaryRpcCodec::DecodeResult decResult = BinaryRpcCodec::decode(&readBuf, respHeader, respMetaRaw, respBodyRaw);
+            if (decResult == BinaryRpcCodec::DecodeResult::Success) {
+                return true;
+            }
+            ssize_t nr = ::read(clientFd, temp, sizeof(temp));
+            if (nr <= 0 || decResult == BinaryRpcCodec::DecodeResult::Error) {
+                return false;
+            }
+            readBuf.write_to_buffer(temp, nr);
+        }
+    };
+
+    ASSERT_TRUE(read_frame());
+    EXPECT_EQ(static_cast<RpcMessageType>(respHeader.type), RpcMessageType::MethodTable);
+    RpcMethodTable table;
+    ASSERT_TRUE(table.ParseFromString(respBodyRaw));
+    ASSERT_EQ(table.methods_size(), 1);
+    EXPECT_EQ(table.methods(0).method_name(), "Echo");
+
+    // 2. 只携带方法 ID 发起调用
+    RpcMeta meta;
+    meta.set_method_id(table.methods(0).method_id());
+    std::string metaRaw;
+    ASSERT_TRUE(meta.SerializeToString(&metaRaw));
+
+    EchoRequest request;
+    request.set_message("compact");
+    std::string bodyRaw;
+    ASSERT_TRUE(request.SerializeToString(&bodyRaw));
+
+    Buffer writeBuf;
+    BinaryRpcCodec::encode(&writeBuf, RpcMessageType::Request, 2, metaRaw, bodyRaw, kRpcVersionMethodId);
+    std::string bytesToSend = writeBuf.read_from_buffer();
+    ASSERT_EQ(::write(clientFd, bytesToSend.data(), bytesToSend.size()), static_cast<ssize_t>(bytesToSend.size()));
+
+    ASSERT_TRUE(read_frame());
+    EXPECT_EQ(respHeader.sequenceId, 2u);
+    EXPECT_EQ(respHeader.version, kRpcVersionMethodId);
+    EchoResponse response;
+    ASSERT_TRUE(response.ParseFromString(respBodyRaw));
+    EXPECT_EQ(response.message(), "Echo: compact");
+
+    ::close(clientFd);
+}
+
 } // namespace test
 } // namespace binary
 } // namespace rpc
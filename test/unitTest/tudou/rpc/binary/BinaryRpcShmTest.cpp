@@ -0,0 +1,161 @@
+/**
+ * @file BinaryRpcShmTest.cpp
+ * @brief 二进制 RPC 经 Unix 域 socket 与共享内存环形缓冲传输的集成测试
+ * @author wenxingming
+ * @project: https://github.com/WenXingming/Tudou
+ */
+
+#include <gtest/gtest.h>
+#include "tudou/rpc/binary/BinaryRpcServer.h"
+#include "tudou/rpc/binary/BinaryRpcChannel.h"
+#include "tudou/rpc/binary/BinaryRpcClientLoopPool.h"
+#include "tudou/rpc/binary/BinaryRpcStream.h"
+#include "tudou/tcp/InetAddress.h"
+#include "test.pb.h"
+
+#include <unistd.h>
+#include <chrono>
+#include <future>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace tudou {
+namespace rpc {
+namespace binary {
+namespace test {
+
+namespace {
+
+class EchoServiceImpl : public TestEchoService {
+public:
+    void Echo(google::protobuf::RpcController*,
+              const EchoRequest* request,
+              EchoResponse* response,
+              google::protobuf::Closure* done) override {
+        response->set_message(request->message());
+        if (done) {
+            done->Run();
+        }
+    }
+};
+
+// 每个测试使用独立的抽象命名空间地址，互不干扰且不留下 socket 文件
+std::string unique_name(const std::string& tag) {
+    return "@tudou-rpc-shm-test-" + tag + "-" + std::to_string(::getpid());
+}
+
+// 在后台线程运行、监听 Unix 域地址并开放共享内存通道的 BinaryRpcServer
+struct ServerHandle {
+    ServerHandle(const std::string& tag, size_t ringCapacity)
+        : socketPath(unique_name(tag + "-sock"))
+        , shmPath(unique_name(tag + "-shm"))
+        , server(std::make_unique<BinaryRpcServer>(InetAddress::from_unix_path(socketPath), 2)) {
+        server->register_service(std::make_shared<EchoServiceImpl>());
+        server->listen_shared_memory(shmPath, ringCapacity);
+        thread = std::thread([this]() {
+            server->start();
+        });
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    }
+
+    ~ServerHandle() {
+        shutdown();
+    }
+
+    void shutdown() {
+        server->stop();
+        if (thread.joinable()) {
+            thread.join();
+        }
+    }
+
+    std::string socketPath;
+    std::string shmPath;
+    std::unique_ptr<BinaryRpcServer> server;
+    std::thread thread;
+};
+
+std::string echo(BinaryRpcChannel& channel, const std::string& message) {
+    TestEchoService_Stub stub(&channel);
+    EchoRequest request;
+    request.set_message(message);
+    EchoResponse response;
+    stub.Echo(nullptr, &request, &response, nullptr);
+    return response.message();
+}
+
+} // namespace
+
+// 1. 验证服务端监听 Unix 域地址时，阻塞线程与共享 loop 池两种客户端均可经 Unix 域 socket 完成调用
+TEST(BinaryRpcShmTest, UnaryCallsOverUnixDomainSocket) {
+    ServerHandle handle("uds", BinaryRpcShmTransport::kDefaultRingCapacity);
+    const InetAddress address = InetAddress::from_unix_path(handle.socketPath);
+
+    BinaryRpcChannel blocking(address);
+    EXPECT_EQ(echo(blocking, "over uds"), "over uds");
+
+    auto loopPool = std::make_shared<BinaryRpcClientLoopPool>(1);
+    BinaryRpcChannel pooled(loopPool, address);
+    EXPECT_EQ(echo(pooled, "over uds pooled"), "over uds pooled");
+}
+
+// 2. 验证共享内存通道上的一元调用：顺序调用、流水线并发调用，以及远大于环容量的载荷分段穿过环
+TEST(BinaryRpcShmTest, UnaryCallsOverSharedMemoryRings) {
+    ServerHandle handle("rings", 4096);
+    auto loopPool = std::make_shared<BinaryRpcClientLoopPool>(1);
+    BinaryRpcChannel channel(loopPool, InetAddress::from_unix_path(handle.shmPath), ChannelTransport::SharedMemory);
+
+    for (int index = 0; index < 50; ++index) {
+        const std::string message = "shm_" + std::to_string(index);
+        EXPECT_EQ(echo(channel, message), message);
+    }
+
+    const google::protobuf::MethodDescriptor* method = TestEchoService::descriptor()->FindMethodByName("Echo");
+    std::vector<EchoRequest> requests(200);
+    std::vector<EchoResponse> responses(200);
+    std::vector<std::future<void>> futures;
+    for (size_t index = 0; index < requests.size(); ++index) {
+        requests[index].set_message(std::string(index * 37 % 900, 'p') + std::to_string(index));
+        futures.push_back(channel.call_async(method, &requests[index], &responses[index]));
+    }
+    for (size_t index = 0; index < futures.size(); ++index) {
+        futures[index].get();
+        EXPECT_EQ(responses[index].message(), requests[index].message());
+    }
+
+    const std::string large(256 * 1024, 'L');
+    EXPECT_EQ(echo(channel, large), large);
+    EXPECT_GT(channel.get_bytes_sent(), large.size());
+    EXPECT_GT(channel.get_bytes_received(), large.size());
+}
+
+// 3. 验证共享内存通道拒绝流式调用，服务端退出后客户端感知连接失效，且非 Unix 域地址无法建立共享内存通道
+TEST(BinaryRpcShmTest, RejectsStreamsAndDetectsServerExit) {
+    auto loopPool = std::make_shared<BinaryRpcClientLoopPool>(1);
+    EXPECT_THROW(BinaryRpcChannel(loopPool, InetAddress("127.0.0.1", 1), ChannelTransport::SharedMemory),
+                 std::invalid_argument);
+
+    ServerHandle handle("exit", BinaryRpcShmTransport::kDefaultRingCapacity);
+    BinaryRpcChannel channel(loopPool, InetAddress::from_unix_path(handle.shmPath), ChannelTransport::SharedMemory);
+    EXPECT_EQ(echo(channel, "before exit"), "before exit");
+
+    std::shared_ptr<BinaryRpcStream> stream = channel.open_stream(TestStreamService::descriptor()->FindMethodByName("Chat"));
+    EchoResponse response;
+    EXPECT_FALSE(stream->read(&response));
+    EXPECT_NE(stream->get_error().find("not supported"), std::string::npos);
+
+    handle.shutdown();
+    for (int attempt = 0; attempt < 100 && !channel.is_closed(); ++attempt) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    EXPECT_TRUE(channel.is_closed());
+    EXPECT_THROW(echo(channel, "after exit"), std::runtime_error);
+}
+
+} // namespace test
+} // namespace binary
+} // namespace rpc
+} // namespace tudou
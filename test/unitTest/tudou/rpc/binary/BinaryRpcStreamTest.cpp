@@ -0,0 +1,326 @@
+/**
+ * @file BinaryRpcStreamTest.cpp
+ * @brief 二进制 RPC 流式调用（服务端流、双向流、流控窗口与取消）集成测试
+ * @author wenxingming
+ * @project: https://github.com/WenXingming/Tudou
+ */
+
+#include <gtest/gtest.h>
+#include "tudou/rpc/binary/BinaryRpcServer.h"
+#include "tudou/rpc/binary/BinaryRpcChannel.h"
+#include "tudou/rpc/binary/BinaryRpcClientLoopPool.h"
+#include "tudou/rpc/binary/BinaryRpcStream.h"
+#include "tudou/rpc/Coroutine.h"
+#include "tudou/reactor/EventLoop.h"
+#include "test.pb.h"
+
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+namespace tudou {
+namespace rpc {
+namespace binary {
+namespace test {
+
+namespace {
+
+// 预留端口
+uint16_t reserve_free_port() {
+    const int fd = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, IPPROTO_TCP);
+    if (fd < 0) {
+        return 0;
+    }
+
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = 0;
+    if (::inet_pton(AF_INET, "127.0.0.1", &addr.sin_addr) != 1
+        || ::bind(fd, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) != 0) {
+        ::close(fd);
+        return 0;
+    }
+
+    socklen_t len = sizeof(addr);
+    if (::getsockname(fd, reinterpret_cast<sockaddr*>(&addr), &len) != 0) {
+        ::close(fd);
+        return 0;
+    }
+
+    ::close(fd);
+    return ntohs(addr.sin_port);
+}
+
+const google::protobuf::MethodDescriptor* chat_method() {
+    return TestStreamService::descriptor()->FindMethodByName("Chat");
+}
+
+// 在后台线程运行、只注册了 Chat 流处理函数的 BinaryRpcServer
+struct StreamServerHandle {
+    explicit StreamServerHandle(BinaryRpcRouter::StreamHandler handler)
+        : port(reserve_free_port())
+        , server(std::make_unique<BinaryRpcServer>("127.0.0.1", port, 2)) {
+        server->register_stream_handler(chat_method(), std::move(handler));
+        thread = std::thread([this]() {
+            server->start();
+        });
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    }
+
+    ~StreamServerHandle() {
+        server->stop();
+        if (thread.joinable()) {
+            thread.join();
+        }
+    }
+
+    uint16_t port;
+    std::unique_ptr<BinaryRpcServer> server;
+    std::thread thread;
+};
+
+// 一元 Echo 挂起所在协程、直到同一连接上的流收到 "release" 才回包，用于占满单连接在途名额
+struct ParkedRequest {
+    std::shared_ptr<Coroutine> coroutine; // 仅在服务端连接所属 loop 线程上读写
+    std::atomic<bool> parked{false};
+};
+
+class ParkingEchoService : public TestEchoService {
+public:
+    explicit ParkingEchoService(std::shared_ptr<ParkedRequest> parked)
+        : parked_(std::move(parked)) {
+    }
+
+    void Echo(google::protobuf::RpcController*,
+              const EchoRequest* request,
+              EchoResponse* response,
+              google::protobuf::Closure* done) override {
+        Coroutine* coro = Coroutine::t_current_coroutine;
+        if (coro != nullptr) {
+            parked_->coroutine = coro->shared_from_this();
+            parked_->parked = true;
+            coro->yield();
+        }
+        response->set_message("Echo: " + request->message());
+        done->Run();
+    }
+
+private:
+    std::shared_ptr<ParkedRequest> parked_;
+};
+
+class PromiseClosure : public google::protobuf::Closure {
+public:
+    void Run() override { promise.set_value(); }
+
+    std::promise<void> promise;
+};
+
+} // namespace
+
+// 1. 验证服务端流：单条请求换回远多于窗口大小的结果集，顺序完整，流正常结束
+TEST(BinaryRpcStreamTest, ServerStreamsManyMessagesThroughSmallWindow) {
+    StreamServerHandle handle([](BinaryRpcStream& stream) {
+        EchoRequest request;
+        if (!stream.read(&request)) {
+            return;
+        }
+        const int count = std::stoi(request.message());
+        for (int index = 0; index < count; ++index) {
+            EchoResponse response;
+            response.set_message("row_" + std::to_string(index));
+            if (!stream.write(response)) {
+                return;
+            }
+        }
+    });
+
+    BinaryRpcChannel channel("127.0.0.1", handle.port);
+    std::shared_ptr<BinaryRpcStream> stream = channel.open_stream(chat_method(), 4);
+
+    EchoRequest request;
+    request.set_message("200");
+    ASSERT_TRUE(stream->write(request));
+    stream->writes_done();
+
+    EchoResponse response;
+    int received = 0;
+    while (stream->read(&response)) {
+        EXPECT_EQ(response.message(), "row_" + std::to_string(received));
+        ++received;
+    }
+    EXPECT_EQ(received, 200);
+    EXPECT_TRUE(stream->get_error().empty());
+    EXPECT_FALSE(stream->is_cancelled());
+}
+
+// 2. 验证共享 loop 池模式下的双向流：逐条请求逐条回显，客户端半关闭后服务端结束流
+TEST(BinaryRpcStreamTest, BidirectionalEchoOverClientLoopPool) {
+    StreamServerHandle handle([](BinaryRpcStream& stream) {
+        EchoRequest request;
+        while (stream.read(&request)) {
+            EchoResponse response;
+            response.set_message("Echo: " + request.message());
+            stream.write(response);
+        }
+    });
+
+    auto loopPool = std::make_shared<BinaryRpcClientLoopPool>(1);
+    BinaryRpcChannel channel(loopPool, "127.0.0.1", handle.port);
+    std::shared_ptr<BinaryRpcStream> stream = channel.open_stream(chat_method(), 2);
+
+    for (int index = 0; index < 20; ++index) {
+        EchoRequest request;
+        request.set_message("msg_" + std::to_string(index));
+        ASSERT_TRUE(stream->write(request));
+
+        EchoResponse response;
+        ASSERT_TRUE(stream->read(&response));
+        EXPECT_EQ(response.message(), "Echo: msg_" + std::to_string(index));
+    }
+
+    stream->writes_done();
+    EchoResponse response;
+    EXPECT_FALSE(stream->read(&response));
+    EXPECT_TRUE(stream->get_error().empty());
+}
+
+// 3. 验证流控窗口限制在途消息数，客户端取消后服务端挂起中的 write() 立即返回 false
+TEST(BinaryRpcStreamTest, WindowBoundsUnreadMessagesAndCancelReachesServer) {
+    std::atomic<int> written{0};
+    std::atomic<bool> observedCancel{false};
+    StreamServerHandle handle([&written, &observedCancel](BinaryRpcStream& stream) {
+        for (int index = 0; index < 1000; ++index) {
+            EchoResponse response;
+            response.set_message(std::string(64, 'x'));
+            if (!stream.write(response)) {
+                observedCancel = stream.is_cancelled();
+                return;
+            }
+            ++written;
+        }
+    });
+
+    BinaryRpcChannel channel("127.0.0.1", handle.port);
+    std::shared_ptr<BinaryRpcStream> stream = channel.open_stream(chat_method(), 8);
+
+    // 客户端不读取：服务端只能写出一个窗口的消息
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    EXPECT_EQ(written.load(), 8);
+
+    stream->cancel("client gave up");
+    EchoResponse response;
+    EXPECT_FALSE(stream->read(&response));
+    EXPECT_TRUE(stream->is_cancelled());
+
+    for (int attempt = 0; attempt < 100 && !observedCancel; ++attempt) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    EXPECT_TRUE(observedCancel.load());
+    EXPECT_EQ(written.load(), 8);
+}
+
+// 4. 验证打开未注册的流式方法或处理函数抛出异常时，客户端 read() 返回 false 并给出错误原因
+TEST(BinaryRpcStreamTest, ReportsUnknownMethodAndHandlerFailure) {
+    StreamServerHandle handle([](BinaryRpcStream&) {
+        throw std::runtime_error("handler failed");
+    });
+
+    BinaryRpcChannel channel("127.0.0.1", handle.port);
+    EchoResponse response;
+
+    std::shared_ptr<BinaryRpcStream> unknown =
+        channel.open_stream(TestEchoService::descriptor()->FindMethodByName("Echo"));
+    EXPECT_FALSE(unknown->read(&response));
+    EXPECT_NE(unknown->get_error().find("not found"), std::string::npos);
+
+    std::shared_ptr<BinaryRpcStream> failing = channel.open_stream(chat_method());
+    EXPECT_FALSE(failing->read(&response));
+    EXPECT_EQ(failing->get_error(), "handler failed");
+
+    // 流式调用失败不影响同一连接上的后续流
+    std::shared_ptr<BinaryRpcStream> another = channel.open_stream(chat_method());
+    EXPECT_FALSE(another->read(&response));
+    EXPECT_EQ(another->get_error(), "handler failed");
+}
+
+// 5. 验证单连接在途名额被一元请求占满时，已打开流上的消息与窗口更新照常送达，不会与等待流推进的请求互相卡死
+TEST(BinaryRpcStreamTest, OpenStreamKeepsFlowingAtInFlightLimit) {
+    auto parked = std::make_shared<ParkedRequest>();
+    const uint16_t port = reserve_free_port();
+    BinaryRpcServer server("127.0.0.1", port, 1);
+    server.set_max_in_flight_per_connection(1);
+    server.register_service(std::make_shared<ParkingEchoService>(parked));
+    server.register_stream_handler(chat_method(), [parked](BinaryRpcStream& stream) {
+        EchoRequest request;
+        while (stream.read(&request)) {
+            if (request.message() == "release" && parked->coroutine) {
+                std::shared_ptr<Coroutine> coro = std::move(parked->coroutine);
+                coro->get_loop()->queue_in_loop([coro]() {
+                    coro->resume();
+                });
+            }
+            EchoResponse response;
+            response.set_message("Echo: " + request.message());
+            stream.write(response);
+        }
+    });
+    std::thread serverThread([&server]() {
+        server.start();
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+    auto loopPool = std::make_shared<BinaryRpcClientLoopPool>(1);
+    BinaryRpcChannel channel(loopPool, "127.0.0.1", port);
+    std::shared_ptr<BinaryRpcStream> stream = channel.open_stream(chat_method(), 2);
+
+    // 先完成一轮往返，确保流在名额被占满之前已经打开
+    EchoRequest request;
+    request.set_message("ping");
+    ASSERT_TRUE(stream->write(request));
+    EchoResponse response;
+    ASSERT_TRUE(stream->read(&response));
+    EXPECT_EQ(response.message(), "Echo: ping");
+
+    TestEchoService_Stub stub(&channel);
+    EchoRequest unaryReq;
+    unaryReq.set_message("parked");
+    EchoResponse unaryResp;
+    PromiseClosure done;
+    std::future<void> doneFuture = done.promise.get_future();
+    stub.Echo(nullptr, &unaryReq, &unaryResp, &done);
+    for (int attempt = 0; attempt < 200 && !parked->parked; ++attempt) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    ASSERT_TRUE(parked->parked.load());
+
+    // 名额已满：流消息仍需送达服务端，才能唤醒挂起的一元请求
+    for (int index = 0; index < 4; ++index) {
+        request.set_message(index == 3 ? "release" : "msg_" + std::to_string(index));
+        ASSERT_TRUE(stream->write(request));
+        ASSERT_TRUE(stream->read(&response));
+        EXPECT_EQ(response.message(), "Echo: " + request.message());
+    }
+    ASSERT_EQ(doneFuture.wait_for(std::chrono::seconds(5)), std::future_status::ready);
+    EXPECT_EQ(unaryResp.message(), "Echo: parked");
+
+    stream->writes_done();
+    EXPECT_FALSE(stream->read(&response));
+    EXPECT_TRUE(stream->get_error().empty());
+
+    server.stop();
+    serverThread.join();
+}
+
+} // namespace test
+} // namespace binary
+} // namespace rpc
+} // namespace tudou
@@ -121,6 +121,43 @@ TEST_F(JsonRpcClientTest, ThrowsExceptionOnInvalidParams) {
     }, std::runtime_error);
 }
 
+// 4. 测试服务端监听 "::" 时以双栈方式同时服务 IPv6 与 IPv4 客户端
+TEST(JsonRpcClientDualStackTest, ServesIpv6AndIpv4ClientsOnOneListener) {
+    const int probeFd = ::socket(AF_INET6, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    sockaddr_in6 loopback{};
+    loopback.sin6_family = AF_INET6;
+    loopback.sin6_addr = in6addr_loopback;
+    const bool ipv6Available = probeFd >= 0
+        && ::bind(probeFd, reinterpret_cast<const sockaddr*>(&loopback), sizeof(loopback)) == 0;
+    if (probeFd >= 0) {
+        ::close(probeFd);
+    }
+    if (!ipv6Available) {
+        GTEST_SKIP() << "IPv6 loopback is not available";
+    }
+
+    const uint16_t port = reserve_free_port();
+    ASSERT_GT(port, 0);
+    JsonRpcServer server("::", port, 0);
+    server.register_method("echo", [](const nlohmann::json& params) {
+        return params.at(0);
+    });
+    std::thread serverThread([&server]() {
+        server.start();
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+    JsonRpcClient v6Client("::1", port);
+    EXPECT_EQ(v6Client.call("echo", nlohmann::json::array({"v6"})).get<std::string>(), "v6");
+    JsonRpcClient bracketedClient("[::1]", port);
+    EXPECT_EQ(bracketedClient.call("echo", nlohmann::json::array({"bracketed"})).get<std::string>(), "bracketed");
+    JsonRpcClient v4Client("127.0.0.1", port);
+    EXPECT_EQ(v4Client.call("echo", nlohmann::json::array({"v4"})).get<std::string>(), "v4");
+
+    server.stop();
+    serverThread.join();
+}
+
 } // namespace test
 } // namespace rpc
 } // namespace tudou
@@ -6,6 +6,14 @@
  */
 
 #include <gtest/gtest.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
 #include "tudou/rpc/json/JsonRpcRouter.h"
 
 class JsonRpcRouterTest : public ::testing::Test {
@@ -148,3 +156,321 @@ TEST_F(JsonRpcRouterTest, ProcessesBatchRequestsCorrectly) {
     // 验证通知逻辑也在此批量中被正确执行
     EXPECT_TRUE(notificationTriggered);
 }
+
+namespace {
+
+// 为两种后端注册同样的方法，便于逐条比对响应
+void register_conformance_methods(JsonRpcRouter& router, int& notifications) {
+    router.register_method("add", [](const nlohmann::json& params) {
+        if (!params.is_array() || params.size() != 2) {
+            throw std::invalid_argument("params must be an array of size 2");
+        }
+        return params[0].get<int>() + params[1].get<int>();
+    });
+    router.register_method("echo", [](const nlohmann::json& params) {
+        return params;
+    });
+    router.register_method("fail", [](const nlohmann::json&) -> nlohmann::json {
+        throw std::runtime_error("boom");
+    });
+    router.register_method("notify_test", [&notifications](const nlohmann::json&) {
+        ++notifications;
+        return nullptr;
+    });
+    // 原始文本处理器：把 params 原样包进结果对象
+    router.register_raw_method("raw.wrap", [](const char* params, size_t len, std::string& result) {
+        result.append("{\"wrapped\":");
+        result.append(params, len);
+        result.push_back('}');
+    });
+    router.register_raw_method("raw.fail", [](const char*, size_t, std::string& result) {
+        result.append("{\"partial\":");
+        throw std::invalid_argument("raw handler rejected params");
+    });
+}
+
+} // namespace
+
+// 8. OnDemand 后端与 nlohmann 后端对同一批请求给出等价的响应
+TEST(JsonRpcRouterBackendTest, OnDemandBackendMatchesNlohmannBackend) {
+    if (!JsonRpcRouter::is_backend_available(JsonRpcRouter::Backend::OnDemand)) {
+        JsonRpcRouter router;
+        EXPECT_FALSE(router.set_backend(JsonRpcRouter::Backend::OnDemand));
+        EXPECT_EQ(router.get_backend(), JsonRpcRouter::Backend::Nlohmann);
+        GTEST_SKIP() << "simdjson not available in this build";
+    }
+
+    JsonRpcRouter dom;
+    JsonRpcRouter onDemand;
+    int domNotifications = 0;
+    int onDemandNotifications = 0;
+    register_conformance_methods(dom, domNotifications);
+    register_conformance_methods(onDemand, onDemandNotifications);
+    ASSERT_TRUE(onDemand.set_backend(JsonRpcRouter::Backend::OnDemand));
+
+    const std::vector<std::string> requests = {
+        R"({"jsonrpc": "2.0", "method": "add", "params": [3, 4], "id": 1})",
+        R"({"id": "abc", "params": {"k": [1, {"x": null}]}, "method": "echo", "jsonrpc": "2.0", "extra": {"ignored": true}})",
+        R"({"jsonrpc": "2.0", "method": "echo", "id": 1.5e3})",
+        R"({"jsonrpc": "2.0", "method": "echo", "params": [], "id": null})",
+        R"({"jsonrpc": "2.0", "method": "echo", "params": ["中\n"], "id": 2})",
+        R"({"jsonrpc": "2.0", "method": "add", "params": "not_an_array", "id": 3})",
+        R"({"jsonrpc": "2.0", "method": "add", "params": 5, "id": 4})",
+        R"({"jsonrpc": "2.0", "method": "missing", "id": 5})",
+        R"({"jsonrpc": "2.0", "method": "fail", "id": 6})",
+        R"({"jsonrpc": "1.0", "method": "add", "params": [1, 2], "id": 7})",
+        R"({"jsonrpc": 2.0, "method": "add", "params": [1, 2], "id": 8})",
+        R"({"jsonrpc": "2.0", "method": 42, "id": 9})",
+        R"({"jsonrpc": "2.0", "method": "add", "params": [1, 2], "id": [10]})",
+        R"({"jsonrpc": "2.0", "method": "add", "params": [1, 2]})",
+        R"({"jsonrpc": "2.0", "method": "fail"})",
+        R"({"jsonrpc": "2.0", "method": "raw.wrap", "params": {"a": [1, 2]}, "id": 11})",
+        R"({"jsonrpc": "2.0", "method": "raw.wrap", "id": 12})",
+        R"({"jsonrpc": "2.0", "method": "raw.fail", "params": [], "id": 13})",
+        R"([{"jsonrpc": "2.0", "method": "add", "params": [1, 2], "id": 10}, {"jsonrpc": "2.0", "method": "notify_test"}, 7, {"jsonrpc": "2.0", "method": "missing", "id": "m"}])",
+        R"([{"jsonrpc": "2.0", "method": "notify_test"}, {"jsonrpc": "2.0", "method": "notify_test"}])",
+        R"([])",
+        R"("just a string")",
+        R"({"jsonrpc": "2.0", "method": "add", "params": [1, 2)",
+        R"({"jsonrpc": "2.0", "method": "add", "params": [1, 2], "id": 1} trailing)",
+        "",
+    };
+
+    for (const std::string& request : requests) {
+        const std::string expected = dom.dispatch(request);
+        const std::string actual = onDemand.dispatch(request);
+        if (expected.empty()) {
+            EXPECT_TRUE(actual.empty()) << request;
+            continue;
+        }
+        ASSERT_FALSE(actual.empty()) << request;
+        EXPECT_EQ(nlohmann::json::parse(actual), nlohmann::json::parse(expected)) << request;
+    }
+    EXPECT_EQ(onDemandNotifications, domNotifications);
+    EXPECT_EQ(onDemandNotifications, 3);
+}
+
+// 9. 响应追加到调用方缓冲尾部，处理器内嵌套 dispatch 不影响外层请求
+TEST(JsonRpcRouterBackendTest, AppendsResponsesAndSupportsNestedDispatch) {
+    for (const auto backend : { JsonRpcRouter::Backend::Nlohmann, JsonRpcRouter::Backend::OnDemand }) {
+        if (!JsonRpcRouter::is_backend_available(backend)) {
+            continue;
+        }
+        JsonRpcRouter router;
+        ASSERT_TRUE(router.set_backend(backend));
+        router.register_method("add", [](const nlohmann::json& params) {
+            return params[0].get<int>() + params[1].get<int>();
+        });
+        router.register_method("nested", [&router](const nlohmann::json& params) {
+            const std::string inner = router.dispatch(R"({"jsonrpc": "2.0", "method": "add", "params": [20, 22], "id": 0})");
+            return nlohmann::json::parse(inner)["result"].get<int>() + params[0].get<int>();
+        });
+
+        std::string output = "prefix\n";
+        const std::string request = R"([{"jsonrpc": "2.0", "method": "nested", "params": [1], "id": 1}, {"jsonrpc": "2.0", "method": "add", "params": [2, 3], "id": 2}])";
+        router.dispatch(request.data(), request.size(), output);
+
+        ASSERT_EQ(output.compare(0, 7, "prefix\n"), 0);
+        const nlohmann::json response = nlohmann::json::parse(output.substr(7));
+        ASSERT_EQ(response.size(), 2u);
+        EXPECT_EQ(response[0]["result"], 43);
+        EXPECT_EQ(response[1]["result"], 5);
+
+        // Notification 不写入任何字节
+        const std::string notification = R"({"jsonrpc": "2.0", "method": "add", "params": [1, 1]})";
+        output = "x";
+        router.dispatch(notification.data(), notification.size(), output);
+        EXPECT_EQ(output, "x");
+    }
+}
+
+// 10. 批量并行执行：响应顺序与顺序执行一致，同一 Batch 的在途元素不超过并发上限
+TEST(JsonRpcRouterParallelBatchTest, PreservesOrderAndRespectsConcurrencyLimit) {
+    for (const auto backend : { JsonRpcRouter::Backend::Nlohmann, JsonRpcRouter::Backend::OnDemand }) {
+        if (!JsonRpcRouter::is_backend_available(backend)) {
+            continue;
+        }
+        std::atomic<int> active{ 0 };
+        std::atomic<int> maxActive{ 0 };
+        auto registerMethods = [&](JsonRpcRouter& router) {
+            ASSERT_TRUE(router.set_backend(backend));
+            router.register_method("slow", [&](const nlohmann::json& params) {
+                const int now = ++active;
+                int seen = maxActive.load();
+                while (now > seen && !maxActive.compare_exchange_weak(seen, now)) {
+                }
+                std::this_thread::sleep_for(std::chrono::milliseconds(5));
+                --active;
+                return params[0];
+            });
+            router.register_method("fail", [](const nlohmann::json&) -> nlohmann::json {
+                throw std::runtime_error("boom");
+            });
+        };
+
+        JsonRpcRouter sequential;
+        registerMethods(sequential);
+        JsonRpcRouter parallel;
+        registerMethods(parallel);
+        parallel.enable_parallel_batch(8, 3);
+
+        std::string request = "[";
+        for (int i = 0; i < 12; ++i) {
+            request += R"({"jsonrpc": "2.0", "method": "slow", "params": [)" + std::to_string(i) + R"(], "id": )" + std::to_string(i) + "},";
+        }
+        request += R"({"jsonrpc": "2.0", "method": "missing", "id": "m"}, 7, {"jsonrpc": "2.0", "method": "fail", "id": "f"}, {"method": "slow"}, {"jsonrpc": "2.0", "method": "slow", "params": [99]}])";
+
+        const std::string expected = sequential.dispatch(request);
+        EXPECT_EQ(maxActive.load(), 1);
+        maxActive = 0;
+
+        const std::string actual = parallel.dispatch(request);
+        ASSERT_FALSE(actual.empty());
+        EXPECT_EQ(nlohmann::json::parse(actual), nlohmann::json::parse(expected));
+        EXPECT_EQ(nlohmann::json::parse(actual).size(), 16u);
+        EXPECT_GE(maxActive.load(), 2);
+        EXPECT_LE(maxActive.load(), 3 + 1); // 末尾的 Notification 不占并发名额
+    }
+}
+
+// 11. Notification 提交后不等待完成；工作线程上嵌套的 Batch 顺序执行，不会因线程池耗尽而死锁
+TEST(JsonRpcRouterParallelBatchTest, NotificationsAreFireAndForget) {
+    for (const auto backend : { JsonRpcRouter::Backend::Nlohmann, JsonRpcRouter::Backend::OnDemand }) {
+        if (!JsonRpcRouter::is_backend_available(backend)) {
+            continue;
+        }
+        std::promise<void> release;
+        std::shared_future<void> released = release.get_future().share();
+        std::atomic<int> finished{ 0 };
+
+        JsonRpcRouter router;
+        ASSERT_TRUE(router.set_backend(backend));
+        router.register_method("block", [&](const nlohmann::json&) {
+            released.wait();
+            ++finished;
+            return nullptr;
+        });
+        router.register_method("add", [](const nlohmann::json& params) {
+            return params[0].get<int>() + params[1].get<int>();
+        });
+        router.register_method("nested", [&router](const nlohmann::json&) {
+            const std::string inner = router.dispatch(R"([{"jsonrpc": "2.0", "method": "add", "params": [1, 2], "id": 1}, {"jsonrpc": "2.0", "method": "add", "params": [3, 4], "id": 2}])");
+            return nlohmann::json::parse(inner);
+        });
+        router.enable_parallel_batch(2, 1);
+
+        // 两个 Notification 各占住一个工作线程，dispatch 仍立即返回
+        EXPECT_EQ(router.dispatch(R"({"jsonrpc": "2.0", "method": "block"})"), "");
+        const std::string reply = router.dispatch(R"([{"jsonrpc": "2.0", "method": "block"}, {"jsonrpc": "2.0", "method": "block"}])");
+        EXPECT_EQ(reply, "");
+        EXPECT_EQ(finished.load(), 0);
+
+        release.set_value();
+        for (int retry = 0; retry < 200 && finished.load() < 3; ++retry) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+        EXPECT_EQ(finished.load(), 3);
+
+        const nlohmann::json nested = nlohmann::json::parse(
+            router.dispatch(R"([{"jsonrpc": "2.0", "method": "nested", "id": 7}, {"jsonrpc": "2.0", "method": "add", "params": [5, 6], "id": 8}])"));
+        ASSERT_EQ(nested.size(), 2u);
+        EXPECT_EQ(nested[0]["result"][0]["result"], 3);
+        EXPECT_EQ(nested[0]["result"][1]["result"], 7);
+        EXPECT_EQ(nested[1]["result"], 11);
+    }
+}
+
+// 12. 带完成回调的 dispatch 提交并行 Batch 后立即返回，最后完成的元素按请求顺序拼装响应并回调
+TEST(JsonRpcRouterParallelBatchTest, AsyncDispatchReturnsBeforeBatchCompletes) {
+    for (const auto backend : { JsonRpcRouter::Backend::Nlohmann, JsonRpcRouter::Backend::OnDemand }) {
+        if (!JsonRpcRouter::is_backend_available(backend)) {
+            continue;
+        }
+        std::promise<void> release;
+        std::shared_future<void> released = release.get_future().share();
+
+        JsonRpcRouter router;
+        ASSERT_TRUE(router.set_backend(backend));
+        router.register_method("block", [&](const nlohmann::json& params) {
+            released.wait();
+            return params[0];
+        });
+        router.register_method("add", [](const nlohmann::json& params) {
+            return params[0].get<int>() + params[1].get<int>();
+        });
+        router.enable_parallel_batch(2, 1);
+
+        // 单条请求与出错的请求仍同步完成，不触发回调
+        std::string output;
+        const std::string single = R"({"jsonrpc": "2.0", "method": "add", "params": [1, 2], "id": 1})";
+        EXPECT_TRUE(router.dispatch(single.data(), single.size(), output, [](std::string&&) { FAIL(); }));
+        EXPECT_EQ(nlohmann::json::parse(output)["result"], 3);
+
+        std::promise<std::string> response;
+        std::future<std::string> responded = response.get_future();
+        output = "x";
+        const std::string batch = R"([{"jsonrpc": "2.0", "method": "block", "params": [5], "id": 1}, {"jsonrpc": "2.0", "method": "add", "params": [1, 1]}, {"jsonrpc": "2.0", "method": "add", "params": [2, 3], "id": 2}])";
+        EXPECT_FALSE(router.dispatch(batch.data(), batch.size(), output, [&response](std::string&& result) {
+            response.set_value(std::move(result));
+        }));
+        EXPECT_EQ(output, "x");
+        EXPECT_EQ(responded.wait_for(std::chrono::milliseconds(20)), std::future_status::timeout);
+
+        release.set_value();
+        ASSERT_EQ(responded.wait_for(std::chrono::seconds(5)), std::future_status::ready);
+        const nlohmann::json parsed = nlohmann::json::parse(responded.get());
+        ASSERT_EQ(parsed.size(), 2u);
+        EXPECT_EQ(parsed[0]["id"], 1);
+        EXPECT_EQ(parsed[0]["result"], 5);
+        EXPECT_EQ(parsed[1]["id"], 2);
+        EXPECT_EQ(parsed[1]["result"], 5);
+    }
+}
+
+// 13. 线程池中的 Notification 达到上限后，新的 Notification 在调用线程上就地执行，不再无限排队
+TEST(JsonRpcRouterParallelBatchTest, NotificationsRunInlineWhenPoolIsFull) {
+    for (const auto backend : { JsonRpcRouter::Backend::Nlohmann, JsonRpcRouter::Backend::OnDemand }) {
+        if (!JsonRpcRouter::is_backend_available(backend)) {
+            continue;
+        }
+        std::promise<void> release;
+        std::shared_future<void> released = release.get_future().share();
+        const std::thread::id caller = std::this_thread::get_id();
+        std::atomic<int> inline_{ 0 };
+        std::atomic<int> pooled{ 0 };
+
+        JsonRpcRouter router;
+        ASSERT_TRUE(router.set_backend(backend));
+        router.register_method("block", [&](const nlohmann::json&) {
+            if (std::this_thread::get_id() == caller) {
+                ++inline_;
+                return nullptr;
+            }
+            released.wait();
+            ++pooled;
+            return nullptr;
+        });
+        router.enable_parallel_batch(1, 0, 2);
+
+        // 一个在工作线程上执行、一个排队，其余两个超出上限在调用线程上执行
+        const std::string notifications = R"([{"jsonrpc": "2.0", "method": "block"}, {"jsonrpc": "2.0", "method": "block"}, {"jsonrpc": "2.0", "method": "block"}, {"jsonrpc": "2.0", "method": "block"}])";
+        EXPECT_EQ(router.dispatch(notifications), "");
+        EXPECT_EQ(inline_.load(), 2);
+        EXPECT_EQ(router.dispatch(R"({"jsonrpc": "2.0", "method": "block"})"), "");
+        EXPECT_EQ(inline_.load(), 3);
+
+        release.set_value();
+        for (int retry = 0; retry < 200 && pooled.load() < 2; ++retry) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+        EXPECT_EQ(pooled.load(), 2);
+
+        // 积压的 Notification 执行完后名额归还，新的 Notification 又投入线程池
+        EXPECT_EQ(router.dispatch(R"({"jsonrpc": "2.0", "method": "block"})"), "");
+        for (int retry = 0; retry < 200 && pooled.load() < 3; ++retry) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+        EXPECT_EQ(pooled.load(), 3);
+        EXPECT_EQ(inline_.load(), 3);
+    }
+}
@@ -11,6 +11,7 @@
 #include <arpa/inet.h>
 #include <unistd.h>
 #include <cstring>
+#include <future>
 #include <memory>
 #include <thread>
 #include <chrono>
@@ -196,3 +197,141 @@ TEST_F(JsonRpcServerTest, ProcessesBatchRpcRequestsOverTcp) {
 
     ::close(clientFd);
 }
+
+// 3. 验证流水线请求被拆成任意小段到达时，原地拆包仍按顺序逐条回包
+TEST_F(JsonRpcServerTest, ReassemblesPipelinedRequestsSplitAcrossReads) {
+    int clientFd = connect_with_retry(port);
+    ASSERT_GE(clientFd, 0);
+
+    std::string pipeline;
+    for (int i = 0; i < 50; ++i) {
+        pipeline += R"({"jsonrpc": "2.0", "method": "add", "params": [)" + std::to_string(i) + R"(, 1], "id": )" + std::to_string(i) + "}\r\n";
+    }
+    // 中间夹一个空行与一个 Notification，均不产生回包
+    pipeline += "\n" R"({"jsonrpc": "2.0", "method": "add", "params": [0, 0]})" "\n";
+
+    // 以 7 字节为单位分段写出，帧边界随机落在分段内部
+    for (size_t offset = 0; offset < pipeline.size(); offset += 7) {
+        write_all(clientFd, pipeline.substr(offset, 7));
+        if (offset % 700 == 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+
+    for (int i = 0; i < 50; ++i) {
+        std::string responseLine = read_line(clientFd);
+        ASSERT_FALSE(responseLine.empty());
+        responseLine.pop_back();
+        nlohmann::json resp = nlohmann::json::parse(responseLine);
+        EXPECT_EQ(resp["id"], i);
+        EXPECT_EQ(resp["result"], i + 1);
+    }
+
+    ::close(clientFd);
+}
+
+// 4. 验证 Content-Length 分帧：正文可包含换行，回包使用同样的分帧
+TEST_F(JsonRpcServerTest, ProcessesContentLengthFramedRequests) {
+    int clientFd = connect_with_retry(port);
+    ASSERT_GE(clientFd, 0);
+
+    const std::string body = "{\n  \"jsonrpc\": \"2.0\",\n  \"method\": \"greet\",\n  \"params\": [\"Frame\"],\n  \"id\": 7\n}";
+    const std::string frame = "Content-Length: " + std::to_string(body.size()) + "\r\nContent-Type: application/json\r\n\r\n" + body;
+
+    // 头部结束标记与正文都被拆开发送，随后紧跟一条换行分隔的请求
+    const size_t split = frame.find("\r\n\r\n") + 2;
+    write_all(clientFd, frame.substr(0, split));
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    write_all(clientFd, frame.substr(split, 10));
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    write_all(clientFd, frame.substr(split + 10) + R"({"jsonrpc": "2.0", "method": "add", "params": [2, 3], "id": 8})" "\n");
+
+    std::string header;
+    while (header.size() < 4 || header.compare(header.size() - 4, 4, "\r\n\r\n") != 0) {
+        char c = 0;
+        ASSERT_EQ(::read(clientFd, &c, 1), 1);
+        header.push_back(c);
+    }
+    ASSERT_EQ(header.compare(0, 16, "Content-Length: "), 0);
+    const size_t length = std::stoul(header.substr(16));
+    std::string responseBody(length, '\0');
+    size_t received = 0;
+    while (received < length) {
+        const ssize_t n = ::read(clientFd, &responseBody[received], length - received);
+        ASSERT_GT(n, 0);
+        received += static_cast<size_t>(n);
+    }
+    nlohmann::json resp = nlohmann::json::parse(responseBody);
+    EXPECT_EQ(resp["id"], 7);
+    EXPECT_EQ(resp["result"], "Hello, Frame!");
+
+    std::string responseLine = read_line(clientFd);
+    ASSERT_FALSE(responseLine.empty());
+    responseLine.pop_back();
+    EXPECT_EQ(nlohmann::json::parse(responseLine)["result"], 5);
+
+    ::close(clientFd);
+}
+
+// 5. 验证缺失或非法的 Content-Length 头导致连接被关闭
+TEST_F(JsonRpcServerTest, ClosesConnectionOnMalformedContentLengthHeader) {
+    int clientFd = connect_with_retry(port);
+    ASSERT_GE(clientFd, 0);
+
+    write_all(clientFd, "Content-Length: 12abc\r\n\r\n{}");
+
+    char c = 0;
+    EXPECT_EQ(::read(clientFd, &c, 1), 0);
+
+    ::close(clientFd);
+}
+
+// 6. 验证并行 Batch 不阻塞 IO 线程：Batch 执行期间其它连接照常回包，同一连接上后续请求的回包排在 Batch 之后
+TEST(JsonRpcServerParallelBatchTest, ParallelBatchDoesNotBlockIoThread) {
+    const uint16_t port = reserve_free_port();
+    ASSERT_NE(port, 0);
+
+    std::promise<void> release;
+    std::shared_future<void> released = release.get_future().share();
+    JsonRpcServer server("127.0.0.1", port);
+    server.register_method("block", [released](const nlohmann::json& params) {
+        released.wait();
+        return params[0];
+    });
+    server.register_method("add", [](const nlohmann::json& params) {
+        return params[0].get<int>() + params[1].get<int>();
+    });
+    server.enable_parallel_batch(2);
+    std::thread serverThread([&server]() { server.start(); });
+
+    const int batchFd = connect_with_retry(port);
+    const int otherFd = connect_with_retry(port);
+    EXPECT_GE(batchFd, 0);
+    EXPECT_GE(otherFd, 0);
+    if (batchFd >= 0 && otherFd >= 0) {
+        write_all(batchFd, R"([{"jsonrpc": "2.0", "method": "block", "params": [7], "id": 1}, {"jsonrpc": "2.0", "method": "add", "params": [1, 2], "id": 2}])" "\n"
+                           R"({"jsonrpc": "2.0", "method": "add", "params": [3, 4], "id": 3})" "\n");
+
+        // IO 线程若在等待 Batch，这里会读超时
+        timeval timeout{ 5, 0 };
+        ::setsockopt(otherFd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+        write_all(otherFd, R"({"jsonrpc": "2.0", "method": "add", "params": [10, 20], "id": 9})" "\n");
+        const std::string otherLine = read_line(otherFd);
+        EXPECT_EQ(nlohmann::json::parse(otherLine, nullptr, false), nlohmann::json::parse(R"({"jsonrpc": "2.0", "result": 30, "id": 9})"));
+    }
+    release.set_value();
+
+    if (batchFd >= 0) {
+        const std::string batchLine = read_line(batchFd);
+        const std::string nextLine = read_line(batchFd);
+        EXPECT_EQ(nlohmann::json::parse(batchLine, nullptr, false), nlohmann::json::parse(R"([{"jsonrpc": "2.0", "result": 7, "id": 1}, {"jsonrpc": "2.0", "result": 3, "id": 2}])"));
+        EXPECT_EQ(nlohmann::json::parse(nextLine, nullptr, false), nlohmann::json::parse(R"({"jsonrpc": "2.0", "result": 7, "id": 3})"));
+        ::close(batchFd);
+    }
+    if (otherFd >= 0) {
+        ::close(otherFd);
+    }
+
+    server.stop();
+    serverThread.join();
+}
@@ -0,0 +1,127 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "tudou/tcp/AdmissionController.h"
+
+namespace {
+
+constexpr std::chrono::steady_clock::duration kNoDelay = std::chrono::steady_clock::duration::zero();
+
+} // namespace
+
+TEST(AdmissionControllerTest, DisabledByDefaultAdmitsEverything) {
+    AdmissionController admission;
+    EXPECT_FALSE(admission.is_enabled());
+    for (int i = 0; i < 1000; ++i) {
+        EXPECT_TRUE(admission.try_acquire(std::chrono::seconds(10)));
+    }
+    EXPECT_EQ(admission.get_rejected_count(), 0u);
+}
+
+TEST(AdmissionControllerTest, StaticLimitRejectsBeyondMaxConcurrency) {
+    AdmissionController admission;
+    AdmissionOptions options;
+    options.maxConcurrency = 2;
+    admission.configure(options);
+
+    EXPECT_TRUE(admission.try_acquire(kNoDelay));
+    EXPECT_TRUE(admission.try_acquire(kNoDelay));
+    EXPECT_FALSE(admission.try_acquire(kNoDelay));
+    EXPECT_EQ(admission.get_in_flight(), 2u);
+    EXPECT_EQ(admission.get_rejected_count(), 1u);
+
+    admission.release();
+    EXPECT_TRUE(admission.try_acquire(kNoDelay));
+}
+
+TEST(AdmissionControllerTest, AdaptiveLimitShrinksUnderQueueingAndRecovers) {
+    AdmissionController admission;
+    AdmissionOptions options;
+    options.maxConcurrency = 64;
+    options.adaptive = true;
+    options.minConcurrency = 4;
+    options.targetQueueDelay = std::chrono::milliseconds(1);
+    options.interval = std::chrono::milliseconds(5);
+    admission.configure(options);
+    EXPECT_EQ(admission.get_limit(), 64u);
+
+    // 持续高排队时延：上限按梯度收缩到下界，且排队超过目标的请求在丢弃态下直接被拒绝
+    for (int round = 0; round < 20; ++round) {
+        std::this_thread::sleep_for(options.interval);
+        EXPECT_FALSE(admission.try_acquire(std::chrono::milliseconds(10)));
+    }
+    EXPECT_EQ(admission.get_limit(), 4u);
+    EXPECT_TRUE(admission.try_acquire(kNoDelay));
+    admission.release();
+
+    // 队列排空后每个周期上限加一
+    for (int round = 0; round < 3; ++round) {
+        std::this_thread::sleep_for(options.interval);
+        EXPECT_TRUE(admission.try_acquire(kNoDelay));
+        admission.release();
+    }
+    EXPECT_GE(admission.get_limit(), 6u);
+    EXPECT_LE(admission.get_limit(), 7u);
+}
+
+TEST(AdmissionControllerTest, ReconfigureWhileInFlightKeepsCountConsistent) {
+    AdmissionController admission;
+    AdmissionOptions options;
+    options.maxConcurrency = 2;
+    admission.configure(options);
+
+    bool first = false;
+    bool second = false;
+    ASSERT_TRUE(admission.try_acquire(kNoDelay, &first));
+    ASSERT_TRUE(admission.try_acquire(kNoDelay, &second));
+    EXPECT_TRUE(first);
+    EXPECT_TRUE(second);
+
+    // 运行期关闭限流：新请求放行但不占用名额，此前占用的名额照样归还
+    admission.configure(AdmissionOptions());
+    bool bypassed = true;
+    EXPECT_TRUE(admission.try_acquire(kNoDelay, &bypassed));
+    EXPECT_FALSE(bypassed);
+    admission.release();
+    admission.release();
+    EXPECT_EQ(admission.get_in_flight(), 0u);
+
+    // 重新启用后按完整上限放行
+    admission.configure(options);
+    EXPECT_TRUE(admission.try_acquire(kNoDelay));
+    EXPECT_TRUE(admission.try_acquire(kNoDelay));
+    EXPECT_FALSE(admission.try_acquire(kNoDelay));
+}
+
+TEST(AdmissionControllerTest, ConcurrentAdaptiveAcquireReleaseBalances) {
+    AdmissionController admission;
+    AdmissionOptions options;
+    options.maxConcurrency = 8;
+    options.adaptive = true;
+    options.targetQueueDelay = std::chrono::microseconds(50);
+    options.interval = std::chrono::milliseconds(1);
+    admission.configure(options);
+
+    std::vector<std::thread> workers;
+    for (int thread = 0; thread < 4; ++thread) {
+        workers.emplace_back([&admission, thread]() {
+            for (int i = 0; i < 20000; ++i) {
+                bool acquired = false;
+                const auto delay = std::chrono::microseconds((i + thread) % 100);
+                if (admission.try_acquire(delay, &acquired) && acquired) {
+                    admission.release();
+                }
+            }
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+
+    EXPECT_EQ(admission.get_in_flight(), 0u);
+    EXPECT_GE(admission.get_limit(), options.minConcurrency);
+    EXPECT_LE(admission.get_limit(), options.maxConcurrency);
+}
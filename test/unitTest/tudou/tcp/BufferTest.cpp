@@ -3,6 +3,7 @@
 #include <sys/socket.h>
 #include <unistd.h>
 
+#include <cstring>
 #include <string>
 
 #include "tudou/tcp/Buffer.h"
@@ -43,4 +44,15 @@ TEST(BufferTest, ReadFromFdUsesExtraBufferWhenWritableSpaceIsInsufficient) {
 
     ::close(fds[0]);
     ::close(fds[1]);
-}
\ No newline at end of file
+}
+TEST(BufferTest, EnsureWritableBytesSupportsInPlaceWrites) {
+    Buffer buffer(8);
+    buffer.write_to_buffer("ab");
+
+    buffer.ensure_writable_bytes(32);
+    ASSERT_GE(buffer.writable_bytes(), 32U);
+    std::memcpy(buffer.writable_start_ptr(), "cdef", 4);
+    buffer.advance_write_index(4);
+
+    EXPECT_EQ(buffer.read_from_buffer(), "abcdef");
+}
@@ -4,6 +4,7 @@
 #include <sys/socket.h>
 
 #include <stdexcept>
+#include <string>
 
 #include "tudou/tcp/InetAddress.h"
 
@@ -51,3 +52,60 @@ TEST(InetAddressTest, ConstructFromNonIpv4SockaddrThrowsInvalidArgument) {
 
     EXPECT_THROW((void)InetAddress(nativeAddress), std::invalid_argument);
 }
+
+TEST(InetAddressTest, ConstructFromIpv6TextFormatsBracketedEndpoint) {
+    const InetAddress address("::1", 8080);
+    EXPECT_TRUE(address.is_ipv6());
+    EXPECT_EQ(address.get_family(), AF_INET6);
+    EXPECT_EQ(address.get_ip(), "::1");
+    EXPECT_EQ(address.get_port(), 8080);
+    EXPECT_EQ(address.get_ip_port(), "[::1]:8080");
+    EXPECT_EQ(address.get_socklen(), static_cast<socklen_t>(sizeof(sockaddr_in6)));
+    EXPECT_EQ(address.get_sockaddr_in6().sin6_port, htons(8080));
+    EXPECT_THROW((void)address.get_sockaddr(), std::logic_error);
+
+    // URL 风格的方括号写法与原生 sockaddr_in6 构造得到同一地址
+    const InetAddress bracketed("[2001:db8::5]", 443);
+    EXPECT_EQ(bracketed.get_ip(), "2001:db8::5");
+    const InetAddress native(bracketed.get_sockaddr_in6());
+    EXPECT_EQ(native.get_ip_port(), "[2001:db8::5]:443");
+
+    EXPECT_THROW(InetAddress("[::1", 80), std::invalid_argument);
+    EXPECT_THROW((void)InetAddress("127.0.0.1", 80).get_sockaddr_in6(), std::logic_error);
+}
+
+TEST(InetAddressTest, Ipv4MappedPeerAddressIsUnmappedToIpv4) {
+    sockaddr_in6 mapped{};
+    mapped.sin6_family = AF_INET6;
+    mapped.sin6_port = htons(9000);
+    ASSERT_EQ(inet_pton(AF_INET6, "::ffff:10.1.2.3", &mapped.sin6_addr), 1);
+
+    // accept/getsockname 经通用地址构造，双栈 socket 上的 IPv4 对端还原为 AF_INET
+    const InetAddress peer(reinterpret_cast<const sockaddr*>(&mapped), sizeof(mapped));
+    EXPECT_EQ(peer.get_family(), AF_INET);
+    EXPECT_EQ(peer.get_ip_port(), "10.1.2.3:9000");
+    EXPECT_EQ(peer.get_sockaddr().sin_port, htons(9000));
+}
+
+TEST(InetAddressTest, UnixPathAddressesExposePathAndFamily) {
+    const InetAddress fileAddress = InetAddress::from_unix_path("/tmp/tudou.sock");
+    EXPECT_TRUE(fileAddress.is_unix());
+    EXPECT_EQ(fileAddress.get_family(), AF_UNIX);
+    EXPECT_EQ(fileAddress.get_unix_path(), "/tmp/tudou.sock");
+    EXPECT_EQ(fileAddress.get_port(), 0);
+    EXPECT_EQ(fileAddress.get_ip_port(), "unix:/tmp/tudou.sock");
+    EXPECT_THROW((void)fileAddress.get_sockaddr(), std::logic_error);
+
+    // 抽象命名空间：首字节为 '\0'，长度由 socklen 界定
+    const InetAddress abstractAddress = InetAddress::from_unix_path("@tudou-test");
+    EXPECT_EQ(abstractAddress.get_unix_path(), "@tudou-test");
+    EXPECT_EQ(abstractAddress.get_sockaddr_ptr()->sa_family, AF_UNIX);
+
+    const InetAddress copied(abstractAddress.get_sockaddr_ptr(), abstractAddress.get_socklen());
+    EXPECT_EQ(copied.get_unix_path(), "@tudou-test");
+}
+
+TEST(InetAddressTest, UnixPathRejectsEmptyOrOverlongPaths) {
+    EXPECT_THROW((void)InetAddress::from_unix_path(""), std::invalid_argument);
+    EXPECT_THROW((void)InetAddress::from_unix_path(std::string(200, 'a')), std::invalid_argument);
+}
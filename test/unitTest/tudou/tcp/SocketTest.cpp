@@ -2,8 +2,11 @@
 
 #include <cerrno>
 #include <fcntl.h>
+#include <stdexcept>
+#include <string>
 #include <unistd.h>
 #include <sys/socket.h>
+#include <sys/stat.h>
 
 #include "tudou/tcp/Socket.h"
 
@@ -130,4 +133,63 @@ TEST(SocketTest, MoveAssignFromInvalidFdDoesNotClose) {
     EXPECT_EQ(valid.fd(), -1);
 
     ::close(fds[1]);
-}
\ No newline at end of file
+}
+
+// ───────────────────────── Unix 域监听 ─────────────────────────
+
+// 辅助：测试专用的文件系统 socket 路径，先清掉上次运行的遗留
+static std::string unix_test_path(const char* name) {
+    const std::string path = "/tmp/tudou-socket-test-" + std::to_string(::getpid()) + "-" + name;
+    ::unlink(path.c_str());
+    return path;
+}
+
+static void expect_address_in_use(const InetAddress& addr) {
+    try {
+        (void)Socket::create_unix_listener(addr);
+        ADD_FAILURE() << "create_unix_listener() should fail";
+    }
+    catch (const std::runtime_error& ex) {
+        EXPECT_NE(std::string(ex.what()).find("errno=" + std::to_string(EADDRINUSE)), std::string::npos) << ex.what();
+    }
+}
+
+TEST(SocketTest, UnixListenerReplacesStaleSocketFile) {
+    const std::string path = unix_test_path("stale");
+    const InetAddress addr = InetAddress::from_unix_path(path);
+    {
+        // 监听 fd 关闭后 socket 文件仍留在路径上，模拟进程异常退出
+        Socket previous = Socket::create_unix_listener(addr);
+    }
+    struct stat st;
+    ASSERT_EQ(::lstat(path.c_str(), &st), 0);
+
+    Socket listener = Socket::create_unix_listener(addr);
+    EXPECT_GE(listener.fd(), 0);
+    ::unlink(path.c_str());
+}
+
+TEST(SocketTest, UnixListenerKeepsLiveSocketAndRegularFile) {
+    const std::string livePath = unix_test_path("live");
+    const InetAddress liveAddr = InetAddress::from_unix_path(livePath);
+    Socket live = Socket::create_unix_listener(liveAddr);
+    expect_address_in_use(liveAddr);
+
+    // 原监听者仍然可以被连上
+    const int clientFd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    ASSERT_GE(clientFd, 0);
+    EXPECT_EQ(::connect(clientFd, liveAddr.get_sockaddr_ptr(), liveAddr.get_socklen()), 0);
+    ::close(clientFd);
+    ::unlink(livePath.c_str());
+
+    const std::string filePath = unix_test_path("file");
+    const int fileFd = ::open(filePath.c_str(), O_CREAT | O_WRONLY | O_CLOEXEC, 0600);
+    ASSERT_GE(fileFd, 0);
+    ::close(fileFd);
+    expect_address_in_use(InetAddress::from_unix_path(filePath));
+
+    struct stat st;
+    ASSERT_EQ(::lstat(filePath.c_str(), &st), 0);
+    EXPECT_TRUE(S_ISREG(st.st_mode));
+    ::unlink(filePath.c_str());
+}
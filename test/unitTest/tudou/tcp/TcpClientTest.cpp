@@ -0,0 +1,253 @@
+#include <gtest/gtest.h>
+
+#include <arpa/inet.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <memory>
+#include <string>
+#include <thread>
+
+#include "tudou/reactor/EventLoopThread.h"
+#include "tudou/tcp/InetAddress.h"
+#include "tudou/tcp/TcpClient.h"
+#include "tudou/tcp/TcpServer.h"
+
+namespace {
+
+uint16_t reserve_free_port() {
+    const int fd = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, IPPROTO_TCP);
+    if (fd < 0) {
+        return 0;
+    }
+
+    const InetAddress loopback("127.0.0.1", 0);
+    sockaddr_in addr{};
+    socklen_t len = sizeof(addr);
+    if (::bind(fd, loopback.get_sockaddr_ptr(), loopback.get_socklen()) != 0
+        || ::getsockname(fd, reinterpret_cast<sockaddr*>(&addr), &len) != 0) {
+        ::close(fd);
+        return 0;
+    }
+
+    ::close(fd);
+    return ntohs(addr.sin_port);
+}
+
+// 在后台线程运行、把收到的数据原样回写的 TcpServer
+struct EchoServer {
+    explicit EchoServer(uint16_t port) : server("127.0.0.1", port, 0) {
+        server.set_connection_callback([](const TcpConnectionPtr&) {});
+        server.set_message_callback([](const TcpConnectionPtr& conn) {
+            conn->send(conn->receive());
+        });
+        server.set_close_callback([](const TcpConnectionPtr&) {});
+        thread = std::thread([this]() {
+            server.start();
+            stopped = true;
+        });
+    }
+
+    ~EchoServer() {
+        // start() 尚未进入主循环时 stop() 会被忽略，重试直到 start() 返回
+        while (!stopped.load()) {
+            server.stop();
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+        thread.join();
+    }
+
+    TcpServer server;
+    std::atomic<bool> stopped{ false };
+    std::thread thread;
+};
+
+Connector::Options fast_retry_options() {
+    Connector::Options options;
+    options.connectTimeoutSeconds = 1.0;
+    options.initialRetryDelaySeconds = 0.02;
+    options.maxRetryDelaySeconds = 0.1;
+    return options;
+}
+
+} // namespace
+
+TEST(TcpClientTest, ConnectsAndExchangesDataWithTcpServer) {
+    const uint16_t port = reserve_free_port();
+    ASSERT_NE(port, 0);
+    EchoServer server(port);
+
+    EventLoopThread clientLoop;
+    std::promise<std::string> echoed;
+    std::atomic<bool> connected{ false };
+    {
+        TcpClient client(clientLoop.get_loop(), InetAddress("127.0.0.1", port), fast_retry_options());
+        client.set_connection_callback([&](const TcpConnectionPtr& conn) {
+            connected = true;
+            EXPECT_EQ(conn->get_peer_addr().get_port(), port);
+            conn->send("ping");
+        });
+        client.set_message_callback([&](const TcpConnectionPtr& conn) {
+            echoed.set_value(conn->receive());
+        });
+        client.connect();
+
+        std::future<std::string> future = echoed.get_future();
+        ASSERT_EQ(future.wait_for(std::chrono::seconds(3)), std::future_status::ready);
+        EXPECT_EQ(future.get(), "ping");
+        EXPECT_TRUE(connected.load());
+        EXPECT_NE(client.get_connection(), nullptr);
+    }
+}
+
+TEST(TcpClientTest, RetriesWithBackoffUntilServerStartsListening) {
+    const uint16_t port = reserve_free_port();
+    ASSERT_NE(port, 0);
+
+    EventLoopThread clientLoop;
+    std::promise<void> connected;
+    TcpClient client(clientLoop.get_loop(), InetAddress("127.0.0.1", port), fast_retry_options());
+    client.set_connection_callback([&](const TcpConnectionPtr&) {
+        connected.set_value();
+    });
+    client.set_message_callback([](const TcpConnectionPtr& conn) {
+        conn->receive();
+    });
+    client.connect();
+
+    // 服务端晚于客户端启动，前几次 connect 被拒绝后按退避重试，最终连上
+    std::this_thread::sleep_for(std::chrono::milliseconds(150));
+    EchoServer server(port);
+
+    std::future<void> future = connected.get_future();
+    EXPECT_EQ(future.wait_for(std::chrono::seconds(3)), std::future_status::ready);
+    client.disconnect();
+}
+
+TEST(TcpClientTest, GivesUpAfterMaxAttempts) {
+    const uint16_t port = reserve_free_port();
+    ASSERT_NE(port, 0);
+
+    Connector::Options options = fast_retry_options();
+    options.maxAttempts = 3;
+
+    EventLoopThread clientLoop;
+    std::promise<std::string> failed;
+    TcpClient client(clientLoop.get_loop(), InetAddress("127.0.0.1", port), options);
+    client.set_message_callback([](const TcpConnectionPtr&) {});
+    client.set_connect_failed_callback([&](const std::string& reason) {
+        failed.set_value(reason);
+    });
+
+    const auto start = std::chrono::steady_clock::now();
+    client.connect();
+    std::future<std::string> future = failed.get_future();
+    ASSERT_EQ(future.wait_for(std::chrono::seconds(3)), std::future_status::ready);
+    EXPECT_NE(future.get().find("refused"), std::string::npos);
+
+    // 3 次尝试之间退避 0.02s 与 0.04s
+    EXPECT_GE(std::chrono::steady_clock::now() - start, std::chrono::milliseconds(60));
+    EXPECT_EQ(client.get_connection(), nullptr);
+}
+
+TEST(TcpClientTest, TimesOutWhenHandshakeNeverCompletes) {
+    // backlog 填满且不 accept 的监听 socket：内核丢弃后续 SYN，客户端 connect 一直停在 SYN_SENT
+    const int listenFd = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, IPPROTO_TCP);
+    ASSERT_GE(listenFd, 0);
+    const InetAddress loopback("127.0.0.1", 0);
+    ASSERT_EQ(::bind(listenFd, loopback.get_sockaddr_ptr(), loopback.get_socklen()), 0);
+    ASSERT_EQ(::listen(listenFd, 0), 0);
+    sockaddr_in bound{};
+    socklen_t len = sizeof(bound);
+    ASSERT_EQ(::getsockname(listenFd, reinterpret_cast<sockaddr*>(&bound), &len), 0);
+    const InetAddress target(bound);
+
+    int fillers[2] = { -1, -1 };
+    for (int& fd : fillers) {
+        fd = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC | SOCK_NONBLOCK, IPPROTO_TCP);
+        ::connect(fd, target.get_sockaddr_ptr(), target.get_socklen());
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+    Connector::Options options;
+    options.connectTimeoutSeconds = 0.1;
+    options.maxAttempts = 1;
+
+    EventLoopThread clientLoop;
+    std::promise<std::string> failed;
+    {
+        TcpClient client(clientLoop.get_loop(), target, options);
+        client.set_message_callback([](const TcpConnectionPtr&) {});
+        client.set_connect_failed_callback([&](const std::string& reason) {
+            failed.set_value(reason);
+        });
+        client.connect();
+
+        std::future<std::string> future = failed.get_future();
+        ASSERT_EQ(future.wait_for(std::chrono::seconds(3)), std::future_status::ready);
+        EXPECT_EQ(future.get(), "connect timeout");
+    }
+
+    for (int fd : fillers) {
+        ::close(fd);
+    }
+    ::close(listenFd);
+}
+
+TEST(TcpClientTest, ReconnectsAfterServerClosesConnectionWhenRetryEnabled) {
+    const uint16_t port = reserve_free_port();
+    ASSERT_NE(port, 0);
+
+    // 服务端对第一条连接立即关闭，第二条连接保持
+    std::atomic<int> serverAccepted{ 0 };
+    TcpServer server("127.0.0.1", port, 0);
+    server.set_connection_callback([&](const TcpConnectionPtr& conn) {
+        if (serverAccepted.fetch_add(1) == 0) {
+            conn->force_close();
+        }
+    });
+    server.set_message_callback([](const TcpConnectionPtr& conn) {
+        conn->receive();
+    });
+    server.set_close_callback([](const TcpConnectionPtr&) {});
+    std::thread serverThread([&server]() {
+        server.start();
+    });
+
+    EventLoopThread clientLoop;
+    std::atomic<int> clientConnected{ 0 };
+    std::atomic<int> clientClosed{ 0 };
+    std::promise<void> reconnected;
+    {
+        TcpClient client(clientLoop.get_loop(), InetAddress("127.0.0.1", port), fast_retry_options());
+        client.enable_retry();
+        client.set_connection_callback([&](const TcpConnectionPtr&) {
+            if (clientConnected.fetch_add(1) == 1) {
+                reconnected.set_value();
+            }
+        });
+        client.set_message_callback([](const TcpConnectionPtr& conn) {
+            conn->receive();
+        });
+        client.set_close_callback([&](const TcpConnectionPtr&) {
+            clientClosed.fetch_add(1);
+        });
+        client.connect();
+
+        std::future<void> future = reconnected.get_future();
+        EXPECT_EQ(future.wait_for(std::chrono::seconds(3)), std::future_status::ready);
+        EXPECT_EQ(clientClosed.load(), 1);
+
+        // 客户端在握手完成时即视为连上，服务端的 accept 可能稍晚
+        for (int retry = 0; retry < 200 && serverAccepted.load() < 2; ++retry) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+    }
+
+    server.stop();
+    serverThread.join();
+    EXPECT_EQ(serverAccepted.load(), 2);
+}
@@ -1,6 +1,7 @@
 #include <gtest/gtest.h>
 
 #include <cerrno>
+#include <csignal>
 #include <cstdlib>
 #include <sys/socket.h>
 #include <unistd.h>
@@ -83,6 +84,78 @@ TEST(TcpConnectionTest, MessageCallbackCanConsumeInboundData) {
     ::close(fds[1]); // fds[1] 未交给 Socket，需手动关闭
 }
 
+TEST(TcpConnectionTest, DirectReadLeavesInboundDataOnSocket) {
+    int fds[2] = { -1, -1 };
+    ASSERT_EQ(::socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, fds), 0);
+
+    EventLoop loop(50);
+    auto conn = make_connection(loop, fds[0]);
+    conn->set_direct_read(true);
+    std::string received;
+    bool closed = false;
+
+    // 直读模式下由上层自己读 fd，并在 EOF 时主动关闭
+    conn->set_message_callback([&](const std::shared_ptr<TcpConnection>& activeConn) {
+        EXPECT_EQ(activeConn->get_read_buffer()->readable_bytes(), 0U);
+        char buf[64];
+        const ssize_t n = ::read(activeConn->get_fd(), buf, sizeof(buf));
+        if (n > 0) {
+            received.append(buf, static_cast<size_t>(n));
+            ::close(fds[1]);
+            return;
+        }
+        activeConn->force_close();
+        });
+    conn->set_close_callback([&](const std::shared_ptr<TcpConnection>&) {
+        closed = true;
+        loop.quit();
+        });
+
+    ASSERT_EQ(::write(fds[1], "hello", 5), 5);
+
+    loop.run_after(0.5, [&]() {
+        loop.quit();
+        });
+    loop.loop();
+
+    EXPECT_EQ(received, "hello");
+    EXPECT_TRUE(closed);
+}
+
+TEST(TcpConnectionTest, RetryOnWritableRunsMessageCallbackOnceSocketDrains) {
+    int fds[2] = { -1, -1 };
+    ASSERT_EQ(::socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, fds), 0);
+
+    EventLoop loop(50);
+    auto conn = make_connection(loop, fds[0]);
+    conn->set_direct_read(true);
+    bool drained = false;
+    int retries = 0;
+
+    // 模拟上层直写 fd 受阻：发送缓冲腾出空间之前不应回调，腾出后只回调一次
+    conn->set_message_callback([&](const std::shared_ptr<TcpConnection>&) {
+        EXPECT_TRUE(drained);
+        ++retries;
+        });
+    conn->set_close_callback([](const std::shared_ptr<TcpConnection>&) {});
+
+    fill_send_buffer_until_would_block(fds[0]);
+    conn->retry_on_writable();
+
+    loop.run_after(0.1, [&]() {
+        drained = true;
+        (void)read_available(fds[1]);
+        });
+    loop.run_after(0.4, [&]() {
+        loop.quit();
+        });
+    loop.loop();
+
+    EXPECT_EQ(retries, 1);
+
+    ::close(fds[1]);
+}
+
 TEST(TcpConnectionTest, SendTriggersHighWaterMarkCallbackWhenCrossingThreshold) {
     int fds[2] = { -1, -1 };
     ASSERT_EQ(::socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, fds), 0);
@@ -252,3 +325,50 @@ TEST(TcpConnectionTest, WritevSendsGatheredBuffersSuccessfully) {
 
     ::close(fds[1]);
 }
+
+// SIGPIPE 保持默认处置（终止进程）时，向已关闭的对端直接发送、经积压缓冲发送与 sendfile 都只走错误关闭路径
+TEST(TcpConnectionTest, WritesToClosedPeerDoNotRaiseSigPipe) {
+    struct sigaction defaultAction {};
+    defaultAction.sa_handler = SIG_DFL;
+    struct sigaction oldAction {};
+    ASSERT_EQ(::sigaction(SIGPIPE, &defaultAction, &oldAction), 0);
+
+    char path[] = "/tmp/tudou-sigpipe-test-XXXXXX";
+    int fileFd = ::mkstemp(path);
+    ASSERT_GE(fileFd, 0);
+    ASSERT_EQ(::unlink(path), 0);
+    const std::string fileBody = "file-body";
+    ASSERT_EQ(::write(fileFd, fileBody.data(), fileBody.size()), static_cast<ssize_t>(fileBody.size()));
+    ASSERT_EQ(::lseek(fileFd, 0, SEEK_SET), 0);
+    auto file = std::make_shared<ScopedFd>(fileFd);
+
+    for (int scenario = 0; scenario < 3; ++scenario) {
+        SCOPED_TRACE(scenario);
+        int fds[2] = { -1, -1 };
+        ASSERT_EQ(::socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, fds), 0);
+
+        EventLoop loop(20);
+        auto conn = make_connection(loop, fds[0]);
+        bool errored = false;
+        conn->set_error_callback([&](const std::shared_ptr<TcpConnection>&) {
+            errored = true;
+            });
+        conn->set_close_callback([](const std::shared_ptr<TcpConnection>&) {});
+
+        if (scenario == 1) {
+            fill_send_buffer_until_would_block(fds[0]);
+            conn->send("queued");
+        }
+        ::close(fds[1]);
+
+        if (scenario == 2) {
+            conn->send_file(file, fileBody.size());
+        }
+        else {
+            conn->send("after-close");
+        }
+        EXPECT_TRUE(errored);
+    }
+
+    ASSERT_EQ(::sigaction(SIGPIPE, &oldAction, nullptr), 0);
+}
@@ -2,6 +2,7 @@
 
 #include <arpa/inet.h>
 #include <sys/socket.h>
+#include <sys/stat.h>
 #include <unistd.h>
 
 #include <atomic>
@@ -10,6 +11,7 @@
 #include <string>
 #include <thread>
 
+#include "tudou/tcp/InetAddress.h"
 #include "tudou/tcp/TcpServer.h"
 
 namespace {
@@ -67,6 +69,35 @@ int connect_with_retry(uint16_t port) {
     return -1;
 }
 
+int connect_address_with_retry(const InetAddress& address) {
+    for (int retry = 0; retry < 200; ++retry) {
+        const int clientFd = ::socket(address.get_family(), SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (clientFd < 0) {
+            return -1;
+        }
+
+        if (::connect(clientFd, address.get_sockaddr_ptr(), address.get_socklen()) == 0) {
+            return clientFd;
+        }
+
+        ::close(clientFd);
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+
+    return -1;
+}
+
+bool ipv6_loopback_available() {
+    const int fd = ::socket(AF_INET6, SOCK_STREAM | SOCK_CLOEXEC, IPPROTO_TCP);
+    if (fd < 0) {
+        return false;
+    }
+    const InetAddress loopback("::1", 0);
+    const bool bound = ::bind(fd, loopback.get_sockaddr_ptr(), loopback.get_socklen()) == 0;
+    ::close(fd);
+    return bound;
+}
+
 std::thread start_watchdog(TcpServer& server, std::atomic<bool>& serverDone) {
     return std::thread([&]() {
         for (int retry = 0; retry < 100 && !serverDone.load(); ++retry) {
@@ -293,3 +324,91 @@ TEST(TcpServerTest, ForceCloseFromConnectionCallbackClosesConnection) {
     EXPECT_TRUE(closed.load());
     EXPECT_TRUE(serverDone.load());
 }
+
+TEST(TcpServerTest, UnixDomainListenerServesAndRemovesSocketFile) {
+    const std::string path = "/tmp/tudou_tcp_server_test_" + std::to_string(::getpid()) + ".sock";
+    const InetAddress listenAddr = InetAddress::from_unix_path(path);
+
+    TcpServer server(listenAddr, 0);
+    std::atomic<bool> serverDone{ false };
+    std::string peer;
+
+    server.set_connection_callback([&](const TcpConnectionPtr& conn) {
+        peer = conn->get_peer_addr().get_ip_port();
+        conn->send("unix-hello");
+        });
+    server.set_write_complete_callback([&](const TcpConnectionPtr&) {
+        server.stop();
+        });
+
+    std::thread serverThread([&]() {
+        server.start();
+        serverDone = true;
+        });
+    std::thread watchdog = start_watchdog(server, serverDone);
+
+    const int clientFd = connect_address_with_retry(listenAddr);
+    ASSERT_GE(clientFd, 0);
+    EXPECT_EQ(read_with_retry(clientFd), "unix-hello");
+    ASSERT_EQ(::close(clientFd), 0);
+
+    serverThread.join();
+    watchdog.join();
+
+    EXPECT_TRUE(serverDone.load());
+    EXPECT_EQ(peer.rfind("unix:", 0), 0u);
+    EXPECT_EQ(server.get_ip(), path);
+    EXPECT_EQ(server.get_port(), 0);
+
+    // Acceptor 析构时删除 socket 文件，下次以同一路径启动不会因残留文件 bind 失败
+    struct stat st;
+    EXPECT_NE(::stat(path.c_str(), &st), 0);
+}
+
+TEST(TcpServerTest, DualStackListenerAcceptsIpv4AndIpv6Clients) {
+    if (!ipv6_loopback_available()) {
+        GTEST_SKIP() << "IPv6 loopback is not available";
+    }
+    const uint16_t port = reserve_free_port();
+    ASSERT_NE(port, 0);
+
+    TcpServer server("::", port, 0);
+    std::atomic<bool> serverDone{ false };
+    std::atomic<int> accepted{ 0 };
+    std::string peers[2];
+
+    server.set_connection_callback([&](const TcpConnectionPtr& conn) {
+        const int index = accepted.fetch_add(1);
+        if (index < 2) {
+            peers[index] = conn->get_peer_addr().get_ip();
+        }
+        if (index == 1) {
+            server.stop();
+        }
+        });
+
+    std::thread serverThread([&]() {
+        server.start();
+        serverDone = true;
+        });
+    std::thread watchdog = start_watchdog(server, serverDone);
+
+    // 同一个 "::" 监听 socket 依次接入 IPv4 与 IPv6 客户端
+    const int v4Fd = connect_with_retry(port);
+    ASSERT_GE(v4Fd, 0);
+    for (int retry = 0; retry < 200 && accepted.load() < 1; ++retry) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    const int v6Fd = connect_address_with_retry(InetAddress("::1", port));
+    ASSERT_GE(v6Fd, 0);
+
+    serverThread.join();
+    watchdog.join();
+    ::close(v4Fd);
+    ::close(v6Fd);
+
+    ASSERT_EQ(accepted.load(), 2);
+    // IPv4 客户端经双栈 socket 接入后，连接地址快照已还原为 AF_INET 文本而非 ::ffff: 映射形式
+    EXPECT_EQ(peers[0], "127.0.0.1");
+    EXPECT_EQ(peers[1], "::1");
+}